@@ -358,6 +358,24 @@ public:
      */
     const char *getVersion();
 
+    /**
+     * Get the usage of the memory pools of the BLE stack.
+     *
+     * Statistics are accumulated from the initialization of the stack and can
+     * be used to size the pools for the workload of the application. They are
+     * only recorded when cordio.buffer-pool-profiling is enabled.
+     *
+     * @param[out] statistics Array receiving the statistics of each pool.
+     * @param[in,out] count Capacity of statistics as input. Number of pools of
+     * the stack as output.
+     *
+     * @return BLE_ERROR_NONE if statistics has been filled,
+     * BLE_ERROR_BUFFER_OVERFLOW if it is too small to hold every pool or
+     * BLE_ERROR_NOT_IMPLEMENTED if the stack does not record the usage of its
+     * pools.
+     */
+    ble_error_t getMemoryPoolStatistics(ble::memory_pool_statistics_t *statistics, uint8_t &count);
+
     /**
      * Accessor to Gap. All Gap-related functionality requires going through
      * this accessor.
@@ -19,6 +19,8 @@
 #ifndef BLE_GAP_GAP_H
 #define BLE_GAP_GAP_H
 
+#include "platform/Callback.h"
+
 #include "ble/common/CallChainOfFunctionPointersWithContext.h"
 
 #include "ble/common/BLERoles.h"
@@ -26,6 +28,7 @@
 #include "ble/gap/AdvertisingDataBuilder.h"
 #include "ble/gap/AdvertisingDataParser.h"
 #include "ble/gap/AdvertisingDataSimpleBuilder.h"
+#include "ble/gap/AdvertisingDataTemplate.h"
 #include "ble/gap/AdvertisingDataTypes.h"
 #include "ble/gap/AdvertisingParameters.h"
 #include "ble/gap/ConnectionParameters.h"
@@ -748,6 +751,39 @@ public:
         mbed::Span<const uint8_t> response
     );
 
+    /** Push the dynamic values of an advertising payload template.
+     *
+     * Nothing is sent if the template has not been modified since the last
+     * update. Otherwise the payload is sent in a single HCI command when it
+     * fits in one, without stopping the advertising set.
+     *
+     * @param handle Advertising set handle.
+     * @param payload Template of the payload; it is marked as sent on success.
+     *
+     * @return BLE_ERROR_NONE on success.
+     *
+     * @see ble::AdvertisingDataTemplate to update a payload in place.
+     */
+    ble_error_t updateAdvertisingPayload(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload
+    );
+
+    /** Push the dynamic values of a scan response template.
+     *
+     * @param handle Advertising set handle.
+     * @param response Template of the scan response; it is marked as sent on
+     * success.
+     *
+     * @return BLE_ERROR_NONE on success.
+     *
+     * @see updateAdvertisingPayload()
+     */
+    ble_error_t updateAdvertisingScanResponse(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &response
+    );
+
     /** Start advertising using the given advertising set.
      *
      * @param handle Advertising set handle.
@@ -826,6 +862,21 @@ public:
         mbed::Span<const uint8_t> payload
     );
 
+    /** Push the dynamic values of a periodic advertising payload template.
+     *
+     * @param handle Advertising set handle.
+     * @param payload Template of the payload; it is marked as sent on success.
+     * @return BLE_ERROR_NONE on success.
+     *
+     * @see updateAdvertisingPayload()
+     *
+     * @version 5+
+     */
+    ble_error_t updatePeriodicAdvertisingPayload(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload
+    );
+
     /** Start periodic advertising for a given set. Periodic advertising will not start until
      *  normal advertising is running but will continue to run after normal advertising has stopped.
      *
@@ -1180,6 +1231,96 @@ public:
         connection_handle_t connectionHandle,
         local_disconnection_reason_t reason
     );
+
+    /**
+     * Request the controller to use longer link layer data packets on a
+     * connection (LE Data Length Extension).
+     *
+     * Longer link layer packets reduce the per packet overhead when large
+     * attributes or long write sequences are exchanged. The outcome of the
+     * negotiation with the peer is reported by onDataLengthChange.
+     *
+     * @param[in] connectionHandle Handle of the connection to update.
+     * @param[in] txOctets Preferred maximum number of payload octets in a
+     * link layer packet; between 27 and 251.
+     * @param[in] txTimeUs Preferred maximum time, in microseconds, taken to
+     * transmit a link layer packet; between 328 and 17040.
+     *
+     * @return BLE_ERROR_NONE if the request has been sent to the controller,
+     * BLE_ERROR_NOT_IMPLEMENTED if the controller doesn't support data length
+     * extension or an appropriate error code.
+     *
+     * @see EventHandler::onDataLengthChange when the controller has negotiated
+     * the new packet length.
+     */
+    ble_error_t setDataLength(
+        connection_handle_t connectionHandle,
+        uint16_t txOctets,
+        uint16_t txTimeUs
+    );
+
+    /**
+     * Get the timing of the connection events of a connection.
+     *
+     * The interval and latency are those of the last connection parameter
+     * update. The date of the next connection event is reported by the
+     * controller when it supports it; otherwise it is estimated from the
+     * dates of the connection and connection parameter update events.
+     *
+     * @param[in] connectionHandle Handle of the connection.
+     * @param[out] timing Timing of the connection events.
+     *
+     * @return BLE_ERROR_NONE on success or BLE_ERROR_INVALID_PARAM if the
+     * connection doesn't exist.
+     */
+    ble_error_t getConnectionEventTiming(
+        connection_handle_t connectionHandle,
+        connection_event_timing_t &timing
+    );
+
+    /**
+     * Invoke a producer shortly before each connection event of a connection.
+     *
+     * Data produced just in time is sent at the next connection event: the
+     * device wakes up once per event instead of once for the event and once
+     * for an unrelated sampling timer, and the data sent is fresher.
+     *
+     * The producer is called from the BLE event processing context, lead
+     * before the anchor point of the event. When the controller doesn't
+     * report connection events the anchor point is estimated from the
+     * connection and connection parameter update events; lead should then
+     * cover the latency of the event processing and the clock drift.
+     *
+     * @note The producer is called at every connection interval, peripheral
+     * latency is not taken into account.
+     *
+     * @param[in] connectionHandle Handle of the connection.
+     * @param[in] producer Callback invoked before each connection event with
+     * the handle of the connection.
+     * @param[in] lead Delay between the call to the producer and the anchor
+     * point of the connection event.
+     *
+     * @return BLE_ERROR_NONE on success, BLE_ERROR_INVALID_PARAM if the
+     * connection doesn't exist or lead is larger than the connection
+     * interval.
+     */
+    ble_error_t setConnectionEventProducer(
+        connection_handle_t connectionHandle,
+        mbed::Callback<void(connection_handle_t)> producer,
+        microsecond_t lead = microsecond_t(1250)
+    );
+
+    /**
+     * Stop invoking the producer registered for a connection.
+     *
+     * The producer is removed automatically when the connection ends.
+     *
+     * @param[in] connectionHandle Handle of the connection.
+     *
+     * @return BLE_ERROR_NONE on success or BLE_ERROR_INVALID_PARAM if no
+     * producer is registered for the connection.
+     */
+    ble_error_t clearConnectionEventProducer(connection_handle_t connectionHandle);
 #endif // BLE_FEATURE_CONNECTABLE
 #if BLE_FEATURE_PHY_MANAGEMENT
     /**
@@ -906,6 +906,44 @@ struct whitelist_t {
     uint8_t capacity;
 };
 
+/**
+ * Usage of a memory pool the stack allocates its messages from.
+ *
+ * @see BLE::getMemoryPoolStatistics()
+ */
+struct memory_pool_statistics_t {
+    /**
+     * Size of the buffers of the pool.
+     */
+    uint16_t buffer_size;
+
+    /**
+     * Number of buffers in the pool.
+     */
+    uint8_t buffer_count;
+
+    /**
+     * Number of buffers currently allocated.
+     */
+    uint8_t in_use;
+
+    /**
+     * Highest number of buffers allocated at the same time.
+     */
+    uint8_t max_in_use;
+
+    /**
+     * Largest allocation served by the pool.
+     */
+    uint16_t max_requested_size;
+
+    /**
+     * Number of allocations that fitted in the pool but could not be served
+     * by it or any larger pool.
+     */
+    uint32_t allocation_failures;
+};
+
 /** events sent and received when passkey is being entered */
 enum Keypress_t {
     KEYPRESS_STARTED,   /**< Passkey entry started */
@@ -0,0 +1,171 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_GAP_ADVERTISING_DATA_TEMPLATE_H__
+#define BLE_GAP_ADVERTISING_DATA_TEMPLATE_H__
+
+#include <cstdint>
+
+#include "platform/Span.h"
+
+#include "ble/common/blecommon.h"
+#include "ble/gap/AdvertisingDataTypes.h"
+
+namespace ble {
+
+/**
+ * @addtogroup ble
+ * @{
+ * @addtogroup gap
+ * @{
+ */
+
+/**
+ * Advertising payload with a fixed layout and dynamic values updated in place.
+ *
+ * The payload is built once, for instance with AdvertisingDataBuilder, in a
+ * buffer owned by the application. The location of each dynamic value is
+ * then resolved once with getField() and later updates only write the bytes
+ * of that value: the rest of the payload is neither rebuilt nor copied.
+ *
+ * The template records whether its content changed since it was last sent
+ * to the controller; Gap::updateAdvertisingPayload() and its siblings use it
+ * to skip the HCI command when nothing changed.
+ *
+ * @code
+ * uint8_t buffer[LEGACY_ADVERTISING_MAX_SIZE];
+ * AdvertisingDataBuilder builder(buffer);
+ * builder.setFlags();
+ * const uint8_t initial[] = { 0xFF, 0xFF, 0x00, 0x00 };
+ * builder.setManufacturerSpecificData(initial);
+ *
+ * AdvertisingDataTemplate beacon(mbed::make_Span(buffer, builder.getAdvertisingData().size()));
+ * AdvertisingDataTemplate::field_t counter;
+ * beacon.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, counter, 2, 2);
+ * gap.setAdvertisingPayload(LEGACY_ADVERTISING_HANDLE, beacon.getAdvertisingData());
+ *
+ * // on every tick
+ * beacon.update(counter, ++count);
+ * gap.updateAdvertisingPayload(LEGACY_ADVERTISING_HANDLE, beacon);
+ * @endcode
+ */
+class AdvertisingDataTemplate {
+public:
+    /**
+     * Location of a dynamic value in the payload.
+     */
+    struct field_t {
+        /**
+         * Offset of the value from the start of the payload; extended and
+         * periodic payloads can be larger than 255 bytes.
+         */
+        uint16_t offset;
+
+        /**
+         * Size of the value.
+         */
+        uint8_t size;
+    };
+
+    /**
+     * Create a template over a complete payload.
+     *
+     * @param payload Payload updated in place. It must remain valid for the
+     * lifetime of the template.
+     */
+    AdvertisingDataTemplate(mbed::Span<uint8_t> payload);
+
+    /**
+     * Locate a dynamic value inside a field of the payload.
+     *
+     * @param[in] type Type of the AD field containing the value.
+     * @param[out] field Location of the value.
+     * @param[in] offset Offset of the value from the start of the field data.
+     * @param[in] size Size of the value, 0 to select the rest of the field data.
+     *
+     * @return BLE_ERROR_NONE on success, BLE_ERROR_NOT_FOUND if the payload
+     * has no field of this type or BLE_ERROR_INVALID_PARAM if the value does
+     * not fit in the field.
+     */
+    ble_error_t getField(
+        adv_data_type_t type,
+        field_t &field,
+        uint8_t offset = 0,
+        uint8_t size = 0
+    ) const;
+
+    /**
+     * Replace a dynamic value.
+     *
+     * @param field Location of the value, obtained with getField().
+     * @param value New value; its size must match the size of the field.
+     *
+     * @return BLE_ERROR_NONE on success or BLE_ERROR_INVALID_PARAM if the size
+     * does not match or the field is outside the payload.
+     */
+    ble_error_t update(const field_t &field, mbed::Span<const uint8_t> value);
+
+    /**
+     * Replace a dynamic value with an integer, in little endian order.
+     *
+     * @param field Location of the value, at most 4 bytes large.
+     * @param value New value, truncated to the size of the field.
+     *
+     * @return BLE_ERROR_NONE on success or BLE_ERROR_INVALID_PARAM if the field
+     * is too large or outside the payload.
+     */
+    ble_error_t update(const field_t &field, uint32_t value);
+
+    /**
+     * Get the complete payload.
+     */
+    mbed::Span<const uint8_t> getAdvertisingData() const
+    {
+        return _payload;
+    }
+
+    /**
+     * Indicate if the payload changed since it was last sent.
+     */
+    bool isModified() const
+    {
+        return _modified;
+    }
+
+    /**
+     * Mark the payload as sent to the controller.
+     *
+     * @note This is called by Gap once the payload has been pushed.
+     */
+    void clearModified()
+    {
+        _modified = false;
+    }
+
+private:
+    mbed::Span<uint8_t> _payload;
+    bool _modified;
+};
+
+/**
+ * @}
+ * @}
+ */
+
+} // namespace ble
+
+#endif // BLE_GAP_ADVERTISING_DATA_TEMPLATE_H__
@@ -989,6 +989,51 @@ struct central_privacy_configuration_t {
     resolution_strategy_t resolution_strategy;
 };
 
+/**
+ * Timing of the connection events of a connection.
+ *
+ * @see Gap::getConnectionEventTiming
+ */
+struct connection_event_timing_t {
+    /**
+     * Construct a timing with no next event known.
+     */
+    connection_event_timing_t() :
+        interval(conn_interval_t::min()),
+        latency(0),
+        next_event_known(false),
+        next_event_estimated(false),
+        next_event(0)
+    {
+    }
+
+    /**
+     * Interval between two connection events.
+     */
+    conn_interval_t interval;
+
+    /**
+     * Number of connection events the peripheral may skip.
+     */
+    slave_latency_t latency;
+
+    /**
+     * Indicates if next_event is known.
+     */
+    bool next_event_known;
+
+    /**
+     * Indicates if next_event is estimated by the host rather than reported
+     * by the controller.
+     */
+    bool next_event_estimated;
+
+    /**
+     * Time remaining before the anchor point of the next connection event.
+     */
+    microsecond_t next_event;
+};
+
 
 /**
  * @}
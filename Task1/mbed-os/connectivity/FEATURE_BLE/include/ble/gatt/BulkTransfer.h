@@ -0,0 +1,361 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MBED_BLE_BULK_TRANSFER_H__
+#define MBED_BLE_BULK_TRANSFER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ble/BLE.h"
+#include "ble/Gap.h"
+#include "ble/GattClient.h"
+#include "ble/GattServer.h"
+#include "ble/common/blecommon.h"
+#include "ble/gatt/GattAttribute.h"
+#include "ble/gatt/GattCallbackParamTypes.h"
+
+#include "drivers/LowPowerTimer.h"
+
+#ifndef MBED_CONF_BLE_API_IMPLEMENTATION_MAX_BULK_TRANSFER_IN_FLIGHT
+#define MBED_CONF_BLE_API_IMPLEMENTATION_MAX_BULK_TRANSFER_IN_FLIGHT 8
+#endif
+
+namespace ble {
+
+/**
+ * @addtogroup ble
+ * @{
+ * @addtogroup gatt
+ * @{
+ */
+
+/**
+ * Move a large blob of data (log, firmware image...) to a peer as fast as the
+ * link allows.
+ *
+ * The data is sent either as a sequence of write without response (the local
+ * device is the GATT client) or as a sequence of notifications (the local
+ * device is the GATT server). Packets are not sent one at a time: up to
+ * a window of packets is handed to the stack and a new one is queued every
+ * time the stack reports that a previous one has left the controller.
+ *
+ * Before the transfer, negotiate() can be used to request a larger ATT MTU,
+ * LE data length extension and the 2M PHY. The size of each packet is then
+ * chosen from the negotiated ATT MTU and link layer payload so that a packet
+ * fills whole link layer PDUs.
+ *
+ * The offset acknowledged by the stack is tracked so that an interrupted
+ * transfer (disconnection, application abort) can be resumed later.
+ *
+ * @par Event routing
+ *
+ * BulkTransfer is a Gap, GattClient and GattServer event handler. It does not
+ * register itself; the application must forward these events to it, either by
+ * registering it directly or by adding it to a ChainableGapEventHandler and
+ * ChainableGattServerEventHandler. Completion of write without response is
+ * tracked through GattClient::onDataWritten() which is registered at
+ * construction.
+ */
+class BulkTransfer :
+    public Gap::EventHandler,
+    public GattClient::EventHandler,
+    public GattServer::EventHandler {
+public:
+    /**
+     * Mechanism used to move data to the peer.
+     */
+    enum Mode {
+        /** Sequence of GATT write without response; local device is a client. */
+        WRITE_WITHOUT_RESPONSE,
+
+        /** Sequence of GATT notifications; local device is a server. */
+        NOTIFICATION
+    };
+
+    /**
+     * Definition of the handler of bulk transfer events.
+     */
+    struct EventHandler {
+        /**
+         * Function invoked when the link parameters used to size packets have
+         * changed.
+         *
+         * @param connectionHandle Connection of the transfer.
+         * @param payloadSize New number of data bytes carried by a packet.
+         */
+        virtual void onBulkTransferLinkUpdate(
+            connection_handle_t connectionHandle,
+            uint16_t payloadSize
+        )
+        {
+        }
+
+        /**
+         * Function invoked when the transfer has stopped.
+         *
+         * @param connectionHandle Connection of the transfer.
+         * @param status BLE_ERROR_NONE if all the data has been sent,
+         * BLE_ERROR_INVALID_STATE if the connection was lost, BLE_ERROR_OPERATION_NOT_PERMITTED
+         * if it was aborted or the error reported by the stack.
+         * @param offset Number of bytes acknowledged by the stack. It is the
+         * offset to pass to resume() to continue the transfer.
+         */
+        virtual void onBulkTransferEnd(
+            connection_handle_t connectionHandle,
+            ble_error_t status,
+            size_t offset
+        )
+        {
+        }
+
+    protected:
+        /**
+         * Prevent polymorphic deletion and avoid unnecessary virtual destructor
+         * as the BulkTransfer class will never delete the instance it contains.
+         */
+        ~EventHandler() = default;
+    };
+
+    /**
+     * Counters of a transfer.
+     */
+    struct Statistics {
+        /** Number of bytes acknowledged by the stack. */
+        size_t bytes_sent;
+
+        /** Number of packets acknowledged by the stack. */
+        uint32_t packets_sent;
+
+        /** Number of times the stack refused a packet because it was full. */
+        uint32_t stalls;
+
+        /** Data bytes carried by a packet at the end of the transfer. */
+        uint16_t payload_size;
+
+        /** Time elapsed between the start of the transfer and its end. */
+        std::chrono::microseconds elapsed;
+
+        /**
+         * Effective throughput of the transfer in bytes per second.
+         */
+        uint32_t throughput() const
+        {
+            if (elapsed.count() <= 0) {
+                return 0;
+            }
+            return (uint32_t)(((uint64_t) bytes_sent * 1000000) / elapsed.count());
+        }
+    };
+
+    /** Maximum number of packets that can be queued in the stack at once. */
+    static const uint8_t MAX_IN_FLIGHT = MBED_CONF_BLE_API_IMPLEMENTATION_MAX_BULK_TRANSFER_IN_FLIGHT;
+
+    /**
+     * Construct a bulk transfer engine.
+     *
+     * @param ble BLE instance used to send data.
+     * @param window Maximum number of packets queued in the stack at any
+     * time. It should match the number of ACL buffers of the controller. It is
+     * capped to MAX_IN_FLIGHT.
+     */
+    BulkTransfer(BLE &ble, uint8_t window = MAX_IN_FLIGHT);
+
+    BulkTransfer(const BulkTransfer &) = delete;
+    BulkTransfer &operator=(const BulkTransfer &) = delete;
+
+    ~BulkTransfer();
+
+    /**
+     * Register the handler of bulk transfer events.
+     *
+     * @param handler Application handler; can be nullptr.
+     */
+    void setEventHandler(EventHandler *handler);
+
+    /**
+     * Request link parameters best suited for bulk transfers on a connection.
+     *
+     * This requests a larger ATT MTU (only in WRITE_WITHOUT_RESPONSE mode as
+     * the exchange is initiated by the client), LE data length extension and
+     * the 2M PHY. Features not supported by the controller are skipped.
+     *
+     * @param connectionHandle Connection to configure.
+     * @param mode Mechanism that will be used by the transfer.
+     *
+     * @return BLE_ERROR_NONE if at least one of the procedures has been
+     * started or the error reported by the last procedure.
+     */
+    ble_error_t negotiate(connection_handle_t connectionHandle, Mode mode);
+
+    /**
+     * Start a transfer.
+     *
+     * @param connectionHandle Connection used to send the data.
+     * @param attributeHandle Handle of the remote characteristic value written
+     * or of the local characteristic value notified.
+     * @param data Data to send. It must remain valid until the end of the
+     * transfer.
+     * @param size Number of bytes in data.
+     * @param mode Mechanism used to send the data.
+     * @param offset Offset in data of the first byte to send.
+     *
+     * @return BLE_ERROR_NONE if the transfer has started or
+     * BLE_ERROR_NOT_IMPLEMENTED if the GATT role needed by mode is not
+     * built in.
+     */
+    ble_error_t start(
+        connection_handle_t connectionHandle,
+        GattAttribute::Handle_t attributeHandle,
+        const uint8_t *data,
+        size_t size,
+        Mode mode,
+        size_t offset = 0
+    );
+
+    /**
+     * Resume a transfer that has been interrupted, possibly on a new
+     * connection.
+     *
+     * Packets that were queued in the stack but not acknowledged are sent
+     * again.
+     *
+     * @param connectionHandle Connection used to send the remaining data.
+     *
+     * @return BLE_ERROR_NONE if the transfer has resumed.
+     */
+    ble_error_t resume(connection_handle_t connectionHandle);
+
+    /**
+     * Stop queuing packets. onBulkTransferEnd is called once packets already
+     * queued have been acknowledged.
+     */
+    void abort();
+
+    /**
+     * Return true if a transfer is ongoing.
+     */
+    bool isActive() const;
+
+    /**
+     * Offset of the first byte not acknowledged by the stack.
+     */
+    size_t getOffset() const;
+
+    /**
+     * Number of data bytes carried by a packet with the current link
+     * parameters.
+     */
+    uint16_t getPayloadSize() const;
+
+    /**
+     * Counters of the current or last transfer.
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * Compute the number of data bytes to place in a packet so that it
+     * fills whole link layer PDUs.
+     *
+     * @param attMtu Negotiated ATT MTU.
+     * @param txOctets Negotiated maximum link layer payload.
+     */
+    static uint16_t computePayloadSize(uint16_t attMtu, uint16_t txOctets);
+
+#if !defined(DOXYGEN_ONLY)
+    /* Gap::EventHandler */
+    void onDataLengthChange(
+        connection_handle_t connectionHandle,
+        uint16_t txSize,
+        uint16_t rxSize
+    ) override;
+
+    void onPhyUpdateComplete(
+        ble_error_t status,
+        connection_handle_t connectionHandle,
+        phy_t txPhy,
+        phy_t rxPhy
+    ) override;
+
+    void onDisconnectionComplete(const DisconnectionCompleteEvent &event) override;
+
+    /* GattClient::EventHandler and GattServer::EventHandler */
+    void onAttMtuChange(
+        connection_handle_t connectionHandle,
+        uint16_t attMtuSize
+    ) override;
+
+    /* GattServer::EventHandler */
+    void onDataSent(const GattDataSentCallbackParams &params) override;
+#endif // !defined(DOXYGEN_ONLY)
+
+private:
+    enum state_t {
+        IDLE,
+        RUNNING,
+        SUSPENDED,
+        ABORTING
+    };
+
+    void when_data_written(const GattWriteCallbackParams *params);
+
+    void on_packet_sent();
+
+    void pump();
+
+    void end(ble_error_t status);
+
+    void update_payload_size();
+
+    BLE &_ble;
+    EventHandler *_event_handler;
+
+    connection_handle_t _connection;
+    GattAttribute::Handle_t _attribute;
+    const uint8_t *_data;
+    size_t _size;
+    Mode _mode;
+    state_t _state;
+
+    /* offset of the first byte not yet acknowledged */
+    size_t _acked_offset;
+    /* offset of the first byte not yet handed to the stack */
+    size_t _sent_offset;
+
+    /* length of the packets queued in the stack, oldest first */
+    uint16_t _in_flight[MAX_IN_FLIGHT];
+    uint8_t _in_flight_head;
+    uint8_t _in_flight_count;
+    uint8_t _window;
+
+    uint16_t _att_mtu;
+    uint16_t _tx_octets;
+    uint16_t _payload_size;
+
+    uint32_t _packets_sent;
+    uint32_t _stalls;
+    mbed::LowPowerTimer _timer;
+};
+
+/**
+ * @}
+ * @}
+ */
+
+} // namespace ble
+
+#endif /* MBED_BLE_BULK_TRANSFER_H__ */
@@ -113,6 +113,11 @@ const char *BLE::getVersion(void)
     return transport.getVersion();
 }
 
+ble_error_t BLE::getMemoryPoolStatistics(ble::memory_pool_statistics_t *statistics, uint8_t &count)
+{
+    return transport.getMemoryPoolStatistics(statistics, count);
+}
+
 const ble::Gap &BLE::gap() const
 {
     return transport.getGap();
@@ -148,6 +148,21 @@ public:
      */
     virtual const char *getVersion() = 0;
 
+    /**
+     * Get the usage of the memory pools of the BLE stack.
+     *
+     * @see BLE::getMemoryPoolStatistics()
+     */
+    virtual ble_error_t getMemoryPoolStatistics(
+        ble::memory_pool_statistics_t *statistics,
+        uint8_t &count
+    )
+    {
+        (void) statistics;
+        (void) count;
+        return BLE_ERROR_NOT_IMPLEMENTED;
+    }
+
     /**
      * Accessor to the vendor implementation of the Gap interface.
      *
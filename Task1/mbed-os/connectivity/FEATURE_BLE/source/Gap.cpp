@@ -102,6 +102,22 @@ ble_error_t Gap::setAdvertisingScanResponse(
     return impl->setAdvertisingScanResponse(handle, response);
 }
 
+ble_error_t Gap::updateAdvertisingPayload(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &payload
+)
+{
+    return impl->updateAdvertisingPayload(handle, payload);
+}
+
+ble_error_t Gap::updateAdvertisingScanResponse(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &response
+)
+{
+    return impl->updateAdvertisingScanResponse(handle, response);
+}
+
 ble_error_t Gap::startAdvertising(
     advertising_handle_t handle,
     adv_duration_t maxDuration,
@@ -151,6 +167,14 @@ ble_error_t Gap::setPeriodicAdvertisingPayload(
     return impl->setPeriodicAdvertisingPayload(handle, payload);
 }
 
+ble_error_t Gap::updatePeriodicAdvertisingPayload(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &payload
+)
+{
+    return impl->updatePeriodicAdvertisingPayload(handle, payload);
+}
+
 
 ble_error_t Gap::startPeriodicAdvertising(advertising_handle_t handle)
 {
@@ -357,6 +381,41 @@ ble_error_t Gap::disconnect(
     return impl->disconnect(connectionHandle, reason);
 }
 
+
+ble_error_t Gap::setDataLength(
+    connection_handle_t connectionHandle,
+    uint16_t txOctets,
+    uint16_t txTimeUs
+)
+{
+    return impl->setDataLength(connectionHandle, txOctets, txTimeUs);
+}
+
+
+ble_error_t Gap::getConnectionEventTiming(
+    connection_handle_t connectionHandle,
+    connection_event_timing_t &timing
+)
+{
+    return impl->getConnectionEventTiming(connectionHandle, timing);
+}
+
+
+ble_error_t Gap::setConnectionEventProducer(
+    connection_handle_t connectionHandle,
+    mbed::Callback<void(connection_handle_t)> producer,
+    microsecond_t lead
+)
+{
+    return impl->setConnectionEventProducer(connectionHandle, producer, lead);
+}
+
+
+ble_error_t Gap::clearConnectionEventProducer(connection_handle_t connectionHandle)
+{
+    return impl->clearConnectionEventProducer(connectionHandle);
+}
+
 #endif // BLE_FEATURE_CONNECTABLE
 #if BLE_FEATURE_PHY_MANAGEMENT
 
@@ -43,6 +43,7 @@
 #include "wsf_os.h"
 #include "wsf_buf.h"
 #include "wsf_timer.h"
+#include "wsf_mbed_os_adaptation.h"
 #include "hci_handler.h"
 #include "dm_handler.h"
 #include "l2c_handler.h"
@@ -202,6 +203,11 @@ ble_error_t BLEInstanceBase::shutdown()
     getGap().reset();
     _event_queue.clear();
 
+#if MBED_CONF_CORDIO_BUFFER_POOL_PROFILING
+    wsf_mbed_os_buf_trace_stats();
+    wsf_mbed_os_buf_trace_recommendation();
+#endif
+
     initialization_status = NOT_INITIALIZED;
     _hci_driver->terminate();
 
@@ -214,6 +220,44 @@ const char *BLEInstanceBase::getVersion()
     return version;
 }
 
+ble_error_t BLEInstanceBase::getMemoryPoolStatistics(
+    ble::memory_pool_statistics_t *statistics,
+    uint8_t &count
+)
+{
+#if MBED_CONF_CORDIO_BUFFER_POOL_PROFILING
+    uint8_t pool_count = WsfBufGetNumPool();
+    if (pool_count > WSF_BUF_STATS_MAX_POOL) {
+        pool_count = WSF_BUF_STATS_MAX_POOL;
+    }
+
+    if (count < pool_count) {
+        count = pool_count;
+        return BLE_ERROR_BUFFER_OVERFLOW;
+    }
+
+    WsfBufPoolStat_t pool_stats[WSF_BUF_STATS_MAX_POOL];
+    WsfBufGetPoolStats(pool_stats, pool_count);
+
+    for (uint8_t i = 0; i < pool_count; ++i) {
+        statistics[i].buffer_size = pool_stats[i].bufSize;
+        statistics[i].buffer_count = pool_stats[i].numBuf;
+        statistics[i].in_use = pool_stats[i].numAlloc;
+        statistics[i].max_in_use = pool_stats[i].maxAlloc;
+        statistics[i].max_requested_size = pool_stats[i].maxReqLen;
+        statistics[i].allocation_failures = wsf_mbed_os_buf_get_alloc_failures(i);
+    }
+    count = pool_count;
+
+    return BLE_ERROR_NONE;
+#else
+    // WSF only keeps the statistics of the pools when profiling
+    (void) statistics;
+    (void) count;
+    return BLE_ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
 ble::impl::Gap &BLEInstanceBase::getGapImpl()
 {
     static ble::impl::PalGenericAccessService cordio_gap_service;
@@ -524,6 +568,10 @@ void BLEInstanceBase::stack_setup()
     // Raise assert if not enough memory was allocated
     MBED_ASSERT(bytes_used != 0);
 
+#if MBED_CONF_CORDIO_BUFFER_POOL_PROFILING
+    wsf_mbed_os_buf_stats_init();
+#endif
+
     SystemHeapStart += bytes_used;
     SystemHeapSize -= bytes_used;
 
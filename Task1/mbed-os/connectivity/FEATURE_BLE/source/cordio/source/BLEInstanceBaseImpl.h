@@ -115,6 +115,14 @@ public:
      */
     const char *getVersion() final;
 
+    /**
+     * @see BLEInstanceBase::getMemoryPoolStatistics
+     */
+    ble_error_t getMemoryPoolStatistics(
+        ble::memory_pool_statistics_t *statistics,
+        uint8_t &count
+    ) final;
+
     ble::impl::Gap &getGapImpl();
 
     /**
@@ -626,6 +626,51 @@ ble_error_t PalGap::disconnect(
     return BLE_ERROR_NONE;
 }
 
+
+ble_error_t PalGap::set_data_length(
+    connection_handle_t connection,
+    uint16_t tx_octets,
+    uint16_t tx_time
+)
+{
+#if MBED_CONF_CORDIO_TRACE_PAL_ECHOES
+    tr_info("Connection %d: set data length - "
+            "tx_octets=%d, "
+            "tx_time=%d",
+            connection,
+            tx_octets,
+            tx_time);
+#endif
+
+    if (!is_feature_supported(controller_supported_features_t::LE_DATA_PACKET_LENGTH_EXTENSION)) {
+        tr_error("Data length extension not supported");
+        return BLE_ERROR_NOT_IMPLEMENTED;
+    }
+
+    DmConnSetDataLen(connection, tx_octets, tx_time);
+    return BLE_ERROR_NONE;
+}
+
+
+ble_error_t PalGap::get_next_connection_event(
+    connection_handle_t connection,
+    microsecond_t &delay
+)
+{
+    /* HCI does not expose the anchor point of connection events */
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+
+ble_error_t PalGap::enable_connection_event_notification(
+    connection_handle_t connection,
+    microsecond_t lead,
+    bool enable
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
 #endif // BLE_FEATURE_CONNECTABLE
 
 #if BLE_FEATURE_PHY_MANAGEMENT
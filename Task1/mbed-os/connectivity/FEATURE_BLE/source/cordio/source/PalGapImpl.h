@@ -155,6 +155,23 @@ public:
         connection_handle_t connection,
         local_disconnection_reason_t disconnection_reason
     ) final;
+
+    ble_error_t set_data_length(
+        connection_handle_t connection,
+        uint16_t tx_octets,
+        uint16_t tx_time
+    ) final;
+
+    ble_error_t get_next_connection_event(
+        connection_handle_t connection,
+        microsecond_t &delay
+    ) final;
+
+    ble_error_t enable_connection_event_notification(
+        connection_handle_t connection,
+        microsecond_t lead,
+        bool enable
+    ) final;
 #endif // BLE_FEATURE_CONNECTABLE
 
 #if BLE_FEATURE_PHY_MANAGEMENT
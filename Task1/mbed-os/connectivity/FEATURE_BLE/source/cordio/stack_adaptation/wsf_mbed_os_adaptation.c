@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
 #include "wsf_mbed_os_adaptation.h"
 #include "mbed_critical.h"
+#include "mbed-trace/mbed_trace.h"
 
 void wsf_mbed_os_critical_section_enter(void)
 {
@@ -26,3 +29,129 @@ void wsf_mbed_os_critical_section_exit(void)
 {
     core_util_critical_section_exit();
 }
+
+#define TRACE_GROUP "BLWB"
+
+/* allocation failures and largest failed request, per pool */
+static uint32_t wsf_buf_failures[WSF_BUF_STATS_MAX_POOL];
+static uint16_t wsf_buf_failed_max_len[WSF_BUF_STATS_MAX_POOL];
+static WsfBufPoolStat_t wsf_buf_pool_stats[WSF_BUF_STATS_MAX_POOL];
+static uint8_t wsf_buf_num_pools = 0;
+
+static void wsf_mbed_os_buf_diag_cb(WsfBufDiag_t *pInfo)
+{
+    if (pInfo->type != WSF_BUF_ALLOC_FAILED || wsf_buf_num_pools == 0) {
+        return;
+    }
+
+    uint16_t len = pInfo->param.alloc.len;
+
+    /* pools are sorted by buffer size, the failure belongs to the first that fits */
+    uint8_t pool = 0;
+    while (pool < wsf_buf_num_pools - 1 && wsf_buf_pool_stats[pool].bufSize < len) {
+        ++pool;
+    }
+
+    core_util_critical_section_enter();
+    ++wsf_buf_failures[pool];
+    if (len > wsf_buf_failed_max_len[pool]) {
+        wsf_buf_failed_max_len[pool] = len;
+    }
+    core_util_critical_section_exit();
+
+#if MBED_CONF_CORDIO_BUFFER_POOL_PROFILING
+    tr_warn("Allocation of %u bytes failed in task %u", len, pInfo->param.alloc.taskId);
+#endif
+}
+
+/* refresh the statistics maintained by WSF */
+static void wsf_mbed_os_buf_update_stats(void)
+{
+    if (wsf_buf_num_pools) {
+        WsfBufGetPoolStats(wsf_buf_pool_stats, wsf_buf_num_pools);
+    }
+}
+
+void wsf_mbed_os_buf_stats_init(void)
+{
+    wsf_buf_num_pools = WsfBufGetNumPool();
+    if (wsf_buf_num_pools > WSF_BUF_STATS_MAX_POOL) {
+        wsf_buf_num_pools = WSF_BUF_STATS_MAX_POOL;
+    }
+
+    memset(wsf_buf_failures, 0, sizeof(wsf_buf_failures));
+    memset(wsf_buf_failed_max_len, 0, sizeof(wsf_buf_failed_max_len));
+    wsf_mbed_os_buf_update_stats();
+
+    WsfBufDiagRegister(wsf_mbed_os_buf_diag_cb);
+}
+
+uint32_t wsf_mbed_os_buf_get_alloc_failures(uint8_t pool)
+{
+    if (pool >= wsf_buf_num_pools) {
+        return 0;
+    }
+    return wsf_buf_failures[pool];
+}
+
+uint8_t wsf_mbed_os_buf_recommend(wsfBufPoolDesc_t *pDesc, uint8_t numPools, uint8_t headroom)
+{
+    wsf_mbed_os_buf_update_stats();
+
+    if (numPools > wsf_buf_num_pools) {
+        numPools = wsf_buf_num_pools;
+    }
+
+    for (uint8_t i = 0; i < numPools; ++i) {
+        const WsfBufPoolStat_t *stat = &wsf_buf_pool_stats[i];
+
+        uint32_t peak = (uint32_t) stat->maxAlloc + wsf_buf_failures[i];
+        uint32_t num = (peak * (100 + headroom) + 99) / 100;
+        if (num == 0) {
+            num = 1;
+        } else if (num > UINT8_MAX) {
+            num = UINT8_MAX;
+        }
+
+        /* only the last pool can receive requests larger than its buffers */
+        uint16_t len = stat->bufSize;
+        if (wsf_buf_failed_max_len[i] > len) {
+            len = (wsf_buf_failed_max_len[i] + 3) & ~3;
+        }
+
+        pDesc[i].len = len;
+        pDesc[i].num = (uint8_t) num;
+    }
+
+    return numPools;
+}
+
+void wsf_mbed_os_buf_trace_stats(void)
+{
+    wsf_mbed_os_buf_update_stats();
+
+    for (uint8_t i = 0; i < wsf_buf_num_pools; ++i) {
+        const WsfBufPoolStat_t *stat = &wsf_buf_pool_stats[i];
+        tr_info(
+            "pool %u: size %u, buffers %u, in use %u, max in use %u, max requested %u, failures %lu",
+            i,
+            stat->bufSize,
+            stat->numBuf,
+            stat->numAlloc,
+            stat->maxAlloc,
+            stat->maxReqLen,
+            (unsigned long) wsf_buf_failures[i]
+        );
+    }
+}
+
+void wsf_mbed_os_buf_trace_recommendation(void)
+{
+    wsfBufPoolDesc_t desc[WSF_BUF_STATS_MAX_POOL];
+    uint8_t count = wsf_mbed_os_buf_recommend(desc, WSF_BUF_STATS_MAX_POOL, MBED_CONF_CORDIO_BUFFER_POOL_HEADROOM);
+
+    tr_info("Recommended buffer pools (%lu bytes):", (unsigned long) WsfBufCalcSize(count, desc));
+    for (uint8_t i = 0; i < count; ++i) {
+        tr_info("    { %4u, %3u },", desc[i].len, desc[i].num);
+    }
+}
@@ -17,6 +17,26 @@
 #ifndef WSF_MBED_OS_ADAPTATION_H_
 #define WSF_MBED_OS_ADAPTATION_H_
 
+#include "wsf_types.h"
+#include "wsf_buf.h"
+
+/**
+ * Record the usage of the buffer pools, reported by
+ * BLE::getMemoryPoolStatistics(), and trace it with the recommended pool
+ * configuration when BLE is shut down.
+ */
+#ifndef MBED_CONF_CORDIO_BUFFER_POOL_PROFILING
+#define MBED_CONF_CORDIO_BUFFER_POOL_PROFILING 0
+#endif
+
+/**
+ * Extra buffers, in percent of the observed peak, added to each pool of the
+ * recommended configuration.
+ */
+#ifndef MBED_CONF_CORDIO_BUFFER_POOL_HEADROOM
+#define MBED_CONF_CORDIO_BUFFER_POOL_HEADROOM 25
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -36,6 +56,48 @@ void wsf_mbed_os_critical_section_exit(void);
  */
 void wsf_mbed_ble_signal_event(void);
 
+/**
+ * Start recording the usage of the buffer pools.
+ * Must be called after WsfBufInit.
+ */
+void wsf_mbed_os_buf_stats_init(void);
+
+/**
+ * Get the number of allocations which could not be served by a pool or
+ * any larger one.
+ *
+ * Failures are accounted to the smallest pool large enough for the request,
+ * requests larger than every pool are accounted to the last one.
+ */
+uint32_t wsf_mbed_os_buf_get_alloc_failures(uint8_t pool);
+
+/**
+ * Compute a pool configuration which would have served the recorded
+ * workload without failure.
+ *
+ * The number of buffers of each pool is its high-water mark plus the
+ * failures accounted to it, increased by headroom percent. The last pool is
+ * enlarged if larger buffers have been requested.
+ *
+ * @param pDesc Array receiving the recommended configuration.
+ * @param numPools Capacity of pDesc.
+ * @param headroom Extra buffers in percent of the peak usage.
+ *
+ * @return Number of pools written in pDesc.
+ */
+uint8_t wsf_mbed_os_buf_recommend(wsfBufPoolDesc_t *pDesc, uint8_t numPools, uint8_t headroom);
+
+/**
+ * Print the usage of each buffer pool with mbed-trace.
+ */
+void wsf_mbed_os_buf_trace_stats(void);
+
+/**
+ * Print the recommended pool configuration with mbed-trace, in a form that
+ * can be pasted in the HCI driver.
+ */
+void wsf_mbed_os_buf_trace_recommendation(void);
+
 #ifdef __cplusplus
 };
 #endif
@@ -0,0 +1,109 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "ble/gap/AdvertisingDataTemplate.h"
+
+namespace ble {
+
+namespace {
+// Each field starts with its length followed by its type
+const size_t FIELD_HEADER_SIZE = 2;
+const size_t LENGTH_INDEX = 0;
+const size_t TYPE_INDEX = 1;
+}
+
+AdvertisingDataTemplate::AdvertisingDataTemplate(mbed::Span<uint8_t> payload) :
+    _payload(payload),
+    _modified(true)
+{
+}
+
+ble_error_t AdvertisingDataTemplate::getField(
+    adv_data_type_t type,
+    field_t &field,
+    uint8_t offset,
+    uint8_t size
+) const
+{
+    size_t idx = 0;
+
+    while (idx + FIELD_HEADER_SIZE <= (size_t) _payload.size()) {
+        const uint8_t field_length = _payload[idx + LENGTH_INDEX];
+
+        // a zero length terminates the significant part of the payload
+        if (field_length == 0) {
+            break;
+        }
+
+        if (_payload[idx + TYPE_INDEX] == type.value()) {
+            const size_t data_size = field_length - 1;
+            if (idx + FIELD_HEADER_SIZE + data_size > (size_t) _payload.size()) {
+                return BLE_ERROR_INVALID_PARAM;
+            }
+            if (offset > data_size) {
+                return BLE_ERROR_INVALID_PARAM;
+            }
+            if (size == 0) {
+                size = data_size - offset;
+            }
+            if (size == 0 || offset + size > data_size) {
+                return BLE_ERROR_INVALID_PARAM;
+            }
+
+            field.offset = idx + FIELD_HEADER_SIZE + offset;
+            field.size = size;
+            return BLE_ERROR_NONE;
+        }
+
+        idx += field_length + 1;
+    }
+
+    return BLE_ERROR_NOT_FOUND;
+}
+
+ble_error_t AdvertisingDataTemplate::update(const field_t &field, mbed::Span<const uint8_t> value)
+{
+    if (value.size() != field.size || (size_t) field.offset + field.size > (size_t) _payload.size()) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t *destination = _payload.data() + field.offset;
+    if (memcmp(destination, value.data(), field.size) != 0) {
+        memcpy(destination, value.data(), field.size);
+        _modified = true;
+    }
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t AdvertisingDataTemplate::update(const field_t &field, uint32_t value)
+{
+    if (field.size > sizeof(value)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t bytes[sizeof(value)];
+    for (size_t i = 0; i < field.size; ++i) {
+        bytes[i] = value >> (8 * i);
+    }
+
+    return update(field, mbed::make_const_Span(bytes, field.size));
+}
+
+} // namespace ble
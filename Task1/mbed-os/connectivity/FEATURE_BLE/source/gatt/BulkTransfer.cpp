@@ -0,0 +1,477 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ble/gatt/BulkTransfer.h"
+
+#include "mbed-trace/mbed_trace.h"
+#include "common/ble_trace_helpers.h"
+
+#define TRACE_GROUP "BLBT"
+
+namespace ble {
+
+namespace {
+
+/* ATT opcode + attribute handle */
+constexpr uint16_t ATT_HEADER_LENGTH = 3;
+/* L2CAP length + channel ID */
+constexpr uint16_t L2CAP_HEADER_LENGTH = 4;
+
+constexpr uint16_t DEFAULT_ATT_MTU = 23;
+constexpr uint16_t DEFAULT_TX_OCTETS = 27;
+
+constexpr uint16_t MAX_TX_OCTETS = 251;
+/* time to send 251 octets on the 1M PHY */
+constexpr uint16_t MAX_TX_TIME = 2120;
+
+}
+
+BulkTransfer::BulkTransfer(BLE &ble, uint8_t window) :
+    _ble(ble),
+    _event_handler(nullptr),
+    _connection(0),
+    _attribute(0),
+    _data(nullptr),
+    _size(0),
+    _mode(WRITE_WITHOUT_RESPONSE),
+    _state(IDLE),
+    _acked_offset(0),
+    _sent_offset(0),
+    _in_flight(),
+    _in_flight_head(0),
+    _in_flight_count(0),
+    _window(window == 0 ? 1 : (window > MAX_IN_FLIGHT ? MAX_IN_FLIGHT : window)),
+    _att_mtu(DEFAULT_ATT_MTU),
+    _tx_octets(DEFAULT_TX_OCTETS),
+    _payload_size(computePayloadSize(DEFAULT_ATT_MTU, DEFAULT_TX_OCTETS)),
+    _packets_sent(0),
+    _stalls(0),
+    _timer()
+{
+#if BLE_FEATURE_GATT_CLIENT
+    _ble.gattClient().onDataWritten().add(
+        makeFunctionPointer(this, &BulkTransfer::when_data_written)
+    );
+#endif
+}
+
+BulkTransfer::~BulkTransfer()
+{
+#if BLE_FEATURE_GATT_CLIENT
+    _ble.gattClient().onDataWritten().detach(
+        makeFunctionPointer(this, &BulkTransfer::when_data_written)
+    );
+#endif
+}
+
+void BulkTransfer::setEventHandler(EventHandler *handler)
+{
+    _event_handler = handler;
+}
+
+ble_error_t BulkTransfer::negotiate(connection_handle_t connectionHandle, Mode mode)
+{
+    if (isActive() && connectionHandle != _connection) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    /* link events are tracked for this connection from now on */
+    _connection = connectionHandle;
+
+    ble_error_t err = BLE_ERROR_NOT_IMPLEMENTED;
+    bool started = false;
+
+#if BLE_FEATURE_GATT_CLIENT
+    if (mode == WRITE_WITHOUT_RESPONSE) {
+        err = _ble.gattClient().negotiateAttMtu(connectionHandle);
+        started |= (err == BLE_ERROR_NONE);
+    }
+#endif
+
+#if BLE_FEATURE_CONNECTABLE
+    err = _ble.gap().setDataLength(connectionHandle, MAX_TX_OCTETS, MAX_TX_TIME);
+    started |= (err == BLE_ERROR_NONE);
+#endif
+
+#if BLE_FEATURE_PHY_MANAGEMENT
+    const phy_set_t phy_2m(phy_t::LE_2M);
+    err = _ble.gap().setPhy(
+        connectionHandle,
+        &phy_2m,
+        &phy_2m,
+        coded_symbol_per_bit_t::UNDEFINED
+    );
+    started |= (err == BLE_ERROR_NONE);
+#endif
+
+    tr_info("Connection %d: bulk transfer link negotiation %s",
+            connectionHandle, started ? "started" : "failed");
+
+    return started ? BLE_ERROR_NONE : err;
+}
+
+ble_error_t BulkTransfer::start(
+    connection_handle_t connectionHandle,
+    GattAttribute::Handle_t attributeHandle,
+    const uint8_t *data,
+    size_t size,
+    Mode mode,
+    size_t offset
+)
+{
+    if (_state != IDLE) {
+        tr_error("Bulk transfer already in progress");
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    if (!data || offset > size) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+#if !BLE_FEATURE_GATT_CLIENT
+    if (mode == WRITE_WITHOUT_RESPONSE) {
+        return BLE_ERROR_NOT_IMPLEMENTED;
+    }
+#endif
+#if !BLE_FEATURE_GATT_SERVER
+    if (mode == NOTIFICATION) {
+        return BLE_ERROR_NOT_IMPLEMENTED;
+    }
+#endif
+
+    if (connectionHandle != _connection) {
+        /* link parameters haven't been tracked for this connection */
+        _connection = connectionHandle;
+        _att_mtu = DEFAULT_ATT_MTU;
+        _tx_octets = DEFAULT_TX_OCTETS;
+        _payload_size = computePayloadSize(_att_mtu, _tx_octets);
+    }
+    _attribute = attributeHandle;
+    _data = data;
+    _size = size;
+    _mode = mode;
+    _acked_offset = offset;
+    _sent_offset = offset;
+    _in_flight_head = 0;
+    _in_flight_count = 0;
+    _packets_sent = 0;
+    _stalls = 0;
+
+    tr_info("Connection %d: bulk transfer of %u bytes from offset %u, payload %d",
+            connectionHandle, (unsigned) size, (unsigned) offset, _payload_size);
+
+    _timer.reset();
+    _timer.start();
+    _state = RUNNING;
+    pump();
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t BulkTransfer::resume(connection_handle_t connectionHandle)
+{
+    if (_state != SUSPENDED) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    _connection = connectionHandle;
+    _sent_offset = _acked_offset;
+    _in_flight_head = 0;
+    _in_flight_count = 0;
+
+    tr_info("Connection %d: resume bulk transfer at offset %u",
+            connectionHandle, (unsigned) _acked_offset);
+
+    _timer.start();
+    _state = RUNNING;
+    pump();
+
+    return BLE_ERROR_NONE;
+}
+
+void BulkTransfer::abort()
+{
+    if (_state != RUNNING) {
+        return;
+    }
+
+    if (_in_flight_count == 0) {
+        end(BLE_ERROR_OPERATION_NOT_PERMITTED);
+    } else {
+        _state = ABORTING;
+    }
+}
+
+bool BulkTransfer::isActive() const
+{
+    return _state == RUNNING || _state == ABORTING;
+}
+
+size_t BulkTransfer::getOffset() const
+{
+    return _acked_offset;
+}
+
+uint16_t BulkTransfer::getPayloadSize() const
+{
+    return _payload_size;
+}
+
+BulkTransfer::Statistics BulkTransfer::getStatistics() const
+{
+    Statistics stats;
+    stats.bytes_sent = _acked_offset;
+    stats.packets_sent = _packets_sent;
+    stats.stalls = _stalls;
+    stats.payload_size = _payload_size;
+    stats.elapsed = _timer.elapsed_time();
+    return stats;
+}
+
+uint16_t BulkTransfer::computePayloadSize(uint16_t attMtu, uint16_t txOctets)
+{
+    if (attMtu <= ATT_HEADER_LENGTH) {
+        return 0;
+    }
+
+    uint16_t max_payload = attMtu - ATT_HEADER_LENGTH;
+    if (txOctets == 0) {
+        return max_payload;
+    }
+
+    /* Shrink the packet so that its last link layer fragment is full; a
+     * mostly empty trailing fragment costs as much air time as a full one. */
+    uint16_t pdus = (max_payload + ATT_HEADER_LENGTH + L2CAP_HEADER_LENGTH) / txOctets;
+    if (pdus == 0) {
+        return max_payload;
+    }
+
+    uint16_t aligned = pdus * txOctets - ATT_HEADER_LENGTH - L2CAP_HEADER_LENGTH;
+    return aligned < max_payload ? aligned : max_payload;
+}
+
+void BulkTransfer::onDataLengthChange(
+    connection_handle_t connectionHandle,
+    uint16_t txSize,
+    uint16_t rxSize
+)
+{
+    (void) rxSize;
+    if (connectionHandle != _connection) {
+        return;
+    }
+    _tx_octets = txSize;
+    update_payload_size();
+}
+
+void BulkTransfer::onPhyUpdateComplete(
+    ble_error_t status,
+    connection_handle_t connectionHandle,
+    phy_t txPhy,
+    phy_t rxPhy
+)
+{
+    (void) rxPhy;
+    if (connectionHandle != _connection) {
+        return;
+    }
+    tr_info("Connection %d: bulk transfer PHY update status=%s, txPhy=%s",
+            connectionHandle, ble_error_to_string(status), to_string(txPhy));
+}
+
+void BulkTransfer::onDisconnectionComplete(const DisconnectionCompleteEvent &event)
+{
+    if (event.getConnectionHandle() != _connection) {
+        return;
+    }
+
+    _att_mtu = DEFAULT_ATT_MTU;
+    _tx_octets = DEFAULT_TX_OCTETS;
+    _payload_size = computePayloadSize(_att_mtu, _tx_octets);
+
+    if (_state == RUNNING || _state == ABORTING) {
+        /* packets still queued are lost with the connection */
+        _in_flight_count = 0;
+        _sent_offset = _acked_offset;
+        _timer.stop();
+        _state = (_state == RUNNING) ? SUSPENDED : IDLE;
+        if (_event_handler) {
+            _event_handler->onBulkTransferEnd(
+                event.getConnectionHandle(),
+                _state == SUSPENDED ? BLE_ERROR_INVALID_STATE : BLE_ERROR_OPERATION_NOT_PERMITTED,
+                _acked_offset
+            );
+        }
+    }
+}
+
+void BulkTransfer::onAttMtuChange(
+    connection_handle_t connectionHandle,
+    uint16_t attMtuSize
+)
+{
+    if (connectionHandle != _connection) {
+        return;
+    }
+    _att_mtu = attMtuSize;
+    update_payload_size();
+}
+
+void BulkTransfer::onDataSent(const GattDataSentCallbackParams &params)
+{
+    if (_mode != NOTIFICATION ||
+        params.connHandle != _connection ||
+        params.attHandle != _attribute
+    ) {
+        return;
+    }
+    on_packet_sent();
+}
+
+void BulkTransfer::when_data_written(const GattWriteCallbackParams *params)
+{
+    if (_mode != WRITE_WITHOUT_RESPONSE ||
+        params->writeOp != GattWriteCallbackParams::OP_WRITE_CMD ||
+        params->connHandle != _connection ||
+        params->handle != _attribute
+    ) {
+        return;
+    }
+
+    if (params->status != BLE_ERROR_NONE) {
+        tr_error("Connection %d: bulk transfer write failed, status=%s",
+                 _connection, ble_error_to_string(params->status));
+        _in_flight_count = 0;
+        end(params->status);
+        return;
+    }
+
+    on_packet_sent();
+}
+
+void BulkTransfer::on_packet_sent()
+{
+    if (!isActive() || _in_flight_count == 0) {
+        return;
+    }
+
+    _acked_offset += _in_flight[_in_flight_head];
+    _in_flight_head = (_in_flight_head + 1) % MAX_IN_FLIGHT;
+    --_in_flight_count;
+    ++_packets_sent;
+
+    if (_state == ABORTING) {
+        if (_in_flight_count == 0) {
+            end(BLE_ERROR_OPERATION_NOT_PERMITTED);
+        }
+        return;
+    }
+
+    if (_acked_offset == _size) {
+        end(BLE_ERROR_NONE);
+        return;
+    }
+
+    pump();
+}
+
+void BulkTransfer::pump()
+{
+    while (_state == RUNNING && _in_flight_count < _window && _sent_offset < _size) {
+        size_t remaining = _size - _sent_offset;
+        uint16_t length = remaining < _payload_size ? remaining : _payload_size;
+
+        ble_error_t err = BLE_ERROR_NOT_IMPLEMENTED;
+        if (_mode == WRITE_WITHOUT_RESPONSE) {
+#if BLE_FEATURE_GATT_CLIENT
+            err = _ble.gattClient().write(
+                GattClient::GATT_OP_WRITE_CMD,
+                _connection,
+                _attribute,
+                length,
+                _data + _sent_offset
+            );
+#endif
+        } else {
+#if BLE_FEATURE_GATT_SERVER
+            err = _ble.gattServer().write(
+                _connection,
+                _attribute,
+                _data + _sent_offset,
+                length
+            );
+#endif
+        }
+
+        if (err == BLE_ERROR_NO_MEM || err == BLE_STACK_BUSY) {
+            /* the stack is full, next packet sent event will restart the pump */
+            ++_stalls;
+            if (_in_flight_count == 0) {
+                end(err);
+            }
+            return;
+        } else if (err != BLE_ERROR_NONE) {
+            tr_error("Connection %d: bulk transfer failed at offset %u, err=%s",
+                     _connection, (unsigned) _sent_offset, ble_error_to_string(err));
+            end(err);
+            return;
+        }
+
+        _in_flight[(_in_flight_head + _in_flight_count) % MAX_IN_FLIGHT] = length;
+        ++_in_flight_count;
+        _sent_offset += length;
+    }
+
+    if (_state == RUNNING && _in_flight_count == 0 && _acked_offset == _size) {
+        end(BLE_ERROR_NONE);
+    }
+}
+
+void BulkTransfer::end(ble_error_t status)
+{
+    _timer.stop();
+    _state = IDLE;
+
+    Statistics stats = getStatistics();
+    tr_info("Connection %d: bulk transfer end status=%s, %u bytes in %u packets, "
+            "%u stalls, %lu B/s",
+            _connection, ble_error_to_string(status), (unsigned) stats.bytes_sent,
+            (unsigned) stats.packets_sent, (unsigned) stats.stalls,
+            (unsigned long) stats.throughput());
+
+    if (_event_handler) {
+        _event_handler->onBulkTransferEnd(_connection, status, _acked_offset);
+    }
+}
+
+void BulkTransfer::update_payload_size()
+{
+    uint16_t payload_size = computePayloadSize(_att_mtu, _tx_octets);
+    if (payload_size == _payload_size) {
+        return;
+    }
+
+    _payload_size = payload_size;
+    tr_info("Connection %d: bulk transfer payload %d (mtu=%d, tx octets=%d)",
+            _connection, _payload_size, _att_mtu, _tx_octets);
+
+    if (_event_handler) {
+        _event_handler->onBulkTransferLinkUpdate(_connection, _payload_size);
+    }
+}
+
+} // namespace ble
@@ -376,6 +376,14 @@ Gap::Gap(
 #if BLE_FEATURE_EXTENDED_ADVERTISING
     _advertising_enable_command_params.number_of_handles = 0;
 #endif //BLE_FEATURE_EXTENDED_ADVERTISING
+#if BLE_FEATURE_CONNECTABLE
+    for (ConnectionEventTiming &timing : _connection_event_timings) {
+        timing.gap = this;
+        timing.in_use = false;
+        timing.timer_running = false;
+        timing.producer_pending = false;
+    }
+#endif // BLE_FEATURE_CONNECTABLE
     _pal_gap.initialize();
 
     _pal_gap.when_gap_event_received(
@@ -969,6 +977,128 @@ ble_error_t Gap::disconnect(
 
     return _pal_gap.disconnect(connectionHandle, reason);
 }
+
+ble_error_t Gap::setDataLength(
+    connection_handle_t connectionHandle,
+    uint16_t txOctets,
+    uint16_t txTimeUs
+)
+{
+    tr_info("Connection %d: set data length - "
+            "txOctets=%d, "
+            "txTimeUs=%d",
+            connectionHandle,
+            txOctets,
+            txTimeUs);
+
+    if (txOctets < 27 || txOctets > 251 || txTimeUs < 328 || txTimeUs > 17040) {
+        tr_error("Data length out of range");
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    return _pal_gap.set_data_length(connectionHandle, txOctets, txTimeUs);
+}
+
+ble_error_t Gap::getConnectionEventTiming(
+    connection_handle_t connectionHandle,
+    connection_event_timing_t &timing
+)
+{
+    ConnectionEventTiming *entry = get_connection_event_timing(connectionHandle);
+    if (!entry) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    timing.interval = conn_interval_t(entry->interval);
+    timing.latency = slave_latency_t(entry->latency);
+    timing.next_event_known = false;
+    timing.next_event_estimated = false;
+    timing.next_event = microsecond_t(0);
+
+    microsecond_t delay(0);
+    if (_pal_gap.get_next_connection_event(connectionHandle, delay) == BLE_ERROR_NONE) {
+        timing.next_event_known = true;
+        timing.next_event = delay;
+    } else if (entry->interval) {
+        const uint32_t interval = entry->interval * conn_interval_t::TIME_BASE;
+        timing.next_event_known = true;
+        timing.next_event_estimated = true;
+        timing.next_event = microsecond_t(interval - entry->anchor.elapsed_time().count() % interval);
+    }
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::setConnectionEventProducer(
+    connection_handle_t connectionHandle,
+    mbed::Callback<void(connection_handle_t)> producer,
+    microsecond_t lead
+)
+{
+    tr_info("Connection %d: set connection event producer - "
+            "lead=%" PRIu32 "us",
+            connectionHandle,
+            lead.value());
+
+    ConnectionEventTiming *entry = get_connection_event_timing(connectionHandle);
+    if (!entry || !producer || lead.value() >= entry->interval * conn_interval_t::TIME_BASE) {
+        tr_error("Invalid connection event producer");
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    if (entry->producer) {
+        clearConnectionEventProducer(connectionHandle);
+    }
+
+    entry->producer = producer;
+    entry->lead = lead;
+
+    ble_error_t err = _pal_gap.enable_connection_event_notification(connectionHandle, lead, true);
+    if (err == BLE_ERROR_NONE) {
+        entry->notified_by_controller = true;
+        return BLE_ERROR_NONE;
+    }
+
+    if (err != BLE_ERROR_NOT_IMPLEMENTED) {
+        entry->producer = nullptr;
+        return err;
+    }
+
+    /* The controller doesn't report connection events; they are predicted
+     * from the last event that changed the connection parameters. */
+    const uint32_t interval = entry->interval * conn_interval_t::TIME_BASE;
+    const uint32_t since_anchor = entry->anchor.elapsed_time().count() % interval;
+    uint32_t delay = interval - since_anchor;
+    if (delay <= lead.value()) {
+        delay += interval;
+    }
+
+    entry->notified_by_controller = false;
+    entry->start_timer(microsecond_t(delay - lead.value()));
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::clearConnectionEventProducer(connection_handle_t connectionHandle)
+{
+    ConnectionEventTiming *entry = get_connection_event_timing(connectionHandle);
+    if (!entry || !entry->producer) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    if (entry->notified_by_controller) {
+        _pal_gap.enable_connection_event_notification(connectionHandle, entry->lead, false);
+        entry->notified_by_controller = false;
+    } else {
+        entry->timer.detach();
+        entry->timer_running = false;
+    }
+
+    entry->producer_pending = false;
+    entry->producer = nullptr;
+
+    return BLE_ERROR_NONE;
+}
 #endif // BLE_FEATURE_CONNECTABLE
 
 #if BLE_FEATURE_WHITELIST
@@ -1255,6 +1385,17 @@ ble_error_t Gap::reset()
     _advertising_timeout.detach();
 #endif // #BLE_ROLE_BROADCASTER
 
+#if BLE_FEATURE_CONNECTABLE
+    for (ConnectionEventTiming &timing : _connection_event_timings) {
+        timing.timer.detach();
+        timing.anchor.stop();
+        timing.timer_running = false;
+        timing.producer_pending = false;
+        timing.producer = nullptr;
+        timing.in_use = false;
+    }
+#endif // BLE_FEATURE_CONNECTABLE
+
     return BLE_ERROR_NONE;
 }
 
@@ -1604,6 +1745,8 @@ void Gap::on_connection_complete(const GapConnectionCompleteEvent &e)
     }
 #endif // BLE_ROLE_PERIPHERAL
 
+    update_connection_event_timing(e.connection_handle, e.connection_interval, e.connection_latency);
+
     ConnectionCompleteEvent event(
         BLE_ERROR_NONE,
         e.connection_handle,
@@ -1637,6 +1780,8 @@ void Gap::on_disconnection_complete(const GapDisconnectionCompleteEvent &e)
     }
 
     if (e.status == hci_error_code_t::SUCCESS) {
+        release_connection_event_timing(e.connection_handle);
+
         // signal internal stack
         if (_connection_event_handler) {
             _connection_event_handler->on_disconnected(
@@ -1711,6 +1856,10 @@ void Gap::on_connection_update(const GapConnectionUpdateEvent &e)
             e.connection_latency,
             e.supervision_timeout);
 
+    if (e.status == hci_error_code_t::SUCCESS) {
+        update_connection_event_timing(e.connection_handle, e.connection_interval, e.connection_latency);
+    }
+
     if (!_event_handler) {
         return;
     }
@@ -2336,6 +2485,86 @@ ble_error_t Gap::setAdvertisingData(
 }
 #endif // BLE_ROLE_BROADCASTER
 
+#if BLE_ROLE_BROADCASTER
+ble_error_t Gap::updateAdvertisingPayload(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &payload
+)
+{
+    return updateAdvertisingData(handle, payload, /* scan response */ false);
+}
+#endif
+
+
+#if BLE_ROLE_BROADCASTER
+ble_error_t Gap::updateAdvertisingScanResponse(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &response
+)
+{
+    return updateAdvertisingData(handle, response, /* scan response */ true);
+}
+#endif
+
+
+#if BLE_ROLE_BROADCASTER
+ble_error_t Gap::updateAdvertisingData(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &payload,
+    bool scan_response
+)
+{
+    if (!payload.isModified()) {
+        return BLE_ERROR_NONE;
+    }
+
+    Span<const uint8_t> data = payload.getAdvertisingData();
+    ble_error_t err;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    // A payload sent in a single command is replaced atomically by the
+    // controller, even while the set is advertising. Its size is checked
+    // against the most restrictive limit so no other validation is needed.
+    if (is_extended_advertising_available() &&
+        handle < getMaxAdvertisingSetNumber() &&
+        _existing_sets.get(handle) &&
+        data.size() <= getMaxConnectableAdvertisingDataLength() &&
+        data.size() <= _pal_gap.get_maximum_hci_advertising_data_length()
+    ) {
+        tr_debug("Advertising set %d: update %s", handle, scan_response ? "scan response" : "advertising data");
+
+        if (scan_response) {
+            err = _pal_gap.set_extended_scan_response_data(
+                handle,
+                advertising_fragment_description_t::COMPLETE_FRAGMENT,
+                /* minimize fragmentation */ true,
+                data.size(),
+                data.data()
+            );
+        } else {
+            _connectable_payload_size_exceeded.clear(handle);
+            err = _pal_gap.set_extended_advertising_data(
+                handle,
+                advertising_fragment_description_t::COMPLETE_FRAGMENT,
+                /* minimize fragmentation */ true,
+                data.size(),
+                data.data()
+            );
+        }
+    } else
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+    {
+        err = setAdvertisingData(handle, data, /* minimise fragmentation */ true, scan_response);
+    }
+
+    if (err == BLE_ERROR_NONE) {
+        payload.clearModified();
+    }
+
+    return err;
+}
+#endif // BLE_ROLE_BROADCASTER
+
 #if BLE_ROLE_BROADCASTER
 ble_error_t Gap::startAdvertising(
     advertising_handle_t handle,
@@ -2760,6 +2989,46 @@ ble_error_t Gap::setPeriodicAdvertisingPayload(
 #endif
 
 
+#if BLE_ROLE_BROADCASTER
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+ble_error_t Gap::updatePeriodicAdvertisingPayload(
+    advertising_handle_t handle,
+    AdvertisingDataTemplate &payload
+)
+{
+    if (!payload.isModified()) {
+        return BLE_ERROR_NONE;
+    }
+
+    Span<const uint8_t> data = payload.getAdvertisingData();
+    ble_error_t err;
+
+    if (handle != LEGACY_ADVERTISING_HANDLE &&
+        handle < getMaxAdvertisingSetNumber() &&
+        _existing_sets.get(handle) &&
+        data.size() <= _pal_gap.get_maximum_hci_advertising_data_length()
+    ) {
+        tr_debug("Advertising set %d: update periodic advertising payload", handle);
+        err = _pal_gap.set_periodic_advertising_data(
+            handle,
+            advertising_fragment_description_t::COMPLETE_FRAGMENT,
+            data.size(),
+            data.data()
+        );
+    } else {
+        err = setPeriodicAdvertisingPayload(handle, data);
+    }
+
+    if (err == BLE_ERROR_NONE) {
+        payload.clearModified();
+    }
+
+    return err;
+}
+#endif
+#endif
+
+
 #if BLE_ROLE_BROADCASTER
 #if BLE_FEATURE_PERIODIC_ADVERTISING
 ble_error_t Gap::startPeriodicAdvertising(advertising_handle_t handle)
@@ -3581,6 +3850,10 @@ void Gap::on_connection_update_complete(
             connection_latency,
             supervision_timeout);
 
+    if (status == hci_error_code_t::SUCCESS) {
+        update_connection_event_timing(connection_handle, connection_interval, connection_latency);
+    }
+
     if (!_event_handler) {
         return;
     }
@@ -3638,6 +3911,110 @@ void Gap::on_remote_connection_parameter(
         );
     }
 }
+
+void Gap::on_connection_event_notification(connection_handle_t connection_handle)
+{
+    ConnectionEventTiming *entry = get_connection_event_timing(connection_handle);
+    if (entry && entry->producer) {
+        entry->producer(connection_handle);
+    }
+}
+
+Gap::ConnectionEventTiming *Gap::get_connection_event_timing(connection_handle_t connection)
+{
+    for (ConnectionEventTiming &timing : _connection_event_timings) {
+        if (timing.in_use && timing.handle == connection) {
+            return &timing;
+        }
+    }
+    return nullptr;
+}
+
+void Gap::update_connection_event_timing(
+    connection_handle_t connection,
+    uint16_t interval,
+    uint16_t latency
+)
+{
+    ConnectionEventTiming *entry = get_connection_event_timing(connection);
+    if (!entry) {
+        for (ConnectionEventTiming &timing : _connection_event_timings) {
+            if (!timing.in_use) {
+                entry = &timing;
+                break;
+            }
+        }
+        if (!entry) {
+            tr_warning("Connection %d: connection event timing not tracked", connection);
+            return;
+        }
+        entry->in_use = true;
+        entry->handle = connection;
+        entry->notified_by_controller = false;
+        entry->timer_running = false;
+        entry->producer_pending = false;
+        entry->producer = nullptr;
+    }
+
+    entry->interval = interval;
+    entry->latency = latency;
+
+    /* The new parameters apply from the connection event reported, the next
+     * anchor point is one interval away. */
+    entry->anchor.reset();
+    entry->anchor.start();
+    if (entry->producer && !entry->notified_by_controller) {
+        entry->start_timer(microsecond_t(interval * conn_interval_t::TIME_BASE - entry->lead.value()));
+    }
+}
+
+void Gap::release_connection_event_timing(connection_handle_t connection)
+{
+    ConnectionEventTiming *entry = get_connection_event_timing(connection);
+    if (!entry) {
+        return;
+    }
+
+    entry->timer.detach();
+    entry->anchor.stop();
+    entry->timer_running = false;
+    entry->producer_pending = false;
+    entry->producer = nullptr;
+    entry->in_use = false;
+}
+
+void Gap::process_connection_event_timeouts()
+{
+    for (ConnectionEventTiming &timing : _connection_event_timings) {
+        if (timing.in_use && timing.producer_pending) {
+            timing.producer_pending = false;
+            if (timing.producer) {
+                timing.producer(timing.handle);
+            }
+        }
+    }
+}
+
+void Gap::ConnectionEventTiming::start_timer(microsecond_t delay)
+{
+    timer.attach(
+        mbed::callback(this, &ConnectionEventTiming::on_timeout),
+        delay.valueChrono()
+    );
+    timer_running = true;
+}
+
+void Gap::ConnectionEventTiming::on_timeout()
+{
+    /* rearm from the interrupt so the latency of the event queue doesn't
+     * accumulate from one connection event to the next */
+    start_timer(microsecond_t(interval * conn_interval_t::TIME_BASE));
+
+    if (!producer_pending) {
+        producer_pending = true;
+        gap->_event_queue.post(mbed::callback(gap, &Gap::process_connection_event_timeouts));
+    }
+}
 #endif // BLE_FEATURE_CONNECTABLE
 
 #if BLE_ROLE_OBSERVER
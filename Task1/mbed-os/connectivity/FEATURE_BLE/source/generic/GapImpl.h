@@ -44,9 +44,15 @@
 #ifdef DEVICE_LPTICKER
 #include "drivers/LowPowerTimeout.h"
 #include "drivers/LowPowerTicker.h"
+#include "drivers/LowPowerTimer.h"
 #else
 #include "drivers/Timeout.h"
 #include "drivers/Ticker.h"
+#include "drivers/Timer.h"
+#endif
+
+#ifndef MBED_CONF_BLE_API_IMPLEMENTATION_MAX_CONNECTION_TIMINGS
+#define MBED_CONF_BLE_API_IMPLEMENTATION_MAX_CONNECTION_TIMINGS 3
 #endif
 
 namespace ble {
@@ -84,9 +90,11 @@ public:
 #ifdef DEVICE_LPTICKER
     using Timeout = mbed::LowPowerTimeout;
     using Ticker  = mbed::LowPowerTicker;
+    using Timer   = mbed::LowPowerTimer;
 #else
     using Timeout = mbed::Timeout;
     using Ticker  = mbed::Ticker;
+    using Timer   = mbed::Timer;
 #endif
 
 #if BLE_FEATURE_PRIVACY
@@ -149,6 +157,16 @@ public:
         mbed::Span<const uint8_t> response
     );
 
+    ble_error_t updateAdvertisingPayload(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload
+    );
+
+    ble_error_t updateAdvertisingScanResponse(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &response
+    );
+
     ble_error_t startAdvertising(
         advertising_handle_t handle,
         adv_duration_t maxDuration = adv_duration_t::forever(),
@@ -176,6 +194,11 @@ public:
         mbed::Span<const uint8_t> payload
     );
 
+    ble_error_t updatePeriodicAdvertisingPayload(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload
+    );
+
     ble_error_t startPeriodicAdvertising(advertising_handle_t handle);
 
     ble_error_t stopPeriodicAdvertising(advertising_handle_t handle);
@@ -288,6 +311,25 @@ public:
         local_disconnection_reason_t reason
     );
 
+    ble_error_t setDataLength(
+        connection_handle_t connectionHandle,
+        uint16_t txOctets,
+        uint16_t txTimeUs
+    );
+
+    ble_error_t getConnectionEventTiming(
+        connection_handle_t connectionHandle,
+        connection_event_timing_t &timing
+    );
+
+    ble_error_t setConnectionEventProducer(
+        connection_handle_t connectionHandle,
+        mbed::Callback<void(connection_handle_t)> producer,
+        microsecond_t lead
+    );
+
+    ble_error_t clearConnectionEventProducer(connection_handle_t connectionHandle);
+
 #endif // BLE_FEATURE_CONNECTABLE
 #if BLE_FEATURE_PHY_MANAGEMENT
 
@@ -588,6 +630,12 @@ private:
         bool scan_response
     );
 
+    ble_error_t updateAdvertisingData(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload,
+        bool scan_response
+    );
+
     void on_advertising_timeout();
 
     void process_advertising_timeout();
@@ -821,6 +869,10 @@ private:
         uint16_t connection_latency,
         uint16_t supervision_timeout
     ) override;
+
+    void on_connection_event_notification(
+        connection_handle_t connection_handle
+    ) override;
 #endif // BLE_FEATURE_CONNECTABLE
 
 #if BLE_ROLE_OBSERVER
@@ -872,6 +924,46 @@ private:
     void connecting_to_host_resolved_address_failed(bool inform_user = true);
 #endif // BLE_GAP_HOST_BASED_PRIVATE_ADDRESS_RESOLUTION
 
+#if BLE_FEATURE_CONNECTABLE
+    /*
+     * Connection event timing of a connection. When the controller cannot
+     * notify connection events, the producer is driven by a host timer
+     * rearmed every interval from its own interrupt. Its phase comes from
+     * the anchor: the date of the connection complete or connection update
+     * complete event, the closest the host gets to an anchor point.
+     */
+    struct ConnectionEventTiming {
+        void on_timeout();
+
+        void start_timer(microsecond_t delay);
+
+        Gap *gap;
+        connection_handle_t handle;
+        uint16_t interval;
+        uint16_t latency;
+        bool in_use;
+        bool notified_by_controller;
+        bool timer_running;
+        volatile bool producer_pending;
+        microsecond_t lead;
+        mbed::Callback<void(connection_handle_t)> producer;
+        Timeout timer;
+        Timer anchor;
+    };
+
+    ConnectionEventTiming *get_connection_event_timing(connection_handle_t connection);
+
+    void update_connection_event_timing(
+        connection_handle_t connection,
+        uint16_t interval,
+        uint16_t latency
+    );
+
+    void release_connection_event_timing(connection_handle_t connection);
+
+    void process_connection_event_timeouts();
+#endif // BLE_FEATURE_CONNECTABLE
+
 private:
     /**
      * Callchain containing all registered callback handlers for shutdown
@@ -952,6 +1044,10 @@ private:
     Timeout _scan_timeout;
     Ticker _address_rotation_ticker;
 
+#if BLE_FEATURE_CONNECTABLE
+    ConnectionEventTiming _connection_event_timings[MBED_CONF_BLE_API_IMPLEMENTATION_MAX_CONNECTION_TIMINGS];
+#endif // BLE_FEATURE_CONNECTABLE
+
     bool _initiating = false;
 
     template<size_t bit_size>
@@ -235,6 +235,17 @@ public:
         uint16_t connection_latency,
         uint16_t supervision_timeout
      ) = 0;
+
+    /**
+     * Called shortly before a connection event when connection event
+     * notifications have been enabled with
+     * PalGap::enable_connection_event_notification().
+     *
+     * @param connection_handle Handle of the connection.
+     */
+    virtual void on_connection_event_notification(
+        connection_handle_t connection_handle
+    ) = 0;
 #endif // BLE_FEATURE_CONNECTABLE
 };
 
@@ -1579,6 +1590,76 @@ public:
         connection_handle_t connection,
         local_disconnection_reason_t disconnection_reason
     ) = 0;
+
+    /**
+     * Suggest to the controller the maximum payload and maximum transmission
+     * time to use for LL data packets on a connection.
+     *
+     * Once the controller has negotiated the new values with the peer, it
+     * should emit a data length change event.
+     *
+     * @param connection Handle of the connection to update.
+     *
+     * @param tx_octets Preferred maximum number of payload octets the
+     * controller should include in a single LL data PDU (27 to 251).
+     *
+     * @param tx_time Preferred maximum number of microseconds the controller
+     * should use to transmit a single LL data PDU (328 to 17040).
+     *
+     * @return BLE_ERROR_NONE if the request has been successfully sent or the
+     * appropriate error otherwise.
+     *
+     * @note: See Bluetooth 5 Vol 2 PartE: 7.8.33 LE Set Data Length command.
+     */
+    virtual ble_error_t set_data_length(
+        connection_handle_t connection,
+        uint16_t tx_octets,
+        uint16_t tx_time
+    ) = 0;
+
+    /**
+     * Get the delay until the next connection event of a connection.
+     *
+     * The standard HCI does not report the anchor point of connection events,
+     * controllers that know it through a vendor specific interface can
+     * implement this function.
+     *
+     * @param connection Handle of the connection.
+     *
+     * @param delay Time remaining before the anchor point of the next
+     * connection event.
+     *
+     * @return BLE_ERROR_NONE on success, BLE_ERROR_NOT_IMPLEMENTED if the
+     * controller does not report the timing of connection events or the
+     * appropriate error otherwise.
+     */
+    virtual ble_error_t get_next_connection_event(
+        connection_handle_t connection,
+        microsecond_t &delay
+    ) = 0;
+
+    /**
+     * Enable or disable the notification of connection events.
+     *
+     * When enabled, the event handler receives
+     * on_connection_event_notification() lead microseconds before the anchor
+     * point of each connection event.
+     *
+     * @param connection Handle of the connection.
+     *
+     * @param lead Delay between the notification and the anchor point.
+     *
+     * @param enable true to enable the notification, false to disable it.
+     *
+     * @return BLE_ERROR_NONE on success, BLE_ERROR_NOT_IMPLEMENTED if the
+     * controller cannot notify connection events or the appropriate error
+     * otherwise.
+     */
+    virtual ble_error_t enable_connection_event_notification(
+        connection_handle_t connection,
+        microsecond_t lead,
+        bool enable
+    ) = 0;
 #endif
 
     /**
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "wsf_mbed_os_adaptation.h"
+
+class TestWsfMbedOsAdaptation : public testing::Test {
+protected:
+    void init(std::vector<wsfBufPoolDesc_t> desc)
+    {
+        WsfBufInit(desc.size(), desc.data());
+        wsf_mbed_os_buf_stats_init();
+    }
+
+    /* allocate a burst of messages of each size, then release them all */
+    uint32_t run_workload()
+    {
+        std::vector<void *> buffers;
+        uint32_t failures = 0;
+        const struct {
+            uint16_t len;
+            uint8_t count;
+        } bursts[] = { { 16, 10 }, { 64, 4 }, { 260, 2 } };
+
+        for (const auto &burst : bursts) {
+            for (uint8_t i = 0; i < burst.count; ++i) {
+                void *buffer = WsfBufAlloc(burst.len);
+                if (buffer) {
+                    buffers.push_back(buffer);
+                } else {
+                    ++failures;
+                }
+            }
+        }
+        for (void *buffer : buffers) {
+            WsfBufFree(buffer);
+        }
+        return failures;
+    }
+
+    std::vector<wsfBufPoolDesc_t> recommend(uint8_t headroom)
+    {
+        std::vector<wsfBufPoolDesc_t> desc(WSF_BUF_STATS_MAX_POOL);
+        desc.resize(wsf_mbed_os_buf_recommend(desc.data(), desc.size(), headroom));
+        return desc;
+    }
+};
+
+TEST_F(TestWsfMbedOsAdaptation, failures_are_accounted_to_the_smallest_fitting_pool)
+{
+    init({ { 16, 4 }, { 64, 2 }, { 272, 1 } });
+    EXPECT_EQ(9u, run_workload());
+
+    /* 3 small messages do not fit anywhere once they have spilled over larger pools */
+    EXPECT_EQ(3u, wsf_mbed_os_buf_get_alloc_failures(0));
+    EXPECT_EQ(4u, wsf_mbed_os_buf_get_alloc_failures(1));
+    EXPECT_EQ(2u, wsf_mbed_os_buf_get_alloc_failures(2));
+    EXPECT_EQ(0u, wsf_mbed_os_buf_get_alloc_failures(3));
+}
+
+TEST_F(TestWsfMbedOsAdaptation, recommendation_serves_the_recorded_workload)
+{
+    init({ { 16, 4 }, { 64, 2 }, { 272, 1 } });
+    ASSERT_NE(0u, run_workload());
+
+    std::vector<wsfBufPoolDesc_t> desc = recommend(0);
+    ASSERT_EQ(3u, desc.size());
+    EXPECT_EQ(16, desc[0].len);
+    EXPECT_EQ(7, desc[0].num);
+    EXPECT_EQ(64, desc[1].len);
+    EXPECT_EQ(6, desc[1].num);
+    EXPECT_EQ(272, desc[2].len);
+    EXPECT_EQ(3, desc[2].num);
+
+    init(desc);
+    EXPECT_EQ(0u, run_workload());
+}
+
+TEST_F(TestWsfMbedOsAdaptation, recommendation_trims_oversized_pools)
+{
+    std::vector<wsfBufPoolDesc_t> initial = { { 16, 16 }, { 64, 16 }, { 128, 8 }, { 272, 8 } };
+    init(initial);
+    ASSERT_EQ(0u, run_workload());
+
+    std::vector<wsfBufPoolDesc_t> desc = recommend(25);
+    ASSERT_EQ(4u, desc.size());
+    EXPECT_EQ(13, desc[0].num);
+    EXPECT_EQ(5, desc[1].num);
+    /* an unused pool keeps a single buffer */
+    EXPECT_EQ(1, desc[2].num);
+    EXPECT_EQ(3, desc[3].num);
+    EXPECT_LT(WsfBufCalcSize(desc.size(), desc.data()), WsfBufCalcSize(initial.size(), initial.data()));
+
+    init(desc);
+    EXPECT_EQ(0u, run_workload());
+}
+
+TEST_F(TestWsfMbedOsAdaptation, recommendation_enlarges_the_last_pool)
+{
+    init({ { 16, 16 }, { 64, 8 }, { 128, 4 } });
+    EXPECT_EQ(2u, run_workload());
+
+    std::vector<wsfBufPoolDesc_t> desc = recommend(0);
+    ASSERT_EQ(3u, desc.size());
+    EXPECT_EQ(2u, wsf_mbed_os_buf_get_alloc_failures(2));
+    EXPECT_EQ(260, desc[2].len);
+    EXPECT_EQ(2, desc[2].num);
+
+    init(desc);
+    EXPECT_EQ(0u, run_workload());
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wsf_types.h"
+#include "wsf_cs.h"
+#include "wsf_heap.h"
+
+/* Memory of the buffer pools, every WsfBufInit starts again at its beginning */
+static uint32_t wsf_heap[8192 / sizeof(uint32_t)];
+static uint32_t wsf_heap_used = 0;
+
+void WsfCsEnter(void)
+{
+}
+
+void WsfCsExit(void)
+{
+}
+
+uint32_t WsfHeapCountAvailable(void)
+{
+    return sizeof(wsf_heap) - wsf_heap_used;
+}
+
+uint32_t WsfHeapCountUsed(void)
+{
+    return wsf_heap_used;
+}
+
+void WsfHeapAlloc(uint32_t size)
+{
+    wsf_heap_used = size;
+}
+
+void *WsfHeapGetFreeStartAddress(void)
+{
+    return wsf_heap;
+}
@@ -88,6 +88,16 @@ public:
         mbed::Span<const uint8_t> response
     ) { return BLE_ERROR_NONE; };
 
+    virtual ble_error_t updateAdvertisingPayload(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload
+    ) { return BLE_ERROR_NONE; };
+
+    virtual ble_error_t updateAdvertisingScanResponse(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &response
+    ) { return BLE_ERROR_NONE; };
+
     virtual ble_error_t startAdvertising(
         advertising_handle_t handle,
         adv_duration_t maxDuration = adv_duration_t::forever(),
@@ -115,6 +125,11 @@ public:
         mbed::Span<const uint8_t> payload
     ) { return BLE_ERROR_NONE; };
 
+    virtual ble_error_t updatePeriodicAdvertisingPayload(
+        advertising_handle_t handle,
+        AdvertisingDataTemplate &payload
+    ) { return BLE_ERROR_NONE; };
+
     virtual ble_error_t startPeriodicAdvertising(advertising_handle_t handle) { return BLE_ERROR_NONE; };
 
     virtual ble_error_t stopPeriodicAdvertising(advertising_handle_t handle) { return BLE_ERROR_NONE; };
@@ -227,6 +242,27 @@ public:
         local_disconnection_reason_t reason
     ) { return BLE_ERROR_NONE; };
 
+    virtual ble_error_t setDataLength(
+        connection_handle_t connectionHandle,
+        uint16_t txOctets,
+        uint16_t txTimeUs
+    ) { return BLE_ERROR_NONE; };
+
+    virtual ble_error_t getConnectionEventTiming(
+        connection_handle_t connectionHandle,
+        connection_event_timing_t &timing
+    ) { return BLE_ERROR_NONE; };
+
+    virtual ble_error_t setConnectionEventProducer(
+        connection_handle_t connectionHandle,
+        mbed::Callback<void(connection_handle_t)> producer,
+        microsecond_t lead
+    ) { return BLE_ERROR_NONE; };
+
+    virtual ble_error_t clearConnectionEventProducer(
+        connection_handle_t connectionHandle
+    ) { return BLE_ERROR_NONE; };
+
 #endif // BLE_FEATURE_CONNECTABLE
 #if BLE_FEATURE_PHY_MANAGEMENT
 
@@ -0,0 +1,180 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VirtualBLEInstanceBase.h"
+
+/**
+ * BLE-API requires an implementation of the following function in order to
+ * obtain its transport handle.
+ */
+ble::BLEInstanceBase *ble::createBLEInstance()
+{
+    return (&(ble::impl::BLEInstanceBase::deviceInstance()));
+}
+
+namespace ble {
+namespace impl {
+
+BLEInstanceBase::BLEInstanceBase() :
+    initialization_status(NOT_INITIALIZED),
+    _environment(virtual_pal::VirtualEnvironment::instance()),
+    _event_queue(_environment.simulator()),
+    _pal_gap(_environment),
+    _gap_service(),
+    _att_client(_environment),
+    _pal_gatt_client(_att_client),
+    _pal_security_manager(_environment)
+{
+}
+
+BLEInstanceBase &BLEInstanceBase::deviceInstance()
+{
+    static BLEInstanceBase instance;
+    return instance;
+}
+
+ble_error_t BLEInstanceBase::init(
+    FunctionPointerWithContext<::BLE::InitializationCompleteCallbackContext *> initCallback
+)
+{
+    if (initialization_status == INITIALIZED) {
+        return BLE_ERROR_NONE;
+    }
+
+    _att_client.initialize();
+    initialization_status = INITIALIZED;
+
+    /* completion is reported asynchronously, as a controller reset would be */
+    _environment.simulator().post([initCallback]() {
+        ::BLE::InitializationCompleteCallbackContext context = {
+            ::BLE::Instance(),
+            BLE_ERROR_NONE
+        };
+        initCallback.call(&context);
+    });
+
+    return BLE_ERROR_NONE;
+}
+
+bool BLEInstanceBase::hasInitialized() const
+{
+    return initialization_status == INITIALIZED;
+}
+
+ble_error_t BLEInstanceBase::shutdown()
+{
+    if (initialization_status != INITIALIZED) {
+        return BLE_ERROR_INITIALIZATION_INCOMPLETE;
+    }
+
+#if BLE_FEATURE_GATT_CLIENT
+    getGattClient().reset();
+#endif // BLE_FEATURE_GATT_CLIENT
+
+#if BLE_FEATURE_SECURITY
+    getSecurityManager().reset();
+#endif // BLE_FEATURE_SECURITY
+
+    getGap().reset();
+    _event_queue.clear();
+    _att_client.terminate();
+
+    initialization_status = NOT_INITIALIZED;
+
+    return BLE_ERROR_NONE;
+}
+
+const char *BLEInstanceBase::getVersion()
+{
+    static const char version[] = "generic-virtual";
+    return version;
+}
+
+ble::impl::Gap &BLEInstanceBase::getGapImpl()
+{
+    static ble::impl::Gap gap(
+        _event_queue,
+        _pal_gap,
+        _gap_service
+    );
+    return gap;
+}
+
+ble::Gap &BLEInstanceBase::getGap()
+{
+    auto &impl = getGapImpl();
+    static ble::Gap gap(&impl);
+    return gap;
+}
+
+const ble::Gap &BLEInstanceBase::getGap() const
+{
+    auto &self = const_cast<BLEInstanceBase &>(*this);
+    return const_cast<const ble::Gap &>(self.getGap());
+};
+
+#if BLE_FEATURE_GATT_CLIENT
+ble::impl::GattClient &BLEInstanceBase::getGattClientImpl()
+{
+    static ble::impl::GattClient gatt_client(getPalGattClient());
+    return gatt_client;
+}
+
+ble::GattClient &BLEInstanceBase::getGattClient()
+{
+    auto &impl = getGattClientImpl();
+    static ble::GattClient gatt_client(&impl);
+    return gatt_client;
+}
+
+PalGattClient &BLEInstanceBase::getPalGattClient()
+{
+    return _pal_gatt_client;
+}
+#endif // BLE_FEATURE_GATT_CLIENT
+
+#if BLE_FEATURE_SECURITY
+ble::impl::SecurityManager &BLEInstanceBase::getSecurityManagerImpl()
+{
+    static ble::impl::SecurityManager m_instance(
+        _pal_security_manager,
+        getGapImpl()
+    );
+
+    return m_instance;
+}
+
+ble::SecurityManager &BLEInstanceBase::getSecurityManager()
+{
+    static ble::SecurityManager m_instance(&getSecurityManagerImpl());
+    return m_instance;
+}
+
+const ble::SecurityManager &BLEInstanceBase::getSecurityManager() const
+{
+    const BLEInstanceBase &self = const_cast<BLEInstanceBase &>(*this);
+    return const_cast<const ble::SecurityManager &>(self.getSecurityManager());
+}
+#endif // BLE_FEATURE_SECURITY
+
+void BLEInstanceBase::processEvents()
+{
+    _environment.simulator().run_for(virtual_pal::sim_time_t(0));
+}
+
+} // namespace impl
+} // namespace ble
@@ -0,0 +1,153 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_BLE_INSTANCE_BASE_H_
+#define BLE_VIRTUAL_PAL_BLE_INSTANCE_BASE_H_
+
+#include "ble/BLE.h"
+#include "ble/Gap.h"
+#include "ble/GattClient.h"
+#include "ble/SecurityManager.h"
+
+#include "source/BLEInstanceBase.h"
+#include "source/pal/PalAttClientToGattClient.h"
+
+#include "source/generic/GapImpl.h"
+#include "source/generic/GattClientImpl.h"
+#include "source/generic/SecurityManagerImpl.h"
+
+#include "VirtualEnvironment.h"
+#include "VirtualPalAttClient.h"
+#include "VirtualPalEventQueue.h"
+#include "VirtualPalGap.h"
+#include "VirtualPalSecurityManager.h"
+
+namespace ble {
+namespace impl {
+
+/**
+ * Implementation of BLEInstanceBase binding the generic BLE layer to the
+ * virtual PAL.
+ *
+ * It takes the place of the vendor port: events are run by the simulator of
+ * the virtual environment rather than by a controller. A GATT server is not
+ * provided, the local device is a GATT client.
+ */
+class BLEInstanceBase final : public ble::BLEInstanceBase {
+    BLEInstanceBase();
+
+public:
+    /**
+     * Access to the singleton containing the implementation of BLEInstanceBase
+     * for the virtual PAL.
+     */
+    static BLEInstanceBase &deviceInstance();
+
+    /**
+     * @see BLEInstanceBase::init
+     */
+    ble_error_t init(
+        FunctionPointerWithContext<::BLE::InitializationCompleteCallbackContext *> initCallback
+    ) final;
+
+    /**
+     * @see BLEInstanceBase::hasInitialized
+     */
+    bool hasInitialized() const final;
+
+    /**
+     * @see BLEInstanceBase::shutdown
+     */
+    ble_error_t shutdown() final;
+
+    /**
+     * @see BLEInstanceBase::getVersion
+     */
+    const char *getVersion() final;
+
+    ble::impl::Gap &getGapImpl();
+
+    /**
+     * @see BLEInstanceBase::getGap
+     */
+    ble::Gap &getGap() final;
+
+    /**
+     * @see BLEInstanceBase::getGap
+     */
+    const ble::Gap &getGap() const final;
+
+#if BLE_FEATURE_GATT_CLIENT
+
+    ble::impl::GattClient &getGattClientImpl();
+
+    /**
+     * @see BLEInstanceBase::getGattClient
+     */
+    ble::GattClient &getGattClient() final;
+
+    /**
+     * Get the PAL Gatt Client.
+     *
+     * @return PAL Gatt Client.
+     */
+    PalGattClient &getPalGattClient();
+
+#endif // BLE_FEATURE_GATT_CLIENT
+
+#if BLE_FEATURE_SECURITY
+
+    ble::impl::SecurityManager &getSecurityManagerImpl();
+
+    /**
+     * @see BLEInstanceBase::getSecurityManager
+     */
+    ble::SecurityManager &getSecurityManager() final;
+
+    /**
+     * @see BLEInstanceBase::getSecurityManager
+     */
+    const ble::SecurityManager &getSecurityManager() const final;
+
+#endif // BLE_FEATURE_SECURITY
+
+    /**
+     * Run the events due at the current simulated time.
+     *
+     * @see BLEInstanceBase::processEvents
+     */
+    void processEvents() final;
+
+private:
+    enum {
+        NOT_INITIALIZED,
+        INITIALIZED
+    } initialization_status;
+
+    virtual_pal::VirtualEnvironment &_environment;
+    virtual_pal::VirtualPalEventQueue _event_queue;
+    virtual_pal::VirtualPalGap _pal_gap;
+    virtual_pal::VirtualPalGenericAccessService _gap_service;
+    virtual_pal::VirtualPalAttClient _att_client;
+    PalAttClientToGattClient _pal_gatt_client;
+    virtual_pal::VirtualPalSecurityManager _pal_security_manager;
+};
+
+} // namespace impl
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_BLE_INSTANCE_BASE_H_ */
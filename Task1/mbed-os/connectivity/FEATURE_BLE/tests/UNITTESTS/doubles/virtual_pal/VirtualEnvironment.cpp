@@ -0,0 +1,94 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VirtualEnvironment.h"
+
+namespace ble {
+namespace virtual_pal {
+
+namespace {
+const uint8_t LOCAL_ADDRESS[6] = { 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 };
+}
+
+VirtualEnvironment &VirtualEnvironment::instance()
+{
+    static VirtualEnvironment environment;
+    return environment;
+}
+
+VirtualEnvironment::VirtualEnvironment() :
+    _link(_simulator, LinkConfiguration()),
+    _peer(_link),
+    _local_address(LOCAL_ADDRESS)
+{
+    _link.set_receiver(
+        VirtualLink::TO_PEER,
+        [this](channel_t channel, const std::vector<uint8_t> &pdu) { _peer.on_sdu(channel, pdu); }
+    );
+    _link.set_receiver(
+        VirtualLink::TO_LOCAL,
+        [this](channel_t channel, const std::vector<uint8_t> &pdu) { dispatch(channel, pdu); }
+    );
+}
+
+void VirtualEnvironment::reset(const LinkConfiguration &configuration)
+{
+    _simulator.reset();
+    _link.configure(configuration);
+    _link.reset_statistics();
+    _peer.reset();
+    _background_advertisers = 0;
+    _controller_statistics = ControllerStatistics();
+}
+
+void VirtualEnvironment::set_local_receiver(channel_t channel, VirtualLink::sdu_handler_t handler)
+{
+    switch (channel) {
+        case channel_t::LL_CONTROL:
+            _ll_control_receiver = std::move(handler);
+            break;
+        case channel_t::ATT:
+            _att_receiver = std::move(handler);
+            break;
+        case channel_t::SMP:
+            _smp_receiver = std::move(handler);
+            break;
+    }
+}
+
+void VirtualEnvironment::dispatch(channel_t channel, const std::vector<uint8_t> &pdu)
+{
+    const VirtualLink::sdu_handler_t *receiver = nullptr;
+    switch (channel) {
+        case channel_t::LL_CONTROL:
+            receiver = &_ll_control_receiver;
+            break;
+        case channel_t::ATT:
+            receiver = &_att_receiver;
+            break;
+        case channel_t::SMP:
+            receiver = &_smp_receiver;
+            break;
+    }
+
+    if (receiver && *receiver) {
+        (*receiver)(channel, pdu);
+    }
+}
+
+} // namespace virtual_pal
+} // namespace ble
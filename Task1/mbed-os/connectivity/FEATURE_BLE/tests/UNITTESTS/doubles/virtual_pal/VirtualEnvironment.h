@@ -0,0 +1,139 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_VIRTUAL_ENVIRONMENT_H_
+#define BLE_VIRTUAL_PAL_VIRTUAL_ENVIRONMENT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ble/common/BLETypes.h"
+
+#include "VirtualLink.h"
+#include "VirtualPeer.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Everything outside the local host: simulated clock, radio link, remote
+ * peer and background advertisers.
+ *
+ * The virtual PAL implementations are bound to the unique environment, as
+ * the generic BLE layer they serve is reached through BLE::Instance().
+ */
+class VirtualEnvironment {
+public:
+    /**
+     * Commands received by the virtual controller from the local host.
+     */
+    struct ControllerStatistics {
+        uint32_t advertising_data = 0;
+        uint32_t scan_response_data = 0;
+        uint32_t periodic_advertising_data = 0;
+        /* extended and periodic data commands carrying a whole payload */
+        uint32_t complete_fragments = 0;
+        /* extended and periodic data commands carrying part of a payload */
+        uint32_t partial_fragments = 0;
+        uint32_t advertising_enables = 0;
+        uint32_t advertising_disables = 0;
+    };
+
+    static VirtualEnvironment &instance();
+
+    VirtualEnvironment(const VirtualEnvironment&) = delete;
+    VirtualEnvironment& operator=(const VirtualEnvironment&) = delete;
+
+    /**
+     * Drop pending events, reset the clock and apply a new link
+     * configuration. Must be called while the local device is not connected.
+     */
+    void reset(const LinkConfiguration &configuration = LinkConfiguration());
+
+    Simulator &simulator()
+    {
+        return _simulator;
+    }
+
+    VirtualLink &link()
+    {
+        return _link;
+    }
+
+    VirtualPeer &peer()
+    {
+        return _peer;
+    }
+
+    /** Public address of the local device. */
+    const address_t &local_address() const
+    {
+        return _local_address;
+    }
+
+    /**
+     * Surround the local device with non connectable advertisers.
+     *
+     * @param count Number of advertisers.
+     * @param interval Advertising interval of each of them, in units of 0.625ms.
+     */
+    void set_background_advertisers(uint16_t count, uint16_t interval)
+    {
+        _background_advertisers = count;
+        _background_advertising_interval = interval;
+    }
+
+    uint16_t background_advertisers() const
+    {
+        return _background_advertisers;
+    }
+
+    uint16_t background_advertising_interval() const
+    {
+        return _background_advertising_interval;
+    }
+
+    ControllerStatistics &controller_statistics()
+    {
+        return _controller_statistics;
+    }
+
+    /** Register the local handler of the SDUs received on a channel. */
+    void set_local_receiver(channel_t channel, VirtualLink::sdu_handler_t handler);
+
+private:
+    VirtualEnvironment();
+
+    void dispatch(channel_t channel, const std::vector<uint8_t> &pdu);
+
+    Simulator _simulator;
+    VirtualLink _link;
+    VirtualPeer _peer;
+    address_t _local_address;
+    uint16_t _background_advertisers = 0;
+    uint16_t _background_advertising_interval = 160;
+    ControllerStatistics _controller_statistics;
+
+    VirtualLink::sdu_handler_t _ll_control_receiver;
+    VirtualLink::sdu_handler_t _att_receiver;
+    VirtualLink::sdu_handler_t _smp_receiver;
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_VIRTUAL_ENVIRONMENT_H_ */
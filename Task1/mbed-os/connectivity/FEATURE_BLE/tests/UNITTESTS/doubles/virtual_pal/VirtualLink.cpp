@@ -0,0 +1,300 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "VirtualLink.h"
+
+namespace ble {
+namespace virtual_pal {
+
+namespace {
+/* inter frame space */
+constexpr sim_time_t T_IFS = 150us;
+/* size of the L2CAP basic header */
+constexpr size_t L2CAP_HEADER_SIZE = 4;
+/* default and minimum LL payload size */
+constexpr uint16_t MIN_TX_OCTETS = 27;
+/* unit of the connection interval */
+constexpr sim_time_t CONNECTION_INTERVAL_UNIT = 1250us;
+}
+
+void Simulator::post_at(sim_time_t date, event_t event)
+{
+    _events.push({ std::max(date, _now), _sequence++, std::move(event) });
+}
+
+bool Simulator::run_next(sim_time_t deadline)
+{
+    if (_events.empty() || _events.top().date > deadline) {
+        return false;
+    }
+
+    scheduled_event_t next = _events.top();
+    _events.pop();
+    _now = next.date;
+    next.event();
+    return true;
+}
+
+size_t Simulator::run_for(sim_time_t duration)
+{
+    const sim_time_t deadline = _now + duration;
+    size_t count = 0;
+    while (run_next(deadline)) {
+        ++count;
+    }
+    _now = deadline;
+    return count;
+}
+
+bool Simulator::run_until(const std::function<bool()> &condition, sim_time_t timeout)
+{
+    const sim_time_t deadline = _now + timeout;
+    while (!condition()) {
+        if (!run_next(deadline)) {
+            _now = deadline;
+            return condition();
+        }
+    }
+    return true;
+}
+
+void Simulator::reset()
+{
+    _events = decltype(_events)();
+    _now = 0us;
+    _sequence = 0;
+}
+
+VirtualLink::VirtualLink(Simulator &simulator, const LinkConfiguration &configuration) :
+    _simulator(simulator),
+    _configuration(configuration),
+    _random(configuration.seed)
+{
+}
+
+void VirtualLink::configure(const LinkConfiguration &configuration)
+{
+    close();
+    _configuration = configuration;
+    _random.seed(configuration.seed);
+}
+
+void VirtualLink::open(connection_handle_t handle, sim_time_t first_event)
+{
+    close();
+    _open = true;
+    _handle = handle;
+    _interval = _configuration.connection_interval;
+    _latency = _configuration.peripheral_latency;
+    _tx_octets = MIN_TX_OCTETS;
+    _phy_2m = false;
+    _skipped = 0;
+    schedule_connection_event(first_event);
+}
+
+void VirtualLink::close()
+{
+    _open = false;
+    ++_generation;
+    _update = { 0, 0, 0, nullptr };
+    _queues[TO_PEER].clear();
+    _queues[TO_LOCAL].clear();
+}
+
+void VirtualLink::set_receiver(direction_t direction, sdu_handler_t handler)
+{
+    _receivers[direction] = std::move(handler);
+}
+
+bool VirtualLink::send(
+    direction_t direction,
+    channel_t channel,
+    std::vector<uint8_t> payload,
+    sent_handler_t on_sent
+)
+{
+    if (!_open) {
+        return false;
+    }
+    _queues[direction].push_back({ channel, std::move(payload), std::move(on_sent), 0 });
+    return true;
+}
+
+void VirtualLink::set_connection_parameters(uint16_t interval, uint16_t latency)
+{
+    _interval = interval;
+    _latency = latency;
+}
+
+void VirtualLink::update_connection_parameters(
+    uint16_t interval,
+    uint16_t latency,
+    uint16_t instant,
+    std::function<void()> on_instant
+)
+{
+    _update = { interval, latency, std::max<uint16_t>(instant, 1), std::move(on_instant) };
+}
+
+void VirtualLink::set_tx_octets(uint16_t tx_octets)
+{
+    _tx_octets = std::max(MIN_TX_OCTETS, std::min(tx_octets, _configuration.max_tx_octets));
+}
+
+uint32_t VirtualLink::random(uint32_t bound)
+{
+    if (bound == 0) {
+        return 0;
+    }
+    return _random() % bound;
+}
+
+void VirtualLink::schedule_connection_event(sim_time_t delay)
+{
+    const uint32_t generation = _generation;
+    _next_event = _simulator.now() + delay;
+    _simulator.post_at(
+        _next_event,
+        [this, generation]() { connection_event(generation); }
+    );
+}
+
+void VirtualLink::connection_event(uint32_t generation)
+{
+    if (!_open || generation != _generation) {
+        return;
+    }
+
+    ++_statistics.connection_events;
+
+    /* the event of the instant already runs with the new parameters */
+    if (_update.events && --_update.events == 0) {
+        _interval = _update.interval;
+        _latency = _update.latency;
+        _simulator.post(std::move(_update.on_instant));
+        _update.on_instant = nullptr;
+    }
+
+    /* an idle peripheral only listens once every latency + 1 events */
+    if (_queues[TO_LOCAL].empty() && _skipped < _latency) {
+        ++_skipped;
+        ++_statistics.skipped_events;
+        schedule_connection_event(_interval * CONNECTION_INTERVAL_UNIT);
+        return;
+    }
+    _skipped = 0;
+
+    const sim_time_t budget = std::chrono::microseconds(_configuration.max_event_length);
+    sim_time_t elapsed = 0us;
+
+    while (true) {
+        uint16_t central_length = next_pdu_length(TO_PEER);
+        uint16_t peripheral_length = next_pdu_length(TO_LOCAL);
+
+        sim_time_t exchange = air_time(central_length) + T_IFS + air_time(peripheral_length) + T_IFS;
+        if (elapsed > 0us && elapsed + exchange > budget) {
+            break;
+        }
+        elapsed += exchange;
+
+        /* the peripheral does not answer a PDU it did not receive */
+        if (lost()) {
+            if (central_length) {
+                ++_statistics.retransmissions[TO_PEER];
+            }
+            break;
+        }
+        if (central_length) {
+            acknowledge(TO_PEER, central_length, elapsed);
+        }
+
+        if (lost()) {
+            if (peripheral_length) {
+                ++_statistics.retransmissions[TO_LOCAL];
+            }
+            break;
+        }
+        if (peripheral_length) {
+            acknowledge(TO_LOCAL, peripheral_length, elapsed);
+        }
+
+        /* no more data in either direction closes the event */
+        if (!next_pdu_length(TO_PEER) && !next_pdu_length(TO_LOCAL)) {
+            break;
+        }
+    }
+
+    schedule_connection_event(_interval * CONNECTION_INTERVAL_UNIT);
+}
+
+uint16_t VirtualLink::next_pdu_length(direction_t direction) const
+{
+    if (_queues[direction].empty()) {
+        return 0;
+    }
+    const sdu_t &sdu = _queues[direction].front();
+    size_t remaining = sdu.payload.size() + L2CAP_HEADER_SIZE - sdu.acked;
+    return (uint16_t) std::min<size_t>(remaining, _tx_octets);
+}
+
+void VirtualLink::acknowledge(direction_t direction, uint16_t length, sim_time_t offset)
+{
+    sdu_t &sdu = _queues[direction].front();
+    sdu.acked += length;
+    ++_statistics.pdus[direction];
+    _statistics.bytes[direction] += length;
+
+    if (sdu.acked < sdu.payload.size() + L2CAP_HEADER_SIZE) {
+        return;
+    }
+
+    ++_statistics.sdus[direction];
+    sdu_t complete = std::move(sdu);
+    _queues[direction].pop_front();
+
+    const uint32_t generation = _generation;
+    _simulator.post_in(offset, [this, direction, generation, complete]() {
+        if (generation != _generation) {
+            return;
+        }
+        if (_receivers[direction]) {
+            _receivers[direction](complete.channel, complete.payload);
+        }
+        if (complete.on_sent) {
+            complete.on_sent();
+        }
+    });
+}
+
+sim_time_t VirtualLink::air_time(uint16_t payload_length) const
+{
+    /* preamble, access address, header, payload and CRC */
+    if (_phy_2m) {
+        return std::chrono::microseconds((2 + 4 + 2 + payload_length + 3) * 4);
+    }
+    return std::chrono::microseconds((1 + 4 + 2 + payload_length + 3) * 8);
+}
+
+bool VirtualLink::lost()
+{
+    return _configuration.loss_per_mille && (random(1000) < _configuration.loss_per_mille);
+}
+
+} // namespace virtual_pal
+} // namespace ble
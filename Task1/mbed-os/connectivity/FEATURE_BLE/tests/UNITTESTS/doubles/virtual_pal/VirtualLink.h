@@ -0,0 +1,373 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_VIRTUAL_LINK_H_
+#define BLE_VIRTUAL_PAL_VIRTUAL_LINK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "ble/common/BLETypes.h"
+
+namespace ble {
+namespace virtual_pal {
+
+using namespace std::chrono_literals;
+
+/** Simulated time, elapsed since the simulator was reset. */
+using sim_time_t = std::chrono::microseconds;
+
+/**
+ * Discrete event scheduler driving the virtual PAL.
+ *
+ * Nothing happens on its own: every controller activity (advertising event,
+ * connection event, response of the peer) is an event posted at a simulated
+ * date. Events are run in date order, events posted for the same date are run
+ * in the order they were posted.
+ */
+class Simulator {
+public:
+    using event_t = std::function<void()>;
+
+    Simulator() = default;
+    Simulator(const Simulator&) = delete;
+    Simulator& operator=(const Simulator&) = delete;
+
+    /** Current simulated time. */
+    sim_time_t now() const
+    {
+        return _now;
+    }
+
+    /** Run event as soon as possible, after events already due. */
+    void post(event_t event)
+    {
+        post_at(_now, std::move(event));
+    }
+
+    /** Run event once delay has elapsed. */
+    void post_in(sim_time_t delay, event_t event)
+    {
+        post_at(_now + delay, std::move(event));
+    }
+
+    /** Run event at an absolute date; dates in the past run immediately. */
+    void post_at(sim_time_t date, event_t event);
+
+    /**
+     * Run all the events due before now() + duration. The clock is left at
+     * the end of the period.
+     *
+     * @return Number of events run.
+     */
+    size_t run_for(sim_time_t duration);
+
+    /**
+     * Run events until condition becomes true or timeout elapses.
+     *
+     * @return true if the condition was met.
+     */
+    bool run_until(const std::function<bool()> &condition, sim_time_t timeout);
+
+    /** Drop pending events and reset the clock to 0. */
+    void reset();
+
+    /** Number of events not yet run. */
+    size_t pending() const
+    {
+        return _events.size();
+    }
+
+private:
+    struct scheduled_event_t {
+        sim_time_t date;
+        uint64_t sequence;
+        event_t event;
+    };
+
+    struct later_first {
+        bool operator()(const scheduled_event_t &lhs, const scheduled_event_t &rhs) const
+        {
+            if (lhs.date != rhs.date) {
+                return lhs.date > rhs.date;
+            }
+            return lhs.sequence > rhs.sequence;
+        }
+    };
+
+    bool run_next(sim_time_t deadline);
+
+    std::priority_queue<scheduled_event_t, std::vector<scheduled_event_t>, later_first> _events;
+    sim_time_t _now = 0us;
+    uint64_t _sequence = 0;
+};
+
+/** Fixed L2CAP channels carried over the virtual link. */
+enum class channel_t : uint16_t {
+    /** Link layer control procedures; not an L2CAP channel. */
+    LL_CONTROL = 0x0000,
+    ATT = 0x0004,
+    SMP = 0x0006
+};
+
+/**
+ * Parameters of the simulated radio link.
+ */
+struct LinkConfiguration {
+    /** Connection interval selected by the controller, in units of 1.25ms. */
+    uint16_t connection_interval = 24;
+
+    /** Number of connection events the peripheral may skip when idle. */
+    uint16_t peripheral_latency = 0;
+
+    /** Supervision timeout, in units of 10ms. */
+    uint16_t supervision_timeout = 400;
+
+    /** Maximum length of a connection event in microseconds. */
+    uint32_t max_event_length = 7500;
+
+    /** Probability, in parts per thousand, that a link layer PDU is lost. */
+    uint16_t loss_per_mille = 0;
+
+    /** Largest link layer payload accepted after a data length update. */
+    uint16_t max_tx_octets = 251;
+
+    /** ACL buffers of the local controller, bounds queued write commands. */
+    uint8_t controller_buffers = 8;
+
+    /** Receive ATT MTU of the peer. */
+    uint16_t peer_att_mtu = 247;
+
+    /** Advertising interval of the peer, in units of 0.625ms. */
+    uint16_t advertising_interval = 160;
+
+    /** Whether the controller reports the timing of connection events. */
+    bool connection_event_notification = true;
+
+    /** Seed of the pseudo random generator used for losses and jitter. */
+    uint32_t seed = 1;
+};
+
+/**
+ * Counters of a virtual link.
+ */
+struct LinkStatistics {
+    uint32_t connection_events = 0;
+    uint32_t skipped_events = 0;
+    uint32_t pdus[2] = { 0, 0 };
+    uint32_t retransmissions[2] = { 0, 0 };
+    uint32_t sdus[2] = { 0, 0 };
+    uint64_t bytes[2] = { 0, 0 };
+};
+
+/**
+ * Simulated ACL connection between the local device (central) and a peer
+ * (peripheral).
+ *
+ * L2CAP SDUs queued in each direction are fragmented into link layer PDUs of
+ * at most tx_octets bytes and exchanged at each connection event, as long as
+ * the air time of the event permits. A lost PDU closes the connection event
+ * and is sent again at the next one.
+ */
+class VirtualLink {
+public:
+    enum direction_t {
+        /** From the local device to the peer. */
+        TO_PEER = 0,
+        /** From the peer to the local device. */
+        TO_LOCAL = 1
+    };
+
+    using sdu_handler_t = std::function<void(channel_t, const std::vector<uint8_t>&)>;
+    using sent_handler_t = std::function<void()>;
+
+    VirtualLink(Simulator &simulator, const LinkConfiguration &configuration);
+    VirtualLink(const VirtualLink&) = delete;
+    VirtualLink& operator=(const VirtualLink&) = delete;
+
+    /** Replace the configuration; must be called while the link is closed. */
+    void configure(const LinkConfiguration &configuration);
+
+    const LinkConfiguration &configuration() const
+    {
+        return _configuration;
+    }
+
+    /**
+     * Start connection events for a new connection.
+     *
+     * @param first_event Delay of the first connection event.
+     */
+    void open(connection_handle_t handle, sim_time_t first_event);
+
+    /** Stop connection events and drop queued SDUs. */
+    void close();
+
+    bool is_open() const
+    {
+        return _open;
+    }
+
+    connection_handle_t handle() const
+    {
+        return _handle;
+    }
+
+    /** Register the handler of SDUs delivered in a direction. */
+    void set_receiver(direction_t direction, sdu_handler_t handler);
+
+    /**
+     * Queue an SDU.
+     *
+     * @param on_sent Invoked when the last fragment has been acknowledged.
+     *
+     * @return false if the link is closed.
+     */
+    bool send(
+        direction_t direction,
+        channel_t channel,
+        std::vector<uint8_t> payload,
+        sent_handler_t on_sent = nullptr
+    );
+
+    /** Number of SDUs not yet fully acknowledged in a direction. */
+    size_t pending(direction_t direction) const
+    {
+        return _queues[direction].size();
+    }
+
+    uint16_t connection_interval() const
+    {
+        return _interval;
+    }
+
+    uint16_t peripheral_latency() const
+    {
+        return _latency;
+    }
+
+    void set_connection_parameters(uint16_t interval, uint16_t latency);
+
+    /**
+     * Switch to new connection parameters at a connection event instant.
+     *
+     * @param instant Number of connection events before the switch.
+     * @param on_instant Invoked once the connection event of the instant,
+     * the first one using the new parameters, is over.
+     */
+    void update_connection_parameters(
+        uint16_t interval,
+        uint16_t latency,
+        uint16_t instant,
+        std::function<void()> on_instant
+    );
+
+    /** Date of the anchor point of the next connection event. */
+    sim_time_t next_connection_event() const
+    {
+        return _next_event;
+    }
+
+    uint16_t tx_octets() const
+    {
+        return _tx_octets;
+    }
+
+    void set_tx_octets(uint16_t tx_octets);
+
+    bool is_2m_phy() const
+    {
+        return _phy_2m;
+    }
+
+    void set_2m_phy(bool enabled)
+    {
+        _phy_2m = enabled;
+    }
+
+    /** Draw a random number in [0, bound). */
+    uint32_t random(uint32_t bound);
+
+    const LinkStatistics &statistics() const
+    {
+        return _statistics;
+    }
+
+    void reset_statistics()
+    {
+        _statistics = LinkStatistics();
+    }
+
+private:
+    struct sdu_t {
+        channel_t channel;
+        std::vector<uint8_t> payload;
+        sent_handler_t on_sent;
+        /* octets of the L2CAP frame (header included) acknowledged */
+        size_t acked;
+    };
+
+    void schedule_connection_event(sim_time_t delay);
+
+    void connection_event(uint32_t generation);
+
+    /* length of the next PDU in a direction, 0 if nothing to send */
+    uint16_t next_pdu_length(direction_t direction) const;
+
+    /* account a PDU that has been received by the other side */
+    void acknowledge(direction_t direction, uint16_t length, sim_time_t offset);
+
+    sim_time_t air_time(uint16_t payload_length) const;
+
+    bool lost();
+
+    Simulator &_simulator;
+    LinkConfiguration _configuration;
+    std::minstd_rand _random;
+
+    bool _open = false;
+    connection_handle_t _handle = 0;
+    uint32_t _generation = 0;
+    uint16_t _interval = 0;
+    uint16_t _latency = 0;
+    uint16_t _tx_octets = 27;
+    bool _phy_2m = false;
+    uint16_t _skipped = 0;
+    sim_time_t _next_event = 0us;
+
+    struct parameters_update_t {
+        uint16_t interval;
+        uint16_t latency;
+        /* connection events left before the instant, 0 if no update pending */
+        uint16_t events;
+        std::function<void()> on_instant;
+    } _update = { 0, 0, 0, nullptr };
+
+    std::deque<sdu_t> _queues[2];
+    sdu_handler_t _receivers[2];
+    LinkStatistics _statistics;
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_VIRTUAL_LINK_H_ */
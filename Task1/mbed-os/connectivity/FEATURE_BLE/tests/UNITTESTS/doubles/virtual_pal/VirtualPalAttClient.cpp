@@ -0,0 +1,473 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "source/pal/PalSimpleAttServerMessage.h"
+
+#include "VirtualBLEInstanceBase.h"
+#include "VirtualPalAttClient.h"
+#include "VirtualProtocol.h"
+
+namespace ble {
+namespace virtual_pal {
+
+namespace {
+/* default ATT MTU of LE links */
+constexpr uint16_t DEFAULT_MTU = 23;
+/* an ATT transaction not completed within 30 seconds has failed */
+constexpr sim_time_t TRANSACTION_TIMEOUT = 30s;
+}
+
+VirtualPalAttClient::VirtualPalAttClient(VirtualEnvironment &environment) :
+    _environment(environment),
+    _mtu_connection(0),
+    _mtu(DEFAULT_MTU),
+    _transaction(0),
+    _transaction_pending(false)
+{
+}
+
+ble_error_t VirtualPalAttClient::initialize()
+{
+    _environment.set_local_receiver(
+        channel_t::ATT,
+        [this](channel_t, const std::vector<uint8_t> &pdu) { on_pdu(pdu); }
+    );
+    _mtu_connection = 0;
+    _mtu = DEFAULT_MTU;
+    ++_transaction;
+    _transaction_pending = false;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalAttClient::terminate()
+{
+    _environment.set_local_receiver(channel_t::ATT, nullptr);
+    ++_transaction;
+    _transaction_pending = false;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalAttClient::exchange_mtu_request(connection_handle_t connection)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::EXCHANGE_MTU_REQUEST };
+    put_u16(pdu, LOCAL_MTU);
+    return send_request(connection, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::get_mtu_size(
+    connection_handle_t connection_handle,
+    uint16_t &mtu_size
+)
+{
+    if (!is_connected(connection_handle)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    mtu_size = (connection_handle == _mtu_connection) ? _mtu : DEFAULT_MTU;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalAttClient::find_information_request(
+    connection_handle_t connection_handle,
+    attribute_handle_range_t discovery_range
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::FIND_INFORMATION_REQUEST };
+    put_u16(pdu, discovery_range.begin);
+    put_u16(pdu, discovery_range.end);
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::find_by_type_value_request(
+    connection_handle_t connection_handle,
+    attribute_handle_range_t discovery_range,
+    uint16_t type,
+    const Span<const uint8_t> &value
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::FIND_BY_TYPE_VALUE_REQUEST };
+    put_u16(pdu, discovery_range.begin);
+    put_u16(pdu, discovery_range.end);
+    put_u16(pdu, type);
+    pdu.insert(pdu.end(), value.data(), value.data() + value.size());
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::read_by_type_request(
+    connection_handle_t connection_handle,
+    attribute_handle_range_t read_range,
+    const UUID &type
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::READ_BY_TYPE_REQUEST };
+    put_u16(pdu, read_range.begin);
+    put_u16(pdu, read_range.end);
+    put_uuid(pdu, type);
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::read_request(
+    connection_handle_t connection_handle,
+    attribute_handle_t attribute_handle
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::READ_REQUEST };
+    put_u16(pdu, attribute_handle);
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::read_blob_request(
+    connection_handle_t connection_handle,
+    attribute_handle_t attribute_handle,
+    uint16_t offset
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::READ_BLOB_REQUEST };
+    put_u16(pdu, attribute_handle);
+    put_u16(pdu, offset);
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::read_multiple_request(
+    connection_handle_t connection_handle,
+    const Span<const attribute_handle_t> &attribute_handles
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::READ_MULTIPLE_REQUEST };
+    for (attribute_handle_t handle : attribute_handles) {
+        put_u16(pdu, handle);
+    }
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::read_by_group_type_request(
+    connection_handle_t connection_handle,
+    attribute_handle_range_t read_range,
+    const UUID &group_type
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::READ_BY_GROUP_TYPE_REQUEST };
+    put_u16(pdu, read_range.begin);
+    put_u16(pdu, read_range.end);
+    put_uuid(pdu, group_type);
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::write_request(
+    connection_handle_t connection_handle,
+    attribute_handle_t attribute_handle,
+    const Span<const uint8_t> &value
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::WRITE_REQUEST };
+    put_u16(pdu, attribute_handle);
+    pdu.insert(pdu.end(), value.data(), value.data() + value.size());
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::write_command(
+    connection_handle_t connection_handle,
+    attribute_handle_t attribute_handle,
+    const Span<const uint8_t> &value
+)
+{
+    if (!is_connected(connection_handle)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    VirtualLink &link = _environment.link();
+    if (link.pending(VirtualLink::TO_PEER) >= link.configuration().controller_buffers) {
+        return BLE_ERROR_NO_MEM;
+    }
+
+    std::vector<uint8_t> pdu { AttributeOpcode::WRITE_COMMAND };
+    put_u16(pdu, attribute_handle);
+    pdu.insert(pdu.end(), value.data(), value.data() + value.size());
+
+    link.send(
+        VirtualLink::TO_PEER,
+        channel_t::ATT,
+        std::move(pdu),
+        [connection_handle, attribute_handle]() {
+            ble::impl::BLEInstanceBase &ble = impl::BLEInstanceBase::deviceInstance();
+            PalGattClientEventHandler *handler = ble.getPalGattClient().get_event_handler();
+            if (handler) {
+                handler->on_write_command_sent(connection_handle, attribute_handle, 0);
+            }
+        }
+    );
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalAttClient::signed_write_command(
+    connection_handle_t connection_handle,
+    attribute_handle_t attribute_handle,
+    const Span<const uint8_t> &value
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalAttClient::prepare_write_request(
+    connection_handle_t connection_handle,
+    attribute_handle_t attribute_handle,
+    uint16_t offset,
+    const Span<const uint8_t> &value
+)
+{
+    std::vector<uint8_t> pdu { AttributeOpcode::PREPARE_WRITE_REQUEST };
+    put_u16(pdu, attribute_handle);
+    put_u16(pdu, offset);
+    pdu.insert(pdu.end(), value.data(), value.data() + value.size());
+    return send_request(connection_handle, std::move(pdu));
+}
+
+ble_error_t VirtualPalAttClient::execute_write_request(
+    connection_handle_t connection_handle,
+    bool execute
+)
+{
+    return send_request(
+        connection_handle,
+        { AttributeOpcode::EXECUTE_WRITE_REQUEST, (uint8_t) (execute ? 0x01 : 0x00) }
+    );
+}
+
+void VirtualPalAttClient::when_server_message_received(
+    mbed::Callback<void(connection_handle_t, const AttServerMessage &)> cb
+)
+{
+    _server_message_cb = cb;
+}
+
+void VirtualPalAttClient::when_transaction_timeout(
+    mbed::Callback<void(connection_handle_t)> cb
+)
+{
+    _transaction_timeout_cb = cb;
+}
+
+ble_error_t VirtualPalAttClient::send_request(
+    connection_handle_t connection,
+    std::vector<uint8_t> pdu
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    /* a client can only have one request outstanding */
+    if (_transaction_pending) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    if (connection != _mtu_connection) {
+        _mtu_connection = connection;
+        _mtu = DEFAULT_MTU;
+    }
+
+    if (pdu.size() > _mtu) {
+        return BLE_ERROR_PARAM_OUT_OF_RANGE;
+    }
+
+    _environment.link().send(VirtualLink::TO_PEER, channel_t::ATT, std::move(pdu));
+
+    _transaction_pending = true;
+    const uint32_t transaction = ++_transaction;
+    _environment.simulator().post_in(TRANSACTION_TIMEOUT, [this, connection, transaction]() {
+        on_transaction_timeout(connection, transaction);
+    });
+
+    return BLE_ERROR_NONE;
+}
+
+void VirtualPalAttClient::on_transaction_timeout(connection_handle_t connection, uint32_t transaction)
+{
+    if (!_transaction_pending || transaction != _transaction) {
+        return;
+    }
+    _transaction_pending = false;
+    if (_transaction_timeout_cb) {
+        _transaction_timeout_cb(connection);
+    }
+}
+
+void VirtualPalAttClient::on_pdu(const std::vector<uint8_t> &pdu)
+{
+    if (pdu.empty()) {
+        return;
+    }
+
+    const connection_handle_t connection = _environment.link().handle();
+    const uint8_t *data = pdu.data();
+    const size_t size = pdu.size();
+
+    switch (data[0]) {
+        case AttributeOpcode::HANDLE_VALUE_NOTIFICATION:
+            if (size >= 3 && _server_message_cb) {
+                _server_message_cb(
+                    connection,
+                    AttHandleValueNotification(get_u16(data + 1), make_const_Span(data + 3, size - 3))
+                );
+            }
+            return;
+
+        case AttributeOpcode::HANDLE_VALUE_INDICATION:
+            if (size >= 3 && _server_message_cb) {
+                _server_message_cb(
+                    connection,
+                    AttHandleValueIndication(get_u16(data + 1), make_const_Span(data + 3, size - 3))
+                );
+            }
+            return;
+
+        default:
+            /* any other PDU completes the pending transaction */
+            if (!_transaction_pending) {
+                return;
+            }
+            _transaction_pending = false;
+            ++_transaction;
+            on_response(connection, pdu);
+            return;
+    }
+}
+
+void VirtualPalAttClient::on_response(connection_handle_t connection, const std::vector<uint8_t> &pdu)
+{
+    const uint8_t *data = pdu.data();
+    const size_t size = pdu.size();
+
+    if (!_server_message_cb) {
+        return;
+    }
+
+    switch (data[0]) {
+        case AttributeOpcode::ERROR_RESPONSE:
+            if (size == 5) {
+                _server_message_cb(
+                    connection,
+                    AttErrorResponse(
+                        static_cast<AttributeOpcode::Code>(data[1]),
+                        get_u16(data + 2),
+                        data[4]
+                    )
+                );
+            }
+            return;
+
+        case AttributeOpcode::EXCHANGE_MTU_RESPONSE: {
+            if (size != 3) {
+                return;
+            }
+            uint16_t server_mtu = get_u16(data + 1);
+            _mtu_connection = connection;
+            _mtu = std::max(DEFAULT_MTU, std::min(server_mtu, LOCAL_MTU));
+            _server_message_cb(connection, AttExchangeMTUResponse(server_mtu));
+
+            ble::impl::BLEInstanceBase &ble = impl::BLEInstanceBase::deviceInstance();
+            PalGattClientEventHandler *handler = ble.getPalGattClient().get_event_handler();
+            if (handler) {
+                handler->on_att_mtu_change(connection, _mtu);
+            }
+            return;
+        }
+
+        case AttributeOpcode::FIND_INFORMATION_RESPONSE:
+            if (size >= 2) {
+                _server_message_cb(
+                    connection,
+                    PalSimpleAttFindInformationResponse(
+                        static_cast<PalSimpleAttFindInformationResponse::Format>(data[1]),
+                        make_const_Span(data + 2, size - 2)
+                    )
+                );
+            }
+            return;
+
+        case AttributeOpcode::FIND_BY_VALUE_TYPE_RESPONSE:
+            _server_message_cb(
+                connection,
+                PalSimpleAttFindByTypeValueResponse(make_const_Span(data + 1, size - 1))
+            );
+            return;
+
+        case AttributeOpcode::READ_BY_TYPE_RESPONSE:
+            if (size >= 2) {
+                _server_message_cb(
+                    connection,
+                    PalSimpleAttReadByTypeResponse(data[1], make_const_Span(data + 2, size - 2))
+                );
+            }
+            return;
+
+        case AttributeOpcode::READ_RESPONSE:
+            _server_message_cb(connection, AttReadResponse(make_const_Span(data + 1, size - 1)));
+            return;
+
+        case AttributeOpcode::READ_BLOB_RESPONSE:
+            _server_message_cb(connection, AttReadBlobResponse(make_const_Span(data + 1, size - 1)));
+            return;
+
+        case AttributeOpcode::READ_MULTIPLE_RESPONSE:
+            _server_message_cb(connection, AttReadMultipleResponse(make_const_Span(data + 1, size - 1)));
+            return;
+
+        case AttributeOpcode::READ_BY_GROUP_TYPE_RESPONSE:
+            if (size >= 2) {
+                _server_message_cb(
+                    connection,
+                    PalSimpleAttReadByGroupTypeResponse(data[1], make_const_Span(data + 2, size - 2))
+                );
+            }
+            return;
+
+        case AttributeOpcode::WRITE_RESPONSE:
+            _server_message_cb(connection, AttWriteResponse());
+            return;
+
+        case AttributeOpcode::PREPARE_WRITE_RESPONSE:
+            if (size >= 5) {
+                _server_message_cb(
+                    connection,
+                    AttPrepareWriteResponse(
+                        get_u16(data + 1),
+                        get_u16(data + 3),
+                        make_const_Span(data + 5, size - 5)
+                    )
+                );
+            }
+            return;
+
+        case AttributeOpcode::EXECUTE_WRITE_RESPONSE:
+            _server_message_cb(connection, AttExecuteWriteResponse());
+            return;
+
+        default:
+            return;
+    }
+}
+
+bool VirtualPalAttClient::is_connected(connection_handle_t connection) const
+{
+    return _environment.link().is_open() && _environment.link().handle() == connection;
+}
+
+} // namespace virtual_pal
+} // namespace ble
@@ -0,0 +1,159 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_ATT_CLIENT_H_
+#define BLE_VIRTUAL_PAL_ATT_CLIENT_H_
+
+#include <vector>
+
+#include "source/pal/PalAttClient.h"
+
+#include "VirtualEnvironment.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Implementation of ble::PalAttClient on top of the virtual environment.
+ *
+ * Requests are encoded as ATT PDUs and sent to the peer over the virtual
+ * link; responses are decoded with the simple server messages of the PAL.
+ * Write commands are accepted as long as the controller has free buffers,
+ * their completion is reported once the peer has acknowledged them.
+ */
+class VirtualPalAttClient final : public ble::PalAttClient {
+public:
+    /** ATT MTU the local device can receive. */
+    static const uint16_t LOCAL_MTU = 247;
+
+    explicit VirtualPalAttClient(VirtualEnvironment &environment);
+
+    ble_error_t initialize() final;
+
+    ble_error_t terminate() final;
+
+    ble_error_t exchange_mtu_request(connection_handle_t connection) final;
+
+    ble_error_t get_mtu_size(
+        connection_handle_t connection_handle,
+        uint16_t &mtu_size
+    ) final;
+
+    ble_error_t find_information_request(
+        connection_handle_t connection_handle,
+        attribute_handle_range_t discovery_range
+    ) final;
+
+    ble_error_t find_by_type_value_request(
+        connection_handle_t connection_handle,
+        attribute_handle_range_t discovery_range,
+        uint16_t type,
+        const Span<const uint8_t> &value
+    ) final;
+
+    ble_error_t read_by_type_request(
+        connection_handle_t connection_handle,
+        attribute_handle_range_t read_range,
+        const UUID &type
+    ) final;
+
+    ble_error_t read_request(
+        connection_handle_t connection_handle,
+        attribute_handle_t attribute_handle
+    ) final;
+
+    ble_error_t read_blob_request(
+        connection_handle_t connection_handle,
+        attribute_handle_t attribute_handle,
+        uint16_t offset
+    ) final;
+
+    ble_error_t read_multiple_request(
+        connection_handle_t connection_handle,
+        const Span<const attribute_handle_t> &attribute_handles
+    ) final;
+
+    ble_error_t read_by_group_type_request(
+        connection_handle_t connection_handle,
+        attribute_handle_range_t read_range,
+        const UUID &group_type
+    ) final;
+
+    ble_error_t write_request(
+        connection_handle_t connection_handle,
+        attribute_handle_t attribute_handle,
+        const Span<const uint8_t> &value
+    ) final;
+
+    ble_error_t write_command(
+        connection_handle_t connection_handle,
+        attribute_handle_t attribute_handle,
+        const Span<const uint8_t> &value
+    ) final;
+
+    ble_error_t signed_write_command(
+        connection_handle_t connection_handle,
+        attribute_handle_t attribute_handle,
+        const Span<const uint8_t> &value
+    ) final;
+
+    ble_error_t prepare_write_request(
+        connection_handle_t connection_handle,
+        attribute_handle_t attribute_handle,
+        uint16_t offset,
+        const Span<const uint8_t> &value
+    ) final;
+
+    ble_error_t execute_write_request(
+        connection_handle_t connection_handle,
+        bool execute
+    ) final;
+
+    void when_server_message_received(
+        mbed::Callback<void(connection_handle_t, const AttServerMessage &)> cb
+    ) final;
+
+    void when_transaction_timeout(
+        mbed::Callback<void(connection_handle_t)> cb
+    ) final;
+
+private:
+    /* send a request and arm the transaction timer */
+    ble_error_t send_request(connection_handle_t connection, std::vector<uint8_t> pdu);
+
+    void on_transaction_timeout(connection_handle_t connection, uint32_t transaction);
+
+    void on_pdu(const std::vector<uint8_t> &pdu);
+
+    void on_response(connection_handle_t connection, const std::vector<uint8_t> &pdu);
+
+    bool is_connected(connection_handle_t connection) const;
+
+    VirtualEnvironment &_environment;
+    mbed::Callback<void(connection_handle_t, const AttServerMessage &)> _server_message_cb;
+    mbed::Callback<void(connection_handle_t)> _transaction_timeout_cb;
+    /* MTU negotiated on the connection _mtu_connection */
+    connection_handle_t _mtu_connection;
+    uint16_t _mtu;
+    uint32_t _transaction;
+    bool _transaction_pending;
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_ATT_CLIENT_H_ */
@@ -0,0 +1,64 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_EVENT_QUEUE_H_
+#define BLE_VIRTUAL_PAL_EVENT_QUEUE_H_
+
+#include "source/pal/PalEventQueue.h"
+
+#include "VirtualLink.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Event queue of the generic layer, run by the simulator at the date events
+ * are posted.
+ */
+class VirtualPalEventQueue final : public PalEventQueue {
+public:
+    explicit VirtualPalEventQueue(Simulator &simulator) :
+        _simulator(simulator)
+    {
+    }
+
+    bool post(const mbed::Callback<void()> &event) final
+    {
+        const uint32_t generation = _generation;
+        _simulator.post([this, generation, event]() {
+            if (generation == _generation) {
+                mbed::Callback<void()> cb = event;
+                cb();
+            }
+        });
+        return true;
+    }
+
+    void clear() final
+    {
+        ++_generation;
+    }
+
+private:
+    Simulator &_simulator;
+    uint32_t _generation = 0;
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_EVENT_QUEUE_H_ */
@@ -0,0 +1,1033 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "VirtualPalGap.h"
+
+namespace ble {
+namespace virtual_pal {
+
+namespace {
+/* unit of the advertising interval */
+constexpr sim_time_t ADVERTISING_INTERVAL_UNIT = 625us;
+/* pseudo random delay added to each advertising event, in microseconds */
+constexpr uint32_t MAX_ADVERTISING_DELAY = 10000;
+/* unit of the connection interval */
+constexpr sim_time_t CONNECTION_INTERVAL_UNIT = 1250us;
+/* delay between the connection request and the first connection event */
+constexpr sim_time_t TRANSMIT_WINDOW_DELAY = 1250us;
+/* connection events before an update takes effect */
+constexpr uint16_t CONNECTION_UPDATE_INSTANT = 6;
+/* connection events needed to run a link layer control procedure */
+constexpr uint16_t CONTROL_PROCEDURE_EVENTS = 2;
+constexpr uint8_t WHITE_LIST_CAPACITY = 8;
+constexpr int8_t PEER_RSSI = -40;
+constexpr int8_t BACKGROUND_RSSI = -80;
+const uint8_t DEFAULT_RANDOM_ADDRESS[6] = { 0x66, 0x55, 0x44, 0x33, 0x22, 0xD1 };
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+/* limits of the extended advertising data, as reported by Cordio controllers */
+constexpr uint16_t EXTENDED_ADVERTISING_MAX_SIZE = 1650;
+constexpr uint16_t EXTENDED_CONNECTABLE_ADVERTISING_MAX_SIZE = 191;
+constexpr uint8_t EXTENDED_ADVERTISING_HCI_MAX_SIZE = 251;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+/* a single legacy advertising report */
+struct AdvertisingReport final : public GapAdvertisingReportEvent {
+    explicit AdvertisingReport(const advertising_t &advertising) :
+        _advertising(advertising)
+    {
+    }
+
+    uint8_t size() const final
+    {
+        return 1;
+    }
+
+    advertising_t operator[](uint8_t i) const final
+    {
+        return _advertising;
+    }
+
+private:
+    advertising_t _advertising;
+};
+
+/* random static address and payload of a background advertiser */
+address_t background_address(uint32_t advertiser)
+{
+    const uint8_t address[6] = {
+        (uint8_t) advertiser, (uint8_t) (advertiser >> 8), 0x00, 0x00, 0xAD, 0xC0
+    };
+    return address_t(address);
+}
+
+std::vector<uint8_t> background_payload(uint32_t advertiser)
+{
+    /* flags and short local name */
+    return {
+        0x02, 0x01, 0x06,
+        0x05, 0x08, 'a', 'd', (uint8_t) ('0' + (advertiser / 10) % 10), (uint8_t) ('0' + advertiser % 10)
+    };
+}
+}
+
+VirtualPalGap::VirtualPalGap(VirtualEnvironment &environment) :
+    _environment(environment),
+    _event_handler(nullptr),
+    _random_address(DEFAULT_RANDOM_ADDRESS)
+#if BLE_ROLE_OBSERVER
+    , _scanning(false),
+    _filter_duplicates(false),
+    _scan_generation(0)
+#endif // BLE_ROLE_OBSERVER
+#if BLE_ROLE_CENTRAL
+    , _initiating(false),
+    _initiation_generation(0),
+    _initiation_interval_min(0),
+    _initiation_interval_max(0)
+#endif // BLE_ROLE_CENTRAL
+#if BLE_FEATURE_CONNECTABLE
+    , _last_connection_handle(0),
+    _notification_lead(0),
+    _notification_generation(0)
+#endif // BLE_FEATURE_CONNECTABLE
+{
+#if BLE_FEATURE_CONNECTABLE
+    _environment.peer().when_disconnect_requested(
+        [this](uint8_t reason) { on_peer_disconnection(reason); }
+    );
+#endif // BLE_FEATURE_CONNECTABLE
+}
+
+bool VirtualPalGap::is_feature_supported(
+    ble::controller_supported_features_t feature
+)
+{
+    switch (feature.value()) {
+        case controller_supported_features_t::LE_ENCRYPTION:
+        case controller_supported_features_t::CONNECTION_PARAMETERS_REQUEST_PROCEDURE:
+        case controller_supported_features_t::LE_DATA_PACKET_LENGTH_EXTENSION:
+        case controller_supported_features_t::LE_2M_PHY:
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+        case controller_supported_features_t::LE_EXTENDED_ADVERTISING:
+#endif
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+        case controller_supported_features_t::LE_PERIODIC_ADVERTISING:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+ble_error_t VirtualPalGap::initialize()
+{
+#if BLE_ROLE_OBSERVER
+    _scanning = false;
+    ++_scan_generation;
+#endif // BLE_ROLE_OBSERVER
+#if BLE_ROLE_CENTRAL
+    _initiating = false;
+    ++_initiation_generation;
+#endif // BLE_ROLE_CENTRAL
+#if BLE_FEATURE_CONNECTABLE
+    ++_notification_generation;
+#endif // BLE_FEATURE_CONNECTABLE
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::terminate()
+{
+    return initialize();
+}
+
+address_t VirtualPalGap::get_device_address()
+{
+    return _environment.local_address();
+}
+
+address_t VirtualPalGap::get_random_address()
+{
+    return _random_address;
+}
+
+ble_error_t VirtualPalGap::set_random_address(const address_t &address)
+{
+    _random_address = address;
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_ROLE_BROADCASTER
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::set_advertising_set_random_address(
+    advertising_handle_t advertising_handle,
+    const address_t &address
+)
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+ble_error_t VirtualPalGap::set_advertising_parameters(
+    uint16_t advertising_interval_min,
+    uint16_t advertising_interval_max,
+    advertising_type_t advertising_type,
+    own_address_type_t own_address_type,
+    advertising_peer_address_type_t peer_address_type,
+    const address_t &peer_address,
+    advertising_channel_map_t advertising_channel_map,
+    advertising_filter_policy_t advertising_filter_policy
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::set_extended_advertising_parameters(
+    advertising_handle_t advertising_handle,
+    advertising_event_properties_t event_properties,
+    advertising_interval_t primary_advertising_interval_min,
+    advertising_interval_t primary_advertising_interval_max,
+    advertising_channel_map_t primary_advertising_channel_map,
+    own_address_type_t own_address_type,
+    advertising_peer_address_type_t peer_address_type,
+    const address_t &peer_address,
+    advertising_filter_policy_t advertising_filter_policy,
+    advertising_power_t advertising_power,
+    phy_t primary_advertising_phy,
+    uint8_t secondary_advertising_max_skip,
+    phy_t secondary_phy,
+    uint8_t advertising_sid,
+    bool scan_request_notification
+)
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+ble_error_t VirtualPalGap::set_periodic_advertising_parameters(
+    advertising_handle_t advertising_handle,
+    periodic_advertising_interval_t periodic_advertising_min,
+    periodic_advertising_interval_t periodic_advertising_max,
+    bool advertise_power
+)
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+
+ble_error_t VirtualPalGap::set_advertising_data(
+    uint8_t advertising_data_length,
+    const advertising_data_t &advertising_data
+)
+{
+    ++_environment.controller_statistics().advertising_data;
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::set_extended_advertising_data(
+    advertising_handle_t advertising_handle,
+    advertising_fragment_description_t operation,
+    bool minimize_fragmentation,
+    uint8_t advertising_data_size,
+    const uint8_t *advertising_data
+)
+{
+    ++_environment.controller_statistics().advertising_data;
+    count_fragment(operation);
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+ble_error_t VirtualPalGap::set_periodic_advertising_data(
+    advertising_handle_t advertising_handle,
+    advertising_fragment_description_t fragment_description,
+    uint8_t advertising_data_size,
+    const uint8_t *advertising_data
+)
+{
+    ++_environment.controller_statistics().periodic_advertising_data;
+    count_fragment(fragment_description);
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+
+ble_error_t VirtualPalGap::set_scan_response_data(
+    uint8_t scan_response_data_length,
+    const advertising_data_t &scan_response_data
+)
+{
+    ++_environment.controller_statistics().scan_response_data;
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::set_extended_scan_response_data(
+    advertising_handle_t advertising_handle,
+    advertising_fragment_description_t operation,
+    bool minimize_fragmentation,
+    uint8_t scan_response_data_size,
+    const uint8_t *scan_response_data
+)
+{
+    ++_environment.controller_statistics().scan_response_data;
+    count_fragment(operation);
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+ble_error_t VirtualPalGap::advertising_enable(bool enable)
+{
+    /* the peer never initiates connections: advertising only has to start and stop */
+    _environment.simulator().post([this, enable]() {
+        if (!_event_handler) {
+            return;
+        }
+        if (enable) {
+            _event_handler->on_legacy_advertising_started();
+        } else {
+            _event_handler->on_legacy_advertising_stopped();
+        }
+    });
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::extended_advertising_enable(
+    bool enable,
+    uint8_t number_of_sets,
+    const advertising_handle_t *handles,
+    const uint16_t *durations,
+    const uint8_t *max_extended_advertising_events
+)
+{
+    if (enable) {
+        ++_environment.controller_statistics().advertising_enables;
+    } else {
+        ++_environment.controller_statistics().advertising_disables;
+    }
+
+    /* sets only have to start and stop, as for legacy advertising */
+    std::vector<advertising_handle_t> sets(handles, handles + number_of_sets);
+    _environment.simulator().post([this, enable, sets]() {
+        if (!_event_handler) {
+            return;
+        }
+        if (enable) {
+            _event_handler->on_advertising_set_started(mbed::make_const_Span(sets.data(), sets.size()));
+        } else {
+            for (advertising_handle_t set : sets) {
+                _event_handler->on_advertising_set_terminated(
+                    hci_error_code_t::SUCCESS,
+                    set,
+                    /* no connection */ 0,
+                    0
+                );
+            }
+        }
+    });
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+ble_error_t VirtualPalGap::periodic_advertising_enable(
+    bool enable,
+    advertising_handle_t advertising_handle
+)
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+
+uint16_t VirtualPalGap::get_maximum_advertising_data_length()
+{
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    return EXTENDED_ADVERTISING_MAX_SIZE;
+#else
+    return LEGACY_ADVERTISING_MAX_SIZE;
+#endif
+}
+
+uint16_t VirtualPalGap::get_maximum_connectable_advertising_data_length()
+{
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    return EXTENDED_CONNECTABLE_ADVERTISING_MAX_SIZE;
+#else
+    return LEGACY_ADVERTISING_MAX_SIZE;
+#endif
+}
+
+uint8_t VirtualPalGap::get_maximum_hci_advertising_data_length()
+{
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    return EXTENDED_ADVERTISING_HCI_MAX_SIZE;
+#else
+    return LEGACY_ADVERTISING_MAX_SIZE;
+#endif
+}
+
+uint8_t VirtualPalGap::get_max_number_of_advertising_sets()
+{
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    return BLE_GAP_MAX_ADVERTISING_SETS;
+#else
+    return 1;
+#endif
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::remove_advertising_set(advertising_handle_t advertising_handle)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::clear_advertising_sets()
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+#endif // BLE_ROLE_BROADCASTER
+
+#if BLE_ROLE_OBSERVER
+ble_error_t VirtualPalGap::set_scan_parameters(
+    bool active_scanning,
+    uint16_t scan_interval,
+    uint16_t scan_window,
+    own_address_type_t own_address_type,
+    scanning_filter_policy_t filter_policy
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::set_extended_scan_parameters(
+    own_address_type_t own_address_type,
+    scanning_filter_policy_t filter_policy,
+    phy_set_t scanning_phys,
+    const bool *active_scanning,
+    const uint16_t *scan_interval,
+    const uint16_t *scan_window
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+ble_error_t VirtualPalGap::scan_enable(
+    bool enable,
+    bool filter_duplicates
+)
+{
+    ++_scan_generation;
+    _scanning = enable;
+
+    if (!enable) {
+        _environment.simulator().post([this]() {
+            if (_event_handler) {
+                _event_handler->on_scan_stopped(true);
+            }
+        });
+        return BLE_ERROR_NONE;
+    }
+
+    _filter_duplicates = filter_duplicates;
+    _reported.assign(_environment.background_advertisers() + 1, false);
+
+    _environment.simulator().post([this]() {
+        if (_event_handler) {
+            _event_handler->on_scan_started(true);
+        }
+    });
+
+    /* advertisers are not synchronised, the first event of each is spread over an interval */
+    VirtualLink &link = _environment.link();
+    for (uint32_t i = 0; i <= _environment.background_advertisers(); ++i) {
+        uint16_t interval = (i == _environment.background_advertisers()) ?
+            link.configuration().advertising_interval :
+            _environment.background_advertising_interval();
+        schedule_advertising_event(i, std::chrono::microseconds(link.random(interval * ADVERTISING_INTERVAL_UNIT.count())));
+    }
+
+    return BLE_ERROR_NONE;
+}
+
+void VirtualPalGap::schedule_advertising_event(uint32_t advertiser, sim_time_t delay)
+{
+    const uint32_t generation = _scan_generation;
+    _environment.simulator().post_in(delay, [this, advertiser, generation]() {
+        on_advertising_event(advertiser, generation);
+    });
+}
+
+void VirtualPalGap::on_advertising_event(uint32_t advertiser, uint32_t generation)
+{
+    if (!_scanning || generation != _scan_generation) {
+        return;
+    }
+
+    VirtualLink &link = _environment.link();
+    VirtualPeer &peer = _environment.peer();
+    const bool is_peer = (advertiser == _environment.background_advertisers());
+
+    /* the peer does not advertise while connected */
+    bool advertising = !is_peer || !link.is_open();
+    if (advertising && (!_filter_duplicates || !_reported[advertiser])) {
+        _reported[advertiser] = true;
+
+        std::vector<uint8_t> payload = is_peer ? peer.advertising_data() : background_payload(advertiser);
+        GapAdvertisingReportEvent::advertising_t advertising_report = {
+            is_peer && peer.is_connectable() ?
+                received_advertising_type_t::ADV_IND :
+                received_advertising_type_t::ADV_NONCONN_IND,
+            connection_peer_address_type_t::RANDOM_ADDRESS,
+            is_peer ? peer.address() : background_address(advertiser),
+            make_const_Span(payload.data(), payload.size()),
+            is_peer ? PEER_RSSI : BACKGROUND_RSSI
+        };
+        emit(AdvertisingReport(advertising_report));
+    }
+
+    uint16_t interval = is_peer ?
+        link.configuration().advertising_interval :
+        _environment.background_advertising_interval();
+    schedule_advertising_event(
+        advertiser,
+        interval * ADVERTISING_INTERVAL_UNIT + std::chrono::microseconds(link.random(MAX_ADVERTISING_DELAY))
+    );
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::extended_scan_enable(
+    bool enable,
+    duplicates_filter_t filter_duplicates,
+    uint16_t duration,
+    uint16_t period
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+ble_error_t VirtualPalGap::periodic_advertising_create_sync(
+    bool use_periodic_advertiser_list,
+    uint8_t advertising_sid,
+    peer_address_type_t peer_address_type,
+    const address_t &peer_address,
+    uint16_t allowed_skip,
+    uint16_t sync_timeout
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalGap::cancel_periodic_advertising_create_sync()
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalGap::periodic_advertising_terminate_sync(sync_handle_t sync_handle)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalGap::add_device_to_periodic_advertiser_list(
+    advertising_peer_address_type_t advertiser_address_type,
+    const address_t &advertiser_address,
+    uint8_t advertising_sid
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalGap::remove_device_from_periodic_advertiser_list(
+    advertising_peer_address_type_t advertiser_address_type,
+    const address_t &advertiser_address,
+    uint8_t advertising_sid
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalGap::clear_periodic_advertiser_list()
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+uint8_t VirtualPalGap::read_periodic_advertiser_list_size()
+{
+    return 0;
+}
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+#endif // BLE_ROLE_OBSERVER
+
+#if BLE_ROLE_CENTRAL
+ble_error_t VirtualPalGap::create_connection(
+    uint16_t scan_interval,
+    uint16_t scan_window,
+    initiator_policy_t initiator_policy,
+    connection_peer_address_type_t peer_address_type,
+    const address_t &peer_address,
+    own_address_type_t own_address_type,
+    uint16_t connection_interval_min,
+    uint16_t connection_interval_max,
+    uint16_t connection_latency,
+    uint16_t supervision_timeout,
+    uint16_t minimum_connection_event_length,
+    uint16_t maximum_connection_event_length
+)
+{
+    if (_initiating || _environment.link().is_open()) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    _initiating = true;
+    _initiation_address = peer_address;
+    _initiation_interval_min = connection_interval_min;
+    _initiation_interval_max = connection_interval_max;
+
+    /* the connection request is sent at the next advertising event of the target */
+    VirtualLink &link = _environment.link();
+    const uint32_t generation = ++_initiation_generation;
+    _environment.simulator().post_in(
+        std::chrono::microseconds(link.random(link.configuration().advertising_interval * ADVERTISING_INTERVAL_UNIT.count())),
+        [this, generation]() { on_peer_advertising_event(generation); }
+    );
+
+    return BLE_ERROR_NONE;
+}
+
+void VirtualPalGap::on_peer_advertising_event(uint32_t generation)
+{
+    if (!_initiating || generation != _initiation_generation) {
+        return;
+    }
+
+    VirtualLink &link = _environment.link();
+    VirtualPeer &peer = _environment.peer();
+
+    if (!peer.is_connectable() || _initiation_address != peer.address()) {
+        /* keep listening; only a cancellation stops the initiator */
+        _environment.simulator().post_in(
+            link.configuration().advertising_interval * ADVERTISING_INTERVAL_UNIT,
+            [this, generation]() { on_peer_advertising_event(generation); }
+        );
+        return;
+    }
+
+    _initiating = false;
+    connection_handle_t connection = ++_last_connection_handle;
+    uint16_t interval = std::max(
+        _initiation_interval_min,
+        std::min(link.configuration().connection_interval, _initiation_interval_max)
+    );
+
+    link.open(connection, TRANSMIT_WINDOW_DELAY);
+    link.set_connection_parameters(interval, link.configuration().peripheral_latency);
+    peer.on_connected();
+
+    /* reported once the first connection event is over */
+    _environment.simulator().post_in(TRANSMIT_WINDOW_DELAY, [this, connection]() {
+        VirtualLink &link = _environment.link();
+        emit(GapConnectionCompleteEvent(
+            hci_error_code_t::SUCCESS,
+            connection,
+            connection_role_t::CENTRAL,
+            peer_address_type_t::RANDOM,
+            _environment.peer().address(),
+            link.connection_interval(),
+            link.peripheral_latency(),
+            link.configuration().supervision_timeout,
+            address_t(),
+            address_t()
+        ));
+    });
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+ble_error_t VirtualPalGap::extended_create_connection(
+    initiator_policy_t initiator_policy,
+    own_address_type_t own_address_type,
+    peer_address_type_t peer_address_type,
+    const address_t &peer_address,
+    phy_set_t initiating_phys,
+    const uint16_t *scan_intervals,
+    const uint16_t *scan_windows,
+    const uint16_t *connection_intervals_min,
+    const uint16_t *connection_intervals_max,
+    const uint16_t *connection_latencies,
+    const uint16_t *supervision_timeouts,
+    const uint16_t *minimum_connection_event_lengths,
+    const uint16_t *maximum_connection_event_lengths
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+ble_error_t VirtualPalGap::cancel_connection_creation()
+{
+    if (!_initiating) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    _initiating = false;
+    ++_initiation_generation;
+
+    _environment.simulator().post([this]() {
+        emit(GapConnectionCompleteEvent(
+            hci_error_code_t::UNKNOWN_CONNECTION_IDENTIFIER,
+            0,
+            connection_role_t::CENTRAL,
+            peer_address_type_t::RANDOM,
+            _initiation_address,
+            0,
+            0,
+            0,
+            address_t(),
+            address_t()
+        ));
+    });
+
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_ROLE_CENTRAL
+
+#if BLE_FEATURE_WHITELIST
+uint8_t VirtualPalGap::read_white_list_capacity()
+{
+    return WHITE_LIST_CAPACITY;
+}
+
+ble_error_t VirtualPalGap::clear_whitelist()
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::add_device_to_whitelist(
+    whitelist_address_type_t address_type,
+    address_t address
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::remove_device_from_whitelist(
+    whitelist_address_type_t address_type,
+    address_t address
+)
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_WHITELIST
+
+#if BLE_FEATURE_CONNECTABLE
+ble_error_t VirtualPalGap::connection_parameters_update(
+    connection_handle_t connection,
+    uint16_t connection_interval_min,
+    uint16_t connection_interval_max,
+    uint16_t connection_latency,
+    uint16_t supervision_timeout,
+    uint16_t minimum_connection_event_length,
+    uint16_t maximum_connection_event_length
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    _environment.link().update_connection_parameters(
+        connection_interval_min,
+        connection_latency,
+        CONNECTION_UPDATE_INSTANT,
+        [this, connection, connection_interval_min, connection_latency, supervision_timeout]() {
+            if (!is_connected(connection)) {
+                return;
+            }
+            emit(GapConnectionUpdateEvent(
+                hci_error_code_t::SUCCESS,
+                connection,
+                connection_interval_min,
+                connection_latency,
+                supervision_timeout
+            ));
+        }
+    );
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::accept_connection_parameter_request(
+    connection_handle_t connection_handle,
+    uint16_t interval_min,
+    uint16_t interval_max,
+    uint16_t latency,
+    uint16_t supervision_timeout,
+    uint16_t minimum_connection_event_length,
+    uint16_t maximum_connection_event_length
+)
+{
+    return connection_parameters_update(
+        connection_handle,
+        interval_min,
+        interval_max,
+        latency,
+        supervision_timeout,
+        minimum_connection_event_length,
+        maximum_connection_event_length
+    );
+}
+
+ble_error_t VirtualPalGap::reject_connection_parameter_request(
+    connection_handle_t connection_handle,
+    hci_error_code_t rejection_reason
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::disconnect(
+    connection_handle_t connection,
+    local_disconnection_reason_t disconnection_reason
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    /* the terminate indication is acknowledged at the next connection event */
+    sim_time_t delay = connection_events(1);
+    _environment.link().close();
+    _environment.peer().on_disconnected();
+
+    _environment.simulator().post_in(delay, [this, connection]() {
+        emit(GapDisconnectionCompleteEvent(
+            hci_error_code_t::SUCCESS,
+            connection,
+            hci_error_code_t::CONNECTION_TERMINATED_BY_LOCAL_HOST
+        ));
+    });
+
+    return BLE_ERROR_NONE;
+}
+
+void VirtualPalGap::on_peer_disconnection(uint8_t reason)
+{
+    connection_handle_t connection = _environment.link().handle();
+    _environment.simulator().post([this, connection, reason]() {
+        emit(GapDisconnectionCompleteEvent(hci_error_code_t::SUCCESS, connection, reason));
+    });
+}
+
+ble_error_t VirtualPalGap::set_data_length(
+    connection_handle_t connection,
+    uint16_t tx_octets,
+    uint16_t tx_time
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    _environment.simulator().post_in(
+        connection_events(CONTROL_PROCEDURE_EVENTS),
+        [this, connection, tx_octets]() {
+            if (!is_connected(connection)) {
+                return;
+            }
+            VirtualLink &link = _environment.link();
+            link.set_tx_octets(tx_octets);
+            if (_event_handler) {
+                _event_handler->on_data_length_change(connection, link.tx_octets(), link.tx_octets());
+            }
+        }
+    );
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::get_next_connection_event(
+    connection_handle_t connection,
+    microsecond_t &delay
+)
+{
+    if (!_environment.link().configuration().connection_event_notification) {
+        return BLE_ERROR_NOT_IMPLEMENTED;
+    }
+
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    sim_time_t remaining = _environment.link().next_connection_event() - _environment.simulator().now();
+    delay = microsecond_t(remaining.count());
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::enable_connection_event_notification(
+    connection_handle_t connection,
+    microsecond_t lead,
+    bool enable
+)
+{
+    if (!_environment.link().configuration().connection_event_notification) {
+        return BLE_ERROR_NOT_IMPLEMENTED;
+    }
+
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t generation = ++_notification_generation;
+    if (enable) {
+        _notification_lead = sim_time_t(lead.value());
+        schedule_connection_event_notification(connection, generation);
+    }
+    return BLE_ERROR_NONE;
+}
+
+void VirtualPalGap::schedule_connection_event_notification(
+    connection_handle_t connection,
+    uint32_t generation
+)
+{
+    const sim_time_t anchor = _environment.link().next_connection_event();
+
+    _environment.simulator().post_at(anchor - _notification_lead, [this, connection, generation, anchor]() {
+        if (!is_connected(connection) || generation != _notification_generation) {
+            return;
+        }
+        if (_event_handler) {
+            _event_handler->on_connection_event_notification(connection);
+        }
+        /* the link schedules the following event once this one has run */
+        _environment.simulator().post_at(anchor, [this, connection, generation]() {
+            if (is_connected(connection) && generation == _notification_generation) {
+                schedule_connection_event_notification(connection, generation);
+            }
+        });
+    });
+}
+
+sim_time_t VirtualPalGap::connection_events(uint16_t count) const
+{
+    return count * _environment.link().connection_interval() * CONNECTION_INTERVAL_UNIT;
+}
+
+bool VirtualPalGap::is_connected(connection_handle_t connection) const
+{
+    return _environment.link().is_open() && _environment.link().handle() == connection;
+}
+#endif // BLE_FEATURE_CONNECTABLE
+
+#if BLE_FEATURE_PHY_MANAGEMENT
+ble_error_t VirtualPalGap::read_phy(connection_handle_t connection)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    _environment.simulator().post([this, connection]() {
+        phy_t phy = _environment.link().is_2m_phy() ? phy_t::LE_2M : phy_t::LE_1M;
+        if (_event_handler) {
+            _event_handler->on_read_phy(hci_error_code_t::SUCCESS, connection, phy, phy);
+        }
+    });
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::set_preferred_phys(
+    const phy_set_t &tx_phys,
+    const phy_set_t &rx_phys
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalGap::set_phy(
+    connection_handle_t connection,
+    const phy_set_t &tx_phys,
+    const phy_set_t &rx_phys,
+    coded_symbol_per_bit_t coded_symbol
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    /* the link is symmetric: 2M is used only if requested in both directions */
+    const bool use_2m = tx_phys.get_2m() && rx_phys.get_2m();
+    _environment.simulator().post_in(
+        connection_events(CONTROL_PROCEDURE_EVENTS),
+        [this, connection, use_2m]() {
+            if (!is_connected(connection)) {
+                return;
+            }
+            _environment.link().set_2m_phy(use_2m);
+            phy_t phy = use_2m ? phy_t::LE_2M : phy_t::LE_1M;
+            if (_event_handler) {
+                _event_handler->on_phy_update_complete(hci_error_code_t::SUCCESS, connection, phy, phy);
+            }
+        }
+    );
+
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_PHY_MANAGEMENT
+
+void VirtualPalGap::when_gap_event_received(mbed::Callback<void(const GapEvent &)> cb)
+{
+    _gap_event_cb = cb;
+}
+
+void VirtualPalGap::set_event_handler(PalGapEventHandler *event_handler)
+{
+    _event_handler = event_handler;
+}
+
+PalGapEventHandler *VirtualPalGap::get_event_handler()
+{
+    return _event_handler;
+}
+
+void VirtualPalGap::emit(const GapEvent &event)
+{
+    if (_gap_event_cb) {
+        _gap_event_cb(event);
+    }
+}
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+void VirtualPalGap::count_fragment(advertising_fragment_description_t operation)
+{
+    if (operation == advertising_fragment_description_t::COMPLETE_FRAGMENT) {
+        ++_environment.controller_statistics().complete_fragments;
+    } else {
+        ++_environment.controller_statistics().partial_fragments;
+    }
+}
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+} // namespace virtual_pal
+} // namespace ble
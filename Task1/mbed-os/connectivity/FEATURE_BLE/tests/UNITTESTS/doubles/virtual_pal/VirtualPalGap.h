@@ -0,0 +1,464 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_GAP_H_
+#define BLE_VIRTUAL_PAL_GAP_H_
+
+#include <vector>
+
+#include "source/pal/PalGap.h"
+#include "source/pal/PalGenericAccessService.h"
+
+#include "VirtualEnvironment.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Implementation of ble::PalGap on top of the virtual environment.
+ *
+ * Scanning and initiating only use legacy PDUs. When built with extended
+ * advertising, advertising sets and periodic advertising start and stop and
+ * their data commands are counted; nothing is sent on air. Scanning reports the
+ * peer and the background advertisers at their advertising interval;
+ * initiating a connection with the peer succeeds at its next advertising
+ * event. Once connected, the link layer procedures (connection update, data
+ * length update, PHY update) complete after a few connection events and
+ * change the parameters of the virtual link. Unlike an HCI controller, the
+ * virtual controller reports the anchor point of connection events.
+ */
+class VirtualPalGap final : public ble::PalGap {
+public:
+    explicit VirtualPalGap(VirtualEnvironment &environment);
+
+    bool is_feature_supported(
+        ble::controller_supported_features_t feature
+    ) final;
+
+    ble_error_t initialize() final;
+
+    ble_error_t terminate() final;
+
+    address_t get_device_address() final;
+
+    address_t get_random_address() final;
+
+    ble_error_t set_random_address(const address_t &address) final;
+
+#if BLE_ROLE_BROADCASTER
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t set_advertising_set_random_address(
+        advertising_handle_t advertising_handle,
+        const address_t &address
+    ) final;
+#endif
+
+    ble_error_t set_advertising_parameters(
+        uint16_t advertising_interval_min,
+        uint16_t advertising_interval_max,
+        advertising_type_t advertising_type,
+        own_address_type_t own_address_type,
+        advertising_peer_address_type_t peer_address_type,
+        const address_t &peer_address,
+        advertising_channel_map_t advertising_channel_map,
+        advertising_filter_policy_t advertising_filter_policy
+    ) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t set_extended_advertising_parameters(
+        advertising_handle_t advertising_handle,
+        advertising_event_properties_t event_properties,
+        advertising_interval_t primary_advertising_interval_min,
+        advertising_interval_t primary_advertising_interval_max,
+        advertising_channel_map_t primary_advertising_channel_map,
+        own_address_type_t own_address_type,
+        advertising_peer_address_type_t peer_address_type,
+        const address_t &peer_address,
+        advertising_filter_policy_t advertising_filter_policy,
+        advertising_power_t advertising_power,
+        phy_t primary_advertising_phy,
+        uint8_t secondary_advertising_max_skip,
+        phy_t secondary_phy,
+        uint8_t advertising_sid,
+        bool scan_request_notification
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+    ble_error_t set_periodic_advertising_parameters(
+        advertising_handle_t advertising_handle,
+        periodic_advertising_interval_t periodic_advertising_min,
+        periodic_advertising_interval_t periodic_advertising_max,
+        bool advertise_power
+    ) final;
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+
+    ble_error_t set_advertising_data(
+        uint8_t advertising_data_length,
+        const advertising_data_t &advertising_data
+    ) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t set_extended_advertising_data(
+        advertising_handle_t advertising_handle,
+        advertising_fragment_description_t operation,
+        bool minimize_fragmentation,
+        uint8_t advertising_data_size,
+        const uint8_t *advertising_data
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+    ble_error_t set_periodic_advertising_data(
+        advertising_handle_t advertising_handle,
+        advertising_fragment_description_t fragment_description,
+        uint8_t advertising_data_size,
+        const uint8_t *advertising_data
+    ) final;
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+
+    ble_error_t set_scan_response_data(
+        uint8_t scan_response_data_length,
+        const advertising_data_t &scan_response_data
+    ) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t set_extended_scan_response_data(
+        advertising_handle_t advertising_handle,
+        advertising_fragment_description_t operation,
+        bool minimize_fragmentation,
+        uint8_t scan_response_data_size,
+        const uint8_t *scan_response_data
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+    ble_error_t advertising_enable(bool enable) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t extended_advertising_enable(
+        bool enable,
+        uint8_t number_of_sets,
+        const advertising_handle_t *handles,
+        const uint16_t *durations,
+        const uint8_t *max_extended_advertising_events
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+    ble_error_t periodic_advertising_enable(
+        bool enable,
+        advertising_handle_t advertising_handle
+    ) final;
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+
+    uint16_t get_maximum_advertising_data_length() final;
+
+    uint16_t get_maximum_connectable_advertising_data_length() final;
+
+    uint8_t get_maximum_hci_advertising_data_length() final;
+
+    uint8_t get_max_number_of_advertising_sets() final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t remove_advertising_set(
+        advertising_handle_t advertising_handle
+    ) final;
+
+    ble_error_t clear_advertising_sets() final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+#endif // BLE_ROLE_BROADCASTER
+
+#if BLE_ROLE_OBSERVER
+    ble_error_t set_scan_parameters(
+        bool active_scanning,
+        uint16_t scan_interval,
+        uint16_t scan_window,
+        own_address_type_t own_address_type,
+        scanning_filter_policy_t filter_policy
+    ) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t set_extended_scan_parameters(
+        own_address_type_t own_address_type,
+        scanning_filter_policy_t filter_policy,
+        phy_set_t scanning_phys,
+        const bool *active_scanning,
+        const uint16_t *scan_interval,
+        const uint16_t *scan_window
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+    ble_error_t scan_enable(
+        bool enable,
+        bool filter_duplicates
+    ) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t extended_scan_enable(
+        bool enable,
+        duplicates_filter_t filter_duplicates,
+        uint16_t duration,
+        uint16_t period
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_FEATURE_PERIODIC_ADVERTISING
+    ble_error_t periodic_advertising_create_sync(
+        bool use_periodic_advertiser_list,
+        uint8_t advertising_sid,
+        peer_address_type_t peer_address_type,
+        const address_t &peer_address,
+        uint16_t allowed_skip,
+        uint16_t sync_timeout
+    ) final;
+
+    ble_error_t cancel_periodic_advertising_create_sync() final;
+
+    ble_error_t periodic_advertising_terminate_sync(
+        sync_handle_t sync_handle
+    ) final;
+
+    ble_error_t add_device_to_periodic_advertiser_list(
+        advertising_peer_address_type_t advertiser_address_type,
+        const address_t &advertiser_address,
+        uint8_t advertising_sid
+    ) final;
+
+    ble_error_t remove_device_from_periodic_advertiser_list(
+        advertising_peer_address_type_t advertiser_address_type,
+        const address_t &advertiser_address,
+        uint8_t advertising_sid
+    ) final;
+
+    ble_error_t clear_periodic_advertiser_list() final;
+
+    uint8_t read_periodic_advertiser_list_size() final;
+#endif // BLE_FEATURE_PERIODIC_ADVERTISING
+#endif // BLE_ROLE_OBSERVER
+
+#if BLE_ROLE_CENTRAL
+    ble_error_t create_connection(
+        uint16_t scan_interval,
+        uint16_t scan_window,
+        initiator_policy_t initiator_policy,
+        connection_peer_address_type_t peer_address_type,
+        const address_t &peer_address,
+        own_address_type_t own_address_type,
+        uint16_t connection_interval_min,
+        uint16_t connection_interval_max,
+        uint16_t connection_latency,
+        uint16_t supervision_timeout,
+        uint16_t minimum_connection_event_length,
+        uint16_t maximum_connection_event_length
+    ) final;
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t extended_create_connection(
+        initiator_policy_t initiator_policy,
+        own_address_type_t own_address_type,
+        peer_address_type_t peer_address_type,
+        const address_t &peer_address,
+        phy_set_t initiating_phys,
+        const uint16_t *scan_intervals,
+        const uint16_t *scan_windows,
+        const uint16_t *connection_intervals_min,
+        const uint16_t *connection_intervals_max,
+        const uint16_t *connection_latencies,
+        const uint16_t *supervision_timeouts,
+        const uint16_t *minimum_connection_event_lengths,
+        const uint16_t *maximum_connection_event_lengths
+    ) final;
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+    ble_error_t cancel_connection_creation() final;
+#endif // BLE_ROLE_CENTRAL
+
+#if BLE_FEATURE_WHITELIST
+    uint8_t read_white_list_capacity() final;
+
+    ble_error_t clear_whitelist() final;
+
+    ble_error_t add_device_to_whitelist(
+        whitelist_address_type_t address_type,
+        address_t address
+    ) final;
+
+    ble_error_t remove_device_from_whitelist(
+        whitelist_address_type_t address_type,
+        address_t address
+    ) final;
+#endif // BLE_FEATURE_WHITELIST
+
+#if BLE_FEATURE_CONNECTABLE
+    ble_error_t connection_parameters_update(
+        connection_handle_t connection,
+        uint16_t connection_interval_min,
+        uint16_t connection_interval_max,
+        uint16_t connection_latency,
+        uint16_t supervision_timeout,
+        uint16_t minimum_connection_event_length,
+        uint16_t maximum_connection_event_length
+    ) final;
+
+    ble_error_t accept_connection_parameter_request(
+        connection_handle_t connection_handle,
+        uint16_t interval_min,
+        uint16_t interval_max,
+        uint16_t latency,
+        uint16_t supervision_timeout,
+        uint16_t minimum_connection_event_length,
+        uint16_t maximum_connection_event_length
+    ) final;
+
+    ble_error_t reject_connection_parameter_request(
+        connection_handle_t connection_handle,
+        hci_error_code_t rejection_reason
+    ) final;
+
+    ble_error_t disconnect(
+        connection_handle_t connection,
+        local_disconnection_reason_t disconnection_reason
+    ) final;
+
+    ble_error_t set_data_length(
+        connection_handle_t connection,
+        uint16_t tx_octets,
+        uint16_t tx_time
+    ) final;
+
+    ble_error_t get_next_connection_event(
+        connection_handle_t connection,
+        microsecond_t &delay
+    ) final;
+
+    ble_error_t enable_connection_event_notification(
+        connection_handle_t connection,
+        microsecond_t lead,
+        bool enable
+    ) final;
+#endif
+
+#if BLE_FEATURE_PHY_MANAGEMENT
+    ble_error_t read_phy(connection_handle_t connection) final;
+
+    ble_error_t set_preferred_phys(
+        const phy_set_t &tx_phys,
+        const phy_set_t &rx_phys
+    ) final;
+
+    ble_error_t set_phy(
+        connection_handle_t connection,
+        const phy_set_t &tx_phys,
+        const phy_set_t &rx_phys,
+        coded_symbol_per_bit_t coded_symbol
+    ) final;
+#endif // BLE_FEATURE_PHY_MANAGEMENT
+
+    void when_gap_event_received(mbed::Callback<void(const GapEvent &)> cb) final;
+
+    void set_event_handler(PalGapEventHandler *event_handler) final;
+
+    PalGapEventHandler *get_event_handler() final;
+
+private:
+    void emit(const GapEvent &event);
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    void count_fragment(advertising_fragment_description_t operation);
+#endif // BLE_FEATURE_EXTENDED_ADVERTISING
+
+#if BLE_ROLE_OBSERVER
+    void schedule_advertising_event(uint32_t advertiser, sim_time_t delay);
+
+    void on_advertising_event(uint32_t advertiser, uint32_t generation);
+#endif // BLE_ROLE_OBSERVER
+
+#if BLE_ROLE_CENTRAL
+    void on_peer_advertising_event(uint32_t generation);
+#endif // BLE_ROLE_CENTRAL
+
+#if BLE_FEATURE_CONNECTABLE
+    void on_peer_disconnection(uint8_t reason);
+
+    /* delay of a link layer procedure completing after count connection events */
+    sim_time_t connection_events(uint16_t count) const;
+
+    bool is_connected(connection_handle_t connection) const;
+
+    /* post the notification of the next connection event not yet notified */
+    void schedule_connection_event_notification(connection_handle_t connection, uint32_t generation);
+#endif // BLE_FEATURE_CONNECTABLE
+
+    VirtualEnvironment &_environment;
+    PalGapEventHandler *_event_handler;
+    mbed::Callback<void(const GapEvent &)> _gap_event_cb;
+
+    address_t _random_address;
+
+#if BLE_ROLE_OBSERVER
+    bool _scanning;
+    bool _filter_duplicates;
+    uint32_t _scan_generation;
+    /* advertisers already reported while filtering duplicates; peer is last */
+    std::vector<bool> _reported;
+#endif // BLE_ROLE_OBSERVER
+
+#if BLE_ROLE_CENTRAL
+    bool _initiating;
+    uint32_t _initiation_generation;
+    address_t _initiation_address;
+    uint16_t _initiation_interval_min;
+    uint16_t _initiation_interval_max;
+#endif // BLE_ROLE_CENTRAL
+
+#if BLE_FEATURE_CONNECTABLE
+    connection_handle_t _last_connection_handle;
+    sim_time_t _notification_lead;
+    uint32_t _notification_generation;
+#endif // BLE_FEATURE_CONNECTABLE
+};
+
+/**
+ * Storage of the peripheral preferred connection parameters; the virtual
+ * environment has no local GATT server to expose them.
+ */
+class VirtualPalGenericAccessService final : public ble::PalGenericAccessService {
+public:
+    ble_error_t get_peripheral_preferred_connection_parameters(
+        ble::Gap::PreferredConnectionParams_t &parameters
+    ) final
+    {
+        parameters = _preferred_connection_parameters;
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t set_peripheral_preferred_connection_parameters(
+        const ble::Gap::PreferredConnectionParams_t &parameters
+    ) final
+    {
+        _preferred_connection_parameters = parameters;
+        return BLE_ERROR_NONE;
+    }
+
+private:
+    ble::Gap::PreferredConnectionParams_t _preferred_connection_parameters = {};
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_GAP_H_ */
@@ -0,0 +1,567 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VirtualPalSecurityManager.h"
+#include "VirtualProtocol.h"
+
+namespace ble {
+namespace virtual_pal {
+
+namespace {
+constexpr uint8_t MAX_ENCRYPTION_KEY_SIZE = 16;
+/* default authentication timeout: 30 seconds */
+constexpr uint16_t DEFAULT_AUTHENTICATION_TIMEOUT = 3000;
+/* random number, encrypted diversifier, session key diversifier and IV */
+constexpr size_t ENC_REQ_PARAMETERS_SIZE = 8 + 2 + 8 + 4;
+}
+
+VirtualPalSecurityManager::VirtualPalSecurityManager(VirtualEnvironment &environment) :
+    _environment(environment),
+    _event_handler(nullptr),
+    _io_capability(io_capability_t::NO_INPUT_NO_OUTPUT),
+    _authentication_timeout(DEFAULT_AUTHENTICATION_TIMEOUT),
+    _connection(0),
+    _pairing(false),
+    _encrypting(false),
+    _local_keys(0),
+    _peer_keys(0)
+{
+}
+
+ble_error_t VirtualPalSecurityManager::initialize()
+{
+    _environment.set_local_receiver(
+        channel_t::SMP,
+        [this](channel_t, const std::vector<uint8_t> &pdu) { on_smp_command(pdu); }
+    );
+    _environment.set_local_receiver(
+        channel_t::LL_CONTROL,
+        [this](channel_t, const std::vector<uint8_t> &pdu) { on_ll_control(pdu); }
+    );
+    return reset();
+}
+
+ble_error_t VirtualPalSecurityManager::terminate()
+{
+    _environment.set_local_receiver(channel_t::SMP, nullptr);
+    _environment.set_local_receiver(channel_t::LL_CONTROL, nullptr);
+    return reset();
+}
+
+ble_error_t VirtualPalSecurityManager::reset()
+{
+    _pairing = false;
+    _encrypting = false;
+    _local_keys = 0;
+    _peer_keys = 0;
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_ROLE_CENTRAL
+ble_error_t VirtualPalSecurityManager::send_pairing_request(
+    connection_handle_t connection,
+    bool oob_data_flag,
+    AuthenticationMask authentication_requirements,
+    KeyDistribution initiator_dist,
+    KeyDistribution responder_dist
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    if (_pairing) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    _connection = connection;
+    _pairing = true;
+
+    send(channel_t::SMP, {
+        smp::PAIRING_REQUEST,
+        _io_capability.value(),
+        (uint8_t) (oob_data_flag ? 0x01 : 0x00),
+        authentication_requirements.value(),
+        MAX_ENCRYPTION_KEY_SIZE,
+        initiator_dist.value(),
+        responder_dist.value()
+    });
+
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_ROLE_CENTRAL
+
+#if BLE_ROLE_PERIPHERAL
+ble_error_t VirtualPalSecurityManager::send_pairing_response(
+    connection_handle_t connection,
+    bool oob_data_flag,
+    AuthenticationMask authentication_requirements,
+    KeyDistribution initiator_dist,
+    KeyDistribution responder_dist
+)
+{
+    /* the local device is always the central of the virtual link */
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_ROLE_PERIPHERAL
+
+ble_error_t VirtualPalSecurityManager::cancel_pairing(
+    connection_handle_t connection,
+    pairing_failure_t reason
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    _pairing = false;
+    send(channel_t::SMP, { smp::PAIRING_FAILED, reason.value() });
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::get_secure_connections_support(
+    bool &enabled
+)
+{
+    enabled = false;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_io_capability(
+    io_capability_t io_capability
+)
+{
+    _io_capability = io_capability;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_authentication_timeout(
+    connection_handle_t connection,
+    uint16_t timeout_in_10ms
+)
+{
+    _authentication_timeout = timeout_in_10ms;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::get_authentication_timeout(
+    connection_handle_t connection,
+    uint16_t &timeout_in_10ms
+)
+{
+    timeout_in_10ms = _authentication_timeout;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_encryption_key_requirements(
+    uint8_t min_encryption_key_size,
+    uint8_t max_encryption_key_size
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_ROLE_PERIPHERAL
+ble_error_t VirtualPalSecurityManager::slave_security_request(
+    connection_handle_t connection,
+    AuthenticationMask authentication
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_ROLE_PERIPHERAL
+
+#if BLE_ROLE_CENTRAL
+ble_error_t VirtualPalSecurityManager::enable_encryption(
+    connection_handle_t connection,
+    const ltk_t &ltk,
+    const rand_t &rand,
+    const ediv_t &ediv,
+    bool mitm
+)
+{
+    if (!is_connected(connection)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    if (_encrypting) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    _connection = connection;
+    _encrypting = true;
+
+    std::vector<uint8_t> request { ll::ENC_REQ };
+    request.insert(request.end(), rand.data(), rand.data() + rand.size());
+    request.insert(request.end(), ediv.data(), ediv.data() + ediv.size());
+    put_random(request, ENC_REQ_PARAMETERS_SIZE - rand.size() - ediv.size());
+    send(channel_t::LL_CONTROL, std::move(request));
+
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_SECURE_CONNECTIONS
+ble_error_t VirtualPalSecurityManager::enable_encryption(
+    connection_handle_t connection,
+    const ltk_t &ltk,
+    bool mitm
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_FEATURE_SECURE_CONNECTIONS
+#endif // BLE_ROLE_CENTRAL
+
+ble_error_t VirtualPalSecurityManager::encrypt_data(
+    const byte_array_t<16> &key,
+    encryption_block_t &data
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalSecurityManager::set_ltk(
+    connection_handle_t connection,
+    const ltk_t &ltk,
+    bool mitm,
+    bool secure_connections
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_ltk_not_found(
+    connection_handle_t connection
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_irk(
+    const irk_t &irk
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_identity_address(
+    const address_t &address, bool public_address
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+#if BLE_FEATURE_SIGNING
+ble_error_t VirtualPalSecurityManager::set_csrk(
+    const csrk_t &csrk,
+    sign_count_t sign_counter
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_peer_csrk(
+    connection_handle_t connection,
+    const csrk_t &csrk,
+    bool authenticated,
+    sign_count_t sign_counter
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::remove_peer_csrk(connection_handle_t connection)
+{
+    return BLE_ERROR_NONE;
+}
+#endif // BLE_FEATURE_SIGNING
+
+ble_error_t VirtualPalSecurityManager::get_random_data(
+    byte_array_t<8> &random_data
+)
+{
+    for (size_t i = 0; i < random_data.size(); ++i) {
+        random_data[i] = (uint8_t) _environment.link().random(256);
+    }
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::set_display_passkey(
+    passkey_num_t passkey
+)
+{
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t VirtualPalSecurityManager::passkey_request_reply(
+    connection_handle_t connection,
+    passkey_num_t passkey
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+#if BLE_FEATURE_SECURE_CONNECTIONS
+ble_error_t VirtualPalSecurityManager::secure_connections_oob_request_reply(
+    connection_handle_t connection,
+    const oob_lesc_value_t &local_random,
+    const oob_lesc_value_t &peer_random,
+    const oob_confirm_t &peer_confirm
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_FEATURE_SECURE_CONNECTIONS
+
+ble_error_t VirtualPalSecurityManager::legacy_pairing_oob_request_reply(
+    connection_handle_t connection,
+    const oob_tk_t &oob_data
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+#if BLE_FEATURE_SECURE_CONNECTIONS
+ble_error_t VirtualPalSecurityManager::confirmation_entered(
+    connection_handle_t connection,
+    bool confirmation
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalSecurityManager::send_keypress_notification(
+    connection_handle_t connection,
+    ble::Keypress_t keypress
+)
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+
+ble_error_t VirtualPalSecurityManager::generate_secure_connections_oob()
+{
+    return BLE_ERROR_NOT_IMPLEMENTED;
+}
+#endif // BLE_FEATURE_SECURE_CONNECTIONS
+
+void VirtualPalSecurityManager::set_event_handler(PalSecurityManagerEventHandler *event_handler)
+{
+    _event_handler = event_handler;
+}
+
+PalSecurityManagerEventHandler *VirtualPalSecurityManager::get_event_handler()
+{
+    return _event_handler;
+}
+
+void VirtualPalSecurityManager::on_smp_command(const std::vector<uint8_t> &pdu)
+{
+    if (pdu.empty() || !_event_handler) {
+        return;
+    }
+
+    const uint8_t *data = pdu.data();
+    const size_t size = pdu.size();
+
+    switch (data[0]) {
+        case smp::PAIRING_RESPONSE: {
+            if (!_pairing || size != 7) {
+                fail_pairing(pairing_failure_t::INVALID_PARAMETERS);
+                return;
+            }
+            _local_keys = data[5] & (KeyDistribution::KEY_DISTRIBUTION_ENCRYPTION | KeyDistribution::KEY_DISTRIBUTION_IDENTITY);
+            _peer_keys = data[6] & (KeyDistribution::KEY_DISTRIBUTION_ENCRYPTION | KeyDistribution::KEY_DISTRIBUTION_IDENTITY);
+
+            std::vector<uint8_t> confirm { smp::PAIRING_CONFIRM };
+            put_random(confirm, 16);
+            send(channel_t::SMP, std::move(confirm));
+            return;
+        }
+
+        case smp::PAIRING_CONFIRM: {
+            std::vector<uint8_t> random { smp::PAIRING_RANDOM };
+            put_random(random, 16);
+            send(channel_t::SMP, std::move(random));
+            return;
+        }
+
+        case smp::PAIRING_RANDOM: {
+            /* the short term key encrypts the link */
+            _encrypting = true;
+            std::vector<uint8_t> request { ll::ENC_REQ };
+            request.resize(1 + 8 + 2); /* rand and ediv are null for an STK */
+            put_random(request, ENC_REQ_PARAMETERS_SIZE - 8 - 2);
+            send(channel_t::LL_CONTROL, std::move(request));
+            return;
+        }
+
+        case smp::PAIRING_FAILED:
+            if (size == 2 && _pairing) {
+                _pairing = false;
+                _event_handler->on_pairing_error(_connection, (pairing_failure_t::type) data[1]);
+            }
+            return;
+
+        case smp::ENCRYPTION_INFORMATION:
+            if (size == 1 + 16) {
+                _event_handler->on_keys_distributed_ltk(_connection, ltk_t(data + 1));
+            }
+            return;
+
+        case smp::CENTRAL_IDENTIFICATION:
+            if (size == 1 + 2 + 8) {
+                _event_handler->on_keys_distributed_ediv_rand(_connection, ediv_t(data + 1), rand_t(data + 3));
+            }
+            _peer_keys &= ~KeyDistribution::KEY_DISTRIBUTION_ENCRYPTION;
+            break;
+
+        case smp::IDENTITY_INFORMATION:
+            if (size == 1 + 16) {
+                _event_handler->on_keys_distributed_irk(_connection, irk_t(data + 1));
+            }
+            return;
+
+        case smp::IDENTITY_ADDRESS_INFORMATION:
+            if (size == 1 + 1 + 6) {
+                _event_handler->on_keys_distributed_bdaddr(
+                    _connection,
+                    data[1] ? advertising_peer_address_type_t::RANDOM : advertising_peer_address_type_t::PUBLIC,
+                    address_t(data + 2)
+                );
+            }
+            _peer_keys &= ~KeyDistribution::KEY_DISTRIBUTION_IDENTITY;
+            break;
+
+#if BLE_ROLE_CENTRAL
+        case smp::SECURITY_REQUEST:
+            if (size == 2) {
+                _event_handler->on_slave_security_request(_environment.link().handle(), AuthenticationMask(data[1]));
+            }
+            return;
+#endif // BLE_ROLE_CENTRAL
+
+        default:
+            return;
+    }
+
+    if (_pairing && !_encrypting && !_peer_keys) {
+        distribute_keys();
+    }
+}
+
+void VirtualPalSecurityManager::on_ll_control(const std::vector<uint8_t> &pdu)
+{
+    if (pdu.empty() || !_event_handler) {
+        return;
+    }
+
+    switch (pdu[0]) {
+        case ll::START_ENC_REQ:
+            send(channel_t::LL_CONTROL, { ll::START_ENC_RSP });
+            return;
+
+        case ll::START_ENC_RSP:
+            if (!_encrypting) {
+                return;
+            }
+            _encrypting = false;
+            _event_handler->on_link_encryption_result(_connection, link_encryption_t::ENCRYPTED);
+            if (_pairing && !_peer_keys) {
+                distribute_keys();
+            }
+            return;
+
+        default:
+            return;
+    }
+}
+
+void VirtualPalSecurityManager::distribute_keys()
+{
+    const connection_handle_t connection = _connection;
+    VirtualLink::sent_handler_t complete = [this, connection]() {
+        _pairing = false;
+        if (_event_handler) {
+            _event_handler->on_pairing_completed(connection);
+        }
+    };
+
+    if (!_local_keys) {
+        _environment.simulator().post(complete);
+        return;
+    }
+
+    if (_local_keys & KeyDistribution::KEY_DISTRIBUTION_ENCRYPTION) {
+        std::vector<uint8_t> ltk { smp::ENCRYPTION_INFORMATION };
+        put_random(ltk, 16);
+        std::vector<uint8_t> identification { smp::CENTRAL_IDENTIFICATION };
+        put_random(identification, 2 + 8);
+
+        _event_handler->on_keys_distributed_local_ltk(connection, ltk_t(ltk.data() + 1));
+        _event_handler->on_keys_distributed_local_ediv_rand(
+            connection,
+            ediv_t(identification.data() + 1),
+            rand_t(identification.data() + 3)
+        );
+
+        send(channel_t::SMP, std::move(ltk));
+        send(
+            channel_t::SMP,
+            std::move(identification),
+            (_local_keys & KeyDistribution::KEY_DISTRIBUTION_IDENTITY) ? VirtualLink::sent_handler_t() : complete
+        );
+    }
+
+    if (_local_keys & KeyDistribution::KEY_DISTRIBUTION_IDENTITY) {
+        std::vector<uint8_t> irk { smp::IDENTITY_INFORMATION };
+        put_random(irk, 16);
+        send(channel_t::SMP, std::move(irk));
+
+        const address_t &address = _environment.local_address();
+        std::vector<uint8_t> identity_address { smp::IDENTITY_ADDRESS_INFORMATION, 0x00 /* public */ };
+        identity_address.insert(identity_address.end(), address.data(), address.data() + address.size());
+        send(channel_t::SMP, std::move(identity_address), complete);
+    }
+
+    _local_keys = 0;
+}
+
+void VirtualPalSecurityManager::fail_pairing(pairing_failure_t reason)
+{
+    send(channel_t::SMP, { smp::PAIRING_FAILED, reason.value() });
+    if (_pairing) {
+        _pairing = false;
+        _event_handler->on_pairing_error(_connection, reason);
+    }
+}
+
+void VirtualPalSecurityManager::send(channel_t channel, std::vector<uint8_t> pdu, VirtualLink::sent_handler_t on_sent)
+{
+    _environment.link().send(VirtualLink::TO_PEER, channel, std::move(pdu), std::move(on_sent));
+}
+
+void VirtualPalSecurityManager::put_random(std::vector<uint8_t> &pdu, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        pdu.push_back((uint8_t) _environment.link().random(256));
+    }
+}
+
+bool VirtualPalSecurityManager::is_connected(connection_handle_t connection) const
+{
+    return _environment.link().is_open() && _environment.link().handle() == connection;
+}
+
+} // namespace virtual_pal
+} // namespace ble
@@ -0,0 +1,239 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_SECURITY_MANAGER_H_
+#define BLE_VIRTUAL_PAL_SECURITY_MANAGER_H_
+
+#include <vector>
+
+#include "source/pal/PalSecurityManager.h"
+
+#include "VirtualEnvironment.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Implementation of ble::PalSecurityManager on top of the virtual
+ * environment.
+ *
+ * The local device pairs as a central with legacy Just Works: SMP commands
+ * are exchanged with the peer over the virtual link and the link is
+ * encrypted with the link layer encryption procedure. Keys are random, no
+ * cryptography is run; only the message flow and its timing are modelled.
+ */
+class VirtualPalSecurityManager final : public ble::PalSecurityManager {
+public:
+    explicit VirtualPalSecurityManager(VirtualEnvironment &environment);
+
+    ble_error_t initialize() final;
+
+    ble_error_t terminate() final;
+
+    ble_error_t reset() final;
+
+#if BLE_ROLE_CENTRAL
+    ble_error_t send_pairing_request(
+        connection_handle_t connection,
+        bool oob_data_flag,
+        AuthenticationMask authentication_requirements,
+        KeyDistribution initiator_dist,
+        KeyDistribution responder_dist
+    ) final;
+#endif // BLE_ROLE_CENTRAL
+
+#if BLE_ROLE_PERIPHERAL
+    ble_error_t send_pairing_response(
+        connection_handle_t connection,
+        bool oob_data_flag,
+        AuthenticationMask authentication_requirements,
+        KeyDistribution initiator_dist,
+        KeyDistribution responder_dist
+    ) final;
+#endif // BLE_ROLE_PERIPHERAL
+
+    ble_error_t cancel_pairing(
+        connection_handle_t connection,
+        pairing_failure_t reason
+    ) final;
+
+    ble_error_t get_secure_connections_support(
+        bool &enabled
+    ) final;
+
+    ble_error_t set_io_capability(
+        io_capability_t io_capability
+    ) final;
+
+    ble_error_t set_authentication_timeout(
+        connection_handle_t connection,
+        uint16_t timeout_in_10ms
+    ) final;
+
+    ble_error_t get_authentication_timeout(
+        connection_handle_t connection,
+        uint16_t &timeout_in_10ms
+    ) final;
+
+    ble_error_t set_encryption_key_requirements(
+        uint8_t min_encryption_key_size,
+        uint8_t max_encryption_key_size
+    ) final;
+
+#if BLE_ROLE_PERIPHERAL
+    ble_error_t slave_security_request(
+        connection_handle_t connection,
+        AuthenticationMask authentication
+    ) final;
+#endif // BLE_ROLE_PERIPHERAL
+
+#if BLE_ROLE_CENTRAL
+    ble_error_t enable_encryption(
+        connection_handle_t connection,
+        const ltk_t &ltk,
+        const rand_t &rand,
+        const ediv_t &ediv,
+        bool mitm
+    ) final;
+
+#if BLE_FEATURE_SECURE_CONNECTIONS
+    ble_error_t enable_encryption(
+        connection_handle_t connection,
+        const ltk_t &ltk,
+        bool mitm
+    ) final;
+#endif // BLE_FEATURE_SECURE_CONNECTIONS
+#endif // BLE_ROLE_CENTRAL
+
+    ble_error_t encrypt_data(
+        const byte_array_t<16> &key,
+        encryption_block_t &data
+    ) final;
+
+    ble_error_t set_ltk(
+        connection_handle_t connection,
+        const ltk_t &ltk,
+        bool mitm,
+        bool secure_connections
+    ) final;
+
+    ble_error_t set_ltk_not_found(
+        connection_handle_t connection
+    ) final;
+
+    ble_error_t set_irk(
+        const irk_t &irk
+    ) final;
+
+    ble_error_t set_identity_address(
+        const address_t &address, bool public_address
+    ) final;
+
+#if BLE_FEATURE_SIGNING
+    ble_error_t set_csrk(
+        const csrk_t &csrk,
+        sign_count_t sign_counter
+    ) final;
+
+    ble_error_t set_peer_csrk(
+        connection_handle_t connection,
+        const csrk_t &csrk,
+        bool authenticated,
+        sign_count_t sign_counter
+    ) final;
+
+    ble_error_t remove_peer_csrk(connection_handle_t connection) final;
+#endif // BLE_FEATURE_SIGNING
+
+    ble_error_t get_random_data(
+        byte_array_t<8> &random_data
+    ) final;
+
+    ble_error_t set_display_passkey(
+        passkey_num_t passkey
+    ) final;
+
+    ble_error_t passkey_request_reply(
+        connection_handle_t connection,
+        passkey_num_t passkey
+    ) final;
+
+#if BLE_FEATURE_SECURE_CONNECTIONS
+    ble_error_t secure_connections_oob_request_reply(
+        connection_handle_t connection,
+        const oob_lesc_value_t &local_random,
+        const oob_lesc_value_t &peer_random,
+        const oob_confirm_t &peer_confirm
+    ) final;
+#endif // BLE_FEATURE_SECURE_CONNECTIONS
+
+    ble_error_t legacy_pairing_oob_request_reply(
+        connection_handle_t connection,
+        const oob_tk_t &oob_data
+    ) final;
+
+#if BLE_FEATURE_SECURE_CONNECTIONS
+    ble_error_t confirmation_entered(
+        connection_handle_t connection,
+        bool confirmation
+    ) final;
+
+    ble_error_t send_keypress_notification(
+        connection_handle_t connection,
+        ble::Keypress_t keypress
+    ) final;
+
+    ble_error_t generate_secure_connections_oob() final;
+#endif // BLE_FEATURE_SECURE_CONNECTIONS
+
+    void set_event_handler(PalSecurityManagerEventHandler *event_handler) final;
+
+    PalSecurityManagerEventHandler *get_event_handler() final;
+
+private:
+    void on_smp_command(const std::vector<uint8_t> &pdu);
+
+    void on_ll_control(const std::vector<uint8_t> &pdu);
+
+    /* send the keys of the local device once the peer has sent its own */
+    void distribute_keys();
+
+    void fail_pairing(pairing_failure_t reason);
+
+    void send(channel_t channel, std::vector<uint8_t> pdu, VirtualLink::sent_handler_t on_sent = nullptr);
+
+    void put_random(std::vector<uint8_t> &pdu, size_t count);
+
+    bool is_connected(connection_handle_t connection) const;
+
+    VirtualEnvironment &_environment;
+    PalSecurityManagerEventHandler *_event_handler;
+    io_capability_t _io_capability;
+    uint16_t _authentication_timeout;
+
+    /* pairing procedure in progress on _connection */
+    connection_handle_t _connection;
+    bool _pairing;
+    bool _encrypting;
+    uint8_t _local_keys;
+    uint8_t _peer_keys;
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_SECURITY_MANAGER_H_ */
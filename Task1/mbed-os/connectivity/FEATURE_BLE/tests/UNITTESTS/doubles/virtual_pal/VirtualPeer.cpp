@@ -0,0 +1,543 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "ble/common/blecommon.h"
+#include "source/pal/AttServerMessage.h"
+
+#include "VirtualPeer.h"
+#include "VirtualProtocol.h"
+
+namespace ble {
+namespace virtual_pal {
+
+namespace {
+/* key distribution bits, see BLUETOOTH SPECIFICATION Version 5.0 | Vol 3, Part H - 3.6.1 */
+constexpr uint8_t ENC_KEY = 0x01;
+constexpr uint8_t ID_KEY = 0x02;
+/* characteristic properties allowing server initiated updates */
+constexpr uint8_t NOTIFY_OR_INDICATE = 0x10 | 0x20;
+/* NoInputNoOutput IO capability, leads to Just Works */
+constexpr uint8_t IO_CAPABILITY_NO_INPUT_NO_OUTPUT = 0x03;
+constexpr uint8_t MAX_ENCRYPTION_KEY_SIZE = 16;
+/* random static address of the peer */
+const uint8_t PEER_ADDRESS[6] = { 0x01, 0x00, 0x00, 0xEE, 0xFF, 0xC0 };
+}
+
+VirtualPeer::VirtualPeer(VirtualLink &link) :
+    _link(link),
+    _address(PEER_ADDRESS)
+{
+}
+
+void VirtualPeer::reset()
+{
+    _connectable = true;
+    _advertising_data.clear();
+    _attributes.clear();
+    _statistics = Statistics();
+    _written_cb = nullptr;
+    on_disconnected();
+}
+
+attribute_handle_t VirtualPeer::add_service(const UUID &uuid)
+{
+    attribute_handle_t handle = _attributes.size() + 1;
+    std::vector<uint8_t> value;
+    put_uuid(value, uuid);
+    _attributes.push_back({ handle, UUID(BLE_UUID_SERVICE_PRIMARY), std::move(value) });
+    return handle;
+}
+
+attribute_handle_t VirtualPeer::add_characteristic(
+    const UUID &uuid,
+    uint8_t properties,
+    std::vector<uint8_t> value
+)
+{
+    attribute_handle_t declaration_handle = _attributes.size() + 1;
+    attribute_handle_t value_handle = declaration_handle + 1;
+
+    std::vector<uint8_t> declaration { properties };
+    put_u16(declaration, value_handle);
+    put_uuid(declaration, uuid);
+
+    _attributes.push_back({ declaration_handle, UUID(BLE_UUID_CHARACTERISTIC), std::move(declaration) });
+    _attributes.push_back({ value_handle, uuid, std::move(value) });
+
+    if (properties & NOTIFY_OR_INDICATE) {
+        _attributes.push_back({
+            (attribute_handle_t) (value_handle + 1),
+            UUID(BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG),
+            { 0x00, 0x00 }
+        });
+    }
+
+    return value_handle;
+}
+
+const VirtualPeer::attribute_t *VirtualPeer::find(attribute_handle_t handle) const
+{
+    if (handle == 0 || handle > _attributes.size()) {
+        return nullptr;
+    }
+    return &_attributes[handle - 1];
+}
+
+VirtualPeer::attribute_t *VirtualPeer::find(attribute_handle_t handle)
+{
+    const VirtualPeer &self = *this;
+    return const_cast<attribute_t *>(self.find(handle));
+}
+
+bool VirtualPeer::notify(attribute_handle_t handle, std::vector<uint8_t> value)
+{
+    if (!_link.is_open()) {
+        return false;
+    }
+
+    std::vector<uint8_t> pdu { AttributeOpcode::HANDLE_VALUE_NOTIFICATION };
+    put_u16(pdu, handle);
+    value.resize(std::min<size_t>(value.size(), _att_mtu - 3));
+    pdu.insert(pdu.end(), value.begin(), value.end());
+    send(channel_t::ATT, std::move(pdu), [this]() { ++_statistics.notifications; });
+    return true;
+}
+
+void VirtualPeer::stream_notifications(attribute_handle_t handle, size_t size, uint32_t count, uint8_t window)
+{
+    _stream_handle = handle;
+    _stream_size = size;
+    _stream_remaining = count;
+    _stream_window = window;
+    pump_stream();
+}
+
+void VirtualPeer::pump_stream()
+{
+    while (_stream_remaining && (_stream_in_flight < _stream_window) && _link.is_open()) {
+        std::vector<uint8_t> pdu { AttributeOpcode::HANDLE_VALUE_NOTIFICATION };
+        put_u16(pdu, _stream_handle);
+        pdu.resize(pdu.size() + std::min<size_t>(_stream_size, _att_mtu - 3), (uint8_t) _stream_remaining);
+
+        --_stream_remaining;
+        ++_stream_in_flight;
+        send(channel_t::ATT, std::move(pdu), [this]() {
+            --_stream_in_flight;
+            ++_statistics.notifications;
+            pump_stream();
+        });
+    }
+}
+
+void VirtualPeer::disconnect(uint8_t reason)
+{
+    if (!_link.is_open()) {
+        return;
+    }
+    _link.close();
+    on_disconnected();
+    if (_disconnect_cb) {
+        _disconnect_cb(reason);
+    }
+}
+
+void VirtualPeer::on_connected()
+{
+    _att_mtu = 23;
+}
+
+void VirtualPeer::on_disconnected()
+{
+    _att_mtu = 23;
+    _stream_remaining = 0;
+    _stream_in_flight = 0;
+    _initiator_keys = 0;
+    _responder_keys = 0;
+    _pairing = false;
+}
+
+void VirtualPeer::on_sdu(channel_t channel, const std::vector<uint8_t> &pdu)
+{
+    if (pdu.empty()) {
+        return;
+    }
+
+    switch (channel) {
+        case channel_t::ATT:
+            on_att_request(pdu);
+            break;
+        case channel_t::SMP:
+            on_smp_command(pdu);
+            break;
+        case channel_t::LL_CONTROL:
+            on_ll_control(pdu);
+            break;
+    }
+}
+
+void VirtualPeer::on_att_request(const std::vector<uint8_t> &pdu)
+{
+    const uint8_t opcode = pdu[0];
+
+    if (opcode == AttributeOpcode::WRITE_COMMAND) {
+        if (pdu.size() < 3) {
+            return;
+        }
+        attribute_t *attribute = find(get_u16(&pdu[1]));
+        if (attribute) {
+            attribute->value.assign(pdu.begin() + 3, pdu.end());
+            if (_written_cb) {
+                _written_cb(attribute->handle, attribute->value);
+            }
+        }
+        ++_statistics.write_commands;
+        _statistics.bytes_written += pdu.size() - 3;
+        return;
+    }
+
+    ++_statistics.requests;
+
+    /* all the discovery requests start with a handle range */
+    attribute_handle_t start = 0;
+    attribute_handle_t end = 0;
+    if (pdu.size() >= 5) {
+        start = get_u16(&pdu[1]);
+        end = get_u16(&pdu[3]);
+    }
+
+    switch (opcode) {
+        case AttributeOpcode::EXCHANGE_MTU_REQUEST: {
+            if (pdu.size() != 3) {
+                send_error(opcode, 0, AttErrorResponse::INVALID_PDU);
+                return;
+            }
+            uint16_t server_mtu = _link.configuration().peer_att_mtu;
+            _att_mtu = std::max<uint16_t>(23, std::min(get_u16(&pdu[1]), server_mtu));
+
+            std::vector<uint8_t> response { AttributeOpcode::EXCHANGE_MTU_RESPONSE };
+            put_u16(response, server_mtu);
+            send(channel_t::ATT, std::move(response));
+            return;
+        }
+
+        case AttributeOpcode::FIND_INFORMATION_REQUEST: {
+            if (pdu.size() != 5 || start == 0 || start > end) {
+                send_error(opcode, start, AttErrorResponse::INVALID_HANDLE);
+                return;
+            }
+
+            /* format: 1 for 16-bit UUIDs, 2 for 128-bit UUIDs */
+            std::vector<uint8_t> response { AttributeOpcode::FIND_INFORMATION_RESPONSE, 0 };
+            for (const attribute_t &attribute : _attributes) {
+                if (attribute.handle < start || attribute.handle > end) {
+                    continue;
+                }
+                uint8_t format = attribute.type.shortOrLong() == UUID::UUID_TYPE_SHORT ? 1 : 2;
+                if (response[1] == 0) {
+                    response[1] = format;
+                } else if (response[1] != format) {
+                    break;
+                }
+                if (response.size() + 2 + attribute.type.getLen() > _att_mtu) {
+                    break;
+                }
+                put_u16(response, attribute.handle);
+                put_uuid(response, attribute.type);
+            }
+
+            if (response[1] == 0) {
+                send_error(opcode, start, AttErrorResponse::ATTRIBUTE_NOT_FOUND);
+                return;
+            }
+            send(channel_t::ATT, std::move(response));
+            return;
+        }
+
+        case AttributeOpcode::FIND_BY_TYPE_VALUE_REQUEST: {
+            if (pdu.size() < 7 || start == 0 || start > end) {
+                send_error(opcode, start, AttErrorResponse::INVALID_HANDLE);
+                return;
+            }
+            UUID type(get_u16(&pdu[5]));
+
+            std::vector<uint8_t> response { AttributeOpcode::FIND_BY_VALUE_TYPE_RESPONSE };
+            for (size_t i = 0; i < _attributes.size(); ++i) {
+                const attribute_t &attribute = _attributes[i];
+                if (attribute.handle < start || attribute.handle > end || !(attribute.type == type)) {
+                    continue;
+                }
+                if (!std::equal(pdu.begin() + 7, pdu.end(), attribute.value.begin(), attribute.value.end())) {
+                    continue;
+                }
+                if (response.size() + 4 > _att_mtu) {
+                    break;
+                }
+                put_u16(response, attribute.handle);
+                put_u16(response, group_end(i));
+            }
+
+            if (response.size() == 1) {
+                send_error(opcode, start, AttErrorResponse::ATTRIBUTE_NOT_FOUND);
+                return;
+            }
+            send(channel_t::ATT, std::move(response));
+            return;
+        }
+
+        case AttributeOpcode::READ_BY_TYPE_REQUEST:
+        case AttributeOpcode::READ_BY_GROUP_TYPE_REQUEST: {
+            if ((pdu.size() != 7 && pdu.size() != 21) || start == 0 || start > end) {
+                send_error(opcode, start, AttErrorResponse::INVALID_HANDLE);
+                return;
+            }
+            UUID type = get_uuid(&pdu[5], pdu.size() - 5);
+
+            const bool group = (opcode == AttributeOpcode::READ_BY_GROUP_TYPE_REQUEST);
+            if (group && !(type == UUID(BLE_UUID_SERVICE_PRIMARY))) {
+                send_error(opcode, start, AttErrorResponse::UNSUPPORTED_GROUP_TYPE);
+                return;
+            }
+
+            /* entries are (handle, [group end,] value) and must have the same length */
+            const size_t header_size = group ? 4 : 2;
+            std::vector<uint8_t> response {
+                group ? AttributeOpcode::READ_BY_GROUP_TYPE_RESPONSE : AttributeOpcode::READ_BY_TYPE_RESPONSE,
+                0
+            };
+            for (size_t i = 0; i < _attributes.size(); ++i) {
+                const attribute_t &attribute = _attributes[i];
+                if (attribute.handle < start || attribute.handle > end || !(attribute.type == type)) {
+                    continue;
+                }
+                size_t value_size = std::min<size_t>(attribute.value.size(), std::min(_att_mtu - 2 - header_size, (size_t) 255 - header_size));
+                if (response[1] == 0) {
+                    response[1] = header_size + value_size;
+                } else if (response[1] != header_size + value_size) {
+                    break;
+                }
+                if (response.size() + response[1] > _att_mtu) {
+                    break;
+                }
+                put_u16(response, attribute.handle);
+                if (group) {
+                    put_u16(response, group_end(i));
+                }
+                response.insert(response.end(), attribute.value.begin(), attribute.value.begin() + value_size);
+            }
+
+            if (response[1] == 0) {
+                send_error(opcode, start, AttErrorResponse::ATTRIBUTE_NOT_FOUND);
+                return;
+            }
+            send(channel_t::ATT, std::move(response));
+            return;
+        }
+
+        case AttributeOpcode::READ_REQUEST:
+        case AttributeOpcode::READ_BLOB_REQUEST: {
+            const bool blob = (opcode == AttributeOpcode::READ_BLOB_REQUEST);
+            if (pdu.size() != (blob ? 5 : 3)) {
+                send_error(opcode, 0, AttErrorResponse::INVALID_PDU);
+                return;
+            }
+            attribute_handle_t handle = get_u16(&pdu[1]);
+            const attribute_t *attribute = find(handle);
+            if (!attribute) {
+                send_error(opcode, handle, AttErrorResponse::INVALID_HANDLE);
+                return;
+            }
+            size_t offset = blob ? get_u16(&pdu[3]) : 0;
+            if (offset > attribute->value.size()) {
+                send_error(opcode, handle, AttErrorResponse::INVALID_OFFSET);
+                return;
+            }
+            size_t length = std::min<size_t>(attribute->value.size() - offset, _att_mtu - 1);
+
+            std::vector<uint8_t> response {
+                blob ? AttributeOpcode::READ_BLOB_RESPONSE : AttributeOpcode::READ_RESPONSE
+            };
+            response.insert(
+                response.end(),
+                attribute->value.begin() + offset,
+                attribute->value.begin() + offset + length
+            );
+            send(channel_t::ATT, std::move(response));
+            return;
+        }
+
+        case AttributeOpcode::WRITE_REQUEST: {
+            if (pdu.size() < 3) {
+                send_error(opcode, 0, AttErrorResponse::INVALID_PDU);
+                return;
+            }
+            attribute_handle_t handle = get_u16(&pdu[1]);
+            attribute_t *attribute = find(handle);
+            if (!attribute) {
+                send_error(opcode, handle, AttErrorResponse::INVALID_HANDLE);
+                return;
+            }
+            attribute->value.assign(pdu.begin() + 3, pdu.end());
+            _statistics.bytes_written += pdu.size() - 3;
+            if (_written_cb) {
+                _written_cb(handle, attribute->value);
+            }
+            send(channel_t::ATT, { AttributeOpcode::WRITE_RESPONSE });
+            return;
+        }
+
+        default:
+            send_error(opcode, 0, AttErrorResponse::REQUEST_NOT_SUPPORTED);
+            return;
+    }
+}
+
+void VirtualPeer::on_smp_command(const std::vector<uint8_t> &pdu)
+{
+    switch (pdu[0]) {
+        case smp::PAIRING_REQUEST: {
+            if (pdu.size() != 7) {
+                send(channel_t::SMP, { smp::PAIRING_FAILED, pairing_failure_t::INVALID_PARAMETERS });
+                return;
+            }
+            /* the peer can distribute and accept encryption and identity keys */
+            _pairing = true;
+            _initiator_keys = pdu[5] & (ENC_KEY | ID_KEY);
+            _responder_keys = pdu[6] & (ENC_KEY | ID_KEY);
+            send(channel_t::SMP, {
+                smp::PAIRING_RESPONSE,
+                IO_CAPABILITY_NO_INPUT_NO_OUTPUT,
+                0x00, /* no OOB data */
+                (uint8_t) (pdu[3] & 0x01), /* bonding, no MITM, no secure connections */
+                MAX_ENCRYPTION_KEY_SIZE,
+                _initiator_keys,
+                _responder_keys
+            });
+            return;
+        }
+
+        case smp::PAIRING_CONFIRM:
+        case smp::PAIRING_RANDOM: {
+            std::vector<uint8_t> response { pdu[0] };
+            put_random(response, 16);
+            send(channel_t::SMP, std::move(response));
+            return;
+        }
+
+        case smp::CENTRAL_IDENTIFICATION:
+            _initiator_keys &= ~ENC_KEY;
+            break;
+
+        case smp::IDENTITY_ADDRESS_INFORMATION:
+            _initiator_keys &= ~ID_KEY;
+            break;
+
+        default:
+            return;
+    }
+
+    if (_pairing && !_initiator_keys) {
+        _pairing = false;
+        ++_statistics.pairings;
+    }
+}
+
+void VirtualPeer::on_ll_control(const std::vector<uint8_t> &pdu)
+{
+    switch (pdu[0]) {
+        case ll::ENC_REQ: {
+            /* SKDs and IVs */
+            std::vector<uint8_t> response { ll::ENC_RSP };
+            put_random(response, 12);
+            send(channel_t::LL_CONTROL, std::move(response));
+            send(channel_t::LL_CONTROL, { ll::START_ENC_REQ });
+            return;
+        }
+
+        case ll::START_ENC_RSP:
+            send(channel_t::LL_CONTROL, { ll::START_ENC_RSP });
+            if (_pairing) {
+                distribute_keys();
+            }
+            return;
+
+        default:
+            return;
+    }
+}
+
+void VirtualPeer::distribute_keys()
+{
+    if (_responder_keys & ENC_KEY) {
+        std::vector<uint8_t> ltk { smp::ENCRYPTION_INFORMATION };
+        put_random(ltk, 16);
+        send(channel_t::SMP, std::move(ltk));
+
+        std::vector<uint8_t> identification { smp::CENTRAL_IDENTIFICATION };
+        put_random(identification, 2 + 8);
+        send(channel_t::SMP, std::move(identification));
+    }
+
+    if (_responder_keys & ID_KEY) {
+        std::vector<uint8_t> irk { smp::IDENTITY_INFORMATION };
+        put_random(irk, 16);
+        send(channel_t::SMP, std::move(irk));
+
+        std::vector<uint8_t> identity_address { smp::IDENTITY_ADDRESS_INFORMATION, 0x01 /* random static */ };
+        identity_address.insert(identity_address.end(), _address.data(), _address.data() + _address.size());
+        send(channel_t::SMP, std::move(identity_address));
+    }
+
+    if (!_initiator_keys) {
+        _pairing = false;
+        ++_statistics.pairings;
+    }
+}
+
+void VirtualPeer::send(channel_t channel, std::vector<uint8_t> pdu, VirtualLink::sent_handler_t on_sent)
+{
+    _link.send(VirtualLink::TO_LOCAL, channel, std::move(pdu), std::move(on_sent));
+}
+
+void VirtualPeer::send_error(uint8_t opcode, attribute_handle_t handle, uint8_t error)
+{
+    std::vector<uint8_t> response { AttributeOpcode::ERROR_RESPONSE, opcode };
+    put_u16(response, handle);
+    response.push_back(error);
+    send(channel_t::ATT, std::move(response));
+}
+
+void VirtualPeer::put_random(std::vector<uint8_t> &pdu, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        pdu.push_back((uint8_t) _link.random(256));
+    }
+}
+
+attribute_handle_t VirtualPeer::group_end(size_t index) const
+{
+    for (size_t i = index + 1; i < _attributes.size(); ++i) {
+        if (_attributes[i].type == UUID(BLE_UUID_SERVICE_PRIMARY)) {
+            return _attributes[i].handle - 1;
+        }
+    }
+    return 0xFFFF;
+}
+
+} // namespace virtual_pal
+} // namespace ble
@@ -0,0 +1,206 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_VIRTUAL_PEER_H_
+#define BLE_VIRTUAL_PAL_VIRTUAL_PEER_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ble/common/BLETypes.h"
+#include "ble/common/UUID.h"
+
+#include "VirtualLink.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Scripted remote device at the other end of the virtual link.
+ *
+ * The peer advertises, accepts connections as a peripheral, runs a GATT
+ * server over its own attribute table and answers legacy Just Works pairing.
+ * It has no host stack of its own: the generic BLE layer runs once per
+ * process as it is reached through BLE::Instance().
+ */
+class VirtualPeer {
+public:
+    struct attribute_t {
+        attribute_handle_t handle;
+        UUID type;
+        std::vector<uint8_t> value;
+    };
+
+    struct Statistics {
+        uint32_t requests = 0;
+        uint32_t write_commands = 0;
+        uint64_t bytes_written = 0;
+        uint32_t notifications = 0;
+        uint32_t pairings = 0;
+    };
+
+    explicit VirtualPeer(VirtualLink &link);
+    VirtualPeer(const VirtualPeer&) = delete;
+    VirtualPeer& operator=(const VirtualPeer&) = delete;
+
+    /** Clear the attribute table, the advertising payload and the counters. */
+    void reset();
+
+    /* identity and advertising */
+
+    const address_t &address() const
+    {
+        return _address;
+    }
+
+    void set_advertising_data(std::vector<uint8_t> data)
+    {
+        _advertising_data = std::move(data);
+    }
+
+    const std::vector<uint8_t> &advertising_data() const
+    {
+        return _advertising_data;
+    }
+
+    void set_connectable(bool connectable)
+    {
+        _connectable = connectable;
+    }
+
+    bool is_connectable() const
+    {
+        return _connectable;
+    }
+
+    /* attribute table */
+
+    /** Add a primary service declaration and return its handle. */
+    attribute_handle_t add_service(const UUID &uuid);
+
+    /**
+     * Add a characteristic to the last service and return the handle of its
+     * value. A client characteristic configuration descriptor is added when
+     * properties allow notifications or indications.
+     */
+    attribute_handle_t add_characteristic(
+        const UUID &uuid,
+        uint8_t properties,
+        std::vector<uint8_t> value
+    );
+
+    const std::vector<attribute_t> &attributes() const
+    {
+        return _attributes;
+    }
+
+    const attribute_t *find(attribute_handle_t handle) const;
+
+    /* data path */
+
+    /** Queue a notification; return false if the link is closed. */
+    bool notify(attribute_handle_t handle, std::vector<uint8_t> value);
+
+    /**
+     * Send count notifications of size bytes (truncated to the ATT MTU),
+     * keeping window notifications queued on the link.
+     */
+    void stream_notifications(attribute_handle_t handle, size_t size, uint32_t count, uint8_t window);
+
+    /** Terminate the connection from the peer side. */
+    void disconnect(uint8_t reason);
+
+    /** Register the handler invoked when the peer terminates the connection. */
+    void when_disconnect_requested(std::function<void(uint8_t)> cb)
+    {
+        _disconnect_cb = std::move(cb);
+    }
+
+    /** Register the handler invoked when the local device writes an attribute. */
+    void when_written(std::function<void(attribute_handle_t, const std::vector<uint8_t>&)> cb)
+    {
+        _written_cb = std::move(cb);
+    }
+
+    /** Called when a connection with the local device is established or closed. */
+    void on_connected();
+    void on_disconnected();
+
+    uint16_t att_mtu() const
+    {
+        return _att_mtu;
+    }
+
+    const Statistics &statistics() const
+    {
+        return _statistics;
+    }
+
+    /** Handle an SDU sent by the local device. */
+    void on_sdu(channel_t channel, const std::vector<uint8_t> &pdu);
+
+private:
+    void on_att_request(const std::vector<uint8_t> &pdu);
+
+    void on_smp_command(const std::vector<uint8_t> &pdu);
+
+    void on_ll_control(const std::vector<uint8_t> &pdu);
+
+    void distribute_keys();
+
+    void send(channel_t channel, std::vector<uint8_t> pdu, VirtualLink::sent_handler_t on_sent = nullptr);
+
+    void send_error(uint8_t opcode, attribute_handle_t handle, uint8_t error);
+
+    void put_random(std::vector<uint8_t> &pdu, size_t count);
+
+    void pump_stream();
+
+    attribute_handle_t group_end(size_t index) const;
+
+    attribute_t *find(attribute_handle_t handle);
+
+    VirtualLink &_link;
+
+    address_t _address;
+    bool _connectable = true;
+    std::vector<uint8_t> _advertising_data;
+    std::vector<attribute_t> _attributes;
+    uint16_t _att_mtu = 23;
+
+    /* notification stream */
+    attribute_handle_t _stream_handle = 0;
+    size_t _stream_size = 0;
+    uint32_t _stream_remaining = 0;
+    uint8_t _stream_window = 0;
+    uint8_t _stream_in_flight = 0;
+
+    /* pairing */
+    bool _pairing = false;
+    uint8_t _initiator_keys = 0;
+    uint8_t _responder_keys = 0;
+
+    std::function<void(uint8_t)> _disconnect_cb;
+    std::function<void(attribute_handle_t, const std::vector<uint8_t>&)> _written_cb;
+    Statistics _statistics;
+};
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_VIRTUAL_PEER_H_ */
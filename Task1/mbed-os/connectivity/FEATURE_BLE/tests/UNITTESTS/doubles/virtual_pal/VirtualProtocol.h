@@ -0,0 +1,93 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_VIRTUAL_PROTOCOL_H_
+#define BLE_VIRTUAL_PAL_VIRTUAL_PROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ble/common/UUID.h"
+
+namespace ble {
+namespace virtual_pal {
+
+/**
+ * Security manager protocol commands.
+ * @see BLUETOOTH SPECIFICATION Version 5.0 | Vol 3, Part H - 3.3
+ */
+namespace smp {
+enum : uint8_t {
+    PAIRING_REQUEST = 0x01,
+    PAIRING_RESPONSE = 0x02,
+    PAIRING_CONFIRM = 0x03,
+    PAIRING_RANDOM = 0x04,
+    PAIRING_FAILED = 0x05,
+    ENCRYPTION_INFORMATION = 0x06,
+    CENTRAL_IDENTIFICATION = 0x07,
+    IDENTITY_INFORMATION = 0x08,
+    IDENTITY_ADDRESS_INFORMATION = 0x09,
+    SECURITY_REQUEST = 0x0B
+};
+}
+
+/**
+ * Link layer control PDUs of the encryption procedure.
+ * @see BLUETOOTH SPECIFICATION Version 5.0 | Vol 6, Part B - 2.4.2
+ */
+namespace ll {
+enum : uint8_t {
+    ENC_REQ = 0x03,
+    ENC_RSP = 0x04,
+    START_ENC_REQ = 0x05,
+    START_ENC_RSP = 0x06
+};
+}
+
+/** Append a little endian 16-bit value to a PDU. */
+inline void put_u16(std::vector<uint8_t> &pdu, uint16_t value)
+{
+    pdu.push_back(value & 0xFF);
+    pdu.push_back(value >> 8);
+}
+
+/** Read a little endian 16-bit value from a PDU. */
+inline uint16_t get_u16(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+/** Append a UUID, in the little endian order used over the air, to a PDU. */
+inline void put_uuid(std::vector<uint8_t> &pdu, const UUID &uuid)
+{
+    pdu.insert(pdu.end(), uuid.getBaseUUID(), uuid.getBaseUUID() + uuid.getLen());
+}
+
+/** Read a 16-bit or 128-bit UUID from a PDU. */
+inline UUID get_uuid(const uint8_t *data, size_t size)
+{
+    if (size == sizeof(UUID::ShortUUIDBytes_t)) {
+        return UUID(get_u16(data));
+    }
+    return UUID(data, UUID::LSB);
+}
+
+} // namespace virtual_pal
+} // namespace ble
+
+#endif /* BLE_VIRTUAL_PAL_VIRTUAL_PROTOCOL_H_ */
@@ -0,0 +1,101 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_DRIVERS_TIMEOUT_H_
+#define BLE_VIRTUAL_PAL_DRIVERS_TIMEOUT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "platform/Callback.h"
+
+#include "VirtualEnvironment.h"
+
+namespace mbed {
+
+/**
+ * Timeout expiring in the simulated time of the virtual environment.
+ *
+ * It shadows the driver used by the generic BLE layer so host timers (the
+ * connection event producer fallback, advertising and scan timeouts) run
+ * alongside the virtual controller.
+ */
+class Timeout {
+public:
+    Timeout() :
+        _state(std::make_shared<State>())
+    {
+    }
+
+    Timeout(const Timeout &) = delete;
+    Timeout &operator=(const Timeout &) = delete;
+
+    ~Timeout()
+    {
+        detach();
+    }
+
+    template <typename F>
+    void attach(F &&func, std::chrono::microseconds t)
+    {
+        ble::virtual_pal::Simulator &simulator = ble::virtual_pal::VirtualEnvironment::instance().simulator();
+
+        _state->callback = std::forward<F>(func);
+        _state->deadline = simulator.now() + t;
+        _state->attached = true;
+        const uint32_t generation = ++_state->generation;
+
+        /* the state outlives the timeout; a stale event finds it detached */
+        std::shared_ptr<State> state = _state;
+        simulator.post_in(t, [state, generation]() {
+            if (!state->attached || state->generation != generation) {
+                return;
+            }
+            state->attached = false;
+            state->callback();
+        });
+    }
+
+    void detach()
+    {
+        _state->attached = false;
+        ++_state->generation;
+    }
+
+    std::chrono::microseconds remaining_time() const
+    {
+        if (!_state->attached) {
+            return std::chrono::microseconds(0);
+        }
+        return _state->deadline - ble::virtual_pal::VirtualEnvironment::instance().simulator().now();
+    }
+
+private:
+    struct State {
+        Callback<void()> callback;
+        std::chrono::microseconds deadline{0};
+        uint32_t generation = 0;
+        bool attached = false;
+    };
+
+    std::shared_ptr<State> _state;
+};
+
+} // namespace mbed
+
+#endif // BLE_VIRTUAL_PAL_DRIVERS_TIMEOUT_H_
@@ -0,0 +1,72 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2021 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BLE_VIRTUAL_PAL_DRIVERS_TIMER_H_
+#define BLE_VIRTUAL_PAL_DRIVERS_TIMER_H_
+
+#include <chrono>
+
+#include "VirtualEnvironment.h"
+
+namespace mbed {
+
+/**
+ * Timer measuring the simulated time of the virtual environment.
+ */
+class Timer {
+public:
+    void start()
+    {
+        if (!_running) {
+            _start = now();
+            _running = true;
+        }
+    }
+
+    void stop()
+    {
+        if (_running) {
+            _elapsed += now() - _start;
+            _running = false;
+        }
+    }
+
+    void reset()
+    {
+        _start = now();
+        _elapsed = std::chrono::microseconds(0);
+    }
+
+    std::chrono::microseconds elapsed_time() const
+    {
+        return _running ? _elapsed + (now() - _start) : _elapsed;
+    }
+
+private:
+    static std::chrono::microseconds now()
+    {
+        return ble::virtual_pal::VirtualEnvironment::instance().simulator().now();
+    }
+
+    std::chrono::microseconds _start{0};
+    std::chrono::microseconds _elapsed{0};
+    bool _running = false;
+};
+
+} // namespace mbed
+
+#endif // BLE_VIRTUAL_PAL_DRIVERS_TIMER_H_
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ble/BLE.h"
+#include "ble/Gap.h"
+#include "ble/gap/AdvertisingDataTemplate.h"
+#include "ble/gap/AdvertisingParameters.h"
+
+#include "VirtualEnvironment.h"
+
+using namespace ble;
+using namespace ble::virtual_pal;
+
+namespace {
+
+/* AD field of the given type carrying size bytes of data, all equal to fill */
+void append_field(std::vector<uint8_t> &payload, adv_data_type_t type, size_t size, uint8_t fill = 0)
+{
+    payload.push_back(size + 1);
+    payload.push_back(type.value());
+    payload.insert(payload.end(), size, fill);
+}
+
+/* flags and up to 8 bytes of manufacturer data, padded with zeros to size bytes */
+std::vector<uint8_t> make_payload(size_t size)
+{
+    std::vector<uint8_t> payload;
+    append_field(payload, adv_data_type_t::FLAGS, 1, 0x06);
+    append_field(payload, adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, std::min<size_t>(size - 5, 8));
+    payload.resize(size, 0);
+    return payload;
+}
+
+mbed::Span<uint8_t> span(std::vector<uint8_t> &payload)
+{
+    return mbed::make_Span(payload.data(), payload.size());
+}
+
+}
+
+TEST(AdvertisingDataTemplate, get_field_locates_value)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    AdvertisingDataTemplate data(span(payload));
+
+    AdvertisingDataTemplate::field_t field;
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 2, 3));
+    /* flags field, then length and type of the manufacturer data */
+    EXPECT_EQ(3 + 2 + 2, field.offset);
+    EXPECT_EQ(3, field.size);
+
+    /* size 0 selects the rest of the field data */
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 2));
+    EXPECT_EQ(3 + 2 + 2, field.offset);
+    EXPECT_EQ(5, field.size);
+
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::FLAGS, field));
+    EXPECT_EQ(2, field.offset);
+    EXPECT_EQ(1, field.size);
+}
+
+TEST(AdvertisingDataTemplate, get_field_not_found)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    AdvertisingDataTemplate data(span(payload));
+
+    AdvertisingDataTemplate::field_t field;
+    EXPECT_EQ(BLE_ERROR_NOT_FOUND, data.getField(adv_data_type_t::COMPLETE_LOCAL_NAME, field));
+
+    AdvertisingDataTemplate empty(mbed::Span<uint8_t>{});
+    EXPECT_EQ(BLE_ERROR_NOT_FOUND, empty.getField(adv_data_type_t::FLAGS, field));
+}
+
+TEST(AdvertisingDataTemplate, get_field_stops_at_zero_length_terminator)
+{
+    std::vector<uint8_t> payload;
+    append_field(payload, adv_data_type_t::FLAGS, 1, 0x06);
+    payload.push_back(0);
+    append_field(payload, adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, 4);
+    AdvertisingDataTemplate data(span(payload));
+
+    AdvertisingDataTemplate::field_t field;
+    EXPECT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::FLAGS, field));
+    EXPECT_EQ(BLE_ERROR_NOT_FOUND, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field));
+}
+
+TEST(AdvertisingDataTemplate, get_field_rejects_truncated_field)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    /* the manufacturer data claims one byte more than the payload holds */
+    payload.pop_back();
+    AdvertisingDataTemplate data(span(payload));
+
+    AdvertisingDataTemplate::field_t field;
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 0, 1));
+
+    /* a payload cut in the middle of a field header has no such field */
+    std::vector<uint8_t> header_only;
+    append_field(header_only, adv_data_type_t::FLAGS, 1, 0x06);
+    header_only.push_back(5);
+    AdvertisingDataTemplate cut(span(header_only));
+    EXPECT_EQ(BLE_ERROR_NOT_FOUND, cut.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field));
+}
+
+TEST(AdvertisingDataTemplate, get_field_checks_value_bounds)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    AdvertisingDataTemplate data(span(payload));
+    const adv_data_type_t type = adv_data_type_t::MANUFACTURER_SPECIFIC_DATA;
+
+    AdvertisingDataTemplate::field_t field;
+    /* the field carries 7 bytes of data */
+    EXPECT_EQ(BLE_ERROR_NONE, data.getField(type, field, 0, 7));
+    EXPECT_EQ(BLE_ERROR_NONE, data.getField(type, field, 6, 1));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.getField(type, field, 0, 8));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.getField(type, field, 6, 2));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.getField(type, field, 8, 1));
+    /* nothing left after the end of the data */
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.getField(type, field, 7));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.getField(type, field, 255, 255));
+}
+
+TEST(AdvertisingDataTemplate, get_field_beyond_255_bytes)
+{
+    std::vector<uint8_t> payload;
+    append_field(payload, adv_data_type_t::FLAGS, 1, 0x06);
+    append_field(payload, adv_data_type_t::COMPLETE_LOCAL_NAME, 250, 'a');
+    append_field(payload, adv_data_type_t::SERVICE_DATA, 100);
+    append_field(payload, adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, 4);
+    AdvertisingDataTemplate data(span(payload));
+
+    AdvertisingDataTemplate::field_t field;
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 2, 2));
+    EXPECT_EQ(payload.size() - 2, field.offset);
+
+    ASSERT_EQ(BLE_ERROR_NONE, data.update(field, 0xABCD));
+    EXPECT_EQ(0xCD, payload[payload.size() - 2]);
+    EXPECT_EQ(0xAB, payload[payload.size() - 1]);
+}
+
+TEST(AdvertisingDataTemplate, update_tracks_modification)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    AdvertisingDataTemplate data(span(payload));
+    EXPECT_TRUE(data.isModified());
+    data.clearModified();
+
+    AdvertisingDataTemplate::field_t field;
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 2, 2));
+
+    /* same value, nothing to send */
+    const uint8_t zero[] = { 0, 0 };
+    EXPECT_EQ(BLE_ERROR_NONE, data.update(field, zero));
+    EXPECT_FALSE(data.isModified());
+
+    const uint8_t value[] = { 1, 2 };
+    EXPECT_EQ(BLE_ERROR_NONE, data.update(field, value));
+    EXPECT_TRUE(data.isModified());
+    EXPECT_EQ(1, payload[field.offset]);
+    EXPECT_EQ(2, payload[field.offset + 1]);
+    /* the bytes around the value are untouched */
+    EXPECT_EQ(0, payload[field.offset - 1]);
+    EXPECT_EQ(0, payload[field.offset + 2]);
+}
+
+TEST(AdvertisingDataTemplate, update_checks_size_and_bounds)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    const std::vector<uint8_t> original = payload;
+    AdvertisingDataTemplate data(span(payload));
+    data.clearModified();
+
+    AdvertisingDataTemplate::field_t field;
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 2, 2));
+
+    const uint8_t too_large[] = { 1, 2, 3 };
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.update(field, too_large));
+
+    AdvertisingDataTemplate::field_t outside = { 11, 2 };
+    const uint8_t value[] = { 1, 2 };
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.update(outside, value));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.update(outside, 0x0102));
+
+    AdvertisingDataTemplate::field_t wide;
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, wide, 0, 5));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, data.update(wide, 1));
+
+    EXPECT_FALSE(data.isModified());
+    EXPECT_EQ(original, payload);
+}
+
+TEST(AdvertisingDataTemplate, update_integer_is_little_endian)
+{
+    std::vector<uint8_t> payload = make_payload(12);
+    AdvertisingDataTemplate data(span(payload));
+
+    AdvertisingDataTemplate::field_t field;
+    ASSERT_EQ(BLE_ERROR_NONE, data.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, field, 0, 3));
+    ASSERT_EQ(BLE_ERROR_NONE, data.update(field, 0x11223344));
+    EXPECT_EQ(0x44, payload[field.offset]);
+    EXPECT_EQ(0x33, payload[field.offset + 1]);
+    EXPECT_EQ(0x22, payload[field.offset + 2]);
+    /* truncated to the size of the field */
+    EXPECT_EQ(0, payload[field.offset + 3]);
+}
+
+/*
+ * Template updates pushed through Gap to extended and periodic advertising
+ * sets of the virtual controller.
+ */
+class TestAdvertisingDataTemplateUpdate : public testing::Test, public Gap::EventHandler {
+protected:
+    static void SetUpTestCase()
+    {
+        BLE::Instance().init(&TestAdvertisingDataTemplateUpdate::on_init);
+        environment().simulator().run_until([]() { return initialized; }, 1s);
+    }
+
+    static void TearDownTestCase()
+    {
+        BLE::Instance().shutdown();
+    }
+
+    void SetUp() override
+    {
+        /* the environment is not reset: it would drop the events Gap posted
+         * to itself when the previous set stopped */
+        ASSERT_TRUE(initialized);
+        gap().setEventHandler(this);
+    }
+
+    void TearDown() override
+    {
+        if (handle != INVALID_ADVERTISING_HANDLE) {
+            if (gap().isPeriodicAdvertisingActive(handle)) {
+                gap().stopPeriodicAdvertising(handle);
+            }
+            if (gap().isAdvertisingActive(handle)) {
+                EXPECT_EQ(BLE_ERROR_NONE, gap().stopAdvertising(handle));
+                simulator().run_until([this]() { return !gap().isAdvertisingActive(handle); }, 1s);
+            }
+            EXPECT_EQ(BLE_ERROR_NONE, gap().destroyAdvertisingSet(handle));
+        }
+        gap().setEventHandler(nullptr);
+    }
+
+    static VirtualEnvironment &environment()
+    {
+        return VirtualEnvironment::instance();
+    }
+
+    static Simulator &simulator()
+    {
+        return environment().simulator();
+    }
+
+    static Gap &gap()
+    {
+        return BLE::Instance().gap();
+    }
+
+    static VirtualEnvironment::ControllerStatistics &controller()
+    {
+        return environment().controller_statistics();
+    }
+
+    void create_set(advertising_type_t type)
+    {
+        ASSERT_TRUE(gap().isFeatureSupported(controller_supported_features_t::LE_EXTENDED_ADVERTISING));
+        AdvertisingParameters parameters(type);
+        parameters.setUseLegacyPDU(false);
+        ASSERT_EQ(BLE_ERROR_NONE, gap().createAdvertisingSet(&handle, parameters));
+    }
+
+    void start_set()
+    {
+        ASSERT_EQ(BLE_ERROR_NONE, gap().startAdvertising(handle));
+        ASSERT_TRUE(simulator().run_until([this]() { return gap().isAdvertisingActive(handle); }, 1s));
+    }
+
+    void onAdvertisingStart(const AdvertisingStartEvent &event) override
+    {
+        ++advertising_starts;
+    }
+
+    static void on_init(BLE::InitializationCompleteCallbackContext *context)
+    {
+        initialized = (context->error == BLE_ERROR_NONE);
+    }
+
+    static bool initialized;
+    advertising_handle_t handle = INVALID_ADVERTISING_HANDLE;
+    uint32_t advertising_starts = 0;
+};
+
+bool TestAdvertisingDataTemplateUpdate::initialized = false;
+
+TEST_F(TestAdvertisingDataTemplateUpdate, active_set_gets_complete_fragment)
+{
+    create_set(advertising_type_t::NON_CONNECTABLE_UNDIRECTED);
+
+    std::vector<uint8_t> buffer = make_payload(100);
+    AdvertisingDataTemplate payload(span(buffer));
+    AdvertisingDataTemplate::field_t value;
+    ASSERT_EQ(BLE_ERROR_NONE, payload.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, value, 2, 2));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingPayload(handle, payload));
+    start_set();
+
+    controller() = VirtualEnvironment::ControllerStatistics();
+    ASSERT_EQ(BLE_ERROR_NONE, payload.update(value, 0x1234));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingPayload(handle, payload));
+
+    EXPECT_EQ(1u, controller().advertising_data);
+    EXPECT_EQ(1u, controller().complete_fragments);
+    EXPECT_EQ(0u, controller().partial_fragments);
+    EXPECT_FALSE(payload.isModified());
+
+    /* the set keeps advertising */
+    simulator().run_for(100ms);
+    EXPECT_TRUE(gap().isAdvertisingActive(handle));
+    EXPECT_EQ(0u, controller().advertising_disables);
+    EXPECT_EQ(0u, controller().advertising_enables);
+    EXPECT_EQ(1u, advertising_starts);
+
+    /* unmodified payloads are not sent */
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingPayload(handle, payload));
+    EXPECT_EQ(1u, controller().advertising_data);
+}
+
+TEST_F(TestAdvertisingDataTemplateUpdate, active_set_gets_complete_scan_response)
+{
+    create_set(advertising_type_t::SCANNABLE_UNDIRECTED);
+
+    std::vector<uint8_t> buffer = make_payload(100);
+    AdvertisingDataTemplate response(span(buffer));
+    AdvertisingDataTemplate::field_t value;
+    ASSERT_EQ(BLE_ERROR_NONE, response.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, value, 0, 4));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingScanResponse(handle, response));
+    start_set();
+
+    controller() = VirtualEnvironment::ControllerStatistics();
+    ASSERT_EQ(BLE_ERROR_NONE, response.update(value, 42));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingScanResponse(handle, response));
+
+    EXPECT_EQ(1u, controller().scan_response_data);
+    EXPECT_EQ(1u, controller().complete_fragments);
+    EXPECT_EQ(0u, controller().partial_fragments);
+    EXPECT_TRUE(gap().isAdvertisingActive(handle));
+}
+
+TEST_F(TestAdvertisingDataTemplateUpdate, oversize_payload_falls_back_to_fragments)
+{
+    create_set(advertising_type_t::NON_CONNECTABLE_UNDIRECTED);
+
+    /* two HCI commands */
+    std::vector<uint8_t> buffer = make_payload(400);
+    AdvertisingDataTemplate payload(span(buffer));
+    AdvertisingDataTemplate::field_t value;
+    ASSERT_EQ(BLE_ERROR_NONE, payload.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, value, 0, 2));
+
+    controller() = VirtualEnvironment::ControllerStatistics();
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingPayload(handle, payload));
+    EXPECT_EQ(2u, controller().advertising_data);
+    EXPECT_EQ(0u, controller().complete_fragments);
+    EXPECT_EQ(2u, controller().partial_fragments);
+    EXPECT_FALSE(payload.isModified());
+
+    /* an active set cannot take a fragmented payload; the update is kept */
+    start_set();
+    controller() = VirtualEnvironment::ControllerStatistics();
+    ASSERT_EQ(BLE_ERROR_NONE, payload.update(value, 7));
+    EXPECT_EQ(BLE_ERROR_INVALID_PARAM, gap().updateAdvertisingPayload(handle, payload));
+    EXPECT_EQ(0u, controller().advertising_data);
+    EXPECT_TRUE(payload.isModified());
+    EXPECT_TRUE(gap().isAdvertisingActive(handle));
+}
+
+TEST_F(TestAdvertisingDataTemplateUpdate, periodic_set_gets_complete_fragment)
+{
+    create_set(advertising_type_t::NON_CONNECTABLE_UNDIRECTED);
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setPeriodicAdvertisingParameters(
+        handle,
+        periodic_interval_t(80),
+        periodic_interval_t(160)
+    ));
+
+    std::vector<uint8_t> buffer = make_payload(240);
+    AdvertisingDataTemplate payload(span(buffer));
+    AdvertisingDataTemplate::field_t value;
+    ASSERT_EQ(BLE_ERROR_NONE, payload.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, value, 0, 2));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updatePeriodicAdvertisingPayload(handle, payload));
+    start_set();
+    ASSERT_EQ(BLE_ERROR_NONE, gap().startPeriodicAdvertising(handle));
+
+    controller() = VirtualEnvironment::ControllerStatistics();
+    for (uint16_t i = 1; i <= 10; ++i) {
+        ASSERT_EQ(BLE_ERROR_NONE, payload.update(value, i));
+        ASSERT_EQ(BLE_ERROR_NONE, gap().updatePeriodicAdvertisingPayload(handle, payload));
+    }
+
+    EXPECT_EQ(10u, controller().periodic_advertising_data);
+    EXPECT_EQ(10u, controller().complete_fragments);
+    EXPECT_EQ(0u, controller().partial_fragments);
+    EXPECT_TRUE(gap().isPeriodicAdvertisingActive(handle));
+}
+
+TEST_F(TestAdvertisingDataTemplateUpdate, oversize_periodic_payload_falls_back_to_fragments)
+{
+    create_set(advertising_type_t::NON_CONNECTABLE_UNDIRECTED);
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setPeriodicAdvertisingParameters(
+        handle,
+        periodic_interval_t(80),
+        periodic_interval_t(160)
+    ));
+
+    /* three HCI commands */
+    std::vector<uint8_t> buffer = make_payload(600);
+    AdvertisingDataTemplate payload(span(buffer));
+
+    controller() = VirtualEnvironment::ControllerStatistics();
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updatePeriodicAdvertisingPayload(handle, payload));
+    EXPECT_EQ(3u, controller().periodic_advertising_data);
+    EXPECT_EQ(0u, controller().complete_fragments);
+    EXPECT_EQ(3u, controller().partial_fragments);
+    EXPECT_FALSE(payload.isModified());
+}
@@ -0,0 +1,747 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "ble/BLE.h"
+#include "ble/Gap.h"
+#include "ble/GattClient.h"
+#include "ble/SecurityManager.h"
+#include "ble/gatt/BulkTransfer.h"
+
+#include "VirtualEnvironment.h"
+
+using namespace ble;
+using namespace ble::virtual_pal;
+
+namespace {
+
+/* characteristic properties */
+constexpr uint8_t PROPERTY_READ = 0x02;
+constexpr uint8_t PROPERTY_WRITE_WITHOUT_RESPONSE = 0x04;
+constexpr uint8_t PROPERTY_NOTIFY = 0x10;
+
+/*
+ * Observer of the events raised by the generic layer.
+ *
+ * Callbacks registered on the GattClient call chains cannot be removed in
+ * bulk; they are registered once for the whole test case and the counters
+ * are cleared by each test.
+ */
+struct Observer :
+    public Gap::EventHandler,
+    public GattClient::EventHandler,
+    public SecurityManager::EventHandler,
+    public BulkTransfer::EventHandler {
+
+    void clear()
+    {
+        *this = Observer();
+    }
+
+    void onConnectionComplete(const ConnectionCompleteEvent &event) override
+    {
+        connected = (event.getStatus() == BLE_ERROR_NONE);
+        handle = event.getConnectionHandle();
+    }
+
+    void onDisconnectionComplete(const DisconnectionCompleteEvent &event) override
+    {
+        connected = false;
+        if (bulk) {
+            bulk->onDisconnectionComplete(event);
+        }
+    }
+
+    void onAdvertisingReport(const AdvertisingReportEvent &event) override
+    {
+        ++advertising_reports;
+    }
+
+    void onDataLengthChange(connection_handle_t connection, uint16_t tx_size, uint16_t rx_size) override
+    {
+        data_length = tx_size;
+        if (bulk) {
+            bulk->onDataLengthChange(connection, tx_size, rx_size);
+        }
+    }
+
+    void onPhyUpdateComplete(ble_error_t status, connection_handle_t connection, phy_t tx_phy, phy_t rx_phy) override
+    {
+        phy_updated = (status == BLE_ERROR_NONE) && (tx_phy == phy_t::LE_2M);
+        if (bulk) {
+            bulk->onPhyUpdateComplete(status, connection, tx_phy, rx_phy);
+        }
+    }
+
+    void onAttMtuChange(connection_handle_t connection, uint16_t att_mtu_size) override
+    {
+        att_mtu = att_mtu_size;
+        if (bulk) {
+            bulk->onAttMtuChange(connection, att_mtu_size);
+        }
+    }
+
+    void onBulkTransferEnd(connection_handle_t, ble_error_t status, size_t) override
+    {
+        bulk_done = true;
+        bulk_status = status;
+    }
+
+    void pairingResult(connection_handle_t, SecurityManager::SecurityCompletionStatus_t result) override
+    {
+        pairing_completed = true;
+        pairing_result = result;
+    }
+
+    void on_hvx(const GattHVXCallbackParams *params)
+    {
+        ++notifications;
+        notification_bytes += params->len;
+    }
+
+    void on_characteristic(const DiscoveredCharacteristic *)
+    {
+        ++characteristics;
+    }
+
+    void on_discovery_termination(connection_handle_t)
+    {
+        discovery_done = true;
+    }
+
+    bool connected = false;
+    connection_handle_t handle = 0;
+    uint32_t advertising_reports = 0;
+    uint16_t data_length = 0;
+    bool phy_updated = false;
+    uint16_t att_mtu = 0;
+    bool pairing_completed = false;
+    SecurityManager::SecurityCompletionStatus_t pairing_result = SecurityManager::SEC_STATUS_UNSPECIFIED;
+    uint32_t notifications = 0;
+    uint64_t notification_bytes = 0;
+    uint32_t characteristics = 0;
+    bool discovery_done = false;
+    BulkTransfer *bulk = nullptr;
+    bool bulk_done = false;
+    ble_error_t bulk_status = BLE_ERROR_NONE;
+};
+
+Observer observer;
+
+double to_ms(sim_time_t duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/* a sample this close to a connection event shares its wake-up */
+constexpr sim_time_t MERGE_WINDOW = 3ms;
+
+/*
+ * Sensor sampled by the application and written to the peer with write
+ * commands carrying the date of the sample, so the peer can measure the age
+ * of the data it receives.
+ */
+struct Sensor {
+    void sample(connection_handle_t connection)
+    {
+        VirtualEnvironment &environment = VirtualEnvironment::instance();
+        const uint32_t date = environment.simulator().now().count();
+        const uint8_t value[] = {
+            uint8_t(date), uint8_t(date >> 8), uint8_t(date >> 16), uint8_t(date >> 24)
+        };
+
+        ++samples;
+        if (environment.link().next_connection_event() - environment.simulator().now() > MERGE_WINDOW) {
+            ++separate_wakeups;
+        }
+
+        BLE::Instance().gattClient().write(
+            GattClient::GATT_OP_WRITE_CMD,
+            connection,
+            value_handle,
+            sizeof(value),
+            value
+        );
+    }
+
+    void on_written(attribute_handle_t, const std::vector<uint8_t> &value)
+    {
+        const uint32_t date = value[0] | (value[1] << 8) | (value[2] << 16) | (uint32_t(value[3]) << 24);
+        total_age += VirtualEnvironment::instance().simulator().now() - sim_time_t(date);
+        ++received;
+    }
+
+    attribute_handle_t value_handle = 0;
+    uint32_t samples = 0;
+    uint32_t separate_wakeups = 0;
+    uint32_t received = 0;
+    sim_time_t total_age = 0us;
+};
+
+}
+
+class TestGenericBenchmarks : public testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        BLE &ble = BLE::Instance();
+        ble.init(&TestGenericBenchmarks::on_init);
+        environment().simulator().run_until([]() { return initialized; }, 1s);
+
+        ble.gap().setEventHandler(&observer);
+        ble.gattClient().setEventHandler(&observer);
+        ble.gattClient().onHVX(makeFunctionPointer(&observer, &Observer::on_hvx));
+        ble.gattClient().onServiceDiscoveryTermination(
+            makeFunctionPointer(&observer, &Observer::on_discovery_termination)
+        );
+        ble.securityManager().init(true, false, SecurityManager::IO_CAPS_NONE, nullptr, false, nullptr);
+        ble.securityManager().setSecurityManagerEventHandler(&observer);
+    }
+
+    static void TearDownTestCase()
+    {
+        BLE::Instance().shutdown();
+    }
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(initialized);
+        environment().reset();
+        environment().peer().reset();
+        environment().set_background_advertisers(0, 160);
+        observer.clear();
+    }
+
+    void TearDown() override
+    {
+        if (observer.connected) {
+            gap().disconnect(observer.handle, local_disconnection_reason_t::USER_TERMINATION);
+            simulator().run_until([]() { return !observer.connected; }, 5s);
+        }
+        if (scanning) {
+            gap().stopScan();
+            scanning = false;
+        }
+    }
+
+    static VirtualEnvironment &environment()
+    {
+        return VirtualEnvironment::instance();
+    }
+
+    static Simulator &simulator()
+    {
+        return environment().simulator();
+    }
+
+    static Gap &gap()
+    {
+        return BLE::Instance().gap();
+    }
+
+    static GattClient &gattClient()
+    {
+        return BLE::Instance().gattClient();
+    }
+
+    void connect()
+    {
+        ConnectionParameters parameters;
+        parameters.setConnectionParameters(
+            phy_t::LE_1M,
+            conn_interval_t(6),
+            conn_interval_t(800),
+            slave_latency_t(0),
+            supervision_timeout_t(400)
+        );
+
+        ASSERT_EQ(BLE_ERROR_NONE, gap().connect(
+            peer_address_type_t::RANDOM,
+            environment().peer().address(),
+            parameters
+        ));
+        ASSERT_TRUE(simulator().run_until([]() { return observer.connected; }, 5s));
+    }
+
+    /* stream notifications from the peer, return the goodput in bit/s */
+    double stream(attribute_handle_t handle, uint32_t count)
+    {
+        const sim_time_t start = simulator().now();
+        environment().peer().stream_notifications(handle, 244, count, 8);
+        EXPECT_TRUE(simulator().run_until([count]() { return observer.notifications == count; }, 120s));
+        const double seconds = std::chrono::duration<double>(simulator().now() - start).count();
+        return (observer.notification_bytes * 8) / seconds;
+    }
+
+    void discover()
+    {
+        ASSERT_EQ(BLE_ERROR_NONE, gattClient().launchServiceDiscovery(
+            observer.handle,
+            nullptr,
+            makeFunctionPointer(&observer, &Observer::on_characteristic)
+        ));
+        ASSERT_TRUE(simulator().run_until([]() { return observer.discovery_done; }, 60s));
+    }
+
+    void populate_peer()
+    {
+        VirtualPeer &peer = environment().peer();
+        for (uint16_t service = 0; service < 3; ++service) {
+            peer.add_service(UUID(0xA000 + service));
+            for (uint16_t characteristic = 0; characteristic < 3; ++characteristic) {
+                peer.add_characteristic(UUID(0xA100 + service * 3 + characteristic), PROPERTY_READ, { 0x00 });
+            }
+        }
+    }
+
+    void report(const char *name, double value, const char *unit)
+    {
+        RecordProperty(name, std::to_string(value));
+        std::printf("[ BENCH    ] %s: %.1f %s\n", name, value, unit);
+    }
+
+    static void on_init(BLE::InitializationCompleteCallbackContext *context)
+    {
+        initialized = (context->error == BLE_ERROR_NONE);
+    }
+
+    static bool initialized;
+    bool scanning = false;
+};
+
+bool TestGenericBenchmarks::initialized = false;
+
+TEST_F(TestGenericBenchmarks, notification_throughput)
+{
+    VirtualPeer &peer = environment().peer();
+    peer.add_service(UUID(0xFFF0));
+    attribute_handle_t value_handle = peer.add_characteristic(UUID(0xFFF1), PROPERTY_NOTIFY, { 0x00 });
+
+    /* default link: 23 bytes MTU, 27 bytes LL payload, 1M PHY */
+    connect();
+    const double default_throughput = stream(value_handle, 200);
+    report("throughput_default_bps", default_throughput, "bit/s");
+
+    /* reconnect and negotiate every knob before streaming */
+    gap().disconnect(observer.handle, local_disconnection_reason_t::USER_TERMINATION);
+    ASSERT_TRUE(simulator().run_until([]() { return !observer.connected; }, 5s));
+    observer.clear();
+    connect();
+
+    ASSERT_EQ(BLE_ERROR_NONE, gattClient().negotiateAttMtu(observer.handle));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setDataLength(observer.handle, 251, 2120));
+    phy_set_t phys(/* 1M */ false, /* 2M */ true, /* coded */ false);
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setPhy(observer.handle, &phys, &phys, coded_symbol_per_bit_t::UNDEFINED));
+    ASSERT_TRUE(simulator().run_until([]() {
+        return observer.att_mtu > 23 && observer.data_length == 251 && observer.phy_updated;
+    }, 5s));
+
+    const double optimized_throughput = stream(value_handle, 200);
+    report("throughput_optimized_bps", optimized_throughput, "bit/s");
+
+    EXPECT_GT(optimized_throughput, 3 * default_throughput);
+}
+
+TEST_F(TestGenericBenchmarks, bulk_transfer_throughput)
+{
+    struct Setting {
+        const char *name;
+        uint8_t window;
+        uint16_t peer_att_mtu;
+        uint16_t max_tx_octets;
+    };
+
+    /* window alone, then each link knob the peer accepts in turn */
+    const Setting settings[] = {
+        { "bulk_window_1_kBps", 1, 23, 27 },
+        { "bulk_window_4_kBps", 4, 23, 27 },
+        { "bulk_window_8_kBps", 8, 23, 27 },
+        { "bulk_att_mtu_kBps", 8, 247, 27 },
+        { "bulk_att_mtu_data_length_kBps", 8, 247, 251 },
+    };
+
+    std::vector<uint8_t> data(16 * 1024);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = uint8_t(i * 7 + (i >> 8));
+    }
+    std::vector<uint8_t> received;
+
+    double previous = 0;
+    for (const Setting &setting : settings) {
+        if (observer.connected) {
+            gap().disconnect(observer.handle, local_disconnection_reason_t::USER_TERMINATION);
+            ASSERT_TRUE(simulator().run_until([]() { return !observer.connected; }, 5s));
+        }
+        observer.clear();
+        received.clear();
+
+        LinkConfiguration configuration;
+        configuration.peer_att_mtu = setting.peer_att_mtu;
+        configuration.max_tx_octets = setting.max_tx_octets;
+        environment().reset(configuration);
+        VirtualPeer &peer = environment().peer();
+        peer.reset();
+        peer.add_service(UUID(0xFFF0));
+        const attribute_handle_t value_handle =
+            peer.add_characteristic(UUID(0xFFF1), PROPERTY_WRITE_WITHOUT_RESPONSE, { 0x00 });
+        peer.when_written([&received, value_handle](attribute_handle_t handle, const std::vector<uint8_t> &value) {
+            if (handle == value_handle) {
+                received.insert(received.end(), value.begin(), value.end());
+            }
+        });
+        connect();
+
+        BulkTransfer bulk(BLE::Instance(), setting.window);
+        bulk.setEventHandler(&observer);
+        observer.bulk = &bulk;
+
+        ASSERT_EQ(BLE_ERROR_NONE, bulk.negotiate(observer.handle, BulkTransfer::WRITE_WITHOUT_RESPONSE));
+        simulator().run_for(1s);
+
+        const sim_time_t start = simulator().now();
+        ASSERT_EQ(BLE_ERROR_NONE, bulk.start(
+            observer.handle,
+            value_handle,
+            data.data(),
+            data.size(),
+            BulkTransfer::WRITE_WITHOUT_RESPONSE
+        ));
+        ASSERT_TRUE(simulator().run_until([]() { return observer.bulk_done; }, 120s));
+        const double seconds = std::chrono::duration<double>(simulator().now() - start).count();
+        observer.bulk = nullptr;
+
+        EXPECT_EQ(BLE_ERROR_NONE, observer.bulk_status);
+        EXPECT_EQ(data.size(), bulk.getStatistics().bytes_sent);
+        /* the last writes may still be on air when the stack releases them */
+        simulator().run_for(1s);
+        EXPECT_TRUE(received == data);
+
+        const double throughput = data.size() / 1024.0 / seconds;
+        report(setting.name, throughput, "kB/s");
+        EXPECT_GT(throughput, previous);
+        previous = throughput;
+    }
+}
+
+TEST_F(TestGenericBenchmarks, discovery_time_depends_on_connection_interval)
+{
+    sim_time_t durations[2];
+    const uint16_t intervals[2] = { 6, 80 };
+
+    for (size_t i = 0; i < 2; ++i) {
+        LinkConfiguration configuration;
+        configuration.connection_interval = intervals[i];
+        environment().reset(configuration);
+        environment().peer().reset();
+        populate_peer();
+        observer.clear();
+
+        connect();
+        const sim_time_t start = simulator().now();
+        discover();
+        durations[i] = simulator().now() - start;
+
+        EXPECT_EQ(9u, observer.characteristics);
+
+        gap().disconnect(observer.handle, local_disconnection_reason_t::USER_TERMINATION);
+        ASSERT_TRUE(simulator().run_until([]() { return !observer.connected; }, 5s));
+    }
+
+    report("discovery_7_5ms_interval_ms", to_ms(durations[0]), "ms");
+    report("discovery_100ms_interval_ms", to_ms(durations[1]), "ms");
+
+    EXPECT_LT(durations[0], durations[1]);
+}
+
+TEST_F(TestGenericBenchmarks, scan_report_load)
+{
+    environment().set_background_advertisers(50, 160);
+
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setScanParameters(ScanParameters()));
+    ASSERT_EQ(BLE_ERROR_NONE, gap().startScan(scan_duration_t::forever(), duplicates_filter_t::DISABLE));
+    scanning = true;
+
+    const auto wall_start = std::chrono::steady_clock::now();
+    simulator().run_for(10s);
+    const auto wall_time = std::chrono::steady_clock::now() - wall_start;
+
+    ASSERT_EQ(BLE_ERROR_NONE, gap().stopScan());
+    scanning = false;
+
+    /* 51 advertisers, every 100ms, for 10s */
+    EXPECT_GT(observer.advertising_reports, 50u * 80u);
+    report("advertising_reports", observer.advertising_reports, "reports");
+    report(
+        "host_cost_per_report_ns",
+        std::chrono::duration<double, std::nano>(wall_time).count() / observer.advertising_reports,
+        "ns"
+    );
+
+    /* with duplicate filtering each advertiser is reported once */
+    observer.clear();
+    ASSERT_EQ(BLE_ERROR_NONE, gap().startScan(scan_duration_t::forever(), duplicates_filter_t::ENABLE));
+    scanning = true;
+    simulator().run_for(10s);
+    EXPECT_EQ(51u, observer.advertising_reports);
+}
+
+TEST_F(TestGenericBenchmarks, pairing_flow)
+{
+    connect();
+
+    const sim_time_t start = simulator().now();
+    ASSERT_EQ(BLE_ERROR_NONE, BLE::Instance().securityManager().requestPairing(observer.handle));
+    ASSERT_TRUE(simulator().run_until([]() { return observer.pairing_completed; }, 30s));
+
+    EXPECT_EQ(SecurityManager::SEC_STATUS_SUCCESS, observer.pairing_result);
+    EXPECT_EQ(1u, environment().peer().statistics().pairings);
+    report("pairing_ms", to_ms(simulator().now() - start), "ms");
+}
+
+TEST_F(TestGenericBenchmarks, advertising_payload_update)
+{
+    const uint32_t updates = 1000;
+    /* the sensor is sampled more often than its value changes */
+    auto sample = [](uint32_t i) -> uint16_t { return i / 4; };
+
+    uint8_t buffer[LEGACY_ADVERTISING_MAX_SIZE];
+    uint8_t manufacturer_data[] = { 0xFF, 0xFF, 0x00, 0x00 };
+    VirtualEnvironment::ControllerStatistics &controller = environment().controller_statistics();
+
+    /* rebuild and push the whole payload on every sample */
+    auto wall_start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < updates; ++i) {
+        AdvertisingDataBuilder builder(buffer);
+        builder.setFlags();
+        builder.setName("beacon");
+        manufacturer_data[2] = sample(i);
+        manufacturer_data[3] = sample(i) >> 8;
+        builder.setManufacturerSpecificData(manufacturer_data);
+        ASSERT_EQ(BLE_ERROR_NONE, gap().setAdvertisingPayload(LEGACY_ADVERTISING_HANDLE, builder.getAdvertisingData()));
+    }
+    const auto builder_time = std::chrono::steady_clock::now() - wall_start;
+    const uint32_t builder_commands = controller.advertising_data;
+
+    /* build once, then patch the sensor value in place */
+    AdvertisingDataBuilder builder(buffer);
+    builder.setFlags();
+    builder.setName("beacon");
+    builder.setManufacturerSpecificData(manufacturer_data);
+    AdvertisingDataTemplate payload(mbed::make_Span(buffer, builder.getAdvertisingData().size()));
+    AdvertisingDataTemplate::field_t value;
+    ASSERT_EQ(BLE_ERROR_NONE, payload.getField(adv_data_type_t::MANUFACTURER_SPECIFIC_DATA, value, 2, 2));
+
+    controller = VirtualEnvironment::ControllerStatistics();
+    wall_start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < updates; ++i) {
+        payload.update(value, sample(i));
+        ASSERT_EQ(BLE_ERROR_NONE, gap().updateAdvertisingPayload(LEGACY_ADVERTISING_HANDLE, payload));
+    }
+    const auto template_time = std::chrono::steady_clock::now() - wall_start;
+    const uint32_t template_commands = controller.advertising_data;
+
+    EXPECT_EQ(updates, builder_commands);
+    EXPECT_EQ(updates / 4, template_commands);
+    EXPECT_EQ(uint8_t(sample(updates - 1)), buffer[value.offset]);
+    EXPECT_EQ(uint8_t(sample(updates - 1) >> 8), buffer[value.offset + 1]);
+
+    report("builder_commands_per_update", double(builder_commands) / updates, "commands");
+    report("template_commands_per_update", double(template_commands) / updates, "commands");
+    report("builder_cpu_per_update_ns", std::chrono::duration<double, std::nano>(builder_time).count() / updates, "ns");
+    report("template_cpu_per_update_ns", std::chrono::duration<double, std::nano>(template_time).count() / updates, "ns");
+}
+
+TEST_F(TestGenericBenchmarks, connection_event_producer)
+{
+    /* the sensor is sampled once per connection interval, 50ms */
+    const sim_time_t period = 50ms;
+    LinkConfiguration configuration;
+    configuration.connection_interval = 40;
+    environment().reset(configuration);
+    VirtualPeer &peer = environment().peer();
+    peer.reset();
+    peer.add_service(UUID(0xFFF0));
+
+    Sensor sensors[2];
+    for (Sensor &sensor : sensors) {
+        sensor.value_handle = peer.add_characteristic(UUID(0xFFF1), PROPERTY_WRITE_WITHOUT_RESPONSE, { 0, 0, 0, 0 });
+    }
+    peer.when_written([&sensors](attribute_handle_t handle, const std::vector<uint8_t> &value) {
+        for (Sensor &sensor : sensors) {
+            if (sensor.value_handle == handle) {
+                sensor.on_written(handle, value);
+            }
+        }
+    });
+
+    connect();
+    const connection_handle_t connection = observer.handle;
+
+    connection_event_timing_t timing;
+    ASSERT_EQ(BLE_ERROR_NONE, gap().getConnectionEventTiming(connection, timing));
+    EXPECT_EQ(40, timing.interval.value());
+    EXPECT_TRUE(timing.next_event_known);
+    EXPECT_FALSE(timing.next_event_estimated);
+    EXPECT_LE(timing.next_event.value(), 50000u);
+
+    /* sampling timer unrelated to the connection events */
+    Sensor &timer_sensor = sensors[0];
+    bool sampling = true;
+    std::function<void()> tick = [&]() {
+        if (!sampling) {
+            return;
+        }
+        timer_sensor.sample(connection);
+        simulator().post_in(period, tick);
+    };
+    simulator().post_in(17ms, tick);
+
+    uint32_t events_start = environment().link().statistics().connection_events;
+    simulator().run_for(10s);
+    sampling = false;
+    const uint32_t timer_wakeups =
+        environment().link().statistics().connection_events - events_start + timer_sensor.separate_wakeups;
+
+    /* sampling driven by the connection events */
+    Sensor &scheduled_sensor = sensors[1];
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setConnectionEventProducer(
+        connection,
+        mbed::callback(&scheduled_sensor, &Sensor::sample),
+        microsecond_t(2000)
+    ));
+
+    events_start = environment().link().statistics().connection_events;
+    simulator().run_for(10s);
+    ASSERT_EQ(BLE_ERROR_NONE, gap().clearConnectionEventProducer(connection));
+    const uint32_t scheduled_wakeups =
+        environment().link().statistics().connection_events - events_start + scheduled_sensor.separate_wakeups;
+
+    ASSERT_GT(timer_sensor.received, 0u);
+    ASSERT_GT(scheduled_sensor.received, 0u);
+    const double timer_age = to_ms(timer_sensor.total_age) / timer_sensor.received;
+    const double scheduled_age = to_ms(scheduled_sensor.total_age) / scheduled_sensor.received;
+
+    EXPECT_EQ(0u, scheduled_sensor.separate_wakeups);
+    EXPECT_LT(scheduled_wakeups, timer_wakeups);
+    EXPECT_LT(scheduled_age * 4, timer_age);
+
+    report("timer_wakeups_per_second", timer_wakeups / 10.0, "wake-ups");
+    report("scheduled_wakeups_per_second", scheduled_wakeups / 10.0, "wake-ups");
+    report("timer_data_age_ms", timer_age, "ms");
+    report("scheduled_data_age_ms", scheduled_age, "ms");
+}
+
+TEST_F(TestGenericBenchmarks, connection_event_producer_fallback)
+{
+    /* the controller cannot report connection events, the host predicts them */
+    const sim_time_t period = 50ms;
+    LinkConfiguration configuration;
+    configuration.connection_interval = 40;
+    configuration.connection_event_notification = false;
+    environment().reset(configuration);
+    VirtualPeer &peer = environment().peer();
+    peer.reset();
+    peer.add_service(UUID(0xFFF0));
+
+    Sensor sensors[2];
+    for (Sensor &sensor : sensors) {
+        sensor.value_handle = peer.add_characteristic(UUID(0xFFF1), PROPERTY_WRITE_WITHOUT_RESPONSE, { 0, 0, 0, 0 });
+    }
+    peer.when_written([&sensors](attribute_handle_t handle, const std::vector<uint8_t> &value) {
+        for (Sensor &sensor : sensors) {
+            if (sensor.value_handle == handle) {
+                sensor.on_written(handle, value);
+            }
+        }
+    });
+
+    connect();
+    const connection_handle_t connection = observer.handle;
+
+    /* sampling timer unrelated to the connection events */
+    Sensor &timer_sensor = sensors[0];
+    bool sampling = true;
+    std::function<void()> tick = [&]() {
+        if (!sampling) {
+            return;
+        }
+        timer_sensor.sample(connection);
+        simulator().post_in(period, tick);
+    };
+    simulator().post_in(17ms, tick);
+
+    uint32_t events_start = environment().link().statistics().connection_events;
+    simulator().run_for(10s);
+    sampling = false;
+    const uint32_t timer_wakeups =
+        environment().link().statistics().connection_events - events_start + timer_sensor.separate_wakeups;
+
+    /* registered at an arbitrary phase of the connection */
+    simulator().run_for(13ms);
+    connection_event_timing_t timing;
+    ASSERT_EQ(BLE_ERROR_NONE, gap().getConnectionEventTiming(connection, timing));
+    EXPECT_TRUE(timing.next_event_known);
+    EXPECT_TRUE(timing.next_event_estimated);
+    EXPECT_EQ(
+        (environment().link().next_connection_event() - simulator().now()).count(),
+        int64_t(timing.next_event.value())
+    );
+
+    Sensor &fallback_sensor = sensors[1];
+    ASSERT_EQ(BLE_ERROR_NONE, gap().setConnectionEventProducer(
+        connection,
+        mbed::callback(&fallback_sensor, &Sensor::sample),
+        microsecond_t(2000)
+    ));
+
+    events_start = environment().link().statistics().connection_events;
+    simulator().run_for(5s);
+
+    /* the prediction follows the new anchor after a parameter update */
+    ASSERT_EQ(BLE_ERROR_NONE, gap().updateConnectionParameters(
+        connection,
+        conn_interval_t(32),
+        conn_interval_t(32),
+        slave_latency_t(0),
+        supervision_timeout_t(400)
+    ));
+    simulator().run_for(5s);
+    ASSERT_EQ(BLE_ERROR_NONE, gap().clearConnectionEventProducer(connection));
+    EXPECT_EQ(32, environment().link().connection_interval());
+    const uint32_t fallback_wakeups =
+        environment().link().statistics().connection_events - events_start + fallback_sensor.separate_wakeups;
+
+    ASSERT_GT(timer_sensor.received, 0u);
+    ASSERT_GT(fallback_sensor.received, 0u);
+    const double timer_age = to_ms(timer_sensor.total_age) / timer_sensor.received;
+    const double fallback_age = to_ms(fallback_sensor.total_age) / fallback_sensor.received;
+
+    EXPECT_EQ(0u, fallback_sensor.separate_wakeups);
+    EXPECT_LT(fallback_wakeups, timer_wakeups);
+    EXPECT_LT(fallback_age * 4, timer_age);
+
+    report("fallback_timer_wakeups_per_second", timer_wakeups / 10.0, "wake-ups");
+    report("fallback_wakeups_per_second", fallback_wakeups / 10.0, "wake-ups");
+    report("fallback_timer_data_age_ms", timer_age, "ms");
+    report("fallback_data_age_ms", fallback_age, "ms");
+}
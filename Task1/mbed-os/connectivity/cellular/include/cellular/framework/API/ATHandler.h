@@ -64,10 +64,31 @@ struct device_err_t {
     int errCode;
 };
 
+/** AT command of a pipeline, see ATHandler::at_cmd_pipeline() */
+struct at_pipeline_cmd_t {
+    /** AT command in form +<CMD> */
+    const char *cmd;
+    /** Char to be added to the command: '?', '=?' or ''. Will be used as such so '=1' is valid as well. */
+    const char *cmd_chr;
+    /** Prefix of the information response, for example "+CSQ:". NULL if the information response has no prefix. */
+    const char *resp_prefix;
+    /** Called for each information response, reads its parameters. Empty if no information response is expected. */
+    Callback<void()> resp_cb;
+    /** Result of the command, set by ATHandler::at_cmd_pipeline() */
+    nsapi_error_t err;
+};
+
 /// Class for sending AT commands and parsing AT responses.
 class ATHandler {
 
 public:
+    /** How the modem takes several AT commands without waiting for each final result code */
+    enum PipelineMode {
+        PipelineNone = 0,       // One command at a time
+        PipelineStream,         // Command lines sent back to back, responses read in order
+        PipelineConcatenate     // Commands concatenated with ';' on one command line
+    };
+
     /** Constructor
      *
      *  @param fh               file handle used for reading AT responses and writing AT commands
@@ -187,6 +208,12 @@ public:
      */
     void set_send_delay(uint16_t send_delay);
 
+    /** Sets how at_cmd_pipeline() sends its commands to the modem.
+     *
+     *  @param mode pipelining supported by the modem, PipelineNone by default
+     */
+    void set_pipeline_mode(PipelineMode mode);
+
     /** Sets BufferedSerial filehandle to given baud rate
      *
      *  @param baud_rate
@@ -245,6 +272,25 @@ public:
      */
     nsapi_error_t at_cmd_discard(const char *cmd, const char *cmd_chr, const char *format = "", ...);
 
+    /**
+     * @brief at_cmd_pipeline Send a batch of independent AT commands and read their responses in order, without
+     *        a serial round trip for each command where the pipeline mode allows it. Locks and unlocks ATHandler
+     *        for operation.
+     *
+     *        In PipelineConcatenate mode, consecutive commands with a response prefix or without information
+     *        response are sent on one command line. Their information responses are given to the command whose
+     *        prefix matches, in order, so the prefixes of the commands should differ. The modem stops at the first
+     *        failing command of a line: the commands up to the last one with an information response succeeded
+     *        and the next one is sent again alone to get its own result. In PipelineStream mode, up to 4 command
+     *        lines are sent before reading their responses. A command failing with ERROR does not stop the
+     *        pipeline, a response timeout does.
+     *
+     * @param cmds commands, their err is set to the result of each command
+     * @param count number of commands
+     * @return NSAPI_ERROR_OK if all commands succeeded, otherwise result of the first failing command
+     */
+    nsapi_error_t at_cmd_pipeline(at_pipeline_cmd_t *cmds, size_t count);
+
     /** Writes integer type AT command subparameter. Starts with the delimiter if not the first param after cmd_start.
      *  In case of failure when writing, the last error is set to NSAPI_ERROR_DEVICE_ERROR.
      *
@@ -326,6 +372,17 @@ public:
      */
     ssize_t read_bytes(uint8_t *buf, size_t len);
 
+    /** Reads binary data of the length given by the modem before it, for example "+QIRD: <len>\r\n<data>".
+     *  The data is read as is, without hex encoding or escapes. Data not fitting to the output buffer is consumed
+     *  and discarded so that it is not parsed as a response or an URC.
+     *
+     *  @param buf output buffer for the read
+     *  @param size size of the output buffer
+     *  @param data_len length of the data given by the modem
+     *  @return number of bytes stored to buf or -1 in case of error
+     */
+    ssize_t read_binary(uint8_t *buf, size_t size, size_t data_len);
+
     /** Reads chars from reading buffer. Terminates with null. Skips the quotation marks.
      *  Stops on delimiter or stop tag.
      *
@@ -446,6 +503,18 @@ private: //Private structs & enums
         oob_t *next;
     };
 
+    // Node of the URC prefix tree. A node stands for label_len characters and
+    // the children of a node start with distinct characters, so that matching
+    // the received data against all URC prefixes reads each character once.
+    struct urc_node_t {
+        const char *label;
+        size_t label_len;
+        // URC whose prefix ends at this node, if any
+        oob_t *oob;
+        urc_node_t *child;
+        urc_node_t *sibling;
+    };
+
     // resp_type: the part of the response that doesn't include the information response (+CMD1,+CMD2..)
     //            ends with OK or (CME)(CMS)ERROR
     // info_type: the information response part of the response: starts with +CMD1 and ends with CRLF
@@ -485,6 +554,16 @@ private: //Private functions
      */
     void remove_urc_handler(const char *prefix);
 
+    // Adds the prefix of the URC to the URC prefix tree
+    void add_urc_node(oob_t *oob);
+    // Rebuilds the URC prefix tree from the linked list of URCs
+    void build_urc_tree();
+    // Frees the given nodes, their siblings and their children
+    static void free_urc_tree(urc_node_t *node);
+    // Walks the URC prefix tree with the receiving buffer content.
+    // Returns the URC with the longest prefix fully received or NULL.
+    oob_t *find_urc() const;
+
     void set_error(nsapi_error_t err);
 
     //Handles the arguments from given variadic list
@@ -500,22 +579,36 @@ private: //Private functions
     // Resets and fills the buffer if all are already read (receiving position equals receiving length).
     // Returns a next char or -1 on failure (also sets error flag)
     int get_char();
-    // Sets to 0 the reading position, reading length and the whole buffer content.
+    // Sets to 0 the reading position and reading length.
     void reset_buffer();
-    // Reading position set to 0 and buffer's unread content moved to beginning
-    void rewind_buffer();
+    // Moves the reading position forward over len characters, len must not exceed the unread content.
+    void advance_buffer(size_t len);
+    // Moves the reading position back over len characters already read.
+    void rewind_buffer(size_t len);
+    // Index in the receiving buffer of the unread character at offset from the reading position.
+    size_t buffer_index(size_t offset) const;
+    // Compares the unread content at offset from the reading position against str, without consuming it.
+    bool buffer_equals(size_t offset, const char *str, size_t len) const;
+    // Checks if the unread content contains str.
+    bool buffer_contains(const char *str, size_t len) const;
     // Calculate remaining time for polling based on request start time and AT timeout.
     // Returns 0 or time in ms for polling.
     int poll_timeout(bool wait_for_timeout = true);
     // Reads from serial to receiving buffer.
     // Returns true on successful read OR false on timeout.
     bool fill_buffer(bool wait_for_timeout = true);
+    // Reads from serial straight to buf, bypassing the empty receiving buffer.
+    // Returns number of bytes read OR -1 on timeout.
+    ssize_t read_direct(uint8_t *buf, size_t len);
+    // Copies or discards (buf NULL) len bytes of the receiving buffer, filling it as needed.
+    // Returns false on timeout (also sets error flag).
+    bool consume_bytes(uint8_t *buf, size_t len);
 
     void set_tag(tag_t *tag_dest, const char *tag_seq);
 
-    // Rewinds the receiving buffer and compares it against given str.
+    // Compares the receiving buffer against given str and consumes it on match.
     bool match(const char *str, size_t size);
-    // Iterates URCs and checks if they match the receiving buffer content.
+    // Looks up the receiving buffer content in the URC prefix tree.
     // If URC match sets the scope to information response and after urc's cb returns
     // finishes the information response scope(consumes to CRLF).
     bool match_urc();
@@ -548,20 +641,21 @@ private: //Private functions
      */
     void set_3gpp_error(int err, DeviceErrorType error_type);
 
+    // Sends up to count commands on separate command lines and reads their responses.
+    // Returns the number of commands done, stops on a response timeout.
+    size_t pipeline_stream(at_pipeline_cmd_t *cmds, size_t count, size_t depth);
+    // Sends the first commands that can share one command line and reads their responses.
+    // Returns the number of commands done, stops on a response timeout.
+    size_t pipeline_concatenate(at_pipeline_cmd_t *cmds, size_t count);
+    // Reads the information responses of concatenated commands up to the final result code.
+    // Returns the number of commands that succeeded.
+    size_t resp_concatenated(at_pipeline_cmd_t *cmds, size_t count);
+    // Sets the result of a pipelined command, returns false if the pipeline cannot go on.
+    bool pipeline_cmd_done(at_pipeline_cmd_t &cmd);
+
     bool check_cmd_send();
     size_t write(const void *data, size_t len);
 
-    /** Finds occurrence of one char buffer inside another char buffer.
-     *
-     * @param dest                  destination char buffer
-     * @param dest_len              length of dest
-     * @param src                   string to be searched for
-     * @param src_len               length of string to be searched for
-     *
-     * @return pointer to first occurrence of src in dest
-     */
-    const char *mem_str(const char *dest, size_t dest_len, const char *src, size_t src_len);
-
     // check is urc is already added
     bool find_urc_handler(const char *prefix);
 
@@ -590,20 +684,26 @@ private: //Member variables
     char *_output_delimiter;
 
     oob_t *_oobs;
+    // URC prefix tree, first node of the top level
+    urc_node_t *_urc_tree;
     mbed::chrono::milliseconds_u32 _at_timeout;
     mbed::chrono::milliseconds_u32 _previous_at_timeout;
 
     std::chrono::duration<uint16_t, std::milli> _at_send_delay;
+    PipelineMode _pipeline_mode;
     rtos::Kernel::Clock::time_point _last_response_stop;
 
     int32_t _ref_count;
     bool _is_fh_usable;
 
     // should fit any prefix and int
+    // Ring buffer: unread content starts at _recv_pos and is _recv_len - _recv_pos long, it wraps
+    // at the end of the buffer. _recv_pos stays below the buffer size, so that the content is never
+    // moved when it is consumed.
     char _recv_buff[MBED_CONF_CELLULAR_AT_HANDLER_BUFFER_SIZE];
-    // reading position
-    size_t _recv_len;
     // reading length
+    size_t _recv_len;
+    // reading position
     size_t _recv_pos;
 
     ScopeType _current_scope;
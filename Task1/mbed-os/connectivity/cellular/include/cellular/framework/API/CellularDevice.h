@@ -37,6 +37,9 @@ class CellularSMS;
 class CellularInformation;
 class CellularNetwork;
 class CellularContext;
+#if MBED_CONF_CELLULAR_FAST_RESUME
+class KVStore;
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
 
 const int MAX_PIN_SIZE = 8;
 const int MAX_PLMN_SIZE = 16;
@@ -360,6 +363,16 @@ public: //Common functions
      */
     void set_plmn(const char *plmn);
 
+#if MBED_CONF_CELLULAR_FAST_RESUME || defined(DOXYGEN_ONLY)
+    /** Store to keep the network state in for fast resume, see CellularStateMachine::set_resume_store.
+     *  Once set, a modem found ready and still registered with the same SIM is not registered again.
+     *  It doesn't start any operations.
+     *
+     *  @param store    key value store for the network state, NULL disables fast resume
+     */
+    void set_resume_store(KVStore *store);
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
     /** Start the interface
      *
      *  Initializes the modem for communication.
@@ -464,6 +477,9 @@ private: //Member variables
     CellularNetwork *_nw;
     char _sim_pin[MAX_PIN_SIZE + 1];
     char _plmn[MAX_PLMN_SIZE + 1];
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    KVStore *_resume_store;
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
     PlatformMutex _mutex;
 
 #ifdef MBED_CONF_RTOS_PRESENT
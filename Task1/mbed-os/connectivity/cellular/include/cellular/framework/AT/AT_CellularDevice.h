@@ -63,6 +63,7 @@ public:
         PROPERTY_IP_TCP,                // 0 = not supported, 1 = supported. Modem IP stack has support for TCP
         PROPERTY_IP_UDP,                // 0 = not supported, 1 = supported. Modem IP stack has support for TCP
         PROPERTY_AT_SEND_DELAY,         // Sending delay between AT commands in ms
+        PROPERTY_AT_CMD_PIPELINE,       // ATHandler::PipelineMode. 0 = one command at a time, 1 = command lines sent back to back, 2 = commands concatenated with ';'
         PROPERTY_MAX
     };
 
@@ -68,6 +68,8 @@ typedef enum cellular_event_status {
     CellularDeviceTimeout                   = NSAPI_EVENT_CELLULAR_STATUS_BASE + 10,/* cell_callback_data_t.error contain an error or NSAPI_ERROR_OK,
                                                                                        cell_callback_data_t.status_data contains the current cellular_connection_status_t,
                                                                                        cellular_event_status.data contains new timeout value in milliseconds */
+    CellularPowerSaveTimersChanged          = NSAPI_EVENT_CELLULAR_STATUS_BASE + 11,/* PSM timers given by the network in a registration URC have changed. cell_callback_data_t.data points to CellularNetwork::registration_params_t,
+                                                                                       with T3324 in seconds in _active_time and T3412 in seconds in _periodic_tau */
 } cellular_connection_status_t;
 
 #endif // CELLULAR_COMMON_
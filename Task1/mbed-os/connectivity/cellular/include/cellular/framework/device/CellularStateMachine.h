@@ -25,6 +25,9 @@
 namespace mbed {
 
 class CellularDevice;
+#if MBED_CONF_CELLULAR_FAST_RESUME
+class KVStore;
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
 
 /** CellularStateMachine class
  *
@@ -100,6 +103,16 @@ public:
      */
     void set_plmn(const char *plmn);
 
+#if MBED_CONF_CELLULAR_FAST_RESUME || defined(DOXYGEN_ONLY)
+    /** Enables fast resume. Once attached, the SIM, the network registered to and the PSM timers are kept in the
+     *  store. When the modem is found ready on the next run and still registered with the same SIM, the SIM and
+     *  registration states are skipped. Needs cellular.fast-resume.
+     *
+     *  @param store    key value store for the network state, NULL disables fast resume
+     */
+    void set_resume_store(KVStore *store);
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
     /** returns readable format of the given state. Used for printing states while debugging.
      *
      *  @param state state which is returned in string format
@@ -146,6 +159,10 @@ private:
     bool get_network_registration(CellularNetwork::RegistrationType type, CellularNetwork::RegistrationStatus &status, bool &is_registered);
     bool is_registered();
     bool device_ready();
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    bool resume_network();
+    void store_network_state();
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
 
     // state functions to keep state machine simple
     void state_init();
@@ -186,6 +203,11 @@ private:
     int _retry_array_length;
     int _event_id;
     const char *_plmn;
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    KVStore *_resume_store;
+    bool _resumed;
+    bool _resume_stale;
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
     bool _command_success;
     bool _is_retry;
     cell_callback_data_t _cb_data;
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _CELLULAR_UPLINK_SCHEDULER_H_
+#define _CELLULAR_UPLINK_SCHEDULER_H_
+
+#include <chrono>
+#include "events/EventQueue.h"
+#include "CellularNetwork.h"
+#include "PlatformMutex.h"
+#include "platform/Callback.h"
+
+namespace mbed {
+
+/** CellularUplinkScheduler class
+ *
+ *  Batches the uplink messages of an application around the power saving of the modem. With PSM each send wakes
+ *  the modem and pays the connection setup, so messages not urgent are queued and sent together in one wake:
+ *  when the oldest one has waited the maximum delay, when the modem is expected to wake up anyway for the periodic
+ *  tracking area update (T3412), when the modem is known to be awake (T3324 after the last send or after
+ *  radio_active()) or when the queue is full. Urgent messages are sent at once, together with the queued ones.
+ */
+class CellularUplinkScheduler {
+public:
+    /** Sends one message to the network, for example with sendto() of a socket.
+     *
+     *  @return number of bytes sent or a negative error code
+     */
+    typedef Callback<nsapi_size_or_error_t(const void *data, nsapi_size_t size)> send_cb_t;
+
+    /** Statistics of the uplink */
+    struct uplink_stats_t {
+        uint32_t messages;  // messages sent
+        uint32_t urgent;    // of which urgent
+        uint32_t batches;   // sends of the queued messages
+        uint32_t wakes;     // sends not within the time the modem was known to be awake
+        uint32_t errors;    // failed sends
+        uplink_stats_t()
+        {
+            messages = 0;
+            urgent = 0;
+            batches = 0;
+            wakes = 0;
+            errors = 0;
+        }
+    };
+
+    /** Constructor
+     *
+     *  @param queue        queue of the flush events
+     *  @param send_cb      sends one message
+     *  @param buffer_size  bytes reserved for queued messages, each takes two bytes more than its size
+     *  @param max_delay    longest time a message not urgent is queued
+     */
+    CellularUplinkScheduler(events::EventQueue &queue, send_cb_t send_cb, nsapi_size_t buffer_size = 512,
+                            std::chrono::duration<int> max_delay = std::chrono::minutes(15));
+    ~CellularUplinkScheduler();
+
+    /** Sends or queues a message.
+     *
+     *  A message is sent at once if it is urgent, if the modem is known to be awake or if it does not fit to the
+     *  queue. The queued messages are sent before it to keep the order.
+     *
+     *  @param data     message
+     *  @param size     size of the message
+     *  @param urgent   true to send the message now
+     *  @return         size if the message was queued or sent, or a negative error code of send_cb
+     */
+    nsapi_size_or_error_t send(const void *data, nsapi_size_t size, bool urgent = false);
+
+    /** Sends the queued messages now.
+     *
+     *  @return NSAPI_ERROR_OK on success, or the error of send_cb. Messages not sent stay queued.
+     */
+    nsapi_error_t flush();
+
+    /** Updates the PSM timers given by the network, as read with CellularNetwork::get_registration_params()
+     *  from +CEREG.
+     *
+     *  @param reg_params   registration parameters with T3412 (_periodic_tau) and T3324 (_active_time)
+     */
+    void set_power_save_timers(const CellularNetwork::registration_params_t &reg_params);
+
+    /** Tells that the modem woke up for other reasons than a send, for example for the periodic tracking area update
+     *  or for downlink data (+CSCON: 1). Queued messages are sent in the same wake.
+     */
+    void radio_active();
+
+    /** Number of messages queued. */
+    int queued() const;
+
+    /** Statistics of the uplink since the construction. */
+    uplink_stats_t get_stats() const;
+
+private:
+    nsapi_size_or_error_t transmit(const void *data, nsapi_size_t size);
+    nsapi_error_t send_queued();
+    bool awake(unsigned now) const;
+    void schedule_flush();
+    void flush_event();
+
+private:
+    events::EventQueue &_queue;
+    send_cb_t _send_cb;
+
+    uint8_t *_buffer;
+    nsapi_size_t _buffer_size;
+    nsapi_size_t _buffer_len;
+    int _queued;
+
+    std::chrono::duration<int, std::milli> _max_delay;
+    int _periodic_tau;
+    int _active_time;
+
+    unsigned _first_queued;
+    unsigned _last_send;
+    unsigned _awake_until;
+    bool _sent;
+    int _event_id;
+
+    uplink_stats_t _stats;
+    mutable PlatformMutex _mutex;
+};
+
+} // namespace mbed
+
+#endif // _CELLULAR_UPLINK_SCHEDULER_H_
@@ -109,6 +109,7 @@ void AT_CellularDevice::setup_at_handler()
     set_at_urcs();
 
     _at.set_send_delay(get_property(AT_CellularDevice::PROPERTY_AT_SEND_DELAY));
+    _at.set_pipeline_mode((ATHandler::PipelineMode)get_property(AT_CellularDevice::PROPERTY_AT_CMD_PIPELINE));
 }
 
 void AT_CellularDevice::urc_nw_deact()
@@ -414,9 +415,11 @@ nsapi_error_t AT_CellularDevice::init()
         _at.flush();
         _at.at_cmd_discard("E0", "");
         if (_at.get_last_error() == NSAPI_ERROR_OK) {
-            _at.at_cmd_discard("+CMEE", "=1");
-            _at.at_cmd_discard("+CFUN", "=1");
-            if (_at.get_last_error() == NSAPI_ERROR_OK) {
+            at_pipeline_cmd_t cmds[] = {
+                { "+CMEE", "=1" },
+                { "+CFUN", "=1" }
+            };
+            if (_at.at_cmd_pipeline(cmds, sizeof(cmds) / sizeof(cmds[0])) == NSAPI_ERROR_OK) {
                 break;
             }
         }
@@ -150,6 +150,14 @@ void AT_CellularNetwork::read_reg_params_and_compare(RegistrationType type)
             data.status_data = reg_params._cell_id;
             _connection_status_cb((nsapi_event_t)CellularCellIDChanged, (intptr_t)&data);
         }
+        if (reg_params._periodic_tau != -1 && (reg_params._periodic_tau != _reg_params._periodic_tau ||
+                                               reg_params._active_time != _reg_params._active_time)) {
+            _reg_params._active_time = reg_params._active_time;
+            _reg_params._periodic_tau = reg_params._periodic_tau;
+            data.status_data = -1;
+            data.data = &_reg_params;
+            _connection_status_cb((nsapi_event_t)CellularPowerSaveTimersChanged, (intptr_t)&data);
+        }
         _reg_params._type = type;
     }
 }
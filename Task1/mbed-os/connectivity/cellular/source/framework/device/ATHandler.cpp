@@ -61,6 +61,12 @@ const char *ERROR_ = "ERROR\r\n";
 const uint8_t ERROR_LENGTH = 7;
 const uint8_t MAX_RESP_LENGTH = CMS_ERROR_LENGTH;
 const char DEFAULT_DELIMITER = ',';
+// Command lines sent before reading their responses in PipelineStream mode
+const uint8_t PIPELINE_DEPTH = 4;
+// Longest concatenated command line, well within what the modems with PipelineConcatenate take
+const uint8_t PIPELINE_LINE_LENGTH = 128;
+// Hex characters converted at a time by write_hex_string
+const uint8_t HEX_WRITE_CHUNK = 64;
 
 static const uint8_t map_3gpp_errors[][2] =  {
     { 103, 3 },  { 106, 6 },  { 107, 7 },  { 108, 8 },  { 111, 11 }, { 112, 12 }, { 113, 13 }, { 114, 14 },
@@ -85,9 +91,11 @@ ATHandler::ATHandler(FileHandle *fh, EventQueue &queue, mbed::chrono::millisecon
     _last_3gpp_error(0),
     _oob_string_max_length(0),
     _oobs(NULL),
+    _urc_tree(NULL),
     _at_timeout(timeout),
     _previous_at_timeout(timeout),
     _at_send_delay(send_delay),
+    _pipeline_mode(PipelineNone),
     _last_response_stop(0s),
     _ref_count(1),
     _is_fh_usable(false),
@@ -149,6 +157,7 @@ ATHandler::~ATHandler()
         _oobs = oob->next;
         delete oob;
     }
+    free_urc_tree(_urc_tree);
     if (_output_delimiter) {
         delete [] _output_delimiter;
     }
@@ -223,6 +232,8 @@ void ATHandler::set_urc_handler(const char *prefix, Callback<void()> callback)
     oob->cb = callback;
     oob->next = _oobs;
     _oobs = oob;
+
+    add_urc_node(oob);
 }
 
 void ATHandler::remove_urc_handler(const char *prefix)
@@ -237,6 +248,8 @@ void ATHandler::remove_urc_handler(const char *prefix)
                 _oobs = current->next;
             }
             delete current;
+            // nodes may point to the prefix just removed
+            build_urc_tree();
             break;
         }
         prev = current;
@@ -244,6 +257,77 @@ void ATHandler::remove_urc_handler(const char *prefix)
     }
 }
 
+void ATHandler::add_urc_node(oob_t *oob)
+{
+    const char *prefix = oob->prefix;
+    size_t prefix_len = oob->prefix_len;
+    urc_node_t **link = &_urc_tree;
+
+    while (prefix_len) {
+        urc_node_t *node = *link;
+        while (node && node->label[0] != prefix[0]) {
+            link = &node->sibling;
+            node = *link;
+        }
+
+        if (!node) {
+            node = new struct urc_node_t;
+            node->label = prefix;
+            node->label_len = prefix_len;
+            node->oob = oob;
+            node->child = NULL;
+            node->sibling = NULL;
+            *link = node;
+            return;
+        }
+
+        size_t common = 1;
+        while (common < node->label_len && common < prefix_len && node->label[common] == prefix[common]) {
+            common++;
+        }
+
+        // split the node where the prefix leaves it
+        if (common < node->label_len) {
+            urc_node_t *tail = new struct urc_node_t;
+            tail->label = node->label + common;
+            tail->label_len = node->label_len - common;
+            tail->oob = node->oob;
+            tail->child = node->child;
+            tail->sibling = NULL;
+            node->label_len = common;
+            node->oob = NULL;
+            node->child = tail;
+        }
+
+        prefix += common;
+        prefix_len -= common;
+        if (!prefix_len) {
+            node->oob = oob;
+        }
+        link = &node->child;
+    }
+}
+
+void ATHandler::build_urc_tree()
+{
+    free_urc_tree(_urc_tree);
+    _urc_tree = NULL;
+
+    for (struct oob_t *oob = _oobs; oob; oob = oob->next) {
+        add_urc_node(oob);
+    }
+}
+
+void ATHandler::free_urc_tree(urc_node_t *node)
+{
+    while (node) {
+        urc_node_t *sibling = node->sibling;
+        free_urc_tree(node->child);
+        delete node;
+        node = sibling;
+    }
+}
+
 bool ATHandler::find_urc_handler(const char *prefix)
 {
     struct oob_t *oob = _oobs;
@@ -338,7 +422,7 @@ void ATHandler::process_oob()
                 if (!(_fileHandle->readable() || (_recv_pos < _recv_len))) {
                     break; // we have nothing to read anymore
                 }
-            } else if (mem_str(_recv_buff, _recv_len, CRLF, CRLF_LENGTH)) { // If no match found, look for CRLF and consume everything up to CRLF
+            } else if (buffer_contains(CRLF, CRLF_LENGTH)) { // If no match found, look for CRLF and consume everything up to CRLF
                 _at_timeout = PROCESS_URC_TIME;
                 consume_to_tag(CRLF, true);
             } else {
@@ -365,14 +449,56 @@ void ATHandler::reset_buffer()
     _recv_len = 0;
 }
 
-void ATHandler::rewind_buffer()
+void ATHandler::advance_buffer(size_t len)
+{
+    _recv_pos += len;
+    if (_recv_pos >= sizeof(_recv_buff)) {
+        _recv_pos -= sizeof(_recv_buff);
+        _recv_len -= sizeof(_recv_buff);
+    }
+}
+
+void ATHandler::rewind_buffer(size_t len)
 {
-    if (_recv_pos > 0 && _recv_len >= _recv_pos) {
-        _recv_len -= _recv_pos;
-        // move what is not read to beginning of buffer
-        memmove(_recv_buff, _recv_buff + _recv_pos, _recv_len);
-        _recv_pos = 0;
+    if (_recv_pos < len) {
+        _recv_pos += sizeof(_recv_buff);
+        _recv_len += sizeof(_recv_buff);
     }
+    _recv_pos -= len;
+}
+
+size_t ATHandler::buffer_index(size_t offset) const
+{
+    size_t index = _recv_pos + offset;
+    return index < sizeof(_recv_buff) ? index : index - sizeof(_recv_buff);
+}
+
+bool ATHandler::buffer_equals(size_t offset, const char *str, size_t len) const
+{
+    const size_t index = buffer_index(offset);
+    const size_t first_len = sizeof(_recv_buff) - index;
+
+    if (len <= first_len) {
+        return memcmp(_recv_buff + index, str, len) == 0;
+    }
+
+    // compare the part wrapped to the beginning of buffer separately
+    return memcmp(_recv_buff + index, str, first_len) == 0
+           && memcmp(_recv_buff, str + first_len, len - first_len) == 0;
+}
+
+bool ATHandler::buffer_contains(const char *str, size_t len) const
+{
+    const size_t unread = _recv_len - _recv_pos;
+
+    if (unread >= len) {
+        for (size_t i = 0; i < unread - len + 1; ++i) {
+            if (_recv_buff[buffer_index(i)] == str[0] && buffer_equals(i, str, len)) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 int ATHandler::poll_timeout(bool wait_for_timeout)
@@ -396,9 +522,14 @@ int ATHandler::poll_timeout(bool wait_for_timeout)
 bool ATHandler::fill_buffer(bool wait_for_timeout)
 {
     // Reset buffer when full
-    if (sizeof(_recv_buff) == _recv_len) {
+    if (sizeof(_recv_buff) == _recv_len - _recv_pos) {
         tr_warn("AT overflow");
-        debug_print(_recv_buff, _recv_len, AT_ERR);
+        debug_print(_recv_buff, sizeof(_recv_buff), AT_ERR);
+        reset_buffer();
+    }
+
+    // An empty buffer is read from the beginning to get as much as possible in one read
+    if (_recv_pos == _recv_len) {
         reset_buffer();
     }
 
@@ -407,17 +538,84 @@ bool ATHandler::fill_buffer(bool wait_for_timeout)
     fhs.events = POLLIN;
     int count = poll(&fhs, 1, poll_timeout(wait_for_timeout));
     if (count > 0 && (fhs.revents & POLLIN)) {
-        ssize_t len = _fileHandle->read(_recv_buff + _recv_len, sizeof(_recv_buff) - _recv_len);
-        if (len > 0) {
-            debug_print(_recv_buff + _recv_len, len, AT_RX);
+        bool filled = false;
+        // free space may wrap to the beginning of buffer, so read it in two parts
+        while (_recv_len - _recv_pos < sizeof(_recv_buff)) {
+            const size_t index = buffer_index(_recv_len - _recv_pos);
+            const size_t free_len = (index < _recv_pos ? _recv_pos : sizeof(_recv_buff)) - index;
+            ssize_t len = _fileHandle->read(_recv_buff + index, free_len);
+            if (len <= 0) {
+                break;
+            }
+            debug_print(_recv_buff + index, len, AT_RX);
             _recv_len += len;
-            return true;
+            filled = true;
+            if ((size_t)len < free_len) {
+                break;
+            }
         }
+        return filled;
     }
 
     return false;
 }
 
+ssize_t ATHandler::read_direct(uint8_t *buf, size_t len)
+{
+    pollfh fhs;
+    fhs.fh = _fileHandle;
+    fhs.events = POLLIN;
+    int count = poll(&fhs, 1, poll_timeout());
+    if (count > 0 && (fhs.revents & POLLIN)) {
+        ssize_t read_len = _fileHandle->read(buf, len);
+        if (read_len > 0) {
+            debug_print((char *)buf, read_len, AT_RX);
+            return read_len;
+        }
+    }
+    return -1;
+}
+
+bool ATHandler::consume_bytes(uint8_t *buf, size_t len)
+{
+    size_t read_len = 0;
+    while (read_len < len) {
+        if (_recv_pos == _recv_len) {
+            // long data is read past the receiving buffer
+            if (buf && len - read_len >= sizeof(_recv_buff)) {
+                ssize_t direct_len = read_direct(buf + read_len, len - read_len);
+                if (direct_len < 0) {
+                    tr_warn("AT timeout");
+                    set_error(NSAPI_ERROR_DEVICE_ERROR);
+                    return false;
+                }
+                read_len += direct_len;
+                continue;
+            }
+            if (!fill_buffer()) {
+                tr_warn("AT timeout");
+                set_error(NSAPI_ERROR_DEVICE_ERROR);
+                return false;
+            }
+        }
+
+        // unread content up to the end of the buffer, the rest wraps to the beginning
+        size_t chunk = _recv_len - _recv_pos;
+        if (chunk > sizeof(_recv_buff) - _recv_pos) {
+            chunk = sizeof(_recv_buff) - _recv_pos;
+        }
+        if (chunk > len - read_len) {
+            chunk = len - read_len;
+        }
+        if (buf) {
+            memcpy(buf + read_len, _recv_buff + _recv_pos, chunk);
+        }
+        advance_buffer(chunk);
+        read_len += chunk;
+    }
+    return true;
+}
+
 int ATHandler::get_char()
 {
     if (_recv_pos == _recv_len) {
@@ -429,7 +627,9 @@ int ATHandler::get_char()
         }
     }
 
-    return _recv_buff[_recv_pos++];
+    const char c = _recv_buff[_recv_pos];
+    advance_buffer(1);
+    return c;
 }
 
 void ATHandler::skip_param(uint32_t count)
@@ -497,16 +697,11 @@ ssize_t ATHandler::read_bytes(uint8_t *buf, size_t len)
         disabled_debug = true;
     }
 
-    size_t read_len = 0;
-    for (; read_len < len; read_len++) {
-        int c = get_char();
-        if (c == -1) {
-            set_error(NSAPI_ERROR_DEVICE_ERROR);
-            _debug_on = debug_on;
-            return -1;
-        }
-        buf[read_len] = c;
+    if (!consume_bytes(buf, len)) {
+        _debug_on = debug_on;
+        return -1;
     }
+    size_t read_len = len;
 
 #if DEBUG_AT_ENABLED
     if (debug_on && disabled_debug) {
@@ -520,6 +715,22 @@ ssize_t ATHandler::read_bytes(uint8_t *buf, size_t len)
     return read_len;
 }
 
+ssize_t ATHandler::read_binary(uint8_t *buf, size_t size, size_t data_len)
+{
+    const size_t read_len = data_len < size ? data_len : size;
+    if (read_bytes(buf, read_len) < 0) {
+        return -1;
+    }
+
+    if (data_len > read_len) {
+        tr_warn("Discard %u bytes", data_len - read_len);
+        if (!consume_bytes(NULL, data_len - read_len)) {
+            return -1;
+        }
+    }
+    return read_len;
+}
+
 ssize_t ATHandler::read_string(char *buf, size_t size, bool read_even_stop_tag)
 {
     if (!ok_to_proceed() || !_stop_tag || (_stop_tag->found && read_even_stop_tag == false)) {
@@ -769,38 +980,55 @@ void ATHandler::set_scope(ScopeType scope_type)
 // should match from recv_pos?
 bool ATHandler::match(const char *str, size_t size)
 {
-    rewind_buffer();
-
     if ((_recv_len - _recv_pos) < size) {
         return false;
     }
 
-    if (str && memcmp(_recv_buff + _recv_pos, str, size) == 0) {
+    if (str && buffer_equals(0, str, size)) {
         // consume matching part
-        _recv_pos += size;
+        advance_buffer(size);
         return true;
     }
     return false;
 }
 
-bool ATHandler::match_urc()
+ATHandler::oob_t *ATHandler::find_urc() const
 {
-    rewind_buffer();
-    size_t prefix_len = 0;
-    for (struct oob_t *oob = _oobs; oob; oob = oob->next) {
-        prefix_len = oob->prefix_len;
-        if (_recv_len >= prefix_len) {
-            if (match(oob->prefix, prefix_len)) {
-                set_scope(InfoType);
-                if (oob->cb) {
-                    oob->cb();
-                }
-                information_response_stop();
-                return true;
-            }
+    const size_t unread = _recv_len - _recv_pos;
+    oob_t *found = NULL;
+    size_t pos = 0;
+
+    for (urc_node_t *node = _urc_tree; node && pos < unread; node = node->child) {
+        const char c = _recv_buff[buffer_index(pos)];
+        while (node && node->label[0] != c) {
+            node = node->sibling;
+        }
+        if (!node || unread - pos < node->label_len || !buffer_equals(pos, node->label, node->label_len)) {
+            break;
+        }
+        pos += node->label_len;
+        if (node->oob) {
+            found = node->oob;
         }
     }
-    return false;
+
+    return found;
+}
+
+bool ATHandler::match_urc()
+{
+    struct oob_t *oob = find_urc();
+    if (!oob) {
+        return false;
+    }
+
+    advance_buffer(oob->prefix_len);
+    set_scope(InfoType);
+    if (oob->cb) {
+        oob->cb();
+    }
+    information_response_stop();
+    return true;
 }
 
 bool ATHandler::match_error()
@@ -925,7 +1153,7 @@ void ATHandler::resp(const char *prefix, bool check_urc)
         }
 
         // If no match found, look for CRLF and consume everything up to and including CRLF
-        if (mem_str(_recv_buff, _recv_len, CRLF, CRLF_LENGTH)) {
+        if (buffer_contains(CRLF, CRLF_LENGTH)) {
             // If no prefix, return on CRLF - means data to read
             if (!prefix || (prefix && !strlen(prefix))) {
                 return;
@@ -956,7 +1184,6 @@ void ATHandler::resp_start(const char *prefix, bool stop)
 
     set_scope(NotSet);
     // Try get as much data as possible
-    rewind_buffer();
     (void)fill_buffer(false);
 
     if (prefix) {
@@ -1037,7 +1264,7 @@ bool ATHandler::consume_char(char ch)
     }
     // If we read something else than ch, recover it
     if (read_char != ch) {
-        _recv_pos--;
+        rewind_buffer(1);
         return false;
     }
     return true;
@@ -1068,7 +1295,7 @@ bool ATHandler::consume_to_tag(const char *tag, bool consume_tag)
     }
 
     if (!consume_tag) {
-        _recv_pos -= tag_length;
+        rewind_buffer(tag_length);
     }
     return true;
 }
@@ -1123,7 +1350,7 @@ void ATHandler::resp_stop()
                 }
 
                 // If no URC nor stop_tag found, look for CRLF and consume everything up to and including CRLF
-                if (mem_str(_recv_buff, _recv_len, CRLF, CRLF_LENGTH)) {
+                if (buffer_contains(CRLF, CRLF_LENGTH)) {
                     consume_to_tag(CRLF, true);
                     // If stop tag is CRLF we have to stop reading/consuming the buffer
                     if (!strncmp(CRLF, _stop_tag->tag, _stop_tag->len)) {
@@ -1171,18 +1398,6 @@ ATHandler::ScopeType ATHandler::get_scope()
     return _current_scope;
 }
 
-const char *ATHandler::mem_str(const char *dest, size_t dest_len, const char *src, size_t src_len)
-{
-    if (dest_len >= src_len) {
-        for (size_t i = 0; i < dest_len - src_len + 1; ++i) {
-            if (memcmp(dest + i, src, src_len) == 0) {
-                return dest + i;
-            }
-        }
-    }
-    return NULL;
-}
-
 void ATHandler::cmd_start(const char *cmd)
 {
     if (!ok_to_proceed()) {
@@ -1324,6 +1539,200 @@ nsapi_error_t ATHandler::at_cmd_discard(const char *cmd, const char *cmd_chr, co
     return unlock_return_error();
 }
 
+nsapi_error_t ATHandler::at_cmd_pipeline(at_pipeline_cmd_t *cmds, size_t count)
+{
+    lock();
+
+    size_t done = 0;
+    while (done < count && ok_to_proceed()) {
+        _start_time = rtos::Kernel::Clock::now();
+        if (_pipeline_mode == PipelineConcatenate) {
+            done += pipeline_concatenate(cmds + done, count - done);
+        } else {
+            done += pipeline_stream(cmds + done, count - done, _pipeline_mode == PipelineStream ? PIPELINE_DEPTH : 1);
+        }
+    }
+
+    nsapi_error_t err = NSAPI_ERROR_OK;
+    for (size_t i = 0; i < count; i++) {
+        if (i >= done) {
+            cmds[i].err = _last_err;
+        }
+        if (err == NSAPI_ERROR_OK) {
+            err = cmds[i].err;
+        }
+    }
+    _last_err = err;
+
+    return unlock_return_error();
+}
+
+size_t ATHandler::pipeline_stream(at_pipeline_cmd_t *cmds, size_t count, size_t depth)
+{
+    const size_t sent = count < depth ? count : depth;
+    _error_found = false;
+
+    for (size_t i = 0; i < sent; i++) {
+        handle_start(cmds[i].cmd, cmds[i].cmd_chr);
+        cmd_stop();
+    }
+
+    for (size_t i = 0; i < sent; i++) {
+        // each command has its own response timeout
+        _start_time = rtos::Kernel::Clock::now();
+        resp_start(cmds[i].resp_prefix);
+        if (cmds[i].resp_prefix) {
+            while (info_resp()) {
+                if (cmds[i].resp_cb) {
+                    cmds[i].resp_cb();
+                }
+            }
+        } else if (cmds[i].resp_cb && ok_to_proceed() && !_resp_stop.found) {
+            cmds[i].resp_cb();
+        }
+        resp_stop();
+
+        if (!pipeline_cmd_done(cmds[i])) {
+            return i + 1;
+        }
+    }
+
+    return sent;
+}
+
+size_t ATHandler::pipeline_concatenate(at_pipeline_cmd_t *cmds, size_t count)
+{
+    char line[PIPELINE_LINE_LENGTH + 1];
+    size_t len = 2;
+    memcpy(line, "AT", len);
+
+    // Only extended commands can be concatenated with ';'. An information response without prefix cannot
+    // be told apart from the other commands' ones.
+    size_t n = 0;
+    for (; n < count; n++) {
+        const char *cmd_chr = cmds[n].cmd_chr ? cmds[n].cmd_chr : "";
+        const size_t cmd_len = strlen(cmds[n].cmd);
+        const size_t cmd_chr_len = strlen(cmd_chr);
+        const size_t separator_len = n ? 1 : 0;
+
+        if (cmds[n].cmd[0] != '+' || (!cmds[n].resp_prefix && cmds[n].resp_cb) ||
+                len + separator_len + cmd_len + cmd_chr_len > PIPELINE_LINE_LENGTH) {
+            break;
+        }
+        if (separator_len) {
+            line[len++] = ';';
+        }
+        memcpy(line + len, cmds[n].cmd, cmd_len);
+        len += cmd_len;
+        memcpy(line + len, cmd_chr, cmd_chr_len);
+        len += cmd_chr_len;
+    }
+    line[len] = '\0';
+
+    if (n < 2) {
+        return pipeline_stream(cmds, 1, 1);
+    }
+
+    cmd_start(line);
+    cmd_stop();
+
+    const size_t answered = resp_concatenated(cmds, n);
+    for (size_t i = 0; i < answered; i++) {
+        cmds[i].err = NSAPI_ERROR_OK;
+    }
+
+    if (answered == n || !_error_found) {
+        // all done, or timeout which leaves the rest of the commands without result
+        return answered;
+    }
+
+    // The modem does not tell which command failed, the first one not answered is sent again alone
+    _last_err = NSAPI_ERROR_OK;
+    return answered + pipeline_stream(cmds + answered, 1, 1);
+}
+
+size_t ATHandler::resp_concatenated(at_pipeline_cmd_t *cmds, size_t count)
+{
+    size_t current = 0;
+    size_t answered = 0;
+
+    if (!ok_to_proceed()) {
+        return 0;
+    }
+
+    set_scope(NotSet);
+    // Try get as much data as possible
+    (void)fill_buffer(false);
+    set_scope(RespType);
+    _error_found = false;
+
+    while (!get_last_error()) {
+
+        (void)match(CRLF, CRLF_LENGTH);
+
+        if (match(OK, OK_LENGTH)) {
+            _stop_tag->found = true;
+            answered = count;
+            break;
+        }
+
+        if (match_error()) {
+            _error_found = true;
+            break;
+        }
+
+        // The information responses come in command order
+        size_t i = current;
+        for (; i < count; i++) {
+            if (cmds[i].resp_prefix && match(cmds[i].resp_prefix, strlen(cmds[i].resp_prefix))) {
+                break;
+            }
+        }
+        if (i < count) {
+            current = i;
+            answered = i + 1;
+            set_scope(InfoType);
+            if (cmds[i].resp_cb) {
+                cmds[i].resp_cb();
+            }
+            if (get_scope() == ElemType) {
+                information_response_element_stop();
+            }
+            information_response_stop();
+            continue;
+        }
+
+        if (match_urc()) {
+            clear_error();
+            continue;
+        }
+
+        // If no match found, look for CRLF and consume everything up to and including CRLF
+        if (buffer_contains(CRLF, CRLF_LENGTH)) {
+            consume_to_tag(CRLF, true);
+        } else if (!fill_buffer()) {
+            // if we don't get any match and no data within timeout, set an error to indicate need for recovery
+            set_error(NSAPI_ERROR_DEVICE_ERROR);
+        }
+    }
+
+    resp_stop();
+
+    return answered;
+}
+
+bool ATHandler::pipeline_cmd_done(at_pipeline_cmd_t &cmd)
+{
+    cmd.err = _last_err;
+
+    // The modem goes on with the next command after an ERROR response, not after a timeout
+    if (_last_err != NSAPI_ERROR_OK && _error_found && _is_fh_usable) {
+        _last_err = NSAPI_ERROR_OK;
+    }
+
+    return _last_err == NSAPI_ERROR_OK;
+}
+
 void ATHandler::write_int(int32_t param)
 {
     // do common checks before sending subparameter
@@ -1551,6 +1960,11 @@ void ATHandler::set_send_delay(uint16_t send_delay)
     _at_send_delay = std::chrono::duration<uint16_t, std::milli>(send_delay);
 }
 
+void ATHandler::set_pipeline_mode(PipelineMode mode)
+{
+    _pipeline_mode = mode;
+}
+
 void ATHandler::write_hex_string(const char *str, size_t size, bool quote_string)
 {
     // do common checks before sending subparameter
@@ -1561,11 +1975,19 @@ void ATHandler::write_hex_string(const char *str, size_t size, bool quote_string
     if (quote_string) {
         (void) write("\"", 1);
     }
-    char hexbuf[2];
+    // converted in chunks to write more than a byte at a time
+    char hexbuf[HEX_WRITE_CHUNK];
+    size_t hex_len = 0;
     for (size_t i = 0; i < size; i++) {
-        hexbuf[0] = hex_values[((str[i]) >> 4) & 0x0F];
-        hexbuf[1] = hex_values[(str[i]) & 0x0F];
-        write(hexbuf, 2);
+        hexbuf[hex_len++] = hex_values[((str[i]) >> 4) & 0x0F];
+        hexbuf[hex_len++] = hex_values[(str[i]) & 0x0F];
+        if (hex_len == sizeof(hexbuf)) {
+            write(hexbuf, hex_len);
+            hex_len = 0;
+        }
+    }
+    if (hex_len) {
+        write(hexbuf, hex_len);
     }
     if (quote_string) {
         (void) write("\"", 1);
@@ -41,6 +41,9 @@ CellularDevice::CellularDevice() :
 #endif //MBED_CONF_CELLULAR_USE_SMS
     _info_ref_count(0), _queue(10 * EVENTS_EVENT_SIZE), _state_machine(0),
     _status_cb(), _nw(0)
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    , _resume_store(0)
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
 #ifdef MBED_CONF_RTOS_PRESENT
     , _queue_thread(osPriorityNormal, 2048, NULL, "cellular_queue")
 #endif // MBED_CONF_RTOS_PRESENT
@@ -95,6 +98,16 @@ void CellularDevice::set_plmn(const char *plmn)
     }
 }
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+void CellularDevice::set_resume_store(KVStore *store)
+{
+    _resume_store = store;
+    if (_state_machine) {
+        _state_machine->set_resume_store(store);
+    }
+}
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 nsapi_error_t CellularDevice::set_device_ready()
 {
     return start_state_machine(CellularStateMachine::STATE_DEVICE_READY);
@@ -130,6 +143,9 @@ nsapi_error_t CellularDevice::create_state_machine()
         if (strlen(_sim_pin)) {
             _state_machine->set_sim_pin(_sim_pin);
         }
+#if MBED_CONF_CELLULAR_FAST_RESUME
+        _state_machine->set_resume_store(_resume_store);
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
     }
     err = _state_machine->start_dispatch();
     if (err) {
@@ -19,6 +19,10 @@
 #include "CellularDevice.h"
 #include "CellularLog.h"
 #include "CellularInformation.h"
+#if MBED_CONF_CELLULAR_FAST_RESUME
+#include "kvstore/KVStore.h"
+#include "platform/mbed_error.h"
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
 
 using namespace std::chrono_literals;
 
@@ -43,6 +47,12 @@ using namespace std::chrono_literals;
 
 #define RETRY_COUNT_DEFAULT 3
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+// key and version of the network state kept for fast resume
+#define RESUME_STATE_KEY     "cellular_resume"
+#define RESUME_STATE_VERSION 1
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 
 const int STM_STOPPED = -99;
 const int ACTIVE_PDP_CONTEXT = 0x01;
@@ -51,6 +61,39 @@ const int DEVICE_READY = 0x04;
 
 namespace mbed {
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+/** Network state kept for fast resume */
+typedef struct {
+    uint8_t version;
+    uint8_t reg_type;           // CellularNetwork::RegistrationType registered with
+    uint8_t rat;                // CellularNetwork::RadioAccessTechnology
+    uint8_t op_format;          // format of plmn, see AT+COPS
+    int32_t periodic_tau;       // T3412 in seconds, -1 if not known
+    int32_t active_time;        // T3324 in seconds, -1 if not known
+    char iccid[MAX_ICCID_LENGTH];
+    char plmn[MAX_OPERATOR_NAME_LONG + 1];
+} cellular_resume_state_t;
+
+static bool load_resume_state(KVStore *store, cellular_resume_state_t &state)
+{
+    size_t size = 0;
+    return store->get(RESUME_STATE_KEY, &state, sizeof(state), &size) == MBED_SUCCESS && size == sizeof(state) &&
+           state.version == RESUME_STATE_VERSION;
+}
+
+static void store_resume_state(KVStore *store, const cellular_resume_state_t &state)
+{
+    cellular_resume_state_t stored;
+    // write only changes to save the flash
+    if (load_resume_state(store, stored) && memcmp(&stored, &state, sizeof(state)) == 0) {
+        return;
+    }
+    if (store->set(RESUME_STATE_KEY, &state, sizeof(state), 0) != MBED_SUCCESS) {
+        tr_warn("Storing network state failed");
+    }
+}
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 CellularStateMachine::CellularStateMachine(CellularDevice &device, events::EventQueue &queue, CellularNetwork &nw) :
     _cellularDevice(device), _state(STATE_INIT), _next_state(_state), _target_state(_state),
     _event_status_cb(), _network(nw), _queue(queue), _sim_pin(0), _retry_count(0),
@@ -60,7 +103,11 @@ CellularStateMachine::CellularStateMachine(CellularDevice &device, events::Event
     // so that not every device don't start at the exact same time (for example after power outage)
     _start_time(rand() % (MBED_CONF_CELLULAR_RANDOM_MAX_START_DELAY)),
 #endif // MBED_CONF_CELLULAR_RANDOM_MAX_START_DELAY
-    _event_timeout(-1s), _event_id(-1), _plmn(0), _command_success(false),
+    _event_timeout(-1s), _event_id(-1), _plmn(0),
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    _resume_store(0), _resumed(false), _resume_stale(true),
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+    _command_success(false),
     _is_retry(false), _cb_data(), _current_event(CellularDeviceReady), _status(0)
 {
 
@@ -96,6 +143,10 @@ void CellularStateMachine::reset()
     _event_timeout = -1s;
     _event_id = -1;
     _is_retry = false;
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    _resumed = false;
+    _resume_stale = true;
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
     _status = 0;
     _target_state = STATE_INIT;
     enter_to_state(STATE_INIT);
@@ -128,6 +179,13 @@ void CellularStateMachine::set_plmn(const char *plmn)
     _plmn = plmn;
 }
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+void CellularStateMachine::set_resume_store(KVStore *store)
+{
+    _resume_store = store;
+}
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 bool CellularStateMachine::open_sim()
 {
     CellularDevice::SimState state = CellularDevice::SimStateUnknown;
@@ -353,6 +411,114 @@ bool CellularStateMachine::device_ready()
     return true;
 }
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+bool CellularStateMachine::resume_network()
+{
+#ifdef MBED_CONF_CELLULAR_CLEAR_ON_CONNECT
+    // the modem is cleared on each connect, there is no registration to resume
+    return false;
+#else
+    cellular_resume_state_t state;
+    if (!_resume_store || !load_resume_state(_resume_store, state)) {
+        return false;
+    }
+
+    // manual registration must be to the network registered with
+    if (_plmn && strlen(_plmn) && (state.op_format != 2 || strcmp(_plmn, state.plmn) != 0)) {
+        return false;
+    }
+
+    // the state is kept for the next run if the modem was power cycled, no need to write it again
+    _resume_stale = false;
+
+    // not registered after a cold boot, ask it before the SIM
+    CellularNetwork::registration_params_t reg_params;
+    nsapi_error_t err = _network.get_registration_params((CellularNetwork::RegistrationType)state.reg_type, reg_params);
+    if (err != NSAPI_ERROR_OK || (reg_params._status != CellularNetwork::RegisteredHomeNetwork &&
+                                  reg_params._status != CellularNetwork::RegisteredRoaming)) {
+        tr_info("Fast resume: not registered");
+        return false;
+    }
+
+    char iccid[MAX_ICCID_LENGTH];
+    CellularInformation *info = _cellularDevice.open_information();
+    if (!info) {
+        return false;
+    }
+    err = info->get_iccid(iccid, sizeof(iccid));
+    _cellularDevice.close_information();
+    if (err != NSAPI_ERROR_OK) {
+        return false;
+    }
+    if (strcmp(iccid, state.iccid) != 0) {
+        tr_info("Fast resume: not the same SIM");
+        _resume_stale = true;
+        return false;
+    }
+
+    tr_info("Fast resume: registered with the same SIM");
+
+    // event reporting set in the SIM state does not survive a power cycle of the modem
+    (void)_network.set_registration_urc((CellularNetwork::RegistrationType)state.reg_type, true);
+    (void)_network.set_packet_domain_event_reporting(true);
+
+    // the network may have changed the RAT or the PSM timers
+    state.rat = reg_params._act;
+    state.periodic_tau = reg_params._periodic_tau;
+    state.active_time = reg_params._active_time;
+    store_resume_state(_resume_store, state);
+
+    // report the states skipped
+    _cb_data.error = NSAPI_ERROR_OK;
+    _cb_data.status_data = CellularDevice::SimStateReady;
+    send_event_cb(CellularSIMStatusChanged);
+    _cb_data.status_data = reg_params._status;
+    send_event_cb(CellularRegistrationStatusChanged);
+
+    return true;
+#endif // MBED_CONF_CELLULAR_CLEAR_ON_CONNECT
+}
+
+void CellularStateMachine::store_network_state()
+{
+    CellularNetwork::registration_params_t reg_params;
+    // registration read last by is_registered() or by an URC
+    if (_network.get_registration_params(reg_params) != NSAPI_ERROR_OK ||
+            (reg_params._type != CellularNetwork::C_EREG && reg_params._type != CellularNetwork::C_GREG) ||
+            (reg_params._status != CellularNetwork::RegisteredHomeNetwork &&
+             reg_params._status != CellularNetwork::RegisteredRoaming)) {
+        return;
+    }
+
+    cellular_resume_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.version = RESUME_STATE_VERSION;
+    state.reg_type = reg_params._type;
+    state.rat = reg_params._act;
+    state.periodic_tau = reg_params._periodic_tau;
+    state.active_time = reg_params._active_time;
+
+    CellularInformation *info = _cellularDevice.open_information();
+    if (!info) {
+        return;
+    }
+    nsapi_error_t err = info->get_iccid(state.iccid, sizeof(state.iccid));
+    _cellularDevice.close_information();
+    if (err != NSAPI_ERROR_OK) {
+        return;
+    }
+
+    int format;
+    CellularNetwork::operator_t op;
+    if (_network.get_operator_params(format, op) == NSAPI_ERROR_OK) {
+        state.op_format = format;
+        strncpy(state.plmn, format == 2 ? op.op_num : (format == 1 ? op.op_short : op.op_long), sizeof(state.plmn) - 1);
+    }
+
+    store_resume_state(_resume_store, state);
+}
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 void CellularStateMachine::state_device_ready()
 {
     change_timeout(_state_timeout_power_on);
@@ -385,7 +551,12 @@ void CellularStateMachine::state_device_ready()
 
             if (device_ready()) {
                 _status = 0;
+#if MBED_CONF_CELLULAR_FAST_RESUME
+                _resumed = _target_state > STATE_DEVICE_READY && resume_network();
+                enter_to_state(_resumed ? STATE_ATTACHING_NETWORK : STATE_SIM_PIN);
+#else
                 enter_to_state(STATE_SIM_PIN);
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
             } else {
                 tr_warning("Power cycle CellularDevice and restart connecting");
                 (void) _cellularDevice.soft_power_off();
@@ -491,6 +662,12 @@ void CellularStateMachine::state_attaching()
         _cb_data.error = _network.set_attach();
     }
     if (_cb_data.error == NSAPI_ERROR_OK) {
+#if MBED_CONF_CELLULAR_FAST_RESUME
+        // written when missing or found for an other SIM or network
+        if (_resume_store && !_resumed && _resume_stale) {
+            store_network_state();
+        }
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
         _cb_data.status_data = CellularNetwork::Attached;
         send_event_cb(_current_event);
     } else {
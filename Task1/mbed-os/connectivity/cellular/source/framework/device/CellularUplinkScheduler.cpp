@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits.h>
+#include <string.h>
+#include "CellularUplinkScheduler.h"
+#include "CellularLog.h"
+
+using namespace mbed;
+
+// length of a queued message, before its data
+const nsapi_size_t MSG_HEADER_LEN = 2;
+
+// true if tick a is before tick b, the ticks wrap around
+static bool tick_before(unsigned a, unsigned b)
+{
+    return (int)(a - b) < 0;
+}
+
+CellularUplinkScheduler::CellularUplinkScheduler(events::EventQueue &queue, send_cb_t send_cb, nsapi_size_t buffer_size,
+                                                 std::chrono::duration<int> max_delay) :
+    _queue(queue),
+    _send_cb(send_cb),
+    _buffer(new uint8_t[buffer_size]),
+    _buffer_size(buffer_size),
+    _buffer_len(0),
+    _queued(0),
+    _max_delay(max_delay),
+    _periodic_tau(-1),
+    _active_time(-1),
+    _first_queued(0),
+    _last_send(0),
+    _awake_until(0),
+    _sent(false),
+    _event_id(0)
+{
+}
+
+CellularUplinkScheduler::~CellularUplinkScheduler()
+{
+    if (_event_id) {
+        _queue.cancel(_event_id);
+    }
+    delete [] _buffer;
+}
+
+nsapi_size_or_error_t CellularUplinkScheduler::send(const void *data, nsapi_size_t size, bool urgent)
+{
+    _mutex.lock();
+    const unsigned now = _queue.tick();
+    const bool fits = size <= 0xFFFF && _buffer_len + MSG_HEADER_LEN + size <= _buffer_size;
+
+    if (urgent || awake(now) || !fits) {
+        // queued messages go first, in the same wake
+        (void)send_queued();
+        nsapi_size_or_error_t ret = transmit(data, size);
+        if (urgent && ret >= 0) {
+            _stats.urgent++;
+        }
+        _mutex.unlock();
+        return ret;
+    }
+
+    _buffer[_buffer_len] = size >> 8;
+    _buffer[_buffer_len + 1] = size & 0xFF;
+    memcpy(_buffer + _buffer_len + MSG_HEADER_LEN, data, size);
+    _buffer_len += MSG_HEADER_LEN + size;
+    if (_queued++ == 0) {
+        _first_queued = now;
+    }
+    schedule_flush();
+
+    _mutex.unlock();
+    return size;
+}
+
+nsapi_error_t CellularUplinkScheduler::flush()
+{
+    _mutex.lock();
+    nsapi_error_t err = send_queued();
+    _mutex.unlock();
+    return err;
+}
+
+void CellularUplinkScheduler::set_power_save_timers(const CellularNetwork::registration_params_t &reg_params)
+{
+    _mutex.lock();
+    tr_info("Uplink scheduler T3412 %d s, T3324 %d s", reg_params._periodic_tau, reg_params._active_time);
+    _periodic_tau = reg_params._periodic_tau;
+    _active_time = reg_params._active_time;
+    if (_queued) {
+        schedule_flush();
+    }
+    _mutex.unlock();
+}
+
+void CellularUplinkScheduler::radio_active()
+{
+    _mutex.lock();
+    const unsigned now = _queue.tick();
+    _last_send = now;
+    _sent = true;
+    if (_active_time > 0) {
+        _awake_until = now + _active_time * 1000;
+    }
+    (void)send_queued();
+    _mutex.unlock();
+}
+
+int CellularUplinkScheduler::queued() const
+{
+    _mutex.lock();
+    int queued = _queued;
+    _mutex.unlock();
+    return queued;
+}
+
+CellularUplinkScheduler::uplink_stats_t CellularUplinkScheduler::get_stats() const
+{
+    _mutex.lock();
+    uplink_stats_t stats = _stats;
+    _mutex.unlock();
+    return stats;
+}
+
+bool CellularUplinkScheduler::awake(unsigned now) const
+{
+    return _sent && _active_time > 0 && tick_before(now, _awake_until);
+}
+
+nsapi_size_or_error_t CellularUplinkScheduler::transmit(const void *data, nsapi_size_t size)
+{
+    const unsigned now = _queue.tick();
+    if (!awake(now)) {
+        _stats.wakes++;
+    }
+
+    nsapi_size_or_error_t ret = _send_cb(data, size);
+    if (ret < 0) {
+        tr_warn("Uplink send failed %d", ret);
+        _stats.errors++;
+        return ret;
+    }
+
+    _stats.messages++;
+    _last_send = now;
+    _sent = true;
+    if (_active_time > 0) {
+        // the modem stays reachable for T3324 after going idle, counted from the send
+        _awake_until = now + _active_time * 1000;
+    }
+    return ret;
+}
+
+nsapi_error_t CellularUplinkScheduler::send_queued()
+{
+    if (_event_id) {
+        _queue.cancel(_event_id);
+        _event_id = 0;
+    }
+    if (_queued == 0) {
+        return NSAPI_ERROR_OK;
+    }
+
+    tr_debug("Uplink batch of %d messages", _queued);
+    _stats.batches++;
+
+    nsapi_error_t err = NSAPI_ERROR_OK;
+    nsapi_size_t pos = 0;
+    while (pos < _buffer_len) {
+        const nsapi_size_t size = (_buffer[pos] << 8) | _buffer[pos + 1];
+        nsapi_size_or_error_t ret = transmit(_buffer + pos + MSG_HEADER_LEN, size);
+        if (ret < 0) {
+            err = ret;
+            break;
+        }
+        pos += MSG_HEADER_LEN + size;
+        _queued--;
+    }
+
+    // messages not sent are kept and retried with the next batch
+    memmove(_buffer, _buffer + pos, _buffer_len - pos);
+    _buffer_len -= pos;
+    if (_queued) {
+        _first_queued = _queue.tick();
+        schedule_flush();
+    }
+    return err;
+}
+
+void CellularUplinkScheduler::schedule_flush()
+{
+    if (_event_id) {
+        _queue.cancel(_event_id);
+        _event_id = 0;
+    }
+
+    const unsigned now = _queue.tick();
+    unsigned deadline = _first_queued + _max_delay.count();
+    const uint64_t tau_ms = (uint64_t)_periodic_tau * 1000;
+    if (_sent && _periodic_tau > 0 && tau_ms < INT_MAX) {
+        // the modem wakes up for the periodic TAU at the latest, the batch replaces that wake
+        const unsigned tau = _last_send + (unsigned)tau_ms;
+        if (tick_before(now, tau) && tick_before(tau, deadline)) {
+            deadline = tau;
+        }
+    }
+
+    const int delay = tick_before(now, deadline) ? (int)(deadline - now) : 0;
+    _event_id = _queue.call_in(std::chrono::duration<int, std::milli>(delay),
+                               callback(this, &CellularUplinkScheduler::flush_event));
+    if (!_event_id) {
+        tr_error("Uplink flush not scheduled");
+    }
+}
+
+void CellularUplinkScheduler::flush_event()
+{
+    _mutex.lock();
+    _event_id = 0;
+    (void)send_queued();
+    _mutex.unlock();
+}
@@ -94,6 +94,7 @@ ATHandler::ATHandler(FileHandle *fh, EventQueue &queue, mbed::chrono::millisecon
     _ref_count(1),
     _oob_string_max_length(0),
     _oobs(NULL),
+    _urc_tree(NULL),
     _max_resp_length(MAX_RESP_LENGTH)
 {
     ATHandler_stub::process_oob_urc = false;
@@ -206,6 +207,11 @@ ssize_t ATHandler::read_bytes(uint8_t *buf, size_t len)
     return ATHandler_stub::ssize_value;
 }
 
+ssize_t ATHandler::read_binary(uint8_t *buf, size_t size, size_t data_len)
+{
+    return ATHandler_stub::ssize_value;
+}
+
 ssize_t ATHandler::read_string(char *buf, size_t size, bool read_even_stop_tag)
 {
     buf[0] = '\0';
@@ -379,6 +385,18 @@ void ATHandler::set_send_delay(uint16_t send_delay)
 {
 }
 
+void ATHandler::set_pipeline_mode(PipelineMode mode)
+{
+}
+
+nsapi_error_t ATHandler::at_cmd_pipeline(at_pipeline_cmd_t *cmds, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        cmds[i].err = ATHandler_stub::nsapi_error_value;
+    }
+    return ATHandler_stub::nsapi_error_value;
+}
+
 void ATHandler::set_baud(int baud_rate)
 {
 }
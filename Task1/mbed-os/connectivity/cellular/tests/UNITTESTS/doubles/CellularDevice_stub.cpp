@@ -44,6 +44,9 @@ CellularDevice::CellularDevice() :
 #endif //MBED_CONF_CELLULAR_USE_SMS
     _info_ref_count(0), _queue(10 * EVENTS_EVENT_SIZE), _state_machine(0),
     _nw(0), _status_cb(0)
+#if MBED_CONF_CELLULAR_FAST_RESUME
+    , _resume_store(0)
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
 {
 }
 
@@ -61,6 +64,12 @@ void CellularDevice::set_plmn(char const *)
 {
 }
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+void CellularDevice::set_resume_store(KVStore *)
+{
+}
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 void CellularDevice::set_sim_pin(char const *)
 {
 }
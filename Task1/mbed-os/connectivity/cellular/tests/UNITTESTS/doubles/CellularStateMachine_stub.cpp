@@ -52,6 +52,12 @@ void CellularStateMachine::set_plmn(const char *plmn)
 {
 }
 
+#if MBED_CONF_CELLULAR_FAST_RESUME
+void CellularStateMachine::set_resume_store(KVStore *store)
+{
+}
+#endif // MBED_CONF_CELLULAR_FAST_RESUME
+
 nsapi_error_t CellularStateMachine::run_to_state(CellularStateMachine::CellularState state)
 {
     return CellularStateMachine_stub::nsapi_error_value;
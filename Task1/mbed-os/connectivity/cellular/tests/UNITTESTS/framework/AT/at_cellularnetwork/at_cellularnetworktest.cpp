@@ -89,6 +89,7 @@ TEST_F(TestAT_CellularNetwork, Create)
 int expected_rat = 0;
 int expected_status = 0;
 int expected_cellid = 0;
+int psm_timer_events = 0;
 
 void status_cb_urc(nsapi_event_t ev, intptr_t ptr)
 {
@@ -106,6 +107,12 @@ void status_cb_urc(nsapi_event_t ev, intptr_t ptr)
         EXPECT_EQ(NSAPI_ERROR_OK, data->error);
         EXPECT_EQ(expected_cellid, data->status_data);
         break;
+    case CellularPowerSaveTimersChanged:
+        EXPECT_EQ(NSAPI_ERROR_OK, data->error);
+        EXPECT_EQ(240, ((const CellularNetwork::registration_params_t *)data->data)->_active_time);
+        EXPECT_EQ(252000, ((const CellularNetwork::registration_params_t *)data->data)->_periodic_tau);
+        psm_timer_events++;
+        break;
     default:
         if (ev == NSAPI_EVENT_CONNECTION_STATUS_CHANGE) {
             EXPECT_EQ(NSAPI_STATUS_DISCONNECTED, (int)ptr);
@@ -123,6 +130,7 @@ TEST_F(TestAT_CellularNetwork, test_urc_creg)
 
     AT_CellularNetwork cn(at, *_dev);
     cn.attach(status_cb_urc);
+    psm_timer_events = 0;
 
     EXPECT_STREQ("+CEREG:", ATHandler_stub::urc_handlers[0].urc);
     EXPECT_STREQ("+CREG:", ATHandler_stub::urc_handlers[1].urc);
@@ -164,6 +172,8 @@ TEST_F(TestAT_CellularNetwork, test_urc_creg)
     ATHandler_stub::read_string_table[0] = "01000111"; // [8] periodic-tau
 
     ATHandler_stub::urc_handlers[0].cb();
+    // PSM timers are reported once, they did not change
+    EXPECT_EQ(1, psm_timer_events);
     ATHandler_stub::read_string_index = kRead_string_table_size;
     ATHandler_stub::read_string_value = NULL;
     ATHandler_stub::ssize_value = 0;
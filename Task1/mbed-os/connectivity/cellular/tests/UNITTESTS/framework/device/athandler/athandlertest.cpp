@@ -40,6 +40,32 @@ void urc2_callback()
 {
 }
 
+uint8_t urc_cereg_callback_count;
+ATHandler *urc_at;
+int32_t urc_value;
+
+void urc_cereg_callback()
+{
+    urc_cereg_callback_count++;
+    if (urc_at) {
+        urc_value = urc_at->read_int();
+    }
+}
+
+int32_t csq_value;
+int32_t cereg_value;
+
+void csq_resp_callback()
+{
+    csq_value = urc_at->read_int();
+}
+
+void cereg_resp_callback()
+{
+    (void)urc_at->read_int();
+    cereg_value = urc_at->read_int();
+}
+
 // AStyle ignored as the definition is not clear due to preprocessor usage
 // *INDENT-OFF*
 class TestATHandler : public testing::Test {
@@ -48,6 +74,11 @@ protected:
     void SetUp()
     {
         urc_callback_count = 0;
+        urc_cereg_callback_count = 0;
+        urc_at = NULL;
+        urc_value = -1;
+        csq_value = -1;
+        cereg_value = -1;
         CellularUtil_stub::char_ptr = NULL;
         CellularUtil_stub::char_pos = 0;
         filehandle_stub_short_value_counter = 0;
@@ -257,6 +288,60 @@ TEST_F(TestATHandler, test_ATHandler_process_oob)
     filehandle_stub_table = NULL;
 }
 
+TEST_F(TestATHandler, test_ATHandler_process_oob_urc_prefixes)
+{
+    EventQueue que;
+    FileHandle_stub fh1;
+
+    ATHandler at(&fh1, que, 0, ",");
+    urc_at = &at;
+    mbed_poll_stub::revents_value = POLLIN;
+    mbed_poll_stub::int_value = 1;
+
+    at.set_urc_handler("+C", &urc_callback);
+    at.set_urc_handler("+CEREG: ", &urc_cereg_callback);
+    at.set_urc_handler("+CGEV: ", &urc2_callback);
+
+    // The longest prefix received wins, whatever the order of registration
+    char table[] = "+CEREG: 1\r\n+CGEV: ME DETACH\r\n+CSQ: 5\r\n\0";
+    filehandle_stub_table = table;
+    filehandle_stub_table_pos = 0;
+    filehandle_stub_short_value_counter = 1;
+    fh1.short_value = POLLIN;
+    at.process_oob();
+    EXPECT_EQ(1, urc_cereg_callback_count);
+    EXPECT_EQ(1, urc_value);
+    EXPECT_EQ(1, urc_callback_count);
+
+    // Prefix tree is rebuilt without the removed URC
+    at.set_urc_handler("+CEREG: ", NULL);
+    char table2[] = "+CEREG: 2\r\n\0";
+    filehandle_stub_table = table2;
+    filehandle_stub_table_pos = 0;
+    filehandle_stub_short_value_counter = 1;
+    at.process_oob();
+    EXPECT_EQ(1, urc_cereg_callback_count);
+    EXPECT_EQ(2, urc_callback_count);
+
+    at.set_urc_handler("+C", NULL);
+    at.set_urc_handler("+CGEV: ", NULL);
+    at.set_urc_handler("+CEREG: ", &urc_cereg_callback);
+
+    // URC wraps around the end of the receiving buffer
+    char table3[] = "0123456789012345678901234\r\n+CEREG: 5\r\n\0";
+    filehandle_stub_table = table3;
+    filehandle_stub_table_pos = 0;
+    filehandle_stub_short_value_counter = 1;
+    at.process_oob();
+    EXPECT_EQ(2, urc_cereg_callback_count);
+    EXPECT_EQ(5, urc_value);
+    EXPECT_EQ(2, urc_callback_count);
+
+    filehandle_stub_short_value_counter = 0;
+    filehandle_stub_table_pos = 0;
+    filehandle_stub_table = NULL;
+}
+
 TEST_F(TestATHandler, test_ATHandler_flush)
 {
     EventQueue que;
@@ -508,6 +593,67 @@ TEST_F(TestATHandler, test_ATHandler_read_bytes)
     EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.get_last_error());
 }
 
+TEST_F(TestATHandler, test_ATHandler_read_binary)
+{
+    EventQueue que;
+    FileHandle_stub fh1;
+    filehandle_stub_table = NULL;
+    filehandle_stub_table_pos = 0;
+
+    ATHandler at(&fh1, que, 0, ",");
+    uint8_t buf[48];
+
+    // Data containing a response and a line end is read as is
+    char table1[] = "+QIRD: 10\r\n\r\nOK\r\n1234\r\nOK\r\n\0";
+    filehandle_stub_table = table1;
+    filehandle_stub_table_pos = 0;
+    mbed_poll_stub::revents_value = POLLIN;
+    mbed_poll_stub::int_value = 1;
+
+    at.resp_start("+QIRD:");
+    EXPECT_EQ(10, at.read_int());
+    EXPECT_EQ(10, at.read_binary(buf, sizeof(buf), 10));
+    EXPECT_TRUE(!memcmp(buf, "\r\nOK\r\n1234", 10));
+    at.resp_stop();
+    EXPECT_EQ(NSAPI_ERROR_OK, at.get_last_error());
+
+    // Data not fitting to the output buffer is discarded, also when longer than the receiving buffer
+    at.clear_error();
+    char table2[] = "+QIRD: 40\r\n0123456789\r\nOK\r\n012345678901234567890123\r\nOK\r\n\0";
+    filehandle_stub_table = table2;
+    filehandle_stub_table_pos = 0;
+
+    at.resp_start("+QIRD:");
+    EXPECT_EQ(40, at.read_int());
+    EXPECT_EQ(5, at.read_binary(buf, 5, 40));
+    EXPECT_TRUE(!memcmp(buf, "01234", 5));
+    at.resp_stop();
+    EXPECT_EQ(NSAPI_ERROR_OK, at.get_last_error());
+
+    // Data longer than the receiving buffer is read past it
+    at.clear_error();
+    filehandle_stub_table = table2;
+    filehandle_stub_table_pos = 0;
+
+    at.resp_start("+QIRD:");
+    EXPECT_EQ(40, at.read_int());
+    EXPECT_EQ(40, at.read_binary(buf, sizeof(buf), 40));
+    EXPECT_TRUE(!memcmp(buf, table2 + 11, 40));
+    at.resp_stop();
+    EXPECT_EQ(NSAPI_ERROR_OK, at.get_last_error());
+
+    // Less data than announced -> ERROR
+    at.clear_error();
+    char table3[] = "+QIRD: 8\r\n1234\0";
+    filehandle_stub_table = table3;
+    filehandle_stub_table_pos = 0;
+
+    at.resp_start("+QIRD:");
+    EXPECT_EQ(8, at.read_int());
+    EXPECT_EQ(-1, at.read_binary(buf, 4, 8));
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.get_last_error());
+}
+
 TEST_F(TestATHandler, test_ATHandler_read_string)
 {
     EventQueue que;
@@ -1310,6 +1456,77 @@ TEST_F(TestATHandler, test_ATHandler_at_cmd_discard)
     EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.at_cmd_discard("+CREG", "=1,", "%d%s%b", 3, "test", byte, 4));
 }
 
+TEST_F(TestATHandler, test_ATHandler_at_cmd_pipeline)
+{
+    EventQueue que;
+    FileHandle_stub fh1;
+
+    ATHandler at(&fh1, que, 0, ",");
+    urc_at = &at;
+    fh1.size_value = 100;
+    mbed_poll_stub::revents_value = POLLIN | POLLOUT;
+    mbed_poll_stub::int_value = 1;
+
+    at_pipeline_cmd_t cmds[] = {
+        { "+CSQ", "", "+CSQ:", &csq_resp_callback },
+        { "+CEREG", "?", "+CEREG:", &cereg_resp_callback },
+        { "+CMEE", "=1" }
+    };
+
+    // Responses correlated by their prefix, URC in between
+    at.set_pipeline_mode(ATHandler::PipelineConcatenate);
+    at.set_urc_handler("+CSCON:", &urc_callback);
+    char table[] = "\r\n+CSQ: 20,99\r\n\r\n+CSCON: 1\r\n\r\n+CEREG: 0,5\r\n\r\nOK\r\n\0";
+    filehandle_stub_table = table;
+    filehandle_stub_table_pos = 0;
+    EXPECT_EQ(NSAPI_ERROR_OK, at.at_cmd_pipeline(cmds, 3));
+    EXPECT_EQ(20, csq_value);
+    EXPECT_EQ(5, cereg_value);
+    EXPECT_EQ(1, urc_callback_count);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[0].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[1].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[2].err);
+
+    // The command after the last answered one is sent again alone, then the rest
+    csq_value = -1;
+    cereg_value = -1;
+    char table2[] = "\r\n+CSQ: 21,99\r\n\r\nERROR\r\n\r\n+CME ERROR: 3\r\n\r\nOK\r\n\0";
+    filehandle_stub_table = table2;
+    filehandle_stub_table_pos = 0;
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.at_cmd_pipeline(cmds, 3));
+    EXPECT_EQ(21, csq_value);
+    EXPECT_EQ(-1, cereg_value);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[0].err);
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, cmds[1].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[2].err);
+    EXPECT_EQ(3, at.get_last_device_error().errCode);
+
+    // An ERROR does not stop streamed commands
+    at.set_pipeline_mode(ATHandler::PipelineStream);
+    char table3[] = "\r\nERROR\r\n\r\n+CEREG: 2,1\r\n\r\nOK\r\n\r\nOK\r\n\0";
+    filehandle_stub_table = table3;
+    filehandle_stub_table_pos = 0;
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.at_cmd_pipeline(cmds, 3));
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, cmds[0].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[1].err);
+    EXPECT_EQ(1, cereg_value);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[2].err);
+
+    // A timeout does
+    at.set_pipeline_mode(ATHandler::PipelineNone);
+    char table4[] = "\r\n+CSQ: 22,99\r\n\r\nOK\r\n\0";
+    filehandle_stub_table = table4;
+    filehandle_stub_table_pos = 0;
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.at_cmd_pipeline(cmds, 3));
+    EXPECT_EQ(22, csq_value);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[0].err);
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, cmds[1].err);
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, cmds[2].err);
+
+    filehandle_stub_table_pos = 0;
+    filehandle_stub_table = NULL;
+}
+
 TEST_F(TestATHandler, test_ATHandler_sync)
 {
     EventQueue que;
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MODEM_TRAFFIC_FILE_HANDLE_H
+#define MODEM_TRAFFIC_FILE_HANDLE_H
+
+#include <string.h>
+#include <errno.h>
+
+#include "FileHandle.h"
+
+/*
+ * Non-blocking FileHandle of a modem AT port, streaming recorded modem traffic.
+ *
+ * The traffic is played repeat times. Reads return at most chunk bytes, as a
+ * serial driver returns what its receive buffer holds, and -EAGAIN once all
+ * the traffic is read. Writes are discarded.
+ */
+class ModemTrafficFileHandle : public mbed::FileHandle {
+public:
+    ModemTrafficFileHandle(const char *traffic, size_t repeat, size_t chunk)
+        : _traffic(traffic),
+          _traffic_len(strlen(traffic)),
+          _total(_traffic_len * repeat),
+          _chunk(chunk),
+          _pos(0),
+          _reads(0),
+          _written(0)
+    {
+    }
+
+    virtual ssize_t read(void *buffer, size_t size)
+    {
+        if (_pos == _total) {
+            return -EAGAIN;
+        }
+
+        if (size > _chunk) {
+            size = _chunk;
+        }
+        if (size > _total - _pos) {
+            size = _total - _pos;
+        }
+
+        char *dest = static_cast<char *>(buffer);
+        size_t copied = 0;
+        while (copied < size) {
+            const size_t offset = (_pos + copied) % _traffic_len;
+            size_t len = _traffic_len - offset;
+            if (len > size - copied) {
+                len = size - copied;
+            }
+            memcpy(dest + copied, _traffic + offset, len);
+            copied += len;
+        }
+
+        _pos += size;
+        _reads++;
+        return size;
+    }
+
+    virtual ssize_t write(const void *buffer, size_t size)
+    {
+        _written += size;
+        return size;
+    }
+
+    virtual off_t seek(off_t offset, int whence = SEEK_SET)
+    {
+        return -ESPIPE;
+    }
+
+    virtual int close()
+    {
+        return 0;
+    }
+
+    virtual short poll(short events) const
+    {
+        return ((_pos < _total) ? POLLIN : 0) | POLLOUT;
+    }
+
+    /** Bytes of traffic read so far. */
+    size_t bytes_read() const
+    {
+        return _pos;
+    }
+
+    /** Calls to read() that returned data. */
+    size_t reads() const
+    {
+        return _reads;
+    }
+
+    size_t bytes_written() const
+    {
+        return _written;
+    }
+
+private:
+    const char *_traffic;
+    size_t _traffic_len;
+    size_t _total;
+    size_t _chunk;
+    size_t _pos;
+    size_t _reads;
+    size_t _written;
+};
+
+#endif // MODEM_TRAFFIC_FILE_HANDLE_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRIPTED_MODEM_FILE_HANDLE_H
+#define SCRIPTED_MODEM_FILE_HANDLE_H
+
+#include <string.h>
+#include <errno.h>
+#include <string>
+
+#include "FileHandle.h"
+
+/** Reply of the scripted modem to one command. */
+typedef struct scripted_reply_s {
+    /** Command as written after AT, for example "+CEREG?". */
+    const char *cmd;
+    /** Information response, NULL if none. */
+    const char *info;
+} scripted_reply_t;
+
+/*
+ * Non-blocking FileHandle of a modem AT port with echo off, answering the
+ * command lines written to it from a script. Commands concatenated with ';'
+ * are executed in order up to the first unknown one, which is answered with
+ * ERROR.
+ *
+ * The time the modem takes is counted on a virtual clock: the bytes on a
+ * 115200 baud serial line both ways, the execution of each command and, when
+ * a command line comes after the host has read all the responses, the round
+ * trip of the host waiting for the response before sending the next command.
+ */
+class ScriptedModemFileHandle : public mbed::FileHandle {
+public:
+    ScriptedModemFileHandle(const scripted_reply_t *replies, size_t count, uint32_t round_trip_us,
+                            uint32_t command_us)
+        : _replies(replies),
+          _count(count),
+          _round_trip_us(round_trip_us),
+          _command_us(command_us),
+          _read_pos(0),
+          _time_us(0),
+          _lines(0),
+          _commands(0)
+    {
+    }
+
+    virtual ssize_t read(void *buffer, size_t size)
+    {
+        if (_read_pos == _output.size()) {
+            return -EAGAIN;
+        }
+
+        if (size > _output.size() - _read_pos) {
+            size = _output.size() - _read_pos;
+        }
+        memcpy(buffer, _output.data() + _read_pos, size);
+        _read_pos += size;
+
+        // keep the output small, the host reads it all before the next line
+        if (_read_pos == _output.size()) {
+            _output.clear();
+            _read_pos = 0;
+        }
+        return size;
+    }
+
+    virtual ssize_t write(const void *buffer, size_t size)
+    {
+        const char *data = static_cast<const char *>(buffer);
+
+        _time_us += size * byte_us;
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] == '\r') {
+                execute_line();
+                _line.clear();
+            } else {
+                _line += data[i];
+            }
+        }
+        return size;
+    }
+
+    virtual off_t seek(off_t offset, int whence = SEEK_SET)
+    {
+        return -ESPIPE;
+    }
+
+    virtual int close()
+    {
+        return 0;
+    }
+
+    virtual short poll(short events) const
+    {
+        return ((_read_pos < _output.size()) ? POLLIN : 0) | POLLOUT;
+    }
+
+    /** Time the modem and the serial line took so far. */
+    uint64_t time_us() const
+    {
+        return _time_us;
+    }
+
+    /** Command lines received. */
+    size_t lines() const
+    {
+        return _lines;
+    }
+
+    /** Commands executed. */
+    size_t commands() const
+    {
+        return _commands;
+    }
+
+    /** Last command line received, without AT. */
+    const std::string &last_line() const
+    {
+        return _last_line;
+    }
+
+private:
+    // 10 bits per byte at 115200 baud
+    static const uint32_t byte_us = 87;
+
+    void execute_line()
+    {
+        if (_line.compare(0, 2, "AT") != 0) {
+            return;
+        }
+        if (_read_pos == _output.size()) {
+            _time_us += _round_trip_us;
+        }
+        _lines++;
+        _last_line = _line.substr(2);
+
+        std::string response;
+        size_t start = 2;
+        bool ok = true;
+        while (ok && start < _line.size()) {
+            size_t end = _line.find(';', start);
+            if (end == std::string::npos) {
+                end = _line.size();
+            }
+            ok = execute(_line.substr(start, end - start), response);
+            start = end + 1;
+        }
+        response += ok ? "\r\nOK\r\n" : "\r\nERROR\r\n";
+
+        _time_us += response.size() * byte_us;
+        _output += response;
+    }
+
+    bool execute(const std::string &cmd, std::string &response)
+    {
+        _time_us += _command_us;
+        _commands++;
+
+        for (size_t i = 0; i < _count; i++) {
+            if (cmd == _replies[i].cmd) {
+                if (_replies[i].info) {
+                    response += "\r\n";
+                    response += _replies[i].info;
+                    response += "\r\n";
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const scripted_reply_t *_replies;
+    size_t _count;
+    uint32_t _round_trip_us;
+    uint32_t _command_us;
+    std::string _line;
+    std::string _last_line;
+    std::string _output;
+    size_t _read_pos;
+    uint64_t _time_us;
+    size_t _lines;
+    size_t _commands;
+};
+
+#endif // SCRIPTED_MODEM_FILE_HANDLE_H
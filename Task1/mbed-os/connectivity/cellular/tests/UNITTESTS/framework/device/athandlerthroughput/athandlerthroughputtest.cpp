@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "gtest/gtest.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "events/EventQueue.h"
+#include "ATHandler.h"
+#include "mbed_poll_stub.h"
+#include "ModemTrafficFileHandle.h"
+#include "ScriptedModemFileHandle.h"
+
+using namespace mbed;
+using namespace events;
+
+/*
+ * AT port of an NB-IoT modem with registration, PDP context, signalling
+ * connection, eDRX, SMS and socket URCs enabled. +CTZV is not registered and
+ * is consumed as an unknown line.
+ */
+static const char urc_traffic[] =
+    "\r\n+CEREG: 5,\"2F0D\",\"0123ABCD\",9\r\n"
+    "\r\n+CSCON: 1\r\n"
+    "\r\n+QIURC: \"recv\",0\r\n"
+    "\r\n+CGEV: NW MODIFY 1,0\r\n"
+    "\r\n+CIEV: 2,4\r\n"
+    "\r\n+CEDRXP: 5,\"0101\",\"0101\",\"0011\"\r\n"
+    "\r\n+QIURC: \"recv\",1\r\n"
+    "\r\n+CMTI: \"ME\",3\r\n"
+    "\r\n+CTZV: \"+08\",0\r\n"
+    "\r\n+CSCON: 0\r\n";
+
+static const uint32_t urcs_in_urc_traffic = 9;
+
+/*
+ * Signal quality polling on a modem emitting URCs between the commands.
+ */
+static const char command_traffic[] =
+    "\r\n+CSCON: 1\r\n"
+    "\r\n+QIURC: \"recv\",2\r\n"
+    "\r\n+CSQ: 20,99\r\n"
+    "\r\nOK\r\n"
+    "\r\n+CSCON: 0\r\n";
+
+static const uint32_t urcs_in_command_traffic = 3;
+
+/*
+ * Startup queries of the application: identification, SIM, signal and
+ * registration, as answered by an LTE-M modem.
+ */
+static const scripted_reply_t boot_replies[] = {
+    { "+CMEE=1", NULL },
+    { "+CGMI", "Quectel" },
+    { "+CGMM", "BG96" },
+    { "+CGMR", "BG96MAR02A07M1G" },
+    { "+CIMI", "244911234567890" },
+    { "+CGSN=1", "+CGSN: \"866425031234567\"" },
+    { "+CCID", "+CCID: 89358151000012345678" },
+    { "+CSQ", "+CSQ: 20,99" },
+    { "+CEREG?", "+CEREG: 0,1" },
+    { "+CGREG?", "+CGREG: 0,1" },
+    { "+COPS?", "+COPS: 0,0,\"Operator\",8" },
+    { "+CGATT?", "+CGATT: 1" }
+};
+
+static const size_t boot_queries = 11;
+
+// Datagram of a socket read, the MTU of a TCP segment
+static const size_t datagram_len = 1460;
+
+// 10 bits per byte at 115200 baud
+static const uint32_t uart_byte_us = 87;
+
+static ATHandler *urc_at;
+static uint32_t urc_count;
+static uint32_t socket_data;
+static uint32_t info_count;
+
+static void info_resp_callback()
+{
+    char buf[32];
+    if (urc_at->read_string(buf, sizeof(buf)) > 0) {
+        info_count++;
+    }
+}
+
+static void urc_callback()
+{
+    urc_count++;
+}
+
+static void cereg_urc_callback()
+{
+    urc_count++;
+    (void)urc_at->read_int();
+}
+
+static void socket_urc_callback()
+{
+    urc_count++;
+    socket_data += urc_at->read_int() + 1;
+}
+
+// Prefixes of the URCs of the other modem drivers, registered to grow the handler count
+static char other_prefixes[64][12];
+
+// AStyle ignored as the definition is not clear due to preprocessor usage
+// *INDENT-OFF*
+class TestATHandlerThroughput : public testing::Test {
+protected:
+
+    void SetUp()
+    {
+        urc_at = NULL;
+        urc_count = 0;
+        socket_data = 0;
+        info_count = 0;
+        mbed_poll_stub::revents_value = POLLIN | POLLOUT;
+        mbed_poll_stub::int_value = 1;
+    }
+
+    void TearDown()
+    {
+        mbed_poll_stub::revents_value = POLLOUT;
+        mbed_poll_stub::int_value = 0;
+    }
+
+    void set_urc_handlers(ATHandler &at, uint32_t other_handlers)
+    {
+        urc_at = &at;
+        at.set_urc_handler("+CEREG:", &cereg_urc_callback);
+        at.set_urc_handler("+CSCON:", &urc_callback);
+        at.set_urc_handler("+QIURC: \"recv\",", &socket_urc_callback);
+        at.set_urc_handler("+CGEV:", &urc_callback);
+        at.set_urc_handler("+CIEV:", &urc_callback);
+        at.set_urc_handler("+CEDRXP:", &urc_callback);
+        at.set_urc_handler("+CMTI:", &urc_callback);
+
+        for (uint32_t i = 0; i < other_handlers && i < 64; i++) {
+            snprintf(other_prefixes[i], sizeof(other_prefixes[i]), "+%c%cURC%u:",
+                     'C' + i % 3, 'A' + i % 26, i);
+            at.set_urc_handler(other_prefixes[i], &urc_callback);
+        }
+    }
+
+    // Streams the URC traffic through ATHandler, returns the throughput in bytes/s
+    double urc_throughput(uint32_t other_handlers, size_t chunk, uint32_t repeat)
+    {
+        EventQueue que;
+        ModemTrafficFileHandle fh(urc_traffic, repeat, chunk);
+        ATHandler at(&fh, que, 0, ",");
+        set_urc_handlers(at, other_handlers);
+
+        const auto start = std::chrono::steady_clock::now();
+        at.process_oob();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        EXPECT_EQ(fh.bytes_read(), strlen(urc_traffic) * repeat);
+        EXPECT_EQ(urcs_in_urc_traffic * repeat, urc_count);
+        EXPECT_EQ(3 * repeat, socket_data);
+
+        return fh.bytes_read() / elapsed.count();
+    }
+
+    // Runs the startup queries through a scripted modem, returns the modem time in us
+    uint64_t boot_time(ATHandler::PipelineMode mode, uint32_t round_trip_us, size_t &lines)
+    {
+        EventQueue que;
+        ScriptedModemFileHandle fh(boot_replies, sizeof(boot_replies) / sizeof(boot_replies[0]),
+                                   round_trip_us, 1000);
+        ATHandler at(&fh, que, 1000, "\r");
+        urc_at = &at;
+        at.set_pipeline_mode(mode);
+
+        at_pipeline_cmd_t cmds[] = {
+            { "+CMEE", "=1" },
+            { "+CGMI", "", NULL, &info_resp_callback },
+            { "+CGMM", "", NULL, &info_resp_callback },
+            { "+CGMR", "", NULL, &info_resp_callback },
+            { "+CIMI", "", NULL, &info_resp_callback },
+            { "+CGSN", "=1", "+CGSN:", &info_resp_callback },
+            { "+CCID", "", "+CCID:", &info_resp_callback },
+            { "+CSQ", "", "+CSQ:", &info_resp_callback },
+            { "+CEREG", "?", "+CEREG:", &info_resp_callback },
+            { "+CGREG", "?", "+CGREG:", &info_resp_callback },
+            { "+COPS", "?", "+COPS:", &info_resp_callback },
+            { "+CGATT", "?", "+CGATT:", &info_resp_callback }
+        };
+
+        info_count = 0;
+        EXPECT_EQ(NSAPI_ERROR_OK, at.at_cmd_pipeline(cmds, sizeof(cmds) / sizeof(cmds[0])));
+        EXPECT_EQ(boot_queries, info_count);
+        EXPECT_EQ(sizeof(cmds) / sizeof(cmds[0]), fh.commands());
+
+        lines = fh.lines();
+        return fh.time_us();
+    }
+
+    // Datagram with all the byte values but 0, line ends and "OK" among them
+    static std::string datagram()
+    {
+        std::string data;
+        for (size_t i = 0; i < datagram_len; i++) {
+            data += (char)(i % 255 + 1);
+        }
+        data.replace(100, 6, "\r\nOK\r\n");
+        return data;
+    }
+
+    // Reads the socket data responses, returns the host time in ns/byte
+    double socket_read(const std::string &traffic, bool hex, uint32_t repeat)
+    {
+        EventQueue que;
+        ModemTrafficFileHandle fh(traffic.c_str(), repeat, 64);
+        ATHandler at(&fh, que, 0, ",");
+        const std::string data = datagram();
+        // read_hex_string terminates with null
+        char buf[datagram_len + 1];
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < repeat; i++) {
+            at.lock();
+            at.resp_start("+QIRD:");
+            const int32_t len = at.read_int();
+            if (hex) {
+                EXPECT_EQ(len, at.read_hex_string(buf, datagram_len));
+            } else {
+                EXPECT_EQ(len, at.read_binary((uint8_t *)buf, datagram_len, len));
+            }
+            at.resp_stop();
+            EXPECT_EQ(NSAPI_ERROR_OK, at.unlock_return_error());
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        EXPECT_TRUE(!memcmp(buf, data.data(), datagram_len));
+        EXPECT_EQ(fh.bytes_read(), traffic.size() * repeat);
+        return 1e9 * elapsed.count() / repeat / datagram_len;
+    }
+};
+// *INDENT-ON*
+
+TEST_F(TestATHandlerThroughput, urc_stream)
+{
+    const uint32_t repeat = 20000;
+
+    for (uint32_t other_handlers : {
+                0, 16, 64
+            }) {
+        for (size_t chunk : {
+                    8, 64
+                }) {
+            urc_count = 0;
+            socket_data = 0;
+            const double throughput = urc_throughput(other_handlers, chunk, repeat);
+            printf("[ BENCH    ] URC stream, %u handlers, %u byte reads: %.1f MB/s, %.0f ns/URC\n",
+                   7 + other_handlers, (unsigned)chunk, throughput / 1e6,
+                   1e9 * strlen(urc_traffic) / throughput / urcs_in_urc_traffic);
+        }
+    }
+}
+
+TEST_F(TestATHandlerThroughput, urc_stream_after_remove)
+{
+    EventQueue que;
+    ModemTrafficFileHandle fh(urc_traffic, 100, 16);
+    ATHandler at(&fh, que, 0, ",");
+    set_urc_handlers(at, 16);
+
+    // Handlers removed and added back are still matched
+    at.set_urc_handler("+CSCON:", NULL);
+    at.set_urc_handler("+CEREG:", NULL);
+    at.set_urc_handler(other_prefixes[3], NULL);
+    at.set_urc_handler("+CSCON:", &urc_callback);
+
+    at.process_oob();
+
+    // The two +CSCON: are still handled, +CEREG: is consumed as an unknown line
+    EXPECT_EQ((urcs_in_urc_traffic - 1) * 100, urc_count);
+    EXPECT_EQ(3 * 100u, socket_data);
+}
+
+TEST_F(TestATHandlerThroughput, command_responses_with_urcs)
+{
+    const uint32_t repeat = 20000;
+    EventQueue que;
+    ModemTrafficFileHandle fh(command_traffic, repeat, 16);
+    ATHandler at(&fh, que, 0, ",");
+    set_urc_handlers(at, 16);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < repeat; i++) {
+        at.lock();
+        at.cmd_start_stop("+CSQ", "");
+        at.resp_start("+CSQ:");
+        EXPECT_EQ(20, at.read_int());
+        EXPECT_EQ(99, at.read_int());
+        at.resp_stop();
+        ASSERT_EQ(NSAPI_ERROR_OK, at.unlock_return_error());
+    }
+    // URCs after the last response
+    at.process_oob();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(fh.bytes_read(), strlen(command_traffic) * repeat);
+    EXPECT_EQ(urcs_in_command_traffic * repeat, urc_count);
+    EXPECT_EQ(3 * repeat, socket_data);
+
+    printf("[ BENCH    ] AT+CSQ with URCs, 23 handlers: %.0f ns/command, %.1f MB/s\n",
+           1e9 * elapsed.count() / repeat, fh.bytes_read() / elapsed.count() / 1e6);
+}
+
+TEST_F(TestATHandlerThroughput, pipelined_startup)
+{
+    static const char *const mode_names[] = { "one at a time", "streamed", "concatenated" };
+
+    // Host round trip of a BG96 without send delay and of a ME910 with its 20 ms send delay
+    for (uint32_t round_trip_us : {
+                2000, 22000
+            }) {
+        uint64_t time_us[3];
+        for (int mode = ATHandler::PipelineNone; mode <= ATHandler::PipelineConcatenate; mode++) {
+            size_t lines;
+            time_us[mode] = boot_time((ATHandler::PipelineMode)mode, round_trip_us, lines);
+            printf("[ BENCH    ] Startup, %u us round trip, %s: %u command lines, %.1f ms\n",
+                   round_trip_us, mode_names[mode], (unsigned)lines, time_us[mode] / 1000.0);
+        }
+        EXPECT_LT(time_us[ATHandler::PipelineStream], time_us[ATHandler::PipelineNone]);
+        // The queries without prefix cannot be concatenated and are still sent one at a time
+        EXPECT_LT(time_us[ATHandler::PipelineConcatenate], time_us[ATHandler::PipelineNone]);
+    }
+}
+
+TEST_F(TestATHandlerThroughput, pipelined_unknown_command)
+{
+    EventQueue que;
+    ScriptedModemFileHandle fh(boot_replies, sizeof(boot_replies) / sizeof(boot_replies[0]), 2000, 1000);
+    ATHandler at(&fh, que, 1000, "\r");
+    urc_at = &at;
+    at.set_pipeline_mode(ATHandler::PipelineConcatenate);
+
+    at_pipeline_cmd_t cmds[] = {
+        { "+CSQ", "", "+CSQ:", &info_resp_callback },
+        { "+CEREG", "?", "+CEREG:", &info_resp_callback },
+        { "+QCFG", "=\"band\"", "+QCFG:", &info_resp_callback },
+        { "+COPS", "?", "+COPS:", &info_resp_callback },
+        { "+CGATT", "?", "+CGATT:", &info_resp_callback }
+    };
+
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, at.at_cmd_pipeline(cmds, 5));
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[0].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[1].err);
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, cmds[2].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[3].err);
+    EXPECT_EQ(NSAPI_ERROR_OK, cmds[4].err);
+    EXPECT_EQ(4u, info_count);
+
+    // +QCFG is sent again alone, the rest on a new line
+    EXPECT_EQ(3u, fh.lines());
+    EXPECT_EQ("+COPS?;+CGATT?", fh.last_line());
+}
+
+TEST_F(TestATHandlerThroughput, socket_data_hex_and_binary)
+{
+    const uint32_t repeat = 2000;
+    const std::string data = datagram();
+
+    // BC95 and UBLOX N2XX give the data in hex, BG96 as it is
+    std::string hex_traffic = "\r\n+QIRD: 1460,\"";
+    for (size_t i = 0; i < data.size(); i++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02X", (uint8_t)data[i]);
+        hex_traffic += hex;
+    }
+    hex_traffic += "\"\r\n\r\nOK\r\n";
+    const std::string binary_traffic = "\r\n+QIRD: 1460\r\n" + data + "\r\n\r\nOK\r\n";
+
+    printf("[ BENCH    ] Socket read, hex: %.1f ns/byte on host, %u bytes %.1f ms on UART\n",
+           socket_read(hex_traffic, true, repeat), (unsigned)hex_traffic.size(),
+           hex_traffic.size() * uart_byte_us / 1000.0);
+    printf("[ BENCH    ] Socket read, binary: %.1f ns/byte on host, %u bytes %.1f ms on UART\n",
+           socket_read(binary_traffic, false, repeat), (unsigned)binary_traffic.size(),
+           binary_traffic.size() * uart_byte_us / 1000.0);
+
+    // Twice the bytes on the serial line in hex
+    EXPECT_GT(hex_traffic.size(), 2 * data.size());
+    EXPECT_LT(binary_traffic.size(), data.size() + 32);
+}
+
+TEST_F(TestATHandlerThroughput, socket_send_hex_and_binary)
+{
+    const uint32_t repeat = 2000;
+    const std::string data = datagram();
+    EventQueue que;
+    ModemTrafficFileHandle fh("", 0, 64);
+    ATHandler at(&fh, que, 0, ",");
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < repeat; i++) {
+        at.write_hex_string(data.data(), data.size());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const size_t hex_bytes = fh.bytes_written() / repeat;
+    printf("[ BENCH    ] Socket send, hex: %.1f ns/byte on host, %u bytes %.1f ms on UART\n",
+           1e9 * elapsed.count() / repeat / datagram_len, (unsigned)hex_bytes,
+           hex_bytes * uart_byte_us / 1000.0);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < repeat; i++) {
+        at.write_bytes((const uint8_t *)data.data(), data.size());
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    const size_t binary_bytes = fh.bytes_written() / repeat - hex_bytes;
+    printf("[ BENCH    ] Socket send, binary: %.1f ns/byte on host, %u bytes %.1f ms on UART\n",
+           1e9 * elapsed.count() / repeat / datagram_len, (unsigned)binary_bytes,
+           binary_bytes * uart_byte_us / 1000.0);
+
+    // Delimiter and quotes around the hex
+    EXPECT_EQ(2 * datagram_len + 3, hex_bytes);
+    EXPECT_EQ(datagram_len, binary_bytes);
+    EXPECT_EQ(NSAPI_ERROR_OK, at.get_last_error());
+}
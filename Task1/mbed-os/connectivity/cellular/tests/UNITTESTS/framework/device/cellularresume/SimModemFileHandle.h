@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIM_MODEM_FILE_HANDLE_H
+#define SIM_MODEM_FILE_HANDLE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+
+#include "FileHandle.h"
+
+/*
+ * Non-blocking FileHandle of the AT port of a simulated LTE modem with echo
+ * off. The modem is powered off, booting, on or asleep in PSM. It searches the
+ * network after boot and keeps the registration and the attach while asleep.
+ *
+ * The time taken is counted on a virtual clock: the bytes on a 115200 baud
+ * serial line both ways, the execution of each command, the AT timeout of the
+ * host for each command line not answered and the waits of the host added with
+ * advance().
+ */
+class SimModemFileHandle : public mbed::FileHandle {
+public:
+    enum Power {
+        PowerOff = 0,
+        PowerOn,
+        PowerAsleep
+    };
+
+    SimModemFileHandle()
+        : _power(PowerOff),
+          _boot_us(5000000),
+          _search_us(8000000),
+          _attach_us(1500000),
+          _wake_us(100000),
+          _command_us(20000),
+          _at_timeout_us(1000000),
+          _iccid("89358151000012345678"),
+          _read_pos(0),
+          _unanswered(false),
+          _time_us(0),
+          _ready_us(0),
+          _registered_us(0),
+          _attached(false),
+          _lines(0)
+    {
+    }
+
+    virtual ssize_t read(void *buffer, size_t size)
+    {
+        if (_read_pos == _output.size()) {
+            // the host waits for the response until its AT timeout
+            if (_unanswered) {
+                _time_us += _at_timeout_us;
+                _unanswered = false;
+            }
+            return -EAGAIN;
+        }
+
+        if (size > _output.size() - _read_pos) {
+            size = _output.size() - _read_pos;
+        }
+        memcpy(buffer, _output.data() + _read_pos, size);
+        _read_pos += size;
+
+        if (_read_pos == _output.size()) {
+            _output.clear();
+            _read_pos = 0;
+        }
+        return size;
+    }
+
+    virtual ssize_t write(const void *buffer, size_t size)
+    {
+        const char *data = static_cast<const char *>(buffer);
+
+        _time_us += size * byte_us;
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] == '\r') {
+                execute_line();
+                _line.clear();
+            } else {
+                _line += data[i];
+            }
+        }
+        return size;
+    }
+
+    virtual off_t seek(off_t offset, int whence = SEEK_SET)
+    {
+        return -ESPIPE;
+    }
+
+    virtual int close()
+    {
+        return 0;
+    }
+
+    virtual short poll(short events) const
+    {
+        return ((_read_pos < _output.size()) ? POLLIN : 0) | POLLOUT;
+    }
+
+    /** Powers the modem on, it boots and searches the network. */
+    void power_on()
+    {
+        if (_power == PowerOff) {
+            _power = PowerOn;
+            _ready_us = _time_us + _boot_us;
+            _registered_us = _ready_us + _search_us;
+            _attached = false;
+        }
+    }
+
+    /** Powers the modem off, the registration is lost. */
+    void power_off()
+    {
+        _power = PowerOff;
+        _attached = false;
+    }
+
+    /** Puts the modem to PSM, it stays registered and attached. */
+    void sleep()
+    {
+        if (_power == PowerOn) {
+            _power = PowerAsleep;
+        }
+    }
+
+    /** Wakes the modem from PSM. */
+    void wake_up()
+    {
+        if (_power == PowerAsleep) {
+            _power = PowerOn;
+            _time_us += _wake_us;
+        }
+    }
+
+    /** Advances the virtual clock by a wait of the host. */
+    void advance(uint64_t us)
+    {
+        _time_us += us;
+    }
+
+    /** Replaces the SIM, the new one is registered after a new search. */
+    void set_iccid(const char *iccid)
+    {
+        _iccid = iccid;
+        _registered_us = _time_us + _search_us;
+        _attached = false;
+    }
+
+    uint64_t time_us() const
+    {
+        return _time_us;
+    }
+
+    /** Command lines answered. */
+    size_t lines() const
+    {
+        return _lines;
+    }
+
+private:
+    // 10 bits per byte at 115200 baud
+    static const uint32_t byte_us = 87;
+
+    bool registered() const
+    {
+        return _power == PowerOn && _time_us >= _registered_us;
+    }
+
+    void execute_line()
+    {
+        if (_line.compare(0, 2, "AT") != 0) {
+            return;
+        }
+        if (_power != PowerOn || _time_us < _ready_us) {
+            _unanswered = true;
+            return;
+        }
+        _lines++;
+        _time_us += _command_us;
+
+        std::string info;
+        const bool ok = execute(_line.substr(2), info);
+        std::string response;
+        if (!info.empty()) {
+            response = "\r\n" + info + "\r\n";
+        }
+        response += ok ? "\r\nOK\r\n" : "\r\nERROR\r\n";
+
+        _time_us += response.size() * byte_us;
+        _output += response;
+    }
+
+    bool execute(const std::string &cmd, std::string &info)
+    {
+        char buf[128];
+        const int stat = registered() ? 1 : 2;
+
+        if (cmd.empty() || cmd == "E0" || cmd == "+CMEE=1" || cmd == "+CFUN=1" || cmd == "+CGEREP=1" ||
+                cmd == "+COPS=0" || cmd == "+CGACT?" || cmd.compare(0, 7, "+CEREG=") == 0 ||
+                cmd.compare(0, 7, "+CGREG=") == 0 || cmd.compare(0, 6, "+CREG=") == 0) {
+            return true;
+        } else if (cmd == "+CPIN?") {
+            info = "+CPIN: READY";
+        } else if (cmd == "+CCID?") {
+            info = "+CCID: " + _iccid;
+        } else if (cmd == "+CSQ") {
+            info = "+CSQ: 20,99";
+        } else if (cmd == "+CEREG?") {
+            // T3324 of 1 minute and T3412 of 1 hour
+            snprintf(buf, sizeof(buf), "+CEREG: 2,%d,\"2F0D\",\"0123ABCD\",7,,,\"00100001\",\"00100001\"", stat);
+            info = buf;
+        } else if (cmd == "+CGREG?" || cmd == "+CREG?") {
+            snprintf(buf, sizeof(buf), "%s: 2,%d", cmd.substr(0, cmd.size() - 1).c_str(), stat);
+            info = buf;
+        } else if (cmd == "+COPS?") {
+            info = registered() ? "+COPS: 0,2,\"24405\",7" : "+COPS: 0";
+        } else if (cmd == "+CGATT?") {
+            info = _attached ? "+CGATT: 1" : "+CGATT: 0";
+        } else if (cmd == "+CGATT=1") {
+            if (!registered()) {
+                return false;
+            }
+            if (!_attached) {
+                _time_us += _attach_us;
+                _attached = true;
+            }
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    Power _power;
+    uint64_t _boot_us;
+    uint64_t _search_us;
+    uint64_t _attach_us;
+    uint64_t _wake_us;
+    uint64_t _command_us;
+    uint64_t _at_timeout_us;
+    std::string _iccid;
+    std::string _line;
+    std::string _output;
+    size_t _read_pos;
+    bool _unanswered;
+    uint64_t _time_us;
+    uint64_t _ready_us;
+    uint64_t _registered_us;
+    bool _attached;
+    size_t _lines;
+};
+
+#endif // SIM_MODEM_FILE_HANDLE_H
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "gtest/gtest.h"
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "AT_CellularDevice.h"
+#include "AT_CellularNetwork.h"
+#include "CellularLog.h"
+#include "kvstore/KVStore.h"
+#include "platform/mbed_error.h"
+#include "mbed_poll_stub.h"
+#include "equeue_stub.h"
+#include "SimModemFileHandle.h"
+
+using namespace mbed;
+
+static const intptr_t sim_properties[AT_CellularDevice::PROPERTY_MAX] = {
+    AT_CellularNetwork::RegistrationModeLAC,    // C_EREG
+    AT_CellularNetwork::RegistrationModeLAC,    // C_GREG
+    AT_CellularNetwork::RegistrationModeLAC,    // C_REG
+    0,  // AT_CGSN_WITH_TYPE
+    1,  // AT_CGDATA
+    1,  // AT_CGAUTH
+    1,  // AT_CNMI
+    1,  // AT_CSMP
+    1,  // AT_CMGF
+    1,  // AT_CSDH
+    1,  // PROPERTY_IPV4_STACK
+    0,  // PROPERTY_IPV6_STACK
+    0,  // PROPERTY_IPV4V6_STACK
+    0,  // PROPERTY_NON_IP_PDP_TYPE
+    1,  // PROPERTY_AT_CGEREP
+    0,  // PROPERTY_AT_COPS_FALLBACK_AUTO
+    0,  // PROPERTY_SOCKET_COUNT
+    0,  // PROPERTY_IP_TCP
+    0,  // PROPERTY_IP_UDP
+    0,  // PROPERTY_AT_SEND_DELAY
+    0,  // PROPERTY_AT_CMD_PIPELINE
+};
+
+// retry timeouts of the state machine in seconds, as by default
+static const uint16_t retry_timeouts[] = { 1, 2, 4, 8, 16, 32, 64, 128, 600, 1200 };
+
+/*
+ * Cellular device of the simulated modem, powering it on and waking it from PSM.
+ */
+class SimCellularDevice : public AT_CellularDevice {
+public:
+    SimCellularDevice(SimModemFileHandle &modem) : AT_CellularDevice(&modem), _modem(modem)
+    {
+        set_cellular_properties(sim_properties);
+    }
+
+    virtual nsapi_error_t hard_power_on()
+    {
+        _modem.power_on();
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual nsapi_error_t soft_power_on()
+    {
+        _modem.wake_up();
+        return NSAPI_ERROR_OK;
+    }
+
+private:
+    SimModemFileHandle &_modem;
+};
+
+/*
+ * KVStore in memory, counting the writes.
+ */
+class MemoryKVStore : public KVStore {
+public:
+    MemoryKVStore() : _writes(0) {}
+
+    virtual int init()
+    {
+        return MBED_SUCCESS;
+    }
+
+    virtual int deinit()
+    {
+        return MBED_SUCCESS;
+    }
+
+    virtual int reset()
+    {
+        _values.clear();
+        return MBED_SUCCESS;
+    }
+
+    virtual int set(const char *key, const void *buffer, size_t size, uint32_t create_flags)
+    {
+        const uint8_t *data = static_cast<const uint8_t *>(buffer);
+        _values[key].assign(data, data + size);
+        _writes++;
+        return MBED_SUCCESS;
+    }
+
+    virtual int get(const char *key, void *buffer, size_t buffer_size, size_t *actual_size = NULL, size_t offset = 0)
+    {
+        std::map<std::string, std::vector<uint8_t> >::const_iterator it = _values.find(key);
+        if (it == _values.end()) {
+            return MBED_ERROR_ITEM_NOT_FOUND;
+        }
+        const size_t size = (it->second.size() - offset < buffer_size) ? it->second.size() - offset : buffer_size;
+        memcpy(buffer, it->second.data() + offset, size);
+        if (actual_size) {
+            *actual_size = size;
+        }
+        return MBED_SUCCESS;
+    }
+
+    virtual int get_info(const char *key, info_t *info = NULL)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    virtual int remove(const char *key)
+    {
+        return _values.erase(key) ? MBED_SUCCESS : MBED_ERROR_ITEM_NOT_FOUND;
+    }
+
+    virtual int set_start(set_handle_t *handle, const char *key, size_t final_data_size, uint32_t create_flags)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    virtual int set_add_data(set_handle_t handle, const void *value_data, size_t data_size)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    virtual int set_finalize(set_handle_t handle)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    virtual int iterator_open(iterator_t *it, const char *prefix = NULL)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    virtual int iterator_next(iterator_t it, char *key, size_t key_size)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    virtual int iterator_close(iterator_t it)
+    {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+
+    /** Values written so far. */
+    int writes() const
+    {
+        return _writes;
+    }
+
+private:
+    std::map<std::string, std::vector<uint8_t> > _values;
+    int _writes;
+};
+
+/** Result of a connect of the host. */
+typedef struct {
+    bool attached;
+    uint64_t time_us;
+    size_t lines;
+} connect_result_t;
+
+static SimModemFileHandle *modem;
+static bool attached;
+
+static void status_callback(nsapi_event_t ev, intptr_t ptr)
+{
+    const cell_callback_data_t *data = (const cell_callback_data_t *)ptr;
+
+    if (ev == CellularStateRetryEvent) {
+        // the host waits before the retry
+        modem->advance(retry_timeouts[*(const int *)data->data] * 1000000ULL);
+    } else if (ev == CellularAttachNetwork && data->error == NSAPI_ERROR_OK) {
+        attached = true;
+    }
+}
+
+// AStyle ignored as the definition is not clear due to preprocessor usage
+// *INDENT-OFF*
+class TestCellularResume : public testing::Test {
+protected:
+
+    void SetUp()
+    {
+        mbed_poll_stub::revents_value = POLLIN | POLLOUT;
+        mbed_poll_stub::int_value = 1;
+        equeue_stub.void_ptr = &_event;
+        equeue_stub.call_cb_immediately = true;
+        modem = &_modem;
+    }
+
+    void TearDown()
+    {
+        modem = NULL;
+        equeue_stub.void_ptr = NULL;
+        equeue_stub.call_cb_immediately = false;
+        mbed_poll_stub::revents_value = POLLOUT;
+        mbed_poll_stub::int_value = 0;
+    }
+
+    /** Host starts, connects to the network and measures the time taken. */
+    connect_result_t connect(KVStore *store)
+    {
+        connect_result_t result;
+        SimCellularDevice device(_modem);
+
+        attached = false;
+        device.attach(&status_callback);
+        device.set_retry_timeout_array(retry_timeouts, sizeof(retry_timeouts) / sizeof(retry_timeouts[0]));
+        device.set_resume_store(store);
+
+        const uint64_t start_us = _modem.time_us();
+        const size_t start_lines = _modem.lines();
+        device.attach_to_network();
+
+        result.attached = attached;
+        result.time_us = _modem.time_us() - start_us;
+        result.lines = _modem.lines() - start_lines;
+        return result;
+    }
+
+    static void print(const char *scenario, const char *cache, const connect_result_t &result)
+    {
+        printf("[ BENCH    ] Time to connect, %s, %s: %u command lines, %.2f s\n", scenario, cache,
+               (unsigned)result.lines, result.time_us / 1000000.0);
+    }
+
+    SimModemFileHandle _modem;
+    struct equeue_event _event;
+};
+// *INDENT-ON*
+
+TEST_F(TestCellularResume, cold_boot)
+{
+    MemoryKVStore store;
+
+    const connect_result_t plain = connect(NULL);
+    ASSERT_TRUE(plain.attached);
+
+    _modem.power_off();
+    const connect_result_t first = connect(&store);
+    ASSERT_TRUE(first.attached);
+    EXPECT_EQ(1, store.writes());
+
+    // the modem searches the network again after boot, the registration cannot be resumed,
+    // only the registration is asked and the record kept as it is
+    _modem.power_off();
+    const connect_result_t cached = connect(&store);
+    ASSERT_TRUE(cached.attached);
+    EXPECT_EQ(1, store.writes());
+    EXPECT_LE(cached.lines, plain.lines + 1);
+    EXPECT_LE(cached.time_us, plain.time_us + 200000);
+
+    print("cold boot", "no cache", plain);
+    print("cold boot", "empty cache", first);
+    print("cold boot", "cache", cached);
+}
+
+TEST_F(TestCellularResume, warm_restart)
+{
+    MemoryKVStore store;
+
+    ASSERT_TRUE(connect(&store).attached);
+    EXPECT_EQ(1, store.writes());
+
+    // host restarts, modem stays registered and attached
+    const connect_result_t plain = connect(NULL);
+    ASSERT_TRUE(plain.attached);
+    const connect_result_t cached = connect(&store);
+    ASSERT_TRUE(cached.attached);
+
+    // unchanged state is not written again
+    EXPECT_EQ(1, store.writes());
+    EXPECT_LT(cached.lines, plain.lines);
+    EXPECT_LT(cached.time_us, plain.time_us);
+
+    print("warm restart", "no cache", plain);
+    print("warm restart", "cache", cached);
+}
+
+TEST_F(TestCellularResume, psm_wake)
+{
+    MemoryKVStore store;
+
+    ASSERT_TRUE(connect(&store).attached);
+
+    _modem.sleep();
+    const connect_result_t plain = connect(NULL);
+    ASSERT_TRUE(plain.attached);
+
+    _modem.sleep();
+    const connect_result_t cached = connect(&store);
+    ASSERT_TRUE(cached.attached);
+
+    EXPECT_EQ(1, store.writes());
+    EXPECT_LT(cached.lines, plain.lines);
+    EXPECT_LT(cached.time_us, plain.time_us);
+
+    print("PSM wake", "no cache", plain);
+    print("PSM wake", "cache", cached);
+}
+
+TEST_F(TestCellularResume, sim_changed)
+{
+    MemoryKVStore store;
+
+    ASSERT_TRUE(connect(&store).attached);
+    EXPECT_EQ(1, store.writes());
+
+    // other SIM, the modem registers again and the cache is not used
+    _modem.set_iccid("89358151000087654321");
+    ASSERT_TRUE(connect(&store).attached);
+    EXPECT_EQ(1, store.writes());
+
+    // registered with the other SIM, the cache is replaced
+    const connect_result_t replaced = connect(&store);
+    ASSERT_TRUE(replaced.attached);
+    EXPECT_EQ(2, store.writes());
+
+    const connect_result_t cached = connect(&store);
+    ASSERT_TRUE(cached.attached);
+    EXPECT_EQ(2, store.writes());
+    EXPECT_LT(cached.lines, replaced.lines);
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIM_PSM_MODEM_H
+#define SIM_PSM_MODEM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "events/EventQueue.h"
+#include "CellularNetwork.h"
+#include "platform/Callback.h"
+
+/** Timings of the simulated modem in milliseconds, scripted after an LTE-M modem. */
+typedef struct {
+    uint32_t wake_ms;       // leaving PSM: RRC connection setup and service request
+    uint32_t connect_ms;    // RRC connection setup from idle
+    uint32_t tx_ms;         // sending a message
+    uint32_t inactivity_ms; // RRC connected after the last message
+    uint32_t tau_ms;        // periodic tracking area update signalling
+    int active_time;        // T3324 in seconds
+    int periodic_tau;       // T3412 in seconds
+} sim_psm_script_t;
+
+/** Message received by the network. */
+typedef struct {
+    uint32_t sent_ms;       // when the modem got it from the host
+    uint32_t seq;           // first four bytes of the message
+} sim_psm_message_t;
+
+/*
+ * Radio of a modem using PSM, on the virtual clock of the fake event queue.
+ *
+ * A message from the host sets up an RRC connection: from PSM with the full
+ * wake up, from idle in the active time with a connection setup. The modem
+ * stays connected for the inactivity time after the last message, then idle
+ * and reachable for T3324 and then goes to PSM. T3412 after going idle it
+ * wakes up for the periodic TAU and tells the host, as with +CSCON: 1.
+ *
+ * The radio is on while connected and while idle in the active time.
+ */
+class SimPsmModem {
+public:
+    SimPsmModem(events::EventQueue &queue, const sim_psm_script_t &script)
+        : _queue(queue),
+          _script(script),
+          _conn_start(0),
+          _conn_end(0),
+          _active_end(0),
+          _tx_end(0),
+          _connected(false),
+          _tau_event(0),
+          _wakes(0),
+          _taus(0),
+          _connections(0),
+          _connected_ms(0),
+          _idle_ms(0),
+          _fail(false)
+    {
+    }
+
+    /** Sends a message of the host, as the socket send of the modem. */
+    nsapi_size_or_error_t send(const void *data, nsapi_size_t size)
+    {
+        if (_fail) {
+            return NSAPI_ERROR_DEVICE_ERROR;
+        }
+        connect(0);
+        const uint32_t now = _queue.tick();
+        _tx_end = (_tx_end > now ? _tx_end : now) + _script.tx_ms;
+        extend(_tx_end + _script.inactivity_ms);
+
+        sim_psm_message_t msg;
+        msg.sent_ms = now;
+        msg.seq = 0;
+        memcpy(&msg.seq, data, size < sizeof(msg.seq) ? size : sizeof(msg.seq));
+        _messages.push_back(msg);
+        return size;
+    }
+
+    /** PSM timers given by the network, as read from +CEREG. */
+    mbed::CellularNetwork::registration_params_t reg_params() const
+    {
+        mbed::CellularNetwork::registration_params_t params;
+        params._type = mbed::CellularNetwork::C_EREG;
+        params._status = mbed::CellularNetwork::RegisteredHomeNetwork;
+        params._active_time = _script.active_time;
+        params._periodic_tau = _script.periodic_tau;
+        return params;
+    }
+
+    /** Called when the modem wakes up by itself. */
+    void set_wake_cb(mbed::Callback<void()> cb)
+    {
+        _wake_cb = cb;
+    }
+
+    /** Sends fail until cleared. */
+    void set_fail(bool fail)
+    {
+        _fail = fail;
+    }
+
+    /** Ends the simulation at the current time, the radio time is counted up to it. */
+    void finish()
+    {
+        const uint32_t now = _queue.tick();
+        if (_connected) {
+            _connected_ms += (now < _conn_end ? now : _conn_end) - _conn_start;
+            _connected = false;
+        }
+        if (now > _conn_end) {
+            _idle_ms += (now < _active_end ? now : _active_end) - _conn_end;
+        }
+        _conn_start = _conn_end = _active_end = now;
+        if (_tau_event) {
+            _queue.cancel(_tau_event);
+            _tau_event = 0;
+        }
+    }
+
+    /** Wake ups from PSM, for the host or for TAU. */
+    uint32_t wakes() const
+    {
+        return _wakes;
+    }
+
+    uint32_t taus() const
+    {
+        return _taus;
+    }
+
+    uint32_t connections() const
+    {
+        return _connections;
+    }
+
+    /** Time the radio was on, connected or idle in the active time. */
+    uint64_t radio_on_ms() const
+    {
+        return _connected_ms + _idle_ms;
+    }
+
+    uint64_t connected_ms() const
+    {
+        return _connected_ms;
+    }
+
+    const std::vector<sim_psm_message_t> &messages() const
+    {
+        return _messages;
+    }
+
+private:
+    // sets up an RRC connection unless connected, extra_ms is signalling after it
+    void connect(uint32_t extra_ms)
+    {
+        const uint32_t now = _queue.tick();
+        if (_connected && now < _conn_end) {
+            return;
+        }
+        if (_connected) {
+            // the previous connection was released, idle since
+            _connected_ms += _conn_end - _conn_start;
+            _idle_ms += (now < _active_end ? now : _active_end) - _conn_end;
+        }
+
+        uint32_t setup_ms = _script.connect_ms;
+        if (now >= _active_end) {
+            setup_ms = _script.wake_ms;
+            _wakes++;
+        }
+        _connections++;
+        _connected = true;
+        _conn_start = now;
+        _tx_end = now + setup_ms + extra_ms;
+        extend(_tx_end + _script.inactivity_ms);
+    }
+
+    // moves the release of the connection, T3412 and T3324 run from it
+    void extend(uint32_t conn_end)
+    {
+        _conn_end = conn_end;
+        _active_end = _conn_end + _script.active_time * 1000;
+        if (_tau_event) {
+            _queue.cancel(_tau_event);
+        }
+        _tau_event = _queue.call_in(std::chrono::duration<int, std::milli>(_conn_end + _script.periodic_tau * 1000 - _queue.tick()),
+                                    mbed::callback(this, &SimPsmModem::tau));
+    }
+
+    void tau()
+    {
+        _tau_event = 0;
+        _taus++;
+        connect(_script.tau_ms);
+        if (_wake_cb) {
+            _wake_cb();
+        }
+    }
+
+    events::EventQueue &_queue;
+    sim_psm_script_t _script;
+    uint32_t _conn_start;
+    uint32_t _conn_end;
+    uint32_t _active_end;
+    uint32_t _tx_end;
+    bool _connected;
+    int _tau_event;
+    uint32_t _wakes;
+    uint32_t _taus;
+    uint32_t _connections;
+    uint64_t _connected_ms;
+    uint64_t _idle_ms;
+    bool _fail;
+    mbed::Callback<void()> _wake_cb;
+    std::vector<sim_psm_message_t> _messages;
+};
+
+#endif // SIM_PSM_MODEM_H
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "gtest/gtest.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "events/EventQueue.h"
+#include "CellularUplinkScheduler.h"
+#include "SimPsmModem.h"
+
+using namespace mbed;
+using namespace events;
+
+static const uint32_t second_ms = 1000;
+static const uint32_t minute_ms = 60 * second_ms;
+static const uint32_t hour_ms = 60 * minute_ms;
+
+// LTE-M modem with T3324 of 1 minute and T3412 of 1 hour, as "00100001" and "00100001" in +CEREG
+static const sim_psm_script_t lte_m_script = {
+    1500,   // wake_ms
+    300,    // connect_ms
+    50,     // tx_ms
+    10000,  // inactivity_ms
+    500,    // tau_ms
+    60,     // active_time
+    3600    // periodic_tau
+};
+
+/** Radio of a simulated day. */
+typedef struct {
+    uint32_t wakes;
+    uint32_t messages;
+    uint64_t radio_on_ms;
+    uint32_t max_latency_ms;
+} uplink_result_t;
+
+// AStyle ignored as the definition is not clear due to preprocessor usage
+// *INDENT-OFF*
+class TestCellularUplinkScheduler : public testing::Test {
+protected:
+
+    TestCellularUplinkScheduler()
+        : _modem(_queue, lte_m_script),
+          _seq(0)
+    {
+    }
+
+    void send_seq(CellularUplinkScheduler &scheduler, bool urgent, nsapi_size_t size = 32)
+    {
+        uint8_t msg[128] = { 0 };
+        memcpy(msg, &_seq, sizeof(_seq));
+        _seq++;
+        EXPECT_EQ((nsapi_size_or_error_t)size, scheduler.send(msg, size, urgent));
+    }
+
+    // Sends a 32 byte reading every 5 minutes and every 20th as an urgent alarm for a day, through the scheduler
+    // or straight to the modem if max_delay is zero
+    static uplink_result_t run_day(std::chrono::duration<int> max_delay, nsapi_size_t buffer_size = 512)
+    {
+        EventQueue queue;
+        SimPsmModem modem(queue, lte_m_script);
+        CellularUplinkScheduler scheduler(queue, callback(&modem, &SimPsmModem::send), buffer_size, max_delay);
+        scheduler.set_power_save_timers(modem.reg_params());
+        modem.set_wake_cb(callback(&scheduler, &CellularUplinkScheduler::radio_active));
+
+        std::vector<uint32_t> sent_ms;
+        for (uint32_t seq = 0; seq < 24 * 12; seq++) {
+            queue.dispatch((seq + 1) * 5 * minute_ms - queue.tick());
+            uint8_t msg[32] = { 0 };
+            memcpy(msg, &seq, sizeof(seq));
+            sent_ms.push_back(queue.tick());
+            const bool urgent = seq % 20 == 19;
+            if (max_delay.count()) {
+                EXPECT_EQ((nsapi_size_or_error_t)sizeof(msg), scheduler.send(msg, sizeof(msg), urgent));
+            } else {
+                EXPECT_EQ((nsapi_size_or_error_t)sizeof(msg), modem.send(msg, sizeof(msg)));
+            }
+        }
+        // the last batch, and the radio is off after it
+        queue.dispatch(2 * hour_ms);
+        modem.finish();
+
+        uplink_result_t result;
+        result.wakes = modem.wakes();
+        result.messages = modem.messages().size();
+        result.radio_on_ms = modem.radio_on_ms();
+        result.max_latency_ms = 0;
+        for (size_t i = 0; i < modem.messages().size(); i++) {
+            const sim_psm_message_t &msg = modem.messages()[i];
+            // received in order
+            EXPECT_EQ(i, msg.seq);
+            if (msg.sent_ms - sent_ms[msg.seq] > result.max_latency_ms) {
+                result.max_latency_ms = msg.sent_ms - sent_ms[msg.seq];
+            }
+        }
+        return result;
+    }
+
+    static void print(const char *name, const uplink_result_t &result)
+    {
+        printf("[ BENCH    ] Uplink 24 h, %s: %u wakes, %.1f messages/wake, radio on %.0f s, latency max %u s\n",
+               name, (unsigned)result.wakes, (double)result.messages / result.wakes, result.radio_on_ms / 1000.0,
+               (unsigned)(result.max_latency_ms / 1000));
+    }
+
+    CellularUplinkScheduler::send_cb_t modem_send()
+    {
+        return callback(&_modem, &SimPsmModem::send);
+    }
+
+    EventQueue _queue;
+    SimPsmModem _modem;
+    uint32_t _seq;
+};
+// *INDENT-ON*
+
+TEST_F(TestCellularUplinkScheduler, queue_and_flush_at_max_delay)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send(), 512, std::chrono::minutes(15));
+    scheduler.set_power_save_timers(_modem.reg_params());
+
+    send_seq(scheduler, false);
+    _queue.dispatch(5 * minute_ms);
+    send_seq(scheduler, false);
+    EXPECT_EQ(2, scheduler.queued());
+    EXPECT_EQ(0u, _modem.messages().size());
+
+    // both go in one wake when the first has waited 15 minutes
+    _queue.dispatch(10 * minute_ms - 1);
+    EXPECT_EQ(0u, _modem.messages().size());
+    _queue.dispatch(1);
+    EXPECT_EQ(2u, _modem.messages().size());
+    EXPECT_EQ(1u, _modem.wakes());
+    EXPECT_EQ(0, scheduler.queued());
+
+    CellularUplinkScheduler::uplink_stats_t stats = scheduler.get_stats();
+    EXPECT_EQ(2u, stats.messages);
+    EXPECT_EQ(1u, stats.batches);
+    EXPECT_EQ(1u, stats.wakes);
+}
+
+TEST_F(TestCellularUplinkScheduler, urgent_bypass)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send());
+    scheduler.set_power_save_timers(_modem.reg_params());
+
+    send_seq(scheduler, false);
+    send_seq(scheduler, false);
+    _queue.dispatch(minute_ms);
+
+    // the queued messages go first, in the same wake
+    send_seq(scheduler, true);
+    ASSERT_EQ(3u, _modem.messages().size());
+    for (uint32_t i = 0; i < 3; i++) {
+        EXPECT_EQ(i, _modem.messages()[i].seq);
+        EXPECT_EQ(minute_ms, _modem.messages()[i].sent_ms);
+    }
+    EXPECT_EQ(1u, _modem.wakes());
+    EXPECT_EQ(1u, scheduler.get_stats().urgent);
+}
+
+TEST_F(TestCellularUplinkScheduler, send_while_awake)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send());
+    scheduler.set_power_save_timers(_modem.reg_params());
+
+    send_seq(scheduler, true);
+
+    // within T3324 the modem is reachable, no need to queue
+    _queue.dispatch(50 * second_ms);
+    send_seq(scheduler, false);
+    EXPECT_EQ(2u, _modem.messages().size());
+    EXPECT_EQ(1u, _modem.wakes());
+    EXPECT_EQ(1u, scheduler.get_stats().wakes);
+
+    // T3324 later the modem is in PSM again
+    _queue.dispatch(61 * second_ms);
+    send_seq(scheduler, false);
+    EXPECT_EQ(2u, _modem.messages().size());
+    EXPECT_EQ(1, scheduler.queued());
+}
+
+TEST_F(TestCellularUplinkScheduler, flush_when_full)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send(), 102);
+    scheduler.set_power_save_timers(_modem.reg_params());
+
+    // 32 bytes and the length of two bytes, three fit
+    send_seq(scheduler, false);
+    send_seq(scheduler, false);
+    send_seq(scheduler, false);
+    EXPECT_EQ(3, scheduler.queued());
+    EXPECT_EQ(0u, _modem.messages().size());
+
+    send_seq(scheduler, false);
+    EXPECT_EQ(4u, _modem.messages().size());
+    EXPECT_EQ(0, scheduler.queued());
+    EXPECT_EQ(1u, _modem.wakes());
+
+    // larger than the queue
+    _queue.dispatch(hour_ms);
+    send_seq(scheduler, false, 101);
+    EXPECT_EQ(5u, _modem.messages().size());
+}
+
+TEST_F(TestCellularUplinkScheduler, flush_with_periodic_tau)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send(), 512, std::chrono::hours(4));
+    scheduler.set_power_save_timers(_modem.reg_params());
+    _modem.set_wake_cb(callback(&scheduler, &CellularUplinkScheduler::radio_active));
+
+    send_seq(scheduler, true);
+    _queue.dispatch(10 * minute_ms);
+    send_seq(scheduler, false);
+
+    // the modem would wake up for TAU an hour after the send, the queued message goes instead of it
+    _queue.dispatch(hour_ms);
+    EXPECT_EQ(2u, _modem.messages().size());
+    EXPECT_EQ(hour_ms, _modem.messages()[1].sent_ms);
+    EXPECT_EQ(2u, _modem.wakes());
+    EXPECT_EQ(0u, _modem.taus());
+}
+
+TEST_F(TestCellularUplinkScheduler, flush_on_radio_active)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send(), 512, std::chrono::hours(4));
+
+    // timers not known, the scheduler is told about the wake of the modem
+    _modem.set_wake_cb(callback(&scheduler, &CellularUplinkScheduler::radio_active));
+    send_seq(scheduler, false);
+    _queue.dispatch(10 * minute_ms);
+    _modem.send("\0\0\0\0", 4);
+
+    // the modem wakes up for TAU an hour later
+    _queue.dispatch(hour_ms + minute_ms);
+    EXPECT_EQ(1u, _modem.taus());
+    EXPECT_EQ(2u, _modem.messages().size());
+    EXPECT_EQ(2u, _modem.wakes());
+}
+
+TEST_F(TestCellularUplinkScheduler, send_failure_keeps_queue)
+{
+    CellularUplinkScheduler scheduler(_queue, modem_send(), 512, std::chrono::minutes(15));
+    scheduler.set_power_save_timers(_modem.reg_params());
+
+    send_seq(scheduler, false);
+    send_seq(scheduler, false);
+    _modem.set_fail(true);
+    _queue.dispatch(15 * minute_ms);
+    EXPECT_EQ(2, scheduler.queued());
+    EXPECT_EQ(NSAPI_ERROR_DEVICE_ERROR, scheduler.flush());
+    EXPECT_EQ(2, scheduler.queued());
+
+    // retried with the next batch
+    _modem.set_fail(false);
+    _queue.dispatch(15 * minute_ms);
+    EXPECT_EQ(0, scheduler.queued());
+    ASSERT_EQ(2u, _modem.messages().size());
+    EXPECT_EQ(0u, _modem.messages()[0].seq);
+    EXPECT_EQ(1u, _modem.messages()[1].seq);
+    EXPECT_EQ(2u, scheduler.get_stats().errors);
+}
+
+TEST_F(TestCellularUplinkScheduler, day_of_readings)
+{
+    const uplink_result_t immediate = run_day(std::chrono::seconds(0));
+    const uplink_result_t batched = run_day(std::chrono::minutes(15));
+    const uplink_result_t batched_to_tau = run_day(std::chrono::hours(2), 1024);
+
+    print("sent at once", immediate);
+    print("batched, 15 min delay", batched);
+    print("batched, 2 h delay", batched_to_tau);
+
+    EXPECT_EQ(288u, immediate.messages);
+    EXPECT_EQ(288u, batched.messages);
+    EXPECT_EQ(288u, batched_to_tau.messages);
+    EXPECT_LE(batched.max_latency_ms, 15 * minute_ms);
+    EXPECT_LE(batched_to_tau.max_latency_ms, 2 * hour_ms);
+
+    EXPECT_LT(batched.wakes * 2, immediate.wakes);
+    EXPECT_LT(batched.radio_on_ms * 2, immediate.radio_on_ms);
+    EXPECT_LT(batched_to_tau.wakes, batched.wakes);
+}
@@ -491,12 +491,15 @@ nsapi_size_or_error_t QUECTEL_BG96_CellularStack::socket_recvfrom_impl(CellularS
             _at.read_string(ip_address, sizeof(ip_address));
             port = _at.read_int();
         }
-        // do not read more than buffer size
-        recv_len = recv_len > (nsapi_size_or_error_t)size ? size : recv_len;
-        _at.read_bytes((uint8_t *)buffer, recv_len);
+        // the rest of a datagram not fitting to the buffer is discarded
+        recv_len = _at.read_binary((uint8_t *)buffer, size, recv_len);
     }
     _at.resp_stop();
 
+    if (recv_len < 0) {
+        return NSAPI_ERROR_DEVICE_ERROR;
+    }
+
     // We block only if 0 recv length really means no data.
     // If 0 is followed by ip address and port can be an UDP 0 length packet
     if (!recv_len && port < 0) {
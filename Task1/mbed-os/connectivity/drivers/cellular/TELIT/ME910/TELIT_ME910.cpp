@@ -64,6 +64,7 @@ static const intptr_t cellular_properties[AT_CellularDevice::PROPERTY_MAX] = {
     0,  // PROPERTY_IP_TCP
     0,  // PROPERTY_IP_UDP
     20, // PROPERTY_AT_SEND_DELAY
+    2,  // PROPERTY_AT_CMD_PIPELINE
 };
 
 TELIT_ME910::TELIT_ME910(FileHandle *fh, PinName pwr, bool active_high)
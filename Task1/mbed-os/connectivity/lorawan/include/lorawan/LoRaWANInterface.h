@@ -352,6 +352,74 @@ public:
      */
     int16_t send(uint8_t port, const uint8_t *data, uint16_t length, int flags);
 
+    /** Queue a message for the gateway
+     *
+     * Unlike send(), this method does not fail while another TX is ongoing:
+     * the message is copied to the uplink queue and sent when the stack is
+     * free. Messages are sent by priority, then by deadline, then in queuing
+     * order. A message which is still queued when its deadline passes is
+     * dropped. Small messages marked as aggregatable are packed in a single
+     * frame with other aggregatable messages for the same port and flags,
+     * up to the payload size of the current data rate.
+     *
+     * A TX_DONE event, or an error event, is sent for every frame built from
+     * the queue. Use get_uplink_queue_stats() to account for messages which
+     * expired or were dropped.
+     *
+     * @param port          The application port number, as for send().
+     *
+     * @param data          A pointer to the data being sent. The data is copied to the queue.
+     *
+     * @param length        The size of data in bytes.
+     *
+     * @param flags         Message type, as for send().
+     *
+     * @param options       Priority, deadline and aggregation of the message.
+     *
+     * @return              The number of bytes queued, or a negative error code on failure:
+     *                      LORAWAN_STATUS_NOT_INITIALIZED   if system is not initialized with initialize(),
+     *                      LORAWAN_STATUS_NO_ACTIVE_SESSIONS if connection is not open,
+     *                      LORAWAN_STATUS_WOULD_BLOCK       if the queue is full of messages at least as urgent,
+     *                      LORAWAN_STATUS_PORT_INVALID      if trying to send to an invalid port (e.g. to 0)
+     *                      LORAWAN_STATUS_PARAMETER_INVALID if NULL data pointer is given, flags are invalid
+     *                                                       or the message is too large for the queue.
+     */
+    int16_t queue_send(uint8_t port, const uint8_t *data, uint16_t length, int flags,
+                       const lorawan_uplink_options_t &options);
+
+    /** Get hold of the uplink queue counters
+     *
+     * @param    stats      the inbound structure that will be filled with the counters.
+     *
+     * @return              LORAWAN_STATUS_OK on success,
+     *                      LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize()
+     */
+    lorawan_status_t get_uplink_queue_stats(lorawan_uplink_queue_stats_t &stats);
+
+    /** Predict when uplinks can be sent
+     *
+     * Computes, at the current data rate, when the next uplink is allowed and
+     * how long a burst of uplinks takes to go through, given the duty cycle
+     * restrictions of the bands and the enabled channels. Pending MAC
+     * commands are accounted for in the frame size.
+     *
+     * The prediction assumes Class A receive windows after every uplink and
+     * no retransmission.
+     *
+     * @param    nb_frames  Number of uplinks in the burst, 1 for the next uplink only.
+     *
+     * @param    size       Application payload size of each uplink.
+     *
+     * @param    plan       the inbound structure that will be filled with the prediction.
+     *
+     * @return              LORAWAN_STATUS_OK on success,
+     *                      LORAWAN_STATUS_NOT_INITIALIZED    if system is not initialized with initialize(),
+     *                      LORAWAN_STATUS_NO_ACTIVE_SESSIONS if connection is not open,
+     *                      LORAWAN_STATUS_LENGTH_ERROR       if the payload does not fit the current data rate,
+     *                      LORAWAN_STATUS_NO_CHANNEL_FOUND   if no channel supports the current data rate.
+     */
+    lorawan_status_t get_tx_plan(uint8_t nb_frames, uint8_t size, lorawan_tx_plan_t &plan);
+
     /** Receives a message from the Network Server on a specific port.
      *
      * @param port          The application port number. Port numbers 0 and 224 are reserved,
@@ -461,14 +529,50 @@ public:
      *
      * Change current device class.
      *
+     * Switching to CLASS_B requires an active session. The device stays in
+     * Class A until it receives a beacon, and reports the progress with the
+     * events BEACON_LOCK, BEACON_NOT_FOUND, BEACON_MISS, SWITCH_CLASS_B_TO_A
+     * and PING_SLOT_INFO_SYNCHED. The timing of the first beacon is asked
+     * from the network with the next uplink.
+     *
      * @param    device_class   The device class
      *
      * @return              LORAWAN_STATUS_OK on success or other negative error code if request failed:
      *                      LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize(),
-     *                      LORAWAN_STATUS_UNSUPPORTED if requested class is not supported
+     *                      LORAWAN_STATUS_UNSUPPORTED if requested class is not supported,
+     *                      LORAWAN_STATUS_NO_ACTIVE_SESSIONS if CLASS_B is requested before joining
      */
     lorawan_status_t set_device_class(device_class_t device_class);
 
+    /** Get Class B status
+     *
+     * Synchronisation to the beacons, measured clock drift and ping slot
+     * statistics.
+     *
+     * @param    status    A reference to the inbound structure which will be
+     *                     filled with the Class B status.
+     *
+     * @return             LORAWAN_STATUS_OK on success,
+     *                     LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize()
+     */
+    lorawan_status_t get_class_b_status(lorawan_class_b_status_t &status);
+
+    /** Set ping slot periodicity
+     *
+     * Sets the periodicity of the Class B ping slots, sent to the network
+     * server when Class B is switched on. The default is
+     * MBED_CONF_LORA_PING_SLOT_PERIODICITY.
+     *
+     * @param    periodicity    0 to 7, the device opens a ping slot every
+     *                          2^periodicity seconds.
+     *
+     * @return             LORAWAN_STATUS_OK on success, a negative error code on failure:
+     *                     LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize(),
+     *                     LORAWAN_STATUS_PARAMETER_INVALID if the periodicity is out of range,
+     *                     LORAWAN_STATUS_BUSY if Class B is on
+     */
+    lorawan_status_t set_ping_slot_periodicity(uint8_t periodicity);
+
     /** Get hold of TX meta-data
      *
      * Use this method to acquire any TX meta-data related to previous transmission.
@@ -49,6 +49,7 @@
 
 #include "lorastack/mac/LoRaMac.h"
 #include "system/LoRaWANTimer.h"
+#include "system/LoRaWANUplinkQueue.h"
 #include "system/lorawan_data_structures.h"
 #include "LoRaRadio.h"
 
@@ -244,6 +245,52 @@ public:
                       uint16_t length, uint8_t flags,
                       bool null_allowed = false, bool allow_port_0 = false);
 
+    /** Queue a message for the gateway
+     *
+     * The message is copied to the uplink queue and sent as soon as the
+     * ongoing transmission, if any, is over. See LoRaWANUplinkQueue.
+     *
+     * @param port              The application port number.
+     *
+     * @param data              A pointer to the data being sent. The data is
+     *                          copied to the queue.
+     *
+     * @param length            The size of data in bytes.
+     *
+     * @param flags             Message type, as for handle_tx().
+     *
+     * @param options           Priority, deadline and aggregation of the message.
+     *
+     * @return                  The number of bytes queued, or
+     *                          LORAWAN_STATUS_WOULD_BLOCK if the queue is full
+     *                          of messages at least as urgent, or a negative
+     *                          error code on failure.
+     */
+    int16_t handle_queued_tx(uint8_t port, const uint8_t *data,
+                             uint16_t length, uint8_t flags,
+                             const lorawan_uplink_options_t &options);
+
+    /** Acquire uplink queue statistics
+     *
+     * @param    stats       A reference to the inbound structure which will be
+     *                       filled with the counters of the uplink queue.
+     *
+     * @return               LORAWAN_STATUS_OK if successful,
+     *                       LORAWAN_STATUS_NOT_INITIALIZED otherwise
+     */
+    lorawan_status_t acquire_uplink_queue_stats(lorawan_uplink_queue_stats_t &stats);
+
+    /** Predicts the schedule of a burst of uplinks
+     *
+     * @param    nb_frames   Number of uplinks in the burst.
+     * @param    size        Application payload size of each uplink.
+     * @param    plan        A reference to the inbound structure which will be
+     *                       filled with the predicted schedule.
+     *
+     * @return               LORAWAN_STATUS_OK if successful, a negative error code otherwise
+     */
+    lorawan_status_t acquire_tx_plan(uint8_t nb_frames, uint8_t size, lorawan_tx_plan_t &plan);
+
     /** Receives a message from the Network Server.
      *
      * @param data              A pointer to buffer where the received data will be
@@ -338,6 +385,27 @@ public:
      */
     lorawan_status_t set_device_class(const device_class_t &device_class);
 
+    /** Acquire Class B status
+     *
+     * @param    status      A reference to the inbound structure which will be
+     *                       filled with the Class B status.
+     *
+     * @return               LORAWAN_STATUS_OK if successful,
+     *                       LORAWAN_STATUS_NOT_INITIALIZED otherwise
+     */
+    lorawan_status_t acquire_class_b_status(lorawan_class_b_status_t &status);
+
+    /** Set ping slot periodicity
+     *
+     * @param    periodicity Ping slot periodicity, 0 to 7. The device opens a
+     *                       ping slot every 2^periodicity seconds.
+     *
+     * @return               LORAWAN_STATUS_OK on success,
+     *                       LORAWAN_STATUS_PARAMETER_INVALID if out of range,
+     *                       LORAWAN_STATUS_BUSY if Class B is on.
+     */
+    lorawan_status_t set_ping_slot_periodicity(uint8_t periodicity);
+
     /** Acquire TX meta-data
      *
      * Upon successful transmission, TX meta-data will be made available
@@ -423,6 +491,11 @@ private:
      */
     void mlme_indication_handler(void);
 
+    /**
+     * Sends an automatic uplink to the port, or asks the application for one
+     */
+    void request_uplink(const uint8_t port);
+
     /**
      * Handles an MLME confirmation
      */
@@ -463,6 +536,13 @@ private:
      */
     void send_automatic_uplink_message(uint8_t port);
 
+    /**
+     * Uplink queue processing
+     */
+    void schedule_queued_uplink(void);
+    void send_queued_uplink(void);
+    void complete_queued_uplink(bool success);
+
     /**
      * TX interrupt handlers and corresponding processors
      */
@@ -481,6 +561,8 @@ private:
     void process_reception(const uint8_t *payload, uint16_t size, int16_t rssi,
                            int8_t snr);
     void process_reception_timeout(bool is_timeout);
+    void process_class_b_reception(rx_slot_t slot, const uint8_t *payload, uint16_t size,
+                                   int16_t rssi, int8_t snr);
 
     int convert_to_msg_flag(const mcps_type_t type);
 
@@ -512,6 +594,9 @@ private:
     uint8_t _rx_payload[LORAMAC_PHY_MAXPAYLOAD];
     events::EventQueue *_queue;
     lorawan_time_t _tx_timestamp;
+    LoRaWANUplinkQueue _uplink_queue;
+    uint8_t _uplink_frame[MBED_CONF_LORA_TX_MAX_SIZE];
+    bool _uplink_dispatch_pending;
 };
 
 #endif /* LORAWANSTACK_H_ */
@@ -205,6 +205,12 @@ typedef struct lorawan_connect {
  * UPLINK_REQUIRED      - Stack indicates application that some uplink needed
  * AUTOMATIC_UPLINK_ERROR - Stack tried automatically send uplink but some error occurred.
  *                          Application should initiate uplink as soon as possible.
+ * BEACON_LOCK          - Class B: the device is synchronised on the beacon and ping slots are open
+ * BEACON_NOT_FOUND     - Class B: beacon acquisition failed, the device stays in Class A
+ * BEACON_MISS          - Class B: an expected beacon was not received, ping slots go on
+ *                        with a wider reception window
+ * SWITCH_CLASS_B_TO_A  - Class B: no beacon for too long, the device is back to Class A
+ * PING_SLOT_INFO_SYNCHED - Class B: the network server acknowledged the ping slot periodicity
  *
  */
 typedef enum lora_events {
@@ -222,6 +228,11 @@ typedef enum lora_events {
     JOIN_FAILURE,
     UPLINK_REQUIRED,
     AUTOMATIC_UPLINK_ERROR,
+    BEACON_LOCK,
+    BEACON_NOT_FOUND,
+    BEACON_MISS,
+    SWITCH_CLASS_B_TO_A,
+    PING_SLOT_INFO_SYNCHED,
 } lorawan_event_t;
 
 /**
@@ -676,4 +687,139 @@ typedef struct {
     uint32_t rx_toa;
 } lorawan_rx_metadata;
 
+/**
+ * Predicted schedule of a burst of uplinks
+ *
+ * Computed from the duty cycle state of the bands, the enabled channels and
+ * the current data rate. All times are in milliseconds, relative to the
+ * time of the request.
+ */
+typedef struct lorawan_tx_plan {
+    /**
+     * Time before the next uplink can start.
+     */
+    uint32_t next_tx;
+    /**
+     * Time before the last uplink of the burst is over.
+     */
+    uint32_t drain_time;
+    /**
+     * Time on air of one uplink.
+     */
+    uint32_t time_on_air;
+    /**
+     * Time on air of the whole burst.
+     */
+    uint32_t airtime;
+    /**
+     * Data rate of the uplinks.
+     */
+    uint8_t datarate;
+} lorawan_tx_plan_t;
+
+/**
+ * Options of a message queued for uplink
+ */
+typedef struct lorawan_uplink_options {
+    /**
+     * Priority of the message, 0 is the most urgent.
+     * More urgent messages are sent first and may evict less urgent ones
+     * when the queue is full.
+     */
+    uint8_t priority;
+    /**
+     * Delay in ms after which the message is dropped if it has not been
+     * handed to the MAC layer yet. 0 means no deadline.
+     */
+    uint32_t deadline;
+    /**
+     * If true, the message may share a frame with other aggregatable messages
+     * queued for the same port with the same flags. Payloads are concatenated,
+     * so aggregated messages must be self-delimiting.
+     */
+    bool aggregate;
+} lorawan_uplink_options_t;
+
+/**
+ * Counters of the uplink queue
+ */
+typedef struct {
+    /**
+     * Messages accepted in the queue.
+     */
+    uint32_t queued;
+    /**
+     * Messages carried by a frame which was transmitted successfully.
+     */
+    uint32_t sent;
+    /**
+     * Messages which shared a frame with a previous message.
+     */
+    uint32_t aggregated;
+    /**
+     * Frames built from the queue.
+     */
+    uint32_t frames;
+    /**
+     * Messages dropped because their deadline passed.
+     */
+    uint32_t expired;
+    /**
+     * Messages evicted by more urgent ones, too large for the current data
+     * rate, or carried by a frame which could not be transmitted.
+     */
+    uint32_t dropped;
+    /**
+     * Cumulated time on air of the frames built from the queue, in ms.
+     */
+    uint32_t airtime;
+    /**
+     * Sum over the sent messages of the delay between queuing and the end of
+     * the transmission, in ms.
+     */
+    uint32_t latency_total;
+    /**
+     * Longest delay between queuing and the end of the transmission, in ms.
+     */
+    uint32_t latency_max;
+} lorawan_uplink_queue_stats_t;
+
+/**
+ * Class B synchronisation state
+ */
+typedef struct {
+    /**
+     * True while the device tracks the beacon and opens ping slots.
+     */
+    bool synchronised;
+    /**
+     * Time field of the beacon of the current period, in GPS seconds.
+     */
+    uint32_t beacon_time;
+    /**
+     * Beacons received since Class B was enabled.
+     */
+    uint32_t beacons_received;
+    /**
+     * Beacons missed since Class B was enabled.
+     */
+    uint32_t beacons_missed;
+    /**
+     * Ping slots opened since Class B was enabled.
+     */
+    uint32_t ping_slots;
+    /**
+     * Measured drift of the local clock against the beacon, in ppm.
+     */
+    int16_t drift;
+    /**
+     * Current widening of the beacon and ping slot windows, in ms.
+     */
+    uint16_t window_widening;
+    /**
+     * Time between two ping slots, in ms.
+     */
+    uint32_t ping_period;
+} lorawan_class_b_status_t;
+
 #endif /* MBED_LORAWAN_TYPES_H_ */
@@ -86,6 +86,10 @@ LoRaMac::LoRaMac()
       _prev_qos_level(LORAWAN_DEFAULT_QOS),
       _demod_ongoing(false)
 {
+    _rx_windows_end = 0;
+    memset(&_beacon_window_config, 0, sizeof(_beacon_window_config));
+    memset(&_ping_slot_config, 0, sizeof(_ping_slot_config));
+
     _params.is_rx_window_enabled = true;
     _params.max_ack_timeout_retries = 1;
     _params.ack_timeout_retry_counter = 1;
@@ -175,6 +179,11 @@ rx_slot_t LoRaMac::get_current_slot(void)
     return _params.rx_slot;
 }
 
+bool LoRaMac::is_class_b_supported(void)
+{
+    return _lora_phy->is_class_b_supported();
+}
+
 /**
  * This part handles incoming frames in response to Radio RX Interrupt
  */
@@ -220,6 +229,12 @@ void LoRaMac::handle_join_accept_frame(const uint8_t *payload, uint16_t size)
             return;
         }
 
+        if (_lora_crypto.set_session_keys(_params.keys.nwk_skey, _params.keys.app_skey,
+                                          sizeof(_params.keys.nwk_skey) * 8) != 0) {
+            _mlme_confirmation.status = LORAMAC_EVENT_INFO_STATUS_CRYPTO_FAIL;
+            return;
+        }
+
         _params.net_id = (uint32_t) _params.rx_buffer[4];
         _params.net_id |= ((uint32_t) _params.rx_buffer[5] << 8);
         _params.net_id |= ((uint32_t) _params.rx_buffer[6] << 16);
@@ -272,7 +287,7 @@ bool LoRaMac::message_integrity_check(const uint8_t *const payload,
                                       uint8_t *const ptr_pos,
                                       uint32_t address,
                                       uint32_t *downlink_counter,
-                                      const uint8_t *nwk_skey)
+                                      const multicast_params_t *multicast)
 {
     uint32_t mic = 0;
     uint32_t mic_rx = 0;
@@ -299,11 +314,16 @@ bool LoRaMac::message_integrity_check(const uint8_t *const payload,
         return false;
     }
 
-    // sizeof nws_skey must be the same as _params.keys.nwk_skey,
-    _lora_crypto.compute_mic(payload, size - LORAMAC_MFR_LEN,
-                             nwk_skey,
-                             sizeof(_params.keys.nwk_skey) * 8,
-                             address, DOWN_LINK, *downlink_counter, &mic);
+    if (multicast) {
+        _lora_crypto.compute_mic(payload, size - LORAMAC_MFR_LEN,
+                                 multicast->nwk_skey,
+                                 sizeof(multicast->nwk_skey) * 8,
+                                 address, DOWN_LINK, *downlink_counter, &mic);
+    } else {
+        _lora_crypto.compute_mic(payload, size - LORAMAC_MFR_LEN,
+                                 LoRaMacCrypto::NWK_SKEY,
+                                 address, DOWN_LINK, *downlink_counter, &mic);
+    }
 
     if (mic_rx != mic) {
         _mcps_indication.status = LORAMAC_EVENT_INFO_STATUS_MIC_FAIL;
@@ -316,8 +336,7 @@ bool LoRaMac::message_integrity_check(const uint8_t *const payload,
 void LoRaMac::extract_data_and_mac_commands(const uint8_t *payload,
                                             uint16_t size,
                                             uint8_t fopts_len,
-                                            uint8_t *nwk_skey,
-                                            uint8_t *app_skey,
+                                            const multicast_params_t *multicast,
                                             uint32_t address,
                                             uint32_t downlink_counter,
                                             int16_t rssi,
@@ -326,6 +345,7 @@ void LoRaMac::extract_data_and_mac_commands(const uint8_t *payload,
     uint8_t frame_len = 0;
     uint8_t payload_start_index = 8 + fopts_len;
     uint8_t port = payload[payload_start_index++];
+    int ret = 0;
     frame_len = (size - 4) - payload_start_index;
 
     _mcps_indication.port = port;
@@ -333,15 +353,25 @@ void LoRaMac::extract_data_and_mac_commands(const uint8_t *payload,
     // special handling of control port 0
     if (port == 0) {
         if (fopts_len == 0) {
-            // sizeof nws_skey must be the same as _params.keys.nwk_skey,
-            if (_lora_crypto.decrypt_payload(payload + payload_start_index,
-                                             frame_len,
-                                             nwk_skey,
-                                             sizeof(_params.keys.nwk_skey) * 8,
-                                             address,
-                                             DOWN_LINK,
-                                             downlink_counter,
-                                             _params.rx_buffer) != 0) {
+            if (multicast) {
+                ret = _lora_crypto.decrypt_payload(payload + payload_start_index,
+                                                   frame_len,
+                                                   multicast->nwk_skey,
+                                                   sizeof(multicast->nwk_skey) * 8,
+                                                   address,
+                                                   DOWN_LINK,
+                                                   downlink_counter,
+                                                   _params.rx_buffer);
+            } else {
+                ret = _lora_crypto.decrypt_payload(payload + payload_start_index,
+                                                   frame_len,
+                                                   LoRaMacCrypto::NWK_SKEY,
+                                                   address,
+                                                   DOWN_LINK,
+                                                   downlink_counter,
+                                                   _params.rx_buffer);
+            }
+            if (ret != 0) {
                 _mcps_indication.status = LORAMAC_EVENT_INFO_STATUS_CRYPTO_FAIL;
             }
 
@@ -387,15 +417,25 @@ void LoRaMac::extract_data_and_mac_commands(const uint8_t *payload,
         }
     }
 
-    // sizeof app_skey must be the same as _params.keys.app_skey
-    if (_lora_crypto.decrypt_payload(payload + payload_start_index,
-                                     frame_len,
-                                     app_skey,
-                                     sizeof(_params.keys.app_skey) * 8,
-                                     address,
-                                     DOWN_LINK,
-                                     downlink_counter,
-                                     _params.rx_buffer) != 0) {
+    if (multicast) {
+        ret = _lora_crypto.decrypt_payload(payload + payload_start_index,
+                                           frame_len,
+                                           multicast->app_skey,
+                                           sizeof(multicast->app_skey) * 8,
+                                           address,
+                                           DOWN_LINK,
+                                           downlink_counter,
+                                           _params.rx_buffer);
+    } else {
+        ret = _lora_crypto.decrypt_payload(payload + payload_start_index,
+                                           frame_len,
+                                           LoRaMacCrypto::APP_SKEY,
+                                           address,
+                                           DOWN_LINK,
+                                           downlink_counter,
+                                           _params.rx_buffer);
+    }
+    if (ret != 0) {
         _mcps_indication.status = LORAMAC_EVENT_INFO_STATUS_CRYPTO_FAIL;
     } else {
         _mcps_indication.buffer = _params.rx_buffer;
@@ -440,8 +480,6 @@ void LoRaMac::handle_data_frame(const uint8_t *const payload,
     uint32_t address = 0;
     uint32_t downlink_counter = 0;
     uint8_t app_payload_start_index = 0;
-    uint8_t *nwk_skey = _params.keys.nwk_skey;
-    uint8_t *app_skey = _params.keys.app_skey;
 
     address = payload[ptr_pos++];
     address |= ((uint32_t) payload[ptr_pos++] << 8);
@@ -455,8 +493,6 @@ void LoRaMac::handle_data_frame(const uint8_t *const payload,
         while (cur_multicast_params != NULL) {
             if (address == cur_multicast_params->address) {
                 is_multicast = true;
-                nwk_skey = cur_multicast_params->nwk_skey;
-                app_skey = cur_multicast_params->app_skey;
                 downlink_counter = cur_multicast_params->dl_frame_counter;
                 break;
             }
@@ -472,8 +508,7 @@ void LoRaMac::handle_data_frame(const uint8_t *const payload,
         }
     } else {
         is_multicast = false;
-        nwk_skey = _params.keys.nwk_skey;
-        app_skey = _params.keys.app_skey;
+        cur_multicast_params = NULL;
         downlink_counter = _params.dl_frame_counter;
     }
 
@@ -482,7 +517,7 @@ void LoRaMac::handle_data_frame(const uint8_t *const payload,
 
     //perform MIC check
     if (!message_integrity_check(payload, size, &ptr_pos, address,
-                                 &downlink_counter, nwk_skey)) {
+                                 &downlink_counter, cur_multicast_params)) {
         tr_error("MIC failed");
         _mcps_indication.status = LORAMAC_EVENT_INFO_STATUS_MIC_FAIL;
         _mcps_indication.pending = false;
@@ -579,7 +614,7 @@ void LoRaMac::handle_data_frame(const uint8_t *const payload,
 
     if (frame_len > 0) {
         extract_data_and_mac_commands(payload, size, fctrl.bits.fopts_len,
-                                      nwk_skey, app_skey, address,
+                                      cur_multicast_params, address,
                                       downlink_counter, rssi, snr);
     } else {
         extract_mac_commands_only(payload, snr, fctrl.bits.fopts_len);
@@ -676,6 +711,13 @@ void LoRaMac::on_radio_rx_done(const uint8_t *const payload, uint16_t size,
                                int16_t rssi, int8_t snr)
 {
     _demod_ongoing = false;
+
+    if (_params.rx_slot == RX_SLOT_WIN_BEACON) {
+        _lora_phy->put_radio_to_sleep();
+        handle_beacon(payload, size);
+        return;
+    }
+
     if (_device_class == CLASS_C && !_continuous_rx2_window_open) {
         _lora_time.stop(_rx2_closure_timer_for_class_c);
         open_rx2_window();
@@ -722,6 +764,8 @@ void LoRaMac::on_radio_rx_done(const uint8_t *const payload, uint16_t size,
             _mcps_indication.pending = false;
             break;
     }
+
+    handle_class_b_answers();
 }
 
 void LoRaMac::on_radio_tx_timeout(void)
@@ -755,10 +799,19 @@ void LoRaMac::on_radio_tx_timeout(void)
 void LoRaMac::on_radio_rx_timeout(bool is_timeout)
 {
     _demod_ongoing = false;
-    if (_device_class == CLASS_A) {
+    if (_device_class != CLASS_C) {
         _lora_phy->put_radio_to_sleep();
     }
 
+    if (_params.rx_slot == RX_SLOT_WIN_BEACON) {
+        handle_beacon_missed();
+        return;
+    }
+
+    if (_params.rx_slot == RX_SLOT_WIN_PING_SLOT) {
+        return;
+    }
+
     if (_params.rx_slot == RX_SLOT_WIN_1) {
         if (_params.is_node_ack_requested == true) {
             _mcps_confirmation.status = is_timeout ?
@@ -1035,7 +1088,8 @@ lorawan_status_t LoRaMac::send(loramac_mhdr_t *machdr, const uint8_t fport,
 
     fctrl.value = 0;
     fctrl.bits.fopts_len = 0;
-    fctrl.bits.fpending = 0;
+    // The FPending bit of an uplink is the Class B bit
+    fctrl.bits.fpending = (_device_class == CLASS_B);
     fctrl.bits.ack = false;
     fctrl.bits.adr_ack_req = false;
     fctrl.bits.adr = _params.sys_params.adr_on;
@@ -1193,6 +1247,22 @@ lorawan_status_t LoRaMac::schedule_tx()
                                    + _params.rx_window2_config.window_offset;
     }
 
+    // Class B: the exchange must not overlap the beacon guard and reserved periods
+    if (_class_b.has_beacon_timing()) {
+        const lorawan_time_t exchange = _lora_phy->compute_tx_time_on_air(_params.sys_params.channel_data_rate,
+                                                                          _params.tx_buffer_len)
+                                        + _params.rx_window2_delay
+                                        + _params.rx_window2_config.window_timeout_ms;
+        const lorawan_time_t delay = _class_b.get_tx_delay(_lora_time.get_current_time(), exchange);
+
+        if (delay != 0) {
+            tr_debug("Beacon guard: Transmitting in %lu ms", delay);
+            _can_cancel_tx = true;
+            _lora_time.start(_params.timers.backoff_timer, delay);
+            return LORAWAN_STATUS_OK;
+        }
+    }
+
     // handle the ack to the server here so that if the sending was cancelled
     // by the user in the backoff period, we would still ack the previous frame.
     if (_params.is_srv_ack_requested) {
@@ -1363,6 +1433,56 @@ int16_t LoRaMac::prepare_ongoing_tx(const uint8_t port,
     return _ongoing_tx_msg.f_buffer_size;
 }
 
+uint8_t LoRaMac::get_max_tx_size()
+{
+    uint8_t fopts_len = _mac_commands.get_mac_cmd_length()
+                        + _mac_commands.get_repeat_commands_length();
+    bool fopts_fit;
+    uint8_t max_size = get_max_frm_payload_size(fopts_len, fopts_fit);
+
+    if (max_size > MBED_CONF_LORA_TX_MAX_SIZE) {
+        max_size = MBED_CONF_LORA_TX_MAX_SIZE;
+    }
+
+    return max_size;
+}
+
+lorawan_status_t LoRaMac::get_tx_plan(uint8_t nb_frames, uint8_t size, lorawan_tx_plan_t &plan)
+{
+    tx_plan_params_t params;
+    uint8_t fopts_len = _mac_commands.get_mac_cmd_length()
+                        + _mac_commands.get_repeat_commands_length();
+    lorawan_time_t elapsed = _lora_time.get_elapsed_time(_params.timers.aggregated_last_tx_time);
+
+    if (!_is_nwk_joined) {
+        return LORAWAN_STATUS_NO_NETWORK_JOINED;
+    }
+
+    if (!validate_payload_length(size, _params.sys_params.channel_data_rate, fopts_len)) {
+        return LORAWAN_STATUS_LENGTH_ERROR;
+    }
+
+    if (MBED_CONF_LORA_DUTY_CYCLE_ON && _lora_phy->verify_duty_cycle(true)) {
+        _params.is_dutycycle_on = true;
+    } else {
+        _params.is_dutycycle_on = false;
+    }
+
+    // the time-off of the last TX is only applied when scheduling the next one
+    calculate_backOff(_params.last_channel_idx);
+
+    params.nb_frames = nb_frames;
+    params.pkt_len = size + fopts_len + LORA_MAC_FRMPAYLOAD_OVERHEAD;
+    params.datarate = _params.sys_params.channel_data_rate;
+    params.dc_enabled = _params.is_dutycycle_on;
+    params.aggregated_duty_cycle = _params.sys_params.aggregated_duty_cycle;
+    params.aggregated_delay = (_params.timers.aggregated_timeoff > elapsed) ?
+                              _params.timers.aggregated_timeoff - elapsed : 0;
+    params.frame_gap = _params.sys_params.recv_delay2;
+
+    return _lora_phy->plan_tx(&params, &plan);
+}
+
 lorawan_status_t LoRaMac::send_ongoing_tx()
 {
     lorawan_status_t status;
@@ -1414,8 +1534,11 @@ device_class_t LoRaMac::get_device_class() const
 }
 
 void LoRaMac::set_device_class(const device_class_t &device_class,
-                               mbed::Callback<void(void)>rx2_would_be_closure_handler)
+                               mbed::Callback<void(void)>rx2_would_be_closure_handler,
+                               mbed::Callback<void(lorawan_event_t)>class_b_event_handler)
 {
+    stop_class_b();
+
     _device_class = device_class;
     _rx2_would_be_closure_for_class_c = rx2_would_be_closure_handler;
 
@@ -1430,6 +1553,20 @@ void LoRaMac::set_device_class(const device_class_t &device_class,
     if (CLASS_A == _device_class) {
         tr_debug("Changing device class to -> CLASS_A");
         _lora_phy->put_radio_to_sleep();
+    } else if (CLASS_B == _device_class) {
+        tr_debug("Changing device class to -> CLASS_B, acquiring beacon");
+        _lora_phy->put_radio_to_sleep();
+
+        // Class A until the first beacon is received
+        _device_class = CLASS_A;
+        _class_b_event_handler = class_b_event_handler;
+        _class_b.start_acquisition();
+        _mac_commands.add_beacon_timing_req();
+        _mac_commands.add_ping_slot_info_req(_class_b.get_ping_slot_periodicity());
+
+        // The acquisition is given up if no BeaconTimingAns comes in time
+        _lora_time.start(_params.timers.beacon_timer,
+                         CLASS_B_BEACON_INTERVAL * MBED_CONF_LORA_CLASS_B_ACQUISITION_PERIODS);
     } else if (CLASS_C == _device_class) {
         _params.is_node_ack_requested = false;
         _lora_phy->put_radio_to_sleep();
@@ -1445,6 +1582,228 @@ void LoRaMac::set_device_class(const device_class_t &device_class,
     }
 }
 
+void LoRaMac::get_class_b_status(lorawan_class_b_status_t &status)
+{
+    _class_b.get_status(status, _lora_time.get_current_time());
+}
+
+lorawan_status_t LoRaMac::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    if (_class_b.get_state() != CLASS_B_OFF) {
+        return LORAWAN_STATUS_BUSY;
+    }
+
+    if (!_class_b.set_ping_slot_periodicity(periodicity)) {
+        return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    return LORAWAN_STATUS_OK;
+}
+
+void LoRaMac::on_beacon_timer_event(void)
+{
+    Lock lock(*this);
+
+    if (!_class_b.has_beacon_timing()) {
+        tr_error("Class B: no beacon timing, giving up");
+        stop_class_b();
+        send_class_b_event(BEACON_NOT_FOUND);
+        return;
+    }
+
+    _lora_time.stop(_params.timers.ping_slot_timer);
+    _params.rx_slot = RX_SLOT_WIN_BEACON;
+
+    _beacon_window_config.frequency = _params.sys_params.beacon_frequency;
+    _beacon_window_config.dl_dwell_time = _params.sys_params.downlink_dwell_time;
+    _beacon_window_config.is_repeater_supported = false;
+    _beacon_window_config.is_rx_continuous = false;
+    _beacon_window_config.rx_slot = RX_SLOT_WIN_BEACON;
+
+    _lora_phy->rx_config(&_beacon_window_config);
+    _lora_phy->handle_receive();
+
+    tr_debug("Beacon window open, Freq = %lu", _beacon_window_config.frequency);
+}
+
+void LoRaMac::on_ping_slot_timer_event(void)
+{
+    Lock lock(*this);
+
+    const lorawan_time_t now = _lora_time.get_current_time();
+
+    // Class A exchanges have priority over the ping slots
+    if (_demod_ongoing || _params.timers.rx_window1_timer.timer_id != 0
+            || _params.timers.rx_window2_timer.timer_id != 0
+            || (int32_t)(_rx_windows_end - now) > 0) {
+        tr_debug("Class A exchange ongoing, skip ping slot");
+        schedule_ping_slot();
+        return;
+    }
+
+    _params.rx_slot = RX_SLOT_WIN_PING_SLOT;
+
+    _ping_slot_config.frequency = _params.sys_params.ping_slot_channel.frequency;
+    _ping_slot_config.dl_dwell_time = _params.sys_params.downlink_dwell_time;
+    _ping_slot_config.is_repeater_supported = _params.is_repeater_supported;
+    _ping_slot_config.is_rx_continuous = false;
+    _ping_slot_config.rx_slot = RX_SLOT_WIN_PING_SLOT;
+
+    _mcps_indication.rx_datarate = _ping_slot_config.datarate;
+    _class_b.ping_slot_opened();
+
+    _lora_phy->rx_config(&_ping_slot_config);
+    _lora_phy->handle_receive();
+
+    schedule_ping_slot();
+}
+
+void LoRaMac::schedule_beacon_window(void)
+{
+    const lorawan_time_t beacon = _class_b.get_next_beacon_start();
+
+    _beacon_window_config.rx_slot = RX_SLOT_WIN_BEACON;
+    _lora_phy->compute_rx_win_params(_lora_phy->get_beacon_datarate(),
+                                     MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH,
+                                     MBED_CONF_LORA_MAX_SYS_RX_ERROR
+                                     + _class_b.get_window_widening(beacon),
+                                     &_beacon_window_config);
+
+    const int32_t delay = (int32_t)(beacon + _beacon_window_config.window_offset
+                                    - _lora_time.get_current_time());
+
+    _lora_time.start(_params.timers.beacon_timer, delay > 0 ? delay : 0);
+}
+
+void LoRaMac::schedule_ping_slot(void)
+{
+    _lora_time.stop(_params.timers.ping_slot_timer);
+
+    if (!_class_b.is_synchronised()) {
+        return;
+    }
+
+    // The widening at the end of the beacon period bounds the one of all
+    // its ping slots
+    _ping_slot_config.rx_slot = RX_SLOT_WIN_PING_SLOT;
+    _lora_phy->compute_rx_win_params(_params.sys_params.ping_slot_channel.datarate,
+                                     MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH,
+                                     MBED_CONF_LORA_MAX_SYS_RX_ERROR
+                                     + _class_b.get_window_widening(_class_b.get_next_beacon_start()),
+                                     &_ping_slot_config);
+
+    const lorawan_time_t now = _lora_time.get_current_time();
+    lorawan_time_t slot = 0;
+
+    if (!_class_b.get_next_ping_slot(now - _ping_slot_config.window_offset + 1, slot)) {
+        // Next ping slots come with the next beacon
+        return;
+    }
+
+    _lora_time.start(_params.timers.ping_slot_timer,
+                     slot + _ping_slot_config.window_offset - now);
+}
+
+void LoRaMac::start_beacon_period(void)
+{
+    uint16_t offset = 0;
+
+    if (_lora_crypto.compute_ping_offset(_class_b.get_beacon_time(), _params.dev_addr,
+                                         _class_b.get_ping_period(), &offset) != 0) {
+        tr_error("Class B: cannot compute the ping offset");
+    }
+    _class_b.set_ping_offset(offset);
+
+    schedule_beacon_window();
+    schedule_ping_slot();
+}
+
+void LoRaMac::handle_beacon(const uint8_t *payload, uint16_t size)
+{
+    uint32_t beacon_time = 0;
+
+    if (!LoRaMacClassB::parse_beacon(payload, size, beacon_time)) {
+        tr_debug("Invalid beacon");
+        handle_beacon_missed();
+        return;
+    }
+
+    // The beacon period starts with the beacon preamble
+    const lorawan_time_t start = _lora_time.get_current_time()
+                                 - _lora_phy->get_rx_time_on_air(MODEM_LORA, size);
+    const bool was_synchronised = _class_b.is_synchronised();
+
+    _class_b.beacon_received(start, beacon_time);
+
+    tr_debug("Beacon received, time = %lu", beacon_time);
+
+    if (!was_synchronised) {
+        _device_class = CLASS_B;
+        send_class_b_event(BEACON_LOCK);
+    }
+
+    start_beacon_period();
+}
+
+void LoRaMac::handle_beacon_missed(void)
+{
+    const bool was_class_b = (_device_class == CLASS_B);
+
+    if (!_class_b.beacon_missed()) {
+        tr_error("Class B: beacon lost, back to Class A");
+        stop_class_b();
+        send_class_b_event(was_class_b ? SWITCH_CLASS_B_TO_A : BEACON_NOT_FOUND);
+        return;
+    }
+
+    if (!_class_b.is_synchronised()) {
+        // Still acquiring, try the next beacon
+        schedule_beacon_window();
+        return;
+    }
+
+    send_class_b_event(BEACON_MISS);
+    start_beacon_period();
+}
+
+void LoRaMac::handle_class_b_answers(void)
+{
+    uint16_t delay = 0;
+
+    if (_mac_commands.take_beacon_timing_ans(delay)
+            && _class_b.get_state() == CLASS_B_ACQUIRING) {
+        // The next beacon starts between Delay and Delay + 1 units after the
+        // end of the downlink
+        _class_b.set_beacon_timing(_lora_time.get_current_time()
+                                   + delay * CLASS_B_BEACON_TIMING_UNIT
+                                   + CLASS_B_BEACON_TIMING_UNIT / 2);
+        _lora_time.stop(_params.timers.beacon_timer);
+        schedule_beacon_window();
+    }
+
+    if (_mac_commands.take_ping_slot_info_ans()) {
+        send_class_b_event(PING_SLOT_INFO_SYNCHED);
+    }
+}
+
+void LoRaMac::stop_class_b(void)
+{
+    _lora_time.stop(_params.timers.beacon_timer);
+    _lora_time.stop(_params.timers.ping_slot_timer);
+    _class_b.reset();
+
+    if (_device_class == CLASS_B) {
+        _device_class = CLASS_A;
+    }
+}
+
+void LoRaMac::send_class_b_event(lorawan_event_t event)
+{
+    if (_class_b_event_handler) {
+        _class_b_event_handler(event);
+    }
+}
+
 void LoRaMac::setup_link_check_request()
 {
     reset_mlme_confirmation();
@@ -1496,6 +1855,11 @@ lorawan_status_t LoRaMac::prepare_join(const lorawan_connect_t *params, bool is_
 
             memcpy(_params.keys.app_skey, params->connection_u.abp.app_skey,
                    sizeof(_params.keys.app_skey));
+
+            if (_lora_crypto.set_session_keys(_params.keys.nwk_skey, _params.keys.app_skey,
+                                              sizeof(_params.keys.nwk_skey) * 8) != 0) {
+                return LORAWAN_STATUS_CRYPTO_FAIL;
+            }
         }
     } else {
 #if MBED_CONF_LORA_OVER_THE_AIR_ACTIVATION
@@ -1526,6 +1890,11 @@ lorawan_status_t LoRaMac::prepare_join(const lorawan_connect_t *params, bool is_
         memcpy(_params.keys.nwk_skey, nwk_skey, sizeof(_params.keys.nwk_skey));
 
         memcpy(_params.keys.app_skey, app_skey, sizeof(_params.keys.app_skey));
+
+        if (_lora_crypto.set_session_keys(_params.keys.nwk_skey, _params.keys.app_skey,
+                                          sizeof(_params.keys.nwk_skey) * 8) != 0) {
+            return LORAWAN_STATUS_CRYPTO_FAIL;
+        }
 #endif
     }
 
@@ -1677,32 +2046,27 @@ lorawan_status_t LoRaMac::prepare_frame(loramac_mhdr_t *machdr,
             // We always add Port Field. Spec leaves it optional.
             _params.tx_buffer[pkt_header_len++] = frame_port;
 
+            uint8_t payload_len = 0;
             if ((payload != NULL) && (_params.tx_buffer_len > 0)) {
-
-                uint8_t *key = _params.keys.app_skey;
-                uint32_t key_length = sizeof(_params.keys.app_skey) * 8;
-                if (frame_port == 0) {
-                    key = _params.keys.nwk_skey;
-                    key_length = sizeof(_params.keys.nwk_skey) * 8;
-                }
-                if (0 != _lora_crypto.encrypt_payload((uint8_t *) payload, _params.tx_buffer_len,
-                                                      key, key_length,
-                                                      _params.dev_addr, UP_LINK,
-                                                      _params.ul_frame_counter,
-                                                      &_params.tx_buffer[pkt_header_len])) {
-                    status = LORAWAN_STATUS_CRYPTO_FAIL;
-                }
+                payload_len = _params.tx_buffer_len;
             }
 
-            _params.tx_buffer_len = pkt_header_len + _params.tx_buffer_len;
+            LoRaMacCrypto::session_key_id_t key = LoRaMacCrypto::APP_SKEY;
+            if (frame_port == 0) {
+                key = LoRaMacCrypto::NWK_SKEY;
+            }
 
-            if (0 != _lora_crypto.compute_mic(_params.tx_buffer, _params.tx_buffer_len,
-                                              _params.keys.nwk_skey, sizeof(_params.keys.nwk_skey) * 8,
-                                              _params.dev_addr,
-                                              UP_LINK, _params.ul_frame_counter, &mic)) {
+            // Encryption and MIC in a single pass with the session key schedules
+            if (0 != _lora_crypto.secure_frame(_params.tx_buffer, pkt_header_len,
+                                               (const uint8_t *) payload, payload_len,
+                                               key,
+                                               _params.dev_addr, UP_LINK,
+                                               _params.ul_frame_counter, &mic)) {
                 status = LORAWAN_STATUS_CRYPTO_FAIL;
             }
 
+            _params.tx_buffer_len = pkt_header_len + payload_len;
+
             _params.tx_buffer[_params.tx_buffer_len + 0] = mic & 0xFF;
             _params.tx_buffer[_params.tx_buffer_len + 1] = (mic >> 8) & 0xFF;
             _params.tx_buffer[_params.tx_buffer_len + 2] = (mic >> 16) & 0xFF;
@@ -1751,6 +2115,9 @@ lorawan_status_t LoRaMac::send_frame_on_channel(uint8_t channel)
     _mcps_confirmation.tx_toa = _params.timers.tx_toa;
     _mlme_confirmation.tx_toa = _params.timers.tx_toa;
 
+    _rx_windows_end = _lora_time.get_current_time() + _params.timers.tx_toa
+                      + _params.rx_window2_delay + _params.rx_window2_config.window_timeout_ms;
+
     if (!_is_nwk_joined) {
         _params.join_request_trial_counter++;
     }
@@ -1839,6 +2206,20 @@ lorawan_status_t LoRaMac::initialize(EventQueue *queue,
         }
         on_ack_timeout_timer_event();
     });
+    _lora_time.init(_params.timers.beacon_timer, [this] {
+        {
+            Lock lock(*this);
+            _lora_time.clear(_params.timers.beacon_timer);
+        }
+        on_beacon_timer_event();
+    });
+    _lora_time.init(_params.timers.ping_slot_timer, [this] {
+        {
+            Lock lock(*this);
+            _lora_time.clear(_params.timers.ping_slot_timer);
+        }
+        on_ping_slot_timer_event();
+    });
 
     _params.timers.mac_init_time = _lora_time.get_current_time();
 
@@ -1854,10 +2235,12 @@ void LoRaMac::disconnect()
     _lora_time.stop(_params.timers.rx_window1_timer);
     _lora_time.stop(_params.timers.rx_window2_timer);
     _lora_time.stop(_params.timers.ack_timeout_timer);
+    stop_class_b();
 
     _lora_phy->put_radio_to_sleep();
 
     _is_nwk_joined = false;
+    _lora_crypto.clear_session_keys();
     _params.is_ack_retry_timeout_expired = false;
     _params.is_rx_window_enabled = true;
     _params.is_node_ack_requested = false;
@@ -1873,9 +2256,19 @@ void LoRaMac::disconnect()
 
 uint8_t LoRaMac::get_max_possible_tx_size(uint8_t fopts_len)
 {
-    uint8_t max_possible_payload_size = 0;
-    uint8_t allowed_frm_payload_size = 0;
+    bool fopts_fit;
+    uint8_t max_possible_payload_size = get_max_frm_payload_size(fopts_len, fopts_fit);
+
+    if (!fopts_fit) {
+        _mac_commands.clear_command_buffer();
+        _mac_commands.clear_repeat_buffer();
+    }
+
+    return max_possible_payload_size;
+}
 
+uint8_t LoRaMac::get_max_frm_payload_size(uint8_t fopts_len, bool &fopts_fit) const
+{
     int8_t datarate = _params.sys_params.channel_data_rate;
     int8_t tx_power = _params.sys_params.channel_tx_power;
     uint32_t adr_ack_counter = _params.adr_ack_counter;
@@ -1886,18 +2279,15 @@ uint8_t LoRaMac::get_max_possible_tx_size(uint8_t fopts_len)
         _lora_phy->get_next_ADR(false, datarate, tx_power, adr_ack_counter);
     }
 
-    allowed_frm_payload_size = _lora_phy->get_max_payload(datarate,
-                                                          _params.is_repeater_supported);
+    uint8_t allowed_frm_payload_size = _lora_phy->get_max_payload(datarate,
+                                                                  _params.is_repeater_supported);
 
-    if (allowed_frm_payload_size >= fopts_len) {
-        max_possible_payload_size = allowed_frm_payload_size - fopts_len;
-    } else {
-        max_possible_payload_size = allowed_frm_payload_size;
-        _mac_commands.clear_command_buffer();
-        _mac_commands.clear_repeat_buffer();
+    // MAC commands which do not fit are dropped rather than the payload
+    fopts_fit = allowed_frm_payload_size >= fopts_len;
+    if (fopts_fit) {
+        return allowed_frm_payload_size - fopts_len;
     }
-
-    return max_possible_payload_size;
+    return allowed_frm_payload_size;
 }
 
 bool LoRaMac::nwk_joined()
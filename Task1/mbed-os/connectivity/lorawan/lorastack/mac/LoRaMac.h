@@ -48,6 +48,7 @@
 #include "system/lorawan_data_structures.h"
 
 #include "LoRaMacChannelPlan.h"
+#include "LoRaMacClassB.h"
 #include "LoRaMacCommand.h"
 #include "LoRaMacCrypto.h"
 #if MBED_CONF_RTOS_PRESENT
@@ -283,6 +284,30 @@ public:
     int16_t prepare_ongoing_tx(const uint8_t port, const uint8_t *data,
                                uint16_t length, uint8_t flags, uint8_t num_retries);
 
+    /**
+     * @brief get_max_tx_size Queries the largest application payload which
+     *                        fits in the next frame, given the current data rate
+     *                        and the pending MAC commands.
+     * @return Size in bytes.
+     */
+    uint8_t get_max_tx_size();
+
+    /**
+     * @brief get_tx_plan Predicts when a burst of uplinks can be sent at the
+     *                    current data rate, given the duty cycle state of the
+     *                    bands and the pending MAC commands.
+     *
+     * @param nb_frames   Number of uplinks in the burst.
+     * @param size        Application payload size of each uplink.
+     * @param plan        The predicted schedule.
+     *
+     * @return LORAWAN_STATUS_OK on success,
+     *         LORAWAN_STATUS_NO_NETWORK_JOINED if not joined,
+     *         LORAWAN_STATUS_LENGTH_ERROR if the payload does not fit,
+     *         LORAWAN_STATUS_NO_CHANNEL_FOUND if no channel supports the data rate.
+     */
+    lorawan_status_t get_tx_plan(uint8_t nb_frames, uint8_t size, lorawan_tx_plan_t &plan);
+
     /**
      * @brief send_ongoing_tx Sends the ongoing_tx_msg
      * @return LORAWAN_STATUS_OK or a negative error code on failure.
@@ -297,12 +322,37 @@ public:
 
     /**
      * @brief set_device_class Sets active device class.
+     *
+     * Class B starts with the acquisition of the beacon: BeaconTimingReq and
+     * PingSlotInfoReq are added to the next uplink, and the device stays in
+     * Class A until it receives a beacon.
+     *
      * @param device_class Device class to use.
      * @param rx2_would_be_closure_handler callback function to inform about
      *        would be closure of RX2 window
+     * @param class_b_event_handler callback function to inform about beacon
+     *        lock and loss, Class B only
      */
     void set_device_class(const device_class_t &device_class,
-                          mbed::Callback<void(void)>rx2_would_be_closure_handler);
+                          mbed::Callback<void(void)>rx2_would_be_closure_handler,
+                          mbed::Callback<void(lorawan_event_t)>class_b_event_handler = NULL);
+
+    /**
+     * @brief get_class_b_status Gets the beacon synchronisation state
+     * @param status Status to fill
+     */
+    void get_class_b_status(lorawan_class_b_status_t &status);
+
+    /**
+     * @brief set_ping_slot_periodicity Sets the ping slot periodicity used
+     *        by the next switch to Class B.
+     * @param periodicity 0 to 7, the device opens a ping slot every
+     *        2^periodicity seconds.
+     * @return LORAWAN_STATUS_OK on success,
+     *         LORAWAN_STATUS_PARAMETER_INVALID if the periodicity is out of range,
+     *         LORAWAN_STATUS_BUSY if Class B is enabled.
+     */
+    lorawan_status_t set_ping_slot_periodicity(uint8_t periodicity);
 
     /**
      * @brief setup_link_check_request Adds link check request command
@@ -408,6 +458,11 @@ public:
      */
     rx_slot_t get_current_slot(void);
 
+    /**
+     * Checks if the region supports Class B
+     */
+    bool is_class_b_supported(void);
+
     /**
      * Indicates what level of QOS is set by network server. QOS level is set
      * in response to a LinkADRReq for UNCONFIRMED messages
@@ -452,6 +507,18 @@ private:
      */
     uint8_t get_max_possible_tx_size(uint8_t fopts_len);
 
+    /**
+     * @brief Computes the size of the largest packet, as get_max_possible_tx_size(),
+     *        without dropping the MAC commands which do not fit.
+     *
+     * @param   fopts_len     [in]    Number of mac commands in the queue pending.
+     * @param   fopts_fit     [out]   False if the MAC commands do not fit and
+     *                                would be omitted.
+     *
+     * @return  Size of the biggest packet that can be sent.
+     */
+    uint8_t get_max_frm_payload_size(uint8_t fopts_len, bool &fopts_fit) const;
+
     /**
      * @brief set_nwk_joined This is used for ABP mode for which real joining does not happen
      * @param joined True if device has joined in network, false otherwise
@@ -496,19 +563,23 @@ private:
     void check_frame_size(uint16_t size);
 
     /**
-     * Performs MIC
+     * Performs MIC, with the keys of the multicast group or with the
+     * session keys if multicast is NULL
      */
     bool message_integrity_check(const uint8_t *payload, uint16_t size,
                                  uint8_t *ptr_pos, uint32_t address,
-                                 uint32_t *downlink_counter, const uint8_t *nwk_skey);
+                                 uint32_t *downlink_counter,
+                                 const multicast_params_t *multicast);
 
     /**
      * Decrypts and extracts data and MAC commands from the received encrypted
-     * payload
+     * payload, with the keys of the multicast group or with the session keys
+     * if multicast is NULL
      */
     void extract_data_and_mac_commands(const uint8_t *payload, uint16_t size,
-                                       uint8_t fopts_len, uint8_t *nwk_skey,
-                                       uint8_t *app_skey, uint32_t address,
+                                       uint8_t fopts_len,
+                                       const multicast_params_t *multicast,
+                                       uint32_t address,
                                        uint32_t downlink_frame_counter,
                                        int16_t rssi, int8_t snr);
     /**
@@ -538,6 +609,59 @@ private:
      */
     void on_ack_timeout_timer_event(void);
 
+    /**
+     * Class B: opens the beacon window, or gives up the acquisition if the
+     * beacon timing is still unknown.
+     */
+    void on_beacon_timer_event(void);
+
+    /**
+     * Class B: opens a ping slot and arms the timer for the next one.
+     */
+    void on_ping_slot_timer_event(void);
+
+    /**
+     * Class B: arms the beacon timer for the next beacon window.
+     */
+    void schedule_beacon_window(void);
+
+    /**
+     * Class B: arms the ping slot timer for the next ping slot of the
+     * current beacon period.
+     */
+    void schedule_ping_slot(void);
+
+    /**
+     * Class B: derives the ping slots of a new beacon period and arms the
+     * timers for it.
+     */
+    void start_beacon_period(void);
+
+    /**
+     * Class B: handles a frame received in the beacon window.
+     */
+    void handle_beacon(const uint8_t *payload, uint16_t size);
+
+    /**
+     * Class B: handles a beacon window closed without a valid beacon.
+     */
+    void handle_beacon_missed(void);
+
+    /**
+     * Class B: takes the BeaconTimingAns and PingSlotInfoAns of a downlink.
+     */
+    void handle_class_b_answers(void);
+
+    /**
+     * Class B: stops the beacon tracking and goes back to Class A.
+     */
+    void stop_class_b(void);
+
+    /**
+     * Class B: forwards an event to the controller layer.
+     */
+    void send_class_b_event(lorawan_event_t event);
+
     /*!
      * \brief Check if the OnAckTimeoutTimer has do be disabled. If so, the
      *        function disables it.
@@ -668,6 +792,29 @@ private:
 
     timer_event_t _rx2_closure_timer_for_class_c;
 
+    /**
+     * Class B beacon tracking and ping slot timing.
+     */
+    LoRaMacClassB _class_b;
+
+    /**
+     * Beacon lock and loss are reported to the controller layer with this
+     * callback, as they do not follow any transmission.
+     */
+    mbed::Callback<void(lorawan_event_t)> _class_b_event_handler;
+
+    /**
+     * Receive window parameters of the beacon and of the ping slots.
+     */
+    rx_config_params_t _beacon_window_config;
+    rx_config_params_t _ping_slot_config;
+
+    /**
+     * End of the RX2 window of the last transmission. Ping slots are
+     * skipped until then, Class A exchanges have priority.
+     */
+    lorawan_time_t _rx_windows_end;
+
     /**
      * Structure to hold MCPS indication data.
      */
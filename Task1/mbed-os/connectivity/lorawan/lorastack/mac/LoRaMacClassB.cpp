@@ -0,0 +1,348 @@
+/**
+ * @file
+ *
+ * @brief      Beacon tracking and ping slot timing of a Class B device
+ *
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "LoRaMacClassB.h"
+
+/*
+ * Beacon period on the network clock, in us
+ */
+#define BEACON_PERIOD_US            ((uint32_t) CLASS_B_BEACON_INTERVAL * 1000)
+
+/*
+ * Offsets in the EU868 beacon: RFU(2) | Time(4) | CRC(2) | GwSpecific(7) | CRC(2)
+ */
+#define BEACON_TIME_OFFSET          2
+#define BEACON_CRC_OFFSET           6
+#define BEACON_GW_SPECIFIC_OFFSET   8
+#define BEACON_GW_SPECIFIC_SIZE     7
+
+/*
+ * Timing error of a beacon timestamp, in ms: the radio events are stamped
+ * with a ms clock.
+ */
+#define BEACON_TIMESTAMP_ERROR      2
+
+static uint16_t beacon_crc(const uint8_t *buffer, uint16_t length)
+{
+    // CRC-16/CCITT, initial value 0
+    uint16_t crc = 0;
+
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= (uint16_t) buffer[i] << 8;
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+LoRaMacClassB::LoRaMacClassB()
+    : _periodicity(MBED_CONF_LORA_PING_SLOT_PERIODICITY)
+{
+    reset();
+}
+
+void LoRaMacClassB::reset()
+{
+    _state = CLASS_B_OFF;
+    _has_timing = false;
+    _has_reference = false;
+    _drift_known = false;
+    _next_beacon = 0;
+    _beacon_time = 0;
+    _reference = 0;
+    _reference_error = 0;
+    _last_beacon = 0;
+    _last_beacon_time = 0;
+    _period = BEACON_PERIOD_US;
+    _ping_offset = 0;
+    _beacons_received = 0;
+    _beacons_missed = 0;
+    _ping_slots = 0;
+}
+
+void LoRaMacClassB::start_acquisition()
+{
+    reset();
+    _state = CLASS_B_ACQUIRING;
+}
+
+class_b_state_t LoRaMacClassB::get_state() const
+{
+    return _state;
+}
+
+bool LoRaMacClassB::is_synchronised() const
+{
+    return _state == CLASS_B_LOCKED || _state == CLASS_B_BEACONLESS;
+}
+
+bool LoRaMacClassB::has_beacon_timing() const
+{
+    return _state != CLASS_B_OFF && _has_timing;
+}
+
+void LoRaMacClassB::set_beacon_timing(lorawan_time_t beacon_start)
+{
+    if (_state != CLASS_B_ACQUIRING) {
+        return;
+    }
+
+    _has_timing = true;
+    _next_beacon = beacon_start;
+    _reference = beacon_start;
+    _reference_error = CLASS_B_BEACON_TIMING_ERROR;
+}
+
+bool LoRaMacClassB::parse_beacon(const uint8_t *payload, uint16_t size, uint32_t &beacon_time)
+{
+    if (!payload || size != CLASS_B_BEACON_SIZE) {
+        return false;
+    }
+
+    const uint16_t crc = (uint16_t) payload[BEACON_CRC_OFFSET]
+                         | ((uint16_t) payload[BEACON_CRC_OFFSET + 1] << 8);
+
+    if (crc != beacon_crc(payload, BEACON_CRC_OFFSET)) {
+        return false;
+    }
+
+    // The gateway specific part has its own CRC, it is not needed here
+    beacon_time = (uint32_t) payload[BEACON_TIME_OFFSET]
+                  | ((uint32_t) payload[BEACON_TIME_OFFSET + 1] << 8)
+                  | ((uint32_t) payload[BEACON_TIME_OFFSET + 2] << 16)
+                  | ((uint32_t) payload[BEACON_TIME_OFFSET + 3] << 24);
+
+    return true;
+}
+
+void LoRaMacClassB::build_beacon(uint32_t beacon_time, uint8_t *payload)
+{
+    memset(payload, 0, CLASS_B_BEACON_SIZE);
+
+    payload[BEACON_TIME_OFFSET] = beacon_time & 0xFF;
+    payload[BEACON_TIME_OFFSET + 1] = (beacon_time >> 8) & 0xFF;
+    payload[BEACON_TIME_OFFSET + 2] = (beacon_time >> 16) & 0xFF;
+    payload[BEACON_TIME_OFFSET + 3] = (beacon_time >> 24) & 0xFF;
+
+    uint16_t crc = beacon_crc(payload, BEACON_CRC_OFFSET);
+    payload[BEACON_CRC_OFFSET] = crc & 0xFF;
+    payload[BEACON_CRC_OFFSET + 1] = (crc >> 8) & 0xFF;
+
+    crc = beacon_crc(payload + BEACON_GW_SPECIFIC_OFFSET, BEACON_GW_SPECIFIC_SIZE);
+    payload[CLASS_B_BEACON_SIZE - 2] = crc & 0xFF;
+    payload[CLASS_B_BEACON_SIZE - 1] = (crc >> 8) & 0xFF;
+}
+
+void LoRaMacClassB::beacon_received(lorawan_time_t beacon_start, uint32_t beacon_time)
+{
+    if (_state == CLASS_B_OFF) {
+        return;
+    }
+
+    // Length of the beacon period measured on the local clock between the
+    // last two beacons received, averaged over the beacons
+    if (_has_reference && _last_beacon_time < beacon_time) {
+        const uint32_t periods = (beacon_time - _last_beacon_time)
+                                 / (CLASS_B_BEACON_INTERVAL / 1000);
+        const uint32_t elapsed = beacon_start - _last_beacon;
+
+        if (periods > 0 && elapsed < CLASS_B_BEACON_LESS_PERIOD + CLASS_B_BEACON_INTERVAL) {
+            const uint32_t measured = (uint32_t)((uint64_t) elapsed * 1000 / periods);
+            const uint32_t max_error = BEACON_PERIOD_US / 1000000 * CLASS_B_MAX_DRIFT;
+
+            if (measured > BEACON_PERIOD_US - max_error
+                    && measured < BEACON_PERIOD_US + max_error) {
+                _period = _drift_known ? (_period * 3 + measured) / 4 : measured;
+                _drift_known = true;
+            }
+        }
+    }
+
+    _state = CLASS_B_LOCKED;
+    _has_timing = true;
+    _has_reference = true;
+
+    _reference = beacon_start;
+    _reference_error = BEACON_TIMESTAMP_ERROR;
+    _last_beacon = beacon_start;
+    _last_beacon_time = beacon_time;
+
+    _beacon_time = beacon_time;
+    _next_beacon = beacon_start + to_local(CLASS_B_BEACON_INTERVAL);
+
+    _beacons_received++;
+}
+
+bool LoRaMacClassB::beacon_missed()
+{
+    if (_state == CLASS_B_OFF) {
+        return false;
+    }
+
+    _beacons_missed++;
+
+    if (_state == CLASS_B_ACQUIRING) {
+        if (!_has_timing || _beacons_missed >= MBED_CONF_LORA_CLASS_B_ACQUISITION_PERIODS) {
+            reset();
+            return false;
+        }
+        _next_beacon += to_local(CLASS_B_BEACON_INTERVAL);
+        return true;
+    }
+
+    _state = CLASS_B_BEACONLESS;
+    _beacon_time += CLASS_B_BEACON_INTERVAL / 1000;
+    _next_beacon += to_local(CLASS_B_BEACON_INTERVAL);
+
+    if ((uint32_t)(_next_beacon - _last_beacon) > CLASS_B_BEACON_LESS_PERIOD) {
+        _state = CLASS_B_OFF;
+        return false;
+    }
+
+    return true;
+}
+
+lorawan_time_t LoRaMacClassB::get_next_beacon_start() const
+{
+    return _next_beacon;
+}
+
+uint32_t LoRaMacClassB::get_window_widening(lorawan_time_t at) const
+{
+    if (!_has_timing) {
+        return 0;
+    }
+
+    const uint32_t ppm = _drift_known ? CLASS_B_RESIDUAL_DRIFT
+                         : MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY;
+    const int32_t elapsed = (int32_t)(at - _reference);
+
+    if (elapsed <= 0) {
+        return _reference_error;
+    }
+
+    return _reference_error + (uint32_t)((uint64_t) elapsed * ppm / 1000000);
+}
+
+bool LoRaMacClassB::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    if (periodicity > 7) {
+        return false;
+    }
+
+    _periodicity = periodicity;
+    return true;
+}
+
+uint8_t LoRaMacClassB::get_ping_slot_periodicity() const
+{
+    return _periodicity;
+}
+
+uint16_t LoRaMacClassB::get_ping_period() const
+{
+    // pingPeriod = 2^12 / pingNb, pingNb = 2^(7 - periodicity)
+    return 1 << (5 + _periodicity);
+}
+
+uint32_t LoRaMacClassB::get_beacon_time() const
+{
+    return _beacon_time;
+}
+
+void LoRaMacClassB::set_ping_offset(uint16_t offset)
+{
+    _ping_offset = offset % get_ping_period();
+}
+
+bool LoRaMacClassB::get_next_ping_slot(lorawan_time_t from, lorawan_time_t &slot_start) const
+{
+    if (!is_synchronised()) {
+        return false;
+    }
+
+    const lorawan_time_t period_start = _next_beacon - to_local(CLASS_B_BEACON_INTERVAL);
+    const uint16_t ping_period = get_ping_period();
+    const uint32_t slots = CLASS_B_BEACON_WINDOW / CLASS_B_PING_SLOT_WINDOW;
+
+    for (uint32_t slot = _ping_offset; slot < slots; slot += ping_period) {
+        const lorawan_time_t start = period_start
+                                     + to_local(CLASS_B_BEACON_RESERVED
+                                                + slot * CLASS_B_PING_SLOT_WINDOW);
+        if ((int32_t)(start - from) >= 0) {
+            slot_start = start;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+lorawan_time_t LoRaMacClassB::get_tx_delay(lorawan_time_t now, lorawan_time_t duration) const
+{
+    if (!has_beacon_timing()) {
+        return 0;
+    }
+
+    // The first beacon whose reserved period is not over yet
+    lorawan_time_t beacon = _next_beacon;
+    while ((int32_t)(beacon + CLASS_B_BEACON_RESERVED - now) <= 0) {
+        beacon += to_local(CLASS_B_BEACON_INTERVAL);
+    }
+
+    const lorawan_time_t guard_start = beacon - CLASS_B_BEACON_GUARD
+                                       - get_window_widening(beacon);
+
+    if ((int32_t)(now + duration - guard_start) <= 0) {
+        return 0;
+    }
+
+    return beacon + CLASS_B_BEACON_RESERVED - now;
+}
+
+void LoRaMacClassB::ping_slot_opened()
+{
+    _ping_slots++;
+}
+
+void LoRaMacClassB::get_status(lorawan_class_b_status_t &status, lorawan_time_t now) const
+{
+    memset(&status, 0, sizeof(status));
+
+    status.synchronised = is_synchronised();
+    status.beacon_time = _beacon_time;
+    status.beacons_received = _beacons_received;
+    status.beacons_missed = _beacons_missed;
+    status.ping_slots = _ping_slots;
+    status.drift = (int16_t)(((int32_t) _period - (int32_t) BEACON_PERIOD_US)
+                             / (CLASS_B_BEACON_INTERVAL / 1000));
+    status.window_widening = (uint16_t) get_window_widening(now);
+    status.ping_period = (uint32_t) get_ping_period() * CLASS_B_PING_SLOT_WINDOW;
+}
+
+lorawan_time_t LoRaMacClassB::to_local(uint32_t duration) const
+{
+    return (lorawan_time_t)((uint64_t) duration * _period / BEACON_PERIOD_US);
+}
@@ -0,0 +1,325 @@
+/**
+ * @file
+ *
+ * @brief      Beacon tracking and ping slot timing of a Class B device
+ *
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MBED_LORAWAN_LORAMACCLASSB_H_
+#define MBED_LORAWAN_LORAMACCLASSB_H_
+
+#include <stdint.h>
+
+#include "system/lorawan_data_structures.h"
+
+/**
+ * Ping slot periodicity requested by the device, 0 to 7. The device opens
+ * 2^(7 - periodicity) ping slots per beacon period, one every 2^periodicity
+ * seconds.
+ */
+#ifndef MBED_CONF_LORA_PING_SLOT_PERIODICITY
+#define MBED_CONF_LORA_PING_SLOT_PERIODICITY        7
+#endif
+
+/**
+ * Worst case accuracy of the device clock in ppm, used to widen the beacon
+ * and ping slot windows until the drift against the network is measured.
+ */
+#ifndef MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY
+#define MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY       100
+#endif
+
+/**
+ * Beacon periods the device waits for its first beacon before giving up
+ * the acquisition.
+ */
+#ifndef MBED_CONF_LORA_CLASS_B_ACQUISITION_PERIODS
+#define MBED_CONF_LORA_CLASS_B_ACQUISITION_PERIODS  2
+#endif
+
+/*!
+ * Beacon period, in ms
+ */
+#define CLASS_B_BEACON_INTERVAL                     128000
+
+/*!
+ * Reserved period at the start of the beacon period, in ms
+ */
+#define CLASS_B_BEACON_RESERVED                     2120
+
+/*!
+ * Guard period before the beacon, in ms. No uplink may overlap it.
+ */
+#define CLASS_B_BEACON_GUARD                        3000
+
+/*!
+ * Beacon window, in ms, shared by the ping slots
+ */
+#define CLASS_B_BEACON_WINDOW                       122880
+
+/*!
+ * Duration of a ping slot, in ms
+ */
+#define CLASS_B_PING_SLOT_WINDOW                    30
+
+/*!
+ * Time a device keeps its ping slots without receiving any beacon, in ms
+ */
+#define CLASS_B_BEACON_LESS_PERIOD                  7200000
+
+/*!
+ * Residual drift in ppm once the drift of the device clock is compensated
+ */
+#define CLASS_B_RESIDUAL_DRIFT                      20
+
+/*!
+ * Bound of the drift the device accepts to measure, in ppm
+ */
+#define CLASS_B_MAX_DRIFT                           500
+
+/*!
+ * Uncertainty of the beacon timing given by a BeaconTimingAns, in ms
+ */
+#define CLASS_B_BEACON_TIMING_ERROR                 30
+
+/*!
+ * Unit of the delay in a BeaconTimingAns, in ms
+ */
+#define CLASS_B_BEACON_TIMING_UNIT                  30
+
+/**
+ * Class B state of the device
+ */
+typedef enum class_b_state_e {
+    /** Class B off. */
+    CLASS_B_OFF = 0,
+    /** Waiting for the first beacon. */
+    CLASS_B_ACQUIRING,
+    /** Beacons received. */
+    CLASS_B_LOCKED,
+    /** Beacons lost, ping slots kept on the local clock. */
+    CLASS_B_BEACONLESS,
+} class_b_state_t;
+
+/** LoRaMacClassB Class
+ *
+ * Keeps the beacon timing of a Class B device and derives the beacon and
+ * ping slot windows from it.
+ *
+ * All times are in ms of the local clock. The length of the beacon period
+ * is measured on that clock between received beacons, so that the windows
+ * follow the network time even when the local clock drifts. The window
+ * widening grows with the time elapsed since the last beacon received.
+ *
+ * The class holds no timers and does not talk to the radio: LoRaMac does,
+ * and reports the beacons received and missed.
+ */
+class LoRaMacClassB {
+
+public:
+    LoRaMacClassB();
+
+    /**
+     * @brief Turns Class B off and forgets the beacon timing.
+     */
+    void reset();
+
+    /**
+     * @brief Starts waiting for the first beacon.
+     *
+     * The beacon timing is unknown until set_beacon_timing() is called.
+     */
+    void start_acquisition();
+
+    /**
+     * @brief Current state.
+     */
+    class_b_state_t get_state() const;
+
+    /**
+     * @brief true if beacons have been received and ping slots are open.
+     */
+    bool is_synchronised() const;
+
+    /**
+     * @brief true if the start of the next beacon is known.
+     */
+    bool has_beacon_timing() const;
+
+    /**
+     * @brief Sets the start of the next beacon, from a BeaconTimingAns.
+     *
+     * @param beacon_start   Local time the next beacon starts.
+     */
+    void set_beacon_timing(lorawan_time_t beacon_start);
+
+    /**
+     * @brief Parses a beacon.
+     *
+     * @param payload        Beacon payload.
+     * @param size           Size of the payload.
+     * @param beacon_time    Network time of the beacon, in seconds since
+     *                       the GPS epoch.
+     *
+     * @return true if the payload is a beacon with a valid time field.
+     */
+    static bool parse_beacon(const uint8_t *payload, uint16_t size, uint32_t &beacon_time);
+
+    /**
+     * @brief Builds a beacon, for a gateway or for testing.
+     *
+     * @param beacon_time    Network time of the beacon.
+     * @param payload        Buffer of CLASS_B_BEACON_SIZE bytes.
+     */
+    static void build_beacon(uint32_t beacon_time, uint8_t *payload);
+
+    /**
+     * @brief Records a received beacon.
+     *
+     * Locks on the beacon and updates the measured length of the beacon
+     * period.
+     *
+     * @param beacon_start   Local time the beacon started.
+     * @param beacon_time    Network time of the beacon.
+     */
+    void beacon_received(lorawan_time_t beacon_start, uint32_t beacon_time);
+
+    /**
+     * @brief Records a missed beacon.
+     *
+     * The timing moves on to the next beacon period on the local clock.
+     *
+     * @return false once no beacon has been received for
+     *         CLASS_B_BEACON_LESS_PERIOD, or while acquiring. Class B is
+     *         then off.
+     */
+    bool beacon_missed();
+
+    /**
+     * @brief Local time the next beacon is expected.
+     */
+    lorawan_time_t get_next_beacon_start() const;
+
+    /**
+     * @brief Window widening for a window opening at the given time, in ms.
+     *
+     * Covers the uncertainty of the timing reference and the drift of the
+     * local clock since it was taken.
+     */
+    uint32_t get_window_widening(lorawan_time_t at) const;
+
+    /**
+     * @brief Sets the ping slot periodicity.
+     *
+     * @param periodicity    0 to 7.
+     *
+     * @return false if the periodicity is out of range.
+     */
+    bool set_ping_slot_periodicity(uint8_t periodicity);
+
+    /**
+     * @brief Ping slot periodicity.
+     */
+    uint8_t get_ping_slot_periodicity() const;
+
+    /**
+     * @brief Number of slots between two ping slots, pingPeriod.
+     */
+    uint16_t get_ping_period() const;
+
+    /**
+     * @brief Network time of the current beacon period.
+     */
+    uint32_t get_beacon_time() const;
+
+    /**
+     * @brief Sets the offset of the ping slots in the current beacon period.
+     *
+     * @param offset         pingOffset, from LoRaMacCrypto::compute_ping_offset().
+     */
+    void set_ping_offset(uint16_t offset);
+
+    /**
+     * @brief Finds the next ping slot of the current beacon period.
+     *
+     * @param from           Earliest local time for the slot to start.
+     * @param slot_start     Local time the slot starts.
+     *
+     * @return false if no ping slot is left in the current beacon period.
+     */
+    bool get_next_ping_slot(lorawan_time_t from, lorawan_time_t &slot_start) const;
+
+    /**
+     * @brief Delay for a transmission so that its exchange does not overlap
+     *        a beacon guard or reserved period.
+     *
+     * @param now            Local time the transmission would start.
+     * @param duration       Duration of the exchange, receive windows
+     *                       included.
+     *
+     * @return 0 if the transmission can go now, the delay in ms otherwise.
+     */
+    lorawan_time_t get_tx_delay(lorawan_time_t now, lorawan_time_t duration) const;
+
+    /**
+     * @brief Records a ping slot window opened.
+     */
+    void ping_slot_opened();
+
+    /**
+     * @brief Fills a status report.
+     *
+     * @param status         Status to fill.
+     * @param now            Local time.
+     */
+    void get_status(lorawan_class_b_status_t &status, lorawan_time_t now) const;
+
+private:
+    /**
+     * Converts a duration of the network clock to the local clock.
+     */
+    lorawan_time_t to_local(uint32_t duration) const;
+
+    class_b_state_t _state;
+    bool _has_timing;
+    bool _has_reference;
+    bool _drift_known;
+
+    /** Start of the next expected beacon. */
+    lorawan_time_t _next_beacon;
+    /** Network time of the current beacon period. */
+    uint32_t _beacon_time;
+
+    /** Timing reference: last beacon received or BeaconTimingAns. */
+    lorawan_time_t _reference;
+    uint32_t _reference_error;
+    /** Last beacon received. */
+    lorawan_time_t _last_beacon;
+    uint32_t _last_beacon_time;
+
+    /** Length of the beacon period on the local clock, in us. */
+    uint32_t _period;
+
+    uint8_t _periodicity;
+    uint16_t _ping_offset;
+
+    uint32_t _beacons_received;
+    uint32_t _beacons_missed;
+    uint32_t _ping_slots;
+};
+
+#endif // MBED_LORAWAN_LORAMACCLASSB_H_
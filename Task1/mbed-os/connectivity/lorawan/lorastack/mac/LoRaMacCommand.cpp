@@ -39,6 +39,9 @@ LoRaMacCommand::LoRaMacCommand()
     sticky_mac_cmd = false;
     mac_cmd_buf_idx = 0;
     mac_cmd_buf_idx_to_repeat = 0;
+    beacon_timing_ans = false;
+    beacon_timing_delay = 0;
+    ping_slot_info_ans = false;
 
     memset(mac_cmd_buffer, 0, sizeof(mac_cmd_buffer));
     memset(mac_cmd_buffer_to_repeat, 0, sizeof(mac_cmd_buffer_to_repeat));
@@ -84,13 +87,17 @@ void LoRaMacCommand::parse_mac_commands_to_repeat()
                 break;
             }
             case MOTE_MAC_LINK_ADR_ANS:
-            case MOTE_MAC_NEW_CHANNEL_ANS: { // 1 byte payload
+            case MOTE_MAC_NEW_CHANNEL_ANS:
+            case MOTE_MAC_PING_SLOT_INFO_REQ:
+            case MOTE_MAC_PING_SLOT_CHANNEL_ANS:
+            case MOTE_MAC_BEACON_FREQ_ANS: { // 1 byte payload
                 i++;
                 break;
             }
             case MOTE_MAC_TX_PARAM_SETUP_ANS:
             case MOTE_MAC_DUTY_CYCLE_ANS:
-            case MOTE_MAC_LINK_CHECK_REQ: { // 0 byte payload
+            case MOTE_MAC_LINK_CHECK_REQ:
+            case MOTE_MAC_BEACON_TIMING_REQ: { // 0 byte payload
                 break;
             }
             default: {
@@ -292,6 +299,56 @@ lorawan_status_t LoRaMacCommand::process_mac_commands(const uint8_t *payload, ui
                 ret_value = add_dl_channel_ans(status);
             }
             break;
+            case SRV_MAC_PING_SLOT_INFO_ANS:
+                ping_slot_info_ans = true;
+                break;
+            case SRV_MAC_PING_SLOT_CHANNEL_REQ: {
+                uint32_t frequency;
+                uint8_t datarate;
+
+                frequency = (uint32_t) payload[mac_index++];
+                frequency |= (uint32_t) payload[mac_index++] << 8;
+                frequency |= (uint32_t) payload[mac_index++] << 16;
+                frequency *= 100;
+                datarate = payload[mac_index++] & 0x0F;
+
+                if (frequency == 0) {
+                    frequency = lora_phy.get_default_ping_slot_frequency();
+                }
+
+                status = lora_phy.accept_ping_slot_channel_req(frequency, datarate);
+
+                if ((status & 0x03) == 0x03) {
+                    mac_sys_params.ping_slot_channel.frequency = frequency;
+                    mac_sys_params.ping_slot_channel.datarate = datarate;
+                }
+                ret_value = add_ping_slot_channel_ans(status);
+            }
+            break;
+            case SRV_MAC_BEACON_TIMING_ANS:
+                beacon_timing_delay = (uint16_t) payload[mac_index++];
+                beacon_timing_delay |= (uint16_t) payload[mac_index++] << 8;
+                // The channel index only matters in regions with beacon hopping
+                mac_index++;
+                beacon_timing_ans = true;
+                break;
+            case SRV_MAC_BEACON_FREQ_REQ: {
+                uint32_t frequency;
+
+                frequency = (uint32_t) payload[mac_index++];
+                frequency |= (uint32_t) payload[mac_index++] << 8;
+                frequency |= (uint32_t) payload[mac_index++] << 16;
+                frequency *= 100;
+
+                status = 0;
+                if (lora_phy.accept_beacon_freq_req(frequency)) {
+                    mac_sys_params.beacon_frequency = frequency ? frequency
+                                                      : lora_phy.get_default_beacon_frequency();
+                    status = 0x01;
+                }
+                ret_value = add_beacon_freq_ans(status);
+            }
+            break;
             default:
                 // Unknown command. ABORT MAC commands processing
                 tr_error("Invalid MAC command (0x%X)!", payload[mac_index]);
@@ -323,6 +380,47 @@ lorawan_status_t LoRaMacCommand::add_link_check_req()
     return ret;
 }
 
+lorawan_status_t LoRaMacCommand::add_ping_slot_info_req(uint8_t periodicity)
+{
+    lorawan_status_t ret = LORAWAN_STATUS_LENGTH_ERROR;
+    if (cmd_buffer_remaining() > 1) {
+        mac_cmd_buffer[mac_cmd_buf_idx++] = MOTE_MAC_PING_SLOT_INFO_REQ;
+        // Periodicity, the datarate bits are RFU
+        mac_cmd_buffer[mac_cmd_buf_idx++] = periodicity & 0x07;
+        ret = LORAWAN_STATUS_OK;
+    }
+    return ret;
+}
+
+lorawan_status_t LoRaMacCommand::add_beacon_timing_req()
+{
+    lorawan_status_t ret = LORAWAN_STATUS_LENGTH_ERROR;
+    if (cmd_buffer_remaining() > 0) {
+        mac_cmd_buffer[mac_cmd_buf_idx++] = MOTE_MAC_BEACON_TIMING_REQ;
+        // No payload for this command
+        ret = LORAWAN_STATUS_OK;
+    }
+    return ret;
+}
+
+bool LoRaMacCommand::take_beacon_timing_ans(uint16_t &delay)
+{
+    if (!beacon_timing_ans) {
+        return false;
+    }
+
+    beacon_timing_ans = false;
+    delay = beacon_timing_delay;
+    return true;
+}
+
+bool LoRaMacCommand::take_ping_slot_info_ans()
+{
+    const bool ans = ping_slot_info_ans;
+    ping_slot_info_ans = false;
+    return ans;
+}
+
 lorawan_status_t LoRaMacCommand::add_link_adr_ans(uint8_t status)
 {
     lorawan_status_t ret = LORAWAN_STATUS_LENGTH_ERROR;
@@ -422,3 +520,27 @@ lorawan_status_t LoRaMacCommand::add_dl_channel_ans(uint8_t status)
     }
     return ret;
 }
+
+lorawan_status_t LoRaMacCommand::add_ping_slot_channel_ans(uint8_t status)
+{
+    lorawan_status_t ret = LORAWAN_STATUS_LENGTH_ERROR;
+    if (cmd_buffer_remaining() > 1) {
+        mac_cmd_buffer[mac_cmd_buf_idx++] = MOTE_MAC_PING_SLOT_CHANNEL_ANS;
+        // Status: Datarate OK, Channel frequency OK
+        mac_cmd_buffer[mac_cmd_buf_idx++] = status;
+        ret = LORAWAN_STATUS_OK;
+    }
+    return ret;
+}
+
+lorawan_status_t LoRaMacCommand::add_beacon_freq_ans(uint8_t status)
+{
+    lorawan_status_t ret = LORAWAN_STATUS_LENGTH_ERROR;
+    if (cmd_buffer_remaining() > 1) {
+        mac_cmd_buffer[mac_cmd_buf_idx++] = MOTE_MAC_BEACON_FREQ_ANS;
+        // Status: Beacon frequency OK
+        mac_cmd_buffer[mac_cmd_buf_idx++] = status;
+        ret = LORAWAN_STATUS_OK;
+    }
+    return ret;
+}
@@ -131,6 +131,41 @@ public:
      */
     lorawan_status_t add_link_check_req();
 
+    /**
+     * @brief Adds a new PingSlotInfoReq MAC command to be sent.
+     *
+     * @param [in] periodicity  Ping slot periodicity, 0 to 7
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_ping_slot_info_req(uint8_t periodicity);
+
+    /**
+     * @brief Adds a new BeaconTimingReq MAC command to be sent.
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_beacon_timing_req();
+
+    /**
+     * @brief Takes the delay of the last BeaconTimingAns received.
+     *
+     * @param [out] delay  Delay between the end of the downlink and the start
+     *                     of the next beacon, in units of 30 ms
+     *
+     * @return status  True if a BeaconTimingAns was received since the last call
+     */
+    bool take_beacon_timing_ans(uint16_t &delay);
+
+    /**
+     * @brief Takes the PingSlotInfoAns indication.
+     *
+     * @return status  True if a PingSlotInfoAns was received since the last call
+     */
+    bool take_ping_slot_info_ans();
+
     /**
      * @brief Set battery level query callback method
      *        If callback is not set, BAT_LEVEL_NO_MEASURE is returned.
@@ -220,6 +255,26 @@ private:
      */
     lorawan_status_t add_dl_channel_ans(uint8_t status);
 
+    /**
+     * @brief Adds a new PingSlotChannelAns MAC command to be sent.
+     *
+     * @param [in] status Status bits
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_ping_slot_channel_ans(uint8_t status);
+
+    /**
+     * @brief Adds a new BeaconFreqAns MAC command to be sent.
+     *
+     * @param [in] status Status bits
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_beacon_freq_ans(uint8_t status);
+
 private:
     /**
       * Indicates if there are any pending sticky MAC commands
@@ -247,6 +302,21 @@ private:
      */
     uint8_t mac_cmd_buffer_to_repeat[LORA_MAC_COMMAND_MAX_LENGTH];
 
+    /**
+     * Indicates that a BeaconTimingAns is waiting for the MAC
+     */
+    bool beacon_timing_ans;
+
+    /**
+     * Delay of the last BeaconTimingAns
+     */
+    uint16_t beacon_timing_delay;
+
+    /**
+     * Indicates that a PingSlotInfoAns is waiting for the MAC
+     */
+    bool ping_slot_info_ans;
+
     mbed::Callback<uint8_t(void)> _battery_level_cb;
 };
 
@@ -30,10 +30,29 @@
 #include "LoRaMacCrypto.h"
 #include "system/lorawan_data_structures.h"
 #include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
 
 
 #if defined(MBEDTLS_CMAC_C) && defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_C)
 
+/**
+ * Derives a CMAC subkey: shifts in left by one bit and applies the
+ * constant Rb when the most significant bit was set (RFC 4493)
+ */
+static void derive_cmac_subkey(const uint8_t *in, uint8_t *out)
+{
+    uint8_t overflow = 0;
+
+    for (int i = 15; i >= 0; i--) {
+        out[i] = (uint8_t)(in[i] << 1) | overflow;
+        overflow = in[i] >> 7;
+    }
+
+    if (in[0] & 0x80) {
+        out[15] ^= 0x87;
+    }
+}
+
 LoRaMacCrypto::LoRaMacCrypto()
 {
 #if defined(MBEDTLS_PLATFORM_C)
@@ -42,10 +61,19 @@ LoRaMacCrypto::LoRaMacCrypto()
         MBED_ASSERT(0 && "LoRaMacCrypto: Fail in mbedtls_platform_setup.");
     }
 #endif /* MBEDTLS_PLATFORM_C */
+
+    mbedtls_aes_init(&_nwk_skey.aes_ctx);
+    mbedtls_aes_init(&_app_skey.aes_ctx);
+    _nwk_skey.valid = false;
+    _app_skey.valid = false;
 }
 
 LoRaMacCrypto::~LoRaMacCrypto()
 {
+    clear_session_keys();
+    mbedtls_aes_free(&_nwk_skey.aes_ctx);
+    mbedtls_aes_free(&_app_skey.aes_ctx);
+
 #if defined(MBEDTLS_PLATFORM_C)
     mbedtls_platform_teardown(NULL);
 #endif /* MBEDTLS_PLATFORM_C */
@@ -57,23 +85,10 @@ int LoRaMacCrypto::compute_mic(const uint8_t *buffer, uint16_t size,
                                uint32_t *mic)
 {
     uint8_t computed_mic[16] = {};
-    uint8_t mic_block_b0[16] = {};
+    uint8_t mic_block_b0[16];
     int ret = 0;
 
-    mic_block_b0[0] = 0x49;
-
-    mic_block_b0[5] = dir;
-
-    mic_block_b0[6] = (address) & 0xFF;
-    mic_block_b0[7] = (address >> 8) & 0xFF;
-    mic_block_b0[8] = (address >> 16) & 0xFF;
-    mic_block_b0[9] = (address >> 24) & 0xFF;
-
-    mic_block_b0[10] = (seq_counter) & 0xFF;
-    mic_block_b0[11] = (seq_counter >> 8) & 0xFF;
-    mic_block_b0[12] = (seq_counter >> 16) & 0xFF;
-    mic_block_b0[13] = (seq_counter >> 24) & 0xFF;
-
+    build_block(mic_block_b0, 0x49, address, dir, seq_counter);
     mic_block_b0[15] = size & 0xFF;
 
     mbedtls_cipher_init(aes_cmac_ctx);
@@ -118,17 +133,44 @@ exit:
     return ret;
 }
 
+int LoRaMacCrypto::compute_mic(const uint8_t *buffer, uint16_t size,
+                               session_key_id_t key_id,
+                               uint32_t address, uint8_t dir, uint32_t seq_counter,
+                               uint32_t *mic)
+{
+    uint8_t mic_block_b0[16];
+    cmac_state_t state;
+    int ret = 0;
+
+    session_key_t *session = get_session_key(key_id);
+    if (!session) {
+        return MBEDTLS_ERR_CIPHER_INVALID_CONTEXT;
+    }
+
+    build_block(mic_block_b0, 0x49, address, dir, seq_counter);
+    mic_block_b0[15] = size & 0xFF;
+
+    cmac_start(state);
+
+    ret = cmac_update(*session, state, mic_block_b0, sizeof(mic_block_b0));
+    if (0 != ret) {
+        return ret;
+    }
+
+    ret = cmac_update(*session, state, buffer, size & 0xFF);
+    if (0 != ret) {
+        return ret;
+    }
+
+    return cmac_finish(*session, state, mic);
+}
+
 int LoRaMacCrypto::encrypt_payload(const uint8_t *buffer, uint16_t size,
                                    const uint8_t *key, const uint32_t key_length,
                                    uint32_t address, uint8_t dir, uint32_t seq_counter,
                                    uint8_t *enc_buffer)
 {
-    uint16_t i;
-    uint8_t bufferIndex = 0;
-    uint16_t ctr = 1;
     int ret = 0;
-    uint8_t a_block[16] = {};
-    uint8_t s_block[16] = {};
 
     mbedtls_aes_init(&aes_ctx);
     ret = mbedtls_aes_setkey_enc(&aes_ctx, key, key_length);
@@ -136,47 +178,8 @@ int LoRaMacCrypto::encrypt_payload(const uint8_t *buffer, uint16_t size,
         goto exit;
     }
 
-    a_block[0] = 0x01;
-    a_block[5] = dir;
-
-    a_block[6] = (address) & 0xFF;
-    a_block[7] = (address >> 8) & 0xFF;
-    a_block[8] = (address >> 16) & 0xFF;
-    a_block[9] = (address >> 24) & 0xFF;
-
-    a_block[10] = (seq_counter) & 0xFF;
-    a_block[11] = (seq_counter >> 8) & 0xFF;
-    a_block[12] = (seq_counter >> 16) & 0xFF;
-    a_block[13] = (seq_counter >> 24) & 0xFF;
-
-    while (size >= 16) {
-        a_block[15] = ((ctr) & 0xFF);
-        ctr++;
-        ret = mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT, a_block,
-                                    s_block);
-        if (0 != ret) {
-            goto exit;
-        }
-
-        for (i = 0; i < 16; i++) {
-            enc_buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ s_block[i];
-        }
-        size -= 16;
-        bufferIndex += 16;
-    }
-
-    if (size > 0) {
-        a_block[15] = ((ctr) & 0xFF);
-        ret = mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT, a_block,
-                                    s_block);
-        if (0 != ret) {
-            goto exit;
-        }
-
-        for (i = 0; i < size; i++) {
-            enc_buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ s_block[i];
-        }
-    }
+    ret = apply_keystream(&aes_ctx, buffer, size, address, dir, seq_counter,
+                          enc_buffer, NULL, NULL);
 
 exit:
     mbedtls_aes_free(&aes_ctx);
@@ -192,6 +195,28 @@ int LoRaMacCrypto::decrypt_payload(const uint8_t *buffer, uint16_t size,
                            dec_buffer);
 }
 
+int LoRaMacCrypto::encrypt_payload(const uint8_t *buffer, uint16_t size,
+                                   session_key_id_t key_id,
+                                   uint32_t address, uint8_t dir, uint32_t seq_counter,
+                                   uint8_t *enc_buffer)
+{
+    session_key_t *session = get_session_key(key_id);
+    if (!session) {
+        return MBEDTLS_ERR_CIPHER_INVALID_CONTEXT;
+    }
+
+    return apply_keystream(&session->aes_ctx, buffer, size, address, dir,
+                           seq_counter, enc_buffer, NULL, NULL);
+}
+
+int LoRaMacCrypto::decrypt_payload(const uint8_t *buffer, uint16_t size,
+                                   session_key_id_t key_id,
+                                   uint32_t address, uint8_t dir, uint32_t seq_counter,
+                                   uint8_t *dec_buffer)
+{
+    return encrypt_payload(buffer, size, key_id, address, dir, seq_counter, dec_buffer);
+}
+
 int LoRaMacCrypto::compute_join_frame_mic(const uint8_t *buffer, uint16_t size,
                                           const uint8_t *key, uint32_t key_length,
                                           uint32_t *mic)
@@ -299,6 +324,270 @@ exit:
     mbedtls_aes_free(&aes_ctx);
     return ret;
 }
+
+int LoRaMacCrypto::set_session_keys(const uint8_t *nwk_skey, const uint8_t *app_skey,
+                                    uint32_t key_length)
+{
+    int ret = prepare_session_key(_nwk_skey, nwk_skey, key_length);
+    if (0 != ret) {
+        return ret;
+    }
+
+    ret = prepare_session_key(_app_skey, app_skey, key_length);
+    if (0 != ret) {
+        clear_session_keys();
+    }
+
+    return ret;
+}
+
+void LoRaMacCrypto::clear_session_keys()
+{
+    session_key_t *sessions[] = { &_nwk_skey, &_app_skey };
+
+    for (session_key_t *session : sessions) {
+        session->valid = false;
+        mbedtls_platform_zeroize(session->k1, sizeof(session->k1));
+        mbedtls_platform_zeroize(session->k2, sizeof(session->k2));
+        mbedtls_aes_free(&session->aes_ctx);
+        mbedtls_aes_init(&session->aes_ctx);
+    }
+}
+
+int LoRaMacCrypto::secure_frame(uint8_t *frame, uint8_t header_size,
+                                const uint8_t *payload, uint8_t payload_size,
+                                session_key_id_t payload_key,
+                                uint32_t address, uint8_t dir, uint32_t seq_counter,
+                                uint32_t *mic)
+{
+    int ret = 0;
+    session_key_t *payload_session = get_session_key(payload_key);
+    session_key_t *mic_session = get_session_key(NWK_SKEY);
+
+    if (!payload_session || !mic_session) {
+        return MBEDTLS_ERR_CIPHER_INVALID_CONTEXT;
+    }
+
+    uint8_t mic_block_b0[16];
+    build_block(mic_block_b0, 0x49, address, dir, seq_counter);
+    mic_block_b0[15] = (header_size + payload_size) & 0xFF;
+
+    cmac_state_t state;
+    cmac_start(state);
+
+    ret = cmac_update(*mic_session, state, mic_block_b0, sizeof(mic_block_b0));
+    if (0 != ret) {
+        return ret;
+    }
+
+    ret = cmac_update(*mic_session, state, frame, header_size);
+    if (0 != ret) {
+        return ret;
+    }
+
+    // The MIC absorbs each block of cipher text as soon as it is produced
+    ret = apply_keystream(&payload_session->aes_ctx, payload, payload_size,
+                          address, dir, seq_counter, frame + header_size,
+                          mic_session, &state);
+    if (0 != ret) {
+        return ret;
+    }
+
+    return cmac_finish(*mic_session, state, mic);
+}
+
+int LoRaMacCrypto::compute_ping_offset(uint32_t beacon_time, uint32_t address,
+                                       uint16_t ping_period, uint16_t *offset)
+{
+    static const uint8_t zero_key[16] = { 0 };
+    uint8_t block[16];
+    uint8_t rand[16];
+    int ret = 0;
+
+    memset(block, 0, sizeof(block));
+    block[0] = beacon_time & 0xFF;
+    block[1] = (beacon_time >> 8) & 0xFF;
+    block[2] = (beacon_time >> 16) & 0xFF;
+    block[3] = (beacon_time >> 24) & 0xFF;
+    block[4] = address & 0xFF;
+    block[5] = (address >> 8) & 0xFF;
+    block[6] = (address >> 16) & 0xFF;
+    block[7] = (address >> 24) & 0xFF;
+
+    mbedtls_aes_init(&aes_ctx);
+
+    ret = mbedtls_aes_setkey_enc(&aes_ctx, zero_key, sizeof(zero_key) * 8);
+    if (0 != ret) {
+        goto exit;
+    }
+
+    ret = mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT, block, rand);
+    if (0 != ret) {
+        goto exit;
+    }
+
+    *offset = (rand[0] + rand[1] * 256) % ping_period;
+
+exit:
+    mbedtls_aes_free(&aes_ctx);
+    return ret;
+}
+
+LoRaMacCrypto::session_key_t *LoRaMacCrypto::get_session_key(session_key_id_t key_id)
+{
+    session_key_t *session = key_id == NWK_SKEY ? &_nwk_skey : &_app_skey;
+
+    return session->valid ? session : NULL;
+}
+
+int LoRaMacCrypto::prepare_session_key(session_key_t &session, const uint8_t *key,
+                                       uint32_t key_length)
+{
+    uint8_t l_block[16] = {};
+    int ret = 0;
+
+    session.valid = false;
+
+    if (key_length != 128) {
+        return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+
+    ret = mbedtls_aes_setkey_enc(&session.aes_ctx, key, key_length);
+    if (0 != ret) {
+        return ret;
+    }
+
+    ret = mbedtls_aes_crypt_ecb(&session.aes_ctx, MBEDTLS_AES_ENCRYPT, l_block, l_block);
+    if (0 != ret) {
+        return ret;
+    }
+
+    derive_cmac_subkey(l_block, session.k1);
+    derive_cmac_subkey(session.k1, session.k2);
+    mbedtls_platform_zeroize(l_block, sizeof(l_block));
+
+    session.valid = true;
+
+    return 0;
+}
+
+void LoRaMacCrypto::cmac_start(cmac_state_t &state)
+{
+    memset(state.x, 0, sizeof(state.x));
+    state.block_len = 0;
+}
+
+int LoRaMacCrypto::cmac_update(session_key_t &session, cmac_state_t &state,
+                               const uint8_t *data, uint16_t size)
+{
+    int ret = 0;
+
+    for (uint16_t i = 0; i < size; i++) {
+        // The last block is kept for cmac_finish() which applies a subkey to it
+        if (state.block_len == sizeof(state.block)) {
+            for (uint8_t j = 0; j < sizeof(state.block); j++) {
+                state.x[j] ^= state.block[j];
+            }
+            ret = mbedtls_aes_crypt_ecb(&session.aes_ctx, MBEDTLS_AES_ENCRYPT,
+                                        state.x, state.x);
+            if (0 != ret) {
+                return ret;
+            }
+            state.block_len = 0;
+        }
+        state.block[state.block_len++] = data[i];
+    }
+
+    return 0;
+}
+
+int LoRaMacCrypto::cmac_finish(session_key_t &session, cmac_state_t &state,
+                               uint32_t *mic)
+{
+    const uint8_t *subkey = session.k1;
+    int ret = 0;
+
+    if (state.block_len < sizeof(state.block)) {
+        state.block[state.block_len] = 0x80;
+        memset(state.block + state.block_len + 1, 0,
+               sizeof(state.block) - state.block_len - 1);
+        subkey = session.k2;
+    }
+
+    for (uint8_t j = 0; j < sizeof(state.block); j++) {
+        state.x[j] ^= state.block[j] ^ subkey[j];
+    }
+
+    ret = mbedtls_aes_crypt_ecb(&session.aes_ctx, MBEDTLS_AES_ENCRYPT, state.x, state.x);
+    if (0 != ret) {
+        return ret;
+    }
+
+    *mic = (uint32_t)((uint32_t) state.x[3] << 24
+                      | (uint32_t) state.x[2] << 16
+                      | (uint32_t) state.x[1] << 8 | (uint32_t) state.x[0]);
+
+    return 0;
+}
+
+void LoRaMacCrypto::build_block(uint8_t *block, uint8_t type, uint32_t address,
+                                uint8_t dir, uint32_t seq_counter)
+{
+    memset(block, 0, 16);
+
+    block[0] = type;
+    block[5] = dir;
+
+    block[6] = (address) & 0xFF;
+    block[7] = (address >> 8) & 0xFF;
+    block[8] = (address >> 16) & 0xFF;
+    block[9] = (address >> 24) & 0xFF;
+
+    block[10] = (seq_counter) & 0xFF;
+    block[11] = (seq_counter >> 8) & 0xFF;
+    block[12] = (seq_counter >> 16) & 0xFF;
+    block[13] = (seq_counter >> 24) & 0xFF;
+}
+
+int LoRaMacCrypto::apply_keystream(mbedtls_aes_context *ctx, const uint8_t *buffer,
+                                   uint16_t size, uint32_t address, uint8_t dir,
+                                   uint32_t seq_counter, uint8_t *out_buffer,
+                                   session_key_t *mic_session, cmac_state_t *mic_state)
+{
+    uint8_t a_block[16];
+    uint8_t s_block[16];
+    uint16_t offset = 0;
+    uint16_t ctr = 1;
+    int ret = 0;
+
+    build_block(a_block, 0x01, address, dir, seq_counter);
+
+    while (offset < size) {
+        const uint16_t len = (size - offset) < 16 ? (size - offset) : 16;
+
+        a_block[15] = ((ctr) & 0xFF);
+        ctr++;
+        ret = mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, a_block, s_block);
+        if (0 != ret) {
+            return ret;
+        }
+
+        for (uint16_t i = 0; i < len; i++) {
+            out_buffer[offset + i] = buffer[offset + i] ^ s_block[i];
+        }
+
+        if (mic_state) {
+            ret = cmac_update(*mic_session, *mic_state, out_buffer + offset, len);
+            if (0 != ret) {
+                return ret;
+            }
+        }
+
+        offset += len;
+    }
+
+    return 0;
+}
 #else
 
 LoRaMacCrypto::LoRaMacCrypto()
@@ -323,6 +612,15 @@ int LoRaMacCrypto::compute_mic(const uint8_t *, uint16_t, const uint8_t *, uint3
     return LORAWAN_STATUS_CRYPTO_FAIL;
 }
 
+int LoRaMacCrypto::compute_mic(const uint8_t *, uint16_t, session_key_id_t, uint32_t,
+                               uint8_t, uint32_t, uint32_t *)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
 int LoRaMacCrypto::encrypt_payload(const uint8_t *, uint16_t, const uint8_t *, uint32_t, uint32_t,
                                    uint8_t, uint32_t, uint8_t *)
 {
@@ -332,6 +630,15 @@ int LoRaMacCrypto::encrypt_payload(const uint8_t *, uint16_t, const uint8_t *, u
     return LORAWAN_STATUS_CRYPTO_FAIL;
 }
 
+int LoRaMacCrypto::encrypt_payload(const uint8_t *, uint16_t, session_key_id_t, uint32_t,
+                                   uint8_t, uint32_t, uint8_t *)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
 int LoRaMacCrypto::decrypt_payload(const uint8_t *, uint16_t, const uint8_t *, uint32_t, uint32_t,
                                    uint8_t, uint32_t, uint8_t *)
 {
@@ -341,6 +648,15 @@ int LoRaMacCrypto::decrypt_payload(const uint8_t *, uint16_t, const uint8_t *, u
     return LORAWAN_STATUS_CRYPTO_FAIL;
 }
 
+int LoRaMacCrypto::decrypt_payload(const uint8_t *, uint16_t, session_key_id_t, uint32_t,
+                                   uint8_t, uint32_t, uint8_t *)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
 int LoRaMacCrypto::compute_join_frame_mic(const uint8_t *, uint16_t, const uint8_t *, uint32_t, uint32_t *)
 {
     MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
@@ -366,4 +682,33 @@ int LoRaMacCrypto::compute_skeys_for_join_frame(const uint8_t *, uint32_t, const
     return LORAWAN_STATUS_CRYPTO_FAIL;
 }
 
+int LoRaMacCrypto::set_session_keys(const uint8_t *, const uint8_t *, uint32_t)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
+void LoRaMacCrypto::clear_session_keys()
+{
+}
+
+int LoRaMacCrypto::secure_frame(uint8_t *, uint8_t, const uint8_t *, uint8_t, session_key_id_t,
+                                uint32_t, uint8_t, uint32_t, uint32_t *)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
+int LoRaMacCrypto::compute_ping_offset(uint32_t, uint32_t, uint16_t, uint16_t *)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
 #endif
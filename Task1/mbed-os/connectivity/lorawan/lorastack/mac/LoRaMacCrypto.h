@@ -36,6 +36,14 @@ SPDX-License-Identifier: BSD-3-Clause
 
 class LoRaMacCrypto {
 public:
+    /**
+     * Session keys prepared by set_session_keys()
+     */
+    enum session_key_id_t {
+        NWK_SKEY,
+        APP_SKEY
+    };
+
     /**
      * Constructor
      */
@@ -65,6 +73,23 @@ public:
                     uint32_t address, uint8_t dir, uint32_t seq_counter,
                     uint32_t *mic);
 
+    /**
+     * Computes the LoRaMAC frame MIC field with a session key
+     *
+     * @param [in]  buffer          - Data buffer
+     * @param [in]  size            - Data buffer size
+     * @param [in]  key_id          - Session key to be used
+     * @param [in]  address         - Frame address
+     * @param [in]  dir             - Frame direction [0: uplink, 1: downlink]
+     * @param [in]  seq_counter     - Frame sequence counter
+     * @param [out] mic             - Computed MIC field
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int compute_mic(const uint8_t *buffer, uint16_t size, session_key_id_t key_id,
+                    uint32_t address, uint8_t dir, uint32_t seq_counter,
+                    uint32_t *mic);
+
     /**
      * Performs payload encryption
      *
@@ -84,6 +109,23 @@ public:
                         uint32_t address, uint8_t dir, uint32_t seq_counter,
                         uint8_t *enc_buffer);
 
+    /**
+     * Performs payload encryption with a session key
+     *
+     * @param [in]  buffer          - Data buffer
+     * @param [in]  size            - Data buffer size
+     * @param [in]  key_id          - Session key to be used
+     * @param [in]  address         - Frame address
+     * @param [in]  dir             - Frame direction [0: uplink, 1: downlink]
+     * @param [in]  seq_counter     - Frame sequence counter
+     * @param [out] enc_buffer      - Encrypted buffer
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int encrypt_payload(const uint8_t *buffer, uint16_t size, session_key_id_t key_id,
+                        uint32_t address, uint8_t dir, uint32_t seq_counter,
+                        uint8_t *enc_buffer);
+
     /**
      * Performs payload decryption
      *
@@ -103,6 +145,23 @@ public:
                         uint32_t address, uint8_t dir, uint32_t seq_counter,
                         uint8_t *dec_buffer);
 
+    /**
+     * Performs payload decryption with a session key
+     *
+     * @param [in]  buffer          - Data buffer
+     * @param [in]  size            - Data buffer size
+     * @param [in]  key_id          - Session key to be used
+     * @param [in]  address         - Frame address
+     * @param [in]  dir             - Frame direction [0: uplink, 1: downlink]
+     * @param [in]  seq_counter     - Frame sequence counter
+     * @param [out] dec_buffer      - Decrypted buffer
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int decrypt_payload(const uint8_t *buffer, uint16_t size, session_key_id_t key_id,
+                        uint32_t address, uint8_t dir, uint32_t seq_counter,
+                        uint8_t *dec_buffer);
+
     /**
      * Computes the LoRaMAC Join Request frame MIC field
      *
@@ -150,7 +209,112 @@ public:
                                      const uint8_t *app_nonce, uint16_t dev_nonce,
                                      uint8_t *nwk_skey, uint8_t *app_skey);
 
+    /**
+     * Prepares the session keys after a join or an ABP activation
+     *
+     * The AES key schedules and the CMAC subkeys of both keys are computed
+     * once for the session. The functions taking a session_key_id_t use them
+     * without any key setup or memory allocation. The keys themselves are
+     * not kept.
+     *
+     * @param [in]  nwk_skey        - Network session key
+     * @param [in]  app_skey        - Application session key
+     * @param [in]  key_length      - Length of the keys (bits)
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int set_session_keys(const uint8_t *nwk_skey, const uint8_t *app_skey,
+                         uint32_t key_length);
+
+    /**
+     * Forgets the session keys
+     */
+    void clear_session_keys();
+
+    /**
+     * Encrypts the payload of a data frame and computes the frame MIC in a
+     * single pass
+     *
+     * The frame header (MHDR to FPort) must already be in the frame buffer;
+     * the encrypted payload is written right after it. The MIC covers the
+     * header and the encrypted payload, it is computed with the network
+     * session key.
+     *
+     * @param [in]  frame           - Frame buffer holding the header
+     * @param [in]  header_size     - Size of the frame header
+     * @param [in]  payload         - Payload to encrypt, may be NULL if payload_size is 0
+     * @param [in]  payload_size    - Payload size
+     * @param [in]  payload_key     - Session key used for the payload
+     * @param [in]  address         - Frame address
+     * @param [in]  dir             - Frame direction [0: uplink, 1: downlink]
+     * @param [in]  seq_counter     - Frame sequence counter
+     * @param [out] mic             - Computed MIC field
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int secure_frame(uint8_t *frame, uint8_t header_size,
+                     const uint8_t *payload, uint8_t payload_size,
+                     session_key_id_t payload_key,
+                     uint32_t address, uint8_t dir, uint32_t seq_counter,
+                     uint32_t *mic);
+
+    /**
+     * Computes the Class B ping slot offset of a beacon period
+     *
+     * LoRaWAN Specification V1.0.2, chapter 13.2: AES-128 with a zero key
+     * over the beacon time and the device address.
+     *
+     * @param [in]  beacon_time     - Time field of the beacon opening the period
+     * @param [in]  address         - Device address
+     * @param [in]  ping_period     - Number of slots between two ping slots
+     * @param [out] offset          - Ping offset, in slots
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int compute_ping_offset(uint32_t beacon_time, uint32_t address, uint16_t ping_period,
+                            uint16_t *offset);
+
 private:
+    /**
+     * Precomputed AES key schedule and CMAC subkeys of a session key
+     */
+    struct session_key_t {
+        uint8_t k1[16];
+        uint8_t k2[16];
+        mbedtls_aes_context aes_ctx;
+        bool valid;
+    };
+
+    /**
+     * Running CMAC computation
+     */
+    struct cmac_state_t {
+        uint8_t x[16];
+        uint8_t block[16];
+        uint8_t block_len;
+    };
+
+    session_key_t *get_session_key(session_key_id_t key_id);
+
+    int prepare_session_key(session_key_t &session, const uint8_t *key,
+                            uint32_t key_length);
+
+    static void cmac_start(cmac_state_t &state);
+
+    static int cmac_update(session_key_t &session, cmac_state_t &state,
+                           const uint8_t *data, uint16_t size);
+
+    static int cmac_finish(session_key_t &session, cmac_state_t &state,
+                           uint32_t *mic);
+
+    static void build_block(uint8_t *block, uint8_t type, uint32_t address,
+                            uint8_t dir, uint32_t seq_counter);
+
+    static int apply_keystream(mbedtls_aes_context *ctx, const uint8_t *buffer,
+                               uint16_t size, uint32_t address, uint8_t dir,
+                               uint32_t seq_counter, uint8_t *out_buffer,
+                               session_key_t *mic_session, cmac_state_t *mic_state);
+
     /**
      * AES computation context variable
      */
@@ -160,6 +324,16 @@ private:
      * CMAC computation context variable
      */
     mbedtls_cipher_context_t aes_cmac_ctx[1];
+
+    /**
+     * Network session key
+     */
+    session_key_t _nwk_skey;
+
+    /**
+     * Application session key
+     */
+    session_key_t _app_skey;
 };
 
 #endif // MBED_LORAWAN_MAC_LORAMAC_CRYPTO_H__
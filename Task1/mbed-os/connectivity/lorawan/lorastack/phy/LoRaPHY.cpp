@@ -35,6 +35,7 @@ SPDX-License-Identifier: BSD-3-Clause
 #define MAX_PREAMBLE_LENGTH     8.0f
 #define TICK_GRANULARITY_JITTER 1.0f
 #define CHANNELS_IN_MASK        16
+#define PLANNER_MAX_NB_BANDS    6
 
 LoRaPHY::LoRaPHY()
     : _radio(NULL),
@@ -485,6 +486,27 @@ uint8_t LoRaPHY::get_bandwidth(uint8_t dr)
     }
 }
 
+uint8_t LoRaPHY::keep_least_restricted_channels(uint8_t *channel_indices, uint8_t count)
+{
+    band_t *band_table = (band_t *) phy_params.bands.table;
+    channel_params_t *channel_list = phy_params.channels.channel_list;
+    uint16_t min_duty_cycle = UINT16_MAX;
+    uint8_t kept = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        min_duty_cycle = MIN(min_duty_cycle,
+                             band_table[channel_list[channel_indices[i]].band].duty_cycle);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (band_table[channel_list[channel_indices[i]].band].duty_cycle == min_duty_cycle) {
+            channel_indices[kept++] = channel_indices[i];
+        }
+    }
+
+    return kept;
+}
+
 uint8_t LoRaPHY::enabled_channel_count(uint8_t datarate,
                                        const uint16_t *channel_mask,
                                        uint8_t *channel_indices,
@@ -558,6 +580,12 @@ void LoRaPHY::reset_to_default_values(loramac_protocol_params *params, bool init
 
     params->sys_params.rx2_channel.datarate = get_default_rx2_datarate();
 
+    params->sys_params.ping_slot_channel.frequency = get_default_ping_slot_frequency();
+
+    params->sys_params.ping_slot_channel.datarate = get_default_ping_slot_datarate();
+
+    params->sys_params.beacon_frequency = get_default_beacon_frequency();
+
     params->sys_params.uplink_dwell_time = phy_params.ul_dwell_time_setting;
 
     params->sys_params.max_eirp = phy_params.default_max_eirp;
@@ -643,6 +671,31 @@ uint8_t LoRaPHY::get_default_rx2_datarate()
     return phy_params.rx_window2_datarate;
 }
 
+bool LoRaPHY::is_class_b_supported()
+{
+    return phy_params.class_b_supported;
+}
+
+uint32_t LoRaPHY::get_default_beacon_frequency()
+{
+    return phy_params.beacon_frequency;
+}
+
+uint8_t LoRaPHY::get_beacon_datarate()
+{
+    return phy_params.beacon_datarate;
+}
+
+uint32_t LoRaPHY::get_default_ping_slot_frequency()
+{
+    return phy_params.ping_slot_frequency;
+}
+
+uint8_t LoRaPHY::get_default_ping_slot_datarate()
+{
+    return phy_params.ping_slot_datarate;
+}
+
 uint16_t *LoRaPHY::get_channel_mask(bool get_default)
 {
     if (get_default) {
@@ -855,6 +908,123 @@ void LoRaPHY::compute_rx_win_params(int8_t datarate, uint8_t min_rx_symbols,
                          rx_conf_params->datarate);
 }
 
+uint32_t LoRaPHY::compute_tx_time_on_air(int8_t datarate, uint8_t pkt_len)
+{
+    uint8_t phy_dr = ((uint8_t *)phy_params.datarates.table)[datarate];
+    uint32_t bandwidth = ((uint32_t *)phy_params.bandwidths.table)[datarate];
+
+    if (phy_params.fsk_supported && datarate == phy_params.max_tx_datarate) {
+        // preamble, sync word, length, payload and CRC at phy_dr kbps
+        return (uint32_t) ceilf(8.0f * (MBED_CONF_LORA_UPLINK_PREAMBLE_LENGTH + 3 + 1 + pkt_len + 2)
+                                / (float) phy_dr);
+    }
+
+    // explicit header, CRC on and coding rate 4/5 as set by tx_config()
+    float t_symbol = compute_symb_timeout_lora(phy_dr, bandwidth);
+    int low_dr_optimize = (t_symbol > 16.0f) ? 1 : 0;
+    float t_preamble = (MBED_CONF_LORA_UPLINK_PREAMBLE_LENGTH + 4.25f) * t_symbol;
+    float symbols = ceilf((8.0f * pkt_len - 4.0f * phy_dr + 28 + 16)
+                          / (4.0f * (phy_dr - 2 * low_dr_optimize))) * 5;
+
+    symbols = 8 + MAX(symbols, 0.0f);
+
+    return (uint32_t) floorf(t_preamble + symbols * t_symbol + 0.999f);
+}
+
+bool LoRaPHY::prefer_band(bool dc_enabled, uint8_t band, uint8_t other,
+                          const uint8_t *band_channels)
+{
+    band_t *band_table = (band_t *) phy_params.bands.table;
+
+    if (MBED_CONF_LORA_DUTY_CYCLE_CHANNEL_PREFERENCE && dc_enabled) {
+        return band_table[band].duty_cycle < band_table[other].duty_cycle;
+    }
+
+    // set_next_channel() draws one of the available channels
+    return band_channels[band] > band_channels[other];
+}
+
+lorawan_status_t LoRaPHY::plan_tx(const tx_plan_params_t *params, lorawan_tx_plan_t *plan)
+{
+    band_t *band_table = (band_t *) phy_params.bands.table;
+    channel_params_t *channel_list = phy_params.channels.channel_list;
+    uint8_t nb_bands = MIN(phy_params.bands.size, PLANNER_MAX_NB_BANDS);
+    lorawan_time_t band_free[PLANNER_MAX_NB_BANDS];
+    uint8_t band_channels[PLANNER_MAX_NB_BANDS] = { 0 };
+    bool usable = false;
+
+    memset(plan, 0, sizeof(lorawan_tx_plan_t));
+    plan->datarate = params->datarate;
+
+    if (!is_datarate_supported(params->datarate)) {
+        return LORAWAN_STATUS_NO_CHANNEL_FOUND;
+    }
+
+    // Bands with an enabled channel for the datarate
+    for (uint8_t i = 0; i < phy_params.max_channel_cnt; i++) {
+        if (mask_bit_test(phy_params.channels.mask, i)
+                && channel_list[i].band < nb_bands
+                && val_in_range(params->datarate, channel_list[i].dr_range.fields.min,
+                                channel_list[i].dr_range.fields.max)) {
+            band_channels[channel_list[i].band]++;
+            usable = true;
+        }
+    }
+
+    if (!usable) {
+        return LORAWAN_STATUS_NO_CHANNEL_FOUND;
+    }
+
+    // Remaining time-off of the bands
+    for (uint8_t i = 0; i < nb_bands; i++) {
+        lorawan_time_t elapsed = _lora_time->get_elapsed_time(band_table[i].last_tx_time);
+        band_free[i] = 0;
+        if (params->dc_enabled && band_table[i].off_time > elapsed) {
+            band_free[i] = band_table[i].off_time - elapsed;
+        }
+    }
+
+    lorawan_time_t toa = compute_tx_time_on_air(params->datarate, params->pkt_len);
+    lorawan_time_t earliest = params->aggregated_delay;
+    lorawan_time_t tx_end = 0;
+
+    for (uint8_t n = 0; n < params->nb_frames; n++) {
+        int8_t band = -1;
+        lorawan_time_t start = 0;
+
+        for (uint8_t i = 0; i < nb_bands; i++) {
+            if (!band_channels[i]) {
+                continue;
+            }
+
+            lorawan_time_t band_start = MAX(earliest, band_free[i]);
+            if (band < 0 || band_start < start
+                    || (band_start == start && prefer_band(params->dc_enabled, i, band, band_channels))) {
+                band = i;
+                start = band_start;
+            }
+        }
+
+        if (n == 0) {
+            plan->next_tx = start;
+        }
+
+        tx_end = start + toa;
+        if (params->dc_enabled) {
+            band_free[band] = start + toa * band_table[band].duty_cycle;
+        }
+
+        earliest = MAX(tx_end + params->frame_gap,
+                       tx_end + toa * params->aggregated_duty_cycle - toa);
+        plan->airtime += toa;
+    }
+
+    plan->time_on_air = toa;
+    plan->drain_time = tx_end;
+
+    return LORAWAN_STATUS_OK;
+}
+
 uint32_t LoRaPHY::get_rx_time_on_air(uint8_t modem, uint16_t pkt_len)
 {
     uint32_t toa = 0;
@@ -889,6 +1059,17 @@ bool LoRaPHY::rx_config(rx_config_params_t *rx_conf)
         _radio->set_rx_config((radio_modems_t) rx_conf->modem_type, 50000, phy_dr * 1000, 0, 83333, MAX_PREAMBLE_LENGTH,
                               rx_conf->window_timeout, false, 0, true, 0, 0,
                               false, rx_conf->is_rx_continuous);
+    } else if (rx_conf->rx_slot == RX_SLOT_WIN_BEACON) {
+        // Beacons are sent in implicit header mode, with no CRC and with
+        // the IQ not inverted
+        rx_conf->modem_type = MODEM_LORA;
+        _radio->set_rx_config((radio_modems_t) rx_conf->modem_type, rx_conf->bandwidth, phy_dr, 1, 0,
+                              CLASS_B_BEACON_PREAMBLE_LENGTH,
+                              rx_conf->window_timeout, true, CLASS_B_BEACON_SIZE, false, 0, 0,
+                              false, rx_conf->is_rx_continuous);
+        _radio->set_max_payload_length((radio_modems_t) rx_conf->modem_type, CLASS_B_BEACON_SIZE);
+        _radio->unlock();
+        return true;
     } else {
         rx_conf->modem_type = MODEM_LORA;
         _radio->set_rx_config((radio_modems_t) rx_conf->modem_type, rx_conf->bandwidth, phy_dr, 1, 0,
@@ -1106,6 +1287,37 @@ uint8_t LoRaPHY::accept_rx_param_setup_req(rx_param_setup_req_t *params)
     return status;
 }
 
+uint8_t LoRaPHY::accept_ping_slot_channel_req(uint32_t frequency, uint8_t datarate)
+{
+    uint8_t status = 0x03;
+
+    if (frequency == 0) {
+        frequency = get_default_ping_slot_frequency();
+    }
+
+    if (lookup_band_for_frequency(frequency) < 0
+            || _radio->check_rf_frequency(frequency) == false) {
+        status &= 0xFE; // Channel frequency KO
+    }
+
+    if (val_in_range(datarate, phy_params.min_rx_datarate,
+                     phy_params.max_rx_datarate) == 0) {
+        status &= 0xFD; // Datarate KO
+    }
+
+    return status;
+}
+
+bool LoRaPHY::accept_beacon_freq_req(uint32_t frequency)
+{
+    if (frequency == 0) {
+        return true;
+    }
+
+    return lookup_band_for_frequency(frequency) >= 0
+           && _radio->check_rf_frequency(frequency);
+}
+
 bool LoRaPHY::accept_tx_param_setup_req(uint8_t ul_dwell_time, uint8_t dl_dwell_time)
 {
     if (phy_params.accept_tx_param_setup_req) {
@@ -1296,6 +1508,11 @@ lorawan_status_t LoRaPHY::set_next_channel(channel_selection_params_t *params,
         channel_count = enabled_channel_count(params->current_datarate,
                                               phy_params.channels.mask,
                                               enabled_channels, &delay_tx);
+
+        // Spend the time-off budget of the least restricted bands first
+        if (MBED_CONF_LORA_DUTY_CYCLE_CHANNEL_PREFERENCE && params->dc_enabled) {
+            channel_count = keep_least_restricted_channels(enabled_channels, channel_count);
+        }
     } else {
         delay_tx++;
         next_tx_delay = params->aggregate_timeoff -
@@ -40,6 +40,16 @@
 #include "LoRaRadio.h"
 #include "lora_phy_ds.h"
 
+/**
+ * When duty cycle is enforced, pick the channels of the bands with the
+ * lowest duty cycle restriction first, so the time-off of the restricted
+ * bands is kept for later frames. Off, the channel is drawn among all the
+ * available ones.
+ */
+#ifndef MBED_CONF_LORA_DUTY_CYCLE_CHANNEL_PREFERENCE
+#define MBED_CONF_LORA_DUTY_CYCLE_CHANNEL_PREFERENCE false
+#endif
+
 /** LoRaPHY Class
  * Parent class for LoRa regional PHY implementations
  */
@@ -327,6 +337,23 @@ public:
      */
     virtual uint8_t accept_rx_param_setup_req(rx_param_setup_req_t *params);
 
+    /** Accept or rejects PingSlotChannelReq MAC command
+     *
+     * @param [in] frequency The ping slot frequency, 0 for the default one.
+     * @param [in] datarate  The ping slot datarate.
+     *
+     * @return The status of the operation, according to the LoRaWAN specification.
+     */
+    virtual uint8_t accept_ping_slot_channel_req(uint32_t frequency, uint8_t datarate);
+
+    /** Accept or rejects BeaconFreqReq MAC command
+     *
+     * @param [in] frequency The beacon frequency, 0 for the default one.
+     *
+     * @return True if the frequency is accepted.
+     */
+    virtual bool accept_beacon_freq_req(uint32_t frequency);
+
     /**
      * @brief accept_tx_param_setup_req Makes decision whether to accept or reject TxParamSetupReq MAC command.
      *
@@ -495,6 +522,36 @@ public:
      */
     uint8_t get_default_rx2_datarate();
 
+    /**
+     * @brief is_class_b_supported Checks if the region defines Class B beacons
+     * @return True if Class B is supported, false otherwise
+     */
+    bool is_class_b_supported();
+
+    /**
+     * @brief get_default_beacon_frequency Gets default beacon frequency
+     * @return Beacon frequency
+     */
+    uint32_t get_default_beacon_frequency();
+
+    /**
+     * @brief get_beacon_datarate Gets beacon datarate
+     * @return Beacon datarate
+     */
+    uint8_t get_beacon_datarate();
+
+    /**
+     * @brief get_default_ping_slot_frequency Gets default ping slot frequency
+     * @return Ping slot frequency
+     */
+    uint32_t get_default_ping_slot_frequency();
+
+    /**
+     * @brief get_default_ping_slot_datarate Gets default ping slot datarate
+     * @return Ping slot datarate
+     */
+    uint8_t get_default_ping_slot_datarate();
+
     /**
      * @brief get_channel_mask Gets the channel mask
      * @param get_default If true the default mask is returned, otherwise the current mask is returned
@@ -526,6 +583,30 @@ public:
      */
     uint32_t get_rx_time_on_air(uint8_t modem, uint16_t pkt_len);
 
+    /**
+     * @brief compute_tx_time_on_air Computes the time on air of an uplink
+     *        without configuring the radio
+     * @param datarate The TX datarate
+     * @param pkt_len The PHY payload length
+     * @return time on air in milliseconds
+     */
+    uint32_t compute_tx_time_on_air(int8_t datarate, uint8_t pkt_len);
+
+    /**
+     * @brief plan_tx Predicts when a burst of uplinks can be sent
+     *
+     * Follows the channel selection of set_next_channel(): every frame goes
+     * to the band available first. If several are, it goes to the least
+     * restricted one with lora.duty-cycle-channel-preference, otherwise to the
+     * one with the most channels, the most likely random pick.
+     *
+     * @param params The parameters of the burst
+     * @param plan   The predicted schedule
+     * @return LORAWAN_STATUS_OK, or LORAWAN_STATUS_NO_CHANNEL_FOUND if no
+     *         enabled channel supports the datarate
+     */
+    lorawan_status_t plan_tx(const tx_plan_params_t *params, lorawan_tx_plan_t *plan);
+
 public: //Verifiers
 
     /**
@@ -660,6 +741,19 @@ protected:
                                   const uint16_t *mask, uint8_t *enabledChannels,
                                   uint8_t *delayTx);
 
+    /**
+     * Keeps the channels of the bands with the lowest duty cycle restriction
+     * and returns their number.
+     */
+    uint8_t keep_least_restricted_channels(uint8_t *channel_indices, uint8_t count);
+
+    /**
+     * Tie-break of plan_tx() between two bands available at the same time,
+     * matching set_next_channel(). Returns true if band is the better pick.
+     */
+    bool prefer_band(bool dc_enabled, uint8_t band, uint8_t other,
+                     const uint8_t *band_channels);
+
     bool is_datarate_supported(const int8_t datarate) const;
 
 private:
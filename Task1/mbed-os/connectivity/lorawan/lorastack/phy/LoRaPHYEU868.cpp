@@ -178,6 +178,26 @@
  */
 #define EU868_RX_WND_2_DR          DR_0
 
+/*!
+ * Class B beacon channel frequency definition.
+ */
+#define EU868_BEACON_FREQ         869525000
+
+/*!
+ * Class B beacon datarate definition.
+ */
+#define EU868_BEACON_DR            DR_3
+
+/*!
+ * Class B default ping slot channel frequency definition.
+ */
+#define EU868_PING_SLOT_FREQ      869525000
+
+/*!
+ * Class B default ping slot datarate definition.
+ */
+#define EU868_PING_SLOT_DR         DR_3
+
 /*!
  * Band 0 definition
  * { DutyCycle, TxMaxPower, LastJoinTxDoneTime, LastTxDoneTime, TimeOff }
@@ -344,6 +364,11 @@ LoRaPHYEU868::LoRaPHYEU868()
     phy_params.ack_timeout_rnd = EU868_ACK_TIMEOUT_RND;
     phy_params.rx_window2_datarate = EU868_RX_WND_2_DR;
     phy_params.rx_window2_frequency = EU868_RX_WND_2_FREQ;
+    phy_params.class_b_supported = true;
+    phy_params.beacon_datarate = EU868_BEACON_DR;
+    phy_params.beacon_frequency = EU868_BEACON_FREQ;
+    phy_params.ping_slot_datarate = EU868_PING_SLOT_DR;
+    phy_params.ping_slot_frequency = EU868_PING_SLOT_FREQ;
 }
 
 LoRaPHYEU868::~LoRaPHYEU868()
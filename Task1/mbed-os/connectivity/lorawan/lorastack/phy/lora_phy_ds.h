@@ -450,6 +450,41 @@ typedef struct channel_selection_params_s {
     bool dc_enabled;
 } channel_selection_params_t;
 
+/**
+ * The parameter structure for the TX planner.
+ */
+typedef struct tx_plan_params_s {
+    /**
+     * The number of frames to plan.
+     */
+    uint8_t nb_frames;
+    /**
+     * The PHY payload size of each frame, MAC header and MIC included.
+     */
+    uint8_t pkt_len;
+    /**
+     * The TX datarate.
+     */
+    int8_t datarate;
+    /**
+     * Set to true, if the duty cycle is enabled, otherwise false.
+     */
+    bool dc_enabled;
+    /**
+     * The aggregated duty cycle, 1 if not restricted.
+     */
+    uint16_t aggregated_duty_cycle;
+    /**
+     * The time before the aggregated time-off of the last TX elapses.
+     */
+    lorawan_time_t aggregated_delay;
+    /**
+     * The minimum time between the end of a TX and the next TX, covering
+     * the receive windows.
+     */
+    uint32_t frame_gap;
+} tx_plan_params_t;
+
 /*!
  * The parameter structure for the function RegionContinuousWave.
  */
@@ -547,6 +582,15 @@ typedef struct {
     uint8_t rx_window2_datarate;
     uint32_t rx_window2_frequency;
 
+    /*!
+     * Class B: beacon and default ping slot channel.
+     */
+    bool class_b_supported;
+    uint8_t beacon_datarate;
+    uint32_t beacon_frequency;
+    uint8_t ping_slot_datarate;
+    uint32_t ping_slot_frequency;
+
     loraphy_table_t bands;
     loraphy_table_t bandwidths;
     loraphy_table_t datarates;
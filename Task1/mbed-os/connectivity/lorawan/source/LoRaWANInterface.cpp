@@ -137,6 +137,25 @@ int16_t LoRaWANInterface::send(uint8_t port, const uint8_t *data, uint16_t lengt
     return _lw_stack.handle_tx(port, data, length, flags);
 }
 
+int16_t LoRaWANInterface::queue_send(uint8_t port, const uint8_t *data, uint16_t length, int flags,
+                                     const lorawan_uplink_options_t &options)
+{
+    Lock lock(*this);
+    return _lw_stack.handle_queued_tx(port, data, length, flags, options);
+}
+
+lorawan_status_t LoRaWANInterface::get_uplink_queue_stats(lorawan_uplink_queue_stats_t &stats)
+{
+    Lock lock(*this);
+    return _lw_stack.acquire_uplink_queue_stats(stats);
+}
+
+lorawan_status_t LoRaWANInterface::get_tx_plan(uint8_t nb_frames, uint8_t size, lorawan_tx_plan_t &plan)
+{
+    Lock lock(*this);
+    return _lw_stack.acquire_tx_plan(nb_frames, size, plan);
+}
+
 lorawan_status_t LoRaWANInterface::cancel_sending(void)
 {
     Lock lock(*this);
@@ -184,3 +203,15 @@ lorawan_status_t LoRaWANInterface::set_device_class(const device_class_t device_
     Lock lock(*this);
     return _lw_stack.set_device_class(device_class);
 }
+
+lorawan_status_t LoRaWANInterface::get_class_b_status(lorawan_class_b_status_t &status)
+{
+    Lock lock(*this);
+    return _lw_stack.acquire_class_b_status(status);
+}
+
+lorawan_status_t LoRaWANInterface::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    Lock lock(*this);
+    return _lw_stack.set_ping_slot_periodicity(periodicity);
+}
@@ -73,7 +73,9 @@ LoRaWANStack::LoRaWANStack()
       _app_port(INVALID_PORT),
       _link_check_requested(false),
       _automatic_uplink_ongoing(false),
-      _queue(NULL)
+      _queue(NULL),
+      _uplink_queue(),
+      _uplink_dispatch_pending(false)
 {
     _tx_metadata.stale = true;
     _rx_metadata.stale = true;
@@ -279,6 +281,8 @@ lorawan_status_t LoRaWANStack::stop_sending(void)
         _ctrl_flags &= ~TX_DONE_FLAG;
         _loramac.set_tx_ongoing(false);
         _device_current_state = DEVICE_STATE_IDLE;
+        complete_queued_uplink(false);
+        schedule_queued_uplink();
         return LORAWAN_STATUS_OK;
     }
 
@@ -347,6 +351,73 @@ int16_t LoRaWANStack::handle_tx(const uint8_t port, const uint8_t *data,
     return (status == LORAWAN_STATUS_OK) ? len : (int16_t) status;
 }
 
+int16_t LoRaWANStack::handle_queued_tx(const uint8_t port, const uint8_t *data,
+                                       uint16_t length, uint8_t flags,
+                                       const lorawan_uplink_options_t &options)
+{
+    if (_device_current_state == DEVICE_STATE_NOT_INITIALIZED) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    if (!data) {
+        return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    if (!_lw_session.active) {
+        return LORAWAN_STATUS_NO_ACTIVE_SESSIONS;
+    }
+
+    if (!is_port_valid(port)) {
+        tr_error("Illegal application port definition.");
+        return LORAWAN_STATUS_PORT_INVALID;
+    }
+
+    switch (flags & MSG_FLAG_MASK) {
+        case MSG_UNCONFIRMED_FLAG:
+        case MSG_CONFIRMED_FLAG:
+        case MSG_PROPRIETARY_FLAG:
+            break;
+
+        default:
+            tr_error("Invalid send flags");
+            return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    lorawan_status_t status = _uplink_queue.push(port, data, length, flags, options,
+                                                 _loramac.get_current_time());
+    if (status != LORAWAN_STATUS_OK) {
+        return status;
+    }
+
+    schedule_queued_uplink();
+
+    return length;
+}
+
+lorawan_status_t LoRaWANStack::acquire_uplink_queue_stats(lorawan_uplink_queue_stats_t &stats)
+{
+    if (_device_current_state == DEVICE_STATE_NOT_INITIALIZED) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    stats = _uplink_queue.get_stats();
+    return LORAWAN_STATUS_OK;
+}
+
+lorawan_status_t LoRaWANStack::acquire_tx_plan(uint8_t nb_frames, uint8_t size,
+                                              lorawan_tx_plan_t &plan)
+{
+    if (_device_current_state == DEVICE_STATE_NOT_INITIALIZED) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    if (!_lw_session.active) {
+        return LORAWAN_STATUS_NO_ACTIVE_SESSIONS;
+    }
+
+    return _loramac.get_tx_plan(nb_frames, size, plan);
+}
+
 int16_t LoRaWANStack::handle_rx(uint8_t *data, uint16_t length, uint8_t &port, int &flags, bool validate_params)
 {
     if (_device_current_state == DEVICE_STATE_NOT_INITIALIZED) {
@@ -451,13 +522,46 @@ lorawan_status_t LoRaWANStack::set_device_class(const device_class_t &device_cla
     }
 
     if (device_class == CLASS_B) {
-        return LORAWAN_STATUS_UNSUPPORTED;
+        if (!_loramac.is_class_b_supported()) {
+            return LORAWAN_STATUS_UNSUPPORTED;
+        }
+
+        if (!_loramac.nwk_joined()) {
+            return LORAWAN_STATUS_NO_ACTIVE_SESSIONS;
+        }
     }
+
     _loramac.set_device_class(device_class,
-                              mbed::callback(this, &LoRaWANStack::post_process_tx_no_reception));
+                              mbed::callback(this, &LoRaWANStack::post_process_tx_no_reception),
+                              mbed::callback(this, &LoRaWANStack::send_event_to_application));
+
+    if (device_class == CLASS_B) {
+        // BeaconTimingReq and PingSlotInfoReq go out with the next uplink
+        request_uplink(0);
+    }
+
     return LORAWAN_STATUS_OK;
 }
 
+lorawan_status_t LoRaWANStack::acquire_class_b_status(lorawan_class_b_status_t &status)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    _loramac.get_class_b_status(status);
+    return LORAWAN_STATUS_OK;
+}
+
+lorawan_status_t LoRaWANStack::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    return _loramac.set_ping_slot_periodicity(periodicity);
+}
+
 lorawan_status_t  LoRaWANStack::acquire_tx_metadata(lorawan_tx_metadata &tx_metadata)
 {
     if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
@@ -678,6 +782,13 @@ void LoRaWANStack::handle_scheduling_failure(void)
 void LoRaWANStack::process_reception(const uint8_t *const payload, uint16_t size,
                                      int16_t rssi, int8_t snr)
 {
+    const rx_slot_t slot = _loramac.get_current_slot();
+
+    if (slot == RX_SLOT_WIN_BEACON || slot == RX_SLOT_WIN_PING_SLOT) {
+        process_class_b_reception(slot, payload, size, rssi, snr);
+        return;
+    }
+
     _device_current_state = DEVICE_STATE_RECEIVING;
 
     _ctrl_flags &= ~MSG_RECVD_FLAG;
@@ -729,6 +840,27 @@ void LoRaWANStack::process_reception(const uint8_t *const payload, uint16_t size
     core_util_atomic_flag_clear(&_rx_payload_in_use);
 }
 
+void LoRaWANStack::process_class_b_reception(rx_slot_t slot, const uint8_t *const payload,
+                                             uint16_t size, int16_t rssi, int8_t snr)
+{
+    // Beacons and ping slots come outside of any uplink cycle, the device
+    // state is left alone
+    _loramac.on_radio_rx_done(payload, size, rssi, snr);
+
+    if (slot == RX_SLOT_WIN_PING_SLOT && _loramac.get_mcps_indication()->pending) {
+        make_rx_metadata_available();
+        _loramac.post_process_mcps_ind();
+        mcps_indication_handler();
+    }
+
+    if (_loramac.get_mlme_indication()->pending && !_automatic_uplink_ongoing) {
+        _loramac.post_process_mlme_ind();
+        mlme_indication_handler();
+    }
+
+    core_util_atomic_flag_clear(&_rx_payload_in_use);
+}
+
 void LoRaWANStack::process_reception_timeout(bool is_timeout)
 {
     rx_slot_t slot = _loramac.get_current_slot();
@@ -845,6 +977,64 @@ void LoRaWANStack::send_automatic_uplink_message(const uint8_t port)
     }
 }
 
+void LoRaWANStack::schedule_queued_uplink(void)
+{
+    if (_uplink_dispatch_pending || _uplink_queue.empty()) {
+        return;
+    }
+
+    const int ret = _queue->call(this, &LoRaWANStack::send_queued_uplink);
+    MBED_ASSERT(ret != 0);
+    (void)ret;
+    _uplink_dispatch_pending = true;
+}
+
+void LoRaWANStack::send_queued_uplink(void)
+{
+    uint8_t port;
+    uint8_t flags;
+
+    _uplink_dispatch_pending = false;
+
+    // resumed from the status check once the ongoing transmission is over
+    if (!_lw_session.active || _loramac.tx_ongoing()
+            || _uplink_queue.frame_in_flight()) {
+        return;
+    }
+
+    _uplink_queue.expire(_loramac.get_current_time());
+
+    const int16_t length = _uplink_queue.build_frame(_uplink_frame,
+                                                     _loramac.get_max_tx_size(),
+                                                     port, flags);
+    if (length < 0) {
+        return;
+    }
+
+    const int16_t ret = handle_tx(port, _uplink_frame, length, flags);
+    if (ret == LORAWAN_STATUS_WOULD_BLOCK || ret == LORAWAN_STATUS_BUSY) {
+        return;
+    }
+
+    _uplink_queue.commit_frame(_loramac.get_current_time());
+
+    if (ret < 0) {
+        tr_error("Failed to send queued uplink, error code = %d", ret);
+        complete_queued_uplink(false);
+        schedule_queued_uplink();
+    }
+}
+
+void LoRaWANStack::complete_queued_uplink(bool success)
+{
+    if (!_uplink_queue.frame_in_flight()) {
+        return;
+    }
+
+    _uplink_queue.complete_frame(success, _loramac.get_current_time(),
+                                 _loramac.get_mcps_confirmation()->tx_toa);
+}
+
 int LoRaWANStack::convert_to_msg_flag(const mcps_type_t type)
 {
     int msg_flag = MSG_UNCONFIRMED_FLAG;
@@ -909,22 +1099,26 @@ void LoRaWANStack::mlme_indication_handler()
 {
     if (_loramac.get_mlme_indication()->indication_type == MLME_SCHEDULE_UPLINK) {
         // The MAC signals that we shall provide an uplink as soon as possible
-#if MBED_CONF_LORA_AUTOMATIC_UPLINK_MESSAGE
-        _automatic_uplink_ongoing = true;
-        tr_debug("mlme indication: sending empty uplink to port 0 to acknowledge MAC commands...");
-        const uint8_t port = 0;
-        const int ret = _queue->call(this, &LoRaWANStack::send_automatic_uplink_message, port);
-        MBED_ASSERT(ret != 0);
-        (void)ret;
-#else
-        send_event_to_application(UPLINK_REQUIRED);
-#endif
+        tr_debug("mlme indication: uplink required to acknowledge MAC commands...");
+        request_uplink(0);
         return;
     }
 
     tr_error("Unknown MLME Indication type.");
 }
 
+void LoRaWANStack::request_uplink(const uint8_t port)
+{
+#if MBED_CONF_LORA_AUTOMATIC_UPLINK_MESSAGE
+    _automatic_uplink_ongoing = true;
+    const int ret = _queue->call(this, &LoRaWANStack::send_automatic_uplink_message, port);
+    MBED_ASSERT(ret != 0);
+    (void)ret;
+#else
+    send_event_to_application(UPLINK_REQUIRED);
+#endif
+}
+
 void LoRaWANStack::mlme_confirm_handler()
 {
     if (_loramac.get_mlme_confirmation()->req_type == MLME_LINK_CHECK) {
@@ -1038,7 +1232,7 @@ void LoRaWANStack::mcps_indication_handler()
      * that we could retry a certain number of times if the uplink
      * failed for some reason
      * or
-     * Class C and node received a confirmed message so we need to
+     * Class B or C and node received a confirmed message so we need to
      * send an empty packet to acknowledge the message.
      * This scenario is unspecified by LoRaWAN 1.0.2 specification,
      * but version 1.1.0 says that network SHALL not send any new
@@ -1046,7 +1240,7 @@ void LoRaWANStack::mcps_indication_handler()
      */
     if ((_loramac.get_device_class() != CLASS_C
             && mcps_indication->fpending_status)
-            || (_loramac.get_device_class() == CLASS_C
+            || (_loramac.get_device_class() != CLASS_A
                 && mcps_indication->type == MCPS_CONFIRMED)) {
 #if (MBED_CONF_LORA_AUTOMATIC_UPLINK_MESSAGE)
         // Do not queue an automatic uplink of there is one already outgoing
@@ -1108,6 +1302,7 @@ void LoRaWANStack::process_shutdown_state(lorawan_status_t &op_status)
      */
     drop_channel_list();
     _loramac.disconnect();
+    _uplink_queue.clear();
     _lw_session.active = false;
     _device_current_state = DEVICE_STATE_SHUTDOWN;
     op_status = LORAWAN_STATUS_DEVICE_OFF;
@@ -1130,6 +1325,8 @@ void LoRaWANStack::process_status_check_state()
         _loramac.set_tx_ongoing(false);
         _loramac.reset_ongoing_tx();
         mcps_confirm_handler();
+        complete_queued_uplink(_loramac.get_mcps_confirmation()->status
+                               == LORAMAC_EVENT_INFO_STATUS_OK);
 
     } else if (_device_current_state == DEVICE_STATE_RECEIVING) {
 
@@ -1145,6 +1342,8 @@ void LoRaWANStack::process_status_check_state()
             } else {
                 mcps_confirm_handler();
             }
+            complete_queued_uplink(_loramac.get_mcps_confirmation()->status
+                                   == LORAMAC_EVENT_INFO_STATUS_OK);
         }
 
         // handle any received data and send event accordingly
@@ -1153,6 +1352,8 @@ void LoRaWANStack::process_status_check_state()
             mcps_indication_handler();
         }
     }
+
+    schedule_queued_uplink();
 }
 
 void LoRaWANStack::process_scheduling_state(lorawan_status_t &op_status)
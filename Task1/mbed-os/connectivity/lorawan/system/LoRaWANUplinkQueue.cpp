@@ -0,0 +1,272 @@
+/**
+ * @file
+ *
+ * @brief      Prioritised queue of application uplink messages
+ *
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "LoRaWANUplinkQueue.h"
+
+LoRaWANUplinkQueue::LoRaWANUplinkQueue()
+    : _count(0),
+      _buffer_used(0),
+      _sequence(0),
+      _in_flight_count(0),
+      _in_flight_max_age(0),
+      _in_flight_age_sum(0),
+      _in_flight_committed_at(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+lorawan_status_t LoRaWANUplinkQueue::push(uint8_t port, const uint8_t *data,
+                                          uint16_t length, uint8_t flags,
+                                          const lorawan_uplink_options_t &options,
+                                          lorawan_time_t now)
+{
+    if (length > MBED_CONF_LORA_TX_MAX_SIZE
+            || length > MBED_CONF_LORA_UPLINK_QUEUE_BUFFER_SIZE) {
+        return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    entry_t entry;
+    entry.sequence = _sequence;
+    entry.queued_at = now;
+    entry.deadline = now + options.deadline;
+    entry.length = length;
+    entry.port = port;
+    entry.flags = flags;
+    entry.priority = options.priority;
+    entry.has_deadline = options.deadline != 0;
+    entry.aggregate = options.aggregate;
+    entry.selected = false;
+
+    // make room by evicting less urgent messages
+    while (_count == MBED_CONF_LORA_UPLINK_QUEUE_SIZE
+            || _buffer_used + length > MBED_CONF_LORA_UPLINK_QUEUE_BUFFER_SIZE) {
+        const int victim = find_least_urgent();
+        if (victim < 0 || !more_urgent(entry, _entries[victim])) {
+            return LORAWAN_STATUS_WOULD_BLOCK;
+        }
+        remove(victim);
+        _stats.dropped++;
+    }
+
+    entry.offset = _buffer_used;
+    if (length) {
+        memcpy(_buffer + _buffer_used, data, length);
+    }
+    _buffer_used += length;
+
+    _entries[_count++] = entry;
+    _sequence++;
+    _stats.queued++;
+
+    return LORAWAN_STATUS_OK;
+}
+
+void LoRaWANUplinkQueue::expire(lorawan_time_t now)
+{
+    for (int i = _count - 1; i >= 0; i--) {
+        if (_entries[i].has_deadline && (int32_t)(now - _entries[i].deadline) >= 0) {
+            remove(i);
+            _stats.expired++;
+        }
+    }
+}
+
+int16_t LoRaWANUplinkQueue::build_frame(uint8_t *frame, uint8_t max_size,
+                                        uint8_t &port, uint8_t &flags)
+{
+    int head;
+    uint16_t size = 0;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        _entries[i].selected = false;
+    }
+
+    while (true) {
+        head = -1;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (head < 0 || more_urgent(_entries[i], _entries[head])) {
+                head = i;
+            }
+        }
+
+        if (head < 0) {
+            return -1;
+        }
+
+        if (_entries[head].length <= max_size) {
+            break;
+        }
+
+        // cannot be sent at the current data rate
+        remove(head);
+        _stats.dropped++;
+    }
+
+    entry_t &first = _entries[head];
+    port = first.port;
+    flags = first.flags;
+    memcpy(frame, _buffer + first.offset, first.length);
+    size = first.length;
+    first.selected = true;
+
+    if (!first.aggregate) {
+        return size;
+    }
+
+    // pack the most urgent compatible messages which still fit
+    while (true) {
+        int next = -1;
+        for (uint8_t i = 0; i < _count; i++) {
+            const entry_t &entry = _entries[i];
+            if (entry.selected || !entry.aggregate || entry.port != port
+                    || entry.flags != flags || size + entry.length > max_size) {
+                continue;
+            }
+            if (next < 0 || more_urgent(entry, _entries[next])) {
+                next = i;
+            }
+        }
+
+        if (next < 0) {
+            break;
+        }
+
+        memcpy(frame + size, _buffer + _entries[next].offset, _entries[next].length);
+        size += _entries[next].length;
+        _entries[next].selected = true;
+    }
+
+    return size;
+}
+
+void LoRaWANUplinkQueue::commit_frame(lorawan_time_t now)
+{
+    uint8_t committed = 0;
+
+    _in_flight_count = 0;
+    _in_flight_max_age = 0;
+    _in_flight_age_sum = 0;
+    _in_flight_committed_at = now;
+
+    for (int i = _count - 1; i >= 0; i--) {
+        if (!_entries[i].selected) {
+            continue;
+        }
+
+        const uint32_t age = now - _entries[i].queued_at;
+        _in_flight_age_sum += age;
+        if (age > _in_flight_max_age) {
+            _in_flight_max_age = age;
+        }
+        committed++;
+        remove(i);
+    }
+
+    if (committed) {
+        _in_flight_count = committed;
+        _stats.frames++;
+        _stats.aggregated += committed - 1;
+    }
+}
+
+void LoRaWANUplinkQueue::complete_frame(bool success, lorawan_time_t now, uint32_t airtime)
+{
+    if (!_in_flight_count) {
+        return;
+    }
+
+    _stats.airtime += airtime;
+
+    if (success) {
+        const uint32_t elapsed = now - _in_flight_committed_at;
+        _stats.sent += _in_flight_count;
+        _stats.latency_total += _in_flight_age_sum + _in_flight_count * elapsed;
+        if (_in_flight_max_age + elapsed > _stats.latency_max) {
+            _stats.latency_max = _in_flight_max_age + elapsed;
+        }
+    } else {
+        _stats.dropped += _in_flight_count;
+    }
+
+    _in_flight_count = 0;
+}
+
+void LoRaWANUplinkQueue::clear()
+{
+    _stats.dropped += _count + _in_flight_count;
+    _count = 0;
+    _buffer_used = 0;
+    _in_flight_count = 0;
+}
+
+void LoRaWANUplinkQueue::reset_stats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool LoRaWANUplinkQueue::more_urgent(const entry_t &lhs, const entry_t &rhs)
+{
+    if (lhs.priority != rhs.priority) {
+        return lhs.priority < rhs.priority;
+    }
+
+    if (lhs.has_deadline != rhs.has_deadline) {
+        return lhs.has_deadline;
+    }
+
+    if (lhs.has_deadline && lhs.deadline != rhs.deadline) {
+        return (int32_t)(lhs.deadline - rhs.deadline) < 0;
+    }
+
+    return (int32_t)(lhs.sequence - rhs.sequence) < 0;
+}
+
+int LoRaWANUplinkQueue::find_least_urgent() const
+{
+    int least = -1;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (least < 0 || more_urgent(_entries[least], _entries[i])) {
+            least = i;
+        }
+    }
+
+    return least;
+}
+
+void LoRaWANUplinkQueue::remove(uint8_t index)
+{
+    const uint16_t offset = _entries[index].offset;
+    const uint16_t length = _entries[index].length;
+
+    // payloads are stored in queuing order, compact the buffer
+    memmove(_buffer + offset, _buffer + offset + length,
+            _buffer_used - offset - length);
+    _buffer_used -= length;
+
+    for (uint8_t i = index + 1; i < _count; i++) {
+        _entries[i - 1] = _entries[i];
+        _entries[i - 1].offset -= length;
+    }
+    _count--;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file
+ *
+ * @brief      Prioritised queue of application uplink messages
+ *
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MBED_LORAWAN_SYS_UPLINK_QUEUE_H__
+#define MBED_LORAWAN_SYS_UPLINK_QUEUE_H__
+
+#include <stdint.h>
+
+#include "lorawan_data_structures.h"
+
+/**
+ * Maximum number of messages held by the uplink queue.
+ */
+#ifndef MBED_CONF_LORA_UPLINK_QUEUE_SIZE
+#define MBED_CONF_LORA_UPLINK_QUEUE_SIZE            8
+#endif
+
+/**
+ * Size of the buffer shared by the payloads of the queued messages.
+ */
+#ifndef MBED_CONF_LORA_UPLINK_QUEUE_BUFFER_SIZE
+#define MBED_CONF_LORA_UPLINK_QUEUE_BUFFER_SIZE     512
+#endif
+
+/**
+ * Queue of application messages waiting for the MAC layer.
+ *
+ * Messages are taken by priority, then by deadline, then in queuing order.
+ * Small aggregatable messages for the same port are packed in a single frame
+ * up to the payload size allowed by the current data rate.
+ *
+ * Payloads are copied to a buffer of fixed size; the queue never allocates.
+ */
+class LoRaWANUplinkQueue {
+public:
+    LoRaWANUplinkQueue();
+
+    /** Queues a message.
+     *
+     * If the queue is full, the least urgent queued message is evicted if it
+     * is less urgent than the new one.
+     *
+     * @param port      Application port.
+     * @param data      Payload, copied to the queue.
+     * @param length    Size of the payload.
+     * @param flags     Message flags, as given to LoRaWANStack::handle_tx().
+     * @param options   Priority, deadline and aggregation of the message.
+     * @param now       Current time.
+     *
+     * @return          LORAWAN_STATUS_OK on success,
+     *                  LORAWAN_STATUS_PARAMETER_INVALID if the message can never fit,
+     *                  LORAWAN_STATUS_WOULD_BLOCK if the queue is full of
+     *                  messages at least as urgent.
+     */
+    lorawan_status_t push(uint8_t port, const uint8_t *data, uint16_t length,
+                          uint8_t flags, const lorawan_uplink_options_t &options,
+                          lorawan_time_t now);
+
+    /** Drops the messages whose deadline has passed.
+     *
+     * @param now       Current time.
+     */
+    void expire(lorawan_time_t now);
+
+    /** Builds the next frame from the queued messages.
+     *
+     * The messages selected stay queued until commit_frame() is called.
+     * Messages which cannot fit in max_size alone are dropped.
+     *
+     * @param frame     Buffer receiving the payload of the frame.
+     * @param max_size  Largest payload allowed by the current data rate.
+     * @param port      Port of the frame.
+     * @param flags     Flags of the frame.
+     *
+     * @return          Size of the payload, or -1 if the queue is empty.
+     */
+    int16_t build_frame(uint8_t *frame, uint8_t max_size, uint8_t &port, uint8_t &flags);
+
+    /** Removes the messages of the last built frame once the MAC layer
+     * accepted it.
+     *
+     * @param now       Current time.
+     */
+    void commit_frame(lorawan_time_t now);
+
+    /** Accounts the end of the transmission of the committed frame.
+     *
+     * @param success   True if the frame was transmitted (and acknowledged
+     *                  if confirmed).
+     * @param now       Current time.
+     * @param airtime   Time on air of the frame, in ms.
+     */
+    void complete_frame(bool success, lorawan_time_t now, uint32_t airtime);
+
+    /** Drops all the queued messages, and the committed frame if any.
+     */
+    void clear();
+
+    bool empty() const
+    {
+        return _count == 0;
+    }
+
+    uint8_t size() const
+    {
+        return _count;
+    }
+
+    /** Indicates if a committed frame awaits complete_frame().
+     */
+    bool frame_in_flight() const
+    {
+        return _in_flight_count != 0;
+    }
+
+    const lorawan_uplink_queue_stats_t &get_stats() const
+    {
+        return _stats;
+    }
+
+    void reset_stats();
+
+private:
+    struct entry_t {
+        uint32_t sequence;
+        lorawan_time_t queued_at;
+        lorawan_time_t deadline;
+        uint16_t offset;
+        uint16_t length;
+        uint8_t port;
+        uint8_t flags;
+        uint8_t priority;
+        bool has_deadline;
+        bool aggregate;
+        bool selected;
+    };
+
+    /* true if lhs must be sent before rhs */
+    static bool more_urgent(const entry_t &lhs, const entry_t &rhs);
+
+    /* index of the least urgent entry, -1 if the queue is empty */
+    int find_least_urgent() const;
+
+    void remove(uint8_t index);
+
+    entry_t _entries[MBED_CONF_LORA_UPLINK_QUEUE_SIZE];
+    uint8_t _count;
+    uint8_t _buffer[MBED_CONF_LORA_UPLINK_QUEUE_BUFFER_SIZE];
+    uint16_t _buffer_used;
+    uint32_t _sequence;
+
+    /* messages of the committed frame */
+    uint8_t _in_flight_count;
+    uint32_t _in_flight_max_age;
+    uint32_t _in_flight_age_sum;
+    lorawan_time_t _in_flight_committed_at;
+
+    lorawan_uplink_queue_stats_t _stats;
+};
+
+#endif /* MBED_LORAWAN_SYS_UPLINK_QUEUE_H__ */
@@ -67,6 +67,16 @@ typedef uint32_t lorawan_time_t;
  */
 #define LORAMAC_PHY_MAXPAYLOAD                      255
 
+/**
+ * Size of the Class B beacon payload.
+ */
+#define CLASS_B_BEACON_SIZE                         17
+
+/**
+ * Preamble length of the Class B beacon, in symbols.
+ */
+#define CLASS_B_BEACON_PREAMBLE_LENGTH              10
+
 #define LORAWAN_DEFAULT_QOS                         1
 
 /**
@@ -150,7 +160,11 @@ typedef enum {
     /*!
      * LoRaMAC class b ping slot window
      */
-    RX_SLOT_WIN_PING_SLOT
+    RX_SLOT_WIN_PING_SLOT,
+    /*!
+     * LoRaMAC class b beacon window
+     */
+    RX_SLOT_WIN_BEACON
 } rx_slot_t;
 
 /*!
@@ -229,6 +243,15 @@ typedef struct {
      * LoRaMac ADR control status
      */
     bool adr_on;
+
+    /*!
+     * Class B ping slot channel, set by PingSlotChannelReq
+     */
+    rx2_channel_params ping_slot_channel;
+    /*!
+     * Class B beacon frequency, set by BeaconFreqReq
+     */
+    uint32_t beacon_frequency;
 } lora_mac_system_params_t;
 
 /*!
@@ -338,7 +361,23 @@ typedef enum {
     /*!
      * DlChannelAns
      */
-    MOTE_MAC_DL_CHANNEL_ANS          = 0x0A
+    MOTE_MAC_DL_CHANNEL_ANS          = 0x0A,
+    /*!
+     * PingSlotInfoReq
+     */
+    MOTE_MAC_PING_SLOT_INFO_REQ      = 0x10,
+    /*!
+     * PingSlotChannelAns
+     */
+    MOTE_MAC_PING_SLOT_CHANNEL_ANS   = 0x11,
+    /*!
+     * BeaconTimingReq
+     */
+    MOTE_MAC_BEACON_TIMING_REQ       = 0x12,
+    /*!
+     * BeaconFreqAns
+     */
+    MOTE_MAC_BEACON_FREQ_ANS         = 0x13
 } mote_mac_cmds_t;
 
 /*!
@@ -383,6 +422,22 @@ typedef enum {
      * DlChannelReq
      */
     SRV_MAC_DL_CHANNEL_REQ           = 0x0A,
+    /*!
+     * PingSlotInfoAns
+     */
+    SRV_MAC_PING_SLOT_INFO_ANS       = 0x10,
+    /*!
+     * PingSlotChannelReq
+     */
+    SRV_MAC_PING_SLOT_CHANNEL_REQ    = 0x11,
+    /*!
+     * BeaconTimingAns
+     */
+    SRV_MAC_BEACON_TIMING_ANS        = 0x12,
+    /*!
+     * BeaconFreqReq
+     */
+    SRV_MAC_BEACON_FREQ_REQ          = 0x13,
 } server_mac_cmds_t;
 
 /*!
@@ -1127,6 +1182,12 @@ typedef struct {
      */
     timer_event_t ack_timeout_timer;
 
+    /*!
+     * Class B beacon window and ping slot timers
+     */
+    timer_event_t beacon_timer;
+    timer_event_t ping_slot_timer;
+
 } lorawan_timers;
 
 /*!
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "LoRaMacClassB.h"
+
+LoRaMacClassB::LoRaMacClassB()
+    : _state(CLASS_B_OFF),
+      _has_timing(false),
+      _has_reference(false),
+      _drift_known(false),
+      _next_beacon(0),
+      _beacon_time(0),
+      _reference(0),
+      _reference_error(0),
+      _last_beacon(0),
+      _last_beacon_time(0),
+      _period(0),
+      _periodicity(0),
+      _ping_offset(0),
+      _beacons_received(0),
+      _beacons_missed(0),
+      _ping_slots(0)
+{
+}
+
+void LoRaMacClassB::reset()
+{
+}
+
+void LoRaMacClassB::start_acquisition()
+{
+}
+
+class_b_state_t LoRaMacClassB::get_state() const
+{
+    return CLASS_B_OFF;
+}
+
+bool LoRaMacClassB::is_synchronised() const
+{
+    return false;
+}
+
+bool LoRaMacClassB::has_beacon_timing() const
+{
+    return false;
+}
+
+void LoRaMacClassB::set_beacon_timing(lorawan_time_t)
+{
+}
+
+bool LoRaMacClassB::parse_beacon(const uint8_t *, uint16_t, uint32_t &)
+{
+    return false;
+}
+
+void LoRaMacClassB::build_beacon(uint32_t, uint8_t *)
+{
+}
+
+void LoRaMacClassB::beacon_received(lorawan_time_t, uint32_t)
+{
+}
+
+bool LoRaMacClassB::beacon_missed()
+{
+    return false;
+}
+
+lorawan_time_t LoRaMacClassB::get_next_beacon_start() const
+{
+    return 0;
+}
+
+uint32_t LoRaMacClassB::get_window_widening(lorawan_time_t) const
+{
+    return 0;
+}
+
+bool LoRaMacClassB::set_ping_slot_periodicity(uint8_t)
+{
+    return true;
+}
+
+uint8_t LoRaMacClassB::get_ping_slot_periodicity() const
+{
+    return 0;
+}
+
+uint16_t LoRaMacClassB::get_ping_period() const
+{
+    return 1;
+}
+
+uint32_t LoRaMacClassB::get_beacon_time() const
+{
+    return 0;
+}
+
+void LoRaMacClassB::set_ping_offset(uint16_t)
+{
+}
+
+bool LoRaMacClassB::get_next_ping_slot(lorawan_time_t, lorawan_time_t &) const
+{
+    return false;
+}
+
+lorawan_time_t LoRaMacClassB::get_tx_delay(lorawan_time_t, lorawan_time_t) const
+{
+    return 0;
+}
+
+void LoRaMacClassB::ping_slot_opened()
+{
+}
+
+void LoRaMacClassB::get_status(lorawan_class_b_status_t &status, lorawan_time_t) const
+{
+    memset(&status, 0, sizeof(status));
+}
+
+lorawan_time_t LoRaMacClassB::to_local(uint32_t) const
+{
+    return 0;
+}
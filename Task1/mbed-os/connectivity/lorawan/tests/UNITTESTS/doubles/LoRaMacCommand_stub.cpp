@@ -93,6 +93,26 @@ lorawan_status_t LoRaMacCommand::add_link_check_req()
     return LoRaMacCommand_stub::status_value;
 }
 
+lorawan_status_t LoRaMacCommand::add_ping_slot_info_req(uint8_t periodicity)
+{
+    return LoRaMacCommand_stub::status_value;
+}
+
+lorawan_status_t LoRaMacCommand::add_beacon_timing_req()
+{
+    return LoRaMacCommand_stub::status_value;
+}
+
+bool LoRaMacCommand::take_beacon_timing_ans(uint16_t &delay)
+{
+    return false;
+}
+
+bool LoRaMacCommand::take_ping_slot_info_ans()
+{
+    return false;
+}
+
 lorawan_status_t LoRaMacCommand::add_link_adr_ans(uint8_t status)
 {
     return LoRaMacCommand_stub::status_value;
@@ -132,3 +152,13 @@ lorawan_status_t LoRaMacCommand::add_dl_channel_ans(uint8_t status)
 {
     return LoRaMacCommand_stub::status_value;
 }
+
+lorawan_status_t LoRaMacCommand::add_ping_slot_channel_ans(uint8_t status)
+{
+    return LoRaMacCommand_stub::status_value;
+}
+
+lorawan_status_t LoRaMacCommand::add_beacon_freq_ans(uint8_t status)
+{
+    return LoRaMacCommand_stub::status_value;
+}
@@ -102,6 +102,11 @@ rx_slot_t LoRaMac::get_current_slot(void)
     return LoRaMac_stub::slot_value;
 }
 
+bool LoRaMac::is_class_b_supported(void)
+{
+    return LoRaMac_stub::bool_value;
+}
+
 void LoRaMac::handle_join_accept_frame(const uint8_t *payload, uint16_t size)
 {
 }
@@ -323,6 +328,16 @@ int16_t LoRaMac::prepare_ongoing_tx(const uint8_t port,
     return 0;
 }
 
+uint8_t LoRaMac::get_max_tx_size()
+{
+    return LoRaMac_stub::uint8_value;
+}
+
+lorawan_status_t LoRaMac::get_tx_plan(uint8_t nb_frames, uint8_t size, lorawan_tx_plan_t &plan)
+{
+    return LoRaMac_stub::status_value;
+}
+
 lorawan_status_t LoRaMac::send_ongoing_tx()
 {
     return LoRaMac_stub::status_value;
@@ -334,10 +349,20 @@ device_class_t LoRaMac::get_device_class() const
 }
 
 void LoRaMac::set_device_class(const device_class_t &device_class,
-                               mbed::Callback<void(void)>rx2_would_be_closure_handler)
+                               mbed::Callback<void(void)>rx2_would_be_closure_handler,
+                               mbed::Callback<void(lorawan_event_t)>class_b_event_handler)
+{
+}
+
+void LoRaMac::get_class_b_status(lorawan_class_b_status_t &status)
 {
 }
 
+lorawan_status_t LoRaMac::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    return LoRaMac_stub::status_value;
+}
+
 void LoRaMac::setup_link_check_request()
 {
 }
@@ -204,6 +204,17 @@ uint8_t LoRaPHY::enabled_channel_count(uint8_t datarate,
     return LoRaPHY_stub::uint8_value;
 }
 
+uint8_t LoRaPHY::keep_least_restricted_channels(uint8_t *channel_indices, uint8_t count)
+{
+    return count;
+}
+
+bool LoRaPHY::prefer_band(bool dc_enabled, uint8_t band, uint8_t other,
+                          const uint8_t *band_channels)
+{
+    return false;
+}
+
 bool LoRaPHY::is_datarate_supported(const int8_t datarate) const
 {
     return LoRaPHY_stub::bool_table[LoRaPHY_stub::bool_counter++];
@@ -268,6 +279,31 @@ uint8_t LoRaPHY::get_default_rx2_datarate()
     return phy_params.rx_window2_datarate;
 }
 
+bool LoRaPHY::is_class_b_supported()
+{
+    return LoRaPHY_stub::bool_table[LoRaPHY_stub::bool_counter++];
+}
+
+uint32_t LoRaPHY::get_default_beacon_frequency()
+{
+    return LoRaPHY_stub::uint32_value;
+}
+
+uint8_t LoRaPHY::get_beacon_datarate()
+{
+    return LoRaPHY_stub::uint8_value;
+}
+
+uint32_t LoRaPHY::get_default_ping_slot_frequency()
+{
+    return LoRaPHY_stub::uint32_value;
+}
+
+uint8_t LoRaPHY::get_default_ping_slot_datarate()
+{
+    return LoRaPHY_stub::uint8_value;
+}
+
 uint16_t *LoRaPHY::get_channel_mask(bool get_default)
 {
     return &LoRaPHY_stub::uint16_value;
@@ -358,6 +394,16 @@ uint8_t LoRaPHY::accept_rx_param_setup_req(rx_param_setup_req_t *params)
     return LoRaPHY_stub::uint8_value;
 }
 
+uint8_t LoRaPHY::accept_ping_slot_channel_req(uint32_t frequency, uint8_t datarate)
+{
+    return LoRaPHY_stub::uint8_value;
+}
+
+bool LoRaPHY::accept_beacon_freq_req(uint32_t frequency)
+{
+    return LoRaPHY_stub::bool_table[LoRaPHY_stub::bool_counter++];
+}
+
 bool LoRaPHY::accept_tx_param_setup_req(uint8_t ul_dwell_time, uint8_t dl_dwell_time)
 {
     return LoRaPHY_stub::bool_table[LoRaPHY_stub::bool_counter++];
@@ -421,3 +467,13 @@ uint32_t LoRaPHY::get_rx_time_on_air(uint8_t modem, uint16_t pkt_len)
     return LoRaPHY_stub::uint32_value;
 }
 
+uint32_t LoRaPHY::compute_tx_time_on_air(int8_t datarate, uint8_t pkt_len)
+{
+    return LoRaPHY_stub::uint32_value;
+}
+
+lorawan_status_t LoRaPHY::plan_tx(const tx_plan_params_t *params, lorawan_tx_plan_t *plan)
+{
+    return LoRaPHY_stub::lorawan_status_value;
+}
+
@@ -114,6 +114,24 @@ int16_t LoRaWANStack::handle_tx(const uint8_t port, const uint8_t *data,
     return 0;
 }
 
+int16_t LoRaWANStack::handle_queued_tx(const uint8_t port, const uint8_t *data,
+                                       uint16_t length, uint8_t flags,
+                                       const lorawan_uplink_options_t &options)
+{
+    return 0;
+}
+
+lorawan_status_t LoRaWANStack::acquire_uplink_queue_stats(lorawan_uplink_queue_stats_t &stats)
+{
+    return LORAWAN_STATUS_OK;
+}
+
+lorawan_status_t LoRaWANStack::acquire_tx_plan(uint8_t nb_frames, uint8_t size,
+                                              lorawan_tx_plan_t &plan)
+{
+    return LORAWAN_STATUS_OK;
+}
+
 int16_t LoRaWANStack::handle_rx(uint8_t *data, uint16_t length, uint8_t &port, int &flags, bool validate_params)
 {
     return 0;
@@ -138,6 +156,16 @@ lorawan_status_t LoRaWANStack::set_device_class(const device_class_t &device_cla
     return LORAWAN_STATUS_OK;
 }
 
+lorawan_status_t LoRaWANStack::acquire_class_b_status(lorawan_class_b_status_t &status)
+{
+    return LORAWAN_STATUS_OK;
+}
+
+lorawan_status_t LoRaWANStack::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    return LORAWAN_STATUS_OK;
+}
+
 lorawan_status_t  LoRaWANStack::acquire_tx_metadata(lorawan_tx_metadata &tx_metadata)
 {
     return LORAWAN_STATUS_OK;
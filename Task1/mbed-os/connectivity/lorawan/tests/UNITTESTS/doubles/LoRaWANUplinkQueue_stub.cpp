@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "LoRaWANUplinkQueue.h"
+
+LoRaWANUplinkQueue::LoRaWANUplinkQueue()
+    : _count(0),
+      _buffer_used(0),
+      _sequence(0),
+      _in_flight_count(0),
+      _in_flight_max_age(0),
+      _in_flight_age_sum(0),
+      _in_flight_committed_at(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+lorawan_status_t LoRaWANUplinkQueue::push(uint8_t, const uint8_t *, uint16_t, uint8_t,
+                                          const lorawan_uplink_options_t &, lorawan_time_t)
+{
+    return LORAWAN_STATUS_OK;
+}
+
+void LoRaWANUplinkQueue::expire(lorawan_time_t)
+{
+}
+
+int16_t LoRaWANUplinkQueue::build_frame(uint8_t *, uint8_t, uint8_t &, uint8_t &)
+{
+    return -1;
+}
+
+void LoRaWANUplinkQueue::commit_frame(lorawan_time_t)
+{
+}
+
+void LoRaWANUplinkQueue::complete_frame(bool, lorawan_time_t, uint32_t)
+{
+}
+
+void LoRaWANUplinkQueue::clear()
+{
+}
+
+void LoRaWANUplinkQueue::reset_stats()
+{
+}
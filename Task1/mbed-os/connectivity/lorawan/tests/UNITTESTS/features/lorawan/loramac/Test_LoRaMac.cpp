@@ -200,6 +200,14 @@ TEST_F(Test_LoRaMac, prepare_ongoing_tx)
     object->prepare_ongoing_tx(1, buf, 16, 1, 0);
 }
 
+TEST_F(Test_LoRaMac, get_tx_plan)
+{
+    my_phy phy;
+    object->bind_phy(phy);
+    lorawan_tx_plan_t plan;
+    EXPECT_EQ(LORAWAN_STATUS_NO_NETWORK_JOINED, object->get_tx_plan(1, 16, plan));
+}
+
 TEST_F(Test_LoRaMac, send_ongoing_tx)
 {
     object->send_ongoing_tx();
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+#include "LoRaMacClassB.h"
+
+class Test_LoRaMacClassB : public testing::Test {
+protected:
+    LoRaMacClassB *object;
+
+    virtual void SetUp()
+    {
+        object = new LoRaMacClassB();
+    }
+
+    virtual void TearDown()
+    {
+        delete object;
+    }
+
+    /* locks on beacons received every period ms of the local clock */
+    void lock(lorawan_time_t start, uint32_t period, uint8_t beacons, uint32_t time = 1000000)
+    {
+        object->start_acquisition();
+        object->set_beacon_timing(start);
+        for (uint8_t i = 0; i < beacons; i++) {
+            object->beacon_received(start + i * period, time + i * 128);
+        }
+    }
+};
+
+TEST_F(Test_LoRaMacClassB, constructor)
+{
+    EXPECT_TRUE(object);
+    EXPECT_EQ(CLASS_B_OFF, object->get_state());
+    EXPECT_FALSE(object->is_synchronised());
+    EXPECT_FALSE(object->has_beacon_timing());
+    EXPECT_EQ(MBED_CONF_LORA_PING_SLOT_PERIODICITY, object->get_ping_slot_periodicity());
+}
+
+TEST_F(Test_LoRaMacClassB, beacon_format)
+{
+    uint8_t beacon[CLASS_B_BEACON_SIZE];
+    uint32_t time = 0;
+
+    LoRaMacClassB::build_beacon(0x12345678, beacon);
+    EXPECT_EQ(0x78, beacon[2]);
+    EXPECT_EQ(0x12, beacon[5]);
+    EXPECT_TRUE(LoRaMacClassB::parse_beacon(beacon, sizeof(beacon), time));
+    EXPECT_EQ(0x12345678u, time);
+
+    EXPECT_FALSE(LoRaMacClassB::parse_beacon(NULL, sizeof(beacon), time));
+    EXPECT_FALSE(LoRaMacClassB::parse_beacon(beacon, sizeof(beacon) - 1, time));
+
+    // corrupted time field
+    beacon[3] ^= 0x01;
+    EXPECT_FALSE(LoRaMacClassB::parse_beacon(beacon, sizeof(beacon), time));
+}
+
+TEST_F(Test_LoRaMacClassB, acquisition)
+{
+    object->start_acquisition();
+    EXPECT_EQ(CLASS_B_ACQUIRING, object->get_state());
+    EXPECT_FALSE(object->has_beacon_timing());
+
+    // a beacon cannot be missed without timing
+    EXPECT_FALSE(object->beacon_missed());
+    EXPECT_EQ(CLASS_B_OFF, object->get_state());
+
+    object->start_acquisition();
+    object->set_beacon_timing(10000);
+    EXPECT_TRUE(object->has_beacon_timing());
+    EXPECT_EQ(10000u, object->get_next_beacon_start());
+    EXPECT_EQ(uint32_t(CLASS_B_BEACON_TIMING_ERROR), object->get_window_widening(10000));
+
+    EXPECT_TRUE(object->beacon_missed());
+    EXPECT_EQ(10000u + CLASS_B_BEACON_INTERVAL, object->get_next_beacon_start());
+
+    object->beacon_received(10000 + CLASS_B_BEACON_INTERVAL, 1000000);
+    EXPECT_EQ(CLASS_B_LOCKED, object->get_state());
+    EXPECT_TRUE(object->is_synchronised());
+    EXPECT_EQ(1000000u, object->get_beacon_time());
+    EXPECT_EQ(10000u + 2 * CLASS_B_BEACON_INTERVAL, object->get_next_beacon_start());
+
+    // timing from a BeaconTimingAns is ignored once locked
+    object->set_beacon_timing(5);
+    EXPECT_EQ(10000u + 2 * CLASS_B_BEACON_INTERVAL, object->get_next_beacon_start());
+}
+
+TEST_F(Test_LoRaMacClassB, acquisition_timeout)
+{
+    object->start_acquisition();
+    object->set_beacon_timing(10000);
+
+    for (uint8_t i = 1; i < MBED_CONF_LORA_CLASS_B_ACQUISITION_PERIODS; i++) {
+        EXPECT_TRUE(object->beacon_missed());
+    }
+    EXPECT_FALSE(object->beacon_missed());
+    EXPECT_EQ(CLASS_B_OFF, object->get_state());
+}
+
+TEST_F(Test_LoRaMacClassB, drift)
+{
+    // local clock 100 ppm slow: the beacon period lasts 127987.2 ms
+    lock(0, 127987, 2);
+    EXPECT_EQ(2 * 127987u, object->get_next_beacon_start());
+
+    lorawan_class_b_status_t status;
+    object->get_status(status, 2 * 127987);
+    EXPECT_EQ(-101, status.drift);
+    EXPECT_EQ(2u, status.beacons_received);
+
+    // the drift is compensated, only the residual drift widens the windows
+    EXPECT_EQ(2u + 128000u * CLASS_B_RESIDUAL_DRIFT / 1000000,
+              object->get_window_widening(2 * 127987));
+
+    // measurements out of the bounds are ignored
+    object->beacon_received(2 * 127987 + 1000, 1000000 + 2 * 128);
+    object->get_status(status, 0);
+    EXPECT_EQ(-101, status.drift);
+}
+
+TEST_F(Test_LoRaMacClassB, beaconless)
+{
+    lock(0, CLASS_B_BEACON_INTERVAL, 1, 2000);
+
+    uint32_t missed = 0;
+    while (object->beacon_missed()) {
+        missed++;
+        EXPECT_EQ(CLASS_B_BEACONLESS, object->get_state());
+        EXPECT_TRUE(object->is_synchronised());
+        EXPECT_EQ(2000u + missed * 128, object->get_beacon_time());
+    }
+
+    // 2 hours without beacon
+    EXPECT_EQ(CLASS_B_BEACON_LESS_PERIOD / CLASS_B_BEACON_INTERVAL - 1, missed);
+    EXPECT_EQ(CLASS_B_OFF, object->get_state());
+    EXPECT_FALSE(object->has_beacon_timing());
+
+    // widening grows with the time since the last beacon
+    lock(0, CLASS_B_BEACON_INTERVAL, 1, 2000);
+    EXPECT_TRUE(object->beacon_missed());
+    EXPECT_EQ(2u + 2 * 128000u * MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY / 1000000,
+              object->get_window_widening(object->get_next_beacon_start()));
+
+    object->beacon_received(object->get_next_beacon_start(), 2000 + 2 * 128);
+    EXPECT_EQ(CLASS_B_LOCKED, object->get_state());
+}
+
+TEST_F(Test_LoRaMacClassB, ping_slots)
+{
+    EXPECT_FALSE(object->set_ping_slot_periodicity(8));
+    EXPECT_TRUE(object->set_ping_slot_periodicity(5));
+    EXPECT_EQ(1024u, object->get_ping_period());
+
+    lorawan_time_t slot = 0;
+    EXPECT_FALSE(object->get_next_ping_slot(0, slot));
+
+    lock(1000, CLASS_B_BEACON_INTERVAL, 1);
+    object->set_ping_offset(100 + 1024);
+
+    // 4 slots every 32 s from the offset
+    lorawan_time_t from = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(object->get_next_ping_slot(from, slot));
+        EXPECT_EQ(1000u + CLASS_B_BEACON_RESERVED + (100 + i * 1024) * CLASS_B_PING_SLOT_WINDOW,
+                  slot);
+        from = slot + 1;
+    }
+    EXPECT_FALSE(object->get_next_ping_slot(from, slot));
+
+    EXPECT_TRUE(object->set_ping_slot_periodicity(0));
+    EXPECT_EQ(32u, object->get_ping_period());
+}
+
+TEST_F(Test_LoRaMacClassB, tx_delay)
+{
+    EXPECT_EQ(0u, object->get_tx_delay(0, 1000));
+
+    lock(0, CLASS_B_BEACON_INTERVAL, 1);
+    const lorawan_time_t beacon = object->get_next_beacon_start();
+    const uint32_t guard = CLASS_B_BEACON_GUARD + object->get_window_widening(beacon);
+
+    EXPECT_EQ(0u, object->get_tx_delay(10000, 1000));
+    EXPECT_EQ(0u, object->get_tx_delay(beacon - guard - 1000, 1000));
+
+    // the exchange would run into the guard period
+    EXPECT_EQ(guard + 999 + CLASS_B_BEACON_RESERVED,
+              object->get_tx_delay(beacon - guard - 999, 1000));
+    // in the reserved period
+    EXPECT_EQ(CLASS_B_BEACON_RESERVED - 100u, object->get_tx_delay(beacon + 100, 1000));
+    EXPECT_EQ(0u, object->get_tx_delay(beacon + CLASS_B_BEACON_RESERVED, 1000));
+}
+
+TEST_F(Test_LoRaMacClassB, status)
+{
+    lorawan_class_b_status_t status;
+
+    object->get_status(status, 0);
+    EXPECT_FALSE(status.synchronised);
+    EXPECT_EQ(0, status.drift);
+
+    lock(0, CLASS_B_BEACON_INTERVAL, 1, 4242);
+    object->ping_slot_opened();
+    EXPECT_TRUE(object->beacon_missed());
+
+    object->get_status(status, 1000);
+    EXPECT_TRUE(status.synchronised);
+    EXPECT_EQ(4242u + 128, status.beacon_time);
+    EXPECT_EQ(1u, status.beacons_received);
+    EXPECT_EQ(1u, status.beacons_missed);
+    EXPECT_EQ(1u, status.ping_slots);
+    EXPECT_EQ(uint32_t(object->get_ping_period()) * CLASS_B_PING_SLOT_WINDOW, status.ping_period);
+}
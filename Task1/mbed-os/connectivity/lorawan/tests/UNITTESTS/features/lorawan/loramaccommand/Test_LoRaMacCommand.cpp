@@ -350,3 +350,69 @@ TEST_F(Test_LoRaMacCommand, set_batterylevel_callback)
     object->set_batterylevel_callback(my_cb);
 }
 
+
+TEST_F(Test_LoRaMacCommand, class_b_commands)
+{
+    loramac_mlme_confirm_t mlme;
+    lora_mac_system_params_t params;
+    my_LoRaPHY phy;
+    uint8_t buf[20];
+    uint16_t delay = 0;
+
+    EXPECT_TRUE(object->add_ping_slot_info_req(0x0D) == LORAWAN_STATUS_OK);
+    EXPECT_TRUE(object->add_beacon_timing_req() == LORAWAN_STATUS_OK);
+    EXPECT_TRUE(object->get_mac_cmd_length() == 3);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[0] == MOTE_MAC_PING_SLOT_INFO_REQ);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[1] == 0x05);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[2] == MOTE_MAC_BEACON_TIMING_REQ);
+    object->clear_command_buffer();
+
+    // PingSlotInfoAns and BeaconTimingAns
+    EXPECT_FALSE(object->take_ping_slot_info_ans());
+    EXPECT_FALSE(object->take_beacon_timing_ans(delay));
+    buf[0] = SRV_MAC_PING_SLOT_INFO_ANS;
+    buf[1] = SRV_MAC_BEACON_TIMING_ANS;
+    buf[2] = 0x34;
+    buf[3] = 0x12;
+    buf[4] = 0;
+    EXPECT_TRUE(object->process_mac_commands(buf, 0, 5, 0, mlme, params, phy) == LORAWAN_STATUS_OK);
+    EXPECT_TRUE(object->take_ping_slot_info_ans());
+    EXPECT_FALSE(object->take_ping_slot_info_ans());
+    EXPECT_TRUE(object->take_beacon_timing_ans(delay));
+    EXPECT_TRUE(delay == 0x1234);
+    EXPECT_FALSE(object->take_beacon_timing_ans(delay));
+
+    // PingSlotChannelReq, accepted
+    params.ping_slot_channel.frequency = 0;
+    params.ping_slot_channel.datarate = 0;
+    LoRaPHY_stub::uint8_value = 0x03;
+    buf[0] = SRV_MAC_PING_SLOT_CHANNEL_REQ;
+    buf[1] = 0x28;
+    buf[2] = 0x76;
+    buf[3] = 0x84;
+    buf[4] = 0x02;
+    EXPECT_TRUE(object->process_mac_commands(buf, 0, 5, 0, mlme, params, phy) == LORAWAN_STATUS_OK);
+    EXPECT_TRUE(params.ping_slot_channel.frequency == 868100000);
+    EXPECT_TRUE(params.ping_slot_channel.datarate == 2);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[0] == MOTE_MAC_PING_SLOT_CHANNEL_ANS);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[1] == 0x03);
+    object->clear_command_buffer();
+
+    // rejected data rate, the channel does not change
+    LoRaPHY_stub::uint8_value = 0x01;
+    buf[4] = 0x0E;
+    EXPECT_TRUE(object->process_mac_commands(buf, 0, 5, 0, mlme, params, phy) == LORAWAN_STATUS_OK);
+    EXPECT_TRUE(params.ping_slot_channel.datarate == 2);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[1] == 0x01);
+    object->clear_command_buffer();
+
+    // BeaconFreqReq
+    params.beacon_frequency = 0;
+    LoRaPHY_stub::bool_counter = 0;
+    LoRaPHY_stub::bool_table[0] = true;
+    buf[0] = SRV_MAC_BEACON_FREQ_REQ;
+    EXPECT_TRUE(object->process_mac_commands(buf, 0, 4, 0, mlme, params, phy) == LORAWAN_STATUS_OK);
+    EXPECT_TRUE(params.beacon_frequency == 868100000);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[0] == MOTE_MAC_BEACON_FREQ_ANS);
+    EXPECT_TRUE(object->get_mac_commands_buffer()[1] == 0x01);
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "LoRaMacCrypto.h"
+
+#define UP_LINK 0
+#define DOWN_LINK 1
+#define KEY_LENGTH 128
+
+/*
+ * Unconfirmed uplink "40F17DBE4900020001954378762B11FF0D": DevAddr 0x49BE7DF1,
+ * FCnt 2, FPort 1, clear text payload "test".
+ */
+static const uint8_t nwk_skey[16] = {
+    0x44, 0x02, 0x42, 0x41, 0xed, 0x4c, 0xe9, 0xa6,
+    0x8c, 0x6a, 0x8b, 0xc0, 0x55, 0x23, 0x3f, 0xd3
+};
+static const uint8_t app_skey[16] = {
+    0xec, 0x92, 0x58, 0x02, 0xae, 0x43, 0x0c, 0xa7,
+    0x7f, 0xd3, 0xdd, 0x73, 0xcb, 0x2c, 0xc5, 0x88
+};
+static const uint8_t header[9] = { 0x40, 0xf1, 0x7d, 0xbe, 0x49, 0x00, 0x02, 0x00, 0x01 };
+static const uint8_t clear_payload[4] = { 't', 'e', 's', 't' };
+static const uint8_t cipher_payload[4] = { 0x95, 0x43, 0x78, 0x76 };
+static const uint32_t dev_addr = 0x49be7df1;
+static const uint32_t fcnt = 2;
+static const uint32_t frame_mic = 0x0dff112b;
+
+class Test_LoRaMacCrypto : public testing::Test {
+protected:
+    LoRaMacCrypto *object;
+
+    virtual void SetUp()
+    {
+        object = new LoRaMacCrypto();
+    }
+
+    virtual void TearDown()
+    {
+        delete object;
+    }
+
+    /* encrypt and sign a frame with the per call API */
+    void legacy_frame(uint8_t *frame, const uint8_t *payload, uint8_t size,
+                      uint32_t seq, uint32_t *mic)
+    {
+        memcpy(frame, header, sizeof(header));
+        EXPECT_EQ(0, object->encrypt_payload(payload, size, app_skey, KEY_LENGTH, dev_addr,
+                                             UP_LINK, seq, frame + sizeof(header)));
+        EXPECT_EQ(0, object->compute_mic(frame, sizeof(header) + size, nwk_skey, KEY_LENGTH,
+                                         dev_addr, UP_LINK, seq, mic));
+    }
+};
+
+TEST_F(Test_LoRaMacCrypto, constructor)
+{
+    EXPECT_TRUE(object);
+}
+
+TEST_F(Test_LoRaMacCrypto, uplink_vector)
+{
+    uint8_t frame[sizeof(header) + sizeof(clear_payload)];
+    uint32_t mic = 0;
+
+    legacy_frame(frame, clear_payload, sizeof(clear_payload), fcnt, &mic);
+    EXPECT_EQ(0, memcmp(frame + sizeof(header), cipher_payload, sizeof(cipher_payload)));
+    EXPECT_EQ(frame_mic, mic);
+
+    ASSERT_EQ(0, object->set_session_keys(nwk_skey, app_skey, KEY_LENGTH));
+
+    memset(frame, 0, sizeof(frame));
+    memcpy(frame, header, sizeof(header));
+    mic = 0;
+    EXPECT_EQ(0, object->secure_frame(frame, sizeof(header), clear_payload, sizeof(clear_payload),
+                                      LoRaMacCrypto::APP_SKEY, dev_addr, UP_LINK, fcnt, &mic));
+    EXPECT_EQ(0, memcmp(frame + sizeof(header), cipher_payload, sizeof(cipher_payload)));
+    EXPECT_EQ(frame_mic, mic);
+
+    /* downlinks use the session keys one at a time */
+    mic = 0;
+    EXPECT_EQ(0, object->compute_mic(frame, sizeof(frame), LoRaMacCrypto::NWK_SKEY, dev_addr,
+                                     UP_LINK, fcnt, &mic));
+    EXPECT_EQ(frame_mic, mic);
+
+    uint8_t clear[sizeof(clear_payload)];
+    EXPECT_EQ(0, object->decrypt_payload(cipher_payload, sizeof(cipher_payload),
+                                         LoRaMacCrypto::APP_SKEY, dev_addr, UP_LINK, fcnt, clear));
+    EXPECT_EQ(0, memcmp(clear, clear_payload, sizeof(clear_payload)));
+}
+
+TEST_F(Test_LoRaMacCrypto, session_matches_legacy)
+{
+    uint8_t payload[242];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = i * 7 + 3;
+    }
+
+    // sizes around the AES block boundaries, the MIC covers header + payload
+    const uint8_t sizes[] = { 0, 1, 6, 7, 15, 16, 17, 23, 32, 48, 51, 115, 222, 242 };
+
+    for (uint8_t size : sizes) {
+        uint8_t expected[sizeof(header) + sizeof(payload)];
+        uint8_t frame[sizeof(header) + sizeof(payload)];
+        uint32_t expected_mic = 0;
+        uint32_t mic = 0;
+
+        object->clear_session_keys();
+        legacy_frame(expected, payload, size, 0x10000 + size, &expected_mic);
+
+        ASSERT_EQ(0, object->set_session_keys(nwk_skey, app_skey, KEY_LENGTH));
+        memcpy(frame, header, sizeof(header));
+        EXPECT_EQ(0, object->secure_frame(frame, sizeof(header), payload, size,
+                                          LoRaMacCrypto::APP_SKEY, dev_addr, UP_LINK,
+                                          0x10000 + size, &mic));
+        EXPECT_EQ(0, memcmp(expected, frame, sizeof(header) + size)) << "size " << (int) size;
+        EXPECT_EQ(expected_mic, mic) << "size " << (int) size;
+
+        // port 0 payloads are encrypted with the network session key
+        uint32_t port0_mic = 0;
+        memcpy(frame, header, sizeof(header));
+        EXPECT_EQ(0, object->secure_frame(frame, sizeof(header), payload, size,
+                                          LoRaMacCrypto::NWK_SKEY, dev_addr, UP_LINK,
+                                          size, &port0_mic));
+        object->clear_session_keys();
+        memcpy(expected, header, sizeof(header));
+        EXPECT_EQ(0, object->encrypt_payload(payload, size, nwk_skey, KEY_LENGTH, dev_addr,
+                                             UP_LINK, size, expected + sizeof(header)));
+        EXPECT_EQ(0, memcmp(expected, frame, sizeof(header) + size)) << "size " << (int) size;
+        EXPECT_EQ(0, object->compute_mic(expected, sizeof(header) + size, nwk_skey, KEY_LENGTH,
+                                         dev_addr, UP_LINK, size, &mic));
+        EXPECT_EQ(mic, port0_mic) << "size " << (int) size;
+    }
+}
+
+TEST_F(Test_LoRaMacCrypto, session_keys_required)
+{
+    const uint8_t other_key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    uint8_t frame[sizeof(header) + sizeof(clear_payload)];
+    uint32_t mic = 0;
+
+    memcpy(frame, header, sizeof(header));
+    EXPECT_NE(0, object->secure_frame(frame, sizeof(header), clear_payload, sizeof(clear_payload),
+                                      LoRaMacCrypto::APP_SKEY, dev_addr, UP_LINK, fcnt, &mic));
+    EXPECT_NE(0, object->compute_mic(frame, sizeof(frame), LoRaMacCrypto::NWK_SKEY, dev_addr,
+                                     UP_LINK, fcnt, &mic));
+
+    /* keys passed explicitly, as for multicast, never use the session */
+    ASSERT_EQ(0, object->set_session_keys(other_key, other_key, KEY_LENGTH));
+    legacy_frame(frame, clear_payload, sizeof(clear_payload), fcnt, &mic);
+    EXPECT_EQ(0, memcmp(frame + sizeof(header), cipher_payload, sizeof(cipher_payload)));
+    EXPECT_EQ(frame_mic, mic);
+
+    object->clear_session_keys();
+    EXPECT_NE(0, object->encrypt_payload(clear_payload, sizeof(clear_payload),
+                                         LoRaMacCrypto::APP_SKEY, dev_addr, UP_LINK, fcnt,
+                                         frame + sizeof(header)));
+
+    EXPECT_NE(0, object->set_session_keys(nwk_skey, app_skey, 256));
+    EXPECT_NE(0, object->compute_mic(frame, sizeof(frame), LoRaMacCrypto::NWK_SKEY, dev_addr,
+                                     UP_LINK, fcnt, &mic));
+}
+
+/*
+ * Frames per second for a 51 byte uplink, the largest payload of the
+ * slowest data rates, sealed with the per call API and with the session
+ * key schedules.
+ */
+TEST_F(Test_LoRaMacCrypto, benchmark)
+{
+    using clock = std::chrono::steady_clock;
+    const uint32_t iterations = 20000;
+    uint8_t payload[51] = {};
+    uint8_t frame[sizeof(header) + sizeof(payload)];
+    uint32_t mic = 0;
+
+    memcpy(frame, header, sizeof(header));
+
+    clock::time_point start = clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        object->encrypt_payload(payload, sizeof(payload), app_skey, KEY_LENGTH, dev_addr,
+                                UP_LINK, i, frame + sizeof(header));
+        object->compute_mic(frame, sizeof(frame), nwk_skey, KEY_LENGTH, dev_addr, UP_LINK, i, &mic);
+    }
+    std::chrono::duration<double> legacy = clock::now() - start;
+
+    ASSERT_EQ(0, object->set_session_keys(nwk_skey, app_skey, KEY_LENGTH));
+
+    start = clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        object->secure_frame(frame, sizeof(header), payload, sizeof(payload),
+                             LoRaMacCrypto::APP_SKEY, dev_addr, UP_LINK, i, &mic);
+    }
+    std::chrono::duration<double> session = clock::now() - start;
+
+    printf("[ BENCH    ] legacy: %.0f frames/s, session: %.0f frames/s\n",
+           iterations / legacy.count(), iterations / session.count());
+}
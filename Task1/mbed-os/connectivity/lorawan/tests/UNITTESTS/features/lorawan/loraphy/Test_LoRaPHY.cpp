@@ -715,6 +715,142 @@ TEST_F(Test_LoRaPHY, set_next_channel)
     EXPECT_TRUE(LORAWAN_STATUS_OK == object->set_next_channel(&p, &ch, &t1, &t2));
 }
 
+TEST_F(Test_LoRaPHY, set_next_channel_least_restricted_band)
+{
+    LoRaWANTimeHandler timer;
+    object->initialize(&timer);
+    LoRaWANTimer_stub::time_value = 0;
+
+    band_t b[2];
+    memset(b, 0, sizeof(b));
+    b[0].duty_cycle = 1000;
+    b[1].duty_cycle = 100;
+    object->get_phy_params().bands.size = 2;
+    object->get_phy_params().bands.table = b;
+
+    channel_params_t ch_list[2];
+    memset(ch_list, 0, sizeof(ch_list));
+    ch_list[0].band = 0;
+    ch_list[1].band = 1;
+    ch_list[0].dr_range.fields.max = 5;
+    ch_list[1].dr_range.fields.max = 5;
+    object->get_phy_params().channels.channel_list = ch_list;
+    object->get_phy_params().max_channel_cnt = 2;
+
+    uint16_t mask = 0x3;
+    object->get_phy_params().channels.mask = &mask;
+    object->get_phy_params().channels.mask_size = 1;
+
+    channel_selection_params_t p;
+    memset(&p, 0, sizeof(channel_selection_params_t));
+    p.joined = true;
+    p.dc_enabled = true;
+    uint8_t ch = 0xFF;
+    lorawan_time_t t1 = 16;
+    lorawan_time_t t2 = 32;
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(LORAWAN_STATUS_OK == object->set_next_channel(&p, &ch, &t1, &t2));
+        EXPECT_EQ(1, ch);
+    }
+
+    // the restricted band is still used when the other one is off
+    b[1].off_time = 1000;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->set_next_channel(&p, &ch, &t1, &t2));
+    EXPECT_EQ(0, ch);
+}
+
+TEST_F(Test_LoRaPHY, compute_tx_time_on_air)
+{
+    uint32_t bandwidths[3] = { 125000, 125000, 125000 };
+    uint8_t datarates[3] = { 12, 7, 50 };
+    object->get_phy_params().bandwidths.table = bandwidths;
+    object->get_phy_params().datarates.table = datarates;
+
+    EXPECT_EQ(1483U, object->compute_tx_time_on_air(0, 23));
+    EXPECT_EQ(62U, object->compute_tx_time_on_air(1, 23));
+
+    object->get_phy_params().fsk_supported = true;
+    object->get_phy_params().max_tx_datarate = 2;
+    EXPECT_EQ(6U, object->compute_tx_time_on_air(2, 23));
+}
+
+TEST_F(Test_LoRaPHY, plan_tx)
+{
+    LoRaWANTimeHandler timer;
+    object->initialize(&timer);
+    LoRaWANTimer_stub::time_value = 0;
+
+    uint32_t bandwidths[2] = { 125000, 125000 };
+    uint8_t datarates[2] = { 12, 7 };
+    object->get_phy_params().bandwidths.table = bandwidths;
+    object->get_phy_params().datarates.table = datarates;
+    object->get_phy_params().datarates.size = 2;
+
+    band_t b[2];
+    memset(b, 0, sizeof(b));
+    b[0].duty_cycle = 100;
+    b[1].duty_cycle = 1000;
+    object->get_phy_params().bands.size = 2;
+    object->get_phy_params().bands.table = b;
+
+    channel_params_t ch_list[2];
+    memset(ch_list, 0, sizeof(ch_list));
+    ch_list[0].band = 0;
+    ch_list[1].band = 1;
+    ch_list[0].dr_range.fields.max = 1;
+    ch_list[1].dr_range.fields.max = 1;
+    object->get_phy_params().channels.channel_list = ch_list;
+    object->get_phy_params().max_channel_cnt = 2;
+
+    uint16_t mask = 0;
+    object->get_phy_params().channels.mask = &mask;
+
+    tx_plan_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.nb_frames = 3;
+    params.pkt_len = 23;
+    params.datarate = 1;
+    params.dc_enabled = true;
+    params.aggregated_duty_cycle = 1;
+    params.frame_gap = 2000;
+
+    lorawan_tx_plan_t plan;
+    EXPECT_TRUE(LORAWAN_STATUS_NO_CHANNEL_FOUND == object->plan_tx(&params, &plan));
+
+    mask = 0x3;
+    params.datarate = 2;
+    EXPECT_TRUE(LORAWAN_STATUS_NO_CHANNEL_FOUND == object->plan_tx(&params, &plan));
+
+    // 1 % band at 0, 0.1 % band after the RX windows, 1 % band once its time-off is over
+    params.datarate = 1;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->plan_tx(&params, &plan));
+    EXPECT_EQ(0U, plan.next_tx);
+    EXPECT_EQ(62U, plan.time_on_air);
+    EXPECT_EQ(3 * 62U, plan.airtime);
+    EXPECT_EQ(6200U + 62U, plan.drain_time);
+    EXPECT_EQ(1, plan.datarate);
+
+    // pending time-off
+    b[0].off_time = 10000;
+    b[1].off_time = 5000;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->plan_tx(&params, &plan));
+    EXPECT_EQ(5000U, plan.next_tx);
+    EXPECT_EQ(16200U + 62U, plan.drain_time);
+
+    // without duty cycle the RX windows set the pace
+    params.dc_enabled = false;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->plan_tx(&params, &plan));
+    EXPECT_EQ(0U, plan.next_tx);
+    EXPECT_EQ(2 * 2062U + 62U, plan.drain_time);
+
+    params.aggregated_duty_cycle = 100;
+    params.aggregated_delay = 300;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->plan_tx(&params, &plan));
+    EXPECT_EQ(300U, plan.next_tx);
+    EXPECT_EQ(300U + 2 * 6200U + 62U, plan.drain_time);
+}
+
 TEST_F(Test_LoRaPHY, add_channel)
 {
     uint16_t list[16];
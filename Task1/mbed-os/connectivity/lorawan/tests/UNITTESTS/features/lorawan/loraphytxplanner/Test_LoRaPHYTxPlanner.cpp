@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "LoRaPHYEU868.h"
+#include "LoRaPHYUS915.h"
+
+/*
+ * Simulated clock, the PHY layer only reads it through LoRaWANTimeHandler.
+ */
+static lorawan_time_t sim_time;
+
+LoRaWANTimeHandler::LoRaWANTimeHandler()
+    : _queue(NULL)
+{
+}
+
+LoRaWANTimeHandler::~LoRaWANTimeHandler()
+{
+}
+
+void LoRaWANTimeHandler::activate_timer_subsystem(events::EventQueue *queue)
+{
+    _queue = queue;
+}
+
+lorawan_time_t LoRaWANTimeHandler::get_current_time(void)
+{
+    return sim_time;
+}
+
+lorawan_time_t LoRaWANTimeHandler::get_elapsed_time(lorawan_time_t saved_time)
+{
+    return sim_time - saved_time;
+}
+
+void LoRaWANTimeHandler::init(timer_event_t &obj, mbed::Callback<void()> callback)
+{
+}
+
+void LoRaWANTimeHandler::start(timer_event_t &obj, const uint32_t timeout)
+{
+}
+
+void LoRaWANTimeHandler::stop(timer_event_t &obj)
+{
+}
+
+void LoRaWANTimeHandler::clear(timer_event_t &obj)
+{
+}
+
+/*
+ * Radio computing the time on air as the SX127x drivers do, from the
+ * configuration given by LoRaPHY::tx_config().
+ */
+class FakeRadio : public LoRaRadio {
+public:
+    FakeRadio() : modem(MODEM_LORA), bandwidth(0), datarate(7), preamble_len(8)
+    {
+    }
+
+    virtual void init_radio(radio_events_t *) {}
+    virtual void radio_reset() {}
+    virtual void sleep(void) {}
+    virtual void standby(void) {}
+    virtual void set_rx_config(radio_modems_t, uint32_t, uint32_t, uint8_t, uint32_t,
+                               uint16_t, uint16_t, bool, uint8_t, bool, bool, uint8_t,
+                               bool, bool) {}
+
+    virtual void set_tx_config(radio_modems_t m, int8_t, uint32_t, uint32_t bw, uint32_t dr,
+                               uint8_t, uint16_t preamble, bool, bool, bool, uint8_t,
+                               bool, uint32_t)
+    {
+        modem = m;
+        bandwidth = bw;
+        datarate = dr;
+        preamble_len = preamble;
+    }
+
+    virtual void send(uint8_t *, uint8_t) {}
+    virtual void receive(void) {}
+    virtual void set_channel(uint32_t) {}
+    virtual uint32_t random(void)
+    {
+        return rand();
+    }
+    virtual uint8_t get_status(void)
+    {
+        return 0;
+    }
+    virtual void set_max_payload_length(radio_modems_t, uint8_t) {}
+    virtual void set_public_network(bool) {}
+
+    virtual uint32_t time_on_air(radio_modems_t m, uint8_t pkt_len)
+    {
+        if (m == MODEM_FSK) {
+            return (uint32_t) std::ceil(8.0 * (preamble_len + 3 + 1 + pkt_len + 2)
+                                        / datarate * 1000);
+        }
+
+        const double bw_hz = 125e3 * (1 << bandwidth);
+        const double symbol = (1 << datarate) / bw_hz;
+        const int low_dr_optimize = (symbol > 0.016) ? 1 : 0;
+        const double preamble = (preamble_len + 4.25) * symbol;
+        const double num = 8.0 * pkt_len - 4.0 * datarate + 28 + 16;
+        const double den = 4.0 * (datarate - 2 * low_dr_optimize);
+        const double symbols = 8 + std::max(std::ceil(num / den) * 5, 0.0);
+
+        return (uint32_t) std::floor((preamble + symbols * symbol) * 1000 + 0.999);
+    }
+
+    virtual bool perform_carrier_sense(radio_modems_t, uint32_t, int16_t, uint32_t)
+    {
+        return true;
+    }
+    virtual void start_cad(void) {}
+    virtual bool check_rf_frequency(uint32_t)
+    {
+        return true;
+    }
+    virtual void set_tx_continuous_wave(uint32_t, int8_t, uint16_t) {}
+    virtual void lock(void) {}
+    virtual void unlock(void) {}
+
+    radio_modems_t modem;
+    uint32_t bandwidth;
+    uint32_t datarate;
+    uint16_t preamble_len;
+};
+
+#define FRAME_GAP   2000
+#define START_TIME  100000
+
+class Test_LoRaPHYTxPlanner : public testing::Test {
+protected:
+    LoRaWANTimeHandler timer;
+    FakeRadio radio;
+
+    virtual void SetUp()
+    {
+        sim_time = START_TIME;
+        srand(1);
+    }
+
+    void setup(LoRaPHY &phy)
+    {
+        phy.initialize(&timer);
+        phy.set_radio_instance(radio);
+    }
+
+    tx_plan_params_t plan_params(int8_t datarate, uint8_t nb_frames, uint8_t size)
+    {
+        tx_plan_params_t params;
+        params.nb_frames = nb_frames;
+        params.pkt_len = size + LORA_MAC_FRMPAYLOAD_OVERHEAD;
+        params.datarate = datarate;
+        params.dc_enabled = true;
+        params.aggregated_duty_cycle = 1;
+        params.aggregated_delay = 0;
+        params.frame_gap = FRAME_GAP;
+        return params;
+    }
+
+    /*
+     * Sends the frames as LoRaMac does: the time-off of the last TX is
+     * applied before looking for a channel, and the MAC sleeps for the
+     * delay given by set_next_channel() when all bands are off.
+     * Returns the time at the end of the last TX.
+     */
+    lorawan_time_t drain(LoRaPHY &phy, int8_t datarate, uint8_t nb_frames, uint8_t size,
+                         uint8_t &last_channel, lorawan_time_t &last_toa)
+    {
+        lorawan_time_t tx_end = sim_time;
+
+        for (uint8_t n = 0; n < nb_frames; n++) {
+            channel_selection_params_t next_channel;
+            lorawan_time_t backoff = 0;
+            lorawan_time_t aggregated_timeoff = 0;
+            uint8_t channel = 0;
+
+            next_channel.aggregate_timeoff = 0;
+            next_channel.last_aggregate_tx_time = 0;
+            next_channel.current_datarate = datarate;
+            next_channel.joined = true;
+            next_channel.dc_enabled = true;
+
+            while (true) {
+                phy.calculate_backoff(true, false, true, last_channel, sim_time, last_toa);
+                lorawan_status_t status = phy.set_next_channel(&next_channel, &channel,
+                                                               &backoff, &aggregated_timeoff);
+                if (status == LORAWAN_STATUS_OK) {
+                    break;
+                }
+                EXPECT_EQ(LORAWAN_STATUS_DUTYCYCLE_RESTRICTED, status);
+                if (status != LORAWAN_STATUS_DUTYCYCLE_RESTRICTED) {
+                    return 0;
+                }
+                sim_time += backoff;
+            }
+
+            tx_config_params_t tx_config;
+            int8_t tx_power = 0;
+            lorawan_time_t toa = 0;
+
+            tx_config.channel = channel;
+            tx_config.datarate = datarate;
+            tx_config.tx_power = 0;
+            tx_config.max_eirp = 16;
+            tx_config.antenna_gain = 0;
+            tx_config.pkt_len = size + LORA_MAC_FRMPAYLOAD_OVERHEAD;
+            phy.tx_config(&tx_config, &tx_power, &toa);
+
+            tx_end = sim_time + toa;
+            phy.set_last_tx_done(channel, true, tx_end);
+            last_channel = channel;
+            last_toa = toa;
+            sim_time = tx_end + FRAME_GAP;
+        }
+
+        return tx_end;
+    }
+
+    /*
+     * Checks the plan against the schedule of the channel selection, burst
+     * after burst so that the time-offs of a burst weigh on the next one.
+     */
+    void check_plan(const char *name, LoRaPHY &phy, int8_t datarate, uint8_t nb_frames,
+                    uint8_t size, uint8_t nb_bursts)
+    {
+        uint8_t last_channel = 0;
+        lorawan_time_t last_toa = 0;
+        lorawan_time_t total = 0;
+
+        for (uint8_t burst = 0; burst < nb_bursts; burst++) {
+            tx_plan_params_t params = plan_params(datarate, nb_frames, size);
+            lorawan_tx_plan_t plan;
+
+            // the pending time-off is applied as LoRaMac::get_tx_plan() does
+            phy.calculate_backoff(true, false, true, last_channel, sim_time, last_toa);
+            ASSERT_EQ(LORAWAN_STATUS_OK, phy.plan_tx(&params, &plan));
+
+            const lorawan_time_t start = sim_time;
+            const lorawan_time_t tx_end = drain(phy, datarate, nb_frames, size,
+                                                last_channel, last_toa);
+
+            EXPECT_EQ(plan.drain_time, tx_end - start) << name << " burst " << (int) burst;
+            EXPECT_EQ(plan.time_on_air, last_toa) << name;
+            total += tx_end - start;
+
+            // the application sleeps until the next burst
+            sim_time += 60000;
+        }
+
+        printf("[ SIM      ] %-30s DR%d: %2u x %3u bytes, %7.1f s per burst\n", name, datarate,
+               nb_frames, size, total / 1000.0 / nb_bursts);
+    }
+};
+
+TEST_F(Test_LoRaPHYTxPlanner, time_on_air_matches_radio)
+{
+    LoRaPHYEU868 eu868;
+    LoRaPHYUS915 us915;
+    LoRaPHY *phys[] = { &eu868, &us915 };
+    const int8_t max_dr[] = { DR_7, DR_4 };
+
+    for (int p = 0; p < 2; p++) {
+        setup(*phys[p]);
+        for (int8_t dr = DR_0; dr <= max_dr[p]; dr++) {
+            uint8_t max_payload = phys[p]->get_max_payload(dr);
+            for (uint16_t size = 0; size <= max_payload; size += 7) {
+                tx_config_params_t tx_config;
+                int8_t tx_power = 0;
+                lorawan_time_t toa = 0;
+                memset(&tx_config, 0, sizeof(tx_config));
+                tx_config.datarate = dr;
+                tx_config.pkt_len = size + LORA_MAC_FRMPAYLOAD_OVERHEAD;
+                phys[p]->tx_config(&tx_config, &tx_power, &toa);
+
+                EXPECT_EQ(toa, phys[p]->compute_tx_time_on_air(dr, size + LORA_MAC_FRMPAYLOAD_OVERHEAD))
+                        << "PHY " << p << " DR" << (int) dr << " size " << size;
+            }
+        }
+    }
+}
+
+TEST_F(Test_LoRaPHYTxPlanner, eu868_default_channels)
+{
+    LoRaPHYEU868 phy;
+    setup(phy);
+
+    check_plan("EU868 default channels", phy, DR_5, 10, 20, 3);
+    check_plan("EU868 default channels", phy, DR_3, 5, 51, 2);
+}
+
+TEST_F(Test_LoRaPHYTxPlanner, eu868_multi_band)
+{
+    LoRaPHYEU868 phy;
+    setup(phy);
+
+    // CFList channels of band 0, and channels in the 0.1 % and 10 % bands
+    const uint32_t frequencies[] = { 867100000, 867300000, 867500000, 867700000, 867900000,
+                                     868800000, 869525000
+                                   };
+    const uint8_t bands[] = { 0, 0, 0, 0, 0, 2, 3 };
+    for (uint8_t i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i++) {
+        channel_params_t channel;
+        channel.frequency = frequencies[i];
+        channel.rx1_frequency = 0;
+        channel.dr_range.value = (DR_5 << 4) | DR_0;
+        channel.band = bands[i];
+        ASSERT_EQ(LORAWAN_STATUS_OK, phy.add_channel(&channel, 3 + i));
+    }
+
+    check_plan("EU868 multi-band", phy, DR_5, 10, 20, 3);
+    check_plan("EU868 multi-band", phy, DR_3, 5, 51, 2);
+
+    // the 10 % band takes the traffic first
+    tx_plan_params_t params = plan_params(DR_5, 1, 20);
+    lorawan_tx_plan_t plan;
+    sim_time += 3600000;
+    ASSERT_EQ(LORAWAN_STATUS_OK, phy.plan_tx(&params, &plan));
+    uint8_t last_channel = 0;
+    lorawan_time_t last_toa = 0;
+    drain(phy, DR_5, 1, 20, last_channel, last_toa);
+    EXPECT_EQ(869525000U, phy.get_phy_channels()[last_channel].frequency);
+}
+
+TEST_F(Test_LoRaPHYTxPlanner, us915)
+{
+    LoRaPHYUS915 phy;
+    setup(phy);
+
+    check_plan("US915 sub-band 2", phy, DR_3, 10, 20, 3);
+    check_plan("US915 sub-band 2", phy, DR_0, 5, 11, 2);
+}
+
+/*
+ * Time needed to drain a queue of 20 byte uplinks at every data rate
+ * supported by the default channels.
+ */
+TEST_F(Test_LoRaPHYTxPlanner, drain_time_per_datarate)
+{
+    LoRaPHYEU868 eu868;
+    LoRaPHYUS915 us915;
+    setup(eu868);
+    setup(us915);
+
+    for (int8_t dr = DR_0; dr <= DR_5; dr++) {
+        tx_plan_params_t params = plan_params(dr, 20, 20);
+        lorawan_tx_plan_t plan;
+        ASSERT_EQ(LORAWAN_STATUS_OK, eu868.plan_tx(&params, &plan));
+        printf("[ SIM      ] EU868 DR%d: %4u ms on air, 20 frames drained in %7.1f s\n",
+               dr, plan.time_on_air, plan.drain_time / 1000.0);
+    }
+
+    for (int8_t dr = DR_1; dr <= DR_4; dr++) {
+        tx_plan_params_t params = plan_params(dr, 20, 20);
+        lorawan_tx_plan_t plan;
+        ASSERT_EQ(LORAWAN_STATUS_OK, us915.plan_tx(&params, &plan));
+        printf("[ SIM      ] US915 DR%d: %4u ms on air, 20 frames drained in %7.1f s\n",
+               dr, plan.time_on_air, plan.drain_time / 1000.0);
+        EXPECT_EQ(20 * plan.time_on_air + 19 * FRAME_GAP, plan.drain_time);
+    }
+}
@@ -0,0 +1,720 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#include "SimChannel.h"
+
+using namespace std::chrono;
+
+/* LoRa bandwidths as given to set_tx_config() / set_rx_config() */
+static uint32_t lora_bandwidth(uint32_t bandwidth)
+{
+    if (bandwidth > 2) {
+        return bandwidth;
+    }
+    return 125000 << bandwidth;
+}
+
+SimChannel::SimChannel(events::EventQueue &queue, uint32_t seed)
+    : _queue(queue),
+      _next_id(1),
+      _gateway_busy_until(0),
+      _rand(seed ? seed : 1)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void SimChannel::set_uplink_handler(mbed::Callback<void(const sim_uplink_t &)> handler)
+{
+    _uplink_handler = handler;
+}
+
+uint32_t SimChannel::now()
+{
+    return _queue.tick();
+}
+
+uint32_t SimChannel::random()
+{
+    // xorshift32, deterministic for a given seed
+    _rand ^= _rand << 13;
+    _rand ^= _rand >> 17;
+    _rand ^= _rand << 5;
+    return _rand;
+}
+
+void SimChannel::attach(SimRadio *radio)
+{
+    _radios.push_back(radio);
+}
+
+void SimChannel::detach(SimRadio *radio)
+{
+    _radios.erase(std::remove(_radios.begin(), _radios.end(), radio), _radios.end());
+}
+
+int16_t SimChannel::rssi(const SimRadio &radio, int8_t power) const
+{
+    return (int16_t) std::floor(power - radio.get_path_loss());
+}
+
+int8_t SimChannel::snr(int16_t rssi, uint32_t bandwidth)
+{
+    const float noise = -174.0f + 10.0f * std::log10((float) bandwidth) + SIM_NOISE_FIGURE;
+    const float value = std::floor(rssi - noise);
+
+    // what the SX127x reports saturates well before the int8_t range
+    return (int8_t) std::max(-32.0f, std::min(15.0f, value));
+}
+
+int8_t SimChannel::snr_floor(radio_modems_t modem, uint32_t datarate)
+{
+    if (modem == MODEM_FSK) {
+        return 10;
+    }
+
+    // -7.5 dB at SF7 down to -20 dB at SF12
+    return (int8_t) std::ceil(-2.5f * (datarate - 4));
+}
+
+float SimChannel::symbol_time(radio_modems_t modem, uint32_t bandwidth, uint32_t datarate)
+{
+    if (modem == MODEM_FSK) {
+        return 8.0f * 1000 / datarate;
+    }
+
+    return (float)(1 << datarate) * 1000 / bandwidth;
+}
+
+uint32_t SimChannel::time_on_air(radio_modems_t modem, uint32_t bandwidth, uint32_t datarate,
+                                 uint16_t preamble_len, uint8_t size)
+{
+    if (modem == MODEM_FSK) {
+        return (uint32_t) std::ceil(8.0 * (preamble_len + 3 + 1 + size + 2) / datarate * 1000);
+    }
+
+    const double symbol = (double)(1 << datarate) / bandwidth;
+    const int low_dr_optimize = (symbol > 0.016) ? 1 : 0;
+    const double preamble = (preamble_len + 4.25) * symbol;
+    const double num = 8.0 * size - 4.0 * datarate + 28 + 16;
+    const double den = 4.0 * (datarate - 2 * low_dr_optimize);
+    const double symbols = 8 + std::max(std::ceil(num / den) * 5, 0.0);
+
+    return (uint32_t) std::floor((preamble + symbols * symbol) * 1000 + 0.999);
+}
+
+bool SimChannel::interferes(const sim_frame_t &lhs, const sim_frame_t &rhs) const
+{
+    // different spreading factors are treated as orthogonal
+    return lhs.frequency == rhs.frequency && lhs.modem == rhs.modem
+           && lhs.datarate == rhs.datarate && lhs.start < rhs.end && rhs.start < lhs.end;
+}
+
+SimChannel::air_frame_t *SimChannel::find(int id)
+{
+    for (size_t i = 0; i < _air.size(); i++) {
+        if (_air[i].id == id) {
+            return &_air[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t SimChannel::transmit(const sim_frame_t &frame)
+{
+    air_frame_t air;
+    air.id = _next_id++;
+    air.frame = frame;
+    air.frame.start = now();
+    air.frame.end = air.frame.start + time_on_air(frame.modem, frame.bandwidth, frame.datarate,
+                                                  frame.preamble_len, frame.size);
+    air.frame.collided = false;
+    air.frame.blocked = false;
+
+    const int16_t air_rssi = frame.sender ? rssi(*frame.sender, frame.power) : 0;
+
+    if (frame.sender) {
+        _stats.uplinks++;
+
+        for (size_t i = 0; i < _air.size(); i++) {
+            sim_frame_t &other = _air[i].frame;
+            if (!other.sender) {
+                // the gateway cannot receive while transmitting
+                if (!air.frame.blocked) {
+                    air.frame.blocked = true;
+                    _stats.half_duplex_losses++;
+                }
+                continue;
+            }
+            if (!interferes(air.frame, other)) {
+                continue;
+            }
+            const int16_t other_rssi = rssi(*other.sender, other.power);
+            if (air_rssi - other_rssi < SIM_CAPTURE_THRESHOLD) {
+                air.frame.collided = true;
+            }
+            if (other_rssi - air_rssi < SIM_CAPTURE_THRESHOLD) {
+                other.collided = true;
+            }
+        }
+    } else {
+        _stats.downlinks++;
+        _gateway_busy_until = std::max(_gateway_busy_until, air.frame.end);
+
+        for (size_t i = 0; i < _air.size(); i++) {
+            if (_air[i].frame.sender && !_air[i].frame.blocked) {
+                _air[i].frame.blocked = true;
+                _stats.half_duplex_losses++;
+            }
+        }
+    }
+
+    _air.push_back(air);
+
+    const int id = air.id;
+    const sim_frame_t sent = air.frame;
+
+    _queue.call_in(milliseconds(sent.end - sent.start), this, &SimChannel::end_of_frame, id);
+
+    for (size_t i = 0; i < _radios.size(); i++) {
+        SimRadio *radio = _radios[i];
+        if (radio == sent.sender || !radio->is_listening()) {
+            continue;
+        }
+        const int16_t radio_rssi = rssi(*radio, sent.power);
+        const int8_t radio_snr = snr(radio_rssi, sent.bandwidth);
+        if (radio->get_loss_rate() > 0
+                && (random() % 10000) < radio->get_loss_rate() * 10000) {
+            continue;
+        }
+        if (radio->try_lock(sent, radio_rssi, radio_snr) && !sent.sender) {
+            _stats.downlinks_received++;
+        }
+    }
+
+    return sent.end - sent.start;
+}
+
+bool SimChannel::transmit_at(const sim_frame_t &frame, uint32_t start)
+{
+    const uint32_t toa = time_on_air(frame.modem, frame.bandwidth, frame.datarate,
+                                     frame.preamble_len, frame.size);
+
+    for (size_t i = 0; i < _scheduled.size(); i++) {
+        const air_frame_t &other = _scheduled[i];
+        if (start < other.frame.end && other.frame.start < start + toa) {
+            return false;
+        }
+    }
+
+    if ((int32_t)(start - now()) < 0 || (int32_t)(start - _gateway_busy_until) < 0) {
+        return false;
+    }
+
+    air_frame_t scheduled;
+    scheduled.id = _next_id++;
+    scheduled.frame = frame;
+    scheduled.frame.sender = NULL;
+    scheduled.frame.start = start;
+    scheduled.frame.end = start + toa;
+    _scheduled.push_back(scheduled);
+
+    _queue.call_in(milliseconds(start - now()), this, &SimChannel::start_scheduled, scheduled.id);
+
+    return true;
+}
+
+void SimChannel::start_scheduled(int id)
+{
+    for (size_t i = 0; i < _scheduled.size(); i++) {
+        if (_scheduled[i].id == id) {
+            const sim_frame_t frame = _scheduled[i].frame;
+            _scheduled.erase(_scheduled.begin() + i);
+            transmit(frame);
+            return;
+        }
+    }
+}
+
+bool SimChannel::busy(uint32_t frequency)
+{
+    for (size_t i = 0; i < _air.size(); i++) {
+        if (_air[i].frame.frequency == frequency) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimChannel::listen(SimRadio &radio)
+{
+    for (size_t i = 0; i < _air.size(); i++) {
+        const sim_frame_t &frame = _air[i].frame;
+        if (frame.sender == &radio) {
+            continue;
+        }
+        const int16_t radio_rssi = rssi(radio, frame.power);
+        if (radio.try_lock(frame, radio_rssi, snr(radio_rssi, frame.bandwidth))) {
+            if (!frame.sender) {
+                _stats.downlinks_received++;
+            }
+            return;
+        }
+    }
+}
+
+void SimChannel::end_of_frame(int id)
+{
+    air_frame_t *air = find(id);
+    if (!air) {
+        return;
+    }
+
+    const sim_frame_t frame = air->frame;
+    _air.erase(_air.begin() + (air - &_air[0]));
+
+    if (!frame.sender) {
+        return;
+    }
+
+    const int16_t frame_rssi = rssi(*frame.sender, frame.power);
+    const int8_t frame_snr = snr(frame_rssi, frame.bandwidth);
+
+    if (frame.blocked) {
+        return;
+    }
+
+    if (frame.collided) {
+        _stats.collisions++;
+        return;
+    }
+
+    if (frame_snr < snr_floor(frame.modem, frame.datarate)) {
+        _stats.below_floor++;
+        return;
+    }
+
+    if (frame.sender->get_loss_rate() > 0
+            && (random() % 10000) < frame.sender->get_loss_rate() * 10000) {
+        _stats.random_losses++;
+        return;
+    }
+
+    _stats.received++;
+
+    if (_uplink_handler) {
+        sim_uplink_t uplink;
+        uplink.frame = &frame;
+        uplink.rssi = frame_rssi;
+        uplink.snr = frame_snr;
+        _uplink_handler(uplink);
+    }
+}
+
+/*****************************************************************************
+ * SimRadio                                                                  *
+ ****************************************************************************/
+
+static const sim_energy_profile_t sx1276_profile = {
+    3.3f,       // supply voltage
+    0.0002f,    // sleep
+    1.6f,       // standby
+    11.5f,      // RX, LnaBoost on, 125 kHz
+    28.0f,      // TX, RFO output at +13 dBm
+};
+
+SimRadio::SimRadio(SimChannel &channel, uint32_t seed)
+    : _channel(channel),
+      _events(NULL),
+      _path_loss(120),
+      _loss_rate(0),
+      _profile(sx1276_profile),
+      _state(RF_IDLE),
+      _power_state(POWER_SLEEP),
+      _power_state_since(channel.now()),
+      _frequency(0),
+      _public_network(true),
+      _tx_modem(MODEM_LORA),
+      _tx_power(14),
+      _tx_bandwidth(125000),
+      _tx_datarate(7),
+      _tx_preamble_len(8),
+      _tx_iq_inverted(false),
+      _rx_modem(MODEM_LORA),
+      _rx_bandwidth(125000),
+      _rx_datarate(7),
+      _rx_preamble_len(8),
+      _rx_symb_timeout(0),
+      _rx_iq_inverted(true),
+      _rx_continuous(false),
+      _rx_start(0),
+      _tx_configured_last(true),
+      _locked(false),
+      _rx_rssi(0),
+      _rx_snr(0),
+      _pending_event(0),
+      _rand(seed ? seed : 1)
+{
+    memset(&_stats, 0, sizeof(_stats));
+    memset(&_rx_frame, 0, sizeof(_rx_frame));
+    _channel.attach(this);
+}
+
+SimRadio::~SimRadio()
+{
+    cancel_pending();
+    _channel.detach(this);
+}
+
+void SimRadio::set_path_loss(float path_loss)
+{
+    _path_loss = path_loss;
+}
+
+void SimRadio::set_loss_rate(float loss_rate)
+{
+    _loss_rate = loss_rate;
+}
+
+void SimRadio::set_energy_profile(const sim_energy_profile_t &profile)
+{
+    set_power_state(_power_state);
+    _profile = profile;
+}
+
+void SimRadio::set_power_state(power_state_t state)
+{
+    const uint32_t now = _channel.now();
+    const uint32_t elapsed = now - _power_state_since;
+
+    switch (_power_state) {
+        case POWER_SLEEP:
+            _stats.sleep_time += elapsed;
+            break;
+        case POWER_STANDBY:
+            _stats.standby_time += elapsed;
+            break;
+        case POWER_RX:
+            _stats.rx_time += elapsed;
+            break;
+        case POWER_TX:
+            _stats.tx_time += elapsed;
+            break;
+    }
+
+    _power_state = state;
+    _power_state_since = now;
+}
+
+const sim_radio_stats_t &SimRadio::get_stats()
+{
+    set_power_state(_power_state);
+    return _stats;
+}
+
+float SimRadio::energy()
+{
+    const sim_radio_stats_t &stats = get_stats();
+
+    // mA x ms x V = uJ
+    const float charge = _profile.sleep * stats.sleep_time
+                         + _profile.standby * stats.standby_time
+                         + _profile.rx * stats.rx_time
+                         + _profile.tx * stats.tx_time;
+
+    return charge * _profile.supply_voltage / 1000;
+}
+
+void SimRadio::cancel_pending()
+{
+    if (_pending_event) {
+        _channel.queue().cancel(_pending_event);
+        _pending_event = 0;
+    }
+    _locked = false;
+}
+
+void SimRadio::init_radio(radio_events_t *events)
+{
+    _events = events;
+    sleep();
+}
+
+void SimRadio::radio_reset()
+{
+    sleep();
+}
+
+void SimRadio::sleep(void)
+{
+    cancel_pending();
+    _state = RF_IDLE;
+    set_power_state(POWER_SLEEP);
+}
+
+void SimRadio::standby(void)
+{
+    cancel_pending();
+    _state = RF_IDLE;
+    set_power_state(POWER_STANDBY);
+}
+
+void SimRadio::set_rx_config(radio_modems_t modem, uint32_t bandwidth,
+                             uint32_t datarate, uint8_t coderate,
+                             uint32_t bandwidth_afc, uint16_t preamble_len,
+                             uint16_t symb_timeout, bool fix_len,
+                             uint8_t payload_len,
+                             bool crc_on, bool freq_hop_on, uint8_t hop_period,
+                             bool iq_inverted, bool rx_continuous)
+{
+    _rx_modem = modem;
+    _rx_bandwidth = modem == MODEM_FSK ? bandwidth : lora_bandwidth(bandwidth);
+    _rx_datarate = datarate;
+    _rx_preamble_len = preamble_len;
+    _rx_symb_timeout = symb_timeout;
+    _rx_iq_inverted = iq_inverted;
+    _rx_continuous = rx_continuous;
+    _tx_configured_last = false;
+}
+
+void SimRadio::set_tx_config(radio_modems_t modem, int8_t power, uint32_t fdev,
+                             uint32_t bandwidth, uint32_t datarate,
+                             uint8_t coderate, uint16_t preamble_len,
+                             bool fix_len, bool crc_on, bool freq_hop_on,
+                             uint8_t hop_period, bool iq_inverted, uint32_t timeout)
+{
+    _tx_modem = modem;
+    _tx_power = power;
+    // LoRaPHY gives the bandwidth index for FSK too, the FSK channel is 50 kHz
+    _tx_bandwidth = modem == MODEM_FSK ? 50000 : lora_bandwidth(bandwidth);
+    _tx_datarate = datarate;
+    _tx_preamble_len = preamble_len;
+    _tx_iq_inverted = iq_inverted;
+    _tx_configured_last = true;
+}
+
+void SimRadio::send(uint8_t *buffer, uint8_t size)
+{
+    cancel_pending();
+
+    sim_frame_t frame;
+    memcpy(frame.payload, buffer, size);
+    frame.size = size;
+    frame.modem = _tx_modem;
+    frame.frequency = _frequency;
+    frame.datarate = _tx_datarate;
+    frame.bandwidth = _tx_bandwidth;
+    frame.preamble_len = _tx_preamble_len;
+    frame.power = _tx_power;
+    frame.iq_inverted = _tx_iq_inverted;
+    frame.public_network = _public_network;
+    frame.sender = this;
+
+    _state = RF_TX_RUNNING;
+    set_power_state(POWER_TX);
+    _stats.tx_frames++;
+
+    const uint32_t toa = _channel.transmit(frame);
+    _pending_event = _channel.queue().call_in(milliseconds(toa), this, &SimRadio::on_tx_done);
+}
+
+void SimRadio::on_tx_done()
+{
+    _pending_event = 0;
+    _state = RF_IDLE;
+    set_power_state(POWER_STANDBY);
+
+    if (_events && _events->tx_done) {
+        _events->tx_done();
+    }
+}
+
+void SimRadio::receive(void)
+{
+    cancel_pending();
+
+    _state = RF_RX_RUNNING;
+    set_power_state(POWER_RX);
+    _rx_start = _channel.now();
+
+    _channel.listen(*this);
+
+    if (!_locked && !_rx_continuous) {
+        const float window = _rx_symb_timeout * SimChannel::symbol_time(_rx_modem, _rx_bandwidth,
+                                                                        _rx_datarate);
+        _pending_event = _channel.queue().call_in(milliseconds((int) std::ceil(window)),
+                                                  this, &SimRadio::on_rx_timeout);
+    }
+}
+
+bool SimRadio::try_lock(const sim_frame_t &frame, int16_t rssi, int8_t snr)
+{
+    if (!is_listening() || frame.frequency != _frequency || frame.modem != _rx_modem
+            || frame.datarate != _rx_datarate || frame.bandwidth != _rx_bandwidth
+            || frame.iq_inverted != _rx_iq_inverted
+            || frame.public_network != _public_network) {
+        return false;
+    }
+
+    // the receiver must see the tail of the preamble
+    const float symbol = SimChannel::symbol_time(frame.modem, frame.bandwidth, frame.datarate);
+    const float latest = frame.start + (frame.preamble_len - SIM_MIN_PREAMBLE_SYMBOLS) * symbol;
+    if (_rx_start > latest) {
+        return false;
+    }
+
+    if (snr < SimChannel::snr_floor(frame.modem, frame.datarate)) {
+        return false;
+    }
+
+    cancel_pending();
+    _locked = true;
+    _rx_frame = frame;
+    _rx_rssi = rssi;
+    _rx_snr = snr;
+    _pending_event = _channel.queue().call_in(milliseconds(frame.end - _channel.now()),
+                                              this, &SimRadio::on_rx_done);
+
+    return true;
+}
+
+void SimRadio::on_rx_done()
+{
+    _pending_event = 0;
+    _locked = false;
+    _stats.rx_frames++;
+
+    if (_rx_continuous) {
+        _rx_start = _channel.now();
+    } else {
+        _state = RF_IDLE;
+        set_power_state(POWER_STANDBY);
+    }
+
+    if (_events && _events->rx_done) {
+        _events->rx_done(_rx_frame.payload, _rx_frame.size, _rx_rssi, _rx_snr);
+    }
+}
+
+void SimRadio::on_rx_timeout()
+{
+    _pending_event = 0;
+    _stats.rx_timeouts++;
+    _state = RF_IDLE;
+    set_power_state(POWER_STANDBY);
+
+    if (_events && _events->rx_timeout) {
+        _events->rx_timeout();
+    }
+}
+
+void SimRadio::set_channel(uint32_t freq)
+{
+    _frequency = freq;
+}
+
+uint32_t SimRadio::random(void)
+{
+    _rand ^= _rand << 13;
+    _rand ^= _rand >> 17;
+    _rand ^= _rand << 5;
+    return _rand;
+}
+
+uint8_t SimRadio::get_status(void)
+{
+    return _state;
+}
+
+void SimRadio::set_max_payload_length(radio_modems_t modem, uint8_t max)
+{
+}
+
+void SimRadio::set_public_network(bool enable)
+{
+    _public_network = enable;
+}
+
+uint32_t SimRadio::time_on_air(radio_modems_t modem, uint8_t pkt_len)
+{
+    // the drivers use whatever was configured last
+    if (_tx_configured_last) {
+        return SimChannel::time_on_air(modem, _tx_bandwidth, _tx_datarate, _tx_preamble_len,
+                                       pkt_len);
+    }
+    return SimChannel::time_on_air(modem, _rx_bandwidth, _rx_datarate, _rx_preamble_len,
+                                   pkt_len);
+}
+
+bool SimRadio::perform_carrier_sense(radio_modems_t modem,
+                                     uint32_t freq,
+                                     int16_t rssi_threshold,
+                                     uint32_t max_carrier_sense_time)
+{
+    return !_channel.busy(freq);
+}
+
+void SimRadio::start_cad(void)
+{
+    cancel_pending();
+
+    _state = RF_CAD;
+    set_power_state(POWER_RX);
+
+    const bool busy = _channel.busy(_frequency);
+    const float duration = 2 * SimChannel::symbol_time(_rx_modem, _rx_bandwidth, _rx_datarate);
+    _pending_event = _channel.queue().call_in(milliseconds((int) std::ceil(duration)),
+                                              this, &SimRadio::on_cad_done, busy);
+}
+
+void SimRadio::on_cad_done(bool busy)
+{
+    _pending_event = 0;
+    _state = RF_IDLE;
+    set_power_state(POWER_STANDBY);
+
+    if (_events && _events->cad_done) {
+        _events->cad_done(busy);
+    }
+}
+
+bool SimRadio::check_rf_frequency(uint32_t frequency)
+{
+    return true;
+}
+
+void SimRadio::set_tx_continuous_wave(uint32_t freq, int8_t power, uint16_t time)
+{
+    cancel_pending();
+
+    _frequency = freq;
+    _state = RF_TX_RUNNING;
+    set_power_state(POWER_TX);
+    _pending_event = _channel.queue().call_in(milliseconds(time * 1000), this,
+                                              &SimRadio::on_tx_done);
+}
+
+void SimRadio::lock(void)
+{
+}
+
+void SimRadio::unlock(void)
+{
+}
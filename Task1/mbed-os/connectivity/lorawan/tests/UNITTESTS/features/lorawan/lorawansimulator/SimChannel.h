@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIM_CHANNEL_H
+#define SIM_CHANNEL_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "events/EventQueue.h"
+#include "platform/Callback.h"
+#include "LoRaRadio.h"
+
+/*
+ * In-process radio channel for the LoRaWAN simulator.
+ *
+ * Every SimRadio and the single gateway share one SimChannel. Time is the
+ * tick of the EventQueue, which the unit test equeue platform advances
+ * only while dispatching, so the stack, the radios and the network server
+ * all run on the same simulated clock.
+ *
+ * The link of each radio to the gateway is a path loss, the same in both
+ * directions, plus an optional random frame loss. A frame is lost when its
+ * SNR is below the demodulation floor of its spreading factor, when it
+ * overlaps a frame on the same frequency and spreading factor which is not
+ * at least SIM_CAPTURE_THRESHOLD dB weaker, or when the gateway transmits
+ * while receiving it.
+ */
+
+class SimRadio;
+
+/** Strongest frame wins if this many dB above the other one. */
+#define SIM_CAPTURE_THRESHOLD       6
+
+/** Preamble symbols the receiver needs to lock on a frame. */
+#define SIM_MIN_PREAMBLE_SYMBOLS    4
+
+/** Transmit power of the gateway, in dBm. */
+#define SIM_GATEWAY_TX_POWER        14
+
+/** Noise figure of the receivers, in dB. */
+#define SIM_NOISE_FIGURE            6
+
+typedef struct sim_frame_s {
+    uint8_t payload[255];
+    uint8_t size;
+    radio_modems_t modem;
+    uint32_t frequency;
+    /** Spreading factor, or bit rate for FSK. */
+    uint32_t datarate;
+    /** Bandwidth in Hz. */
+    uint32_t bandwidth;
+    uint16_t preamble_len;
+    int8_t power;
+    bool iq_inverted;
+    bool public_network;
+    uint32_t start;
+    uint32_t end;
+    /** Sending radio, NULL for the gateway. */
+    SimRadio *sender;
+    /** Overlapped by a frame too strong to be captured over. */
+    bool collided;
+    /** Sent to the gateway while it was transmitting. */
+    bool blocked;
+} sim_frame_t;
+
+/** Uplink as received by the gateway. */
+typedef struct sim_uplink_s {
+    const sim_frame_t *frame;
+    int16_t rssi;
+    int8_t snr;
+} sim_uplink_t;
+
+typedef struct sim_channel_stats_s {
+    uint32_t uplinks;
+    uint32_t received;
+    uint32_t collisions;
+    uint32_t below_floor;
+    uint32_t random_losses;
+    uint32_t half_duplex_losses;
+    uint32_t downlinks;
+    uint32_t downlinks_received;
+} sim_channel_stats_t;
+
+class SimChannel {
+public:
+    SimChannel(events::EventQueue &queue, uint32_t seed);
+
+    /** Receiver of the uplinks which reach the gateway. */
+    void set_uplink_handler(mbed::Callback<void(const sim_uplink_t &)> handler);
+
+    /** Current simulated time, in ms. */
+    uint32_t now();
+
+    events::EventQueue &queue()
+    {
+        return _queue;
+    }
+
+    /** Sends a frame from a radio, or from the gateway if sender is NULL.
+     *
+     * @return  Time on air, in ms.
+     */
+    uint32_t transmit(const sim_frame_t &frame);
+
+    /** Schedules a gateway transmission.
+     *
+     * @return  false if the gateway is already transmitting at that time.
+     */
+    bool transmit_at(const sim_frame_t &frame, uint32_t start);
+
+    /** Indicates if a frame is on air on the given frequency. */
+    bool busy(uint32_t frequency);
+
+    /** Called by a radio entering RX, may lock the radio on a frame
+     * already on air.
+     */
+    void listen(SimRadio &radio);
+
+    /** Signal level at the gateway of a transmission from a radio. */
+    int16_t rssi(const SimRadio &radio, int8_t power) const;
+
+    /** SNR for the given signal level and bandwidth. */
+    static int8_t snr(int16_t rssi, uint32_t bandwidth);
+
+    /** Lowest SNR a receiver can demodulate. */
+    static int8_t snr_floor(radio_modems_t modem, uint32_t datarate);
+
+    /** Time on air as computed by the SX127x drivers. */
+    static uint32_t time_on_air(radio_modems_t modem, uint32_t bandwidth, uint32_t datarate,
+                                uint16_t preamble_len, uint8_t size);
+
+    /** Length of a symbol, in ms. */
+    static float symbol_time(radio_modems_t modem, uint32_t bandwidth, uint32_t datarate);
+
+    uint32_t random();
+
+    void attach(SimRadio *radio);
+    void detach(SimRadio *radio);
+
+    const sim_channel_stats_t &get_stats() const
+    {
+        return _stats;
+    }
+
+private:
+    void end_of_frame(int id);
+    void start_scheduled(int id);
+    bool interferes(const sim_frame_t &lhs, const sim_frame_t &rhs) const;
+
+    struct air_frame_t {
+        int id;
+        sim_frame_t frame;
+    };
+
+    air_frame_t *find(int id);
+
+    events::EventQueue &_queue;
+    mbed::Callback<void(const sim_uplink_t &)> _uplink_handler;
+    std::vector<air_frame_t> _air;
+    std::vector<air_frame_t> _scheduled;
+    std::vector<SimRadio *> _radios;
+    int _next_id;
+    uint32_t _gateway_busy_until;
+    uint32_t _rand;
+    sim_channel_stats_t _stats;
+};
+
+/** Current drawn by the radio in each state, in mA. */
+typedef struct sim_energy_profile_s {
+    float supply_voltage;
+    float sleep;
+    float standby;
+    float rx;
+    float tx;
+} sim_energy_profile_t;
+
+typedef struct sim_radio_stats_s {
+    uint32_t sleep_time;
+    uint32_t standby_time;
+    uint32_t rx_time;
+    uint32_t tx_time;
+    uint32_t tx_frames;
+    uint32_t rx_frames;
+    uint32_t rx_timeouts;
+} sim_radio_stats_t;
+
+/*
+ * LoRaRadio attached to a SimChannel.
+ *
+ * Events are raised from the EventQueue at the simulated time they would
+ * fire on hardware. Energy is integrated over the time spent in each state
+ * with the currents of the energy profile, the SX1276 datasheet figures by
+ * default.
+ */
+class SimRadio : public LoRaRadio {
+public:
+    SimRadio(SimChannel &channel, uint32_t seed);
+    virtual ~SimRadio();
+
+    /** Path loss between the radio and the gateway, in dB. */
+    void set_path_loss(float path_loss);
+
+    float get_path_loss() const
+    {
+        return _path_loss;
+    }
+
+    /** Probability to lose a frame in either direction, on top of
+     * collisions and the SNR floor.
+     */
+    void set_loss_rate(float loss_rate);
+
+    float get_loss_rate() const
+    {
+        return _loss_rate;
+    }
+
+    void set_energy_profile(const sim_energy_profile_t &profile);
+
+    /** Energy used since the radio was created, in mJ. */
+    float energy();
+
+    const sim_radio_stats_t &get_stats();
+
+    /** Called by the channel when a frame starts on air. */
+    bool try_lock(const sim_frame_t &frame, int16_t rssi, int8_t snr);
+
+    bool is_listening() const
+    {
+        return _state == RF_RX_RUNNING && !_locked;
+    }
+
+    virtual void init_radio(radio_events_t *events);
+    virtual void radio_reset();
+    virtual void sleep(void);
+    virtual void standby(void);
+    virtual void set_rx_config(radio_modems_t modem, uint32_t bandwidth,
+                               uint32_t datarate, uint8_t coderate,
+                               uint32_t bandwidth_afc, uint16_t preamble_len,
+                               uint16_t symb_timeout, bool fix_len,
+                               uint8_t payload_len,
+                               bool crc_on, bool freq_hop_on, uint8_t hop_period,
+                               bool iq_inverted, bool rx_continuous);
+    virtual void set_tx_config(radio_modems_t modem, int8_t power, uint32_t fdev,
+                               uint32_t bandwidth, uint32_t datarate,
+                               uint8_t coderate, uint16_t preamble_len,
+                               bool fix_len, bool crc_on, bool freq_hop_on,
+                               uint8_t hop_period, bool iq_inverted, uint32_t timeout);
+    virtual void send(uint8_t *buffer, uint8_t size);
+    virtual void receive(void);
+    virtual void set_channel(uint32_t freq);
+    virtual uint32_t random(void);
+    virtual uint8_t get_status(void);
+    virtual void set_max_payload_length(radio_modems_t modem, uint8_t max);
+    virtual void set_public_network(bool enable);
+    virtual uint32_t time_on_air(radio_modems_t modem, uint8_t pkt_len);
+    virtual bool perform_carrier_sense(radio_modems_t modem,
+                                       uint32_t freq,
+                                       int16_t rssi_threshold,
+                                       uint32_t max_carrier_sense_time);
+    virtual void start_cad(void);
+    virtual bool check_rf_frequency(uint32_t frequency);
+    virtual void set_tx_continuous_wave(uint32_t freq, int8_t power, uint16_t time);
+    virtual void lock(void);
+    virtual void unlock(void);
+
+    /* configuration of the receiver, read by the channel */
+    radio_modems_t rx_modem() const
+    {
+        return _rx_modem;
+    }
+    uint32_t rx_bandwidth() const
+    {
+        return _rx_bandwidth;
+    }
+    uint32_t rx_datarate() const
+    {
+        return _rx_datarate;
+    }
+    bool rx_iq_inverted() const
+    {
+        return _rx_iq_inverted;
+    }
+    uint32_t frequency() const
+    {
+        return _frequency;
+    }
+    bool public_network() const
+    {
+        return _public_network;
+    }
+    uint32_t rx_start() const
+    {
+        return _rx_start;
+    }
+
+private:
+    enum power_state_t {
+        POWER_SLEEP,
+        POWER_STANDBY,
+        POWER_RX,
+        POWER_TX
+    };
+
+    void set_power_state(power_state_t state);
+    void cancel_pending();
+    void on_tx_done();
+    void on_rx_done();
+    void on_rx_timeout();
+    void on_cad_done(bool busy);
+
+    SimChannel &_channel;
+    radio_events_t *_events;
+
+    float _path_loss;
+    float _loss_rate;
+    sim_energy_profile_t _profile;
+
+    uint8_t _state;
+    power_state_t _power_state;
+    uint32_t _power_state_since;
+    sim_radio_stats_t _stats;
+
+    uint32_t _frequency;
+    bool _public_network;
+
+    radio_modems_t _tx_modem;
+    int8_t _tx_power;
+    uint32_t _tx_bandwidth;
+    uint32_t _tx_datarate;
+    uint16_t _tx_preamble_len;
+    bool _tx_iq_inverted;
+
+    radio_modems_t _rx_modem;
+    uint32_t _rx_bandwidth;
+    uint32_t _rx_datarate;
+    uint16_t _rx_preamble_len;
+    uint16_t _rx_symb_timeout;
+    bool _rx_iq_inverted;
+    bool _rx_continuous;
+    uint32_t _rx_start;
+
+    /* last configured modem, used for time_on_air() like the drivers do */
+    bool _tx_configured_last;
+
+    bool _locked;
+    sim_frame_t _rx_frame;
+    int16_t _rx_rssi;
+    int8_t _rx_snr;
+
+    int _pending_event;
+    uint32_t _rand;
+};
+
+#endif // SIM_CHANNEL_H
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "SimDevice.h"
+
+using namespace std::chrono;
+
+#define SIM_APP_PORT    15
+
+SimDevice::SimDevice(SimChannel &channel, uint32_t id)
+    : _channel(channel),
+      _id(id),
+      _radio(channel, 0x9E3779B9 ^ (id * 0x85EBCA6B)),
+      _callbacks(),
+      _adr(false),
+      _datarate(DR_5),
+      _traffic(false),
+      _period(0),
+      _size(0),
+      _confirmed(false),
+      _traffic_event(0),
+      _sequence(0),
+      _rx_port(0)
+{
+    static const uint8_t app_eui[8] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x00, 0x01 };
+
+    const uint8_t dev_eui[8] = {
+        0x00, 0x80, 0xE1, 0x15, (uint8_t)(id >> 24), (uint8_t)(id >> 16),
+        (uint8_t)(id >> 8), (uint8_t) id
+    };
+
+    memcpy(_dev_eui, dev_eui, sizeof(_dev_eui));
+    memcpy(_app_eui, app_eui, sizeof(_app_eui));
+    for (uint8_t i = 0; i < sizeof(_app_key); i++) {
+        _app_key[i] = (uint8_t)(0x2B + i * 0x11) ^ (uint8_t)(id >> (8 * (i % 4)));
+    }
+
+    memset(&_stats, 0, sizeof(_stats));
+    memset(_rx_data, 0, sizeof(_rx_data));
+
+    _stack.bind_phy_and_radio_driver(_radio, _phy);
+    _stack.initialize_mac_layer(&_channel.queue());
+
+    _callbacks.events = mbed::callback(this, &SimDevice::on_event);
+    _callbacks.link_check_resp = mbed::callback(this, &SimDevice::on_link_check);
+    _stack.set_lora_callbacks(&_callbacks);
+}
+
+void SimDevice::set_link_settings(bool adr, uint8_t datarate)
+{
+    _adr = adr;
+    _datarate = datarate;
+}
+
+lorawan_status_t SimDevice::join()
+{
+    lorawan_connect_t params;
+
+    params.connect_type = LORAWAN_CONNECTION_OTAA;
+    params.connection_u.otaa.dev_eui = _dev_eui;
+    params.connection_u.otaa.app_eui = _app_eui;
+    params.connection_u.otaa.app_key = _app_key;
+    params.connection_u.otaa.nb_trials = 8;
+
+    return _stack.connect(params);
+}
+
+void SimDevice::start_traffic(uint32_t period, uint8_t size, bool confirmed)
+{
+    stop_traffic();
+
+    _traffic = true;
+    _period = period;
+    _size = size;
+    _confirmed = confirmed;
+
+    if (!_stats.joined) {
+        return;
+    }
+
+    send();
+}
+
+void SimDevice::stop_traffic()
+{
+    _traffic = false;
+    if (_traffic_event) {
+        _channel.queue().cancel(_traffic_event);
+        _traffic_event = 0;
+    }
+}
+
+lorawan_status_t SimDevice::request_link_check()
+{
+    return _stack.set_link_check_request();
+}
+
+uint8_t SimDevice::datarate()
+{
+    lorawan_tx_metadata metadata;
+    if (_stack.acquire_tx_metadata(metadata) == LORAWAN_STATUS_OK) {
+        _datarate = metadata.data_rate;
+    }
+    return _datarate;
+}
+
+void SimDevice::send()
+{
+    if (!_traffic) {
+        return;
+    }
+
+    // uniformly spread around the period so that devices do not stay in step
+    if (_period) {
+        const uint32_t delay = _period / 2 + _radio.random() % _period;
+        _traffic_event = _channel.queue().call_in(milliseconds(delay), this, &SimDevice::send);
+    }
+
+    uint8_t payload[242];
+    for (uint8_t i = 0; i < _size; i++) {
+        payload[i] = (uint8_t)(_sequence + i);
+    }
+
+    const int16_t ret = _stack.handle_tx(SIM_APP_PORT, payload, _size,
+                                         _confirmed ? MSG_CONFIRMED_FLAG : MSG_UNCONFIRMED_FLAG);
+    if (ret == LORAWAN_STATUS_WOULD_BLOCK) {
+        _stats.would_block++;
+    } else if (ret >= 0) {
+        _stats.sent++;
+        _sequence++;
+    } else {
+        _stats.tx_errors++;
+    }
+}
+
+void SimDevice::on_event(lorawan_event_t event)
+{
+    switch (event) {
+        case CONNECTED:
+            _stats.joined = true;
+            _stats.joined_at = _channel.now();
+            // the data rate can only be set with ADR off, ADR starts from it
+            _stack.enable_adaptive_datarate(false);
+            _stack.set_channel_data_rate(_datarate);
+            _stack.enable_adaptive_datarate(_adr);
+            if (_traffic) {
+                start_traffic(_period, _size, _confirmed);
+            }
+            break;
+        case JOIN_FAILURE:
+            _stats.join_failures++;
+            break;
+        case TX_DONE:
+            _stats.tx_done++;
+            datarate();
+            if (_traffic && !_period) {
+                send();
+            }
+            break;
+        case TX_TIMEOUT:
+        case TX_ERROR:
+        case CRYPTO_ERROR:
+        case TX_SCHEDULING_ERROR:
+            _stats.tx_errors++;
+            if (_traffic && !_period) {
+                send();
+            }
+            break;
+        case RX_DONE: {
+            int flags = 0;
+            const int16_t size = _stack.handle_rx(_rx_data, sizeof(_rx_data), _rx_port, flags,
+                                                  false);
+            if (size >= 0) {
+                _stats.rx_done++;
+                _stats.rx_bytes += size;
+                _stats.rx_at = _channel.now();
+            }
+            break;
+        }
+        case UPLINK_REQUIRED:
+            _stack.handle_tx(SIM_APP_PORT, NULL, 0, MSG_UNCONFIRMED_FLAG, true);
+            break;
+        case BEACON_LOCK:
+            _stats.beacon_locks++;
+            // the Class B bit of this uplink tells the network server
+            _stack.handle_tx(SIM_APP_PORT, NULL, 0, MSG_UNCONFIRMED_FLAG, true);
+            break;
+        case BEACON_MISS:
+            _stats.beacon_misses++;
+            break;
+        case BEACON_NOT_FOUND:
+            _stats.beacons_not_found++;
+            break;
+        case SWITCH_CLASS_B_TO_A:
+            _stats.class_b_losses++;
+            break;
+        case PING_SLOT_INFO_SYNCHED:
+            _stats.ping_slot_info_synched = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void SimDevice::on_link_check(uint8_t demod_margin, uint8_t nb_gateways)
+{
+    _stats.link_checks++;
+    _stats.link_check_margin = demod_margin;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIM_DEVICE_H
+#define SIM_DEVICE_H
+
+#include <stdint.h>
+
+#include "LoRaWANStack.h"
+#include "LoRaPHYEU868.h"
+#include "SimChannel.h"
+
+typedef struct sim_device_stats_s {
+    bool joined;
+    uint32_t joined_at;
+    uint32_t join_failures;
+    /** Uplinks requested by the application. */
+    uint32_t sent;
+    uint32_t would_block;
+    uint32_t tx_done;
+    uint32_t tx_errors;
+    uint32_t rx_done;
+    uint32_t rx_bytes;
+    uint32_t link_checks;
+    uint8_t link_check_margin;
+    /** Time of the last application downlink. */
+    uint32_t rx_at;
+    /* Class B events */
+    uint32_t beacon_locks;
+    uint32_t beacon_misses;
+    uint32_t beacons_not_found;
+    uint32_t class_b_losses;
+    bool ping_slot_info_synched;
+} sim_device_stats_t;
+
+/*
+ * EU868 end device: a LoRaWANStack on a SimRadio, with an application
+ * sending uplinks either periodically or back to back.
+ *
+ * The EUIs and the application key are derived from the device id, so
+ * that the same id can be provisioned in the SimNetworkServer.
+ *
+ * Once locked on the beacons, the device sends an uplink to announce Class
+ * B to the network server, as an application would.
+ */
+class SimDevice {
+public:
+    SimDevice(SimChannel &channel, uint32_t id);
+
+    uint32_t id() const
+    {
+        return _id;
+    }
+
+    const uint8_t *dev_eui() const
+    {
+        return _dev_eui;
+    }
+
+    const uint8_t *app_eui() const
+    {
+        return _app_eui;
+    }
+
+    const uint8_t *app_key() const
+    {
+        return _app_key;
+    }
+
+    LoRaWANStack &stack()
+    {
+        return _stack;
+    }
+
+    SimRadio &radio()
+    {
+        return _radio;
+    }
+
+    /** ADR and data rate applied once joined, ADR starts from that data
+     * rate.
+     */
+    void set_link_settings(bool adr, uint8_t datarate);
+
+    /** Starts an OTAA join. */
+    lorawan_status_t join();
+
+    /** Sends an uplink every period ms on average once joined, period 0
+     * sends the next uplink as soon as the previous one is done.
+     */
+    void start_traffic(uint32_t period, uint8_t size, bool confirmed);
+
+    void stop_traffic();
+
+    /** Adds a LinkCheckReq to the next uplink. */
+    lorawan_status_t request_link_check();
+
+    /** Data rate of the last uplink. */
+    uint8_t datarate();
+
+    const sim_device_stats_t &get_stats() const
+    {
+        return _stats;
+    }
+
+    /** Last application payload received. */
+    const uint8_t *rx_data() const
+    {
+        return _rx_data;
+    }
+
+    uint8_t rx_port() const
+    {
+        return _rx_port;
+    }
+
+private:
+    void on_event(lorawan_event_t event);
+    void on_link_check(uint8_t demod_margin, uint8_t nb_gateways);
+    void send();
+
+    SimChannel &_channel;
+    uint32_t _id;
+    uint8_t _dev_eui[8];
+    uint8_t _app_eui[8];
+    uint8_t _app_key[16];
+
+    SimRadio _radio;
+    LoRaPHYEU868 _phy;
+    LoRaWANStack _stack;
+    lorawan_app_callbacks_t _callbacks;
+
+    bool _adr;
+    uint8_t _datarate;
+
+    bool _traffic;
+    uint32_t _period;
+    uint8_t _size;
+    bool _confirmed;
+    int _traffic_event;
+    uint32_t _sequence;
+
+    sim_device_stats_t _stats;
+    uint8_t _rx_data[242];
+    uint8_t _rx_port;
+};
+
+#endif // SIM_DEVICE_H
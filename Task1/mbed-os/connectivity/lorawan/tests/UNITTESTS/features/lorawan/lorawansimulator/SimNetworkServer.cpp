@@ -0,0 +1,827 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#include "mbedtls/aes.h"
+#include "mbedtls/cipher.h"
+#include "mbedtls/cmac.h"
+#include "system/lorawan_data_structures.h"
+
+#include "SimNetworkServer.h"
+
+using namespace std::chrono;
+
+#define MTYPE_JOIN_REQUEST          0x00
+#define MTYPE_JOIN_ACCEPT           0x01
+#define MTYPE_UNCONFIRMED_UP        0x02
+#define MTYPE_UNCONFIRMED_DOWN      0x03
+#define MTYPE_CONFIRMED_UP          0x04
+#define MTYPE_CONFIRMED_DOWN        0x05
+
+#define FCTRL_ADR                   0x80
+#define FCTRL_ADR_ACK_REQ           0x40
+#define FCTRL_ACK                   0x20
+#define FCTRL_CLASS_B               0x10
+#define FCTRL_FOPTS_LEN             0x0F
+
+#define JOIN_REQUEST_SIZE           23
+#define NET_ID                      0x000013
+#define EU868_MAX_TX_POWER_INDEX    7
+#define EU868_DEFAULT_CHANNEL_MASK  0x0007
+
+#define BEACON_SIZE                 17
+#define BEACON_CRC_OFFSET           6
+#define BEACON_WINDOW_SLOTS         4096
+/** Unit of the delay of a BeaconTimingAns, in ms. */
+#define BEACON_TIMING_UNIT          30
+
+/*****************************************************************************
+ * Crypto                                                                    *
+ ****************************************************************************/
+
+static void aes_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    mbedtls_aes_context ctx;
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_enc(&ctx, key, 128);
+    mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, in, out);
+    mbedtls_aes_free(&ctx);
+}
+
+static void aes_decrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    mbedtls_aes_context ctx;
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_dec(&ctx, key, 128);
+    mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_DECRYPT, in, out);
+    mbedtls_aes_free(&ctx);
+}
+
+/* first four bytes of the CMAC, in the order they go on air */
+static void cmac(const uint8_t *key, const uint8_t *data, uint16_t size, uint8_t *mic)
+{
+    uint8_t out[16];
+    mbedtls_cipher_cmac(mbedtls_cipher_info_from_type(MBEDTLS_CIPHER_AES_128_ECB),
+                        key, 128, data, size, out);
+    memcpy(mic, out, 4);
+}
+
+static void put_u32(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+    buffer[2] = (value >> 16) & 0xFF;
+    buffer[3] = (value >> 24) & 0xFF;
+}
+
+/* MIC of a data frame, B0 block followed by the frame */
+static void data_mic(const uint8_t *key, const uint8_t *frame, uint8_t size, uint8_t dir,
+                     uint32_t dev_addr, uint32_t fcnt, uint8_t *mic)
+{
+    uint8_t buffer[16 + 255];
+
+    memset(buffer, 0, 16);
+    buffer[0] = 0x49;
+    buffer[5] = dir;
+    put_u32(buffer + 6, dev_addr);
+    put_u32(buffer + 10, fcnt);
+    buffer[15] = size;
+    memcpy(buffer + 16, frame, size);
+
+    cmac(key, buffer, 16 + size, mic);
+}
+
+/* FRMPayload encryption, its own inverse */
+static void crypt_payload(const uint8_t *key, const uint8_t *in, uint8_t size, uint8_t dir,
+                          uint32_t dev_addr, uint32_t fcnt, uint8_t *out)
+{
+    uint8_t a[16];
+    uint8_t s[16];
+
+    memset(a, 0, sizeof(a));
+    a[0] = 0x01;
+    a[5] = dir;
+    put_u32(a + 6, dev_addr);
+    put_u32(a + 10, fcnt);
+
+    for (uint8_t i = 0; i < size; i += 16) {
+        a[15] = i / 16 + 1;
+        aes_encrypt(key, a, s);
+        for (uint8_t j = 0; j < 16 && i + j < size; j++) {
+            out[i + j] = in[i + j] ^ s[j];
+        }
+    }
+}
+
+/* CRC-16/CCITT of the beacons, initial value 0 */
+static uint16_t crc16(const uint8_t *data, uint8_t size)
+{
+    uint16_t crc = 0;
+
+    for (uint8_t i = 0; i < size; i++) {
+        crc ^= (uint16_t) data[i] << 8;
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*****************************************************************************
+ * SimNetworkServer                                                          *
+ ****************************************************************************/
+
+SimNetworkServer::SimNetworkServer(SimChannel &channel)
+    : _channel(channel),
+      _adr_enabled(false),
+      _adr_history(SIM_NS_ADR_HISTORY),
+      _app_nonce(1),
+      _next_dev_addr(0x26011000),
+      _beacons_started(false),
+      _beacons_enabled(false),
+      _clock_drift(0),
+      _beacon_period(0),
+      _beacons(0)
+{
+    _channel.set_uplink_handler(mbed::callback(this, &SimNetworkServer::on_uplink));
+}
+
+int SimNetworkServer::add_device(const uint8_t *dev_eui, const uint8_t *app_eui,
+                                 const uint8_t *app_key)
+{
+    device_t device;
+    memset(&device, 0, sizeof(device));
+    memcpy(device.dev_eui, dev_eui, sizeof(device.dev_eui));
+    memcpy(device.app_eui, app_eui, sizeof(device.app_eui));
+    memcpy(device.app_key, app_key, sizeof(device.app_key));
+
+    _devices.push_back(device);
+    return _devices.size() - 1;
+}
+
+void SimNetworkServer::set_adr(bool enable, uint8_t history)
+{
+    _adr_enabled = enable;
+    _adr_history = std::max<uint8_t>(history, 1);
+}
+
+void SimNetworkServer::set_application_handler(mbed::Callback<void(int, uint8_t, const uint8_t *, uint8_t)> handler)
+{
+    _app_handler = handler;
+}
+
+bool SimNetworkServer::send(int index, uint8_t port, const uint8_t *data, uint8_t size,
+                            bool confirmed)
+{
+    device_t &device = _devices[index];
+
+    if (!device.joined || device.app_pending || port == 0 || size > sizeof(device.app_payload)) {
+        return false;
+    }
+
+    device.app_pending = true;
+    device.app_confirmed = confirmed;
+    device.app_port = port;
+    memcpy(device.app_payload, data, size);
+    device.app_size = size;
+
+    // Class B devices do not wait for their next uplink
+    if (device.stats.class_b && _beacons_started) {
+        send_ping_slot_downlink(device);
+    }
+    return true;
+}
+
+void SimNetworkServer::request_device_status(int index)
+{
+    const uint8_t command = SRV_MAC_DEV_STATUS_REQ;
+    add_mac_command(_devices[index], &command, 1);
+}
+
+const sim_ns_device_stats_t &SimNetworkServer::get_device_stats(int index) const
+{
+    return _devices[index].stats;
+}
+
+uint32_t SimNetworkServer::delivered() const
+{
+    uint32_t total = 0;
+    for (size_t i = 0; i < _devices.size(); i++) {
+        total += _devices[i].stats.delivered;
+    }
+    return total;
+}
+
+bool SimNetworkServer::joined(int index) const
+{
+    return _devices[index].joined;
+}
+
+uint32_t SimNetworkServer::dev_addr(int index) const
+{
+    return _devices[index].dev_addr;
+}
+
+void SimNetworkServer::start_beacons(int32_t drift)
+{
+    _clock_drift = drift;
+    _beacons_enabled = true;
+
+    if (_beacons_started) {
+        return;
+    }
+
+    _beacons_started = true;
+    _beacon_period = to_network_time(_channel.now()) / SIM_NS_BEACON_PERIOD + 1;
+    schedule_beacon();
+}
+
+void SimNetworkServer::set_beacons_enabled(bool enabled)
+{
+    _beacons_enabled = enabled;
+}
+
+uint32_t SimNetworkServer::to_sim_time(uint64_t network_time) const
+{
+    return (uint32_t) std::llround(network_time * 1e6 / (1e6 + _clock_drift));
+}
+
+uint64_t SimNetworkServer::to_network_time(uint32_t sim_time) const
+{
+    return (uint64_t) std::floor(sim_time * (1e6 + _clock_drift) / 1e6);
+}
+
+void SimNetworkServer::schedule_beacon()
+{
+    const uint32_t start = to_sim_time(_beacon_period * SIM_NS_BEACON_PERIOD);
+
+    _channel.queue().call_in(milliseconds(start - _channel.now()),
+                             this, &SimNetworkServer::send_beacon, _beacon_period);
+}
+
+void SimNetworkServer::send_beacon(uint64_t period)
+{
+    if (_beacons_enabled) {
+        // RFU(2) | Time(4) | CRC(2) | GwSpecific(7) | CRC(2)
+        sim_frame_t beacon;
+        memset(beacon.payload, 0, BEACON_SIZE);
+        put_u32(beacon.payload + 2, (uint32_t)(SIM_NS_GPS_TIME + period * SIM_NS_BEACON_PERIOD / 1000));
+
+        uint16_t crc = crc16(beacon.payload, BEACON_CRC_OFFSET);
+        beacon.payload[BEACON_CRC_OFFSET] = crc & 0xFF;
+        beacon.payload[BEACON_CRC_OFFSET + 1] = crc >> 8;
+        crc = crc16(beacon.payload + BEACON_CRC_OFFSET + 2, 7);
+        beacon.payload[BEACON_SIZE - 2] = crc & 0xFF;
+        beacon.payload[BEACON_SIZE - 1] = crc >> 8;
+
+        beacon.size = BEACON_SIZE;
+        beacon.modem = MODEM_LORA;
+        beacon.frequency = SIM_NS_BEACON_FREQUENCY;
+        beacon.datarate = SIM_NS_BEACON_SF;
+        beacon.bandwidth = 125000;
+        beacon.preamble_len = SIM_NS_BEACON_PREAMBLE;
+        beacon.power = SIM_GATEWAY_TX_POWER;
+        beacon.iq_inverted = false;
+        // the simulated devices are all on the public network
+        beacon.public_network = true;
+        beacon.sender = NULL;
+
+        if (_channel.transmit_at(beacon, _channel.now())) {
+            _beacons++;
+        }
+    }
+
+    _beacon_period = period + 1;
+    schedule_beacon();
+}
+
+uint16_t SimNetworkServer::ping_offset(uint32_t beacon_time, uint32_t dev_addr,
+                                       uint16_t ping_period)
+{
+    const uint8_t key[16] = { 0 };
+    uint8_t block[16];
+    uint8_t rand[16];
+
+    memset(block, 0, sizeof(block));
+    put_u32(block, beacon_time);
+    put_u32(block + 4, dev_addr);
+    aes_encrypt(key, block, rand);
+
+    return (rand[0] + rand[1] * 256) % ping_period;
+}
+
+uint8_t SimNetworkServer::datarate(const sim_frame_t &frame)
+{
+    if (frame.modem == MODEM_FSK) {
+        return 7;
+    }
+    if (frame.bandwidth == 250000) {
+        return 6;
+    }
+    return 12 - frame.datarate;
+}
+
+void SimNetworkServer::on_uplink(const sim_uplink_t &uplink)
+{
+    const sim_frame_t &frame = *uplink.frame;
+
+    if (frame.size < 1) {
+        return;
+    }
+
+    switch (frame.payload[0] >> 5) {
+        case MTYPE_JOIN_REQUEST:
+            handle_join_request(uplink);
+            break;
+        case MTYPE_UNCONFIRMED_UP:
+        case MTYPE_CONFIRMED_UP:
+            handle_data_frame(uplink);
+            break;
+        default:
+            break;
+    }
+}
+
+void SimNetworkServer::handle_join_request(const sim_uplink_t &uplink)
+{
+    const sim_frame_t &frame = *uplink.frame;
+
+    if (frame.size != JOIN_REQUEST_SIZE) {
+        return;
+    }
+
+    // EUIs are sent least significant byte first
+    uint8_t dev_eui[8];
+    for (uint8_t i = 0; i < 8; i++) {
+        dev_eui[i] = frame.payload[16 - i];
+    }
+
+    for (size_t i = 0; i < _devices.size(); i++) {
+        device_t &device = _devices[i];
+        if (memcmp(device.dev_eui, dev_eui, sizeof(dev_eui)) != 0) {
+            continue;
+        }
+
+        uint8_t mic[4];
+        cmac(device.app_key, frame.payload, JOIN_REQUEST_SIZE - 4, mic);
+        if (memcmp(mic, frame.payload + JOIN_REQUEST_SIZE - 4, 4) != 0) {
+            device.stats.mic_failures++;
+            return;
+        }
+
+        const uint8_t *dev_nonce = frame.payload + 17;
+        const uint32_t app_nonce = _app_nonce++;
+
+        // a rejoin gets a fresh session and address
+        device.dev_addr = _next_dev_addr++;
+
+        uint8_t accept[17];
+        accept[0] = MTYPE_JOIN_ACCEPT << 5;
+        accept[1] = app_nonce & 0xFF;
+        accept[2] = (app_nonce >> 8) & 0xFF;
+        accept[3] = (app_nonce >> 16) & 0xFF;
+        accept[4] = NET_ID & 0xFF;
+        accept[5] = (NET_ID >> 8) & 0xFF;
+        accept[6] = (NET_ID >> 16) & 0xFF;
+        put_u32(accept + 7, device.dev_addr);
+        accept[11] = SIM_NS_RX2_DATARATE;
+        accept[12] = SIM_NS_RX1_DELAY / 1000;
+        cmac(device.app_key, accept, 13, accept + 13);
+
+        // the device encrypts to decrypt, so the server decrypts to encrypt
+        uint8_t encrypted[17];
+        encrypted[0] = accept[0];
+        aes_decrypt(device.app_key, accept + 1, encrypted + 1);
+
+        uint8_t block[16];
+        memset(block, 0, sizeof(block));
+        memcpy(block + 1, accept + 1, 6);
+        memcpy(block + 7, dev_nonce, 2);
+        block[0] = 0x01;
+        aes_encrypt(device.app_key, block, device.nwk_skey);
+        block[0] = 0x02;
+        aes_encrypt(device.app_key, block, device.app_skey);
+
+        device.joined = true;
+        device.has_uplink = false;
+        device.fcnt_up = 0;
+        device.fcnt_down = 0;
+        device.mac_commands_len = 0;
+        device.app_pending = false;
+        device.snr_count = 0;
+        device.tx_power = 0;
+        device.adr_pending = false;
+        device.beacon_timing_req = false;
+        device.stats.class_b = false;
+        device.stats.joins++;
+        device.stats.joined_at = _channel.now();
+
+        if (!schedule(encrypted, sizeof(encrypted), uplink, SIM_NS_JOIN_ACCEPT_DELAY1)) {
+            device.stats.missed_downlinks++;
+        } else {
+            device.stats.downlinks++;
+        }
+        return;
+    }
+}
+
+void SimNetworkServer::handle_data_frame(const sim_uplink_t &uplink)
+{
+    const sim_frame_t &frame = *uplink.frame;
+
+    if (frame.size < 12) {
+        return;
+    }
+
+    const uint8_t mtype = frame.payload[0] >> 5;
+    const uint32_t dev_addr = frame.payload[1] | (frame.payload[2] << 8)
+                              | (frame.payload[3] << 16) | ((uint32_t) frame.payload[4] << 24);
+    const uint8_t fctrl = frame.payload[5];
+    const uint16_t fcnt16 = frame.payload[6] | (frame.payload[7] << 8);
+    const uint8_t fopts_len = fctrl & FCTRL_FOPTS_LEN;
+
+    int index = -1;
+    for (size_t i = 0; i < _devices.size(); i++) {
+        if (_devices[i].joined && _devices[i].dev_addr == dev_addr) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 || frame.size < 12 + fopts_len) {
+        return;
+    }
+
+    device_t &device = _devices[index];
+
+    // rebuild the 32 bit counter from its 16 least significant bits
+    uint32_t fcnt = (device.fcnt_up & 0xFFFF0000) | fcnt16;
+    if (device.has_uplink && fcnt < device.fcnt_up) {
+        fcnt += 0x10000;
+    }
+
+    uint8_t mic[4];
+    data_mic(device.nwk_skey, frame.payload, frame.size - 4, 0, dev_addr, fcnt, mic);
+    if (memcmp(mic, frame.payload + frame.size - 4, 4) != 0) {
+        device.stats.mic_failures++;
+        return;
+    }
+
+    const bool duplicate = device.has_uplink && fcnt == device.fcnt_up;
+
+    device.stats.uplinks++;
+    device.stats.last_snr = uplink.snr;
+    device.stats.datarate = datarate(frame);
+
+    if (fctrl & FCTRL_ACK) {
+        device.stats.downlink_acks++;
+    }
+
+    device.stats.class_b = (fctrl & FCTRL_CLASS_B) != 0;
+
+    if (duplicate) {
+        device.stats.duplicates++;
+    } else {
+        device.fcnt_up = fcnt;
+        device.has_uplink = true;
+
+        handle_mac_commands(device, frame.payload + 8, fopts_len, uplink);
+
+        const uint8_t payload_start = 8 + fopts_len;
+        if (frame.size > payload_start + 4) {
+            const uint8_t port = frame.payload[payload_start];
+            const uint8_t size = frame.size - payload_start - 5;
+            uint8_t clear[255];
+
+            crypt_payload(port == 0 ? device.nwk_skey : device.app_skey,
+                          frame.payload + payload_start + 1, size, 0, dev_addr, fcnt, clear);
+
+            if (port == 0) {
+                handle_mac_commands(device, clear, size, uplink);
+            } else {
+                device.stats.delivered++;
+                device.stats.delivered_bytes += size;
+                if (_app_handler) {
+                    _app_handler(index, port, clear, size);
+                }
+            }
+        }
+
+        if (_adr_enabled && (fctrl & FCTRL_ADR)) {
+            run_adr(device, uplink);
+        }
+    }
+
+    const bool ack = mtype == MTYPE_CONFIRMED_UP;
+    if (ack || device.mac_commands_len || device.app_pending || device.beacon_timing_req
+            || (fctrl & FCTRL_ADR_ACK_REQ)) {
+        send_downlink(device, uplink, ack);
+    }
+}
+
+void SimNetworkServer::handle_mac_commands(device_t &device, const uint8_t *commands,
+                                           uint8_t size, const sim_uplink_t &uplink)
+{
+    uint8_t i = 0;
+
+    while (i < size) {
+        switch (commands[i++]) {
+            case MOTE_MAC_LINK_CHECK_REQ: {
+                const int margin = uplink.snr - SimChannel::snr_floor(uplink.frame->modem,
+                                                                      uplink.frame->datarate);
+                const uint8_t answer[3] = {
+                    SRV_MAC_LINK_CHECK_ANS, (uint8_t) std::max(0, std::min(254, margin)), 1
+                };
+                add_mac_command(device, answer, sizeof(answer));
+                device.stats.link_checks++;
+                break;
+            }
+            case MOTE_MAC_LINK_ADR_ANS:
+                if (i + 1 > size) {
+                    return;
+                }
+                if ((commands[i] & 0x07) == 0x07 && device.adr_pending) {
+                    device.tx_power = device.adr_tx_power;
+                    device.stats.adr_accepted++;
+                }
+                device.adr_pending = false;
+                i += 1;
+                break;
+            case MOTE_MAC_DEV_STATUS_ANS:
+                if (i + 2 > size) {
+                    return;
+                }
+                device.stats.battery = commands[i];
+                // 6 bit signed margin
+                device.stats.margin = (int8_t)(commands[i + 1] << 2) >> 2;
+                device.stats.dev_status_answers++;
+                i += 2;
+                break;
+            case MOTE_MAC_RX_PARAM_SETUP_ANS:
+            case MOTE_MAC_NEW_CHANNEL_ANS:
+            case MOTE_MAC_DL_CHANNEL_ANS:
+                i += 1;
+                break;
+            case MOTE_MAC_PING_SLOT_INFO_REQ: {
+                if (i + 1 > size) {
+                    return;
+                }
+                device.stats.ping_slot_periodicity = commands[i] & 0x07;
+                const uint8_t answer = SRV_MAC_PING_SLOT_INFO_ANS;
+                add_mac_command(device, &answer, 1);
+                i += 1;
+                break;
+            }
+            case MOTE_MAC_BEACON_TIMING_REQ:
+                // answered when the downlink is built, relative to its end
+                device.beacon_timing_req = _beacons_started;
+                break;
+            case MOTE_MAC_DUTY_CYCLE_ANS:
+            case MOTE_MAC_RX_TIMING_SETUP_ANS:
+            case MOTE_MAC_TX_PARAM_SETUP_ANS:
+                break;
+            default:
+                // unknown command, the rest cannot be parsed
+                return;
+        }
+    }
+}
+
+/*
+ * Semtech's reference algorithm: the margin of the best recent uplink over
+ * the demodulation floor is spent in 3 dB steps, first raising the data
+ * rate, then lowering the transmit power.
+ */
+void SimNetworkServer::run_adr(device_t &device, const sim_uplink_t &uplink)
+{
+    device.snr_history[device.snr_count++ % _adr_history] = uplink.snr;
+
+    if (device.snr_count < _adr_history || device.adr_pending) {
+        return;
+    }
+
+    int8_t max_snr = device.snr_history[0];
+    for (uint8_t i = 1; i < _adr_history; i++) {
+        max_snr = std::max(max_snr, device.snr_history[i]);
+    }
+
+    const sim_frame_t &frame = *uplink.frame;
+    const int margin = max_snr - SimChannel::snr_floor(frame.modem, frame.datarate)
+                       - SIM_NS_ADR_MARGIN;
+    int steps = (int) std::floor(margin / 3.0);
+    uint8_t dr = datarate(frame);
+    uint8_t tx_power = device.tx_power;
+
+    while (steps > 0 && dr < 5) {
+        dr++;
+        steps--;
+    }
+    while (steps > 0 && tx_power < EU868_MAX_TX_POWER_INDEX) {
+        tx_power++;
+        steps--;
+    }
+    while (steps < 0 && tx_power > 0) {
+        tx_power--;
+        steps++;
+    }
+
+    device.snr_count = 0;
+
+    if (dr == datarate(frame) && tx_power == device.tx_power) {
+        return;
+    }
+
+    const uint8_t request[5] = {
+        SRV_MAC_LINK_ADR_REQ,
+        (uint8_t)((dr << 4) | tx_power),
+        EU868_DEFAULT_CHANNEL_MASK & 0xFF,
+        EU868_DEFAULT_CHANNEL_MASK >> 8,
+        // channel mask control 0, one transmission
+        0x01
+    };
+    add_mac_command(device, request, sizeof(request));
+
+    device.adr_pending = true;
+    device.adr_datarate = dr;
+    device.adr_tx_power = tx_power;
+    device.stats.adr_requests++;
+}
+
+void SimNetworkServer::add_mac_command(device_t &device, const uint8_t *command, uint8_t size)
+{
+    if (device.mac_commands_len + size > sizeof(device.mac_commands)) {
+        return;
+    }
+    memcpy(device.mac_commands + device.mac_commands_len, command, size);
+    device.mac_commands_len += size;
+}
+
+uint8_t SimNetworkServer::build_downlink(device_t &device, bool ack, uint8_t *frame)
+{
+    uint8_t size = 0;
+
+    const bool confirmed = device.app_pending && device.app_confirmed;
+
+    frame[size++] = (confirmed ? MTYPE_CONFIRMED_DOWN : MTYPE_UNCONFIRMED_DOWN) << 5;
+    put_u32(frame + size, device.dev_addr);
+    size += 4;
+    frame[size++] = (_adr_enabled ? FCTRL_ADR : 0) | (ack ? FCTRL_ACK : 0)
+                    | device.mac_commands_len;
+    frame[size++] = device.fcnt_down & 0xFF;
+    frame[size++] = (device.fcnt_down >> 8) & 0xFF;
+    memcpy(frame + size, device.mac_commands, device.mac_commands_len);
+    size += device.mac_commands_len;
+
+    if (device.app_pending) {
+        frame[size++] = device.app_port;
+        crypt_payload(device.app_skey, device.app_payload, device.app_size, 1,
+                      device.dev_addr, device.fcnt_down, frame + size);
+        size += device.app_size;
+    }
+
+    data_mic(device.nwk_skey, frame, size, 1, device.dev_addr, device.fcnt_down, frame + size);
+    size += 4;
+
+    return size;
+}
+
+void SimNetworkServer::downlink_sent(device_t &device)
+{
+    device.fcnt_down++;
+    device.mac_commands_len = 0;
+    device.app_pending = false;
+    device.stats.downlinks++;
+}
+
+void SimNetworkServer::send_downlink(device_t &device, const sim_uplink_t &uplink, bool ack)
+{
+    uint8_t frame[255];
+    bool rx2 = true;
+
+    if (device.beacon_timing_req
+            && device.mac_commands_len + 4 <= sizeof(device.mac_commands)) {
+        // The delay is counted from the end of the RX1 downlink to the next
+        // beacon, so the answer cannot fall back to RX2
+        const sim_frame_t &up = *uplink.frame;
+        const uint8_t size = 12 + device.mac_commands_len + 4
+                             + (device.app_pending ? 1 + device.app_size : 0);
+        const uint32_t end = up.end + SIM_NS_RX1_DELAY
+                             + SimChannel::time_on_air(up.modem, up.bandwidth, up.datarate, 8, size);
+        const uint64_t network_end = to_network_time(end);
+        const uint64_t beacon = (network_end / SIM_NS_BEACON_PERIOD + 1) * SIM_NS_BEACON_PERIOD;
+        const uint16_t delay = (beacon - network_end) / BEACON_TIMING_UNIT;
+
+        // the last byte is the beacon channel, unused in EU868
+        const uint8_t answer[4] = {
+            SRV_MAC_BEACON_TIMING_ANS, (uint8_t)(delay & 0xFF), (uint8_t)(delay >> 8), 0
+        };
+        add_mac_command(device, answer, sizeof(answer));
+        rx2 = false;
+    }
+
+    const uint8_t size = build_downlink(device, ack, frame);
+
+    if (!schedule(frame, size, uplink, SIM_NS_RX1_DELAY, rx2)) {
+        // keep everything for the next uplink
+        if (!rx2) {
+            device.mac_commands_len -= 4;
+        }
+        device.stats.missed_downlinks++;
+        return;
+    }
+
+    if (!rx2) {
+        device.beacon_timing_req = false;
+        device.stats.beacon_timing_answers++;
+    }
+    downlink_sent(device);
+}
+
+void SimNetworkServer::send_ping_slot_downlink(device_t &device)
+{
+    sim_frame_t down;
+
+    down.size = build_downlink(device, false, down.payload);
+    down.modem = MODEM_LORA;
+    down.frequency = SIM_NS_BEACON_FREQUENCY;
+    down.datarate = SIM_NS_BEACON_SF;
+    down.bandwidth = 125000;
+    down.preamble_len = 8;
+    down.power = SIM_GATEWAY_TX_POWER;
+    down.iq_inverted = true;
+    down.public_network = true;
+    down.sender = NULL;
+
+    const uint16_t ping_period = 1 << (5 + device.stats.ping_slot_periodicity);
+    const uint64_t now = to_network_time(_channel.now());
+    const uint64_t current = now / SIM_NS_BEACON_PERIOD;
+
+    // first free ping slot of the current or the next beacon period
+    for (uint64_t period = current; period <= current + 1; period++) {
+        const uint32_t beacon_time = SIM_NS_GPS_TIME + period * SIM_NS_BEACON_PERIOD / 1000;
+
+        for (uint32_t slot = ping_offset(beacon_time, device.dev_addr, ping_period);
+                slot < BEACON_WINDOW_SLOTS; slot += ping_period) {
+            const uint64_t start = period * SIM_NS_BEACON_PERIOD + SIM_NS_BEACON_RESERVED
+                                   + slot * SIM_NS_PING_SLOT;
+            if (start > now && _channel.transmit_at(down, to_sim_time(start))) {
+                device.stats.ping_slot_downlinks++;
+                downlink_sent(device);
+                return;
+            }
+        }
+    }
+
+    device.stats.missed_downlinks++;
+}
+
+bool SimNetworkServer::schedule(const uint8_t *payload, uint8_t size,
+                                const sim_uplink_t &uplink, uint32_t rx1_delay, bool rx2)
+{
+    const sim_frame_t &up = *uplink.frame;
+    sim_frame_t down;
+
+    memcpy(down.payload, payload, size);
+    down.size = size;
+    down.modem = up.modem;
+    down.preamble_len = 8;
+    down.power = SIM_GATEWAY_TX_POWER;
+    down.iq_inverted = true;
+    down.public_network = up.public_network;
+    down.sender = NULL;
+
+    // RX1, same channel and data rate as the uplink
+    down.frequency = up.frequency;
+    down.datarate = up.datarate;
+    down.bandwidth = up.bandwidth;
+    if (_channel.transmit_at(down, up.end + rx1_delay)) {
+        return true;
+    }
+
+    if (!rx2) {
+        return false;
+    }
+
+    // RX2
+    down.modem = MODEM_LORA;
+    down.frequency = SIM_NS_RX2_FREQUENCY;
+    down.datarate = 12 - SIM_NS_RX2_DATARATE;
+    down.bandwidth = 125000;
+    return _channel.transmit_at(down, up.end + rx1_delay + 1000);
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIM_NETWORK_SERVER_H
+#define SIM_NETWORK_SERVER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "SimChannel.h"
+
+/*
+ * Minimal LoRaWAN 1.0.2 network server behind a single EU868 gateway.
+ *
+ * It handles OTAA joins, verifies and decrypts uplinks, answers the MAC
+ * commands of the devices, runs a simple ADR algorithm and sends the
+ * downlinks in RX1, falling back to RX2 when the gateway is busy. Its
+ * crypto is written against mbedTLS directly so that it does not share
+ * code with the stack under test.
+ *
+ * The gateway can also send Class B beacons on a network clock drifting
+ * against the simulated one, which stands for the drift of the device
+ * clocks. Downlinks to Class B devices go in their next ping slot.
+ */
+
+/** Uplinks the ADR algorithm looks at. */
+#define SIM_NS_ADR_HISTORY          20
+
+/** Installation margin of the ADR algorithm, in dB. */
+#define SIM_NS_ADR_MARGIN           10
+
+#define SIM_NS_RX1_DELAY            1000
+#define SIM_NS_JOIN_ACCEPT_DELAY1   5000
+#define SIM_NS_RX2_FREQUENCY        869525000
+#define SIM_NS_RX2_DATARATE         0
+
+#define SIM_NS_BEACON_PERIOD        128000
+#define SIM_NS_BEACON_RESERVED      2120
+#define SIM_NS_PING_SLOT            30
+#define SIM_NS_BEACON_FREQUENCY     869525000
+/** DR3 */
+#define SIM_NS_BEACON_SF            9
+#define SIM_NS_BEACON_PREAMBLE      10
+/** GPS time at the start of the simulation, a multiple of the beacon period. */
+#define SIM_NS_GPS_TIME             1281312000
+
+typedef struct sim_ns_device_stats_s {
+    uint32_t joins;
+    uint32_t joined_at;
+    /** Valid data uplinks, repetitions included. */
+    uint32_t uplinks;
+    uint32_t duplicates;
+    uint32_t mic_failures;
+    /** Application payloads delivered once each. */
+    uint32_t delivered;
+    uint32_t delivered_bytes;
+    uint32_t downlinks;
+    uint32_t missed_downlinks;
+    uint32_t downlink_acks;
+    uint32_t link_checks;
+    uint32_t adr_requests;
+    uint32_t adr_accepted;
+    uint32_t dev_status_answers;
+    uint32_t beacon_timing_answers;
+    /** Class B bit of the last uplink. */
+    bool class_b;
+    uint8_t ping_slot_periodicity;
+    uint32_t ping_slot_downlinks;
+    uint8_t battery;
+    int8_t margin;
+    int8_t last_snr;
+    /** Data rate of the last uplink. */
+    uint8_t datarate;
+} sim_ns_device_stats_t;
+
+class SimNetworkServer {
+public:
+    SimNetworkServer(SimChannel &channel);
+
+    /** Provisions a device for OTAA.
+     *
+     * @return  Index of the device in the server.
+     */
+    int add_device(const uint8_t *dev_eui, const uint8_t *app_eui, const uint8_t *app_key);
+
+    /** Enables the ADR algorithm for the devices which request it.
+     *
+     * @param history   Number of uplinks looked at before adapting.
+     */
+    void set_adr(bool enable, uint8_t history = SIM_NS_ADR_HISTORY);
+
+    /** Receiver of the application payloads. */
+    void set_application_handler(mbed::Callback<void(int, uint8_t, const uint8_t *, uint8_t)> handler);
+
+    /** Queues an application downlink, sent after the next uplink.
+     *
+     * @return  false if the device has not joined or a downlink is
+     *          already queued.
+     */
+    bool send(int device, uint8_t port, const uint8_t *data, uint8_t size, bool confirmed);
+
+    /** Queues a DevStatusReq MAC command. */
+    void request_device_status(int device);
+
+    /** Starts sending beacons.
+     *
+     * @param drift     Drift of the network clock against the simulated
+     *                  one, in ppm.
+     */
+    void start_beacons(int32_t drift = 0);
+
+    /** Suspends or resumes the beacons, the network clock keeps running. */
+    void set_beacons_enabled(bool enabled);
+
+    uint32_t beacons() const
+    {
+        return _beacons;
+    }
+
+    const sim_ns_device_stats_t &get_device_stats(int device) const;
+
+    /** Application payloads delivered by all the devices. */
+    uint32_t delivered() const;
+
+    bool joined(int device) const;
+
+    uint32_t dev_addr(int device) const;
+
+private:
+    struct device_t {
+        uint8_t dev_eui[8];
+        uint8_t app_eui[8];
+        uint8_t app_key[16];
+        uint8_t nwk_skey[16];
+        uint8_t app_skey[16];
+        uint32_t dev_addr;
+        bool joined;
+        bool has_uplink;
+        bool beacon_timing_req;
+        uint32_t fcnt_up;
+        uint32_t fcnt_down;
+
+        /* MAC commands for the next downlink */
+        uint8_t mac_commands[15];
+        uint8_t mac_commands_len;
+
+        /* queued application downlink */
+        bool app_pending;
+        bool app_confirmed;
+        uint8_t app_port;
+        uint8_t app_payload[242];
+        uint8_t app_size;
+
+        /* ADR state */
+        int8_t snr_history[255];
+        uint8_t snr_count;
+        uint8_t tx_power;
+        bool adr_pending;
+        uint8_t adr_datarate;
+        uint8_t adr_tx_power;
+
+        sim_ns_device_stats_t stats;
+    };
+
+    void on_uplink(const sim_uplink_t &uplink);
+    void handle_join_request(const sim_uplink_t &uplink);
+    void handle_data_frame(const sim_uplink_t &uplink);
+    void handle_mac_commands(device_t &device, const uint8_t *commands, uint8_t size,
+                             const sim_uplink_t &uplink);
+    void run_adr(device_t &device, const sim_uplink_t &uplink);
+    void add_mac_command(device_t &device, const uint8_t *command, uint8_t size);
+    void send_downlink(device_t &device, const sim_uplink_t &uplink, bool ack);
+    void send_ping_slot_downlink(device_t &device);
+    uint8_t build_downlink(device_t &device, bool ack, uint8_t *frame);
+    void downlink_sent(device_t &device);
+    bool schedule(const uint8_t *payload, uint8_t size, const sim_uplink_t &uplink,
+                  uint32_t rx1_delay, bool rx2 = true);
+
+    void schedule_beacon();
+    void send_beacon(uint64_t period);
+    uint32_t to_sim_time(uint64_t network_time) const;
+    uint64_t to_network_time(uint32_t sim_time) const;
+    static uint16_t ping_offset(uint32_t beacon_time, uint32_t dev_addr, uint16_t ping_period);
+
+    static uint8_t datarate(const sim_frame_t &frame);
+
+    SimChannel &_channel;
+    std::vector<device_t> _devices;
+    mbed::Callback<void(int, uint8_t, const uint8_t *, uint8_t)> _app_handler;
+    bool _adr_enabled;
+    uint8_t _adr_history;
+    uint32_t _app_nonce;
+    uint32_t _next_dev_addr;
+
+    bool _beacons_started;
+    bool _beacons_enabled;
+    int32_t _clock_drift;
+    /** Next beacon period, counted on the network clock. */
+    uint64_t _beacon_period;
+    uint32_t _beacons;
+};
+
+#endif // SIM_NETWORK_SERVER_H
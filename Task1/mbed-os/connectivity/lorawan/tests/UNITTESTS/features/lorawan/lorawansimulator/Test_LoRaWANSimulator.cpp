@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string.h>
+#include <vector>
+
+#include "SimChannel.h"
+#include "SimDevice.h"
+#include "SimNetworkServer.h"
+
+using namespace std::chrono;
+
+#define HOUR            (3600 * 1000)
+#define MINUTE          (60 * 1000)
+
+/* path losses giving SNRs of +15 (clamped), 0 and -9 dB at 13 dBm */
+#define NEAR            100
+#define MIDDLE          130
+#define FAR             139
+
+class Test_LoRaWANSimulator : public testing::Test {
+protected:
+    events::EventQueue *queue;
+    SimChannel *channel;
+    SimNetworkServer *server;
+    std::vector<SimDevice *> devices;
+    std::vector<int> indices;
+
+    virtual void SetUp()
+    {
+        queue = new events::EventQueue(1024 * EVENTS_EVENT_SIZE);
+        channel = new SimChannel(*queue, 1);
+        server = new SimNetworkServer(*channel);
+    }
+
+    virtual void TearDown()
+    {
+        for (size_t i = 0; i < devices.size(); i++) {
+            delete devices[i];
+        }
+        devices.clear();
+        indices.clear();
+        delete server;
+        delete channel;
+        delete queue;
+    }
+
+    SimDevice &add_device(float path_loss)
+    {
+        SimDevice *device = new SimDevice(*channel, devices.size() + 1);
+        device->radio().set_path_loss(path_loss);
+        devices.push_back(device);
+        indices.push_back(server->add_device(device->dev_eui(), device->app_eui(),
+                                             device->app_key()));
+        return *device;
+    }
+
+    void run(uint32_t duration)
+    {
+        queue->dispatch_for(milliseconds(duration));
+    }
+
+    /* runs in steps of one second until all the devices joined */
+    bool join_all(uint32_t timeout)
+    {
+        const uint32_t start = channel->now();
+
+        while (channel->now() - start < timeout) {
+            bool joined = true;
+            for (size_t i = 0; i < devices.size(); i++) {
+                joined = joined && devices[i]->get_stats().joined;
+            }
+            if (joined) {
+                return true;
+            }
+            run(1000);
+        }
+        return false;
+    }
+
+    /* energy of all the radios, in mJ */
+    float energy()
+    {
+        float total = 0;
+        for (size_t i = 0; i < devices.size(); i++) {
+            total += devices[i]->radio().energy();
+        }
+        return total;
+    }
+
+    void report(const char *scenario, uint32_t delivered, uint32_t duration, float energy_used)
+    {
+        const float hours = (float) duration / HOUR;
+        const float average_ua = energy_used / 3.3f / (duration / 1000.0f) * 1000
+                                 / devices.size();
+
+        printf("[ BENCH    ] %s: %.0f packets/h, %.1f mJ/packet, %.1f uA average per device\n",
+               scenario, delivered / hours, delivered ? energy_used / delivered : 0.0f,
+               average_ua);
+    }
+};
+
+TEST_F(Test_LoRaWANSimulator, otaa_join)
+{
+    SimDevice &device = add_device(MIDDLE);
+
+    const uint32_t start = channel->now();
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+
+    EXPECT_TRUE(server->joined(indices[0]));
+    EXPECT_EQ(1U, server->get_device_stats(indices[0]).joins);
+
+    // JOIN_ACCEPT_DELAY1 after the end of the join request
+    const uint32_t join_time = device.get_stats().joined_at - start;
+    EXPECT_GE(join_time, 5000U);
+    EXPECT_LT(join_time, 7000U);
+
+    printf("[ BENCH    ] join: %u ms, %.2f mJ\n", join_time, device.radio().energy());
+}
+
+TEST_F(Test_LoRaWANSimulator, uplink_payloads)
+{
+    struct receiver_t {
+        uint32_t count;
+        bool in_order;
+
+        void on_payload(int device, uint8_t port, const uint8_t *data, uint8_t size)
+        {
+            in_order = in_order && port == 15 && size == 8 && data[0] == (uint8_t) count
+                       && data[7] == (uint8_t)(count + 7);
+            count++;
+        }
+    } receiver = { 0, true };
+
+    SimDevice &device = add_device(MIDDLE);
+    server->set_application_handler(mbed::callback(&receiver, &receiver_t::on_payload));
+
+    device.start_traffic(30000, 8, false);
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+    run(10 * MINUTE);
+
+    EXPECT_EQ(device.get_stats().sent, receiver.count);
+    EXPECT_GE(receiver.count, 15U);
+    EXPECT_TRUE(receiver.in_order);
+    EXPECT_EQ(0U, channel->get_stats().collisions);
+}
+
+/*
+ * A single device sending back to back: with the three default EU868
+ * channels in one 1 % sub-band, at most 36 s of airtime per hour.
+ */
+TEST_F(Test_LoRaWANSimulator, duty_cycle_throughput)
+{
+    const uint8_t datarates[] = { DR_0, DR_3, DR_5 };
+
+    for (uint8_t datarate : datarates) {
+        TearDown();
+        SetUp();
+
+        SimDevice &device = add_device(MIDDLE);
+        device.set_link_settings(false, datarate);
+        ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+        ASSERT_TRUE(join_all(MINUTE));
+
+        const float start_energy = energy();
+        const uint32_t start_airtime = device.radio().get_stats().tx_time;
+        const uint32_t start_delivered = server->delivered();
+
+        device.start_traffic(0, 12, false);
+        run(HOUR);
+        device.stop_traffic();
+
+        const uint32_t delivered = server->delivered() - start_delivered;
+        const uint32_t airtime = device.radio().get_stats().tx_time - start_airtime;
+        const uint32_t toa = SimChannel::time_on_air(MODEM_LORA, 125000, 12 - datarate, 8,
+                                                     12 + LORA_MAC_FRMPAYLOAD_OVERHEAD);
+
+        EXPECT_LE(airtime, HOUR / 100 + toa);
+        EXPECT_GE(delivered, (HOUR / 100 / toa) * 9 / 10);
+
+        char name[64];
+        snprintf(name, sizeof(name), "duty cycle DR%u, %u ms airtime", datarate, airtime);
+        report(name, delivered, HOUR, energy() - start_energy);
+    }
+}
+
+TEST_F(Test_LoRaWANSimulator, adr_convergence)
+{
+    const float path_losses[] = { NEAR, MIDDLE, FAR };
+    const uint8_t expected[] = { DR_5, DR_3, DR_0 };
+
+    for (uint8_t i = 0; i < 3; i++) {
+        TearDown();
+        SetUp();
+
+        server->set_adr(true, 10);
+
+        SimDevice &device = add_device(path_losses[i]);
+        device.set_link_settings(true, DR_0);
+        device.start_traffic(0, 12, false);
+        ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+        ASSERT_TRUE(join_all(MINUTE));
+
+        const uint32_t start = channel->now();
+        uint32_t converged = 0;
+        while (channel->now() - start < 2 * HOUR) {
+            run(10000);
+            if (!converged && device.datarate() == expected[i]) {
+                converged = channel->now() - start;
+            }
+        }
+
+        const sim_ns_device_stats_t &stats = server->get_device_stats(indices[0]);
+        EXPECT_EQ(expected[i], device.datarate());
+        EXPECT_EQ(expected[i], stats.datarate);
+        EXPECT_EQ(stats.adr_requests, stats.adr_accepted);
+
+        printf("[ BENCH    ] ADR path loss %.0f dB: DR%u after %u s, %u requests, %.0f packets/h\n",
+               path_losses[i], stats.datarate, converged / 1000, stats.adr_requests,
+               stats.delivered / 2.0f);
+    }
+}
+
+/*
+ * Devices reporting every minute on the same data rate, so that only the
+ * channel hopping of the stack spreads them.
+ */
+TEST_F(Test_LoRaWANSimulator, collisions)
+{
+    const uint8_t nb_devices = 40;
+
+    for (uint8_t i = 0; i < nb_devices; i++) {
+        SimDevice &device = add_device(NEAR + (i % 8) * 4);
+        device.set_link_settings(false, DR_3);
+        device.start_traffic(MINUTE, 20, false);
+        queue->call_in(milliseconds(i * 1500), &device, &SimDevice::join);
+    }
+    ASSERT_TRUE(join_all(10 * MINUTE));
+
+    const uint32_t start_delivered = server->delivered();
+    uint32_t start_sent = 0;
+    for (size_t i = 0; i < devices.size(); i++) {
+        start_sent += devices[i]->get_stats().sent;
+    }
+    const float start_energy = energy();
+
+    run(HOUR);
+
+    uint32_t sent = 0;
+    for (size_t i = 0; i < devices.size(); i++) {
+        sent += devices[i]->get_stats().sent;
+    }
+    sent -= start_sent;
+    const uint32_t delivered = server->delivered() - start_delivered;
+    const sim_channel_stats_t &stats = channel->get_stats();
+
+    EXPECT_GT(stats.collisions, 0U);
+    EXPECT_LT(delivered, sent);
+    EXPECT_GT(delivered, sent / 2);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%u devices, %.1f %% delivered, %u collisions",
+             nb_devices, 100.0f * delivered / sent, stats.collisions);
+    report(name, delivered, HOUR, energy() - start_energy);
+}
+
+TEST_F(Test_LoRaWANSimulator, confirmed_with_loss)
+{
+    SimDevice &device = add_device(MIDDLE);
+    device.radio().set_loss_rate(0.3f);
+    device.set_link_settings(false, DR_5);
+    device.start_traffic(MINUTE, 12, true);
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(10 * MINUTE));
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().set_confirmed_msg_retry(4));
+
+    const uint32_t start_delivered = server->delivered();
+    const uint32_t start_sent = device.get_stats().sent;
+    const float start_energy = energy();
+
+    run(HOUR);
+
+    const uint32_t sent = device.get_stats().sent - start_sent;
+    const uint32_t delivered = server->delivered() - start_delivered;
+    const sim_ns_device_stats_t &stats = server->get_device_stats(indices[0]);
+
+    EXPECT_GT(stats.duplicates, 0U);
+    EXPECT_GE(delivered, sent * 9 / 10);
+    EXPECT_GT(device.get_stats().tx_done, 0U);
+
+    char name[64];
+    snprintf(name, sizeof(name), "confirmed, 30 %% loss, %u retransmissions", stats.duplicates);
+    report(name, delivered, HOUR, energy() - start_energy);
+}
+
+TEST_F(Test_LoRaWANSimulator, downlink_and_mac_commands)
+{
+    SimDevice &device = add_device(MIDDLE);
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+
+    const uint8_t hello[5] = { 'h', 'e', 'l', 'l', 'o' };
+    EXPECT_TRUE(server->send(indices[0], 2, hello, sizeof(hello), false));
+    server->request_device_status(indices[0]);
+    EXPECT_EQ(LORAWAN_STATUS_OK, device.request_link_check());
+
+    device.start_traffic(30000, 4, false);
+    run(2 * MINUTE);
+
+    const sim_device_stats_t &stats = device.get_stats();
+    EXPECT_EQ(1U, stats.rx_done);
+    EXPECT_EQ(2, device.rx_port());
+    EXPECT_EQ(0, memcmp(hello, device.rx_data(), sizeof(hello)));
+
+    // the request stays in every uplink until removed
+    EXPECT_GE(stats.link_checks, 1U);
+    EXPECT_GT(stats.link_check_margin, 0);
+
+    const sim_ns_device_stats_t &ns_stats = server->get_device_stats(indices[0]);
+    EXPECT_EQ(stats.link_checks, ns_stats.link_checks);
+    EXPECT_EQ(1U, ns_stats.dev_status_answers);
+    EXPECT_EQ(0U, ns_stats.missed_downlinks);
+}
+
+TEST_F(Test_LoRaWANSimulator, class_b_without_beacons)
+{
+    SimDevice &device = add_device(MIDDLE);
+    ASSERT_EQ(LORAWAN_STATUS_NO_ACTIVE_SESSIONS, device.stack().set_device_class(CLASS_B));
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+
+    // the gateway sends no beacon and does not answer BeaconTimingReq
+    EXPECT_EQ(LORAWAN_STATUS_OK, device.stack().set_device_class(CLASS_B));
+    EXPECT_EQ(LORAWAN_STATUS_BUSY, device.stack().set_ping_slot_periodicity(3));
+    run(3 * SIM_NS_BEACON_PERIOD);
+
+    EXPECT_EQ(1U, device.get_stats().beacons_not_found);
+    EXPECT_EQ(0U, device.get_stats().beacon_locks);
+    EXPECT_EQ(LORAWAN_STATUS_OK, device.stack().set_ping_slot_periodicity(3));
+}
+
+TEST_F(Test_LoRaWANSimulator, class_b_ping_slot_latency)
+{
+    SimDevice &device = add_device(MIDDLE);
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+
+    server->start_beacons();
+    // 16 ping slots per beacon period, 7.68 s apart
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().set_ping_slot_periodicity(3));
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().set_device_class(CLASS_B));
+    run(2 * SIM_NS_BEACON_PERIOD + MINUTE);
+
+    const sim_ns_device_stats_t &ns_stats = server->get_device_stats(indices[0]);
+    ASSERT_EQ(1U, device.get_stats().beacon_locks);
+    EXPECT_TRUE(device.get_stats().ping_slot_info_synched);
+    EXPECT_EQ(1U, ns_stats.beacon_timing_answers);
+    EXPECT_EQ(3, ns_stats.ping_slot_periodicity);
+    ASSERT_TRUE(ns_stats.class_b);
+
+    uint32_t total = 0;
+    uint32_t worst = 0;
+    const uint8_t count = 20;
+
+    for (uint8_t i = 0; i < count; i++) {
+        // downlinks at random times, without any uplink
+        run(1000 + channel->random() % 20000);
+
+        const uint32_t rx_done = device.get_stats().rx_done;
+        const uint32_t sent_at = channel->now();
+        const uint8_t data[4] = { 'p', 'i', 'n', 'g' };
+        ASSERT_TRUE(server->send(indices[0], 3, data, sizeof(data), false));
+
+        while (device.get_stats().rx_done == rx_done && channel->now() - sent_at < MINUTE) {
+            run(10);
+        }
+        ASSERT_EQ(rx_done + 1, device.get_stats().rx_done);
+        EXPECT_EQ(0, memcmp(data, device.rx_data(), sizeof(data)));
+
+        const uint32_t latency = device.get_stats().rx_at - sent_at;
+        total += latency;
+        worst = std::max(worst, latency);
+    }
+
+    // one ping period, plus the beacon guard and reserved periods when a
+    // beacon comes in between, plus the frame
+    EXPECT_LT(worst, 7680U + 5120 + 200);
+    EXPECT_EQ(count, ns_stats.ping_slot_downlinks);
+    EXPECT_EQ(0U, ns_stats.missed_downlinks);
+
+    lorawan_class_b_status_t status;
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().acquire_class_b_status(status));
+    EXPECT_TRUE(status.synchronised);
+    EXPECT_EQ(0U, status.beacons_missed);
+    EXPECT_EQ(7680U, status.ping_period);
+
+    printf("[ BENCH    ] class B, ping period 7.68 s: %u ms average latency, %u ms worst\n",
+           total / count, worst);
+}
+
+TEST_F(Test_LoRaWANSimulator, class_b_drift_compensation)
+{
+    SimDevice &device = add_device(MIDDLE);
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+
+    // the device clock is 80 ppm slower than the network one
+    server->start_beacons(80);
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().set_ping_slot_periodicity(4));
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().set_device_class(CLASS_B));
+    run(8 * SIM_NS_BEACON_PERIOD);
+
+    lorawan_class_b_status_t status;
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().acquire_class_b_status(status));
+    ASSERT_TRUE(status.synchronised);
+    EXPECT_EQ(0U, status.beacons_missed);
+    EXPECT_NEAR(-80, status.drift, 10);
+
+    // the ping slots keep up on the local clock while the beacons are gone
+    server->set_beacons_enabled(false);
+    const uint8_t data[2] = { 0xB0, 0x0B };
+    const uint32_t start_rx = device.get_stats().rx_done;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        run(5 * MINUTE);
+        EXPECT_TRUE(server->send(indices[0], 4, data, sizeof(data), false));
+    }
+    run(MINUTE);
+
+    EXPECT_EQ(start_rx + 6, device.get_stats().rx_done);
+    EXPECT_EQ(0U, device.get_stats().class_b_losses);
+    EXPECT_GE(device.get_stats().beacon_misses, 14U);
+
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().acquire_class_b_status(status));
+    EXPECT_TRUE(status.synchronised);
+    EXPECT_LT(status.window_widening, 50);
+
+    printf("[ BENCH    ] class B, 80 ppm clock: %d ppm measured, %u ms widening after %u "
+           "missed beacons\n", status.drift, status.window_widening, status.beacons_missed);
+}
+
+TEST_F(Test_LoRaWANSimulator, class_b_beacon_loss)
+{
+    SimDevice &device = add_device(MIDDLE);
+    ASSERT_EQ(LORAWAN_STATUS_CONNECT_IN_PROGRESS, device.join());
+    ASSERT_TRUE(join_all(MINUTE));
+
+    server->start_beacons();
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().set_device_class(CLASS_B));
+    run(3 * SIM_NS_BEACON_PERIOD);
+    ASSERT_EQ(1U, device.get_stats().beacon_locks);
+
+    server->set_beacons_enabled(false);
+    run(2 * HOUR + 2 * SIM_NS_BEACON_PERIOD);
+
+    EXPECT_EQ(1U, device.get_stats().class_b_losses);
+
+    lorawan_class_b_status_t status;
+    ASSERT_EQ(LORAWAN_STATUS_OK, device.stack().acquire_class_b_status(status));
+    EXPECT_FALSE(status.synchronised);
+
+    // back in Class A, uplinks still go through
+    const uint32_t delivered = server->delivered();
+    device.start_traffic(MINUTE, 4, false);
+    run(10 * MINUTE);
+    EXPECT_GT(server->delivered(), delivered);
+    EXPECT_FALSE(server->get_device_stats(indices[0]).class_b);
+}
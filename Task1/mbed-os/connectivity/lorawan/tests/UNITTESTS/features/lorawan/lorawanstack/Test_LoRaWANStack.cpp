@@ -433,6 +433,36 @@ TEST_F(Test_LoRaWANStack, handle_tx)
 
 }
 
+TEST_F(Test_LoRaWANStack, handle_queued_tx)
+{
+    uint8_t data[4] = { 1, 2, 3, 4 };
+    lorawan_uplink_options_t options;
+    options.priority = 0;
+    options.deadline = 0;
+    options.aggregate = false;
+    EXPECT_TRUE(LORAWAN_STATUS_NOT_INITIALIZED == object->handle_queued_tx(1, data, 4, 0x01, options));
+
+    EventQueue queue;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->initialize_mac_layer(&queue));
+
+    EXPECT_TRUE(LORAWAN_STATUS_PARAMETER_INVALID == object->handle_queued_tx(1, NULL, 0, 0x01, options));
+    EXPECT_TRUE(LORAWAN_STATUS_NO_ACTIVE_SESSIONS == object->handle_queued_tx(1, data, 4, 0x01, options));
+
+    lorawan_connect_t conn;
+    conn.connect_type = LORAWAN_CONNECTION_ABP;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->connect(conn));
+
+    EXPECT_TRUE(LORAWAN_STATUS_PORT_INVALID == object->handle_queued_tx(0, data, 4, 0x01, options));
+    EXPECT_TRUE(LORAWAN_STATUS_PARAMETER_INVALID == object->handle_queued_tx(1, data, 4, 0x04, options));
+
+    // the message is queued even while a TX is ongoing
+    LoRaMac_stub::bool_value = true;
+    EXPECT_EQ(4, object->handle_queued_tx(1, data, 4, 0x01, options));
+
+    lorawan_uplink_queue_stats_t stats;
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->acquire_uplink_queue_stats(stats));
+}
+
 TEST_F(Test_LoRaWANStack, handle_rx)
 {
     uint8_t port;
@@ -601,8 +631,16 @@ TEST_F(Test_LoRaWANStack, set_device_class)
     EXPECT_TRUE(LORAWAN_STATUS_OK == object->initialize_mac_layer(&queue));
 
     LoRaMac_stub::status_value = LORAWAN_STATUS_OK;
+    LoRaMac_stub::bool_value = false;
     EXPECT_TRUE(LORAWAN_STATUS_UNSUPPORTED == object->set_device_class(CLASS_B));
 
+    // supported by the PHY, but not joined
+    LoRaMac_stub::bool_value = true;
+    LoRaMac_stub::bool_false_counter = 1;
+    EXPECT_TRUE(LORAWAN_STATUS_NO_ACTIVE_SESSIONS == object->set_device_class(CLASS_B));
+
+    EXPECT_TRUE(LORAWAN_STATUS_OK == object->set_device_class(CLASS_B));
+
     EXPECT_TRUE(LORAWAN_STATUS_OK == object->set_device_class(CLASS_A));
 }
 
@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2021, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "LoRaRadio.h"
+#include "LoRaWANUplinkQueue.h"
+
+static lorawan_uplink_options_t options(uint8_t priority, uint32_t deadline = 0,
+                                        bool aggregate = false)
+{
+    lorawan_uplink_options_t opts;
+    opts.priority = priority;
+    opts.deadline = deadline;
+    opts.aggregate = aggregate;
+    return opts;
+}
+
+class Test_LoRaWANUplinkQueue : public testing::Test {
+protected:
+    LoRaWANUplinkQueue *object;
+    uint8_t frame[MBED_CONF_LORA_TX_MAX_SIZE];
+    uint8_t port;
+    uint8_t flags;
+
+    virtual void SetUp()
+    {
+        object = new LoRaWANUplinkQueue();
+    }
+
+    virtual void TearDown()
+    {
+        delete object;
+    }
+
+    lorawan_status_t push(uint8_t tag, uint16_t length, const lorawan_uplink_options_t &opts,
+                          lorawan_time_t now = 0, uint8_t fport = 1,
+                          uint8_t fflags = MSG_UNCONFIRMED_FLAG)
+    {
+        uint8_t data[MBED_CONF_LORA_TX_MAX_SIZE];
+        memset(data, tag, sizeof(data));
+        return object->push(fport, data, length, fflags, opts, now);
+    }
+
+    /* tag of the next frame, sent successfully */
+    int next(uint8_t max_size = 51, lorawan_time_t now = 0)
+    {
+        int16_t size = object->build_frame(frame, max_size, port, flags);
+        if (size <= 0) {
+            return -1;
+        }
+        object->commit_frame(now);
+        object->complete_frame(true, now, 0);
+        return frame[0];
+    }
+};
+
+TEST_F(Test_LoRaWANUplinkQueue, constructor)
+{
+    EXPECT_TRUE(object);
+    EXPECT_TRUE(object->empty());
+    EXPECT_FALSE(object->frame_in_flight());
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, priority_order)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(3)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 4, options(0)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(3, 4, options(3)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(4, 4, options(1)));
+    EXPECT_EQ(4, object->size());
+
+    EXPECT_EQ(2, next());
+    EXPECT_EQ(4, next());
+    EXPECT_EQ(1, next());
+    EXPECT_EQ(3, next());
+    EXPECT_EQ(-1, next());
+    EXPECT_EQ(4U, object->get_stats().sent);
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, deadline_order)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(1)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 4, options(1, 5000)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(3, 4, options(1, 1000)));
+
+    EXPECT_EQ(3, next());
+    EXPECT_EQ(2, next());
+    EXPECT_EQ(1, next());
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, expire)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(1, 1000), 100));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 4, options(1, 5000), 100));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(3, 4, options(1), 100));
+
+    object->expire(1099);
+    EXPECT_EQ(3, object->size());
+    object->expire(1100);
+    EXPECT_EQ(2, object->size());
+    EXPECT_EQ(1U, object->get_stats().expired);
+
+    EXPECT_EQ(2, next());
+    EXPECT_EQ(3, next());
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, aggregation)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 20, options(2, 0, true)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 20, options(2, 0, true), 0, 2));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(3, 20, options(1, 0, true)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(4, 20, options(2, 0, false)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(5, 10, options(2, 0, true)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(6, 4, options(3, 0, true), 0, 1, MSG_CONFIRMED_FLAG));
+
+    // 3 leads, then 1 and 5 for port 1 fit in 51 bytes
+    EXPECT_EQ(50, object->build_frame(frame, 51, port, flags));
+    EXPECT_EQ(1, port);
+    EXPECT_EQ(MSG_UNCONFIRMED_FLAG, flags);
+    EXPECT_EQ(3, frame[0]);
+    EXPECT_EQ(1, frame[20]);
+    EXPECT_EQ(5, frame[40]);
+    object->commit_frame(0);
+    EXPECT_TRUE(object->frame_in_flight());
+    EXPECT_EQ(3, object->size());
+    object->complete_frame(true, 0, 0);
+
+    EXPECT_EQ(20, object->build_frame(frame, 51, port, flags));
+    EXPECT_EQ(2, port);
+    object->commit_frame(0);
+    object->complete_frame(true, 0, 0);
+
+    // not aggregatable
+    EXPECT_EQ(20, object->build_frame(frame, 51, port, flags));
+    EXPECT_EQ(4, frame[0]);
+    object->commit_frame(0);
+    object->complete_frame(true, 0, 0);
+
+    EXPECT_EQ(4, object->build_frame(frame, 51, port, flags));
+    EXPECT_EQ(MSG_CONFIRMED_FLAG, flags);
+    object->commit_frame(0);
+    object->complete_frame(true, 0, 0);
+
+    EXPECT_EQ(6U, object->get_stats().queued);
+    EXPECT_EQ(6U, object->get_stats().sent);
+    EXPECT_EQ(4U, object->get_stats().frames);
+    EXPECT_EQ(2U, object->get_stats().aggregated);
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, build_does_not_remove)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(1)));
+
+    // the MAC layer refused the frame, it is rebuilt later
+    EXPECT_EQ(4, object->build_frame(frame, 51, port, flags));
+    EXPECT_FALSE(object->frame_in_flight());
+    EXPECT_EQ(1, object->size());
+    EXPECT_EQ(1, next());
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, too_large)
+{
+    EXPECT_EQ(LORAWAN_STATUS_PARAMETER_INVALID, push(1, MBED_CONF_LORA_TX_MAX_SIZE + 1, options(1)));
+
+    // does not fit the current data rate
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 100, options(0)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 10, options(1)));
+    EXPECT_EQ(2, next(51));
+    EXPECT_EQ(1U, object->get_stats().dropped);
+    EXPECT_TRUE(object->empty());
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, eviction)
+{
+    for (int i = 0; i < MBED_CONF_LORA_UPLINK_QUEUE_SIZE; i++) {
+        EXPECT_EQ(LORAWAN_STATUS_OK, push(10 + i, 4, options(2)));
+    }
+
+    EXPECT_EQ(LORAWAN_STATUS_WOULD_BLOCK, push(1, 4, options(2)));
+    EXPECT_EQ(LORAWAN_STATUS_WOULD_BLOCK, push(1, 4, options(3)));
+
+    // evicts the most recent message of the lowest priority
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(0)));
+    EXPECT_EQ(1U, object->get_stats().dropped);
+    EXPECT_EQ(MBED_CONF_LORA_UPLINK_QUEUE_SIZE, object->size());
+
+    EXPECT_EQ(1, next());
+    for (int i = 0; i < MBED_CONF_LORA_UPLINK_QUEUE_SIZE - 1; i++) {
+        EXPECT_EQ(10 + i, next());
+    }
+    EXPECT_TRUE(object->empty());
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, buffer_compaction)
+{
+    const uint16_t large = MBED_CONF_LORA_UPLINK_QUEUE_BUFFER_SIZE / 4;
+
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, large, options(2)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, large, options(1)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(3, large, options(2)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(4, large, options(2)));
+    EXPECT_EQ(LORAWAN_STATUS_WOULD_BLOCK, push(5, 1, options(2)));
+
+    // frees room in the middle of the buffer
+    EXPECT_EQ(2, next(255));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(5, large, options(2)));
+
+    for (int tag = 1; tag <= 5; tag++) {
+        if (tag == 2) {
+            continue;
+        }
+        ASSERT_EQ(large, object->build_frame(frame, 255, port, flags));
+        for (uint16_t i = 0; i < large; i++) {
+            ASSERT_EQ(tag, frame[i]);
+        }
+        object->commit_frame(0);
+        object->complete_frame(true, 0, 0);
+    }
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, latency_and_airtime)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(1, 0, true), 1000));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 4, options(1, 0, true), 3000));
+
+    EXPECT_EQ(8, object->build_frame(frame, 51, port, flags));
+    object->commit_frame(4000);
+    object->complete_frame(true, 6000, 400);
+
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(3, 4, options(1)));
+    EXPECT_EQ(4, object->build_frame(frame, 51, port, flags));
+    object->commit_frame(7000);
+    object->complete_frame(false, 9000, 300);
+
+    lorawan_uplink_queue_stats_t stats = object->get_stats();
+    EXPECT_EQ(2U, stats.sent);
+    EXPECT_EQ(1U, stats.dropped);
+    EXPECT_EQ(2U, stats.frames);
+    EXPECT_EQ(1U, stats.aggregated);
+    EXPECT_EQ(700U, stats.airtime);
+    EXPECT_EQ(5000U + 3000U, stats.latency_total);
+    EXPECT_EQ(5000U, stats.latency_max);
+
+    object->reset_stats();
+    EXPECT_EQ(0U, object->get_stats().frames);
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, clear)
+{
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(1, 4, options(1)));
+    EXPECT_EQ(LORAWAN_STATUS_OK, push(2, 4, options(1)));
+    EXPECT_EQ(4, object->build_frame(frame, 51, port, flags));
+    object->commit_frame(0);
+
+    object->clear();
+    EXPECT_TRUE(object->empty());
+    EXPECT_FALSE(object->frame_in_flight());
+    EXPECT_EQ(2U, object->get_stats().dropped);
+}
+
+/*
+ * Radio model for the simulation: records the transmissions and computes
+ * their time on air as the SX127x drivers do.
+ */
+class FakeRadio : public LoRaRadio {
+public:
+    FakeRadio() : sf(7), bandwidth(0), coderate(1), preamble_len(8), crc_on(true),
+        frames(0), airtime(0)
+    {
+    }
+
+    virtual void init_radio(radio_events_t *) {}
+    virtual void radio_reset() {}
+    virtual void sleep(void) {}
+    virtual void standby(void) {}
+    virtual void set_rx_config(radio_modems_t, uint32_t, uint32_t, uint8_t, uint32_t,
+                               uint16_t, uint16_t, bool, uint8_t, bool, bool, uint8_t,
+                               bool, bool) {}
+
+    virtual void set_tx_config(radio_modems_t, int8_t, uint32_t, uint32_t bw, uint32_t datarate,
+                               uint8_t cr, uint16_t preamble, bool, bool crc, bool, uint8_t,
+                               bool, uint32_t)
+    {
+        sf = datarate;
+        bandwidth = bw;
+        coderate = cr;
+        preamble_len = preamble;
+        crc_on = crc;
+    }
+
+    virtual void send(uint8_t *, uint8_t size)
+    {
+        frames++;
+        airtime += time_on_air(MODEM_LORA, size);
+    }
+
+    virtual void receive(void) {}
+    virtual void set_channel(uint32_t) {}
+    virtual uint32_t random(void)
+    {
+        return 0;
+    }
+    virtual uint8_t get_status(void)
+    {
+        return 0;
+    }
+    virtual void set_max_payload_length(radio_modems_t, uint8_t) {}
+    virtual void set_public_network(bool) {}
+
+    virtual uint32_t time_on_air(radio_modems_t, uint8_t pkt_len)
+    {
+        const double bw_hz = 125e3 * (1 << bandwidth);
+        const double symbol = (1 << sf) / bw_hz;
+        const int low_dr_optimize = (symbol > 0.016) ? 1 : 0;
+        const double preamble = (preamble_len + 4.25) * symbol;
+        const double num = 8.0 * pkt_len - 4.0 * sf + 28 + 16 * crc_on;
+        const double den = 4.0 * (sf - 2 * low_dr_optimize);
+        const double symbols = 8 + std::max(std::ceil(num / den) * (coderate + 4), 0.0);
+
+        return (uint32_t) std::floor((preamble + symbols * symbol) * 1000 + 0.999);
+    }
+
+    virtual bool perform_carrier_sense(radio_modems_t, uint32_t, int16_t, uint32_t)
+    {
+        return true;
+    }
+    virtual void start_cad(void) {}
+    virtual bool check_rf_frequency(uint32_t)
+    {
+        return true;
+    }
+    virtual void set_tx_continuous_wave(uint32_t, int8_t, uint16_t) {}
+    virtual void lock(void) {}
+    virtual void unlock(void) {}
+
+    uint32_t sf;
+    uint32_t bandwidth;
+    uint8_t coderate;
+    uint16_t preamble_len;
+    bool crc_on;
+
+    uint32_t frames;
+    uint32_t airtime;
+};
+
+/*
+ * One hour of a sensor reporting 6 byte readings every 15 s, and an urgent
+ * 2 byte alarm every 5 min, at DR3 of EU868 (SF9, 115 byte payloads) under
+ * the 1 % duty cycle. Each frame is transmitted as soon as the duty cycle
+ * allows, and its class A receive windows are over 2 s after the TX.
+ */
+static void simulate(bool aggregate, FakeRadio &radio, lorawan_uplink_queue_stats_t &stats)
+{
+    const uint8_t frame_overhead = 13;
+    const uint32_t duration = 3600 * 1000;
+    LoRaWANUplinkQueue queue;
+    uint8_t frame[MBED_CONF_LORA_TX_MAX_SIZE + 13];
+    uint8_t reading[6] = {};
+    uint8_t alarm[2] = {};
+    lorawan_time_t next_tx = 0;
+    lorawan_time_t done = 0;
+    uint32_t toa = 0;
+    uint8_t port;
+    uint8_t flags;
+
+    radio.set_tx_config(MODEM_LORA, 14, 0, 0, 9, 1, 8, false, true, false, 0, false, 3000);
+
+    for (lorawan_time_t now = 0; now < duration; now += 10) {
+        if (now % 15000 == 0) {
+            queue.push(2, reading, sizeof(reading), MSG_UNCONFIRMED_FLAG,
+                       options(2, 0, aggregate), now);
+        }
+        if (now % 300000 == 7000) {
+            queue.push(2, alarm, sizeof(alarm), MSG_UNCONFIRMED_FLAG,
+                       options(0, 0, aggregate), now);
+        }
+
+        if (queue.frame_in_flight() && now >= done) {
+            queue.complete_frame(true, now, toa);
+        }
+
+        if (queue.frame_in_flight() || now < next_tx) {
+            continue;
+        }
+
+        queue.expire(now);
+        int16_t size = queue.build_frame(frame, 115, port, flags);
+        if (size < 0) {
+            continue;
+        }
+        queue.commit_frame(now);
+
+        toa = radio.time_on_air(MODEM_LORA, frame_overhead + size);
+        radio.send(frame, frame_overhead + size);
+        done = now + toa + 2000;
+        next_tx = now + toa * 100;
+    }
+
+    stats = queue.get_stats();
+}
+
+TEST_F(Test_LoRaWANUplinkQueue, simulation)
+{
+    FakeRadio separate_radio;
+    FakeRadio aggregated_radio;
+    lorawan_uplink_queue_stats_t separate;
+    lorawan_uplink_queue_stats_t aggregated;
+
+    simulate(false, separate_radio, separate);
+    simulate(true, aggregated_radio, aggregated);
+
+    printf("[ SIM      ] separate:   %u sent, %u dropped, %u frames, %u ms on air, "
+           "latency avg %u ms max %u ms\n", separate.sent, separate.dropped + separate.expired,
+           separate_radio.frames, separate_radio.airtime,
+           separate.sent ? separate.latency_total / separate.sent : 0, separate.latency_max);
+    printf("[ SIM      ] aggregated: %u sent, %u dropped, %u frames, %u ms on air, "
+           "latency avg %u ms max %u ms\n", aggregated.sent, aggregated.dropped + aggregated.expired,
+           aggregated_radio.frames, aggregated_radio.airtime,
+           aggregated.sent ? aggregated.latency_total / aggregated.sent : 0,
+           aggregated.latency_max);
+
+    // SF9, 125 kHz, 6 byte reading in a 19 byte frame
+    EXPECT_EQ(186U, separate_radio.time_on_air(MODEM_LORA, 19));
+
+    EXPECT_EQ(aggregated_radio.airtime, aggregated.airtime);
+    EXPECT_EQ(0U, aggregated.dropped);
+    EXPECT_LT(aggregated_radio.frames, separate_radio.frames);
+    EXPECT_LT(aggregated_radio.airtime, separate_radio.airtime);
+    EXPECT_GT(aggregated.sent, separate.sent);
+    EXPECT_LT(aggregated.latency_total / aggregated.sent, separate.latency_total / separate.sent);
+}
@@ -22,6 +22,7 @@
 #include "NanostackRfPhy.h"
 #include "Nanostack.h"
 #include "mesh_interface_types.h"
+#include "ns_event_loop_profiler.h"
 
 class Nanostack::Interface : public OnboardNetworkStack::Interface, private mbed::NonCopyable<Nanostack::Interface> {
 public:
@@ -177,6 +178,28 @@ public:
      */
     nsapi_error_t initialize(NanostackRfPhy *phy);
 
+    /** Read the event loop profile
+     *
+     *  The event loop is shared by all interfaces, so is the profile.
+     *  Profiling is enabled with nanostack-hal.event-loop-profiler.
+     *
+     *  @param profile  Profile read
+     *  @return         0 on success, NSAPI_ERROR_UNSUPPORTED if profiling is not enabled
+     */
+    nsapi_error_t read_event_loop_profile(ns_event_loop_profile_t *profile);
+
+    /** Reset the event loop profile
+     *
+     *  @return         0 on success, NSAPI_ERROR_UNSUPPORTED if profiling is not enabled
+     */
+    nsapi_error_t reset_event_loop_profile();
+
+    /** Print the event loop profile with mbed-trace
+     *
+     *  @return         0 on success, NSAPI_ERROR_UNSUPPORTED if profiling is not enabled
+     */
+    nsapi_error_t trace_event_loop_profile();
+
 protected:
     MeshInterfaceNanostack() = default;
     MeshInterfaceNanostack(NanostackRfPhy *phy) : _phy(phy) { }
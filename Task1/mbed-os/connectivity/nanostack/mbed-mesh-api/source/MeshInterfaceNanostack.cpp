@@ -165,6 +165,43 @@ nsapi_error_t MeshInterfaceNanostack::initialize(NanostackRfPhy *phy)
     }
 }
 
+nsapi_error_t MeshInterfaceNanostack::read_event_loop_profile(ns_event_loop_profile_t *profile)
+{
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+    if (!profile) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    NanostackLockGuard lock;
+    ns_event_loop_profile_read(profile);
+    return NSAPI_ERROR_OK;
+#else
+    (void) profile;
+    return NSAPI_ERROR_UNSUPPORTED;
+#endif
+}
+
+nsapi_error_t MeshInterfaceNanostack::reset_event_loop_profile()
+{
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+    NanostackLockGuard lock;
+    ns_event_loop_profile_reset();
+    return NSAPI_ERROR_OK;
+#else
+    return NSAPI_ERROR_UNSUPPORTED;
+#endif
+}
+
+nsapi_error_t MeshInterfaceNanostack::trace_event_loop_profile()
+{
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+    NanostackLockGuard lock;
+    ns_event_loop_profile_trace();
+    return NSAPI_ERROR_OK;
+#else
+    return NSAPI_ERROR_UNSUPPORTED;
+#endif
+}
+
 void Nanostack::Interface::network_handler(mesh_connection_status_t status)
 {
     if (_blocking) {
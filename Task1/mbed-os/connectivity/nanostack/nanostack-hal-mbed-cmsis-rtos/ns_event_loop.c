@@ -27,6 +27,7 @@
 
 #include "ns_event_loop_mutex.h"
 #include "ns_event_loop.h"
+#include "ns_event_loop_profiler.h"
 
 #define TRACE_GROUP "evlp"
 
@@ -72,6 +73,7 @@ void eventOS_scheduler_signal(void)
     // XXX why does signal set lock if called with irqs disabled?
     //__enable_irq();
     //tr_debug("signal %p", (void*)event_thread_id);
+    ns_event_loop_profiler_signal();
 #if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_DISPATCH_FROM_APPLICATION
     osEventFlagsSet(event_flag_id, 1);
 #else
@@ -83,6 +85,7 @@ void eventOS_scheduler_signal(void)
 void eventOS_scheduler_idle(void)
 {
     //tr_debug("idle");
+    ns_event_loop_profiler_idle();
     eventOS_scheduler_mutex_release();
 
 #if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_DISPATCH_FROM_APPLICATION
@@ -99,7 +102,16 @@ static void event_loop_thread(void *arg)
 {
     (void)arg;
     eventOS_scheduler_mutex_wait();
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+    // Same loop as eventOS_scheduler_run(), through the profiler
+    for (;;) {
+        if (!ns_event_loop_profiler_dispatch()) {
+            eventOS_scheduler_idle();
+        }
+    }
+#else
     eventOS_scheduler_run(); //Does not return
+#endif
 }
 #endif
 
@@ -31,6 +31,7 @@
 #include "events/Event.h"
 #include "ns_event_loop_mutex.h"
 #include "ns_event_loop.h"
+#include "ns_event_loop_profiler.h"
 
 #define TRACE_GROUP "evlp"
 
@@ -47,6 +48,9 @@ void eventOS_scheduler_signal(void)
 {
     platform_enter_critical();
     if (started && event_pending == 0) {
+        // Profiled wait is the time the dispatch spends in the shared queue
+        ns_event_loop_profiler_idle();
+        ns_event_loop_profiler_signal();
         event_pending = event->post();
         MBED_ASSERT(event_pending != 0);
     }
@@ -68,7 +72,7 @@ static void do_dispatch_with_mutex_held()
      * others on the global queue.
      */
     eventOS_scheduler_mutex_wait();
-    bool dispatched = eventOS_scheduler_dispatch_event();
+    bool dispatched = ns_event_loop_profiler_dispatch();
     eventOS_scheduler_mutex_release();
 
     /* Go round again if (potentially) more */
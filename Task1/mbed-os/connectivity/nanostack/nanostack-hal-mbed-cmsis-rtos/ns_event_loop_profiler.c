@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <inttypes.h>
+#include "hal/us_ticker_api.h"
+#include "platform/mbed_critical.h"
+#include "ns_trace.h"
+
+#include "eventOS_event.h"
+#include "eventOS_scheduler.h"
+
+#include "ns_event_loop_profiler.h"
+
+#define TRACE_GROUP "evlp"
+
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+
+#ifndef MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_EVENTS
+#define MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_EVENTS 100
+#endif
+
+#ifndef MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_WINDOW
+#define MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_WINDOW 100
+#endif
+
+#define PROFILER_OTHER MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_TASKLETS
+
+/* Tasklet handlers wrapped to tell the profiler who runs */
+#define PROFILER_HANDLERS 16
+
+#if defined(TOOLCHAIN_GCC)
+#define SUPER_HANDLER_CREATE    __real_eventOS_event_handler_create
+#define SUB_HANDLER_CREATE      __wrap_eventOS_event_handler_create
+#elif defined(TOOLCHAIN_ARM) || defined(__ICCARM__)
+#define SUPER_HANDLER_CREATE    $Super$$eventOS_event_handler_create
+#define SUB_HANDLER_CREATE      $Sub$$eventOS_event_handler_create
+#endif
+
+static const uint32_t profiler_bucket_limits[NS_EVENT_LOOP_PROFILER_BUCKETS - 1] = {50, 200, 1000, 5000, 20000};
+
+typedef struct profiler_storm {
+    uint32_t window_start;
+    uint32_t events;
+} profiler_storm_t;
+
+static ns_event_loop_profile_t profile;
+static profiler_storm_t profiler_storm[PROFILER_OTHER + 1];
+static uint32_t profiler_wake_events;
+
+/* Receiver of the event being dispatched, -1 until its handler runs */
+static int8_t profiler_tasklet;
+
+/* Written by the signal, possibly from interrupt */
+static volatile bool profiler_idle;
+static volatile bool profiler_signalled;
+static volatile uint32_t profiler_signal_time;
+
+static uint_fast8_t profiler_bucket(uint32_t time_us)
+{
+    uint_fast8_t i;
+    for (i = 0; i < NS_EVENT_LOOP_PROFILER_BUCKETS - 1; i++) {
+        if (time_us < profiler_bucket_limits[i]) {
+            break;
+        }
+    }
+    return i;
+}
+
+static void profiler_storm_check(int8_t tasklet, uint_fast8_t index, uint32_t now)
+{
+    profiler_storm_t *storm = &profiler_storm[index];
+
+    if (now - storm->window_start >= MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_WINDOW * 1000) {
+        storm->window_start = now;
+        storm->events = 0;
+    }
+    // Reported once per window
+    if (++storm->events == MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_EVENTS) {
+        profile.tasklet[index].storms++;
+        tr_warn("Event storm: tasklet %d, %d events in %d ms", tasklet,
+                MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_EVENTS,
+                MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_STORM_WINDOW);
+    }
+}
+
+#ifdef SUB_HANDLER_CREATE
+static void (*profiler_tasklet_handler[PROFILER_HANDLERS])(arm_event_t *);
+
+static void profiler_handler_run(uint_fast8_t n, arm_event_t *event)
+{
+    profiler_tasklet = event->receiver;
+    profiler_tasklet_handler[n](event);
+}
+
+/* Each tasklet needs a handler of its own, the scheduler rejects duplicates */
+#define PROFILER_HANDLER(n) \
+    static void profiler_handler_##n(arm_event_t *event) \
+    { \
+        profiler_handler_run(n, event); \
+    }
+
+PROFILER_HANDLER(0)
+PROFILER_HANDLER(1)
+PROFILER_HANDLER(2)
+PROFILER_HANDLER(3)
+PROFILER_HANDLER(4)
+PROFILER_HANDLER(5)
+PROFILER_HANDLER(6)
+PROFILER_HANDLER(7)
+PROFILER_HANDLER(8)
+PROFILER_HANDLER(9)
+PROFILER_HANDLER(10)
+PROFILER_HANDLER(11)
+PROFILER_HANDLER(12)
+PROFILER_HANDLER(13)
+PROFILER_HANDLER(14)
+PROFILER_HANDLER(15)
+
+static void (*const profiler_handler[PROFILER_HANDLERS])(arm_event_t *) = {
+    profiler_handler_0, profiler_handler_1, profiler_handler_2, profiler_handler_3,
+    profiler_handler_4, profiler_handler_5, profiler_handler_6, profiler_handler_7,
+    profiler_handler_8, profiler_handler_9, profiler_handler_10, profiler_handler_11,
+    profiler_handler_12, profiler_handler_13, profiler_handler_14, profiler_handler_15,
+};
+
+int8_t SUPER_HANDLER_CREATE(void (*handler_func_ptr)(arm_event_t *), uint8_t init_event_type);
+
+/* Tasklets get a profiler handler that notes the receiver and calls theirs.
+ * The ones created after the profiler handlers run out are profiled together
+ * with the tasklets without an entry.
+ */
+int8_t SUB_HANDLER_CREATE(void (*handler_func_ptr)(arm_event_t *), uint8_t init_event_type)
+{
+    int_fast8_t free_n = -1;
+
+    for (uint_fast8_t n = 0; n < PROFILER_HANDLERS; n++) {
+        // Already registered, the scheduler would say the same
+        if (profiler_tasklet_handler[n] == handler_func_ptr) {
+            return -1;
+        }
+        if (!profiler_tasklet_handler[n] && free_n < 0) {
+            free_n = n;
+        }
+    }
+    if (free_n < 0) {
+        return SUPER_HANDLER_CREATE(handler_func_ptr, init_event_type);
+    }
+
+    profiler_tasklet_handler[free_n] = handler_func_ptr;
+    int8_t tasklet = SUPER_HANDLER_CREATE(profiler_handler[free_n], init_event_type);
+    if (tasklet < 0) {
+        profiler_tasklet_handler[free_n] = NULL;
+    }
+    return tasklet;
+}
+#endif
+
+bool ns_event_loop_profiler_dispatch(void)
+{
+    if (profiler_signalled) {
+        core_util_critical_section_enter();
+        uint32_t wait_time = us_ticker_read() - profiler_signal_time;
+        profiler_signalled = false;
+        core_util_critical_section_exit();
+
+        profile.wake_ups++;
+        profile.wait_time_histogram[profiler_bucket(wait_time)]++;
+        if (wait_time > profile.wait_time_max_us) {
+            profile.wait_time_max_us = wait_time;
+        }
+        profiler_wake_events = 0;
+    }
+
+    profiler_tasklet = -1;
+    uint32_t start = us_ticker_read();
+    if (!eventOS_scheduler_dispatch_event()) {
+        return false;
+    }
+
+    uint32_t end = us_ticker_read();
+    uint32_t run_time = end - start;
+    int8_t tasklet = profiler_tasklet;
+    uint_fast8_t index = tasklet >= 0 && tasklet < PROFILER_OTHER ? tasklet : PROFILER_OTHER;
+    ns_event_loop_tasklet_profile_t *tasklet_profile = &profile.tasklet[index];
+
+    profile.events++;
+    profile.run_time_us += run_time;
+    if (++profiler_wake_events > profile.wake_events_max) {
+        profile.wake_events_max = profiler_wake_events;
+    }
+
+    tasklet_profile->events++;
+    tasklet_profile->run_time_us += run_time;
+    tasklet_profile->run_time_histogram[profiler_bucket(run_time)]++;
+    if (run_time > tasklet_profile->run_time_max_us) {
+        tasklet_profile->run_time_max_us = run_time;
+    }
+
+    profiler_storm_check(tasklet, index, end);
+    return true;
+}
+
+void ns_event_loop_profiler_idle(void)
+{
+    core_util_critical_section_enter();
+    profiler_idle = true;
+    core_util_critical_section_exit();
+}
+
+void ns_event_loop_profiler_signal(void)
+{
+    core_util_critical_section_enter();
+    if (profiler_idle) {
+        profiler_idle = false;
+        profiler_signalled = true;
+        profiler_signal_time = us_ticker_read();
+    }
+    core_util_critical_section_exit();
+}
+
+void ns_event_loop_profile_read(ns_event_loop_profile_t *profile_out)
+{
+    *profile_out = profile;
+}
+
+void ns_event_loop_profile_reset(void)
+{
+    memset(&profile, 0, sizeof(profile));
+    memset(profiler_storm, 0, sizeof(profiler_storm));
+    profiler_wake_events = 0;
+}
+
+void ns_event_loop_profile_trace(void)
+{
+    tr_info("Event loop: %"PRIu32" events, run time %"PRIu32" ms, %"PRIu32" wake-ups, max %"PRIu32" events per wake-up",
+            profile.events, (uint32_t)(profile.run_time_us / 1000), profile.wake_ups, profile.wake_events_max);
+    tr_info("Wake-up wait <50 <200 <1000 <5000 <20000 more us: %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32", max %"PRIu32" us",
+            profile.wait_time_histogram[0], profile.wait_time_histogram[1], profile.wait_time_histogram[2],
+            profile.wait_time_histogram[3], profile.wait_time_histogram[4], profile.wait_time_histogram[5],
+            profile.wait_time_max_us);
+
+    // Tasklet -1 stands for the ones without an entry of their own
+    for (uint_fast8_t i = 0; i <= PROFILER_OTHER; i++) {
+        const ns_event_loop_tasklet_profile_t *tasklet_profile = &profile.tasklet[i];
+        if (!tasklet_profile->events) {
+            continue;
+        }
+        tr_info("Tasklet %d: %"PRIu32" events, run time %"PRIu32" us, max %"PRIu32" us, runs %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32", storms %"PRIu32,
+                i < PROFILER_OTHER ? (int) i : -1,
+                tasklet_profile->events, (uint32_t) tasklet_profile->run_time_us, tasklet_profile->run_time_max_us,
+                tasklet_profile->run_time_histogram[0], tasklet_profile->run_time_histogram[1],
+                tasklet_profile->run_time_histogram[2], tasklet_profile->run_time_histogram[3],
+                tasklet_profile->run_time_histogram[4], tasklet_profile->run_time_histogram[5],
+                tasklet_profile->storms);
+    }
+}
+
+#endif // MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
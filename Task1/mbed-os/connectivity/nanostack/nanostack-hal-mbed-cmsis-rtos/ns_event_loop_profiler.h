@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NS_EVENT_LOOP_PROFILER_H_
+#define NS_EVENT_LOOP_PROFILER_H_
+
+/*
+ * Event loop profiler.
+ *
+ * Enabled with nanostack-hal.event-loop-profiler. The event loop thread, or
+ * the Mbed OS event queue, then dispatches through
+ * ns_event_loop_profiler_dispatch(), which counts the events and the run
+ * time of each tasklet, and the time from a wake-up signal to the dispatch
+ * of the first event. A tasklet getting more events than
+ * event-loop-profiler-storm-events in event-loop-profiler-storm-window
+ * milliseconds is reported as an event storm.
+ *
+ * Events are charged to the tasklet whose handler runs. The profiler wraps
+ * eventOS_event_handler_create() to hand the scheduler a handler of its own
+ * that notes the receiver, so the GCC link needs
+ * --wrap=eventOS_event_handler_create, which the CMake build adds. Without
+ * it, all events are charged to the entry of the tasklets without one.
+ *
+ * An application dispatching events itself can call
+ * ns_event_loop_profiler_dispatch() instead of
+ * eventOS_scheduler_dispatch_event().
+ *
+ * When disabled, the profiler compiles to plain event dispatch.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eventOS_scheduler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+#define MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER 0
+#endif
+
+#ifndef MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_TASKLETS
+#define MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_TASKLETS 16
+#endif
+
+/* Histogram bucket upper limits are 50, 200, 1000, 5000 and 20000 us, the last one is unbounded */
+#define NS_EVENT_LOOP_PROFILER_BUCKETS 6
+
+typedef struct ns_event_loop_tasklet_profile {
+    uint32_t events;                                            /*<! Events dispatched */
+    uint32_t storms;                                            /*<! Event storms detected */
+    uint64_t run_time_us;                                       /*<! Total handler run time */
+    uint32_t run_time_max_us;                                   /*<! Longest handler run */
+    uint32_t run_time_histogram[NS_EVENT_LOOP_PROFILER_BUCKETS]; /*<! Handler runs by run time */
+} ns_event_loop_tasklet_profile_t;
+
+typedef struct ns_event_loop_profile {
+    uint32_t events;                                            /*<! Events dispatched */
+    uint32_t wake_ups;                                          /*<! Wake-ups of an idle event loop */
+    uint32_t wake_events_max;                                   /*<! Most events dispatched in one wake-up */
+    uint32_t wait_time_max_us;                                  /*<! Longest time from wake-up signal to dispatch */
+    uint32_t wait_time_histogram[NS_EVENT_LOOP_PROFILER_BUCKETS]; /*<! Wake-ups by time from signal to dispatch */
+    uint64_t run_time_us;                                       /*<! Total handler run time */
+    /* Tasklets by ID; the last entry collects the IDs that do not fit and events without a tasklet */
+    ns_event_loop_tasklet_profile_t tasklet[MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_TASKLETS + 1];
+} ns_event_loop_profile_t;
+
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER
+
+/* Dispatches one event, as eventOS_scheduler_dispatch_event(). Called with the scheduler mutex held. */
+bool ns_event_loop_profiler_dispatch(void);
+
+/* Event loop is about to wait for a signal */
+void ns_event_loop_profiler_idle(void);
+
+/* Event loop signalled, may be called from interrupt */
+void ns_event_loop_profiler_signal(void);
+
+/* Copy of the profile, called with the scheduler mutex held */
+void ns_event_loop_profile_read(ns_event_loop_profile_t *profile);
+
+void ns_event_loop_profile_reset(void);
+
+/* Prints the profile with mbed-trace */
+void ns_event_loop_profile_trace(void);
+
+#else
+
+#define ns_event_loop_profiler_dispatch() eventOS_scheduler_dispatch_event()
+#define ns_event_loop_profiler_idle() ((void) 0)
+#define ns_event_loop_profiler_signal() ((void) 0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NS_EVENT_LOOP_PROFILER_H_ */
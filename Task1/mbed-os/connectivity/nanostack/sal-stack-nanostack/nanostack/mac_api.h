@@ -328,6 +328,9 @@ struct mac_api_s {
     uint16_t                            phyMTU;                         /**< Maximum Transmission Unit(MTU) used by MAC*/
 };
 
+/** Number of time ranges in the MAC queue time histogram. */
+#define MAC_STATISTICS_QUEUE_TIME_BUCKETS 5
+
 /**
  * \struct mac_statistics_s
  * \brief MAC statistics structure.
@@ -349,6 +352,9 @@ typedef struct mac_statistics_s {
     uint32_t mac_cca_attempts_count;    /**< MAC CCA attempts count. */
     uint32_t mac_failed_cca_count;      /**< MAC failed CCA count. */
     uint32_t mac_tx_latency_max;        /**< MAC data request max latency. */
+    uint16_t mac_indirect_queue_size;   /**< MAC indirect queue current size. */
+    uint16_t mac_indirect_queue_peak;   /**< MAC indirect queue peak size. */
+    uint32_t mac_tx_queue_time[MAC_STATISTICS_QUEUE_TIME_BUCKETS]; /**< MAC data requests by time queued before transmission: under 10 ms, 100 ms, 1 s, 10 s, and longer. */
 } mac_statistics_t;
 
 #ifdef __cplusplus
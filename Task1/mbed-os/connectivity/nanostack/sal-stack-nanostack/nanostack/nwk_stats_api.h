@@ -75,6 +75,10 @@ typedef struct nwk_stats_t {
     uint16_t adapt_layer_tx_queue_peak; /**< Adaptation layer direct TX queue size peak. */
     uint32_t adapt_layer_tx_congestion_drop; /**< Adaptation layer direct TX randon early detection drop packet. */
     uint16_t adapt_layer_tx_latency_max; /**< Adaptation layer latency between TX request and TX ready in seconds (MAX). */
+    /* Fragment reassembly */
+    uint32_t frag_rx_complete;      /**< Datagrams reassembled. */
+    uint32_t frag_rx_timeout;       /**< Reassemblies timed out, also counted in frag_rx_errors. */
+    uint32_t frag_rx_early_drop;    /**< Reassemblies dropped early to make room for a new datagram. */
 } nwk_stats_t;
 
 /**
@@ -40,15 +40,37 @@
 
 #define TRACE_GROUP "6frg"
 
-typedef struct {
-    uint16_t ttl;   /*!< Reassembly timer (seconds) */
+/* Memory for reassembly buffers per interface, as datagram bytes per session.
+ * Sessions share the total, so a larger datagram fits while others are
+ * smaller, and a datagram of the largest size always fits. 0 for no limit
+ * other than the number of sessions.
+ */
+#ifndef REASSEMBLY_SESSION_MEMORY
+#define REASSEMBLY_SESSION_MEMORY LOWPAN_MTU
+#endif
+
+/* A session is stalled, and goes first when room is needed, when the other
+ * sessions have received this many fragments per session since its last one.
+ * Senders transmit the fragments of a datagram back to back, so a stalled
+ * session has most likely lost one and will only time out.
+ */
+#ifndef REASSEMBLY_STALL_FRAGMENTS
+#define REASSEMBLY_STALL_FRAGMENTS 8
+#endif
+
+typedef struct reassembly_entry {
+    uint32_t expiry;    /*!< Interface time the reassembly times out (seconds) */
     uint16_t tag;   /*!< Fragmentation datagram TAG ID */
     uint16_t size;  /*!< Datagram Total Size (uncompressed) */
     uint16_t orig_size; /*!< Datagram Original Size (compressed) */
     uint16_t frag_max;  /*!< Maximum fragment size (MAC payload) */
     uint16_t offset; /*!< Data offset from datagram start */
+    uint16_t received; /*!< Bytes of the datagram received */
+    uint16_t last_frag; /*!< Interface fragment count at the last fragment */
+    bool end_received; /*!< Got the end of the datagram, the holes are left behind */
     int16_t pattern; /*!< Size of compressed LoWPAN headers */
     buffer_t *buf;
+    struct reassembly_entry *hash_next; /*!< Next in the hash bucket */
     ns_list_link_t      link; /*!< List link entry */
 } reassembly_entry_t;
 
@@ -56,10 +78,17 @@ typedef NS_LIST_HEAD(reassembly_entry_t, link) reassembly_list_t;
 
 typedef struct {
     int8_t interface_id;
+    uint8_t hash_mask;
     uint16_t timeout;
-    reassembly_list_t rx_list;
+    uint16_t stall_fragments;
+    uint16_t frag_count;    /*!< Fragments received for sessions, wraps */
+    uint32_t time;          /*!< Seconds since init */
+    uint32_t memory_used;   /*!< Bytes of reassembly buffers */
+    uint32_t memory_limit;
+    reassembly_list_t rx_list; /*!< Newest first, so in order of expiry from the end */
     reassembly_list_t free_list;
     reassembly_entry_t *entry_pointer_buffer;
+    reassembly_entry_t **hash; /*!< Sessions by source, tag and size */
     ns_list_link_t      link; /*!< List link entry */
 } reassembly_interface_t;
 
@@ -210,13 +239,48 @@ static reassembly_interface_t *reassembly_interface_discover(int8_t interfaceId)
     return NULL;
 }
 
-static void reassembly_entry_free(reassembly_interface_t *interface_ptr, reassembly_entry_t *entry)
+/* Reassembly buffer for a datagram, see cipv6_frag_reassembly() */
+static uint16_t reassembly_buffer_size(uint16_t datagram_size)
+{
+    return 1 + ((datagram_size + 7) & ~7);
+}
+
+static reassembly_entry_t **reassembly_hash_bucket(const reassembly_interface_t *interface_ptr, const sockaddr_t *src, uint16_t tag, uint16_t size)
+{
+    uint_fast16_t hash = tag ^ size;
+    uint_fast8_t len = addr_len_from_type(src->addr_type);
+
+    /* Type will be either long or short 802.15.4 - we skip the PAN ID */
+    for (uint_fast8_t i = 2; i < len; i++) {
+        hash = hash * 31 + src->address[i];
+    }
+
+    return &interface_ptr->hash[(hash ^ (hash >> 8)) & interface_ptr->hash_mask];
+}
+
+/* Returns the entry to the free list, and its buffer to the caller */
+static buffer_t *reassembly_entry_release(reassembly_interface_t *interface_ptr, reassembly_entry_t *entry)
 {
+    buffer_t *buf = entry->buf;
+
     ns_list_remove(&interface_ptr->rx_list, entry);
     ns_list_add_to_start(&interface_ptr->free_list, entry);
-    if (entry->buf) {
-        entry->buf = buffer_free(entry->buf);
+    if (buf) {
+        for (reassembly_entry_t **p = reassembly_hash_bucket(interface_ptr, &buf->src_sa, entry->tag, entry->size); *p; p = &(*p)->hash_next) {
+            if (*p == entry) {
+                *p = entry->hash_next;
+                break;
+            }
+        }
+        interface_ptr->memory_used -= reassembly_buffer_size(entry->size);
+        entry->buf = NULL;
     }
+    return buf;
+}
+
+static void reassembly_entry_free(reassembly_interface_t *interface_ptr, reassembly_entry_t *entry)
+{
+    buffer_free(reassembly_entry_release(interface_ptr, entry));
 }
 
 static void reassembly_list_free(reassembly_interface_t *interface_ptr)
@@ -227,9 +291,11 @@ static void reassembly_list_free(reassembly_interface_t *interface_ptr)
 }
 
 
-static reassembly_entry_t *reassembly_already_action(reassembly_list_t *reassembly_list, buffer_t *buf, uint16_t tag, uint16_t size)
+static reassembly_entry_t *reassembly_already_action(const reassembly_interface_t *interface_ptr, buffer_t *buf, uint16_t tag, uint16_t size)
 {
-    ns_list_foreach(reassembly_entry_t, reassembly_entry, reassembly_list) {
+    reassembly_entry_t *reassembly_entry = *reassembly_hash_bucket(interface_ptr, &buf->src_sa, tag, size);
+
+    for (; reassembly_entry; reassembly_entry = reassembly_entry->hash_next) {
         if ((reassembly_entry->tag == tag) && (reassembly_entry->size == size) &&
                 reassembly_entry->buf->src_sa.addr_type == buf->src_sa.addr_type &&
                 reassembly_entry->buf->dst_sa.addr_type == buf->dst_sa.addr_type) {
@@ -245,13 +311,74 @@ static reassembly_entry_t *reassembly_already_action(reassembly_list_t *reassemb
 
 }
 
-static reassembly_entry_t *lowpan_adaptation_reassembly_get(reassembly_interface_t *interface_ptr)
+static bool reassembly_same_source(const reassembly_entry_t *entry, const sockaddr_t *src)
 {
-    reassembly_entry_t *entry = ns_list_get_first(&interface_ptr->free_list);
-    if (!entry) {
-        return NULL;
+    return entry->buf->src_sa.addr_type == src->addr_type &&
+           memcmp(entry->buf->src_sa.address + 2, src->address + 2, addr_len_from_type(src->addr_type) - 2) == 0;
+}
+
+/* Early drop - choose a session to give up to make room for a new datagram
+ * from "src" with "remaining" bytes still to come. Stalled sessions go
+ * first: one of an earlier datagram from the same sender, as senders send
+ * one datagram at a time, otherwise the most stalled one. A session that has
+ * the end of its datagram but holes before it counts as stalled, as senders
+ * send the fragments in order. Then the session furthest from completion,
+ * the oldest of equals, if it is further than the new datagram - sessions
+ * closest to completion are kept.
+ */
+static reassembly_entry_t *reassembly_early_drop_choose(reassembly_interface_t *interface_ptr, const sockaddr_t *src, uint16_t remaining)
+{
+    reassembly_entry_t *stalled = NULL, *furthest = NULL;
+    uint16_t stalled_idle = 0;
+    bool stalled_same_source = false;
+    uint16_t furthest_remaining = remaining;
+
+    ns_list_foreach(reassembly_entry_t, entry, &interface_ptr->rx_list) {
+        uint16_t idle = interface_ptr->frag_count - entry->last_frag;
+        if (entry->end_received || idle >= interface_ptr->stall_fragments) {
+            bool same_source = reassembly_same_source(entry, src);
+            if (!stalled || (same_source && !stalled_same_source) ||
+                    (same_source == stalled_same_source && idle >= stalled_idle)) {
+                stalled = entry;
+                stalled_idle = idle;
+                stalled_same_source = same_source;
+            }
+        }
+        if (entry->size - entry->received >= furthest_remaining) {
+            furthest = entry;
+            furthest_remaining = entry->size - entry->received;
+        }
+    }
+
+    if (stalled) {
+        return stalled;
     }
+    if (furthest && furthest_remaining > remaining) {
+        return furthest;
+    }
+    return NULL;
+}
 
+/* Only a datagram seen from its first fragment may drop another session, one
+ * that starts later has lost the first and will not complete either.
+ */
+static reassembly_entry_t *lowpan_adaptation_reassembly_get(reassembly_interface_t *interface_ptr, const sockaddr_t *src, uint16_t size, uint16_t remaining, bool first)
+{
+    /* The limit always has room for a single datagram */
+    uint16_t buffer_size = reassembly_buffer_size(size);
+    while (ns_list_is_empty(&interface_ptr->free_list) ||
+            (interface_ptr->memory_limit && interface_ptr->memory_used + buffer_size > interface_ptr->memory_limit)) {
+        reassembly_entry_t *victim = first ? reassembly_early_drop_choose(interface_ptr, src, remaining) : NULL;
+        if (!victim) {
+            return NULL;
+        }
+        tr_debug("Reassembly drop: src %s size %u received %u",
+                 trace_sockaddr(&victim->buf->src_sa, true), victim->size, victim->received);
+        protocol_stats_update(STATS_FRAG_RX_EARLY_DROP, 1);
+        reassembly_entry_free(interface_ptr, victim);
+    }
+
+    reassembly_entry_t *entry = ns_list_get_first(&interface_ptr->free_list);
     ns_list_remove(&interface_ptr->free_list, entry);
     memset(entry, 0, sizeof(reassembly_entry_t));
     //Add to first
@@ -294,16 +421,16 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
      * point (we treat FRAGN with offset 0 the same as FRAG1)
      */
     buffer_data_pointer_set(buf, ptr);
-    reassembly_entry_t *frag_ptr = reassembly_already_action(&interface_ptr->rx_list, buf, datagram_tag, datagram_size);
+    reassembly_entry_t *frag_ptr = reassembly_already_action(interface_ptr, buf, datagram_tag, datagram_size);
 
     if (!frag_ptr) {
-
-        frag_ptr = lowpan_adaptation_reassembly_get(interface_ptr);
+        uint16_t remaining = datagram_size > buffer_data_length(buf) ? datagram_size - buffer_data_length(buf) : 0;
+        frag_ptr = lowpan_adaptation_reassembly_get(interface_ptr, &buf->src_sa, datagram_size, remaining, fragment_first == 0);
         if (!frag_ptr) {
             goto resassembly_error;
         }
 
-        buffer_t *reassembly_buffer = buffer_get(1 + ((datagram_size + 7) & ~7));
+        buffer_t *reassembly_buffer = buffer_get(reassembly_buffer_size(datagram_size));
         if (!reassembly_buffer) {
             //Put allocated back to free
             reassembly_entry_free(interface_ptr, frag_ptr);
@@ -319,7 +446,7 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
 
         reassembly_buffer->src_sa = buf->src_sa;
         reassembly_buffer->dst_sa = buf->dst_sa;
-        frag_ptr->ttl = interface_ptr->timeout;
+        frag_ptr->expiry = interface_ptr->time + interface_ptr->timeout;
         frag_ptr->tag = datagram_tag;
         frag_ptr->size = datagram_size;
         // Set buffer length and adjust start pointer, so it represents the
@@ -330,7 +457,13 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
         frag_ptr->offset = 0xffff;
         create_hole(reassembly_buffer, 0, datagram_size - 1, &frag_ptr->offset);
         frag_ptr->buf = reassembly_buffer;
+
+        reassembly_entry_t **bucket = reassembly_hash_bucket(interface_ptr, &buf->src_sa, datagram_tag, datagram_size);
+        frag_ptr->hash_next = *bucket;
+        *bucket = frag_ptr;
+        interface_ptr->memory_used += reassembly_buffer_size(datagram_size);
     }
+    frag_ptr->last_frag = ++interface_ptr->frag_count;
 
     /* For the first link fragment, work out and remember the "pattern"
      * (difference between6LoWPAN and IPv6 size), and also copy the buffer
@@ -392,6 +525,8 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
             protocol_stats_update(STATS_FRAG_RX_ERROR, 1);
             /* Forget previous data by marking as "all hole" */
             frag_ptr->offset = 0xffff;
+            frag_ptr->received = 0;
+            frag_ptr->end_received = false;
             create_hole(frag_ptr->buf, hole_off = hole_first = 0, hole_last = datagram_size - 1, prev_ptr = &frag_ptr->offset);
         }
 
@@ -410,6 +545,10 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
 
         /* Unlike RFC 815, we're now done. We don't allow overlaps, so we finish
          * as soon as we identify one hole that it entirely or partially fills */
+        frag_ptr->received += ipv6_size;
+        if (fragment_last == datagram_size - 1) {
+            frag_ptr->end_received = true;
+        }
         break;
     } while (hole_off != 0xffff);
 
@@ -432,9 +571,7 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
     }
 
     /* No more holes, so our reassembly is complete */
-    buf = frag_ptr->buf;
-    frag_ptr->buf = NULL;
-    reassembly_entry_free(interface_ptr, frag_ptr);
+    buf = reassembly_entry_release(interface_ptr, frag_ptr);
 
     /* Buffer start pointer is currently at the "start of uncompressed IPv6
      * packet" position. Move it either forwards or backwards to match
@@ -443,6 +580,7 @@ buffer_t *cipv6_frag_reassembly(int8_t interface_id, buffer_t *buf)
      */
     buf->buf_ptr += frag_ptr->pattern;
     buf->info = (buffer_info_t)(B_DIR_UP | B_FROM_FRAGMENTATION | B_TO_IPV6_TXRX);
+    protocol_stats_update(STATS_FRAG_RX_COMPLETE, 1);
     return buf;
 
 resassembly_error:
@@ -452,16 +590,19 @@ resassembly_error:
 
 static void reassembly_entry_timer_update(reassembly_interface_t *interface_ptr, uint16_t seconds)
 {
-    ns_list_foreach_safe(reassembly_entry_t, reassembly_entry, &interface_ptr->rx_list) {
-        if (reassembly_entry->ttl > seconds) {
-            reassembly_entry->ttl -= seconds;
-        } else {
-            protocol_stats_update(STATS_FRAG_RX_ERROR, 1);
-            tr_debug("Reassembly TO: src %s size %u",
-                     trace_sockaddr(&reassembly_entry->buf->src_sa, true),
-                     reassembly_entry->size);
-            reassembly_entry_free(interface_ptr, reassembly_entry);
+    interface_ptr->time += seconds;
+
+    /* All sessions have the same timeout, so the oldest ones at the end expire first */
+    ns_list_foreach_reverse_safe(reassembly_entry_t, reassembly_entry, &interface_ptr->rx_list) {
+        if ((int32_t)(reassembly_entry->expiry - interface_ptr->time) > 0) {
+            break;
         }
+        protocol_stats_update(STATS_FRAG_RX_ERROR, 1);
+        protocol_stats_update(STATS_FRAG_RX_TIMEOUT, 1);
+        tr_debug("Reassembly TO: src %s size %u",
+                 trace_sockaddr(&reassembly_entry->buf->src_sa, true),
+                 reassembly_entry->size);
+        reassembly_entry_free(interface_ptr, reassembly_entry);
     }
 }
 
@@ -481,9 +622,11 @@ int8_t reassembly_interface_free(int8_t interface_id)
     }
 
     ns_list_remove(&reassembly_interface_list, interface_ptr);
+    reassembly_list_free(interface_ptr);
 
     //Free Dynamic allocated entry buffer
     ns_dyn_mem_free(interface_ptr->entry_pointer_buffer);
+    ns_dyn_mem_free(interface_ptr->hash);
     ns_dyn_mem_free(interface_ptr);
 
     return 0;
@@ -500,19 +643,37 @@ int8_t reassembly_interface_init(int8_t interface_id, uint8_t reassembly_session
     //Remove old interface
     reassembly_interface_free(interface_id);
 
+    //Hash buckets, power of two at least the number of sessions
+    uint16_t hash_size = 1;
+    while (hash_size < reassembly_session_limit) {
+        hash_size <<= 1;
+    }
+
     //Allocate new
     reassembly_interface_t *interface_ptr = ns_dyn_mem_alloc(sizeof(reassembly_interface_t));
     reassembly_entry_t *reassemply_ptr = ns_dyn_mem_alloc(sizeof(reassembly_entry_t) * reassembly_session_limit);
-    if (!interface_ptr || !reassemply_ptr) {
+    reassembly_entry_t **hash = ns_dyn_mem_alloc(sizeof(reassembly_entry_t *) * hash_size);
+    if (!interface_ptr || !reassemply_ptr || !hash) {
         ns_dyn_mem_free(interface_ptr);
         ns_dyn_mem_free(reassemply_ptr);
+        ns_dyn_mem_free(hash);
         return -1;
     }
 
     memset(interface_ptr, 0, sizeof(reassembly_interface_t));
+    memset(hash, 0, sizeof(reassembly_entry_t *) * hash_size);
     interface_ptr->interface_id = interface_id;
     interface_ptr->timeout = reassembly_timeout;
+    interface_ptr->stall_fragments = REASSEMBLY_STALL_FRAGMENTS * reassembly_session_limit;
+#if REASSEMBLY_SESSION_MEMORY
+    interface_ptr->memory_limit = (uint32_t) reassembly_session_limit * reassembly_buffer_size(REASSEMBLY_SESSION_MEMORY);
+    if (interface_ptr->memory_limit < reassembly_buffer_size(LOWPAN_HARD_MTU_LIMIT)) {
+        interface_ptr->memory_limit = reassembly_buffer_size(LOWPAN_HARD_MTU_LIMIT);
+    }
+#endif
     interface_ptr->entry_pointer_buffer = reassemply_ptr;
+    interface_ptr->hash = hash;
+    interface_ptr->hash_mask = hash_size - 1;
     ns_list_init(&interface_ptr->free_list);
     ns_list_init(&interface_ptr->rx_list);
 
@@ -881,10 +881,12 @@ static void nd_update_registration(protocol_interface_info_entry_t *cur_interfac
 #ifdef HAVE_RPL
 void nd_remove_registration(protocol_interface_info_entry_t *cur_interface, addrtype_t ll_type, const uint8_t *ll_address)
 {
-    ns_list_foreach_safe(ipv6_neighbour_t, cur, &cur_interface->ipv6_neighbour_cache.list) {
-        if ((cur->type == IP_NEIGHBOUR_REGISTERED
-                || cur->type == IP_NEIGHBOUR_TENTATIVE)
-                && ipv6_neighbour_ll_addr_match(cur, ll_type, ll_address)) {
+    ipv6_neighbour_cache_t *ncache = &cur_interface->ipv6_neighbour_cache;
+    ipv6_neighbour_t *next;
+    for (ipv6_neighbour_t *cur = ipv6_neighbour_lookup_ll_addr_next(ncache, ll_type, ll_address, NULL); cur; cur = next) {
+        next = ipv6_neighbour_lookup_ll_addr_next(ncache, ll_type, ll_address, cur);
+        if (cur->type == IP_NEIGHBOUR_REGISTERED
+                || cur->type == IP_NEIGHBOUR_TENTATIVE) {
 
             ipv6_route_delete(cur->ip_address, 128, cur_interface->id, cur->ip_address,
                               ROUTE_ARO);
@@ -1697,8 +1697,12 @@ static bool mcps_data_indication_neighbor_validate(protocol_interface_info_entry
 
 void lowpan_adaptation_interface_data_ind(protocol_interface_info_entry_t *cur, const mcps_data_ind_t *data_ind)
 {
-    buffer_t *buf = buffer_get(data_ind->msduLength);
-    if (!buf || !cur) {
+    if (!cur) {
+        return;
+    }
+    // Room for decompression and for the headers added if the packet is routed on
+    buffer_t *buf = buffer_get_specific(BUFFER_DEFAULT_HEADROOM + cur->buffer_rx_headroom + buffer_link_headroom(), data_ind->msduLength, BUFFER_DEFAULT_MIN_SIZE);
+    if (!buf) {
         return;
     }
     uint8_t *ptr;
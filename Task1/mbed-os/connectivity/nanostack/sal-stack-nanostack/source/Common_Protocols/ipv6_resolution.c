@@ -224,8 +224,9 @@ bool ipv6_map_ll_to_ip_link_local(protocol_interface_info_entry_t *cur, addrtype
         return true;
     }
 
-    ns_list_foreach(ipv6_neighbour_t, n, &cur->ipv6_neighbour_cache.list) {
-        if (ipv6_neighbour_ll_addr_match(n, ll_type, ll_addr) && addr_is_ipv6_link_local(n->ip_address)) {
+    ipv6_neighbour_cache_t *ncache = &cur->ipv6_neighbour_cache;
+    for (ipv6_neighbour_t *n = ipv6_neighbour_lookup_ll_addr_next(ncache, ll_type, ll_addr, NULL); n; n = ipv6_neighbour_lookup_ll_addr_next(ncache, ll_type, ll_addr, n)) {
+        if (addr_is_ipv6_link_local(n->ip_address)) {
             memcpy(ip_addr_out, n->ip_address, 16);
             return true;
         }
@@ -22,6 +22,7 @@
 #include "nsdynmemLIB.h"
 #include "Core/include/ns_address_internal.h"
 #include "Core/include/ns_buffer.h"
+#include "Core/include/ns_mem_slab.h"
 #include "Core/include/ns_socket.h"
 #include "ns_trace.h"
 #include "platform/arm_hal_interrupt.h"
@@ -40,6 +41,9 @@
 
 volatile unsigned int buffer_count = 0;
 
+/* Largest tunnel and routing header growth of the interfaces, see protocol_core */
+static uint16_t buffer_link_extra_headroom = 0;
+
 uint8_t *(buffer_corrupt_check)(buffer_t *buf)
 {
     if (buf == NULL) {
@@ -55,9 +59,19 @@ uint8_t *(buffer_corrupt_check)(buffer_t *buf)
     return buffer_data_pointer(buf);
 }
 
+void buffer_link_headroom_set(uint16_t headroom)
+{
+    buffer_link_extra_headroom = headroom;
+}
+
+uint16_t buffer_link_headroom(void)
+{
+    return buffer_link_extra_headroom;
+}
+
 buffer_t *buffer_get(uint16_t size)
 {
-    return buffer_get_specific(BUFFER_DEFAULT_HEADROOM, size, BUFFER_DEFAULT_MIN_SIZE);
+    return buffer_get_specific(BUFFER_DEFAULT_HEADROOM + buffer_link_extra_headroom, size, BUFFER_DEFAULT_MIN_SIZE);
 }
 
 buffer_t *buffer_get_minimal(uint16_t size)
@@ -91,7 +105,7 @@ buffer_t *buffer_get_specific(uint16_t headroom, uint16_t size, uint16_t minspac
     if (total_size <= BUFFER_MAX_SIZE) {
         // Note - as well as this alloc+init, buffers can also be "realloced"
         // in buffer_headroom()
-        buf = ns_dyn_mem_temporary_alloc(sizeof(buffer_t) + total_size);
+        buf = ns_mem_slab_temporary_alloc(sizeof(buffer_t) + total_size);
     }
 
     if (buf) {
@@ -138,24 +152,25 @@ buffer_t *buffer_headroom(buffer_t *buf, uint16_t size)
 
     if (buf->size < (curr_len + size)) {
         buffer_t *restrict new_buf = NULL;
-        /* This buffer isn't big enough at all - allocate a new block */
-        // TODO - should we be giving them extra? probably
-        uint32_t new_total = (curr_len + size + 3) & ~ 3;
+        /* This buffer isn't big enough at all - allocate a new block, with
+         * room for the routing headers so that it is copied only once */
+        uint16_t extra = buffer_link_extra_headroom;
+        uint32_t new_total = (curr_len + size + extra + 3) & ~ 3;
         if (new_total <= BUFFER_MAX_SIZE) {
-            new_buf = ns_dyn_mem_temporary_alloc(sizeof(buffer_t) + new_total);
+            new_buf = ns_mem_slab_temporary_alloc(sizeof(buffer_t) + new_total);
         }
 
         if (new_buf) {
             // Copy the buffer_t header
             *new_buf = *buf;
             // Set new pointers, leaving specified headroom
-            new_buf->buf_ptr = size;
-            new_buf->buf_end = size + curr_len;
+            new_buf->buf_ptr = size + extra;
+            new_buf->buf_end = size + extra + curr_len;
             new_buf->size = new_total;
             // Copy the current data
             memcpy(buffer_data_pointer(new_buf), buffer_data_pointer(buf), curr_len);
             protocol_stats_update(STATS_BUFFER_HEADROOM_REALLOC, 1);
-            ns_dyn_mem_free(buf);
+            ns_mem_slab_free(buf, sizeof(buffer_t) + buf->size);
             buf = new_buf;
         } else {
             tr_error("HeadRoom Fail");
@@ -211,7 +226,7 @@ buffer_t *buffer_free(buffer_t *buf)
         socket_dereference(buf->socket);
         ns_dyn_mem_free(buf->predecessor);
         ns_dyn_mem_free(buf->rpl_option);
-        ns_dyn_mem_free(buf);
+        ns_mem_slab_free(buf, sizeof(buffer_t) + buf->size);
 
     } else {
         tr_error("nullp F");
@@ -262,6 +262,12 @@ extern buffer_t *buffer_get_specific(uint16_t headroom, uint16_t size, uint16_t
 /** Allocate memory for a minimal buffer (no headroom or extra space) */
 extern buffer_t *buffer_get_minimal(uint16_t size);
 
+/** Set headroom added to new buffers for headers inserted when routing them out of an interface */
+void buffer_link_headroom_set(uint16_t headroom);
+
+/** Headroom for headers inserted when routing a buffer out of an interface */
+uint16_t buffer_link_headroom(void);
+
 /** Free a buffer from the heap, and return NULL */
 extern buffer_t *buffer_free(buffer_t *buf);
 
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ns_mem_slab.h
+ * \brief Size-class allocation of the most common stack objects.
+ *
+ * With HAVE_MEM_SLAB, buffers, neighbour cache entries and MAC frames are
+ * taken from free lists of fixed size classes. The classes get their memory
+ * from nsdynmemLIB in chunks of several objects, so the heap statistics
+ * still cover all of it. Temporary and long-term allocations have classes
+ * of their own. Each object keeps a pointer to its chunk, so a free takes
+ * constant time. A chunk goes back to the heap when its last object is
+ * freed; one empty chunk of each class stays until stack GC.
+ *
+ * The slab trades heap for allocation time. In the replay of
+ * nanostack-ns-mem-slab-unittest it halves the time of an allocation, but
+ * holds more of the heap and leaves the rest of it more fragmented, so it
+ * is off by default.
+ *
+ * Without HAVE_MEM_SLAB the functions are plain nsdynmemLIB calls.
+ *
+ * The free must be given the size of the allocation.
+ */
+
+#ifndef _NS_MEM_SLAB_H
+#define _NS_MEM_SLAB_H
+
+#include "nsdynmemLIB.h"
+
+#ifdef HAVE_MEM_SLAB
+
+/* Size classes, multiples of 8 in increasing order. Larger allocations go to the heap as is. */
+#ifndef NS_MEM_SLAB_SIZES
+#define NS_MEM_SLAB_SIZES 64, 128, 192, 256, 320
+#endif
+
+/* Heap allocation of a class */
+#ifndef NS_MEM_SLAB_CHUNK_SIZE
+#define NS_MEM_SLAB_CHUNK_SIZE 2048
+#endif
+
+/* Fewest objects in a chunk, a class of larger objects gets larger chunks */
+#ifndef NS_MEM_SLAB_CHUNK_OBJECTS
+#define NS_MEM_SLAB_CHUNK_OBJECTS 4
+#endif
+
+void *ns_mem_slab_alloc(ns_mem_block_size_t size);
+
+void *ns_mem_slab_temporary_alloc(ns_mem_block_size_t size);
+
+void ns_mem_slab_free(void *block, ns_mem_block_size_t size);
+
+/* Releases the empty chunks kept by the classes */
+void ns_mem_slab_gc(bool full_gc);
+
+#else
+
+#define ns_mem_slab_alloc(size) ns_dyn_mem_alloc(size)
+#define ns_mem_slab_temporary_alloc(size) ns_dyn_mem_temporary_alloc(size)
+#define ns_mem_slab_free(block, size) ns_dyn_mem_free(block)
+#define ns_mem_slab_gc(full_gc) ((void) 0)
+
+#endif
+
+#endif /* _NS_MEM_SLAB_H */
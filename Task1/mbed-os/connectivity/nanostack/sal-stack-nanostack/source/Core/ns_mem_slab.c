@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ns_list.h"
+#include "nsdynmemLIB.h"
+#include "platform/arm_hal_interrupt.h"
+#include "Core/include/ns_mem_slab.h"
+
+#ifdef HAVE_MEM_SLAB
+
+/* Object, free or allocated. The chunk is kept in front of the block, so
+ * that the free finds it without a search.
+ */
+typedef struct ns_mem_slab_object {
+    struct ns_mem_slab_chunk *chunk;
+    struct ns_mem_slab_object *next;        /* While free, the block starts here */
+} ns_mem_slab_object_t;
+
+/* Objects keep the 8-byte alignment of the heap */
+#define NS_MEM_SLAB_ALIGN(size) (((size) + 7) & ~(size_t) 7)
+#define NS_MEM_SLAB_OBJECT_HEADER NS_MEM_SLAB_ALIGN(offsetof(ns_mem_slab_object_t, next))
+
+/* Chunk header, the objects follow it */
+typedef struct ns_mem_slab_chunk {
+    struct ns_mem_slab_class *slab_class;
+    ns_mem_slab_object_t *free_list;
+    uint16_t count;
+    uint16_t in_use;
+    ns_list_link_t link;                    /* In the class while it has free objects */
+} ns_mem_slab_chunk_t;
+
+#define NS_MEM_SLAB_CHUNK_HEADER NS_MEM_SLAB_ALIGN(sizeof(ns_mem_slab_chunk_t))
+
+/* Only the chunks with free objects are listed, allocation takes the first
+ * of them. A chunk that fills leaves the list, and one that gets room joins
+ * at the end, so the others have time to empty. A chunk that becomes empty
+ * goes back to the heap, unless it is the only one with room.
+ */
+typedef struct ns_mem_slab_class {
+    NS_LIST_HEAD(ns_mem_slab_chunk_t, link) partial;
+    uint16_t object_size;
+    uint16_t chunk_count;
+    bool temporary;
+} ns_mem_slab_class_t;
+
+static const uint16_t ns_mem_slab_sizes[] = { NS_MEM_SLAB_SIZES };
+
+#define NS_MEM_SLAB_CLASSES (sizeof(ns_mem_slab_sizes) / sizeof(ns_mem_slab_sizes[0]))
+
+/* Temporary and long-term objects get classes of their own, so that a chunk
+ * in the temporary end of the heap is not pinned by a long-lived object, nor
+ * a long-term chunk left mostly empty once the short-lived ones are gone.
+ */
+static ns_mem_slab_class_t ns_mem_slab_classes[2][NS_MEM_SLAB_CLASSES];
+static bool ns_mem_slab_initialised;
+
+static void ns_mem_slab_init(void)
+{
+    for (uint_fast8_t i = 0; i < 2 * NS_MEM_SLAB_CLASSES; i++) {
+        ns_mem_slab_class_t *slab_class = &ns_mem_slab_classes[i / NS_MEM_SLAB_CLASSES][i % NS_MEM_SLAB_CLASSES];
+        uint16_t object_size = NS_MEM_SLAB_OBJECT_HEADER + ns_mem_slab_sizes[i % NS_MEM_SLAB_CLASSES];
+        uint16_t chunk_count = (NS_MEM_SLAB_CHUNK_SIZE - NS_MEM_SLAB_CHUNK_HEADER) / object_size;
+
+        ns_list_init(&slab_class->partial);
+        slab_class->object_size = object_size;
+        slab_class->chunk_count = chunk_count > NS_MEM_SLAB_CHUNK_OBJECTS ? chunk_count : NS_MEM_SLAB_CHUNK_OBJECTS;
+        slab_class->temporary = i / NS_MEM_SLAB_CLASSES;
+    }
+    ns_mem_slab_initialised = true;
+}
+
+static int_fast8_t ns_mem_slab_class_index(ns_mem_block_size_t size)
+{
+    for (uint_fast8_t i = 0; i < NS_MEM_SLAB_CLASSES; i++) {
+        if (size <= ns_mem_slab_sizes[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static ns_mem_slab_object_t *ns_mem_slab_pop(ns_mem_slab_class_t *slab_class)
+{
+    ns_mem_slab_object_t *object = NULL;
+
+    platform_enter_critical();
+    ns_mem_slab_chunk_t *chunk = ns_list_get_first(&slab_class->partial);
+    if (chunk) {
+        object = chunk->free_list;
+        chunk->free_list = object->next;
+        chunk->in_use++;
+        if (!chunk->free_list) {
+            ns_list_remove(&slab_class->partial, chunk);
+        }
+    }
+    platform_exit_critical();
+    return object;
+}
+
+static bool ns_mem_slab_grow(ns_mem_slab_class_t *slab_class)
+{
+    uint16_t count = slab_class->chunk_count;
+    ns_mem_slab_chunk_t *chunk = NULL;
+    while (!chunk && count) {
+        size_t chunk_size = NS_MEM_SLAB_CHUNK_HEADER + (size_t) count * slab_class->object_size;
+        chunk = slab_class->temporary ? ns_dyn_mem_temporary_alloc(chunk_size) : ns_dyn_mem_alloc(chunk_size);
+        if (!chunk) {
+            // Heap too fragmented for a whole chunk, settle for a single object
+            count = count > 1 ? 1 : 0;
+        }
+    }
+    if (!chunk) {
+        return false;
+    }
+
+    uint8_t *objects = (uint8_t *) chunk + NS_MEM_SLAB_CHUNK_HEADER;
+    chunk->slab_class = slab_class;
+    chunk->free_list = NULL;
+    chunk->count = count;
+    chunk->in_use = 0;
+    for (uint16_t i = count; i-- > 0;) {
+        ns_mem_slab_object_t *object = (ns_mem_slab_object_t *)(objects + (size_t) i * slab_class->object_size);
+        object->chunk = chunk;
+        object->next = chunk->free_list;
+        chunk->free_list = object;
+    }
+
+    platform_enter_critical();
+    ns_list_add_to_start(&slab_class->partial, chunk);
+    platform_exit_critical();
+    return true;
+}
+
+static void *ns_mem_slab_alloc_from(ns_mem_block_size_t size, bool temporary)
+{
+    int_fast8_t index = ns_mem_slab_class_index(size);
+    if (index < 0) {
+        return temporary ? ns_dyn_mem_temporary_alloc(size) : ns_dyn_mem_alloc(size);
+    }
+    if (!ns_mem_slab_initialised) {
+        ns_mem_slab_init();
+    }
+
+    ns_mem_slab_class_t *slab_class = &ns_mem_slab_classes[temporary][index];
+    ns_mem_slab_object_t *object = ns_mem_slab_pop(slab_class);
+    if (!object && ns_mem_slab_grow(slab_class)) {
+        object = ns_mem_slab_pop(slab_class);
+    }
+    return object ? (uint8_t *) object + NS_MEM_SLAB_OBJECT_HEADER : NULL;
+}
+
+void *ns_mem_slab_alloc(ns_mem_block_size_t size)
+{
+    return ns_mem_slab_alloc_from(size, false);
+}
+
+void *ns_mem_slab_temporary_alloc(ns_mem_block_size_t size)
+{
+    return ns_mem_slab_alloc_from(size, true);
+}
+
+void ns_mem_slab_free(void *block, ns_mem_block_size_t size)
+{
+    if (!block) {
+        return;
+    }
+    if (ns_mem_slab_class_index(size) < 0) {
+        ns_dyn_mem_free(block);
+        return;
+    }
+
+    ns_mem_slab_object_t *object = (ns_mem_slab_object_t *)((uint8_t *) block - NS_MEM_SLAB_OBJECT_HEADER);
+    ns_mem_slab_chunk_t *chunk = object->chunk;
+    ns_mem_slab_class_t *slab_class = chunk->slab_class;
+    ns_mem_slab_chunk_t *release = NULL;
+
+    platform_enter_critical();
+    if (!chunk->free_list) {
+        // Has room now
+        ns_list_add_to_end(&slab_class->partial, chunk);
+    }
+    object->next = chunk->free_list;
+    chunk->free_list = object;
+    chunk->in_use--;
+    if (chunk->in_use == 0 && ns_list_get_next(&slab_class->partial, ns_list_get_first(&slab_class->partial))) {
+        ns_list_remove(&slab_class->partial, chunk);
+        release = chunk;
+    }
+    platform_exit_critical();
+
+    ns_dyn_mem_free(release);
+}
+
+void ns_mem_slab_gc(bool full_gc)
+{
+    (void) full_gc;
+
+    if (!ns_mem_slab_initialised) {
+        return;
+    }
+
+    // Empty chunks kept for the next allocation
+    for (uint_fast8_t i = 0; i < 2 * NS_MEM_SLAB_CLASSES; i++) {
+        ns_mem_slab_class_t *slab_class = &ns_mem_slab_classes[i / NS_MEM_SLAB_CLASSES][i % NS_MEM_SLAB_CLASSES];
+        ns_mem_slab_chunk_t *release;
+
+        platform_enter_critical();
+        release = ns_list_get_first(&slab_class->partial);
+        if (release && release->in_use == 0) {
+            ns_list_remove(&slab_class->partial, release);
+        } else {
+            release = NULL;
+        }
+        platform_exit_critical();
+
+        ns_dyn_mem_free(release);
+    }
+}
+
+#endif /* HAVE_MEM_SLAB */
@@ -31,6 +31,7 @@
 #define HAVE_DEBUG
 #include "ns_trace.h"
 #include "nsdynmemLIB.h"
+#include "Core/include/ns_mem_slab.h"
 #include "ipv6_stack/ipv6_routing_table.h"
 #include "NWK_INTERFACE/Include/protocol.h"
 #include "6LoWPAN/ws/ws_pae_controller.h"
@@ -75,7 +76,11 @@ typedef void (ns_maintenance_gc_cb)(bool full_gc);
 static ns_maintenance_gc_cb *ns_maintenance_gc_functions[] = {
     ipv6_destination_cache_forced_gc,
     ws_pae_controller_forced_gc,
-    lowpan_adaptation_free_heap
+    lowpan_adaptation_free_heap,
+#ifdef HAVE_MEM_SLAB
+    // Last, to get back the chunks the others have emptied
+    ns_mem_slab_gc
+#endif
 };
 
 static void ns_monitor_heap_gc(bool full_gc)
@@ -1097,7 +1097,15 @@ int16_t socket_buffer_sendmsg(int8_t sid, buffer_t *buf, const struct ns_msghdr
 
     // Now copy (some of) the data into a buffer
     if (!buf) {
-        buf = buffer_get(payload_length);
+        // Leave room for the transport header too, so that UDP and TCP do
+        // not have to move the payload to a larger buffer
+        uint16_t headroom = BUFFER_DEFAULT_HEADROOM + buffer_link_headroom();
+        if (socket_ptr->type == SOCKET_TYPE_DGRAM) {
+            headroom += 8;
+        } else if (socket_ptr->type == SOCKET_TYPE_STREAM) {
+            headroom += 20;
+        }
+        buf = buffer_get_specific(headroom, payload_length, BUFFER_DEFAULT_MIN_SIZE);
         if (!buf) {
             ret_val = -2;
             goto fail;
@@ -23,6 +23,11 @@
 #include "mac_data_buffer.h"
 #include "ns_list.h"
 
+/* Buckets of the indirect queue, indexed by destination address */
+#ifndef MAC_INDIRECT_QUEUE_HASH_SIZE
+#define MAC_INDIRECT_QUEUE_HASH_SIZE 16
+#endif
+
 struct cca_structure_s;
 struct buffer;
 struct mac_pre_build_frame;
@@ -273,7 +278,8 @@ typedef struct protocol_interface_rf_mac_setup {
     uint16_t phy_mtu_size;
     phy_802_15_4_mode_t current_mac_mode;
     /* Indirect queue parameters */
-    struct mac_pre_build_frame *indirect_pd_data_request_queue;
+    struct mac_pre_build_frame *indirect_pd_data_request_queue[MAC_INDIRECT_QUEUE_HASH_SIZE];
+    uint16_t indirect_queue_size;
     struct mac_pre_build_frame enhanced_ack_buffer;
     uint32_t enhanced_ack_handler_timestamp;
     arm_event_t mac_mcps_timer_event;
@@ -41,6 +41,47 @@
 #define TRACE_GROUP_MAC_INDIR "mInD"
 #define TRACE_GROUP "mInD"
 
+/* Frames are kept in per-destination buckets, so that a data request only
+ * compares the frames of the polling child and of those hashed with it. A
+ * bucket is in queueing order.
+ */
+static uint_fast8_t mac_indirect_address_length(uint8_t addr_mode)
+{
+    return addr_mode == MAC_ADDR_MODE_16_BIT ? 2 : 8;
+}
+
+static mac_pre_build_frame_t **mac_indirect_bucket(protocol_interface_rf_mac_setup_s *rf_mac_setup, const uint8_t *address, uint_fast8_t length)
+{
+    uint_fast16_t hash = 0;
+    for (uint_fast8_t i = 0; i < length; i++) {
+        hash = hash * 31 + address[i];
+    }
+    return &rf_mac_setup->indirect_pd_data_request_queue[hash % MAC_INDIRECT_QUEUE_HASH_SIZE];
+}
+
+static mac_pre_build_frame_t **mac_indirect_find(protocol_interface_rf_mac_setup_s *rf_mac_setup, uint8_t addr_mode, const uint8_t *address)
+{
+    uint_fast8_t len = mac_indirect_address_length(addr_mode);
+    mac_pre_build_frame_t **b_ptr = mac_indirect_bucket(rf_mac_setup, address, len);
+    for (; *b_ptr; b_ptr = &(*b_ptr)->next) {
+        if ((*b_ptr)->fcf_dsn.DstAddrMode == addr_mode && memcmp((*b_ptr)->DstAddr, address, len) == 0) {
+            return b_ptr;
+        }
+    }
+    return NULL;
+}
+
+static mac_pre_build_frame_t *mac_indirect_remove(protocol_interface_rf_mac_setup_s *rf_mac_setup, mac_pre_build_frame_t **b_ptr)
+{
+    mac_pre_build_frame_t *b = *b_ptr;
+    *b_ptr = b->next;
+    b->next = NULL;
+    rf_mac_setup->indirect_pending_bytes -= b->mac_payload_length;
+    rf_mac_setup->indirect_queue_size--;
+    sw_mac_stats_update(rf_mac_setup, STAT_MAC_INDIRECT_QUEUE, rf_mac_setup->indirect_queue_size);
+    return b;
+}
+
 void mac_indirect_data_ttl_handle(protocol_interface_rf_mac_setup_s *cur, uint16_t tick_value)
 {
     if (!cur || !cur->dev_driver) {
@@ -50,7 +91,7 @@ void mac_indirect_data_ttl_handle(protocol_interface_rf_mac_setup_s *cur, uint16
     memset(&confirm, 0, sizeof(mcps_data_conf_t));
 
     phy_device_driver_s *dev_driver = cur->dev_driver->phy_driver;
-    if (!cur->indirect_pd_data_request_queue) {
+    if (!cur->indirect_queue_size) {
         uint8_t value = 0;
         if (dev_driver && dev_driver->extension) {
             dev_driver->extension(PHY_EXTENSION_CTRL_PENDING_BIT, &value);
@@ -58,42 +99,34 @@ void mac_indirect_data_ttl_handle(protocol_interface_rf_mac_setup_s *cur, uint16
         cur->mac_frame_pending = false;
         return;
     }
-    mac_pre_build_frame_t *buf, *buf_prev = 0, *buf_temp = 0;
 
     mac_api_t *api = get_sw_mac_api(cur);
     if (!api) {
         return;
     }
 
-    buf = cur->indirect_pd_data_request_queue;
-
     tick_value /= 20; //Covert time ms
     if (tick_value == 0) {
         tick_value = 1;
     }
 
-    while (buf) {
-        if (buf->buffer_ttl > tick_value) {
-            buf->buffer_ttl -= tick_value;
-            buf_prev = buf;
-            buf = buf->next;
-        } else {
-            buf->buffer_ttl = 0;
-            if (buf_prev) {
-                buf_prev->next = buf->next;
-            } else {
-                cur->indirect_pd_data_request_queue = buf->next;
+    for (uint_fast8_t i = 0; i < MAC_INDIRECT_QUEUE_HASH_SIZE; i++) {
+        mac_pre_build_frame_t **b_ptr = &cur->indirect_pd_data_request_queue[i];
+        while (*b_ptr) {
+            mac_pre_build_frame_t *buf = *b_ptr;
+            if (buf->buffer_ttl > tick_value) {
+                buf->buffer_ttl -= tick_value;
+                b_ptr = &buf->next;
+                continue;
             }
 
-            confirm.msduHandle = buf->msduHandle;
-            buf_temp = buf;
-            buf = buf->next;
-            buf_temp->next = NULL;
-            cur->indirect_pending_bytes -= buf_temp->mac_payload_length;
+            buf->buffer_ttl = 0;
+            mac_indirect_remove(cur, b_ptr);
 
+            confirm.msduHandle = buf->msduHandle;
             confirm.status = MLME_TRANSACTION_EXPIRED;
 
-            mcps_sap_prebuild_frame_buffer_free(buf_temp);
+            mcps_sap_prebuild_frame_buffer_free(buf);
 
             if (cur->mac_extension_enabled) {
                 mcps_data_conf_payload_t data_conf;
@@ -148,64 +181,35 @@ uint8_t mac_indirect_data_req_handle(mac_pre_parsed_frame_t *buf, protocol_inter
 
     /* If the Ack we sent for the Data Request didn't have frame pending set, we shouldn't transmit - child may have slept */
     if (!buf->ack_pendinfg_status) {
-        if (mac_ptr->indirect_pd_data_request_queue) {
+        if (mac_ptr->indirect_queue_size) {
             tr_error("Wrongly dropped");
         }
         //Free Buffer
         return 1;
     }
 
-    uint8_t address_cmp_ok = 0;
-    uint8_t len;
-    mac_pre_build_frame_t *b_prev = NULL;
-
-    if (buf->fcf_dsn.SrcAddrMode == MAC_ADDR_MODE_16_BIT) {
-        len = 2;
+    mac_pre_build_frame_t **b_ptr;
+    if (buf->neigh_info) {
+        // Frames may be addressed to either address of the neighbour, take the oldest
+        uint8_t short_address[2];
+        common_write_16_bit(buf->neigh_info->ShortAddress, short_address);
+        b_ptr = mac_indirect_find(mac_ptr, MAC_ADDR_MODE_16_BIT, short_address);
+        mac_pre_build_frame_t **ext_ptr = mac_indirect_find(mac_ptr, MAC_ADDR_MODE_64_BIT, buf->neigh_info->ExtAddress);
+        if (!b_ptr || (ext_ptr && (int32_t)((*ext_ptr)->request_start_time_us - (*b_ptr)->request_start_time_us) < 0)) {
+            b_ptr = ext_ptr;
+        }
     } else {
-        len = 8;
+        b_ptr = mac_indirect_find(mac_ptr, buf->fcf_dsn.SrcAddrMode, srcAddress);
     }
 
-    mac_pre_build_frame_t *b = mac_ptr->indirect_pd_data_request_queue;
-    while (b) {
-
-        if (buf->neigh_info) {
-            uint16_t compare_short;
-            if (b->fcf_dsn.DstAddrMode == MAC_ADDR_MODE_16_BIT) {
-
-                compare_short = common_read_16_bit(b->DstAddr);
-                if (compare_short == buf->neigh_info->ShortAddress) {
-                    address_cmp_ok = 1;
-                }
-            } else {
-                if (memcmp(b->DstAddr, buf->neigh_info->ExtAddress, 8) == 0) {
-                    address_cmp_ok = 1;
-                }
-            }
-        } else {
-            if (b->fcf_dsn.DstAddrMode == buf->fcf_dsn.SrcAddrMode) {
-                if (memcmp(b->DstAddr, srcAddress, len) == 0) {
-                    address_cmp_ok = 1;
-                }
-            }
-        }
-
-        if (address_cmp_ok) {
-            if (b_prev) {
-                b_prev->next = b->next;
-
-            } else {
-                mac_ptr->indirect_pd_data_request_queue = b->next;
-            }
-            b->next = NULL;
-            b->priority = MAC_PD_DATA_MEDIUM_PRIORITY;
-            mcps_sap_pd_req_queue_write(mac_ptr, b);
-            return 1;
-        } else {
-            b_prev = b;
-            b = b->next;
-        }
+    if (!b_ptr) {
+        return 0;
     }
-    return 0;
+
+    mac_pre_build_frame_t *b = mac_indirect_remove(mac_ptr, b_ptr);
+    b->priority = MAC_PD_DATA_MEDIUM_PRIORITY;
+    mcps_sap_pd_req_queue_write(mac_ptr, b);
+    return 1;
 }
 
 void mac_indirect_queue_write(protocol_interface_rf_mac_setup_s *rf_mac_setup, mac_pre_build_frame_t *buffer)
@@ -216,9 +220,16 @@ void mac_indirect_queue_write(protocol_interface_rf_mac_setup_s *rf_mac_setup, m
     rf_mac_setup->indirect_pending_bytes += buffer->mac_payload_length;
     buffer->next = NULL;
     buffer->buffer_ttl = 7100;
-    //Push to queue
-    if (!rf_mac_setup->indirect_pd_data_request_queue) {
-        rf_mac_setup->indirect_pd_data_request_queue = buffer;
+    //Push to the end of destination bucket
+    mac_pre_build_frame_t **b_ptr = mac_indirect_bucket(rf_mac_setup, buffer->DstAddr, mac_indirect_address_length(buffer->fcf_dsn.DstAddrMode));
+    while (*b_ptr) {
+        b_ptr = &(*b_ptr)->next;
+    }
+    *b_ptr = buffer;
+    rf_mac_setup->indirect_queue_size++;
+    sw_mac_stats_update(rf_mac_setup, STAT_MAC_INDIRECT_QUEUE, rf_mac_setup->indirect_queue_size);
+
+    if (rf_mac_setup->indirect_queue_size == 1) {
         //Trig timer and set pending flag to radio
         eventOS_callback_timer_stop(rf_mac_setup->mac_mcps_timer);
         eventOS_callback_timer_start(rf_mac_setup->mac_mcps_timer, MAC_INDIRECT_TICK_IN_MS * 20);
@@ -227,16 +238,27 @@ void mac_indirect_queue_write(protocol_interface_rf_mac_setup_s *rf_mac_setup, m
             uint8_t value = 1;
             rf_mac_setup->dev_driver->phy_driver->extension(PHY_EXTENSION_CTRL_PENDING_BIT, &value);
         }
-        return;
     }
+}
 
-    mac_pre_build_frame_t *cur = rf_mac_setup->indirect_pd_data_request_queue;
-    while (cur) {
-        if (cur->next == NULL) {
-            cur->next = buffer;
-            cur = NULL;
-        } else {
-            cur = cur->next;
+bool mac_indirect_queue_purge(protocol_interface_rf_mac_setup_s *rf_mac_setup, uint8_t msduhandle)
+{
+    for (uint_fast8_t i = 0; i < MAC_INDIRECT_QUEUE_HASH_SIZE; i++) {
+        for (mac_pre_build_frame_t **b_ptr = &rf_mac_setup->indirect_pd_data_request_queue[i]; *b_ptr; b_ptr = &(*b_ptr)->next) {
+            if ((*b_ptr)->fcf_dsn.frametype == MAC_FRAME_DATA && (*b_ptr)->msduHandle == msduhandle) {
+                mcps_sap_prebuild_frame_buffer_free(mac_indirect_remove(rf_mac_setup, b_ptr));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void mac_indirect_queue_free(protocol_interface_rf_mac_setup_s *rf_mac_setup)
+{
+    for (uint_fast8_t i = 0; i < MAC_INDIRECT_QUEUE_HASH_SIZE; i++) {
+        while (rf_mac_setup->indirect_pd_data_request_queue[i]) {
+            mcps_sap_prebuild_frame_buffer_free(mac_indirect_remove(rf_mac_setup, &rf_mac_setup->indirect_pd_data_request_queue[i]));
         }
     }
 }
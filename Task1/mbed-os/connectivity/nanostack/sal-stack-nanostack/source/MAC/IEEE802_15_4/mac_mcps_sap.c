@@ -35,6 +35,7 @@
 #include "platform/arm_hal_interrupt.h"
 #include "common_functions.h"
 #include "Core/include/ns_monitor.h"
+#include "Core/include/ns_mem_slab.h"
 #include "randLIB.h"
 
 #include "MAC/IEEE802_15_4/sw_mac_internal.h"
@@ -760,7 +761,7 @@ static int8_t mac_data_sap_rx_handler(mac_pre_parsed_frame_t *buf, protocol_inte
     uint8_t status;
 
     //allocate Data ind primitiv and parse packet to that
-    mcps_data_ind_t *data_ind = ns_dyn_mem_temporary_alloc(sizeof(mcps_data_ind_t));
+    mcps_data_ind_t *data_ind = ns_mem_slab_temporary_alloc(sizeof(mcps_data_ind_t));
 
     if (!data_ind) {
         goto DROP_PACKET;
@@ -837,7 +838,7 @@ static int8_t mac_data_sap_rx_handler(mac_pre_parsed_frame_t *buf, protocol_inte
     }
 
 DROP_PACKET:
-    ns_dyn_mem_free(data_ind);
+    ns_mem_slab_free(data_ind, sizeof(mcps_data_ind_t));
     mcps_sap_pre_parsed_frame_buffer_free(buf);
     return retval;
 }
@@ -1122,6 +1123,15 @@ static bool mcps_sap_check_buffer_timeout(protocol_interface_rf_mac_setup_s *rf_
     return false;
 }
 
+static void mcps_sap_queue_time_update(protocol_interface_rf_mac_setup_s *rf_mac_setup, mac_pre_build_frame_t *buffer)
+{
+    // Timestamp is not implemented by virtual RF driver
+    if (!rf_mac_setup->mac_statistics || rf_mac_setup->dev_driver->phy_driver->arm_net_virtual_tx_cb) {
+        return;
+    }
+    sw_mac_stats_update(rf_mac_setup, STAT_MAC_TX_QUEUE_TIME, (mac_mcps_sap_get_phy_timestamp(rf_mac_setup) - buffer->request_start_time_us) / 1000);
+}
+
 void mac_mcps_trig_buffer_from_queue(protocol_interface_rf_mac_setup_s *rf_mac_setup)
 {
     if (!rf_mac_setup) {
@@ -1155,6 +1165,7 @@ void mac_mcps_trig_buffer_from_queue(protocol_interface_rf_mac_setup_s *rf_mac_s
                     memcpy(rf_mac_setup->mac_edfe_info->PeerAddr, buffer->DstAddr, 8);
                     rf_mac_setup->mac_edfe_info->state = MAC_EDFE_FRAME_CONNECTING;
                 }
+                mcps_sap_queue_time_update(rf_mac_setup, buffer);
                 rf_mac_setup->active_pd_data_request = buffer;
                 if (mcps_pd_data_request(rf_mac_setup, buffer) != 0) {
                     if (buffer->ExtendedFrameExchange) {
@@ -1335,7 +1346,7 @@ int8_t mac_mcps_sap_tasklet_init(void)
 
 mac_pre_build_frame_t *mcps_sap_prebuild_frame_buffer_get(uint16_t payload_size)
 {
-    mac_pre_build_frame_t *buffer = ns_dyn_mem_temporary_alloc(sizeof(mac_pre_build_frame_t));
+    mac_pre_build_frame_t *buffer = ns_mem_slab_temporary_alloc(sizeof(mac_pre_build_frame_t));
     if (!buffer) {
         return NULL;
     }
@@ -1347,7 +1358,7 @@ mac_pre_build_frame_t *mcps_sap_prebuild_frame_buffer_get(uint16_t payload_size)
         //Mac interlnal payload allocate
         buffer->mac_payload = ns_dyn_mem_temporary_alloc(payload_size);
         if (!buffer->mac_payload) {
-            ns_dyn_mem_free(buffer);
+            ns_mem_slab_free(buffer, sizeof(mac_pre_build_frame_t));
             return NULL;
         }
         buffer->mac_allocated_payload_ptr = true;
@@ -1369,7 +1380,7 @@ void mcps_sap_prebuild_frame_buffer_free(mac_pre_build_frame_t *buffer)
         ns_dyn_mem_free(buffer->mac_payload);
     }
     //Free Buffer frame
-    ns_dyn_mem_free(buffer);
+    ns_mem_slab_free(buffer, sizeof(mac_pre_build_frame_t));
 
 }
 
@@ -2544,12 +2555,12 @@ void mcps_sap_pre_parsed_frame_buffer_free(mac_pre_parsed_frame_t *buf)
         }
     }
 
-    ns_dyn_mem_free(buf);
+    ns_mem_slab_free(buf, sizeof(mac_pre_parsed_frame_t) + buf->frameLength);
 }
 
 mac_pre_parsed_frame_t *mcps_sap_pre_parsed_frame_buffer_get(const uint8_t *data_ptr, uint16_t frame_length)
 {
-    mac_pre_parsed_frame_t *buffer = ns_dyn_mem_temporary_alloc(sizeof(mac_pre_parsed_frame_t) + frame_length);
+    mac_pre_parsed_frame_t *buffer = ns_mem_slab_temporary_alloc(sizeof(mac_pre_parsed_frame_t) + frame_length);
 
     if (buffer) {
         memset(buffer, 0, sizeof(mac_pre_parsed_frame_t) + frame_length);
@@ -2777,13 +2788,7 @@ void mac_mcps_buffer_queue_free(protocol_interface_rf_mac_setup_s *rf_mac_setup)
         }
     }
 
-    while (rf_mac_setup->indirect_pd_data_request_queue) {
-        mac_pre_build_frame_t *buffer = rf_mac_setup->indirect_pd_data_request_queue;
-        if (buffer) {
-            rf_mac_setup->indirect_pd_data_request_queue = buffer->next;
-            mcps_sap_prebuild_frame_buffer_free(buffer);
-        }
-    }
+    mac_indirect_queue_free(rf_mac_setup);
 
     if (rf_mac_setup->pd_rx_ack_buffer) {
         if (rf_mac_setup->rf_pd_ack_buffer_is_in_use) {
@@ -2833,7 +2838,7 @@ static bool mcps_sap_purge_req_from_queue(protocol_interface_rf_mac_setup_s *rf_
     rf_mac_setup->pd_data_request_queue_to_go = mcps_sap_purge_from_list(rf_mac_setup->pd_data_request_queue_to_go, msduhandle, &status);
 
     if (!status) {
-        rf_mac_setup->indirect_pd_data_request_queue = mcps_sap_purge_from_list(rf_mac_setup->indirect_pd_data_request_queue, msduhandle, &status);
+        status = mac_indirect_queue_purge(rf_mac_setup, msduhandle);
     }
 
     return status;
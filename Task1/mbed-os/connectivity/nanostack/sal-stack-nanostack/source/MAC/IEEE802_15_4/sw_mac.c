@@ -785,6 +785,21 @@ void sw_mac_stats_update(protocol_interface_rf_mac_setup_s *setup, mac_stats_typ
                     setup->mac_statistics->mac_tx_latency_max = update_val;
                 }
                 break;
+            case STAT_MAC_TX_QUEUE_TIME: {
+                // Decades of milliseconds from 10 ms up
+                uint_fast8_t i = 0;
+                for (uint32_t limit = 10; i < MAC_STATISTICS_QUEUE_TIME_BUCKETS - 1 && update_val >= limit; limit *= 10) {
+                    i++;
+                }
+                setup->mac_statistics->mac_tx_queue_time[i]++;
+                break;
+            }
+            case STAT_MAC_INDIRECT_QUEUE:
+                setup->mac_statistics->mac_indirect_queue_size = update_val;
+                if (setup->mac_statistics->mac_indirect_queue_size > setup->mac_statistics->mac_indirect_queue_peak) {
+                    setup->mac_statistics->mac_indirect_queue_peak = setup->mac_statistics->mac_indirect_queue_size;
+                }
+                break;
         }
     }
 }
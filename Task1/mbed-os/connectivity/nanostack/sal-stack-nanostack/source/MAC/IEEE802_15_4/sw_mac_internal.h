@@ -35,7 +35,9 @@ typedef enum {
     STAT_MAC_TX_RETRY,
     STAT_MAC_TX_CCA_ATT,
     STAT_MAC_TX_CCA_FAIL,
-    STAT_MAC_TX_LATENCY
+    STAT_MAC_TX_LATENCY,
+    STAT_MAC_TX_QUEUE_TIME,
+    STAT_MAC_INDIRECT_QUEUE
 } mac_stats_type_t;
 
 typedef enum arm_nwk_timer_id {
@@ -48,9 +48,18 @@
 #define MPL_SEED_64_BIT     2
 #define MPL_SEED_128_BIT    3
 
+/* Total size of buffered messages. When full, the first buffered message of
+ * each seed is compared and the one buffered longest ago is dropped,
+ * advancing its seed's MinSequence.
+ */
+#ifndef MAX_BUFFERED_MESSAGES_SIZE
 #define MAX_BUFFERED_MESSAGES_SIZE 8192
+#endif
 #define MAX_BUFFERED_MESSAGE_LIFETIME 600 // 1/10 s ticks
 
+/* Accepted sequence numbers remembered behind the newest one of a seed */
+#define MPL_SEED_WINDOW_SIZE 32
+
 static bool mpl_timer_running;
 static uint16_t mpl_total_buffered;
 
@@ -83,9 +92,11 @@ typedef struct mpl_data_message {
 
 typedef struct mpl_seed {
     ns_list_link_t link;
+    uint32_t window;                /* bit n set: window_top - n accepted */
     bool colour;
     uint16_t lifetime;
     uint8_t min_sequence;
+    uint8_t window_top;
     uint8_t id_len;
     NS_LIST_HEAD(mpl_buffered_message_t, link) messages; /* sequence number order */
     uint8_t id[];
@@ -332,6 +343,9 @@ static mpl_seed_t *mpl_seed_create(mpl_domain_t *domain, uint8_t id_len, const u
     }
 
     seed->min_sequence = sequence;
+    /* Nothing before the first message heard can be told apart from a repeat */
+    seed->window_top = sequence - 1;
+    seed->window = UINT32_MAX;
     seed->lifetime = domain->seed_set_entry_lifetime;
     seed->id_len = id_len;
     seed->colour = domain->colour;
@@ -360,12 +374,42 @@ static void mpl_seed_advance_min_sequence(mpl_seed_t *seed, uint8_t min_sequence
     }
 }
 
+/* The window catches repeats of messages that were accepted but could not
+ * be buffered. Returns false for a sequence already accepted. Beyond the
+ * window, the buffered messages are left to tell from MinSequence up.
+ */
+static bool mpl_seed_window_accept(mpl_seed_t *seed, uint8_t sequence)
+{
+    if (common_serial_number_greater_8(sequence, seed->window_top)) {
+        uint8_t shift = sequence - seed->window_top;
+        seed->window = shift < MPL_SEED_WINDOW_SIZE ? seed->window << shift : 0;
+        seed->window |= 1;
+        seed->window_top = sequence;
+        return true;
+    }
+
+    uint8_t age = seed->window_top - sequence;
+    if (age >= MPL_SEED_WINDOW_SIZE) {
+        return !common_serial_number_greater_8(seed->min_sequence, sequence);
+    }
+    if (seed->window & (UINT32_C(1) << age)) {
+        return false;
+    }
+    seed->window |= UINT32_C(1) << age;
+    return true;
+}
+
 static mpl_buffered_message_t *mpl_buffer_lookup(mpl_seed_t *seed, uint8_t sequence)
 {
     ns_list_foreach(mpl_buffered_message_t, message, &seed->messages) {
-        if (mpl_buffer_sequence(message) == sequence) {
+        uint8_t message_sequence = mpl_buffer_sequence(message);
+        if (message_sequence == sequence) {
             return message;
         }
+        /* Held in sequence order */
+        if (common_serial_number_greater_8(message_sequence, sequence)) {
+            break;
+        }
     }
     return NULL;
 }
@@ -747,15 +791,20 @@ buffer_t *mpl_control_handler(buffer_t *buf, protocol_interface_info_entry_t *cu
                 message->colour = new_colour;
             }
         }
-        for (uint8_t i = 0; i / 8 < bm_len; i++) {
-            if (bit_test(ptr, i)) {
-                mpl_buffered_message_t *message = mpl_buffer_lookup(seed, min_seqno + i);
-
-                if (!message && common_serial_number_greater_8(min_seqno + i, seed->min_sequence)) {
-                    they_have_new_data = true;
-                } else if (message) {
-                    message->colour = new_colour;
-                }
+        /* Bitmap and our messages are both in sequence order, walk them together */
+        mpl_buffered_message_t *message = ns_list_get_first(&seed->messages);
+        for (uint_fast16_t i = 0; i < bm_len * 8; i++) {
+            if (!bit_test(ptr, i)) {
+                continue;
+            }
+            uint8_t sequence = min_seqno + i;
+            while (message && common_serial_number_greater_8(sequence, mpl_buffer_sequence(message))) {
+                message = ns_list_get_next(&seed->messages, message);
+            }
+            if (message && mpl_buffer_sequence(message) == sequence) {
+                message->colour = new_colour;
+            } else if (common_serial_number_greater_8(sequence, seed->min_sequence)) {
+                they_have_new_data = true;
             }
         }
         ptr += bm_len;
@@ -917,6 +966,12 @@ bool mpl_forwarder_process_message(buffer_t *buf, mpl_domain_t *domain, bool see
         return false;
     }
 
+    /* Also catches repeats of messages we could not buffer */
+    if (!mpl_seed_window_accept(seed, sequence)) {
+        tr_debug("Repeated MPL message %"PRIu8, sequence);
+        return false;
+    }
+
     seed->lifetime = domain->seed_set_entry_lifetime;
 
     uint8_t hop_limit = buffer_data_pointer(buf)[IPV6_HDROFF_HOP_LIMIT];
@@ -46,7 +46,10 @@ typedef enum {
     STATS_ETX_2ND_PARENT,
     STATS_AL_TX_QUEUE_SIZE,
     STATS_AL_TX_CONGESTION_DROP,
-    STATS_AL_TX_LATENCY
+    STATS_AL_TX_LATENCY,
+    STATS_FRAG_RX_COMPLETE,
+    STATS_FRAG_RX_TIMEOUT,
+    STATS_FRAG_RX_EARLY_DROP
 
 } nwk_stats_type_t;
 
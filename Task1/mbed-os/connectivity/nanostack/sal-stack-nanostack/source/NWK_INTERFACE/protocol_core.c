@@ -99,6 +99,12 @@
 // to make sure the code is regularly exercised, let's make it 10 minutes.
 #define REACHABLE_TIME_UPDATE_SECONDS       600
 
+// Source route length a border router reserves buffer headroom for; longer
+// routes still work, at the cost of a copy of the packet.
+#ifndef BUFFER_SOURCE_ROUTE_HEADROOM_HOPS
+#define BUFFER_SOURCE_ROUTE_HEADROOM_HOPS   8
+#endif
+
 /** Quick monotonic time for simple timestamp comparisons; 100ms ticks.
  * This can of course wrap, so to handle this correctly comparisons must be
  * expressed like:
@@ -129,6 +135,7 @@ volatile uint8_t power_save_state =  0;
 
 void core_timer_event_handle(uint16_t ticksUpdate);
 static void protocol_buffer_poll(buffer_t *b);
+static void protocol_buffer_headroom_update(protocol_interface_info_entry_t *cur, bool ready);
 
 static int8_t net_interface_get_free_id(void);
 
@@ -416,6 +423,7 @@ void protocol_core_interface_info_reset(protocol_interface_info_entry_t *entry)
         /* This is done after address deletion, so RPL can act on them */
         rpl_control_remove_domain_from_interface(entry);
 #endif
+        protocol_buffer_headroom_update(entry, false);
     }
 }
 
@@ -1098,12 +1106,43 @@ static void nwk_net_event_post(arm_nwk_interface_status_type_e posted_event, int
     }
 }
 
+/* Sizes buffer headroom for the headers the interface decompresses and
+ * inserts, so that received and forwarded packets are not copied to a larger
+ * buffer by buffer_headroom(). */
+static void protocol_buffer_headroom_update(protocol_interface_info_entry_t *cur, bool ready)
+{
+    cur->buffer_rx_headroom = 0;
+    cur->buffer_tx_headroom = 0;
+    if (ready && cur->nwk_id == IF_6LoWPAN) {
+        // Elided UDP header and RPL option, on top of the IPv6 header
+        cur->buffer_rx_headroom = 8 + 8;
+    }
+    if (ready && cur->rpl_domain) {
+        // IPv6-in-IPv6 tunnel with a RPL option, or with a source routing
+        // header of /64 addresses when routing down from the root
+        cur->buffer_tx_headroom = IPV6_HDRLEN + 8;
+        if (cur->bootsrap_mode == ARM_NWK_BOOTSRAP_MODE_6LoWPAN_BORDER_ROUTER) {
+            cur->buffer_tx_headroom += BUFFER_SOURCE_ROUTE_HEADROOM_HOPS * 8;
+        }
+    }
+
+    // A packet may be routed out of any interface
+    uint16_t link_headroom = 0;
+    ns_list_foreach(protocol_interface_info_entry_t, entry, &protocol_interface_info_list) {
+        if (entry->buffer_tx_headroom > link_headroom) {
+            link_headroom = entry->buffer_tx_headroom;
+        }
+    }
+    buffer_link_headroom_set(link_headroom);
+}
+
 void nwk_bootsrap_state_update(arm_nwk_interface_status_type_e posted_event, protocol_interface_info_entry_t *cur)
 {
     //Clear Bootsrap Active Bit allways
     cur->lowpan_info &= ~INTERFACE_NWK_BOOTSRAP_ACTIVE;
     cur->bootsrap_state_machine_cnt = 0;
     nwk_net_event_post(posted_event, cur->net_start_tasklet, cur->id);
+    protocol_buffer_headroom_update(cur, posted_event == ARM_NWK_BOOTSTRAP_READY);
 
     if (posted_event == ARM_NWK_BOOTSTRAP_READY) {
 
@@ -160,6 +160,15 @@ void protocol_stats_update(nwk_stats_type_t type, uint16_t update_val)
                     nwk_stats_ptr->adapt_layer_tx_latency_max = update_val;
                 }
                 break;
+            case STATS_FRAG_RX_COMPLETE:
+                nwk_stats_ptr->frag_rx_complete++;
+                break;
+            case STATS_FRAG_RX_TIMEOUT:
+                nwk_stats_ptr->frag_rx_timeout++;
+                break;
+            case STATS_FRAG_RX_EARLY_DROP:
+                nwk_stats_ptr->frag_rx_early_drop++;
+                break;
         }
     }
 }
@@ -704,6 +704,23 @@ not_forwarding_error:
 }
 
 #ifdef HAVE_RPL_ROOT
+/* Each source route computation marks the targets it passes with a number
+ * of its own, so a loop shows as a target marked already.
+ */
+static uint16_t rpl_data_sr_walk_start(rpl_instance_t *instance)
+{
+    if (++instance->root_sr_walk == 0) {
+        /* Wrapped - forget the marks of earlier computations */
+        ns_list_foreach(rpl_dao_target_t, target, &instance->dao_targets) {
+            if (target->root) {
+                target->info.root.sr_walk = 0;
+            }
+        }
+        instance->root_sr_walk = 1;
+    }
+    return instance->root_sr_walk;
+}
+
 /* TODO - every target involved here should be non-External. Add checks */
 static bool rpl_data_compute_source_route(const uint8_t *final_dest, rpl_dao_target_t *const target)
 {
@@ -738,6 +755,8 @@ static bool rpl_data_compute_source_route(const uint8_t *final_dest, rpl_dao_tar
      * each time, which is the shortest path after the compute_paths call.
      */
     rpl_dao_target_t *t = target;
+    uint16_t walk = rpl_data_sr_walk_start(target->instance);
+    t->info.root.sr_walk = walk;
     for (;;) {
         /* First transit is best path, thanks to root computation above */
         rpl_dao_root_transit_t *transit = ns_list_get_first(&t->info.root.transits);
@@ -752,13 +771,19 @@ static bool rpl_data_compute_source_route(const uint8_t *final_dest, rpl_dao_tar
             tr_err("Parent %s disconnected", trace_ipv6_prefix(parent->prefix, parent->prefix_len));
             return false;
         }
-        /* Check transit address isn't already in table. Should not be possible */
-        for (int i = 16 * rpl_data_sr->ihops; i >= 0; i -= 16) {
-            if (addr_ipv6_equal(rpl_data_sr->final_dest + i, transit->transit)) {
-                protocol_stats_update(STATS_RPL_ROUTELOOP, 1);
-                tr_err("SR loop %s->%s", trace_ipv6_prefix(t->prefix, t->prefix_len), trace_ipv6(transit->transit));
-                return false;
-            }
+        /* Check the walk hasn't passed the parent or the final destination
+         * already. Should not be possible - the topo sort broke any loops.
+         */
+        if (parent->info.root.sr_walk == walk || addr_ipv6_equal(transit->transit, final_dest)) {
+            protocol_stats_update(STATS_RPL_ROUTELOOP, 1);
+            tr_err("SR loop %s->%s", trace_ipv6_prefix(t->prefix, t->prefix_len), trace_ipv6(transit->transit));
+            return false;
+        }
+        parent->info.root.sr_walk = walk;
+        /* The header can't hold more hops */
+        if (rpl_data_sr->ihops == UINT8_MAX) {
+            tr_err("SR too long %s", trace_ipv6_prefix(target->prefix, target->prefix_len));
+            return false;
         }
         /* Increase size of table if necessary */
         if (16 * (rpl_data_sr->ihops + 1) > rpl_data_sr->iaddr_size) {
@@ -269,6 +269,121 @@ void rpl_downward_process_dao_parent_changes(rpl_instance_t *instance)
     }
 }
 
+/* The /128 targets of an instance are also kept in a hash, once there are
+ * enough of them for it to pay off. A non-storing root has a target for
+ * every node of the network, and looks up the parent of every transit when
+ * linking the graph - with a list scan, that would be quadratic.
+ */
+#ifndef RPL_DAO_TARGET_HASH_MIN
+#define RPL_DAO_TARGET_HASH_MIN 16      /* Targets (and buckets) when the hash is first allocated */
+#endif
+#ifndef RPL_DAO_TARGET_HASH_MAX
+#define RPL_DAO_TARGET_HASH_MAX 1024    /* Maximum number of buckets */
+#endif
+
+/* FNV-1a hash of an address, folded to a power of two buckets */
+static uint_fast16_t rpl_dao_target_hash(const uint8_t address[16], uint_fast16_t buckets)
+{
+    uint32_t hash = 2166136261u;
+
+    for (uint_fast8_t i = 0; i < 16; i++) {
+        hash = (hash ^ address[i]) * 16777619u;
+    }
+
+    return (hash ^ (hash >> 16)) & (buckets - 1);
+}
+
+static void rpl_dao_target_hash_insert(rpl_instance_t *instance, rpl_dao_target_t *target)
+{
+    rpl_dao_target_t **p = &instance->dao_target_hash[rpl_dao_target_hash(target->prefix, instance->dao_target_hash_size)];
+
+    /* Added to the end, so lookups find the oldest first, as the list scan did */
+    while (*p) {
+        p = &(*p)->hash_next;
+    }
+    target->hash_next = NULL;
+    *p = target;
+}
+
+static bool rpl_dao_target_hash_resize(rpl_instance_t *instance, uint16_t size)
+{
+    rpl_dao_target_t **hash = rpl_alloc(size * sizeof * hash);
+    if (!hash) {
+        /* Keep the old hash, or the list scan if there was none */
+        return false;
+    }
+    memset(hash, 0, size * sizeof * hash);
+    rpl_free(instance->dao_target_hash, instance->dao_target_hash_size * sizeof * hash);
+    instance->dao_target_hash = hash;
+    instance->dao_target_hash_size = size;
+
+    ns_list_foreach(rpl_dao_target_t, target, &instance->dao_targets) {
+        if (target->prefix_len == 128) {
+            rpl_dao_target_hash_insert(instance, target);
+        }
+    }
+    return true;
+}
+
+/* Call after adding the target to the list */
+static void rpl_dao_target_index(rpl_instance_t *instance, rpl_dao_target_t *target)
+{
+    if (target->prefix_len != 128) {
+        instance->dao_prefix_target_count++;
+        return;
+    }
+
+    instance->dao_target_count++;
+    if (instance->dao_target_count >= RPL_DAO_TARGET_HASH_MIN &&
+            instance->dao_target_count > 2 * instance->dao_target_hash_size &&
+            instance->dao_target_hash_size < RPL_DAO_TARGET_HASH_MAX) {
+        uint16_t size = instance->dao_target_hash_size ? 2 * instance->dao_target_hash_size : RPL_DAO_TARGET_HASH_MIN;
+        if (rpl_dao_target_hash_resize(instance, size)) {
+            /* Rehash included the new target */
+            return;
+        }
+    }
+
+    if (instance->dao_target_hash) {
+        rpl_dao_target_hash_insert(instance, target);
+    }
+}
+
+static void rpl_dao_target_unindex(rpl_instance_t *instance, rpl_dao_target_t *target)
+{
+    if (target->prefix_len != 128) {
+        instance->dao_prefix_target_count--;
+        return;
+    }
+
+    if (instance->dao_target_hash) {
+        rpl_dao_target_t **p = &instance->dao_target_hash[rpl_dao_target_hash(target->prefix, instance->dao_target_hash_size)];
+        for (; *p; p = &(*p)->hash_next) {
+            if (*p == target) {
+                *p = target->hash_next;
+                break;
+            }
+        }
+    }
+
+    if (--instance->dao_target_count == 0) {
+        rpl_free(instance->dao_target_hash, instance->dao_target_hash_size * sizeof * instance->dao_target_hash);
+        instance->dao_target_hash = NULL;
+        instance->dao_target_hash_size = 0;
+    }
+}
+
+static rpl_dao_target_t *rpl_dao_target_hash_lookup(const rpl_instance_t *instance, const uint8_t address[16])
+{
+    rpl_dao_target_t *target = instance->dao_target_hash[rpl_dao_target_hash(address, instance->dao_target_hash_size)];
+    for (; target; target = target->hash_next) {
+        if (addr_ipv6_equal(target->prefix, address)) {
+            break;
+        }
+    }
+    return target;
+}
+
 rpl_dao_target_t *rpl_create_dao_target(rpl_instance_t *instance, const uint8_t *prefix, uint8_t prefix_len, bool root)
 {
     rpl_dao_target_t *target = rpl_alloc(sizeof(rpl_dao_target_t));
@@ -290,6 +405,7 @@ rpl_dao_target_t *rpl_create_dao_target(rpl_instance_t *instance, const uint8_t
 #endif
 
     ns_list_add_to_end(&instance->dao_targets, target);
+    rpl_dao_target_index(instance, target);
     return target;
 }
 
@@ -300,6 +416,7 @@ void rpl_delete_dao_target(rpl_instance_t *instance, rpl_dao_target_t *target)
     /* TODO - should send a No-Path to root */
 
     ns_list_remove(&instance->dao_targets, target);
+    rpl_dao_target_unindex(instance, target);
 
 #ifdef HAVE_RPL_ROOT
     if (target->root) {
@@ -327,6 +444,10 @@ rpl_dao_target_t *rpl_instance_lookup_published_dao_target(rpl_instance_t *insta
 
 rpl_dao_target_t *rpl_instance_lookup_dao_target(rpl_instance_t *instance, const uint8_t *prefix, uint8_t prefix_len)
 {
+    if (prefix_len == 128 && instance->dao_target_hash) {
+        return rpl_dao_target_hash_lookup(instance, prefix);
+    }
+
     ns_list_foreach(rpl_dao_target_t, target, &instance->dao_targets) {
         if (target->prefix_len == prefix_len &&
                 bitsequal(target->prefix, prefix, prefix_len)) {
@@ -341,6 +462,14 @@ rpl_dao_target_t *rpl_instance_match_dao_target(rpl_instance_t *instance, const
     rpl_dao_target_t *longest = NULL;
     int_fast16_t longest_len = -1;
 
+    /* A /128 target is always the longest match */
+    if (prefix_len == 128 && instance->dao_target_hash) {
+        longest = rpl_dao_target_hash_lookup(instance, prefix);
+        if (longest || instance->dao_prefix_target_count == 0) {
+            return longest;
+        }
+    }
+
     ns_list_foreach(rpl_dao_target_t, target, &instance->dao_targets) {
         if (target->prefix_len >= longest_len && target->prefix_len <= prefix_len &&
                 bitsequal(target->prefix, prefix, target->prefix_len)) {
@@ -977,30 +1106,32 @@ static uint_fast8_t rpl_downward_path_control_to_preference(uint8_t pc)
 static rpl_dao_root_transit_t *rpl_downward_add_root_transit(rpl_dao_target_t *target, const uint8_t parent[16], uint8_t path_control)
 {
     //rpl_dao_root_transit_t *old_first = ns_list_get_first(&target->info.root.transits);
-    rpl_dao_root_transit_t *transit = NULL;
     ns_list_foreach(rpl_dao_root_transit_t, t, &target->info.root.transits) {
         if (addr_ipv6_equal(t->transit, parent)) {
-            ns_list_remove(&target->info.root.transits, t);
-            transit = t;
-            /* Updating existing transit - invalidates costs only */
-            rpl_downward_paths_invalidate(target->instance);
-            break;
+            /* Refreshing an existing transit leaves the graph as it is, and
+             * the paths too unless its cost changes. It keeps its place in
+             * the list - the first transit is the best path.
+             */
+            uint16_t old_cost = t->cost;
+            t->path_control |= path_control;
+            t->cost = rpl_downward_path_control_to_preference(t->path_control);
+            if (t->cost != old_cost) {
+                rpl_downward_paths_invalidate(target->instance);
+            }
+            return ns_list_get_first(&target->info.root.transits);
         }
     }
 
+    rpl_dao_root_transit_t *transit = rpl_alloc(sizeof(rpl_dao_root_transit_t));
     if (!transit) {
-        transit = rpl_alloc(sizeof(rpl_dao_root_transit_t));
-        if (!transit) {
-            tr_warn("RPL DAO overflow (target=%s,transit=%s)", trace_ipv6_prefix(target->prefix, target->prefix_len), trace_ipv6(parent));
-            goto out;
-        }
-        transit->path_control = 0;
-        /* A new transit invalidates the topo sort */
-        rpl_downward_topo_sort_invalidate(target->instance);
+        tr_warn("RPL DAO overflow (target=%s,transit=%s)", trace_ipv6_prefix(target->prefix, target->prefix_len), trace_ipv6(parent));
+        goto out;
     }
+    /* A new transit invalidates the topo sort */
+    rpl_downward_topo_sort_invalidate(target->instance);
 
     transit->target = target;
-    transit->path_control |= path_control;
+    transit->path_control = path_control;
     /* Initial transit cost is 1-4, depending on preference in Path Control.
      * Source routing errors from intermediate nodes may increase this. For
      * directly connected nodes, rpl_downward_compute_paths asks policy
@@ -1163,9 +1294,18 @@ static bool rpl_downward_process_targets_for_transit(rpl_dodag_t *dodag, bool st
                     /* If path sequence is different, we clear existing transits for this target */
                     if (!(seq_cmp & RPL_CMP_EQUAL)) {
                         if (target->root) {
+                            /* Except the one this DAO refreshes - nodes bump the sequence
+                             * for every refresh, and mostly keep their parent. Only
+                             * removing a transit changes the graph.
+                             */
                             ns_list_foreach_safe(rpl_dao_root_transit_t, transit, &target->info.root.transits) {
+                                if (addr_ipv6_equal(transit->transit, parent)) {
+                                    transit->path_control = 0;
+                                    continue;
+                                }
                                 ns_list_remove(&target->info.root.transits, transit);
                                 rpl_free(transit, sizeof * transit);
+                                rpl_downward_topo_sort_invalidate(dodag->instance);
                             }
                         }
                         if (storing) {
@@ -1441,7 +1581,7 @@ static void rpl_downward_topo_sort_invalidate(rpl_instance_t *instance)
     rpl_downward_paths_invalidate(instance);
 }
 
-static void rpl_downward_update_path_cost_to_children(rpl_dao_root_transit_children_list_t *children, uint16_t parent_cost)
+static void rpl_downward_update_path_cost_to_children(rpl_dao_root_transit_children_list_t *children, uint32_t parent_cost)
 {
     ns_list_foreach(rpl_dao_root_transit_t, transit, children) {
         rpl_dao_target_t *child = transit->target;
@@ -1450,9 +1590,14 @@ static void rpl_downward_update_path_cost_to_children(rpl_dao_root_transit_child
         if (parent_cost == 0 && child->prefix_len == 128) {
             transit_cost = rpl_policy_modify_downward_cost_to_root_neighbour(child->instance->domain, child->interface_id, child->prefix, transit->cost);
         }
-        if (child->info.root.cost > parent_cost + transit_cost) {
+        /* Saturate below 0xFFFFFFFF, which marks disconnected targets */
+        uint32_t cost = parent_cost + transit_cost;
+        if (cost < parent_cost || cost == 0xFFFFFFFF) {
+            cost = 0xFFFFFFFE;
+        }
+        if (child->info.root.cost > cost) {
             /* Note new best cost to child, and make this transit the child's first/best */
-            child->info.root.cost = parent_cost + transit_cost;
+            child->info.root.cost = cost;
             if (transit != ns_list_get_first(&child->info.root.transits)) {
                 ns_list_remove(&child->info.root.transits, transit);
                 ns_list_add_to_start(&child->info.root.transits, transit);
@@ -115,6 +115,7 @@ typedef NS_LIST_HEAD(rpl_dao_root_transit_t, parent_link) rpl_dao_root_transit_c
 /* Information held for a DAO target in a non-storing root */
 typedef struct rpl_dao_root {
     uint32_t cost;                      /* Routing cost - (used as number of incoming graph edges during topo sort) */
+    uint16_t sr_walk;                   /* Last source route computation that passed through this target */
     rpl_dao_root_transit_children_list_t children;   /* Child list - only valid after routing cost computation */
     rpl_dao_root_transit_list_t transits;
 } rpl_dao_root_t;
@@ -155,6 +156,7 @@ struct rpl_dao_target {
 #endif
         rpl_dao_non_root_t non_root;    /* Info for other nodes (any in storing, non-root in non-storing) */
     } info;
+    rpl_dao_target_t *hash_next;        /* Next in the target hash bucket (/128 targets) */
     ns_list_link_t link;
 };
 
@@ -197,6 +199,11 @@ struct rpl_instance {
     trickle_t dio_timer;                            /* Trickle timer for DIO transmission */
     rpl_dao_root_transit_children_list_t root_children;
     rpl_dao_target_list_t dao_targets;              /* List of DAO targets */
+    rpl_dao_target_t **dao_target_hash;             /* Hash of /128 targets, allocated when there are many */
+    uint16_t dao_target_hash_size;                  /* Buckets in dao_target_hash, power of two */
+    uint16_t dao_target_count;                      /* Number of /128 targets */
+    uint16_t dao_prefix_target_count;               /* Number of shorter targets */
+    uint16_t root_sr_walk;                          /* Current source route computation, marks the targets it passes */
     uint8_t dao_sequence;                           /* Next DAO sequence to use */
     uint8_t dao_sequence_in_transit;                /* DAO sequence in transit (if dao_in_transit) */
     uint16_t delay_dao_timer;
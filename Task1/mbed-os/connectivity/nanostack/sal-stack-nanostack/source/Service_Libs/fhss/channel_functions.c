@@ -208,23 +208,29 @@ int tr51_init_channel_table(int16_t *channel_table, int16_t number_of_channels)
     return 0;
 }
 
-int32_t tr51_get_uc_channel_index(int16_t *channel_table, uint8_t *output_table, uint16_t slot_number, uint8_t *mac, int16_t number_of_channels, uint32_t *excluded_channels)
+uint16_t tr51_get_uc_hopping_sequence(int16_t *channel_table, uint8_t *output_table, uint8_t *mac, int16_t number_of_channels, uint32_t *excluded_channels)
 {
     uint16_t nearest_prime = tr51_calc_nearest_prime_number(number_of_channels);
     uint8_t first_element;
     uint8_t step_size;
     tr51_compute_cfd(mac, &first_element, &step_size, nearest_prime);
-    tr51_calculate_hopping_sequence(channel_table, nearest_prime, first_element, step_size, output_table, excluded_channels);
+    return tr51_calculate_hopping_sequence(channel_table, nearest_prime, first_element, step_size, output_table, excluded_channels);
+}
+
+uint16_t tr51_get_bc_hopping_sequence(int16_t *channel_table, uint8_t *output_table, uint16_t bsi, int16_t number_of_channels, uint32_t *excluded_channels)
+{
+    uint8_t mac[8] = {0, 0, 0, 0, 0, 0, (uint8_t)(bsi >> 8), (uint8_t)bsi};
+    return tr51_get_uc_hopping_sequence(channel_table, output_table, mac, number_of_channels, excluded_channels);
+}
+
+int32_t tr51_get_uc_channel_index(int16_t *channel_table, uint8_t *output_table, uint16_t slot_number, uint8_t *mac, int16_t number_of_channels, uint32_t *excluded_channels)
+{
+    tr51_get_uc_hopping_sequence(channel_table, output_table, mac, number_of_channels, excluded_channels);
     return output_table[slot_number];
 }
 
 int32_t tr51_get_bc_channel_index(int16_t *channel_table, uint8_t *output_table, uint16_t slot_number, uint16_t bsi, int16_t number_of_channels, uint32_t *excluded_channels)
 {
-    uint16_t nearest_prime = tr51_calc_nearest_prime_number(number_of_channels);
-    uint8_t mac[8] = {0, 0, 0, 0, 0, 0, (uint8_t)(bsi >> 8), (uint8_t)bsi};
-    uint8_t first_element;
-    uint8_t step_size;
-    tr51_compute_cfd(mac, &first_element, &step_size, nearest_prime);
-    tr51_calculate_hopping_sequence(channel_table, nearest_prime, first_element, step_size, output_table, excluded_channels);
+    tr51_get_bc_hopping_sequence(channel_table, output_table, bsi, number_of_channels, excluded_channels);
     return output_table[slot_number];
 }
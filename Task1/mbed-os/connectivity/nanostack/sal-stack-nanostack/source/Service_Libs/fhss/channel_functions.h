@@ -32,6 +32,28 @@ uint16_t tr51_calc_nearest_prime_number(uint16_t start_value);
  */
 int tr51_init_channel_table(int16_t *channel_table, int16_t number_of_channels);
 
+/**
+ * @brief Compute the unicast hopping sequence using tr51 channel function.
+ * @param channel_table Channel table.
+ * @param output_table Output hopping sequence, channel index of each slot.
+ * @param mac MAC address of the node for which the sequence is calculated.
+ * @param number_of_channels Number of channels.
+ * @param excluded_channels Excluded channels.
+ * @return Number of channels in sequence.
+ */
+uint16_t tr51_get_uc_hopping_sequence(int16_t *channel_table, uint8_t *output_table, uint8_t *mac, int16_t number_of_channels, uint32_t *excluded_channels);
+
+/**
+ * @brief Compute the broadcast hopping sequence using tr51 channel function.
+ * @param channel_table Channel table.
+ * @param output_table Output hopping sequence, channel index of each slot.
+ * @param bsi Broadcast schedule identifier of the node for which the sequence is calculated.
+ * @param number_of_channels Number of channels.
+ * @param excluded_channels Excluded channels.
+ * @return Number of channels in sequence.
+ */
+uint16_t tr51_get_bc_hopping_sequence(int16_t *channel_table, uint8_t *output_table, uint16_t bsi, int16_t number_of_channels, uint32_t *excluded_channels);
+
 /**
  * @brief Compute the unicast schedule channel index using tr51 channel function.
  * @param channel_table Channel table.
@@ -69,6 +69,10 @@ void (*fhss_bc_switch)(void) = NULL;
 #define WH_IE_ID        0x2a
 #define WH_SUB_ID_UTT   1
 #define WH_SUB_ID_BT    2
+// Hop sequences of the own schedules, then the neighbours
+#define HOP_SEQUENCE_OWN_UC     0
+#define HOP_SEQUENCE_OWN_BC     1
+#define HOP_SEQUENCE_NEIGHBOR   2
 
 #ifdef HAVE_WS
 
@@ -87,6 +91,7 @@ static bool fhss_ws_check_tx_allowed(fhss_structure_t *fhss_structure);
 static bool fhss_allow_transmitting_on_rx_slot(fhss_structure_t *fhss_structure);
 static bool fhss_allow_unicast_on_broadcast_channel(fhss_structure_t *fhss_structure);
 static int32_t fhss_channel_index_from_mask(const uint32_t *channel_mask, int32_t channel_index, uint16_t number_of_channels);
+static int32_t fhss_ws_hop_sequence_channel(fhss_structure_t *fhss_structure, fhss_ws_hop_sequence_t *sequence, uint8_t channel_function, uint8_t *eui64, uint16_t number_of_channels, const uint32_t *channel_mask, uint16_t slot);
 
 // This function supports rounding up
 static int64_t divide_integer(int64_t dividend, int32_t divisor)
@@ -192,11 +197,109 @@ static int fhss_ws_manage_channel_table_allocation(fhss_structure_t *fhss_struct
             ns_dyn_mem_free(fhss_structure->ws->tr51_channel_table);
             return -1;
         }
+        // Own schedules and the neighbour cache, with a channel table of each
+        uint16_t hop_sequence_count = HOP_SEQUENCE_NEIGHBOR + FHSS_WS_HOP_SEQUENCE_CACHE_SIZE;
+        fhss_ws_hop_sequence_t *hop_sequences = ns_dyn_mem_alloc((sizeof(fhss_ws_hop_sequence_t) + channel_count) * hop_sequence_count);
+        if (!hop_sequences) {
+            ns_dyn_mem_free(fhss_structure->ws->tr51_channel_table);
+            fhss_structure->ws->tr51_channel_table = NULL;
+            ns_dyn_mem_free(fhss_structure->ws->tr51_output_table);
+            fhss_structure->ws->tr51_output_table = NULL;
+            return -1;
+        }
+        uint8_t *channels = (uint8_t *)(hop_sequences + hop_sequence_count);
+        for (uint16_t i = 0; i < hop_sequence_count; i++) {
+            memset(&hop_sequences[i], 0, sizeof(fhss_ws_hop_sequence_t));
+            hop_sequences[i].channels = channels + i * channel_count;
+        }
+        ns_dyn_mem_free(fhss_structure->ws->hop_sequences);
+        fhss_structure->ws->hop_sequences = hop_sequences;
+        fhss_structure->ws->hop_sequence_length = channel_count;
         tr51_init_channel_table(fhss_structure->ws->tr51_channel_table, channel_count);
     }
     return 0;
 }
 
+static void fhss_ws_hop_sequence_invalidate(fhss_structure_t *fhss_structure)
+{
+    for (uint16_t i = 0; i < HOP_SEQUENCE_NEIGHBOR + FHSS_WS_HOP_SEQUENCE_CACHE_SIZE; i++) {
+        fhss_structure->ws->hop_sequences[i].number_of_channels = 0;
+    }
+}
+
+static void fhss_ws_hop_sequence_key(fhss_structure_t *fhss_structure, uint8_t channel_function, const uint8_t *eui64, uint8_t key[8])
+{
+    memset(key, 0, 8);
+    // DH1CF hashes the node with the slot, only the channel mask is precomputed
+    if (channel_function != WS_TR51CF) {
+        return;
+    }
+    if (eui64) {
+        memcpy(key, eui64, 8);
+    } else {
+        common_write_16_bit(fhss_structure->ws->fhss_configuration.bsi, &key[6]);
+    }
+}
+
+static bool fhss_ws_hop_sequence_match(const fhss_ws_hop_sequence_t *sequence, uint8_t channel_function, const uint8_t key[8], uint16_t number_of_channels, const uint32_t *channel_mask)
+{
+    return sequence->number_of_channels == number_of_channels &&
+           sequence->channel_function == channel_function &&
+           memcmp(sequence->eui64, key, 8) == 0 &&
+           memcmp(sequence->channel_mask, channel_mask, sizeof(sequence->channel_mask)) == 0;
+}
+
+/* Cached sequence of a neighbour schedule, or the least recently used one to be computed again */
+static fhss_ws_hop_sequence_t *fhss_ws_neighbor_hop_sequence(fhss_structure_t *fhss_structure, uint8_t channel_function, uint8_t *eui64, uint16_t number_of_channels, const uint32_t *channel_mask)
+{
+    uint8_t key[8];
+    fhss_ws_hop_sequence_key(fhss_structure, channel_function, eui64, key);
+    fhss_ws_hop_sequence_t *oldest = NULL;
+    for (uint16_t i = HOP_SEQUENCE_NEIGHBOR; i < HOP_SEQUENCE_NEIGHBOR + FHSS_WS_HOP_SEQUENCE_CACHE_SIZE; i++) {
+        fhss_ws_hop_sequence_t *sequence = &fhss_structure->ws->hop_sequences[i];
+        if (fhss_ws_hop_sequence_match(sequence, channel_function, key, number_of_channels, channel_mask)) {
+            return sequence;
+        }
+        if (!oldest || (int32_t)(sequence->last_used - oldest->last_used) < 0) {
+            oldest = sequence;
+        }
+    }
+    return oldest;
+}
+
+static void fhss_ws_hop_sequence_calculate(fhss_structure_t *fhss_structure, fhss_ws_hop_sequence_t *sequence, uint8_t channel_function, const uint8_t key[8], uint16_t number_of_channels, const uint32_t *channel_mask)
+{
+    uint16_t length = fhss_structure->ws->hop_sequence_length;
+    uint8_t *channels = sequence->channels;
+    uint16_t active_channels = 0;
+
+    // Channel of each channel index, as fhss_channel_index_from_mask()
+    for (uint16_t i = 0; i < fhss_structure->number_of_channels && active_channels < length; i++) {
+        if (channel_mask[i / 32] & (1U << (i % 32))) {
+            channels[active_channels++] = i;
+        }
+    }
+    memset(channels + active_channels, 0, length - active_channels);
+
+    if (channel_function == WS_TR51CF) {
+        uint8_t *output_table = fhss_structure->ws->tr51_output_table;
+        if (sequence == &fhss_structure->ws->hop_sequences[HOP_SEQUENCE_OWN_BC]) {
+            tr51_get_bc_hopping_sequence(fhss_structure->ws->tr51_channel_table, output_table, fhss_structure->ws->fhss_configuration.bsi, number_of_channels, NULL);
+        } else {
+            tr51_get_uc_hopping_sequence(fhss_structure->ws->tr51_channel_table, output_table, (uint8_t *)key, number_of_channels, NULL);
+        }
+        for (uint16_t i = 0; i < number_of_channels; i++) {
+            output_table[i] = channels[output_table[i]];
+        }
+        memcpy(channels, output_table, number_of_channels);
+    }
+
+    memcpy(sequence->eui64, key, 8);
+    sequence->channel_function = channel_function;
+    sequence->number_of_channels = number_of_channels;
+    memcpy(sequence->channel_mask, channel_mask, sizeof(sequence->channel_mask));
+}
+
 void fhss_set_txrx_slot_length(fhss_structure_t *fhss_structure)
 {
     // No broadcast schedule, no TX slots
@@ -254,15 +357,13 @@ static int32_t fhss_ws_calc_bc_channel(fhss_structure_t *fhss_structure)
     int32_t next_channel = fhss_structure->ws->fhss_configuration.broadcast_fixed_channel;
 
     if (fhss_structure->ws->fhss_configuration.ws_bc_channel_function == WS_TR51CF) {
-        next_channel = tr51_get_bc_channel_index(fhss_structure->ws->tr51_channel_table, fhss_structure->ws->tr51_output_table, fhss_structure->ws->bc_slot, fhss_structure->ws->fhss_configuration.bsi, fhss_structure->number_of_bc_channels, NULL);
-        next_channel = fhss_channel_index_from_mask(fhss_structure->ws->fhss_configuration.channel_mask, next_channel, fhss_structure->number_of_channels);
+        next_channel = fhss_ws_hop_sequence_channel(fhss_structure, &fhss_structure->ws->hop_sequences[HOP_SEQUENCE_OWN_BC], WS_TR51CF, NULL, fhss_structure->number_of_bc_channels, fhss_structure->ws->fhss_configuration.channel_mask, fhss_structure->ws->bc_slot);
         if (++fhss_structure->ws->bc_slot == fhss_structure->number_of_bc_channels) {
             fhss_structure->ws->bc_slot = 0;
         }
     } else if (fhss_structure->ws->fhss_configuration.ws_bc_channel_function == WS_DH1CF) {
         fhss_structure->ws->bc_slot++;
-        next_channel = dh1cf_get_bc_channel_index(fhss_structure->ws->bc_slot, fhss_structure->ws->fhss_configuration.bsi, fhss_structure->number_of_bc_channels);
-        next_channel = fhss_channel_index_from_mask(fhss_structure->ws->fhss_configuration.channel_mask, next_channel, fhss_structure->number_of_channels);
+        next_channel = fhss_ws_hop_sequence_channel(fhss_structure, &fhss_structure->ws->hop_sequences[HOP_SEQUENCE_OWN_BC], WS_DH1CF, NULL, fhss_structure->number_of_bc_channels, fhss_structure->ws->fhss_configuration.channel_mask, fhss_structure->ws->bc_slot);
     } else if (fhss_structure->ws->fhss_configuration.ws_bc_channel_function == WS_VENDOR_DEF_CF) {
         if (fhss_structure->ws->fhss_configuration.vendor_defined_cf) {
             next_channel = fhss_structure->ws->fhss_configuration.vendor_defined_cf(fhss_structure->fhss_api, fhss_structure->ws->bc_slot, NULL, fhss_structure->ws->fhss_configuration.bsi, fhss_structure->number_of_channels);
@@ -302,6 +403,44 @@ static int32_t fhss_channel_index_from_mask(const uint32_t *channel_mask, int32_
     return 0;
 }
 
+/* Channel of a schedule in the slot, broadcast schedule when eui64 is NULL. Channels
+ * are looked up from "sequence", computed again only when the schedule has changed.
+ */
+static int32_t fhss_ws_hop_sequence_channel(fhss_structure_t *fhss_structure, fhss_ws_hop_sequence_t *sequence, uint8_t channel_function, uint8_t *eui64, uint16_t number_of_channels, const uint32_t *channel_mask, uint16_t slot)
+{
+    int32_t channel_index;
+    if (channel_function == WS_DH1CF) {
+        if (eui64) {
+            channel_index = dh1cf_get_uc_channel_index(slot, eui64, number_of_channels);
+        } else {
+            channel_index = dh1cf_get_bc_channel_index(slot, fhss_structure->ws->fhss_configuration.bsi, number_of_channels);
+        }
+    } else {
+        // Slot may be past the end of the sequence after synchronising to parent
+        channel_index = slot % number_of_channels;
+    }
+
+    // Schedules of neighbours with more channels than the tables are computed as is
+    if (number_of_channels > fhss_structure->ws->hop_sequence_length) {
+        if (channel_function == WS_TR51CF) {
+            if (eui64) {
+                channel_index = tr51_get_uc_channel_index(fhss_structure->ws->tr51_channel_table, fhss_structure->ws->tr51_output_table, channel_index, eui64, number_of_channels, NULL);
+            } else {
+                channel_index = tr51_get_bc_channel_index(fhss_structure->ws->tr51_channel_table, fhss_structure->ws->tr51_output_table, channel_index, fhss_structure->ws->fhss_configuration.bsi, number_of_channels, NULL);
+            }
+        }
+        return fhss_channel_index_from_mask(channel_mask, channel_index, fhss_structure->number_of_channels);
+    }
+
+    uint8_t key[8];
+    fhss_ws_hop_sequence_key(fhss_structure, channel_function, eui64, key);
+    if (!fhss_ws_hop_sequence_match(sequence, channel_function, key, number_of_channels, channel_mask)) {
+        fhss_ws_hop_sequence_calculate(fhss_structure, sequence, channel_function, key, number_of_channels, channel_mask);
+    }
+    sequence->last_used = ++fhss_structure->ws->hop_sequence_used;
+    return sequence->channels[channel_index];
+}
+
 static void fhss_broadcast_handler(const fhss_api_t *fhss_api, uint16_t delay)
 {
     (void) delay;
@@ -632,14 +771,12 @@ static void fhss_ws_update_uc_channel_callback(fhss_structure_t *fhss_structure)
     if (fhss_structure->ws->fhss_configuration.ws_uc_channel_function == WS_FIXED_CHANNEL) {
         return;
     } else if (fhss_structure->ws->fhss_configuration.ws_uc_channel_function == WS_TR51CF) {
-        next_channel = tr51_get_uc_channel_index(fhss_structure->ws->tr51_channel_table, fhss_structure->ws->tr51_output_table, fhss_structure->ws->uc_slot, mac_address, fhss_structure->number_of_uc_channels, NULL);
-        next_channel = fhss_structure->rx_channel = fhss_channel_index_from_mask(fhss_structure->ws->fhss_configuration.unicast_channel_mask, next_channel, fhss_structure->number_of_channels);
+        next_channel = fhss_structure->rx_channel = fhss_ws_hop_sequence_channel(fhss_structure, &fhss_structure->ws->hop_sequences[HOP_SEQUENCE_OWN_UC], WS_TR51CF, mac_address, fhss_structure->number_of_uc_channels, fhss_structure->ws->fhss_configuration.unicast_channel_mask, fhss_structure->ws->uc_slot);
         if (++fhss_structure->ws->uc_slot == fhss_structure->number_of_uc_channels) {
             fhss_structure->ws->uc_slot = 0;
         }
     } else if (fhss_structure->ws->fhss_configuration.ws_uc_channel_function == WS_DH1CF) {
-        next_channel = dh1cf_get_uc_channel_index(fhss_structure->ws->uc_slot, mac_address, fhss_structure->number_of_uc_channels);
-        next_channel = fhss_structure->rx_channel = fhss_channel_index_from_mask(fhss_structure->ws->fhss_configuration.unicast_channel_mask, next_channel, fhss_structure->number_of_channels);
+        next_channel = fhss_structure->rx_channel = fhss_ws_hop_sequence_channel(fhss_structure, &fhss_structure->ws->hop_sequences[HOP_SEQUENCE_OWN_UC], WS_DH1CF, mac_address, fhss_structure->number_of_uc_channels, fhss_structure->ws->fhss_configuration.unicast_channel_mask, fhss_structure->ws->uc_slot);
         fhss_structure->ws->uc_slot++;
     } else if (fhss_structure->ws->fhss_configuration.ws_uc_channel_function == WS_VENDOR_DEF_CF) {
         if (fhss_structure->ws->fhss_configuration.vendor_defined_cf) {
@@ -703,11 +840,13 @@ static int fhss_ws_tx_handle_callback(const fhss_api_t *api, bool is_broadcast_a
         uint16_t destination_slot = fhss_ws_calculate_destination_slot(neighbor_timing_info, tx_time);
         int32_t tx_channel = neighbor_timing_info->uc_timing_info.fixed_channel;
         if (neighbor_timing_info->uc_timing_info.unicast_channel_function == WS_TR51CF) {
-            tx_channel = tr51_get_uc_channel_index(fhss_structure->ws->tr51_channel_table, fhss_structure->ws->tr51_output_table, destination_slot, destination_address, neighbor_timing_info->uc_timing_info.unicast_number_of_channels, NULL);
-            tx_channel = fhss_channel_index_from_mask(neighbor_timing_info->uc_channel_list.channel_mask, tx_channel, fhss_structure->number_of_channels);
+            uint16_t number_of_channels = neighbor_timing_info->uc_timing_info.unicast_number_of_channels;
+            fhss_ws_hop_sequence_t *sequence = fhss_ws_neighbor_hop_sequence(fhss_structure, WS_TR51CF, destination_address, number_of_channels, neighbor_timing_info->uc_channel_list.channel_mask);
+            tx_channel = fhss_ws_hop_sequence_channel(fhss_structure, sequence, WS_TR51CF, destination_address, number_of_channels, neighbor_timing_info->uc_channel_list.channel_mask, destination_slot);
         } else if (neighbor_timing_info->uc_timing_info.unicast_channel_function == WS_DH1CF) {
-            tx_channel = dh1cf_get_uc_channel_index(destination_slot, destination_address, neighbor_timing_info->uc_channel_list.channel_count);
-            tx_channel = fhss_channel_index_from_mask(neighbor_timing_info->uc_channel_list.channel_mask, tx_channel, fhss_structure->number_of_channels);
+            uint16_t number_of_channels = neighbor_timing_info->uc_channel_list.channel_count;
+            fhss_ws_hop_sequence_t *sequence = fhss_ws_neighbor_hop_sequence(fhss_structure, WS_DH1CF, destination_address, number_of_channels, neighbor_timing_info->uc_channel_list.channel_mask);
+            tx_channel = fhss_ws_hop_sequence_channel(fhss_structure, sequence, WS_DH1CF, destination_address, number_of_channels, neighbor_timing_info->uc_channel_list.channel_mask, destination_slot);
         } else if (neighbor_timing_info->uc_timing_info.unicast_channel_function == WS_VENDOR_DEF_CF) {
             if (fhss_structure->ws->fhss_configuration.vendor_defined_cf) {
                 tx_channel = fhss_structure->ws->fhss_configuration.vendor_defined_cf(fhss_structure->fhss_api, fhss_structure->ws->bc_slot, destination_address, fhss_structure->ws->fhss_configuration.bsi, neighbor_timing_info->uc_timing_info.unicast_number_of_channels);
@@ -1234,6 +1373,7 @@ int fhss_ws_configuration_set(fhss_structure_t *fhss_structure, const fhss_ws_co
     fhss_structure->number_of_channels = fhss_configuration->channel_mask_size;
     fhss_structure->number_of_bc_channels = channel_count_bc;
     fhss_structure->number_of_uc_channels = channel_count_uc;
+    fhss_ws_hop_sequence_invalidate(fhss_structure);
     if (fhss_configuration->ws_uc_channel_function == WS_FIXED_CHANNEL) {
         fhss_structure->rx_channel = fhss_configuration->unicast_fixed_channel;
     }
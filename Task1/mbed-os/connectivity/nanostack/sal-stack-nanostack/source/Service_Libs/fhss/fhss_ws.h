@@ -35,8 +35,24 @@
 #define EXPEDITED_FORWARDING_POLL_PERIOD    (5000 / 50)
 // TX poll interval used when channel schedules are not yet started (50us slots)
 #define DEFAULT_POLL_PERIOD    (10000 / 50)
+// Number of neighbour unicast schedules with precomputed hopping sequences
+#ifndef FHSS_WS_HOP_SEQUENCE_CACHE_SIZE
+#define FHSS_WS_HOP_SEQUENCE_CACHE_SIZE     8
+#endif
 typedef struct fhss_ws fhss_ws_t;
 
+/* Precomputed channels of a schedule, with the channel mask applied. TR51: channel of
+ * each slot. DH1CF: channel of each channel index, as the slot is hashed.
+ */
+typedef struct fhss_ws_hop_sequence {
+    uint8_t eui64[8];               // Node of a TR51 sequence, BSI in the last two bytes for broadcast
+    uint8_t channel_function;
+    uint16_t number_of_channels;    // 0 when not computed
+    uint32_t last_used;
+    uint32_t channel_mask[8];
+    uint8_t *channels;
+} fhss_ws_hop_sequence_t;
+
 struct fhss_ws {
     uint8_t bc_channel;
     uint16_t uc_slot;
@@ -48,6 +64,9 @@ struct fhss_ws {
     int32_t drift_per_millisecond_ns;
     int16_t *tr51_channel_table;
     uint8_t *tr51_output_table;
+    uint16_t hop_sequence_length;
+    uint32_t hop_sequence_used;
+    fhss_ws_hop_sequence_t *hop_sequences;
     uint32_t next_uc_timeout;
     uint32_t next_bc_timeout;
     uint32_t expedited_forwarding_enabled_us;
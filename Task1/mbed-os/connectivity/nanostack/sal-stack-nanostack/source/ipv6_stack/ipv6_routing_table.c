@@ -42,6 +42,7 @@
 #include "Common_Protocols/ipv6_constants.h"
 #include "Common_Protocols/icmpv6.h"
 #include "nsdynmemLIB.h"
+#include "Core/include/ns_mem_slab.h"
 #include "Service_Libs/etx/etx.h"
 #include "Common_Protocols/ipv6_resolution.h"
 #include <stdarg.h>
@@ -105,6 +106,76 @@ static uint8_t ipv6_route_table_get_max_entries(int8_t interface_id, ipv6_route_
 
 static uint16_t dcache_gc_timer;
 
+/* Destination Cache is also kept in a hash by address, to avoid walking the list for every packet */
+static ipv6_destination_t *ipv6_destination_hash[IPV6_DESTINATION_HASH_SIZE];
+static uint16_t ipv6_destination_count;
+
+/* FNV-1a hash of an address, folded to a power of two buckets */
+static uint_fast16_t ipv6_address_hash(const uint8_t *address, uint_fast8_t len, uint_fast16_t buckets)
+{
+    uint32_t hash = 2166136261u;
+
+    while (len--) {
+        hash = (hash ^ *address++) * 16777619u;
+    }
+
+    return (hash ^ (hash >> 16)) & (buckets - 1);
+}
+
+#define ipv6_neighbour_hash_bucket(cache, address) \
+    (&(cache)->hash[ipv6_address_hash(address, 16, IPV6_NEIGHBOUR_HASH_SIZE)])
+#define ipv6_neighbour_ll_hash_bucket(cache, ll_type, ll_address) \
+    (&(cache)->ll_hash[ipv6_address_hash(ll_address, addr_len_from_type(ll_type), IPV6_NEIGHBOUR_HASH_SIZE)])
+#define ipv6_destination_hash_bucket(address) \
+    (&ipv6_destination_hash[ipv6_address_hash(address, 16, IPV6_DESTINATION_HASH_SIZE)])
+
+/* Neighbour entry with the LL address and the EUI-64 of registration. The
+ * slab free needs the size, so with slabs it doesn't follow cache settings
+ * that may change while the entry exists: 2 + 8 is the longest LL address.
+ */
+#ifdef HAVE_MEM_SLAB
+#define IPV6_NEIGHBOUR_ALLOC_SIZE(cache) (sizeof(ipv6_neighbour_t) + 2 + 8 + 8)
+#else
+#define IPV6_NEIGHBOUR_ALLOC_SIZE(cache) (sizeof(ipv6_neighbour_t) + (cache)->max_ll_len + ((cache)->recv_addr_reg ? 8 : 0))
+#endif
+
+static void ipv6_neighbour_ll_hash_remove(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry)
+{
+    if (entry->ll_type == ADDR_NONE) {
+        return;
+    }
+
+    for (ipv6_neighbour_t **p = ipv6_neighbour_ll_hash_bucket(cache, entry->ll_type, entry->ll_address); *p; p = &(*p)->ll_hash_next) {
+        if (*p == entry) {
+            *p = entry->ll_hash_next;
+            break;
+        }
+    }
+}
+
+static void ipv6_neighbour_ll_hash_add(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry)
+{
+    if (entry->ll_type == ADDR_NONE) {
+        return;
+    }
+
+    ipv6_neighbour_t **bucket = ipv6_neighbour_ll_hash_bucket(cache, entry->ll_type, entry->ll_address);
+    entry->ll_hash_next = *bucket;
+    *bucket = entry;
+}
+
+/* Entries with a timer running are also in the timer list, so the fast timer only visits those */
+static void ipv6_neighbour_timer_set(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry, uint32_t timer)
+{
+    if (timer && !entry->timer) {
+        /* Added to the start - not visited again by a fast timer pass in progress */
+        ns_list_add_to_start(&cache->timer_list, entry);
+    } else if (!timer && entry->timer) {
+        ns_list_remove(&cache->timer_list, entry);
+    }
+    entry->timer = timer;
+}
+
 static uint32_t next_probe_time(ipv6_neighbour_cache_t *cache, uint_fast8_t retrans_num)
 {
     uint32_t t = cache->retrans_timer;
@@ -220,6 +291,9 @@ void ipv6_neighbour_cache_init(ipv6_neighbour_cache_t *cache, int8_t interface_i
     ns_list_foreach_safe(ipv6_neighbour_t, cur, &cache->list) {
         ipv6_neighbour_entry_remove(cache, cur);
     }
+    ns_list_init(&cache->timer_list);
+    memset(cache->hash, 0, sizeof(cache->hash));
+    memset(cache->ll_hash, 0, sizeof(cache->ll_hash));
     cache->gc_timer = NCACHE_GC_PERIOD;
     cache->retrans_timer = 1000;
     cache->max_ll_len = 0;
@@ -247,7 +321,7 @@ void ipv6_neighbour_cache_flush(ipv6_neighbour_cache_t *cache)
 
 ipv6_neighbour_t *ipv6_neighbour_lookup(ipv6_neighbour_cache_t *cache, const uint8_t *address)
 {
-    ns_list_foreach(ipv6_neighbour_t, cur, &cache->list) {
+    for (ipv6_neighbour_t *cur = *ipv6_neighbour_hash_bucket(cache, address); cur; cur = cur->hash_next) {
         if (addr_ipv6_equal(cur->ip_address, address)) {
             return cur;
         }
@@ -274,6 +348,14 @@ void ipv6_neighbour_entry_remove(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t
      * the entry.
      */
     ns_list_remove(&cache->list, entry);
+    for (ipv6_neighbour_t **p = ipv6_neighbour_hash_bucket(cache, entry->ip_address); *p; p = &(*p)->hash_next) {
+        if (*p == entry) {
+            *p = entry->hash_next;
+            break;
+        }
+    }
+    ipv6_neighbour_ll_hash_remove(cache, entry);
+    ipv6_neighbour_timer_set(cache, entry, 0);
     switch (entry->state) {
         case IP_NEIGHBOUR_NEW:
             break;
@@ -296,29 +378,29 @@ void ipv6_neighbour_entry_remove(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t
             break;
     }
     ipv6_destination_cache_forget_neighbour(entry);
-    ns_dyn_mem_free(entry);
+    ns_mem_slab_free(entry, IPV6_NEIGHBOUR_ALLOC_SIZE(cache));
 }
 
 ipv6_neighbour_t *ipv6_neighbour_lookup_or_create(ipv6_neighbour_cache_t *cache, const uint8_t *address/*, bool tentative*/)
 {
     uint_fast16_t count = 0;
-    ipv6_neighbour_t *entry = NULL;
+    ipv6_neighbour_t *entry = ipv6_neighbour_lookup(cache, address);
     ipv6_neighbour_t *garbage_possible_entry = NULL;
 
-    ns_list_foreach(ipv6_neighbour_t, cur, &cache->list) {
+    if (entry) {
+        if (entry != ns_list_get_first(&cache->list)) {
+            ns_list_remove(&cache->list, entry);
+            ns_list_add_to_start(&cache->list, entry);
+        }
+        return entry;
+    }
 
+    /* Only a new entry needs the count, and the least recently used entry to push out */
+    ns_list_foreach(ipv6_neighbour_t, cur, &cache->list) {
         if (cur->type == IP_NEIGHBOUR_GARBAGE_COLLECTIBLE) {
             garbage_possible_entry = cur;
             count++;
         }
-
-        if (addr_ipv6_equal(cur->ip_address, address)) {
-            if (cur != ns_list_get_first(&cache->list)) {
-                ns_list_remove(&cache->list, cur);
-                ns_list_add_to_start(&cache->list, cur);
-            }
-            return cur;
-        }
     }
 
     if (count >= neighbour_cache_config.max_entries && garbage_possible_entry) {
@@ -330,7 +412,7 @@ ipv6_neighbour_t *ipv6_neighbour_lookup_or_create(ipv6_neighbour_cache_t *cache,
     // plus another 8 for the EUI-64 of registration (RFC 6775). Note that in
     // the protocols, the link-layer address and EUI-64 are distinct. The
     // neighbour may be using a short link-layer address, not its EUI-64.
-    entry = ns_dyn_mem_alloc(sizeof(ipv6_neighbour_t) + cache->max_ll_len + (cache->recv_addr_reg ? 8 : 0));
+    entry = ns_mem_slab_alloc(IPV6_NEIGHBOUR_ALLOC_SIZE(cache));
     if (!entry) {
         tr_warn("No mem!");
         return NULL;
@@ -354,6 +436,9 @@ ipv6_neighbour_t *ipv6_neighbour_lookup_or_create(ipv6_neighbour_cache_t *cache,
     }
 
     ns_list_add_to_start(&cache->list, entry);
+    ipv6_neighbour_t **bucket = ipv6_neighbour_hash_bucket(cache, address);
+    entry->hash_next = *bucket;
+    *bucket = entry;
 
     return entry;
 }
@@ -388,7 +473,7 @@ ipv6_neighbour_t *ipv6_neighbour_used(ipv6_neighbour_cache_t *cache, ipv6_neighb
 
     /* Special case for Registered Unreachable entries - restart the probe timer if stopped */
     else if (entry->state == IP_NEIGHBOUR_UNREACHABLE && entry->timer == 0) {
-        entry->timer = next_probe_time(cache, entry->retrans_count);
+        ipv6_neighbour_timer_set(cache, entry, next_probe_time(cache, entry->retrans_count));
     }
 
     return entry;
@@ -436,7 +521,29 @@ bool ipv6_neighbour_ll_addr_match(const ipv6_neighbour_t *entry, addrtype_t ll_t
     return ll_type == entry->ll_type && memcmp(entry->ll_address, ll_address, addr_len_from_type(ll_type)) == 0;
 }
 
-static bool ipv6_neighbour_update_ll(ipv6_neighbour_t *entry, addrtype_t ll_type, const uint8_t *ll_address)
+/* Changes the LL address and moves the entry to its LL address hash bucket */
+static void ipv6_neighbour_set_ll(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry, addrtype_t ll_type, const uint8_t *ll_address)
+{
+    ipv6_neighbour_ll_hash_remove(cache, entry);
+    entry->ll_type = ll_type;
+    memcpy(entry->ll_address, ll_address, addr_len_from_type(ll_type));
+    ipv6_neighbour_ll_hash_add(cache, entry);
+}
+
+ipv6_neighbour_t *ipv6_neighbour_lookup_ll_addr_next(ipv6_neighbour_cache_t *cache, addrtype_t ll_type, const uint8_t *ll_address, const ipv6_neighbour_t *prev)
+{
+    ipv6_neighbour_t *cur = prev ? prev->ll_hash_next : *ipv6_neighbour_ll_hash_bucket(cache, ll_type, ll_address);
+
+    for (; cur; cur = cur->ll_hash_next) {
+        if (ipv6_neighbour_ll_addr_match(cur, ll_type, ll_address)) {
+            return cur;
+        }
+    }
+
+    return NULL;
+}
+
+static bool ipv6_neighbour_update_ll(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry, addrtype_t ll_type, const uint8_t *ll_address)
 {
     uint8_t ll_len = addr_len_from_type(ll_type);
 
@@ -446,8 +553,7 @@ static bool ipv6_neighbour_update_ll(ipv6_neighbour_t *entry, addrtype_t ll_type
     entry->from_redirect = false;
 
     if (ll_type != entry->ll_type || memcmp(entry->ll_address, ll_address, ll_len)) {
-        entry->ll_type = ll_type;
-        memcpy(entry->ll_address, ll_address, ll_len);
+        ipv6_neighbour_set_ll(cache, entry, ll_type, ll_address);
         return true;
     }
     return false;
@@ -455,8 +561,10 @@ static bool ipv6_neighbour_update_ll(ipv6_neighbour_t *entry, addrtype_t ll_type
 
 void ipv6_neighbour_invalidate_ll_addr(ipv6_neighbour_cache_t *cache, addrtype_t ll_type, const uint8_t *ll_address)
 {
-    ns_list_foreach_safe(ipv6_neighbour_t, cur, &cache->list) {
-        if (cur->type == IP_NEIGHBOUR_GARBAGE_COLLECTIBLE && ipv6_neighbour_ll_addr_match(cur, ll_type, ll_address)) {
+    ipv6_neighbour_t *next;
+    for (ipv6_neighbour_t *cur = ipv6_neighbour_lookup_ll_addr_next(cache, ll_type, ll_address, NULL); cur; cur = next) {
+        next = ipv6_neighbour_lookup_ll_addr_next(cache, ll_type, ll_address, cur);
+        if (cur->type == IP_NEIGHBOUR_GARBAGE_COLLECTIBLE) {
             ipv6_neighbour_entry_remove(cache, cur);
         }
     }
@@ -501,27 +609,27 @@ void ipv6_neighbour_set_state(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *e
     switch (state) {
         case IP_NEIGHBOUR_INCOMPLETE:
             entry->retrans_count = 0;
-            entry->timer = cache->retrans_timer;
+            ipv6_neighbour_timer_set(cache, entry, cache->retrans_timer);
             break;
         case IP_NEIGHBOUR_STALE:
-            entry->timer = 0;
+            ipv6_neighbour_timer_set(cache, entry, 0);
             break;
         case IP_NEIGHBOUR_DELAY:
-            entry->timer = DELAY_FIRST_PROBE_TIME;
+            ipv6_neighbour_timer_set(cache, entry, DELAY_FIRST_PROBE_TIME);
             break;
         case IP_NEIGHBOUR_PROBE:
             entry->retrans_count = 0;
-            entry->timer = next_probe_time(cache, 0);
+            ipv6_neighbour_timer_set(cache, entry, next_probe_time(cache, 0));
             break;
         case IP_NEIGHBOUR_REACHABLE:
-            entry->timer = cache->reachable_time;
+            ipv6_neighbour_timer_set(cache, entry, cache->reachable_time);
             break;
         case IP_NEIGHBOUR_UNREACHABLE:
             /* Progress to this from PROBE - timers continue */
             ipv6_neighbour_gone(cache, entry->ip_address);
             break;
         default:
-            entry->timer = 0;
+            ipv6_neighbour_timer_set(cache, entry, 0);
             break;
     }
     entry->state = state;
@@ -530,7 +638,7 @@ void ipv6_neighbour_set_state(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *e
 /* Called when LL address information is received other than in an NA (NS source, RS source, RA source, Redirect target) */
 void ipv6_neighbour_entry_update_unsolicited(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry, addrtype_t type, const uint8_t *ll_address/*, bool tentative*/)
 {
-    bool modified_ll = ipv6_neighbour_update_ll(entry, type, ll_address);
+    bool modified_ll = ipv6_neighbour_update_ll(cache, entry, type, ll_address);
 
     switch (entry->state) {
         case IP_NEIGHBOUR_NEW:
@@ -568,7 +676,7 @@ void ipv6_neighbour_update_from_na(ipv6_neighbour_cache_t *cache, ipv6_neighbour
             return;
         }
 
-        ipv6_neighbour_update_ll(entry, ll_type, ll_address);
+        ipv6_neighbour_update_ll(cache, entry, ll_type, ll_address);
         if (flags & NA_S) {
             ipv6_neighbour_set_state(cache, entry, IP_NEIGHBOUR_REACHABLE);
         } else {
@@ -583,8 +691,7 @@ void ipv6_neighbour_update_from_na(ipv6_neighbour_cache_t *cache, ipv6_neighbour
 
     if (ll_addr_differs) {
         if (flags & NA_O) {
-            entry->ll_type = ll_type;
-            memcpy(entry->ll_address, ll_address, addr_len_from_type(ll_type));
+            ipv6_neighbour_set_ll(cache, entry, ll_type, ll_address);
         } else {
             if (entry->state == IP_NEIGHBOUR_REACHABLE) {
                 ipv6_neighbour_set_state(cache, entry, IP_NEIGHBOUR_STALE);
@@ -792,17 +899,14 @@ void ipv6_neighbour_cache_fast_timer(ipv6_neighbour_cache_t *cache, uint16_t tic
 {
     uint32_t ms = (uint32_t) ticks * 100;
 
-    ns_list_foreach_safe(ipv6_neighbour_t, cur, &cache->list) {
-        if (cur->timer == 0) {
-            continue;
-        }
-
+    /* Only entries with a timer running are in the list */
+    ns_list_foreach_safe(ipv6_neighbour_t, cur, &cache->timer_list) {
         if (cur->timer > ms) {
             cur->timer -= ms;
             continue;
         }
 
-        cur->timer = 0;
+        ipv6_neighbour_timer_set(cache, cur, 0);
 
         /* Timer expired */
         switch (cur->state) {
@@ -816,7 +920,7 @@ void ipv6_neighbour_cache_fast_timer(ipv6_neighbour_cache_t *cache, uint16_t tic
                     ipv6_neighbour_entry_remove(cache, cur);
                 } else {
                     ipv6_interface_resolve_send_ns(cache, cur, false, cur->retrans_count);
-                    cur->timer = cache->retrans_timer;
+                    ipv6_neighbour_timer_set(cache, cur, cache->retrans_timer);
                 }
                 break;
             case IP_NEIGHBOUR_STALE:
@@ -853,14 +957,14 @@ void ipv6_neighbour_cache_fast_timer(ipv6_neighbour_cache_t *cache, uint16_t tic
                         /* "Final" unicast probe */
                         if (cur->type == IP_NEIGHBOUR_GARBAGE_COLLECTIBLE) {
                             /* Only wait 1 initial retrans time for response to final probe - don't want backoff in this case */
-                            cur->timer = cache->retrans_timer;
+                            ipv6_neighbour_timer_set(cache, cur, cache->retrans_timer);
                         } else {
                             /* We're not going to remove this. Let's stop the timer. We'll restart to probe once more if it's used */
-                            cur->timer = 0;
+                            ipv6_neighbour_timer_set(cache, cur, 0);
                         }
                     } else {
                         /* Backoff for the next probe */
-                        cur->timer = next_probe_time(cache, cur->retrans_count);
+                        ipv6_neighbour_timer_set(cache, cur, next_probe_time(cache, cur->retrans_count));
                     }
                 }
                 break;
@@ -893,7 +997,7 @@ static ipv6_destination_t *ipv6_destination_lookup(const uint8_t *address, int8_
         return NULL;
     }
 
-    ns_list_foreach(ipv6_destination_t, cur, &ipv6_destination_cache) {
+    for (ipv6_destination_t *cur = *ipv6_destination_hash_bucket(address); cur; cur = cur->hash_next) {
         if (!addr_ipv6_equal(cur->destination, address)) {
             continue;
         }
@@ -922,7 +1026,6 @@ static ipv6_destination_t *ipv6_destination_lookup(const uint8_t *address, int8_
  */
 ipv6_destination_t *ipv6_destination_lookup_or_create(const uint8_t *address, int8_t interface_id)
 {
-    uint_fast16_t count = 0;
     ipv6_destination_t *entry = NULL;
     bool interface_specific = addr_ipv6_scope(address, NULL) <= IPV6_SCOPE_REALM_LOCAL;
 
@@ -931,8 +1034,7 @@ ipv6_destination_t *ipv6_destination_lookup_or_create(const uint8_t *address, in
     }
 
     /* Find any existing entry */
-    ns_list_foreach(ipv6_destination_t, cur, &ipv6_destination_cache) {
-        count++;
+    for (ipv6_destination_t *cur = *ipv6_destination_hash_bucket(address); cur; cur = cur->hash_next) {
         if (!addr_ipv6_equal(cur->destination, address)) {
             continue;
         }
@@ -947,7 +1049,7 @@ ipv6_destination_t *ipv6_destination_lookup_or_create(const uint8_t *address, in
 
 
     if (!entry) {
-        if (count > destination_cache_config.max_entries) {
+        if (ipv6_destination_count > destination_cache_config.max_entries) {
             entry = ns_list_get_last(&ipv6_destination_cache);
             ipv6_destination_release(entry);
         }
@@ -976,6 +1078,10 @@ ipv6_destination_t *ipv6_destination_lookup_or_create(const uint8_t *address, in
             entry->interface_id = -1;
         }
         ns_list_add_to_start(&ipv6_destination_cache, entry);
+        ipv6_destination_t **bucket = ipv6_destination_hash_bucket(address);
+        entry->hash_next = *bucket;
+        *bucket = entry;
+        ipv6_destination_count++;
     } else if (entry != ns_list_get_first(&ipv6_destination_cache)) {
         /* If there was an entry, and it wasn't at the start, move it */
         ns_list_remove(&ipv6_destination_cache, entry);
@@ -1083,7 +1189,7 @@ void ipv6_destination_redirect(const uint8_t *dest_addr, const uint8_t *sender_a
 
 void ipv6_destination_cache_forced_gc(bool full_gc)
 {
-    int gc_count = ns_list_count(&ipv6_destination_cache);
+    int gc_count = ipv6_destination_count;
 
     /* Minimize size of destination cache:
      * - keep absolutely minimum number of entries if not full gc
@@ -1111,6 +1217,13 @@ static bool ipv6_destination_release(ipv6_destination_t *dest)
 {
     if (--dest->refcount == 0) {
         ns_list_remove(&ipv6_destination_cache, dest);
+        for (ipv6_destination_t **p = ipv6_destination_hash_bucket(dest->destination); *p; p = &(*p)->hash_next) {
+            if (*p == dest) {
+                *p = dest->hash_next;
+                break;
+            }
+        }
+        ipv6_destination_count--;
         tr_debug("Destination cache remove: %s", trace_ipv6(dest->destination));
         ns_dyn_mem_free(dest);
         return true;
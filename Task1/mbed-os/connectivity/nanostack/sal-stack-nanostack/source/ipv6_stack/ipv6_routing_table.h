@@ -41,6 +41,16 @@
 
 #define IPV6_ROUTE_DEFAULT_METRIC           128
 
+/* Buckets of the Neighbour Cache hashes (per interface) and of the
+ * Destination Cache hash (system-wide), power of two.
+ */
+#ifndef IPV6_NEIGHBOUR_HASH_SIZE
+#define IPV6_NEIGHBOUR_HASH_SIZE            32
+#endif
+#ifndef IPV6_DESTINATION_HASH_SIZE
+#define IPV6_DESTINATION_HASH_SIZE          32
+#endif
+
 /* XXX in the process of renaming this - it's really specifically the
  * IP Neighbour Cache  but was initially called a routing table */
 
@@ -100,7 +110,10 @@ typedef struct ipv6_neighbour {
     addrtype_t                      ll_type;
     uint32_t                        timer;                      /* 100ms ticks */
     uint32_t                        lifetime;                   /* seconds */
-    ns_list_link_t                  link;                       /*!< List link */
+    ns_list_link_t                  link;                       /*!< List link, most recently used first */
+    ns_list_link_t                  timer_link;                 /*!< Link in the list of running timers */
+    struct ipv6_neighbour           *hash_next;                 /*!< Next in the IP address hash bucket */
+    struct ipv6_neighbour           *ll_hash_next;              /*!< Next in the LL address hash bucket */
     NS_LIST_HEAD_INCOMPLETE(struct buffer) queue;
     uint8_t                         ll_address[];
 } ipv6_neighbour_t;
@@ -135,6 +148,9 @@ typedef struct ipv6_neighbour_cache {
     ipv6_route_interface_info_t             route_if_info;
     //uint8_t                                   num_entries;
     NS_LIST_HEAD(ipv6_neighbour_t, link)    list;
+    NS_LIST_HEAD(ipv6_neighbour_t, timer_link) timer_list;  // entries with timer running
+    ipv6_neighbour_t                        *hash[IPV6_NEIGHBOUR_HASH_SIZE];    // by IP address
+    ipv6_neighbour_t                        *ll_hash[IPV6_NEIGHBOUR_HASH_SIZE]; // by LL address, if known
 } ipv6_neighbour_cache_t;
 
 /* Macros for formatting ipv6 addresses into strings for route printing. */
@@ -159,6 +175,7 @@ extern void ipv6_neighbour_entry_remove(ipv6_neighbour_cache_t *cache, ipv6_neig
 extern bool ipv6_neighbour_is_probably_reachable(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *n);
 extern bool ipv6_neighbour_addr_is_probably_reachable(ipv6_neighbour_cache_t *cache, const uint8_t *address);
 extern bool ipv6_neighbour_ll_addr_match(const ipv6_neighbour_t *entry, addrtype_t ll_type, const uint8_t *ll_address);
+extern ipv6_neighbour_t *ipv6_neighbour_lookup_ll_addr_next(ipv6_neighbour_cache_t *cache, addrtype_t ll_type, const uint8_t *ll_address, const ipv6_neighbour_t *prev);
 extern void ipv6_neighbour_invalidate_ll_addr(ipv6_neighbour_cache_t *cache, addrtype_t ll_type, const uint8_t *ll_address);
 extern void ipv6_neighbour_delete_registered_by_eui64(ipv6_neighbour_cache_t *cache, const uint8_t *eui64);
 extern bool ipv6_neighbour_has_registered_by_eui64(ipv6_neighbour_cache_t *cache, const uint8_t *eui64);
@@ -207,7 +224,8 @@ typedef struct ipv6_destination {
     uint32_t                        fragment_id;
 #endif
     ipv6_neighbour_t                *last_neighbour;    // last neighbour used (only for reachability confirmation)
-    ns_list_link_t                  link;
+    ns_list_link_t                  link;               // most recently used first
+    struct ipv6_destination         *hash_next;         // next in the hash bucket
 } ipv6_destination_t;
 
 #ifndef NO_IPV6_PMTUD
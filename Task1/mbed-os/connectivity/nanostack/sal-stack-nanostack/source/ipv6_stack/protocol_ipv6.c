@@ -113,14 +113,14 @@ static void ethernet_data_ind_cb(const eth_mac_api_t *api, const eth_data_ind_t
         return;
     }
 
-    buffer_t *buffer = buffer_get_minimal(data->msduLength);
+    // Headroom for the tunnel and routing headers if the packet is routed into a mesh
+    buffer_t *buffer = buffer_get_specific(buffer_link_headroom(), data->msduLength, 0);
     if (!buffer) {
         tr_error("RX: out of memory");
         return;
     }
 
-    buffer->buf_ptr = buffer->buf_end = 0;
-    // Upward direction functions assume no headroom and are trusting that removed bytes are still valid.
+    // Upward direction functions are trusting that removed bytes are still valid.
     // see mac.c:655
 
     /* Set default flags */
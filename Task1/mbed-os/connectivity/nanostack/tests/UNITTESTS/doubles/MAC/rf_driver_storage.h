@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * PHY driver list of the MAC. The driver storage is not part of this tree,
+ * the tests only need the driver entry.
+ */
+
+#ifndef RF_DRIVER_STORAGE_H_
+#define RF_DRIVER_STORAGE_H_
+
+#include "ns_types.h"
+#include "platform/arm_hal_phy.h"
+
+struct arm_phy_sap_msg_s;
+
+typedef struct arm_device_driver_list {
+    int8_t id;
+    phy_device_driver_s *phy_driver;
+    void *phy_sap_identifier;
+    int8_t (*phy_sap_upper_cb)(void *identifier, struct arm_phy_sap_msg_s *message);
+} arm_device_driver_list_s;
+
+arm_device_driver_list_s *arm_net_phy_driver_pointer(int8_t id);
+
+#endif /* RF_DRIVER_STORAGE_H_ */
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Neighbour cache of the interface, which protocol.h embeds. The cache
+ * itself is not part of this tree, the tests stub the calls protocol_core.c
+ * makes.
+ */
+
+#ifndef NEIGHBOR_TABLE_DEFINITION_H_
+#define NEIGHBOR_TABLE_DEFINITION_H_
+
+typedef struct neigh_cache_s {
+    void *head;
+} neigh_cache_s;
+
+void neighbor_cache_init(neigh_cache_s *neigh_cache);
+
+#endif /* NEIGHBOR_TABLE_DEFINITION_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * PAN blacklists of the interface, which protocol.h embeds. The blacklist
+ * service is not part of this tree, the tests stub the calls protocol_core.c
+ * makes.
+ */
+
+#ifndef PAN_BLACKLIST_API_H_
+#define PAN_BLACKLIST_API_H_
+
+typedef struct pan_blaclist_cache_s {
+    void *head;
+} pan_blaclist_cache_s;
+
+typedef struct pan_coordinator_blaclist_cache_s {
+    void *head;
+} pan_coordinator_blaclist_cache_s;
+
+void pan_blacklist_cache_init(pan_blaclist_cache_s *blacklist_cache);
+
+void pan_coordinator_blacklist_cache_init(pan_coordinator_blaclist_cache_s *coordinator_blacklist_cache);
+
+void pan_blacklist_time_update(pan_blaclist_cache_s *blacklist_cache, uint16_t time_update_in_seconds);
+
+void pan_coordinator_blacklist_time_update(pan_coordinator_blaclist_cache_s *coordinator_blacklist_cache, uint16_t time_update_in_seconds);
+
+#endif /* PAN_BLACKLIST_API_H_ */
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Stack configuration of the unit tests, selected by nsconfig.h as the
+ * default nanostack_full. The stack configurations are not part of this
+ * tree, this enables what the tested modules need.
+ */
+
+#ifndef _CFG_NANOSTACK_FULL_H_
+#define _CFG_NANOSTACK_FULL_H_
+
+#define HAVE_IPV6_ND
+#define HAVE_6LOWPAN_ND
+#define HAVE_RPL
+#define HAVE_RPL_ROOT
+#define HAVE_RPL_DAO_HANDLING
+#define HAVE_ETHERNET
+
+#endif /* _CFG_NANOSTACK_FULL_H_ */
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include "eventOS_event.h"
+#include "ns_event_loop_profiler.h"
+
+#include "ns_event_loop_profiler_stubs.h"
+
+#define TEST_EVENT 10
+
+// Handlers take 100 us and 3 ms
+static void tasklet_a_handler(arm_event_t *event)
+{
+    ns_event_loop_profiler_stub_time += 100;
+}
+
+static void tasklet_b_handler(arm_event_t *event)
+{
+    ns_event_loop_profiler_stub_time += 3000;
+}
+
+static void idle_tasklet_handler(arm_event_t *event)
+{
+}
+
+// The profiler keeps its wrapped handlers between tests
+static void tasklet_c_handler(arm_event_t *event)
+{
+}
+
+static void tasklet_d_handler(arm_event_t *event)
+{
+}
+
+class Test_NsEventLoopProfiler : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ns_event_loop_profiler_stub_reset();
+        ns_event_loop_profiler_stub_time = 0;
+    }
+
+    void send(int8_t tasklet, uint_fast8_t count)
+    {
+        while (count--) {
+            arm_event_t event = {};
+            event.receiver = tasklet;
+            event.event_type = TEST_EVENT;
+            ASSERT_EQ(0, eventOS_event_send(&event));
+        }
+    }
+
+    uint32_t dispatch_all()
+    {
+        uint32_t events = 0;
+        while (ns_event_loop_profiler_dispatch()) {
+            events++;
+        }
+        return events;
+    }
+};
+
+TEST_F(Test_NsEventLoopProfiler, events_charged_to_receiver)
+{
+    // Tasklet 0 only gets its initialization event, though the dispatcher
+    // leaves it active after each event
+    int8_t idle = eventOS_event_handler_create(idle_tasklet_handler, 0);
+    int8_t a = eventOS_event_handler_create(tasklet_a_handler, 0);
+    int8_t b = eventOS_event_handler_create(tasklet_b_handler, 0);
+    ASSERT_EQ(0, idle);
+    ASSERT_EQ(1, a);
+    ASSERT_EQ(2, b);
+    send(a, 3);
+    send(b, 2);
+    send(a, 1);
+
+    ns_event_loop_profile_reset();
+    ASSERT_EQ(9, dispatch_all());
+
+    ns_event_loop_profile_t profile;
+    ns_event_loop_profile_read(&profile);
+    EXPECT_EQ(9, profile.events);
+    EXPECT_EQ(5 * 100 + 3 * 3000, profile.run_time_us);
+
+    EXPECT_EQ(1, profile.tasklet[idle].events);
+    EXPECT_EQ(0, profile.tasklet[idle].run_time_us);
+
+    EXPECT_EQ(5, profile.tasklet[a].events);
+    EXPECT_EQ(5 * 100, profile.tasklet[a].run_time_us);
+    EXPECT_EQ(100, profile.tasklet[a].run_time_max_us);
+    EXPECT_EQ(5, profile.tasklet[a].run_time_histogram[1]);
+
+    EXPECT_EQ(3, profile.tasklet[b].events);
+    EXPECT_EQ(3 * 3000, profile.tasklet[b].run_time_us);
+    EXPECT_EQ(3000, profile.tasklet[b].run_time_max_us);
+    EXPECT_EQ(3, profile.tasklet[b].run_time_histogram[3]);
+
+    EXPECT_EQ(0, profile.tasklet[MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_PROFILER_TASKLETS].events);
+}
+
+TEST_F(Test_NsEventLoopProfiler, handler_created_once)
+{
+    ASSERT_EQ(0, eventOS_event_handler_create(tasklet_c_handler, 0));
+    EXPECT_EQ(-1, eventOS_event_handler_create(tasklet_c_handler, 0));
+    EXPECT_EQ(1, eventOS_event_handler_create(tasklet_d_handler, 0));
+    EXPECT_EQ(2, dispatch_all());
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Scheduler behaving as the eventloop library's: tasklet IDs are given out
+ * in order, a handler can only be registered once, and the active tasklet is
+ * the receiver while its handler runs and 0 after. Tasklet creation is
+ * linked with --wrap, so the profiler sees it first.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "hal/us_ticker_api.h"
+#include "platform/mbed_critical.h"
+#include "eventOS_event.h"
+#include "eventOS_scheduler.h"
+
+#include "ns_event_loop_profiler_stubs.h"
+
+#define STUB_TASKLETS 32
+#define STUB_EVENTS 64
+
+uint32_t ns_event_loop_profiler_stub_time;
+
+static void (*stub_handler[STUB_TASKLETS])(arm_event_t *);
+static uint_fast8_t stub_tasklets;
+static arm_event_t stub_queue[STUB_EVENTS];
+static uint_fast8_t stub_queue_head, stub_queue_count;
+static int8_t stub_active_tasklet;
+
+void ns_event_loop_profiler_stub_reset(void)
+{
+    memset(stub_handler, 0, sizeof stub_handler);
+    stub_tasklets = 0;
+    stub_queue_head = 0;
+    stub_queue_count = 0;
+    stub_active_tasklet = 0;
+}
+
+void (*ns_event_loop_profiler_stub_handler(int8_t tasklet))(arm_event_t *)
+{
+    return tasklet >= 0 && tasklet < stub_tasklets ? stub_handler[tasklet] : NULL;
+}
+
+int8_t eventOS_event_send(const arm_event_t *event)
+{
+    if (event->receiver < 0 || event->receiver >= stub_tasklets || stub_queue_count == STUB_EVENTS) {
+        return -1;
+    }
+    stub_queue[(stub_queue_head + stub_queue_count++) % STUB_EVENTS] = *event;
+    return 0;
+}
+
+int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_t *), uint8_t init_event_type)
+{
+    for (uint_fast8_t i = 0; i < stub_tasklets; i++) {
+        if (stub_handler[i] == handler_func_ptr) {
+            return -1;
+        }
+    }
+    if (stub_tasklets == STUB_TASKLETS) {
+        return -1;
+    }
+    int8_t tasklet = stub_tasklets++;
+    stub_handler[tasklet] = handler_func_ptr;
+
+    arm_event_t event = {
+        .receiver = tasklet,
+        .sender = 0,
+        .event_type = init_event_type,
+    };
+    eventOS_event_send(&event);
+    return tasklet;
+}
+
+bool eventOS_scheduler_dispatch_event(void)
+{
+    if (!stub_queue_count) {
+        return false;
+    }
+    arm_event_t event = stub_queue[stub_queue_head];
+    stub_queue_head = (stub_queue_head + 1) % STUB_EVENTS;
+    stub_queue_count--;
+
+    stub_active_tasklet = event.receiver;
+    stub_handler[event.receiver](&event);
+    stub_active_tasklet = 0;
+    return true;
+}
+
+int8_t eventOS_scheduler_get_active_tasklet(void)
+{
+    return stub_active_tasklet;
+}
+
+uint32_t us_ticker_read(void)
+{
+    return ns_event_loop_profiler_stub_time;
+}
+
+void core_util_critical_section_enter(void)
+{
+}
+
+void core_util_critical_section_exit(void)
+{
+}
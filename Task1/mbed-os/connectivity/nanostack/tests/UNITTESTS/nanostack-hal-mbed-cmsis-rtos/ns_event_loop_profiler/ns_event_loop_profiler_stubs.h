@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef NS_EVENT_LOOP_PROFILER_STUBS_H_
+#define NS_EVENT_LOOP_PROFILER_STUBS_H_
+
+#include <stdint.h>
+#include "eventOS_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Microseconds, as read by us_ticker_read() */
+extern uint32_t ns_event_loop_profiler_stub_time;
+
+/* Back to no tasklets and no events */
+void ns_event_loop_profiler_stub_reset(void);
+
+/* Handler of the tasklet as registered with the scheduler */
+void (*ns_event_loop_profiler_stub_handler(int8_t tasklet))(arm_event_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NS_EVENT_LOOP_PROFILER_STUBS_H_ */
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include "gtest/gtest.h"
+
+#include "test_cipv6_fragmenter.h"
+
+#define FRAGMENT 64
+
+class Test_Cipv6Fragmenter : public testing::Test {
+protected:
+    virtual void TearDown()
+    {
+        test_cipv6_fragmenter_deinit();
+    }
+
+    // Fragments of the datagram from offset "from" up to "to", returns true
+    // if the last one completed it
+    bool send(uint16_t sender, uint16_t tag, uint16_t size, uint16_t from, uint16_t to)
+    {
+        bool complete = false;
+        for (uint16_t offset = from; offset < to; offset += FRAGMENT) {
+            uint16_t length = size - offset < FRAGMENT ? size - offset : FRAGMENT;
+            complete = test_cipv6_fragmenter_fragment(sender, tag, size, offset, length);
+        }
+        return complete;
+    }
+
+    // Sessions 1 and 2 get a fragment of 128-byte datagrams, then session 3
+    // gets enough of its own for the first two to stall
+    void stall_two_sessions()
+    {
+        test_cipv6_fragmenter_init(3);
+        send(1, 1, 128, 0, FRAGMENT);
+        send(2, 1, 128, 0, FRAGMENT);
+        send(3, 1, 2040, 0, 25 * FRAGMENT);
+    }
+};
+
+TEST_F(Test_Cipv6Fragmenter, reassembles_datagram)
+{
+    test_cipv6_fragmenter_init(2);
+
+    EXPECT_TRUE(send(1, 1, 200, 0, 200));
+    EXPECT_EQ(1, cipv6_fragmenter_stub_complete);
+    EXPECT_EQ(0, cipv6_fragmenter_stub_errors);
+}
+
+TEST_F(Test_Cipv6Fragmenter, early_drop_furthest_from_completion)
+{
+    test_cipv6_fragmenter_init(2);
+    send(1, 1, 1024, 0, 1024 - FRAGMENT);
+    send(2, 1, 1024, FRAGMENT, 2 * FRAGMENT);
+
+    // Further from completion than session 2
+    EXPECT_FALSE(send(3, 1, 512, 0, FRAGMENT));
+    EXPECT_EQ(1, cipv6_fragmenter_stub_early_drops);
+
+    EXPECT_TRUE(send(1, 1, 1024, 1024 - FRAGMENT, 1024));
+    EXPECT_TRUE(send(3, 1, 512, FRAGMENT, 512));
+}
+
+TEST_F(Test_Cipv6Fragmenter, early_drop_keeps_near_complete_from_same_sender)
+{
+    test_cipv6_fragmenter_init(2);
+    send(1, 1, 1024, 0, 1024 - FRAGMENT);
+    send(2, 1, 1024, 0, 512);
+
+    // Both sessions are closer to completion than the new datagram
+    EXPECT_FALSE(send(1, 2, 1024, 0, FRAGMENT));
+    EXPECT_EQ(0, cipv6_fragmenter_stub_early_drops);
+    EXPECT_EQ(1, cipv6_fragmenter_stub_errors);
+
+    EXPECT_TRUE(send(1, 1, 1024, 1024 - FRAGMENT, 1024));
+    EXPECT_TRUE(send(2, 1, 1024, 512, 1024));
+}
+
+TEST_F(Test_Cipv6Fragmenter, early_drop_stalled_from_same_sender_first)
+{
+    stall_two_sessions();
+
+    // Session 1 is the most stalled, but sender 2 has moved on
+    EXPECT_FALSE(send(2, 2, 128, 0, FRAGMENT));
+    EXPECT_EQ(1, cipv6_fragmenter_stub_early_drops);
+
+    EXPECT_TRUE(send(1, 1, 128, FRAGMENT, 128));
+    EXPECT_TRUE(send(2, 2, 128, FRAGMENT, 128));
+    EXPECT_TRUE(send(3, 1, 2040, 25 * FRAGMENT, 2040));
+}
+
+TEST_F(Test_Cipv6Fragmenter, early_drop_most_stalled)
+{
+    stall_two_sessions();
+
+    EXPECT_FALSE(send(4, 1, 128, 0, FRAGMENT));
+    EXPECT_EQ(1, cipv6_fragmenter_stub_early_drops);
+
+    EXPECT_TRUE(send(2, 1, 128, FRAGMENT, 128));
+    EXPECT_TRUE(send(4, 1, 128, FRAGMENT, 128));
+    EXPECT_TRUE(send(3, 1, 2040, 25 * FRAGMENT, 2040));
+}
+
+TEST_F(Test_Cipv6Fragmenter, early_drop_lost_fragment)
+{
+    // Session 1 has the end of its datagram, but a fragment is missing
+    test_cipv6_fragmenter_init(2);
+    send(1, 1, 256, 0, FRAGMENT);
+    send(1, 1, 256, 2 * FRAGMENT, 256);
+    send(2, 1, 1024, 0, 512);
+
+    EXPECT_FALSE(send(3, 1, 1024, 0, FRAGMENT));
+    EXPECT_EQ(1, cipv6_fragmenter_stub_early_drops);
+
+    EXPECT_TRUE(send(2, 1, 1024, 512, 1024));
+    EXPECT_TRUE(send(3, 1, 1024, FRAGMENT, 1024));
+}
+
+TEST_F(Test_Cipv6Fragmenter, early_drop_not_for_missing_first_fragment)
+{
+    stall_two_sessions();
+
+    EXPECT_FALSE(send(4, 1, 128, FRAGMENT, 128));
+    EXPECT_EQ(0, cipv6_fragmenter_stub_early_drops);
+    EXPECT_EQ(1, cipv6_fragmenter_stub_errors);
+}
+
+TEST_F(Test_Cipv6Fragmenter, memory_limit_shared_by_sessions)
+{
+    // Two sessions get room for two LOWPAN_MTU datagrams
+    test_cipv6_fragmenter_init(2);
+    send(1, 1, 1504, 0, FRAGMENT);
+
+    EXPECT_FALSE(send(2, 1, 1504, 0, FRAGMENT));
+    EXPECT_EQ(0, cipv6_fragmenter_stub_early_drops);
+    EXPECT_EQ(1, cipv6_fragmenter_stub_errors);
+
+    EXPECT_TRUE(send(3, 1, 1000, 0, 1000));
+    EXPECT_TRUE(send(1, 1, 1504, FRAGMENT, 1504));
+}
+
+TEST_F(Test_Cipv6Fragmenter, memory_limit_fits_largest_datagram)
+{
+    test_cipv6_fragmenter_init(1);
+
+    EXPECT_TRUE(send(1, 1, 2040, 0, 2040));
+    EXPECT_EQ(0, cipv6_fragmenter_stub_errors);
+}
+
+// Interleaved senders into the receiver's 8 sessions, goodput is printed
+TEST_F(Test_Cipv6Fragmenter, simulate_interleaved_senders)
+{
+    static const struct {
+        uint16_t senders;
+        uint8_t loss;
+        uint8_t burst;
+    } runs[] = {
+        {4, 0, 1}, {8, 0, 1}, {16, 0, 1}, {64, 0, 1}, {16, 0, 8},
+        {4, 2, 1}, {8, 2, 1}, {8, 2, 8}, {8, 10, 1}, {8, 10, 8},
+    };
+
+    for (unsigned i = 0; i < sizeof runs / sizeof runs[0]; i++) {
+        test_cipv6_fragmenter_result_t result;
+        test_cipv6_fragmenter_init(8);
+        test_cipv6_fragmenter_simulate(runs[i].senders, runs[i].loss, runs[i].burst, 5000, &result);
+        printf("%3u senders, %2u%% loss, burst %u: goodput %5.1f%%\n", runs[i].senders, runs[i].loss,
+               runs[i].burst, 100.0 * result.received / result.sent);
+        EXPECT_EQ(0, result.corrupt);
+        if (runs[i].senders <= 8 && !runs[i].loss) {
+            // All but the datagrams still on the way when it stopped
+            EXPECT_LE(result.sent, result.received + runs[i].senders);
+        }
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "Core/include/ns_address_internal.h"
+#include "Core/include/ns_buffer.h"
+#include "6LoWPAN/IPHC_Decode/cipv6.h"
+#include "6LoWPAN/Fragmentation/cipv6_fragmenter.h"
+
+#include "test_cipv6_fragmenter.h"
+
+#define TEST_INTERFACE_ID 1
+
+#define SIMULATION_DATAGRAM 1000
+#define SIMULATION_FRAGMENT 96
+#define SIMULATION_FRAGMENTS_PER_SECOND 200
+
+/* Datagram byte, tells the senders and datagrams apart */
+static uint8_t test_cipv6_fragmenter_byte(uint16_t sender, uint16_t tag, uint16_t offset)
+{
+    return (uint8_t)(sender * 7 + tag * 3 + offset);
+}
+
+void test_cipv6_fragmenter_init(uint8_t session_limit)
+{
+    cipv6_fragmenter_stub_complete = 0;
+    cipv6_fragmenter_stub_errors = 0;
+    cipv6_fragmenter_stub_early_drops = 0;
+    reassembly_interface_init(TEST_INTERFACE_ID, session_limit, 5);
+}
+
+void test_cipv6_fragmenter_deinit(void)
+{
+    reassembly_interface_free(TEST_INTERFACE_ID);
+}
+
+bool test_cipv6_fragmenter_fragment(uint16_t sender, uint16_t tag, uint16_t size, uint16_t offset, uint16_t length)
+{
+    buffer_t *buf = buffer_get(5 + length);
+    uint8_t *ptr = buffer_data_pointer(buf);
+
+    *ptr++ = (offset ? LOWPAN_FRAGN : LOWPAN_FRAG1) | (size >> 8);
+    *ptr++ = (uint8_t) size;
+    *ptr++ = tag >> 8;
+    *ptr++ = (uint8_t) tag;
+    if (offset) {
+        *ptr++ = offset >> 3;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        *ptr++ = test_cipv6_fragmenter_byte(sender, tag, offset + i);
+    }
+    buffer_data_end_set(buf, ptr);
+
+    buf->src_sa.addr_type = ADDR_802_15_4_LONG;
+    buf->src_sa.address[8] = sender >> 8;
+    buf->src_sa.address[9] = (uint8_t) sender;
+    buf->dst_sa.addr_type = ADDR_802_15_4_SHORT;
+
+    buf = cipv6_frag_reassembly(TEST_INTERFACE_ID, buf);
+    if (!buf) {
+        return false;
+    }
+
+    bool intact = buffer_data_length(buf) == size;
+    for (uint16_t i = 0; intact && i < size; i++) {
+        intact = buffer_data_pointer(buf)[i] == test_cipv6_fragmenter_byte(sender, tag, i);
+    }
+    buffer_free(buf);
+    return intact;
+}
+
+static uint32_t test_cipv6_fragmenter_random(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+void test_cipv6_fragmenter_simulate(uint16_t senders, uint8_t loss, uint8_t burst, uint32_t datagrams, test_cipv6_fragmenter_result_t *result)
+{
+    struct {
+        uint16_t tag;
+        uint16_t offset;
+    } *sender = calloc(senders, sizeof * sender);
+    uint32_t seed = 1;
+    uint32_t fragments = 0;
+    uint16_t current = 0;
+    uint8_t left = 0;
+
+    memset(result, 0, sizeof * result);
+    while (result->sent < datagrams) {
+        if (!left) {
+            current = test_cipv6_fragmenter_random(&seed) % senders;
+            left = 1 + test_cipv6_fragmenter_random(&seed) % burst;
+        }
+        left--;
+
+        uint16_t offset = sender[current].offset;
+        uint16_t length = SIMULATION_DATAGRAM - offset < SIMULATION_FRAGMENT ? SIMULATION_DATAGRAM - offset : SIMULATION_FRAGMENT;
+        if (offset == 0) {
+            sender[current].tag++;
+            result->sent++;
+        }
+        sender[current].offset = offset + length < SIMULATION_DATAGRAM ? offset + length : 0;
+
+        if (test_cipv6_fragmenter_random(&seed) % 100 >= loss) {
+            uint32_t complete = cipv6_fragmenter_stub_complete;
+            if (test_cipv6_fragmenter_fragment(current, sender[current].tag, SIMULATION_DATAGRAM, offset, length)) {
+                result->received++;
+            } else if (cipv6_fragmenter_stub_complete != complete) {
+                result->corrupt++;
+            }
+        }
+        if (++fragments % SIMULATION_FRAGMENTS_PER_SECOND == 0) {
+            cipv6_frag_timer(1);
+        }
+    }
+    free(sender);
+}
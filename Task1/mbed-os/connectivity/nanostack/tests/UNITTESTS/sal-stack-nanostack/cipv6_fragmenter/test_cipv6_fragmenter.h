@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_CIPV6_FRAGMENTER_H_
+#define TEST_CIPV6_FRAGMENTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct test_cipv6_fragmenter_result {
+    uint32_t sent;
+    uint32_t received;
+    uint32_t corrupt;
+} test_cipv6_fragmenter_result_t;
+
+/* Counted by the stubs */
+extern uint32_t cipv6_fragmenter_stub_complete;
+extern uint32_t cipv6_fragmenter_stub_errors;
+extern uint32_t cipv6_fragmenter_stub_early_drops;
+
+void test_cipv6_fragmenter_init(uint8_t session_limit);
+
+void test_cipv6_fragmenter_deinit(void);
+
+/* Passes a fragment of the sender's datagram to the reassembly, returns true
+ * if the datagram is complete and its data intact.
+ */
+bool test_cipv6_fragmenter_fragment(uint16_t sender, uint16_t tag, uint16_t size, uint16_t offset, uint16_t length);
+
+/* Senders take turns at random, "burst" fragments at most at a time, to send
+ * 1000-byte datagrams in 96-byte fragments over a link that loses "loss"
+ * percent of them. The receiver takes 200 fragments a second.
+ */
+void test_cipv6_fragmenter_simulate(uint16_t senders, uint8_t loss, uint8_t burst, uint32_t datagrams, test_cipv6_fragmenter_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_CIPV6_FRAGMENTER_H_ */
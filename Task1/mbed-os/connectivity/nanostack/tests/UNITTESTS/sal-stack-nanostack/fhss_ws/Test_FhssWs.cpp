@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gtest/gtest.h"
+
+#include "fhss_config.h"
+#include "test_fhss_ws.h"
+
+// Slots replayed, FHSS_WS_REPLAY_SLOTS in the environment overrides it for benchmarking
+#define REPLAY_SLOTS 20000
+
+// Channel plans: one with channels excluded, one larger than a TR51 table of 8 bit indices
+#define CHANNELS 35
+#define EXCLUDED 11
+#define CHANNELS_LARGE 129
+
+class Test_FhssWs : public testing::Test {
+protected:
+    virtual void TearDown()
+    {
+        test_fhss_ws_deinit();
+    }
+};
+
+TEST_F(Test_FhssWs, own_unicast_channels)
+{
+    test_fhss_ws_init(WS_TR51CF, WS_FIXED_CHANNEL, CHANNELS, EXCLUDED);
+    // Sequence wraps around
+    EXPECT_EQ(0, test_fhss_ws_unicast(3 * CHANNELS));
+    test_fhss_ws_deinit();
+
+    test_fhss_ws_init(WS_DH1CF, WS_FIXED_CHANNEL, CHANNELS_LARGE, 0);
+    EXPECT_EQ(0, test_fhss_ws_unicast(1000));
+}
+
+TEST_F(Test_FhssWs, own_broadcast_channels)
+{
+    test_fhss_ws_init(WS_FIXED_CHANNEL, WS_TR51CF, CHANNELS_LARGE, 0);
+    EXPECT_EQ(0, test_fhss_ws_broadcast(3 * CHANNELS_LARGE));
+    test_fhss_ws_deinit();
+
+    test_fhss_ws_init(WS_FIXED_CHANNEL, WS_DH1CF, CHANNELS, EXCLUDED);
+    EXPECT_EQ(0, test_fhss_ws_broadcast(1000));
+}
+
+// More neighbours than hopping sequences cached
+TEST_F(Test_FhssWs, tx_channels_to_neighbors)
+{
+    test_fhss_ws_init(WS_TR51CF, WS_FIXED_CHANNEL, CHANNELS, EXCLUDED);
+    // A few neighbours with channel plans of their own, TR51 ones no larger than the own
+    test_fhss_ws_neighbor(1, WS_TR51CF, CHANNELS, 7);
+    test_fhss_ws_neighbor(2, WS_TR51CF, CHANNELS - 5, EXCLUDED);
+    test_fhss_ws_neighbor(3, WS_DH1CF, CHANNELS, EXCLUDED);
+    EXPECT_EQ(0, test_fhss_ws_tx(4, 1000));
+    EXPECT_EQ(0, test_fhss_ws_tx(TEST_FHSS_WS_NEIGHBORS, 10000));
+    test_fhss_ws_deinit();
+
+    test_fhss_ws_init(WS_DH1CF, WS_FIXED_CHANNEL, CHANNELS_LARGE, EXCLUDED);
+    EXPECT_EQ(0, test_fhss_ws_tx(TEST_FHSS_WS_NEIGHBORS, 10000));
+}
+
+// Neighbour schedule with more channels than the own tables is not precomputed.
+// Only DH1CF, TR51 reads past the sequence of the own channel table.
+TEST_F(Test_FhssWs, tx_channels_to_larger_schedule)
+{
+    test_fhss_ws_init(WS_DH1CF, WS_FIXED_CHANNEL, CHANNELS_LARGE, 4);
+    test_fhss_ws_neighbor(0, WS_DH1CF, CHANNELS_LARGE, 0);
+    EXPECT_EQ(0, test_fhss_ws_tx(1, 1000));
+}
+
+// Sequences computed again when the channel plan changes
+TEST_F(Test_FhssWs, configuration_change)
+{
+    test_fhss_ws_init(WS_TR51CF, WS_FIXED_CHANNEL, CHANNELS, 0);
+    EXPECT_EQ(0, test_fhss_ws_unicast(CHANNELS));
+    test_fhss_ws_configure(CHANNELS, EXCLUDED);
+    EXPECT_EQ(0, test_fhss_ws_unicast(2 * CHANNELS));
+    test_fhss_ws_configure(CHANNELS_LARGE, EXCLUDED);
+    EXPECT_EQ(0, test_fhss_ws_unicast(2 * CHANNELS_LARGE));
+    test_fhss_ws_deinit();
+
+    test_fhss_ws_init(WS_FIXED_CHANNEL, WS_DH1CF, CHANNELS, 0);
+    EXPECT_EQ(0, test_fhss_ws_broadcast(100));
+    test_fhss_ws_configure(CHANNELS, EXCLUDED);
+    EXPECT_EQ(0, test_fhss_ws_broadcast(100));
+}
+
+TEST_F(Test_FhssWs, simulate_hopping)
+{
+    static const uint8_t channel_functions[2] = {WS_TR51CF, WS_DH1CF};
+    const char *env = getenv("FHSS_WS_REPLAY_SLOTS");
+    uint32_t slots = env ? strtoul(env, NULL, 10) : REPLAY_SLOTS;
+
+    for (int i = 0; i < 2; i++) {
+        for (int large = 0; large < 2; large++) {
+            test_fhss_ws_result_t result;
+            test_fhss_ws_replay(channel_functions[i], large ? CHANNELS_LARGE : CHANNELS, large ? 0 : EXCLUDED, slots, &result);
+            printf("%s %3u channels: own UC %.0f ns, own BC %.0f ns, TX to 1 neighbor %.0f ns, 8 %.0f ns, %u %.0f ns\n",
+                   i ? "DH1CF" : "TR51 ", large ? CHANNELS_LARGE : CHANNELS, result.unicast_ns, result.broadcast_ns,
+                   result.tx_ns[0], result.tx_ns[1], TEST_FHSS_WS_NEIGHBORS, result.tx_ns[2]);
+        }
+    }
+}
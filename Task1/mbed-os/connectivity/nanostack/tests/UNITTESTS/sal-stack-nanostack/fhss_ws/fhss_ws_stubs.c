@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stubs of the FHSS around fhss_ws.c, for a single instance whose schedule
+ * timers are expired by the test.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* External definitions of the libservice inline functions */
+#define NS_LIST_FN extern
+#include "ns_list.h"
+#define COMMON_FUNCTIONS_FN extern
+#include "common_functions.h"
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "randLIB.h"
+#include "nsdynmemLIB.h"
+#include "eventOS_callback_timer.h"
+#include "platform/arm_hal_interrupt.h"
+#include "fhss_api.h"
+#include "fhss_config.h"
+#include "Service_Libs/fhss/fhss.h"
+#include "Service_Libs/fhss/fhss_common.h"
+#include "Service_Libs/fhss/fhss_statistics.h"
+
+#include "test_fhss_ws.h"
+
+uint32_t fhss_ws_stub_time;
+
+static fhss_structure_t fhss_ws_stub_instance;
+
+/* Schedule timers, the unicast and the broadcast one */
+static struct {
+    void (*callback)(const fhss_api_t *fhss_api, uint16_t);
+    uint32_t expiry;
+} fhss_ws_stub_timers[2];
+
+bool fhss_ws_stub_timer_expire(void)
+{
+    int next = -1;
+    for (int i = 0; i < 2; i++) {
+        if (fhss_ws_stub_timers[i].callback && (next < 0 || (int32_t)(fhss_ws_stub_timers[i].expiry - fhss_ws_stub_timers[next].expiry) < 0)) {
+            next = i;
+        }
+    }
+    if (next < 0) {
+        return false;
+    }
+    void (*callback)(const fhss_api_t *fhss_api, uint16_t) = fhss_ws_stub_timers[next].callback;
+    fhss_ws_stub_timers[next].callback = NULL;
+    fhss_ws_stub_time = fhss_ws_stub_timers[next].expiry;
+    callback(fhss_ws_stub_instance.fhss_api, 0);
+    return true;
+}
+
+fhss_structure_t *fhss_allocate_instance(fhss_api_t *fhss_api, const fhss_timer_t *fhss_timer)
+{
+    memset(&fhss_ws_stub_instance, 0, sizeof(fhss_ws_stub_instance));
+    memset(fhss_ws_stub_timers, 0, sizeof(fhss_ws_stub_timers));
+    fhss_ws_stub_instance.fhss_api = fhss_api;
+    fhss_ws_stub_instance.platform_functions = *fhss_timer;
+    return &fhss_ws_stub_instance;
+}
+
+int8_t fhss_free_instance(fhss_api_t *fhss_api)
+{
+    memset(&fhss_ws_stub_instance, 0, sizeof(fhss_ws_stub_instance));
+    return 0;
+}
+
+fhss_structure_t *fhss_get_object_with_api(const fhss_api_t *fhss_api)
+{
+    return fhss_api && fhss_api == fhss_ws_stub_instance.fhss_api ? &fhss_ws_stub_instance : NULL;
+}
+
+fhss_structure_t *fhss_get_object_with_timer_id(const int8_t timer_id)
+{
+    return &fhss_ws_stub_instance;
+}
+
+int fhss_init_callbacks_cb(const fhss_api_t *api, fhss_callback_t *callbacks)
+{
+    return 0;
+}
+
+void fhss_start_timer(fhss_structure_t *fhss_structure, uint32_t time, void (*callback)(const fhss_api_t *fhss_api, uint16_t))
+{
+    fhss_stop_timer(fhss_structure, callback);
+    for (int i = 0; i < 2; i++) {
+        if (!fhss_ws_stub_timers[i].callback) {
+            fhss_ws_stub_timers[i].callback = callback;
+            fhss_ws_stub_timers[i].expiry = fhss_ws_stub_time + time;
+            return;
+        }
+    }
+    abort();
+}
+
+void fhss_stop_timer(fhss_structure_t *fhss_structure, void (*callback)(const fhss_api_t *fhss_api, uint16_t))
+{
+    for (int i = 0; i < 2; i++) {
+        if (fhss_ws_stub_timers[i].callback == callback) {
+            fhss_ws_stub_timers[i].callback = NULL;
+        }
+    }
+}
+
+void fhss_stats_update(fhss_structure_t *fhss_structure, fhss_stats_type_t type, uint32_t update_val)
+{
+}
+
+fhss_failed_tx_t *fhss_failed_handle_find(fhss_structure_t *fhss_structure, uint8_t handle)
+{
+    return NULL;
+}
+
+int fhss_failed_handle_add(fhss_structure_t *fhss_structure, uint8_t handle, uint8_t bad_channel)
+{
+    return 0;
+}
+
+int fhss_failed_handle_remove(fhss_structure_t *fhss_structure, uint8_t handle)
+{
+    return 0;
+}
+
+int8_t eventOS_callback_timer_register(void (*timer_interrupt_handler)(int8_t, uint16_t))
+{
+    return 1;
+}
+
+int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
+{
+    return 0;
+}
+
+int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
+{
+    return 0;
+}
+
+uint16_t randLIB_get_random_in_range(uint16_t min, uint16_t max)
+{
+    return min;
+}
+
+void *ns_dyn_mem_alloc(ns_mem_block_size_t alloc_size)
+{
+    return malloc(alloc_size);
+}
+
+void ns_dyn_mem_free(void *block)
+{
+    free(block);
+}
+
+void platform_enter_critical(void)
+{
+}
+
+void platform_exit_critical(void)
+{
+}
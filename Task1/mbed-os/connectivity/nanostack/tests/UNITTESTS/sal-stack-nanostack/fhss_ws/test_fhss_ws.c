@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ns_list.h"
+#include "nsdynmemLIB.h"
+#include "fhss_api.h"
+#include "fhss_config.h"
+#include "fhss_ws_extension.h"
+#include "Service_Libs/fhss/fhss.h"
+#include "Service_Libs/fhss/fhss_common.h"
+#include "Service_Libs/fhss/fhss_ws.h"
+#include "Service_Libs/fhss/channel_functions.h"
+#include "Service_Libs/fhss/channel_list.h"
+
+#include "test_fhss_ws.h"
+
+#define DWELL_INTERVAL 255
+#define BROADCAST_INTERVAL 1020
+#define BSI 0x1234
+#define MAX_CHANNELS 256
+
+// DH1CF slots of neighbours, kept below 2^32 us from the UTT-IE reception
+#define DH1CF_SLOTS 16000
+
+static fhss_api_t api;
+static const fhss_timer_t timer = { .fhss_resolution_divider = 1 };
+static fhss_structure_t *fhss;
+static int32_t channel;
+static const uint8_t mac[8] = {0x00, 0x0d, 0x6f, 0x00, 0x12, 0x34, 0x56, 0x78};
+static fhss_ws_neighbor_timing_info_t neighbors[TEST_FHSS_WS_NEIGHBORS];
+static uint8_t neighbor_eui64[TEST_FHSS_WS_NEIGHBORS][8];
+static uint32_t seed;
+
+// TR51 channel table of the reference, initialised as the one of fhss_ws.c
+static int16_t channel_table[MAX_CHANNELS + 1];
+static uint8_t output_table[MAX_CHANNELS];
+static uint16_t channel_table_length;
+
+static uint32_t random_value(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t read_timestamp(const fhss_api_t *fhss_api)
+{
+    return fhss_ws_stub_time;
+}
+
+static int read_mac_address(const fhss_api_t *fhss_api, uint8_t *mac_address)
+{
+    memcpy(mac_address, mac, 8);
+    return 0;
+}
+
+static int change_channel(const fhss_api_t *fhss_api, uint8_t channel_number)
+{
+    channel = channel_number;
+    return 0;
+}
+
+static uint16_t read_tx_queue_size(const fhss_api_t *fhss_api, bool broadcast_queue)
+{
+    return 0;
+}
+
+static fhss_ws_neighbor_timing_info_t *get_neighbor_info(const fhss_api_t *fhss_api, uint8_t eui64[8])
+{
+    return &neighbors[eui64[7] % TEST_FHSS_WS_NEIGHBORS];
+}
+
+static void channel_mask(uint32_t *mask, uint16_t channels, uint16_t excluded)
+{
+    memset(mask, 0, 8 * sizeof(uint32_t));
+    for (uint16_t i = 0; i < channels; i++) {
+        if (!excluded || i % excluded != excluded - 1) {
+            mask[i / 32] |= 1U << (i % 32);
+        }
+    }
+}
+
+/* Channel of the slot as computed before the hopping sequences were
+ * precomputed: channel index of the slot, then the channel of the index in
+ * the mask. Broadcast schedule when eui64 is NULL.
+ */
+static int32_t reference_channel(uint8_t channel_function, uint8_t *eui64, uint16_t number_of_channels, const uint32_t *mask, uint16_t slot)
+{
+    int32_t channel_index;
+    if (channel_table_length != fhss->ws->hop_sequence_length) {
+        channel_table_length = fhss->ws->hop_sequence_length;
+        tr51_init_channel_table(channel_table, channel_table_length);
+    }
+    if (channel_function == WS_TR51CF) {
+        if (eui64) {
+            channel_index = tr51_get_uc_channel_index(channel_table, output_table, slot % number_of_channels, eui64, number_of_channels, NULL);
+        } else {
+            channel_index = tr51_get_bc_channel_index(channel_table, output_table, slot % number_of_channels, BSI, number_of_channels, NULL);
+        }
+    } else {
+        if (eui64) {
+            channel_index = dh1cf_get_uc_channel_index(slot, eui64, number_of_channels);
+        } else {
+            channel_index = dh1cf_get_bc_channel_index(slot, BSI, number_of_channels);
+        }
+    }
+    for (uint16_t i = 0; i < fhss->number_of_channels; i++) {
+        if ((mask[i / 32] & (1U << (i % 32))) && channel_index-- == 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void configuration(fhss_ws_configuration_t *cfg, uint8_t uc_channel_function, uint8_t bc_channel_function, uint16_t channels, uint16_t excluded)
+{
+    memset(cfg, 0, sizeof(fhss_ws_configuration_t));
+    channel_mask(cfg->channel_mask, channels, excluded);
+    cfg->channel_mask_size = channels;
+    cfg->ws_uc_channel_function = uc_channel_function;
+    cfg->ws_bc_channel_function = bc_channel_function;
+    cfg->fhss_uc_dwell_interval = DWELL_INTERVAL;
+    if (bc_channel_function != WS_FIXED_CHANNEL) {
+        cfg->fhss_bc_dwell_interval = DWELL_INTERVAL;
+        cfg->fhss_broadcast_interval = BROADCAST_INTERVAL;
+    }
+    cfg->bsi = BSI;
+}
+
+void test_fhss_ws_init(uint8_t uc_channel_function, uint8_t bc_channel_function, uint16_t channels, uint16_t excluded)
+{
+    fhss_ws_configuration_t cfg;
+    configuration(&cfg, uc_channel_function, bc_channel_function, channels, excluded);
+    seed = 1;
+    fhss_ws_stub_time = 0;
+    fhss = fhss_ws_enable(&api, &cfg, &timer);
+    fhss_ws_set_callbacks(fhss);
+    fhss->callbacks.read_timestamp = read_timestamp;
+    fhss->callbacks.read_mac_address = read_mac_address;
+    fhss->callbacks.change_channel = change_channel;
+    fhss->callbacks.read_tx_queue_size = read_tx_queue_size;
+    fhss->ws->get_neighbor_info = get_neighbor_info;
+    for (uint16_t i = 0; i < TEST_FHSS_WS_NEIGHBORS; i++) {
+        for (uint8_t j = 0; j < 8; j++) {
+            neighbor_eui64[i][j] = random_value();
+        }
+        neighbor_eui64[i][7] = i;
+        test_fhss_ws_neighbor(i, uc_channel_function, channels, excluded);
+    }
+    channel = -1;
+    api.synch_state_set(&api, FHSS_SYNCHRONIZED, 0);
+}
+
+void test_fhss_ws_deinit(void)
+{
+    if (!fhss) {
+        return;
+    }
+    ns_dyn_mem_free(fhss->ws->tr51_channel_table);
+    ns_dyn_mem_free(fhss->ws->tr51_output_table);
+    ns_dyn_mem_free(fhss->ws->hop_sequences);
+    ns_dyn_mem_free(fhss->ws);
+    fhss_free_instance(&api);
+    fhss = NULL;
+    channel_table_length = 0;
+}
+
+void test_fhss_ws_configure(uint16_t channels, uint16_t excluded)
+{
+    fhss_ws_configuration_t cfg;
+    configuration(&cfg, fhss->ws->fhss_configuration.ws_uc_channel_function, fhss->ws->fhss_configuration.ws_bc_channel_function, channels, excluded);
+    fhss_ws_configuration_set(fhss, &cfg);
+}
+
+void test_fhss_ws_neighbor(uint16_t neighbor, uint8_t channel_function, uint16_t channels, uint16_t excluded)
+{
+    fhss_ws_neighbor_timing_info_t *info = &neighbors[neighbor];
+    memset(info, 0, sizeof(fhss_ws_neighbor_timing_info_t));
+    channel_mask(info->uc_channel_list.channel_mask, channels, excluded);
+    info->uc_channel_list.channel_count = channel_list_count_channels(info->uc_channel_list.channel_mask);
+    info->uc_timing_info.unicast_channel_function = channel_function;
+    info->uc_timing_info.unicast_dwell_interval = DWELL_INTERVAL;
+    info->uc_timing_info.unicast_number_of_channels = info->uc_channel_list.channel_count;
+}
+
+uint32_t test_fhss_ws_unicast(uint32_t slots)
+{
+    uint8_t channel_function = fhss->ws->fhss_configuration.ws_uc_channel_function;
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < slots; i++) {
+        uint16_t slot = fhss->ws->uc_slot;
+        channel = -1;
+        fhss_ws_stub_timer_expire();
+        errors += channel != reference_channel(channel_function, (uint8_t *) mac, fhss->number_of_uc_channels, fhss->ws->fhss_configuration.unicast_channel_mask, slot);
+    }
+    return errors;
+}
+
+uint32_t test_fhss_ws_broadcast(uint32_t slots)
+{
+    uint8_t channel_function = fhss->ws->fhss_configuration.ws_bc_channel_function;
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < slots; i++) {
+        // Off the broadcast channel, then on it. DH1CF counts the slot before its channel.
+        fhss_ws_stub_timer_expire();
+        uint16_t slot = fhss->ws->bc_slot + (channel_function == WS_DH1CF);
+        channel = -1;
+        fhss_ws_stub_timer_expire();
+        errors += !fhss->ws->is_on_bc_channel;
+        errors += channel != reference_channel(channel_function, NULL, fhss->number_of_bc_channels, fhss->ws->fhss_configuration.channel_mask, slot);
+    }
+    return errors;
+}
+
+/* TX channel to the neighbour, in the given slot of its schedule */
+static int32_t tx_channel(uint16_t neighbor, uint16_t slot)
+{
+    fhss_ws_neighbor_timing_info_t *info = &neighbors[neighbor];
+    info->uc_timing_info.ufsi = 0;
+    info->uc_timing_info.utt_rx_timestamp = fhss_ws_stub_time - (uint32_t) slot * DWELL_INTERVAL * 1000;
+    channel = -1;
+    if (api.tx_handle(&api, false, neighbor_eui64[neighbor], 0, 100, 0, 0, fhss_ws_stub_time)) {
+        return -1;
+    }
+    return channel;
+}
+
+static uint16_t tx_slot(uint16_t neighbor)
+{
+    fhss_ws_neighbor_timing_info_t *info = &neighbors[neighbor];
+    if (info->uc_timing_info.unicast_channel_function == WS_TR51CF) {
+        return random_value() % info->uc_timing_info.unicast_number_of_channels;
+    }
+    return random_value() % DH1CF_SLOTS;
+}
+
+uint32_t test_fhss_ws_tx(uint16_t neighbors_used, uint32_t frames)
+{
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        uint16_t neighbor = random_value() % neighbors_used;
+        uint16_t slot = tx_slot(neighbor);
+        fhss_ws_neighbor_timing_info_t *info = &neighbors[neighbor];
+        uint16_t number_of_channels = info->uc_timing_info.unicast_channel_function == WS_TR51CF ? info->uc_timing_info.unicast_number_of_channels : info->uc_channel_list.channel_count;
+        errors += tx_channel(neighbor, slot) != reference_channel(info->uc_timing_info.unicast_channel_function, neighbor_eui64[neighbor], number_of_channels, info->uc_channel_list.channel_mask, slot);
+    }
+    return errors;
+}
+
+void test_fhss_ws_replay(uint8_t channel_function, uint16_t channels, uint16_t excluded, uint32_t slots, test_fhss_ws_result_t *result)
+{
+    static const uint16_t neighbors_used[3] = {1, 8, TEST_FHSS_WS_NEIGHBORS};
+    double start;
+
+    test_fhss_ws_init(channel_function, WS_FIXED_CHANNEL, channels, excluded);
+    start = now_ns();
+    for (uint32_t i = 0; i < slots; i++) {
+        fhss_ws_stub_timer_expire();
+    }
+    result->unicast_ns = (now_ns() - start) / slots;
+
+    for (uint8_t n = 0; n < 3; n++) {
+        start = now_ns();
+        for (uint32_t i = 0; i < slots; i++) {
+            uint16_t neighbor = random_value() % neighbors_used[n];
+            tx_channel(neighbor, tx_slot(neighbor));
+        }
+        result->tx_ns[n] = (now_ns() - start) / slots;
+    }
+    test_fhss_ws_deinit();
+
+    // Each slot on the broadcast channel and off it
+    test_fhss_ws_init(WS_FIXED_CHANNEL, channel_function, channels, excluded);
+    start = now_ns();
+    for (uint32_t i = 0; i < 2 * slots; i++) {
+        fhss_ws_stub_timer_expire();
+    }
+    result->broadcast_ns = (now_ns() - start) / slots;
+    test_fhss_ws_deinit();
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_FHSS_WS_H_
+#define TEST_FHSS_WS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEST_FHSS_WS_NEIGHBORS 64
+
+typedef struct {
+    double unicast_ns;          // Own unicast channel
+    double broadcast_ns;        // Own broadcast channel
+    double tx_ns[3];            // TX channel to 1, 8 and all neighbours
+} test_fhss_ws_result_t;
+
+/* Set by the stubs */
+extern uint32_t fhss_ws_stub_time;
+
+/* Expires the schedule timer due first, false if none runs */
+bool fhss_ws_stub_timer_expire(void);
+
+/* Enabled and synchronised with "channels" channels, every "excluded"th of
+ * them excluded (none when 0). Unicast and broadcast schedules use the given
+ * channel functions, WS_FIXED_CHANNEL for none. Neighbours follow the
+ * unicast schedule.
+ */
+void test_fhss_ws_init(uint8_t uc_channel_function, uint8_t bc_channel_function, uint16_t channels, uint16_t excluded);
+
+void test_fhss_ws_deinit(void);
+
+/* Configuration set again with another channel mask */
+void test_fhss_ws_configure(uint16_t channels, uint16_t excluded);
+
+/* Neighbour schedule of "channels" channels, every "excluded"th excluded */
+void test_fhss_ws_neighbor(uint16_t neighbor, uint8_t channel_function, uint16_t channels, uint16_t excluded);
+
+/* Channels that differ from the ones computed slot by slot with
+ * channel_functions.c. The other schedule must be fixed.
+ */
+uint32_t test_fhss_ws_unicast(uint32_t slots);
+uint32_t test_fhss_ws_broadcast(uint32_t slots);
+uint32_t test_fhss_ws_tx(uint16_t neighbors, uint32_t frames);
+
+/* Time taken by channel changes of the schedules */
+void test_fhss_ws_replay(uint8_t channel_function, uint16_t channels, uint16_t excluded, uint32_t slots, test_fhss_ws_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_FHSS_WS_H_ */
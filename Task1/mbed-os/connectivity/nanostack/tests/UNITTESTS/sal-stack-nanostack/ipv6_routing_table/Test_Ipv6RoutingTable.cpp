@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gtest/gtest.h"
+
+#include "test_ipv6_routing_table.h"
+
+// Two entries a node, more than the hash buckets
+#define NODES 200
+
+// Replay length, IPV6_ROUTING_TABLE_REPLAY_PACKETS in the environment overrides it for benchmarking
+#define REPLAY_PACKETS 20000
+
+class Test_Ipv6RoutingTable : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        test_ipv6_routing_table_init(NODES);
+        for (uint32_t node = 0; node < NODES; node++) {
+            test_ipv6_routing_table_add_node(node);
+        }
+    }
+
+    virtual void TearDown()
+    {
+        test_ipv6_routing_table_deinit();
+    }
+};
+
+TEST_F(Test_Ipv6RoutingTable, lookup_by_address)
+{
+    for (uint32_t node = 0; node < NODES; node++) {
+        EXPECT_TRUE(test_ipv6_routing_table_lookup(node, true));
+        EXPECT_TRUE(test_ipv6_routing_table_lookup(node, false));
+    }
+    EXPECT_FALSE(test_ipv6_routing_table_lookup(NODES, true));
+}
+
+TEST_F(Test_Ipv6RoutingTable, lookup_by_ll_address)
+{
+    for (uint32_t node = 0; node < NODES; node++) {
+        EXPECT_EQ(2, test_ipv6_routing_table_lookup_ll(node));
+        EXPECT_TRUE(test_ipv6_routing_table_map_ll(node));
+    }
+    EXPECT_EQ(0, test_ipv6_routing_table_lookup_ll(NODES));
+}
+
+TEST_F(Test_Ipv6RoutingTable, removed_entries_not_found)
+{
+    for (uint32_t node = 0; node < NODES; node += 2) {
+        test_ipv6_routing_table_remove(node, node % 4 == 0);
+    }
+    for (uint32_t node = 0; node < NODES; node++) {
+        bool removed = node % 2 == 0;
+        EXPECT_EQ(!removed || node % 4 != 0, test_ipv6_routing_table_lookup(node, true));
+        EXPECT_EQ(!removed || node % 4 == 0, test_ipv6_routing_table_lookup(node, false));
+        EXPECT_EQ(removed ? 1 : 2, test_ipv6_routing_table_lookup_ll(node));
+    }
+}
+
+TEST_F(Test_Ipv6RoutingTable, ll_address_change)
+{
+    test_ipv6_routing_table_set_ll(1, NODES);
+    EXPECT_EQ(0, test_ipv6_routing_table_lookup_ll(1));
+    EXPECT_EQ(2, test_ipv6_routing_table_lookup_ll(NODES));
+
+    // Node 2 takes the address of node 3, and is found along with it
+    test_ipv6_routing_table_set_ll(2, 3);
+    EXPECT_EQ(0, test_ipv6_routing_table_lookup_ll(2));
+    EXPECT_EQ(4, test_ipv6_routing_table_lookup_ll(3));
+
+    // Only the link-local entries can go
+    test_ipv6_routing_table_invalidate_ll(3);
+    EXPECT_EQ(2, test_ipv6_routing_table_lookup_ll(3));
+    EXPECT_TRUE(test_ipv6_routing_table_lookup(2, true));
+    EXPECT_FALSE(test_ipv6_routing_table_lookup(2, false));
+    EXPECT_TRUE(test_ipv6_routing_table_lookup(3, true));
+    EXPECT_FALSE(test_ipv6_routing_table_lookup(3, false));
+}
+
+TEST_F(Test_Ipv6RoutingTable, fast_timer_running_timers)
+{
+    EXPECT_EQ(0, test_ipv6_routing_table_timers());
+    for (uint32_t node = 0; node < NODES; node += 10) {
+        test_ipv6_routing_table_reachable(node);
+    }
+    EXPECT_EQ(NODES / 10, test_ipv6_routing_table_timers());
+
+    // Removed entry leaves the list
+    test_ipv6_routing_table_remove(0, true);
+    EXPECT_EQ(NODES / 10 - 1, test_ipv6_routing_table_timers());
+
+    test_ipv6_routing_table_tick(TEST_IPV6_ROUTING_TABLE_REACHABLE_TICKS - 1);
+    EXPECT_EQ(NODES / 10 - 1, test_ipv6_routing_table_timers());
+    test_ipv6_routing_table_tick(1);
+    EXPECT_EQ(0, test_ipv6_routing_table_timers());
+    EXPECT_EQ(0, ipv6_routing_table_stub_ns_sent);
+}
+
+TEST_F(Test_Ipv6RoutingTable, destination_lookup)
+{
+    const void *first = test_ipv6_routing_table_destination(1);
+    const void *second = test_ipv6_routing_table_destination(2);
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_NE(first, second);
+
+    // Stays under the 64 entries of the cache, nothing is pushed out
+    for (uint32_t node = 3; node < 60; node++) {
+        test_ipv6_routing_table_destination(node);
+    }
+    EXPECT_EQ(first, test_ipv6_routing_table_destination(1));
+    EXPECT_EQ(second, test_ipv6_routing_table_destination(2));
+}
+
+// Lookups of a router forwarding to its neighbours, as the cache grows
+TEST_F(Test_Ipv6RoutingTable, simulate_forwarding)
+{
+    const char *env = getenv("IPV6_ROUTING_TABLE_REPLAY_PACKETS");
+    uint32_t packets = env ? strtoul(env, NULL, 10) : REPLAY_PACKETS;
+
+    test_ipv6_routing_table_deinit();
+    for (uint32_t nodes = 10; nodes <= 1000; nodes *= 10) {
+        test_ipv6_routing_table_result_t result;
+        test_ipv6_routing_table_replay(nodes, packets, &result);
+        printf("%4u nodes: forward %.0f ns/packet, LL map %.0f ns, fast timer %.0f ns/tick\n",
+               (unsigned) nodes, result.forward_ns, result.ll_map_ns, result.fast_timer_ns);
+    }
+    test_ipv6_routing_table_init(NODES);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stubs of the stack around ipv6_routing_table.c, for a Neighbour Cache of
+ * 802.15.4 nodes and the Destination Cache in front of it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* External definitions of the libservice inline functions */
+#define NS_LIST_FN extern
+#include "ns_list.h"
+#define COMMON_FUNCTIONS_FN extern
+#include "common_functions.h"
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ip6string.h"
+#include "randLIB.h"
+#include "nsdynmemLIB.h"
+#include "Core/include/ns_address_internal.h"
+#include "NWK_INTERFACE/Include/protocol_abstract.h"
+#include "Common_Protocols/ipv6_constants.h"
+#include "Common_Protocols/ipv6_resolution.h"
+#include "Service_Libs/etx/etx.h"
+#include "ipv6_stack/ipv6_routing_table.h"
+
+#include "test_ipv6_routing_table.h"
+
+#define UNREACHED() abort()
+
+const uint8_t ADDR_UNSPECIFIED[16];
+int protocol_core_buffers_in_event_queue;
+
+uint32_t ipv6_routing_table_stub_ns_sent;
+
+bool addr_ipv6_equal(const uint8_t a[static 16], const uint8_t b[static 16])
+{
+    return memcmp(a, b, 16) == 0;
+}
+
+bool addr_is_ipv6_link_local(const uint8_t addr[static 16])
+{
+    return addr[0] == 0xfe && (addr[1] & 0xc0) == 0x80;
+}
+
+uint_fast8_t addr_ipv6_scope(const uint8_t addr[static 16], const protocol_interface_info_entry_t *interface)
+{
+    return addr_is_ipv6_link_local(addr) ? IPV6_SCOPE_LINK_LOCAL : IPV6_SCOPE_GLOBAL;
+}
+
+uint8_t addr_len_from_type(addrtype_t addr_type)
+{
+    switch (addr_type) {
+        case ADDR_802_15_4_SHORT:
+            return 2 + 2;
+        case ADDR_802_15_4_LONG:
+            return 2 + 8;
+        default:
+            return 0;
+    }
+}
+
+uint8_t *bitcopy(uint8_t *restrict dst, const uint8_t *restrict src, uint_fast8_t bits)
+{
+    memcpy(dst, src, (bits + 7) / 8);
+    return dst;
+}
+
+bool bitsequal(const uint8_t *a, const uint8_t *b, uint_fast8_t bits)
+{
+    return memcmp(a, b, bits / 8) == 0;
+}
+
+uint_fast8_t ip6tos(const void *ip6addr, char *p)
+{
+    *p = '\0';
+    return 0;
+}
+
+uint32_t randLIB_get_32bit(void)
+{
+    return 0;
+}
+
+uint32_t randLIB_randomise_base(uint32_t base, uint16_t min_factor, uint16_t max_factor)
+{
+    return base;
+}
+
+void *ns_dyn_mem_alloc(ns_mem_block_size_t alloc_size)
+{
+    return malloc(alloc_size);
+}
+
+void ns_dyn_mem_free(void *block)
+{
+    free(block);
+}
+
+uint16_t etx_read(int8_t interface_id, addrtype_t addr_type, const uint8_t *addr_ptr)
+{
+    return 0;
+}
+
+ipv6_neighbour_cache_t *ipv6_neighbour_cache_by_interface_id(int8_t interface_id)
+{
+    return interface_id == TEST_IPV6_ROUTING_TABLE_INTERFACE ? &test_ipv6_routing_table_cache : NULL;
+}
+
+void ipv6_interface_resolve_send_ns(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry, bool unicast, uint_fast8_t seq)
+{
+    ipv6_routing_table_stub_ns_sent++;
+}
+
+void ipv6_interface_resolution_failed(ipv6_neighbour_cache_t *cache, ipv6_neighbour_t *entry)
+{
+}
+
+void ipv6_send_queued(ipv6_neighbour_t *neighbour)
+{
+}
+
+uint16_t ipv6_map_ip_to_ll_and_call_ll_addr_handler(protocol_interface_info_entry_t *cur, int8_t interface_id, ipv6_neighbour_t *n, const uint8_t ipaddr[16], ll_addr_handler_t *ll_addr_handler_ptr)
+{
+    UNREACHED();
+    return 0;
+}
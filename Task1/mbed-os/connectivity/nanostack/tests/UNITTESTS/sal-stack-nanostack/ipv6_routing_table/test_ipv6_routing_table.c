@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ns_list.h"
+#include "Core/include/ns_address_internal.h"
+#include "ipv6_stack/ipv6_routing_table.h"
+
+#include "test_ipv6_routing_table.h"
+
+#define LL_TYPE ADDR_802_15_4_LONG
+
+ipv6_neighbour_cache_t test_ipv6_routing_table_cache;
+
+static void node_address(uint8_t ip[16], uint8_t ll[10], uint32_t node, bool global)
+{
+    static const uint8_t prefix[8] = { 0xfd, 0x00, 0x61, 0x72, 0x6d, 0x00, 0x00, 0x01 };
+    static const uint8_t link_local[8] = { 0xfe, 0x80 };
+    // EUI-64 based IID
+    const uint8_t eui64[8] = { 0x00, 0x11, 0x22, 0xff, 0xfe, node >> 16, node >> 8, node };
+
+    memcpy(ip, global ? prefix : link_local, 8);
+    memcpy(ip + 8, eui64, 8);
+    ip[8] ^= 2;
+    ll[0] = 0xca;
+    ll[1] = 0xfe;
+    memcpy(ll + 2, eui64, 8);
+}
+
+static ipv6_neighbour_t *node_entry(uint32_t node, bool global)
+{
+    uint8_t ip[16], ll[10];
+    node_address(ip, ll, node, global);
+    return ipv6_neighbour_lookup(&test_ipv6_routing_table_cache, ip);
+}
+
+static uint32_t random_node(uint32_t *seed, uint32_t nodes)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 8) % nodes;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void test_ipv6_routing_table_init(uint32_t nodes)
+{
+    ipv6_neighbour_cache_t *cache = &test_ipv6_routing_table_cache;
+
+    memset(cache, 0, sizeof(ipv6_neighbour_cache_t));
+    ns_list_init(&cache->list);
+    ipv6_neighbour_cache_init(cache, TEST_IPV6_ROUTING_TABLE_INTERFACE);
+    cache->max_ll_len = 10;
+    cache->reachable_time = TEST_IPV6_ROUTING_TABLE_REACHABLE_TICKS * 100;
+    ipv6_neighbour_set_current_max_cache(nodes < 32 ? 64 : 2 * nodes);
+    ipv6_routing_table_stub_ns_sent = 0;
+}
+
+void test_ipv6_routing_table_deinit(void)
+{
+    ipv6_destination_cache_forced_gc(true);
+    ipv6_neighbour_cache_flush(&test_ipv6_routing_table_cache);
+}
+
+void test_ipv6_routing_table_add_node(uint32_t node)
+{
+    uint8_t ip[16], ll[10];
+
+    for (int global = 0; global < 2; global++) {
+        node_address(ip, ll, node, global);
+        ipv6_neighbour_t *entry = ipv6_neighbour_update_unsolicited(&test_ipv6_routing_table_cache, ip, LL_TYPE, ll);
+        entry->type = global ? IP_NEIGHBOUR_REGISTERED : IP_NEIGHBOUR_GARBAGE_COLLECTIBLE;
+        entry->lifetime = global ? 7200 : 600;
+    }
+}
+
+bool test_ipv6_routing_table_lookup(uint32_t node, bool global)
+{
+    uint8_t ip[16], ll[10];
+    node_address(ip, ll, node, global);
+    ipv6_neighbour_t *entry = ipv6_neighbour_lookup(&test_ipv6_routing_table_cache, ip);
+    return entry && memcmp(entry->ip_address, ip, 16) == 0;
+}
+
+uint32_t test_ipv6_routing_table_lookup_ll(uint32_t node)
+{
+    ipv6_neighbour_cache_t *cache = &test_ipv6_routing_table_cache;
+    uint8_t ip[16], ll[10];
+    uint32_t count = 0;
+
+    node_address(ip, ll, node, false);
+    for (ipv6_neighbour_t *entry = ipv6_neighbour_lookup_ll_addr_next(cache, LL_TYPE, ll, NULL); entry;
+            entry = ipv6_neighbour_lookup_ll_addr_next(cache, LL_TYPE, ll, entry)) {
+        if (!ipv6_neighbour_ll_addr_match(entry, LL_TYPE, ll)) {
+            return UINT32_MAX;
+        }
+        count++;
+    }
+    return count;
+}
+
+bool test_ipv6_routing_table_map_ll(uint32_t node)
+{
+    ipv6_neighbour_cache_t *cache = &test_ipv6_routing_table_cache;
+    uint8_t ip[16], ll[10];
+
+    node_address(ip, ll, node, false);
+    for (ipv6_neighbour_t *entry = ipv6_neighbour_lookup_ll_addr_next(cache, LL_TYPE, ll, NULL); entry;
+            entry = ipv6_neighbour_lookup_ll_addr_next(cache, LL_TYPE, ll, entry)) {
+        if (addr_is_ipv6_link_local(entry->ip_address)) {
+            return memcmp(entry->ip_address, ip, 16) == 0;
+        }
+    }
+    return false;
+}
+
+void test_ipv6_routing_table_remove(uint32_t node, bool global)
+{
+    ipv6_neighbour_entry_remove(&test_ipv6_routing_table_cache, node_entry(node, global));
+}
+
+void test_ipv6_routing_table_set_ll(uint32_t node, uint32_t ll_node)
+{
+    uint8_t ip[16], ll[10];
+
+    node_address(ip, ll, ll_node, false);
+    for (int global = 0; global < 2; global++) {
+        ipv6_neighbour_entry_update_unsolicited(&test_ipv6_routing_table_cache, node_entry(node, global), LL_TYPE, ll);
+    }
+}
+
+void test_ipv6_routing_table_invalidate_ll(uint32_t node)
+{
+    uint8_t ip[16], ll[10];
+    node_address(ip, ll, node, false);
+    ipv6_neighbour_invalidate_ll_addr(&test_ipv6_routing_table_cache, LL_TYPE, ll);
+}
+
+void test_ipv6_routing_table_reachable(uint32_t node)
+{
+    ipv6_neighbour_set_state(&test_ipv6_routing_table_cache, node_entry(node, true), IP_NEIGHBOUR_REACHABLE);
+}
+
+void test_ipv6_routing_table_tick(uint16_t ticks)
+{
+    ipv6_neighbour_cache_fast_timer(&test_ipv6_routing_table_cache, ticks);
+}
+
+uint32_t test_ipv6_routing_table_timers(void)
+{
+    ipv6_neighbour_cache_t *cache = &test_ipv6_routing_table_cache;
+    uint32_t running = 0;
+
+    ns_list_foreach(ipv6_neighbour_t, entry, &cache->list) {
+        running += entry->timer != 0;
+    }
+    ns_list_foreach(ipv6_neighbour_t, entry, &cache->timer_list) {
+        if (entry->timer == 0) {
+            return UINT32_MAX;
+        }
+    }
+    return ns_list_count(&cache->timer_list) == running ? running : UINT32_MAX;
+}
+
+const void *test_ipv6_routing_table_destination(uint32_t node)
+{
+    uint8_t ip[16], ll[10];
+    node_address(ip, ll, node, true);
+    return ipv6_destination_lookup_or_create(ip, TEST_IPV6_ROUTING_TABLE_INTERFACE);
+}
+
+void test_ipv6_routing_table_replay(uint32_t nodes, uint32_t packets, test_ipv6_routing_table_result_t *result)
+{
+    ipv6_neighbour_cache_t *cache = &test_ipv6_routing_table_cache;
+    uint8_t ip[16], ll[10];
+    uint32_t seed = 1;
+    double start;
+
+    test_ipv6_routing_table_init(nodes);
+    for (uint32_t node = 0; node < nodes; node++) {
+        test_ipv6_routing_table_add_node(node);
+    }
+
+    start = now_ns();
+    for (uint32_t i = 0; i < packets; i++) {
+        node_address(ip, ll, random_node(&seed, nodes), true);
+        ipv6_destination_t *destination = ipv6_destination_lookup_or_create(ip, TEST_IPV6_ROUTING_TABLE_INTERFACE);
+        ipv6_neighbour_t *neighbour = ipv6_neighbour_lookup(cache, ip);
+        if (destination && neighbour) {
+            destination->last_neighbour = ipv6_neighbour_used(cache, neighbour);
+        }
+    }
+    result->forward_ns = (now_ns() - start) / packets;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < packets; i++) {
+        test_ipv6_routing_table_map_ll(random_node(&seed, nodes));
+    }
+    result->ll_map_ns = (now_ns() - start) / packets;
+
+    uint32_t ticks = packets / 10;
+    start = now_ns();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        if (tick % (TEST_IPV6_ROUTING_TABLE_REACHABLE_TICKS / 2) == 0) {
+            for (uint32_t node = 0; node < nodes; node += 10) {
+                test_ipv6_routing_table_reachable(node);
+            }
+        }
+        ipv6_neighbour_cache_fast_timer(cache, 1);
+    }
+    result->fast_timer_ns = (now_ns() - start) / ticks;
+
+    test_ipv6_routing_table_deinit();
+}
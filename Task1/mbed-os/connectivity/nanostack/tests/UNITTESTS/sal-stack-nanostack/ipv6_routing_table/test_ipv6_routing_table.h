@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_IPV6_ROUTING_TABLE_H_
+#define TEST_IPV6_ROUTING_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEST_IPV6_ROUTING_TABLE_INTERFACE 1
+
+/* Reachable time of the cache, in 100 ms timer ticks */
+#define TEST_IPV6_ROUTING_TABLE_REACHABLE_TICKS 300
+
+struct ipv6_neighbour_cache;
+
+extern struct ipv6_neighbour_cache test_ipv6_routing_table_cache;
+
+/* Set by the stubs */
+extern uint32_t ipv6_routing_table_stub_ns_sent;
+
+typedef struct test_ipv6_routing_table_result {
+    double forward_ns;      /* Destination lookup, next hop lookup and use, per packet */
+    double ll_map_ns;       /* Link-local address of a received LL source */
+    double fast_timer_ns;   /* 100 ms tick */
+} test_ipv6_routing_table_result_t;
+
+/* Neighbour Cache with room for the nodes, and an empty Destination Cache */
+void test_ipv6_routing_table_init(uint32_t nodes);
+
+void test_ipv6_routing_table_deinit(void);
+
+/* A registered global entry and a garbage-collectible link-local entry of
+ * the node, with the EUI-64 of the node as their LL address */
+void test_ipv6_routing_table_add_node(uint32_t node);
+
+/* Whether the entry of the node is found by its IP address */
+bool test_ipv6_routing_table_lookup(uint32_t node, bool global);
+
+/* Entries found by the LL address of the node, all of them checked to have it */
+uint32_t test_ipv6_routing_table_lookup_ll(uint32_t node);
+
+/* Node's entry, mapped from its LL address as a received frame is */
+bool test_ipv6_routing_table_map_ll(uint32_t node);
+
+void test_ipv6_routing_table_remove(uint32_t node, bool global);
+
+/* Gives both entries of the node the LL address of another */
+void test_ipv6_routing_table_set_ll(uint32_t node, uint32_t ll_node);
+
+/* Removes the garbage-collectible entries with the LL address of the node */
+void test_ipv6_routing_table_invalidate_ll(uint32_t node);
+
+/* Global entry of the node is confirmed reachable */
+void test_ipv6_routing_table_reachable(uint32_t node);
+
+void test_ipv6_routing_table_tick(uint16_t ticks);
+
+/* Entries in the timer list, all of them checked to have a timer running,
+ * and the count checked against the entries with a timer running */
+uint32_t test_ipv6_routing_table_timers(void);
+
+/* Destination Cache entry of the node's global address */
+const void *test_ipv6_routing_table_destination(uint32_t node);
+
+/*
+ * Forwards packets to random nodes, maps the LL source of received frames
+ * to the link-local address, and runs the fast timer with a tenth of the
+ * nodes reachable.
+ */
+void test_ipv6_routing_table_replay(uint32_t nodes, uint32_t packets, test_ipv6_routing_table_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_IPV6_ROUTING_TABLE_H_ */
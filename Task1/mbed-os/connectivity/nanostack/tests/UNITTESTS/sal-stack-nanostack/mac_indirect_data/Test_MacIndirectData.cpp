@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include "gtest/gtest.h"
+
+#include "test_mac_indirect_data.h"
+
+#define SHORT TEST_MAC_INDIRECT_SHORT
+#define EXT TEST_MAC_INDIRECT_EXT
+
+// Over half the 7100 ms frame time to live, in whole 100 ms ticks
+#define OVER_HALF_TTL 3600
+
+class Test_MacIndirectData : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        test_mac_indirect_data_init();
+    }
+
+    virtual void TearDown()
+    {
+        test_mac_indirect_data_deinit();
+    }
+
+    // Handle of the frame the poll released, -1 for none
+    int poll(uint16_t child, uint8_t address, bool neighbour = false)
+    {
+        uint_fast8_t sent = mac_indirect_data_stub_sent.count;
+        test_mac_indirect_data_poll(child, address, neighbour, true);
+        if (mac_indirect_data_stub_sent.count == sent) {
+            return -1;
+        }
+        return mac_indirect_data_stub_sent.handle[sent];
+    }
+
+    static uint16_t random_child(uint32_t *seed, uint16_t children)
+    {
+        *seed = *seed * 1103515245 + 12345;
+        return (*seed >> 8) % children;
+    }
+};
+
+TEST_F(Test_MacIndirectData, poll_by_short_address)
+{
+    test_mac_indirect_data_queue(1, 1, SHORT, 10);
+    test_mac_indirect_data_queue(2, 2, SHORT, 20);
+
+    EXPECT_EQ(2, poll(2, SHORT));
+    EXPECT_EQ(-1, poll(2, SHORT));
+    EXPECT_EQ(1, test_mac_indirect_data_queue_size());
+    EXPECT_EQ(10, test_mac_indirect_data_pending_bytes());
+}
+
+TEST_F(Test_MacIndirectData, poll_by_extended_address)
+{
+    test_mac_indirect_data_queue(1, 1, SHORT, 10);
+    test_mac_indirect_data_queue(2, 1, EXT, 20);
+
+    // Unknown child, only its source address counts
+    EXPECT_EQ(2, poll(1, EXT));
+    EXPECT_EQ(-1, poll(1, EXT));
+    EXPECT_EQ(1, poll(1, SHORT));
+    EXPECT_EQ(0, test_mac_indirect_data_pending_bytes());
+}
+
+TEST_F(Test_MacIndirectData, poll_by_neighbour_oldest_first)
+{
+    test_mac_indirect_data_queue(1, 1, EXT, 10);
+    test_mac_indirect_data_queue(2, 1, SHORT, 10);
+    test_mac_indirect_data_queue(3, 1, EXT, 10);
+    test_mac_indirect_data_queue(4, 1, SHORT, 10);
+
+    EXPECT_EQ(1, poll(1, SHORT, true));
+    EXPECT_EQ(2, poll(1, EXT, true));
+    EXPECT_EQ(3, poll(1, SHORT, true));
+    EXPECT_EQ(4, poll(1, SHORT, true));
+    EXPECT_EQ(-1, poll(1, SHORT, true));
+}
+
+TEST_F(Test_MacIndirectData, poll_children_sharing_buckets)
+{
+    // More children than hash buckets, two frames each
+    for (uint16_t child = 0; child < 24; child++) {
+        test_mac_indirect_data_queue(2 * child, child, SHORT, 1);
+        test_mac_indirect_data_queue(2 * child + 1, child, SHORT, 1);
+    }
+    for (uint16_t child = 24; child-- > 0;) {
+        EXPECT_EQ(2 * child, poll(child, SHORT));
+        EXPECT_EQ(2 * child + 1, poll(child, SHORT));
+    }
+    EXPECT_EQ(0, test_mac_indirect_data_queue_size());
+}
+
+TEST_F(Test_MacIndirectData, poll_without_pending_ack)
+{
+    test_mac_indirect_data_queue(1, 1, SHORT, 10);
+
+    // Child may have gone back to sleep
+    EXPECT_EQ(1, test_mac_indirect_data_poll(1, SHORT, false, false));
+    EXPECT_EQ(0, mac_indirect_data_stub_sent.count);
+    EXPECT_EQ(1, test_mac_indirect_data_queue_size());
+}
+
+TEST_F(Test_MacIndirectData, frame_pending_left_to_upper_layer)
+{
+    test_mac_indirect_data_queue(1, 1, SHORT, 10);
+    test_mac_indirect_data_queue(2, 1, SHORT, 10);
+
+    EXPECT_EQ(1, poll(1, SHORT));
+    EXPECT_FALSE(mac_indirect_data_stub_sent.frame_pending[0]);
+}
+
+TEST_F(Test_MacIndirectData, ttl_expiry)
+{
+    test_mac_indirect_data_queue(1, 1, SHORT, 10);
+    test_mac_indirect_data_tick(OVER_HALF_TTL);
+    test_mac_indirect_data_queue(2, 2, EXT, 20);
+    test_mac_indirect_data_queue(3, 1, SHORT, 30);
+    test_mac_indirect_data_tick(OVER_HALF_TTL);
+
+    ASSERT_EQ(1, mac_indirect_data_stub_expired.count);
+    EXPECT_EQ(1, mac_indirect_data_stub_expired.handle[0]);
+    EXPECT_EQ(1, mac_indirect_data_stub_freed);
+    EXPECT_EQ(2, test_mac_indirect_data_queue_size());
+    EXPECT_EQ(50, test_mac_indirect_data_pending_bytes());
+    EXPECT_EQ(3, poll(1, SHORT));
+
+    test_mac_indirect_data_tick(OVER_HALF_TTL);
+    ASSERT_EQ(2, mac_indirect_data_stub_expired.count);
+    EXPECT_EQ(2, mac_indirect_data_stub_expired.handle[1]);
+    EXPECT_EQ(0, test_mac_indirect_data_queue_size());
+    EXPECT_EQ(0, test_mac_indirect_data_pending_bytes());
+}
+
+TEST_F(Test_MacIndirectData, purge_accounting)
+{
+    test_mac_indirect_data_queue(1, 1, SHORT, 10);
+    test_mac_indirect_data_queue(2, 1, SHORT, 20);
+    test_mac_indirect_data_queue(3, 2, EXT, 30);
+
+    EXPECT_TRUE(test_mac_indirect_data_purge(2));
+    EXPECT_FALSE(test_mac_indirect_data_purge(2));
+    EXPECT_EQ(1, mac_indirect_data_stub_freed);
+    EXPECT_EQ(2, test_mac_indirect_data_queue_size());
+    EXPECT_EQ(40, test_mac_indirect_data_pending_bytes());
+
+    EXPECT_EQ(1, poll(1, SHORT));
+    EXPECT_EQ(-1, poll(1, SHORT));
+
+    test_mac_indirect_data_free();
+    EXPECT_EQ(2, mac_indirect_data_stub_freed);
+    EXPECT_EQ(0, test_mac_indirect_data_queue_size());
+    EXPECT_EQ(0, test_mac_indirect_data_pending_bytes());
+}
+
+// A parent with many sleepy children, two frames queued for each on
+// average and a new frame per poll. Time per data request is printed. The
+// queue grows, frames are a byte so that the 16-bit pending bytes hold.
+TEST_F(Test_MacIndirectData, poll_many_children)
+{
+    static const uint16_t children_n[] = {8, 64, 256, 1024};
+    const uint32_t polls = 100000;
+
+    for (unsigned c = 0; c < sizeof children_n / sizeof children_n[0]; c++) {
+        uint16_t children = children_n[c];
+        uint32_t seed = 1;
+        uint32_t found = 0;
+        std::chrono::nanoseconds time(0);
+
+        for (uint32_t i = 0; i < 2u * children; i++) {
+            test_mac_indirect_data_queue(i, random_child(&seed, children), SHORT, 1);
+        }
+        for (uint32_t i = 0; i < polls; i++) {
+            uint16_t size = test_mac_indirect_data_queue_size();
+            uint16_t child = random_child(&seed, children);
+            auto start = std::chrono::steady_clock::now();
+            test_mac_indirect_data_poll(child, SHORT, false, true);
+            time += std::chrono::steady_clock::now() - start;
+            found += test_mac_indirect_data_queue_size() < size;
+            test_mac_indirect_data_queue(i, random_child(&seed, children), SHORT, 1);
+        }
+        printf("%4u children: %.0f ns/poll, %.1f%% polls with data\n", children,
+               (double) time.count() / polls, 100.0 * found / polls);
+        EXPECT_EQ(2u * children + polls - found, test_mac_indirect_data_queue_size());
+        EXPECT_EQ(test_mac_indirect_data_queue_size(), test_mac_indirect_data_pending_bytes());
+        test_mac_indirect_data_free();
+    }
+}
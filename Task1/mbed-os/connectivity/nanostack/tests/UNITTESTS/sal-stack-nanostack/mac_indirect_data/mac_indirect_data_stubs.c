@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stubs of the MAC around mac_indirect_data.c. Transmitted and expired
+ * frames are logged and freed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* External definitions of the libservice inline functions */
+#define COMMON_FUNCTIONS_FN extern
+#include "common_functions.h"
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "eventOS_callback_timer.h"
+#include "mac_api.h"
+#include "MAC/IEEE802_15_4/mac_defines.h"
+#include "MAC/IEEE802_15_4/mac_header_helper_functions.h"
+#include "MAC/IEEE802_15_4/mac_mcps_sap.h"
+#include "MAC/IEEE802_15_4/sw_mac_internal.h"
+
+#include "test_mac_indirect_data.h"
+
+test_mac_indirect_data_log_t mac_indirect_data_stub_sent;
+test_mac_indirect_data_log_t mac_indirect_data_stub_expired;
+uint32_t mac_indirect_data_stub_freed;
+uint8_t mac_indirect_data_stub_src_address[8];
+
+static void mac_indirect_data_stub_log(test_mac_indirect_data_log_t *log, uint8_t handle, bool frame_pending)
+{
+    if (log->count < TEST_MAC_INDIRECT_FRAMES) {
+        log->handle[log->count] = handle;
+        log->frame_pending[log->count] = frame_pending;
+        log->count++;
+    }
+}
+
+static void mac_indirect_data_stub_data_conf(const mac_api_t *api, const mcps_data_conf_t *data)
+{
+    if (data->status == MLME_TRANSACTION_EXPIRED) {
+        mac_indirect_data_stub_log(&mac_indirect_data_stub_expired, data->msduHandle, false);
+    }
+}
+
+static mac_api_t mac_indirect_data_stub_api = {
+    .data_conf_cb = mac_indirect_data_stub_data_conf
+};
+
+mac_api_t *get_sw_mac_api(protocol_interface_rf_mac_setup_s *setup)
+{
+    return &mac_indirect_data_stub_api;
+}
+
+void sw_mac_stats_update(protocol_interface_rf_mac_setup_s *setup, mac_stats_type_t type, uint32_t update_val)
+{
+}
+
+void mac_header_get_src_address(const mac_fcf_sequence_t *header, const uint8_t *ptr, uint8_t *address_ptr)
+{
+    memcpy(address_ptr, mac_indirect_data_stub_src_address, header->SrcAddrMode == MAC_ADDR_MODE_16_BIT ? 2 : 8);
+}
+
+void mac_header_get_dst_address(const mac_fcf_sequence_t *header, const uint8_t *ptr, uint8_t *address_ptr)
+{
+    memset(address_ptr, 0, 8);
+}
+
+uint16_t mac_header_get_dst_panid(const mac_fcf_sequence_t *header, const uint8_t *ptr, uint16_t configured_pan_id)
+{
+    return configured_pan_id;
+}
+
+void mac_header_security_components_read(mac_pre_parsed_frame_t *buffer, mlme_security_t *security_params)
+{
+}
+
+void mcps_sap_pd_req_queue_write(protocol_interface_rf_mac_setup_s *rf_mac_setup, mac_pre_build_frame_t *buffer)
+{
+    mac_indirect_data_stub_log(&mac_indirect_data_stub_sent, buffer->msduHandle, buffer->fcf_dsn.framePending);
+    free(buffer);
+}
+
+void mcps_sap_prebuild_frame_buffer_free(mac_pre_build_frame_t *buffer)
+{
+    mac_indirect_data_stub_freed++;
+    free(buffer);
+}
+
+int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
+{
+    return 0;
+}
+
+int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
+{
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "common_functions.h"
+#include "mac_api.h"
+#include "MAC/IEEE802_15_4/mac_defines.h"
+#include "MAC/IEEE802_15_4/mac_indirect_data.h"
+#include "MAC/IEEE802_15_4/sw_mac_internal.h"
+#include "MAC/rf_driver_storage.h"
+
+#include "test_mac_indirect_data.h"
+
+extern uint8_t mac_indirect_data_stub_src_address[8];
+
+static protocol_interface_rf_mac_setup_s *mac_setup;
+static phy_device_driver_s phy_driver;
+static arm_device_driver_list_s dev_driver = {
+    .phy_driver = &phy_driver
+};
+static uint32_t request_time;
+
+static void test_mac_indirect_data_address(uint16_t child, uint8_t address, uint8_t *addr_mode, uint8_t out[8])
+{
+    memset(out, 0, 8);
+    if (address == TEST_MAC_INDIRECT_SHORT) {
+        *addr_mode = MAC_ADDR_MODE_16_BIT;
+        common_write_16_bit(0x1000 + child, out);
+    } else {
+        *addr_mode = MAC_ADDR_MODE_64_BIT;
+        out[0] = 0x02;
+        common_write_16_bit(child, out + 6);
+    }
+}
+
+void test_mac_indirect_data_init(void)
+{
+    memset(&mac_indirect_data_stub_sent, 0, sizeof mac_indirect_data_stub_sent);
+    memset(&mac_indirect_data_stub_expired, 0, sizeof mac_indirect_data_stub_expired);
+    mac_indirect_data_stub_freed = 0;
+    mac_setup = calloc(1, sizeof(protocol_interface_rf_mac_setup_s));
+    mac_setup->dev_driver = &dev_driver;
+    request_time = 0;
+}
+
+void test_mac_indirect_data_deinit(void)
+{
+    mac_indirect_queue_free(mac_setup);
+    free(mac_setup);
+    mac_setup = NULL;
+}
+
+void test_mac_indirect_data_queue(uint8_t handle, uint16_t child, uint8_t address, uint16_t length)
+{
+    mac_pre_build_frame_t *frame = calloc(1, sizeof(mac_pre_build_frame_t));
+    uint8_t addr_mode;
+    test_mac_indirect_data_address(child, address, &addr_mode, frame->DstAddr);
+    frame->fcf_dsn.frametype = MAC_FRAME_DATA;
+    frame->fcf_dsn.DstAddrMode = addr_mode;
+    frame->msduHandle = handle;
+    frame->mac_payload_length = length;
+    frame->request_start_time_us = ++request_time;
+    mac_indirect_queue_write(mac_setup, frame);
+}
+
+uint8_t test_mac_indirect_data_poll(uint16_t child, uint8_t address, bool neighbour, bool ack_pending)
+{
+    mac_pre_parsed_frame_t *poll = calloc(1, sizeof(mac_pre_parsed_frame_t));
+    mlme_device_descriptor_t neigh_info;
+    uint8_t addr_mode;
+    uint8_t short_address[8];
+
+    test_mac_indirect_data_address(child, address, &addr_mode, mac_indirect_data_stub_src_address);
+    poll->fcf_dsn.frametype = MAC_FRAME_CMD;
+    poll->fcf_dsn.DstAddrMode = MAC_ADDR_MODE_16_BIT;
+    poll->fcf_dsn.SrcAddrMode = addr_mode;
+    poll->ack_pendinfg_status = ack_pending;
+    if (neighbour) {
+        memset(&neigh_info, 0, sizeof neigh_info);
+        test_mac_indirect_data_address(child, TEST_MAC_INDIRECT_SHORT, &addr_mode, short_address);
+        neigh_info.ShortAddress = common_read_16_bit(short_address);
+        test_mac_indirect_data_address(child, TEST_MAC_INDIRECT_EXT, &addr_mode, neigh_info.ExtAddress);
+        poll->neigh_info = &neigh_info;
+    }
+
+    uint8_t ret = mac_indirect_data_req_handle(poll, mac_setup);
+    free(poll);
+    return ret;
+}
+
+void test_mac_indirect_data_tick(uint16_t ms)
+{
+    // The MAC timer runs in ticks of MAC_INDIRECT_TICK_IN_MS, passing 50 us slots
+    for (; ms >= MAC_INDIRECT_TICK_IN_MS; ms -= MAC_INDIRECT_TICK_IN_MS) {
+        mac_indirect_data_ttl_handle(mac_setup, MAC_INDIRECT_TICK_IN_MS * 20);
+    }
+}
+
+bool test_mac_indirect_data_purge(uint8_t handle)
+{
+    return mac_indirect_queue_purge(mac_setup, handle);
+}
+
+void test_mac_indirect_data_free(void)
+{
+    mac_indirect_queue_free(mac_setup);
+}
+
+uint16_t test_mac_indirect_data_queue_size(void)
+{
+    return mac_setup->indirect_queue_size;
+}
+
+uint16_t test_mac_indirect_data_pending_bytes(void)
+{
+    return mac_setup->indirect_pending_bytes;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_MAC_INDIRECT_DATA_H_
+#define TEST_MAC_INDIRECT_DATA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Children have short address 0x1000 + child and an extended address
+ * ending in the child number.
+ */
+#define TEST_MAC_INDIRECT_SHORT 0
+#define TEST_MAC_INDIRECT_EXT 1
+
+#define TEST_MAC_INDIRECT_FRAMES 64
+
+/* Recorded by the stubs, in order */
+typedef struct test_mac_indirect_data_log {
+    uint8_t handle[TEST_MAC_INDIRECT_FRAMES];
+    bool frame_pending[TEST_MAC_INDIRECT_FRAMES];
+    uint_fast8_t count;
+} test_mac_indirect_data_log_t;
+
+extern test_mac_indirect_data_log_t mac_indirect_data_stub_sent;
+extern test_mac_indirect_data_log_t mac_indirect_data_stub_expired;
+extern uint32_t mac_indirect_data_stub_freed;
+
+void test_mac_indirect_data_init(void);
+
+void test_mac_indirect_data_deinit(void);
+
+/* Queues a data frame of "length" bytes for the child, addressed by its
+ * short or extended address.
+ */
+void test_mac_indirect_data_queue(uint8_t handle, uint16_t child, uint8_t address, uint16_t length);
+
+/* Data request from the child, returns the value of mac_indirect_data_req_handle().
+ * A known neighbour is looked up by both its addresses.
+ */
+uint8_t test_mac_indirect_data_poll(uint16_t child, uint8_t address, bool neighbour, bool ack_pending);
+
+void test_mac_indirect_data_tick(uint16_t ms);
+
+bool test_mac_indirect_data_purge(uint8_t handle);
+
+void test_mac_indirect_data_free(void);
+
+uint16_t test_mac_indirect_data_queue_size(void);
+
+uint16_t test_mac_indirect_data_pending_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_MAC_INDIRECT_DATA_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gtest/gtest.h"
+
+#include "test_ns_mem_slab.h"
+
+// Replay length, NS_MEM_SLAB_REPLAY_STEPS in the environment overrides it for benchmarking
+#define REPLAY_STEPS 100000
+
+class Test_NsMemSlab : public testing::Test {
+protected:
+    static uint32_t steps()
+    {
+        const char *steps = getenv("NS_MEM_SLAB_REPLAY_STEPS");
+        return steps ? strtoul(steps, NULL, 10) : REPLAY_STEPS;
+    }
+
+    static void replay(bool slab, test_ns_mem_slab_result_t *result)
+    {
+        uint32_t n = steps();
+        test_ns_mem_slab_replay(slab, n, result);
+        printf("%s %u steps: %.0f ns/op, %.1f search steps/op, used mean %.1f%%, "
+               "fragmentation mean %.1f%% max %.1f%%, largest hole min %zu, fails %u\n",
+               slab ? "slab" : "heap", (unsigned) n, result->ns_per_op, result->search_steps_per_op,
+               100 * result->used_mean, 100 * result->fragmentation_mean, 100 * result->fragmentation_max,
+               result->largest_hole_min, (unsigned) result->fails);
+    }
+};
+
+// The slab takes fewer heap searches. Heap use and fragmentation are
+// printed for comparison, the slab does not improve them.
+TEST_F(Test_NsMemSlab, replay_heap_searches)
+{
+    test_ns_mem_slab_result_t heap;
+    test_ns_mem_slab_result_t slab;
+    replay(false, &heap);
+    replay(true, &slab);
+
+    EXPECT_EQ(0, heap.fails);
+    EXPECT_EQ(0, slab.fails);
+    EXPECT_LT(2 * slab.search_steps_per_op, heap.search_steps_per_op);
+}
+
+TEST_F(Test_NsMemSlab, replay_gc_releases_all)
+{
+    test_ns_mem_slab_result_t slab;
+    replay(true, &slab);
+
+    // Chunks back in the heap
+    EXPECT_EQ(0, slab.leaked);
+}
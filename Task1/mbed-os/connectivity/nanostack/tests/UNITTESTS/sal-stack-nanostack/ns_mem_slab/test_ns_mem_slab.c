@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* External definitions of the libservice inline functions */
+#define NS_LIST_FN extern
+#include "ns_list.h"
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "nsdynmemLIB.h"
+#include "platform/arm_hal_interrupt.h"
+#include "Core/include/ns_mem_slab.h"
+
+#include "test_ns_mem_slab.h"
+
+/*
+ * Model of the sector heap: first fit, long-term blocks from the start and
+ * temporary ones from the end, size tags at both ends of a block for
+ * merging, and a free list in address order.
+ */
+typedef struct heap_block {
+    int32_t size;                   /* Payload, negative when free */
+    struct heap_block *prev_free;
+    struct heap_block *next_free;
+} heap_block_t;
+
+/* Tags keep the 8-byte alignment */
+#define HEAP_TAG 8
+#define HEAP_MIN_PAYLOAD 24
+
+static uint8_t *heap;
+static heap_block_t *heap_free_first;
+static heap_block_t *heap_free_last;
+static size_t heap_used;
+static size_t heap_largest;
+static uint64_t heap_search_steps;
+
+static void heap_block_size_set(heap_block_t *block, int32_t size)
+{
+    block->size = size;
+    *(int32_t *)((uint8_t *) block + HEAP_TAG + abs(size)) = size;
+}
+
+static void heap_free_insert(heap_block_t *block)
+{
+    heap_block_t *next = heap_free_first;
+    while (next && next < block) {
+        next = next->next_free;
+    }
+    block->next_free = next;
+    block->prev_free = next ? next->prev_free : heap_free_last;
+    if (block->prev_free) {
+        block->prev_free->next_free = block;
+    } else {
+        heap_free_first = block;
+    }
+    if (next) {
+        next->prev_free = block;
+    } else {
+        heap_free_last = block;
+    }
+}
+
+static void heap_free_remove(heap_block_t *block)
+{
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        heap_free_first = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    } else {
+        heap_free_last = block->prev_free;
+    }
+}
+
+static void heap_init(void)
+{
+    heap = malloc(TEST_NS_MEM_SLAB_HEAP_SIZE);
+    heap_free_first = NULL;
+    heap_free_last = NULL;
+    heap_used = 0;
+    heap_search_steps = 0;
+    heap_block_size_set((heap_block_t *) heap, -(TEST_NS_MEM_SLAB_HEAP_SIZE - 2 * HEAP_TAG));
+    heap_free_insert((heap_block_t *) heap);
+}
+
+static void *heap_alloc(size_t size, bool temporary)
+{
+    size = (size + 7) & ~(size_t) 7;
+    if (size < HEAP_MIN_PAYLOAD) {
+        size = HEAP_MIN_PAYLOAD;
+    }
+
+    heap_block_t *block = temporary ? heap_free_last : heap_free_first;
+    while (block && (size_t) - block->size < size) {
+        heap_search_steps++;
+        block = temporary ? block->prev_free : block->next_free;
+    }
+    if (!block) {
+        return NULL;
+    }
+
+    size_t block_size = -block->size;
+    heap_free_remove(block);
+    if (block_size >= size + 2 * HEAP_TAG + HEAP_MIN_PAYLOAD) {
+        size_t rest = block_size - size - 2 * HEAP_TAG;
+        if (temporary) {
+            heap_block_size_set(block, -(int32_t) rest);
+            heap_free_insert(block);
+            block = (heap_block_t *)((uint8_t *) block + rest + 2 * HEAP_TAG);
+        } else {
+            heap_block_t *rest_block = (heap_block_t *)((uint8_t *) block + size + 2 * HEAP_TAG);
+            heap_block_size_set(rest_block, -(int32_t) rest);
+            heap_free_insert(rest_block);
+        }
+        block_size = size;
+    }
+    heap_block_size_set(block, block_size);
+    heap_used += block_size + 2 * HEAP_TAG;
+    return (uint8_t *) block + HEAP_TAG;
+}
+
+static void heap_free(void *ptr)
+{
+    heap_block_t *block = (heap_block_t *)((uint8_t *) ptr - HEAP_TAG);
+    int32_t size = block->size;
+    heap_used -= size + 2 * HEAP_TAG;
+
+    heap_block_t *next = (heap_block_t *)((uint8_t *) block + size + 2 * HEAP_TAG);
+    if ((uint8_t *) next < heap + TEST_NS_MEM_SLAB_HEAP_SIZE && next->size < 0) {
+        heap_free_remove(next);
+        size += -next->size + 2 * HEAP_TAG;
+    }
+    if ((uint8_t *) block > heap) {
+        int32_t prev_size = *(int32_t *)((uint8_t *) block - HEAP_TAG);
+        if (prev_size < 0) {
+            heap_block_t *prev = (heap_block_t *)((uint8_t *) block - 2 * HEAP_TAG + prev_size);
+            heap_free_remove(prev);
+            size += -prev_size + 2 * HEAP_TAG;
+            block = prev;
+        }
+    }
+    heap_block_size_set(block, -size);
+    heap_free_insert(block);
+}
+
+static double heap_fragmentation(void)
+{
+    size_t total = 0;
+    heap_largest = 0;
+    for (heap_block_t *block = heap_free_first; block; block = block->next_free) {
+        total += -block->size;
+        if ((size_t) - block->size > heap_largest) {
+            heap_largest = -block->size;
+        }
+    }
+    return total ? 1.0 - (double) heap_largest / total : 0;
+}
+
+void *ns_dyn_mem_alloc(ns_mem_block_size_t alloc_size)
+{
+    return heap_alloc(alloc_size, false);
+}
+
+void *ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size)
+{
+    return heap_alloc(alloc_size, true);
+}
+
+void ns_dyn_mem_free(void *heap_ptr)
+{
+    if (heap_ptr) {
+        heap_free(heap_ptr);
+    }
+}
+
+void platform_enter_critical(void)
+{
+}
+
+void platform_exit_critical(void)
+{
+}
+
+/*
+ * The trace. Sizes are those of a 32-bit target: buffer_t is 148 bytes and
+ * the data follows it, a neighbour entry with an EUI-64 link layer address
+ * is 110, a MAC pre-build frame 132, a pre-parsed frame 44 and the frame,
+ * and a data indication 48.
+ */
+enum {
+    OBJECT_BUFFER,
+    OBJECT_PREPARSED,
+    OBJECT_PREBUILD,
+    OBJECT_DATA_IND,
+    OBJECT_NEIGHBOUR,
+    OBJECT_OTHER_SHORT,
+    OBJECT_OTHER_LONG,
+};
+
+/* Up to OBJECT_NEIGHBOUR the stack allocates them through ns_mem_slab */
+#define OBJECT_SLAB(kind) ((kind) <= OBJECT_NEIGHBOUR)
+
+#define NEIGHBOURS_MAX 500
+#define OTHERS_LONG_MAX 300
+
+typedef struct object {
+    void *ptr;
+    uint16_t size;
+    uint8_t kind;
+    uint32_t next;
+} object_t;
+
+/* Objects expire from a wheel longer than any lifetime */
+#define WHEEL_SIZE (1u << 18)
+#define OBJECTS_MAX 8192
+#define OBJECT_NONE UINT32_MAX
+
+static object_t objects[OBJECTS_MAX];
+static uint32_t wheel[WHEEL_SIZE];
+static uint32_t objects_free;
+static uint32_t random_state;
+static uint64_t time_ns;
+
+static uint32_t random_next(void)
+{
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void object_free(bool slab, object_t *object)
+{
+    uint64_t start = now_ns();
+    if (slab && OBJECT_SLAB(object->kind)) {
+        ns_mem_slab_free(object->ptr, object->size);
+    } else {
+        ns_dyn_mem_free(object->ptr);
+    }
+    time_ns += now_ns() - start;
+}
+
+static void *object_alloc(bool slab, uint8_t kind, uint16_t size, bool temporary)
+{
+    void *ptr;
+    uint64_t start = now_ns();
+    if (slab && OBJECT_SLAB(kind)) {
+        ptr = temporary ? ns_mem_slab_temporary_alloc(size) : ns_mem_slab_alloc(size);
+    } else {
+        ptr = temporary ? ns_dyn_mem_temporary_alloc(size) : ns_dyn_mem_alloc(size);
+    }
+    time_ns += now_ns() - start;
+    return ptr;
+}
+
+void test_ns_mem_slab_replay(bool slab, uint32_t steps, test_ns_mem_slab_result_t *result)
+{
+    uint64_t ops = 0;
+    uint32_t samples = 0;
+    uint32_t neighbours = 0;
+    uint32_t others_long = 0;
+    double used_sum = 0;
+    double fragmentation_sum = 0;
+
+    memset(result, 0, sizeof(*result));
+    result->largest_hole_min = TEST_NS_MEM_SLAB_HEAP_SIZE;
+    heap_init();
+    random_state = 1;
+    time_ns = 0;
+    for (uint32_t i = 0; i < WHEEL_SIZE; i++) {
+        wheel[i] = OBJECT_NONE;
+    }
+    for (uint32_t i = 0; i < OBJECTS_MAX; i++) {
+        objects[i].next = i + 1 < OBJECTS_MAX ? i + 1 : OBJECT_NONE;
+    }
+    objects_free = 0;
+
+    for (uint32_t now = 0; now < steps; now++) {
+        uint32_t i = wheel[now % WHEEL_SIZE];
+        wheel[now % WHEEL_SIZE] = OBJECT_NONE;
+        while (i != OBJECT_NONE) {
+            object_t *object = &objects[i];
+            uint32_t next = object->next;
+            neighbours -= object->kind == OBJECT_NEIGHBOUR;
+            others_long -= object->kind == OBJECT_OTHER_LONG;
+            object_free(slab, object);
+            ops++;
+            object->next = objects_free;
+            objects_free = i;
+            i = next;
+        }
+
+        for (uint_fast8_t n = 0; n < 4 && objects_free != OBJECT_NONE; n++) {
+            uint32_t kind_random = random_next() % 100;
+            uint8_t kind;
+            uint16_t size;
+            uint32_t lifetime;
+            bool temporary = true;
+            if (kind_random < 35) {
+                kind = OBJECT_BUFFER;
+                size = 148 + (random_next() % 4 ? 40 + random_next() % 120 : 200 + random_next() % 1100);
+                // Some wait for a sleepy child
+                lifetime = 1 + random_next() % (random_next() % 64 ? 20 : 500);
+            } else if (kind_random < 50) {
+                kind = OBJECT_PREPARSED;
+                size = 44 + 20 + random_next() % 236;
+                lifetime = 1 + random_next() % 5;
+            } else if (kind_random < 60) {
+                kind = OBJECT_PREBUILD;
+                size = 132;
+                lifetime = 1 + random_next() % 50;
+            } else if (kind_random < 70) {
+                kind = OBJECT_DATA_IND;
+                size = 48;
+                lifetime = 1;
+            } else if (kind_random < 73 && neighbours < NEIGHBOURS_MAX) {
+                kind = OBJECT_NEIGHBOUR;
+                size = 110;
+                lifetime = 20000 + random_next() % 200000;
+                temporary = false;
+            } else if (kind_random < 76 && others_long < OTHERS_LONG_MAX) {
+                kind = OBJECT_OTHER_LONG;
+                size = 16 + random_next() % 300;
+                lifetime = 5000 + random_next() % 100000;
+                temporary = false;
+            } else {
+                kind = OBJECT_OTHER_SHORT;
+                size = 16 + random_next() % 400;
+                lifetime = 1 + random_next() % 200;
+            }
+
+            void *ptr = object_alloc(slab, kind, size, temporary);
+            ops++;
+            if (!ptr) {
+                result->fails++;
+                continue;
+            }
+            neighbours += kind == OBJECT_NEIGHBOUR;
+            others_long += kind == OBJECT_OTHER_LONG;
+            memset(ptr, kind, size);
+
+            uint32_t index = objects_free;
+            object_t *object = &objects[index];
+            objects_free = object->next;
+            object->ptr = ptr;
+            object->size = size;
+            object->kind = kind;
+            object->next = wheel[(now + lifetime) % WHEEL_SIZE];
+            wheel[(now + lifetime) % WHEEL_SIZE] = index;
+        }
+
+        // GC of ns_monitor at the heap high watermark, checked on its interval
+        if (slab && now % 10 == 0 && heap_used > TEST_NS_MEM_SLAB_HEAP_SIZE * 95 / 100) {
+            uint64_t start = now_ns();
+            ns_mem_slab_gc(false);
+            time_ns += now_ns() - start;
+        }
+
+        if (now % 1000 == 999) {
+            double fragmentation = heap_fragmentation();
+            fragmentation_sum += fragmentation;
+            used_sum += (double) heap_used / TEST_NS_MEM_SLAB_HEAP_SIZE;
+            if (fragmentation > result->fragmentation_max) {
+                result->fragmentation_max = fragmentation;
+            }
+            if (heap_largest < result->largest_hole_min) {
+                result->largest_hole_min = heap_largest;
+            }
+            samples++;
+        }
+    }
+
+    result->ns_per_op = ops ? (double) time_ns / ops : 0;
+    result->search_steps_per_op = ops ? (double) heap_search_steps / ops : 0;
+    result->used_mean = samples ? used_sum / samples : 0;
+    result->fragmentation_mean = samples ? fragmentation_sum / samples : 0;
+
+    for (uint32_t w = 0; w < WHEEL_SIZE; w++) {
+        for (uint32_t i = wheel[w]; i != OBJECT_NONE; i = objects[i].next) {
+            object_free(slab, &objects[i]);
+        }
+    }
+    if (slab) {
+        ns_mem_slab_gc(true);
+    }
+    result->leaked = heap_used;
+    free(heap);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_NS_MEM_SLAB_H_
+#define TEST_NS_MEM_SLAB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the model heap */
+#define TEST_NS_MEM_SLAB_HEAP_SIZE (256 * 1024)
+
+typedef struct test_ns_mem_slab_result {
+    double ns_per_op;               /* Time of an allocation or free */
+    double search_steps_per_op;     /* Free blocks passed over by the heap */
+    double used_mean;               /* Heap in use, of the whole */
+    double fragmentation_mean;      /* Free memory outside the largest hole, of all free */
+    double fragmentation_max;
+    size_t largest_hole_min;
+    uint32_t fails;                 /* Allocations that failed */
+    size_t leaked;                  /* Heap in use after everything is freed and a full GC */
+} test_ns_mem_slab_result_t;
+
+/*
+ * Replays a border router allocation trace of the given number of steps
+ * against a model of the nsdynmemLIB heap: buffers, MAC frames, data
+ * indications and neighbour entries, with the other allocations of the
+ * stack mixed in. With slab, the objects ns_mem_slab handles in the stack
+ * go through it. The trace is the same each time.
+ */
+void test_ns_mem_slab_replay(bool slab, uint32_t steps, test_ns_mem_slab_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_NS_MEM_SLAB_H_ */
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include "gtest/gtest.h"
+
+#include "test_protocol_core.h"
+
+// IPv6 tunnel with a RPL option, and the source routing header of a border router
+#define TUNNEL (40 + 8)
+#define SOURCE_ROUTE (8 * 8)
+
+class Test_ProtocolCore : public testing::Test {
+protected:
+    virtual void TearDown()
+    {
+        test_protocol_core_deinit();
+    }
+
+    static void forward(const char *name, uint16_t tunnel_length)
+    {
+        const uint16_t count = 1200;
+        protocol_core_stub_copies = 0;
+        protocol_core_stub_heap_bytes = 0;
+        for (uint16_t length = 48; length < 48 + count; length++) {
+            test_protocol_core_forward(length, tunnel_length);
+        }
+        printf("%s, link headroom %u: copies/packet %.2f, heap bytes/packet %.0f\n", name,
+               test_protocol_core_link_headroom(), (double) protocol_core_stub_copies / count,
+               (double) protocol_core_stub_heap_bytes / count);
+    }
+};
+
+TEST_F(Test_ProtocolCore, headroom_follows_bootstrap)
+{
+    struct protocol_interface_info_entry *ethernet = test_protocol_core_interface(TEST_PROTOCOL_CORE_ETHERNET);
+    struct protocol_interface_info_entry *mesh = test_protocol_core_interface(TEST_PROTOCOL_CORE_BORDER_ROUTER);
+    EXPECT_EQ(0, test_protocol_core_link_headroom());
+
+    test_protocol_core_bootstrap(ethernet, true);
+    EXPECT_EQ(0, test_protocol_core_link_headroom());
+    EXPECT_EQ(0, test_protocol_core_rx_headroom(ethernet));
+
+    test_protocol_core_bootstrap(mesh, true);
+    EXPECT_EQ(TUNNEL + SOURCE_ROUTE, test_protocol_core_link_headroom());
+    EXPECT_EQ(16, test_protocol_core_rx_headroom(mesh));
+
+    test_protocol_core_bootstrap(mesh, false);
+    EXPECT_EQ(0, test_protocol_core_link_headroom());
+    EXPECT_EQ(0, test_protocol_core_rx_headroom(mesh));
+}
+
+TEST_F(Test_ProtocolCore, headroom_lowered_on_interface_down)
+{
+    struct protocol_interface_info_entry *border_router = test_protocol_core_interface(TEST_PROTOCOL_CORE_BORDER_ROUTER);
+    struct protocol_interface_info_entry *router = test_protocol_core_interface(TEST_PROTOCOL_CORE_ROUTER);
+    test_protocol_core_bootstrap(border_router, true);
+    test_protocol_core_bootstrap(router, true);
+    EXPECT_EQ(TUNNEL + SOURCE_ROUTE, test_protocol_core_link_headroom());
+
+    // Set down without a bootstrap event
+    test_protocol_core_down(border_router);
+    EXPECT_EQ(TUNNEL, test_protocol_core_link_headroom());
+    EXPECT_EQ(0, test_protocol_core_rx_headroom(border_router));
+
+    test_protocol_core_down(router);
+    EXPECT_EQ(0, test_protocol_core_link_headroom());
+}
+
+// Router forwarding packets, in a tunnel towards the root while it is up.
+// Once it is down, buffers no longer carry room for the tunnel.
+TEST_F(Test_ProtocolCore, simulate_forwarding)
+{
+    struct protocol_interface_info_entry *router = test_protocol_core_interface(TEST_PROTOCOL_CORE_ROUTER);
+    forward("no interface up", 0);
+    uint32_t heap_bytes = protocol_core_stub_heap_bytes;
+    forward("no interface up, tunnelled", TUNNEL);
+    EXPECT_LT(0, protocol_core_stub_copies);
+
+    test_protocol_core_bootstrap(router, true);
+    forward("router up, tunnelled", TUNNEL);
+    EXPECT_EQ(0, protocol_core_stub_copies);
+
+    test_protocol_core_down(router);
+    forward("router down", 0);
+    EXPECT_EQ(heap_bytes, protocol_core_stub_heap_bytes);
+}
@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stubs of the stack around protocol_core.c and buffer_dyn.c, for
+ * interfaces that come up and go down without a MAC or a bootstrap behind
+ * them. Everything else aborts.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* External definitions of the libservice inline functions */
+#define NS_LIST_FN extern
+#include "ns_list.h"
+#define COMMON_FUNCTIONS_FN extern
+#include "common_functions.h"
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "randLIB.h"
+#include "ip_fsc.h"
+#include "nsdynmemLIB.h"
+#include "eventOS_event.h"
+#include "platform/arm_hal_interrupt.h"
+#include "Core/include/ns_address_internal.h"
+#include "Core/include/ns_buffer.h"
+#include "Core/include/ns_socket.h"
+#include "Core/include/ns_monitor.h"
+#include "NWK_INTERFACE/Include/protocol.h"
+#include "NWK_INTERFACE/Include/protocol_stats.h"
+#include "NWK_INTERFACE/Include/protocol_timer.h"
+#include "Common_Protocols/ipv6.h"
+#include "Common_Protocols/ipv6_fragmentation.h"
+#include "Common_Protocols/icmpv6.h"
+#include "Common_Protocols/icmpv6_radv.h"
+#include "Common_Protocols/mld.h"
+#include "6LoWPAN/Bootstraps/protocol_6lowpan_bootstrap.h"
+#include "6LoWPAN/Fragmentation/cipv6_fragmenter.h"
+#include "6LoWPAN/IPHC_Decode/lowpan_context.h"
+#include "6LoWPAN/MAC/beacon_handler.h"
+#include "6LoWPAN/MAC/mac_data_poll.h"
+#include "6LoWPAN/MAC/mac_helper.h"
+#include "6LoWPAN/MAC/mac_response_handler.h"
+#include "6LoWPAN/ND/nd_router_object.h"
+#include "6LoWPAN/lowpan_adaptation_interface.h"
+#include "RPL/rpl_control.h"
+#include "Service_Libs/etx/etx.h"
+#include "Service_Libs/mac_neighbor_table/mac_neighbor_table.h"
+#include "ipv6_stack/ipv6_routing_table.h"
+#include "ipv6_stack/protocol_ipv6.h"
+#include "libNET/src/net_dns_internal.h"
+
+#include "test_protocol_core.h"
+
+#define UNREACHED() abort()
+
+const uint8_t ADDR_UNSPECIFIED[16];
+
+uint32_t protocol_core_stub_copies;
+uint32_t protocol_core_stub_heap_bytes;
+
+void protocol_stats_update(nwk_stats_type_t type, uint16_t update_val)
+{
+    if (type == STATS_BUFFER_HEADROOM_REALLOC) {
+        protocol_core_stub_copies += update_val;
+    }
+}
+
+void *ns_dyn_mem_alloc(ns_mem_block_size_t alloc_size)
+{
+    return malloc(alloc_size);
+}
+
+void *ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size)
+{
+    protocol_core_stub_heap_bytes += alloc_size;
+    return malloc(alloc_size);
+}
+
+void ns_dyn_mem_free(void *block)
+{
+    free(block);
+}
+
+void platform_enter_critical(void)
+{
+}
+
+void platform_exit_critical(void)
+{
+}
+
+int8_t eventOS_event_send(const arm_event_t *event)
+{
+    return 0;
+}
+
+void eventOS_event_send_user_allocated(arm_event_storage_t *event)
+{
+    UNREACHED();
+}
+
+int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_t *), uint8_t init_event_type)
+{
+    UNREACHED();
+    return -1;
+}
+
+void randLIB_add_seed(uint64_t seed)
+{
+    UNREACHED();
+}
+
+uint32_t randLIB_randomise_base(uint32_t base, uint16_t min_factor, uint16_t max_factor)
+{
+    return base;
+}
+
+bool bitsequal(const uint8_t *a, const uint8_t *b, uint_fast8_t bits)
+{
+    UNREACHED();
+    return false;
+}
+
+uint16_t ipv6_fcf(const uint8_t src_address[static 16], const uint8_t dest_address[static 16],
+                  uint16_t data_length, const uint8_t data_ptr[static data_length],  uint8_t next_protocol)
+{
+    UNREACHED();
+    return 0;
+}
+
+socket_t *socket_reference(socket_t *socket)
+{
+    UNREACHED();
+    return socket;
+}
+
+socket_t *socket_dereference(socket_t *socket)
+{
+    if (socket) {
+        UNREACHED();
+    }
+    return NULL;
+}
+
+buffer_t *socket_tx_buffer_event(buffer_t *buf, uint8_t status)
+{
+    UNREACHED();
+    return buf;
+}
+
+void socket_tx_buffer_event_and_free(buffer_t *buf, uint8_t status)
+{
+    UNREACHED();
+}
+
+int ns_monitor_init(void)
+{
+    UNREACHED();
+    return -1;
+}
+
+void ns_monitor_timer(uint16_t seconds)
+{
+    UNREACHED();
+}
+
+int protocol_timer_init(void)
+{
+    UNREACHED();
+    return -1;
+}
+
+void protocol_timer_start(protocol_timer_id_t id, void (*passed_fptr)(uint16_t), uint32_t time_ms)
+{
+    UNREACHED();
+}
+
+void protocol_timer_event_lock_free(void)
+{
+    UNREACHED();
+}
+
+void protocol_timer_cb(uint16_t ticks)
+{
+    UNREACHED();
+}
+
+/* Interface down, nothing to clean up */
+
+void icmpv6_stop_router_advertisements(protocol_interface_info_entry_t *cur, const uint8_t *abro)
+{
+}
+
+void lowpan_context_list_free(lowpan_context_list_t *list)
+{
+}
+
+void ipv6_neighbour_cache_flush(ipv6_neighbour_cache_t *cache)
+{
+}
+
+void rpl_control_remove_domain_from_interface(protocol_interface_info_entry_t *cur)
+{
+}
+
+void addr_delete_entry(protocol_interface_info_entry_t *cur, if_address_entry_t *addr)
+{
+    UNREACHED();
+}
+
+/* Bootstrap ready */
+
+void mac_data_poll_protocol_poll_mode_disable(protocol_interface_info_entry_t *cur)
+{
+}
+
+void addr_add_router_groups(protocol_interface_info_entry_t *interface)
+{
+    UNREACHED();
+}
+
+void icmpv6_restart_router_advertisements(protocol_interface_info_entry_t *cur, const uint8_t abro[16])
+{
+    UNREACHED();
+}
+
+void icmpv6_recv_ra_routes(protocol_interface_info_entry_t *cur, bool enable)
+{
+    UNREACHED();
+}
+
+void icmpv6_recv_ra_prefixes(protocol_interface_info_entry_t *cur, bool enable)
+{
+    UNREACHED();
+}
+
+/* Interface allocation */
+
+void neighbor_cache_init(neigh_cache_s *neigh_cache)
+{
+    UNREACHED();
+}
+
+void pan_blacklist_cache_init(pan_blaclist_cache_s *blacklist_cache)
+{
+    UNREACHED();
+}
+
+void pan_coordinator_blacklist_cache_init(pan_coordinator_blaclist_cache_s *coordinator_blacklist_cache)
+{
+    UNREACHED();
+}
+
+void ipv6_neighbour_cache_init(ipv6_neighbour_cache_t *cache, int8_t interface_id)
+{
+    UNREACHED();
+}
+
+void ipv6_neighbour_cache_print(const ipv6_neighbour_cache_t *cache, route_print_fn_t *print_fn)
+{
+    UNREACHED();
+}
+
+void addr_max_slaac_entries_set(protocol_interface_info_entry_t *cur, uint8_t max_slaac_entries)
+{
+    UNREACHED();
+}
+
+bool addr_is_assigned_to_interface(const protocol_interface_info_entry_t *interface, const uint8_t addr[static 16])
+{
+    UNREACHED();
+    return false;
+}
+
+void icmpv6_radv_init(protocol_interface_info_entry_t *cur)
+{
+    UNREACHED();
+}
+
+int8_t lowpan_adaptation_interface_init(int8_t interface_id, uint16_t mac_mtu_size)
+{
+    UNREACHED();
+    return -1;
+}
+
+int8_t lowpan_adaptation_interface_free(int8_t interface_id)
+{
+    UNREACHED();
+    return -1;
+}
+
+bool lowpan_adaptation_tx_active(int8_t interface_id)
+{
+    UNREACHED();
+    return false;
+}
+
+int8_t reassembly_interface_init(int8_t interface_id, uint8_t reassembly_session_limit, uint16_t reassembly_timeout)
+{
+    UNREACHED();
+    return -1;
+}
+
+int8_t reassembly_interface_free(int8_t interface_id)
+{
+    UNREACHED();
+    return -1;
+}
+
+int8_t mac_helper_mac64_set(protocol_interface_info_entry_t *interface, const uint8_t *mac64)
+{
+    UNREACHED();
+    return -1;
+}
+
+void mac_helper_set_default_key_source(protocol_interface_info_entry_t *interface)
+{
+    UNREACHED();
+}
+
+void ipv6_interface_phy_sap_register(protocol_interface_info_entry_t *cur)
+{
+    UNREACHED();
+}
+
+void mcps_data_confirm_handler(const mac_api_t *api, const struct mcps_data_conf_s *data)
+{
+    UNREACHED();
+}
+
+void mcps_data_indication_handler(const mac_api_t *api, const struct mcps_data_ind_s *data)
+{
+    UNREACHED();
+}
+
+void mcps_purge_confirm_handler(const mac_api_t *api, mcps_purge_conf_t *data)
+{
+    UNREACHED();
+}
+
+void mlme_confirm_handler(const mac_api_t *api, mlme_primitive id, const void *data)
+{
+    UNREACHED();
+}
+
+void mlme_indication_handler(const mac_api_t *api, mlme_primitive id, const void *data)
+{
+    UNREACHED();
+}
+
+void beacon_received(int8_t if_id, const struct mlme_beacon_ind_s *data)
+{
+    UNREACHED();
+}
+
+void beacon_join_priority_update(int8_t interface_id)
+{
+    UNREACHED();
+}
+
+/* Packets and timers */
+
+buffer_routing_info_t *ipv6_buffer_route(buffer_t *buf)
+{
+    UNREACHED();
+    return NULL;
+}
+
+void protocol_6lowpan_bootstrap(protocol_interface_info_entry_t *cur)
+{
+    UNREACHED();
+}
+
+void protocol_6lowpan_mle_timer(uint16_t ticks_update)
+{
+    UNREACHED();
+}
+
+void ipv6_core_timer_event_handle(protocol_interface_info_entry_t *cur, uint8_t event)
+{
+    UNREACHED();
+}
+
+void ipv6_core_slow_timer_event_handle(protocol_interface_info_entry_t *cur)
+{
+    UNREACHED();
+}
+
+void ipv6_stack_route_advert_remove(uint8_t *address, uint8_t prefixLength)
+{
+    UNREACHED();
+}
+
+void ipv6_route_table_set_max_entries(int8_t interface_id, ipv6_route_src_t source, uint8_t max_entries)
+{
+    UNREACHED();
+}
+
+void ipv6_route_table_ttl_update(uint16_t seconds)
+{
+    UNREACHED();
+}
+
+void ipv6_route_table_source_invalidated_reset(void)
+{
+    UNREACHED();
+}
+
+bool ipv6_route_table_source_was_invalidated(ipv6_route_src_t src)
+{
+    UNREACHED();
+    return false;
+}
+
+void ipv6_destination_cache_timer(uint8_t ticks)
+{
+    UNREACHED();
+}
+
+void ipv6_neighbour_cache_fast_timer(ipv6_neighbour_cache_t *cache, uint16_t ticks)
+{
+    UNREACHED();
+}
+
+void ipv6_neighbour_cache_slow_timer(ipv6_neighbour_cache_t *cache, uint8_t seconds)
+{
+    UNREACHED();
+}
+
+void ipv6_frag_timer(uint8_t secs)
+{
+    UNREACHED();
+}
+
+void cipv6_frag_timer(uint16_t seconds)
+{
+    UNREACHED();
+}
+
+void lowpan_adaptation_interface_slow_timer(protocol_interface_info_entry_t *cur)
+{
+    UNREACHED();
+}
+
+void lowpan_context_timer(lowpan_context_list_t *list, uint_fast16_t ticks)
+{
+    UNREACHED();
+}
+
+void addr_fast_timer(protocol_interface_info_entry_t *cur, uint_fast16_t ticks)
+{
+    UNREACHED();
+}
+
+void addr_slow_timer(protocol_interface_info_entry_t *cur, uint_fast16_t seconds)
+{
+    UNREACHED();
+}
+
+void mld_fast_timer(protocol_interface_info_entry_t *interface, uint_fast16_t ticks)
+{
+    UNREACHED();
+}
+
+void mld_slow_timer(protocol_interface_info_entry_t *interface, uint_fast16_t seconds)
+{
+    UNREACHED();
+}
+
+void icmpv6_radv_timer(uint16_t ticks)
+{
+    UNREACHED();
+}
+
+void nd_object_timer(protocol_interface_info_entry_t *cur_interface, uint16_t ticks_update)
+{
+    UNREACHED();
+}
+
+void rpl_control_fast_timer(uint16_t ticks)
+{
+    UNREACHED();
+}
+
+void rpl_control_slow_timer(uint16_t seconds)
+{
+    UNREACHED();
+}
+
+void etx_cache_timer(int8_t interface_id, uint16_t seconds_update)
+{
+    UNREACHED();
+}
+
+void mac_neighbor_table_neighbor_timeout_update(mac_neighbor_table_t *table_class, uint32_t time_update)
+{
+    UNREACHED();
+}
+
+void net_dns_timer_seconds(uint32_t seconds)
+{
+    UNREACHED();
+}
+
+void pan_blacklist_time_update(pan_blaclist_cache_s *blacklist_cache, uint16_t time_update_in_seconds)
+{
+    UNREACHED();
+}
+
+void pan_coordinator_blacklist_time_update(pan_coordinator_blaclist_cache_s *coordinator_blacklist_cache, uint16_t time_update_in_seconds)
+{
+    UNREACHED();
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ns_list.h"
+#include "Core/include/ns_buffer.h"
+#include "NWK_INTERFACE/Include/protocol.h"
+#include "Common_Protocols/ipv6_constants.h"
+
+#include "test_protocol_core.h"
+
+// Only compared against NULL
+static uint8_t rpl_domain;
+
+static int8_t interface_down(protocol_interface_info_entry_t *cur)
+{
+    test_protocol_core_down(cur);
+    return 0;
+}
+
+void test_protocol_core_deinit(void)
+{
+    ns_list_foreach_safe(protocol_interface_info_entry_t, cur, &protocol_interface_info_list) {
+        ns_list_remove(&protocol_interface_info_list, cur);
+        free(cur);
+    }
+    buffer_link_headroom_set(0);
+    protocol_core_stub_copies = 0;
+    protocol_core_stub_heap_bytes = 0;
+}
+
+protocol_interface_info_entry_t *test_protocol_core_interface(test_protocol_core_interface_t type)
+{
+    protocol_interface_info_entry_t *cur = calloc(1, sizeof(protocol_interface_info_entry_t));
+    cur->id = ns_list_count(&protocol_interface_info_list) + 1;
+    ns_list_init(&cur->ip_addresses);
+    cur->if_down = interface_down;
+    switch (type) {
+        case TEST_PROTOCOL_CORE_ETHERNET:
+            cur->nwk_id = IF_IPV6;
+            cur->bootsrap_mode = ARM_NWK_BOOTSRAP_MODE_ETHERNET_ROUTER;
+            break;
+        case TEST_PROTOCOL_CORE_ROUTER:
+            cur->nwk_id = IF_6LoWPAN;
+            cur->bootsrap_mode = ARM_NWK_BOOTSRAP_MODE_6LoWPAN_ROUTER;
+            cur->rpl_domain = (struct rpl_domain *) &rpl_domain;
+            break;
+        case TEST_PROTOCOL_CORE_BORDER_ROUTER:
+            cur->nwk_id = IF_6LoWPAN;
+            cur->bootsrap_mode = ARM_NWK_BOOTSRAP_MODE_6LoWPAN_BORDER_ROUTER;
+            cur->rpl_domain = (struct rpl_domain *) &rpl_domain;
+            break;
+    }
+    ns_list_add_to_end(&protocol_interface_info_list, cur);
+    return cur;
+}
+
+void test_protocol_core_bootstrap(protocol_interface_info_entry_t *cur, bool ready)
+{
+    nwk_bootsrap_state_update(ready ? ARM_NWK_BOOTSTRAP_READY : ARM_NWK_NWK_SCAN_FAIL, cur);
+}
+
+void test_protocol_core_down(protocol_interface_info_entry_t *cur)
+{
+    protocol_core_interface_info_reset(cur);
+}
+
+uint16_t test_protocol_core_rx_headroom(const protocol_interface_info_entry_t *cur)
+{
+    return cur->buffer_rx_headroom;
+}
+
+uint16_t test_protocol_core_link_headroom(void)
+{
+    return buffer_link_headroom();
+}
+
+void test_protocol_core_forward(uint16_t packet_length, uint16_t tunnel_length)
+{
+    static const uint8_t packet[1280];
+    buffer_t *buf = buffer_get(packet_length);
+    buffer_data_add(buf, packet, packet_length);
+    buf = buffer_headroom(buf, tunnel_length);
+    buffer_data_reserve_header(buf, tunnel_length);
+    buffer_free(buf);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_PROTOCOL_CORE_H_
+#define TEST_PROTOCOL_CORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct protocol_interface_info_entry;
+
+typedef enum {
+    TEST_PROTOCOL_CORE_ETHERNET,
+    TEST_PROTOCOL_CORE_ROUTER,          // 6LoWPAN, in a RPL domain
+    TEST_PROTOCOL_CORE_BORDER_ROUTER,   // 6LoWPAN, root of a RPL domain
+} test_protocol_core_interface_t;
+
+/* Set by the stubs */
+extern uint32_t protocol_core_stub_copies;
+extern uint32_t protocol_core_stub_heap_bytes;
+
+void test_protocol_core_deinit(void);
+
+/* New interface in the interface list, not bootstrapped */
+struct protocol_interface_info_entry *test_protocol_core_interface(test_protocol_core_interface_t type);
+
+/* Bootstrap of the interface completes, or fails */
+void test_protocol_core_bootstrap(struct protocol_interface_info_entry *cur, bool ready);
+
+/* Interface is set down, as arm_nwk_interface_down() does */
+void test_protocol_core_down(struct protocol_interface_info_entry *cur);
+
+uint16_t test_protocol_core_rx_headroom(const struct protocol_interface_info_entry *cur);
+
+uint16_t test_protocol_core_link_headroom(void);
+
+/* Forwards an IPv6 packet in a buffer of the stack, tunnelled with
+ * headers of the given length */
+void test_protocol_core_forward(uint16_t packet_length, uint16_t tunnel_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_PROTOCOL_CORE_H_ */
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "gtest/gtest.h"
+
+#include "test_rpl_data.h"
+
+class Test_RplData : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        test_rpl_data_init();
+    }
+
+    virtual void TearDown()
+    {
+        test_rpl_data_deinit();
+    }
+
+    // Chain of nodes 1..n, node 1 next to the root
+    void chain(uint32_t n)
+    {
+        for (uint32_t node = 1; node <= n; node++) {
+            test_rpl_data_dao(node, node - 1);
+        }
+    }
+
+    bool next_hop_is(uint32_t dest, uint32_t node)
+    {
+        uint8_t next_hop[16], expected[16];
+        memset(next_hop, 0, sizeof next_hop);
+        test_rpl_data_node_address(expected, node);
+        return test_rpl_data_route(dest, next_hop) && memcmp(next_hop, expected, 16) == 0;
+    }
+};
+
+TEST_F(Test_RplData, route_chain)
+{
+    chain(3);
+
+    EXPECT_TRUE(next_hop_is(1, 1));
+    EXPECT_TRUE(next_hop_is(2, 1));
+    EXPECT_TRUE(next_hop_is(3, 1));
+    EXPECT_EQ(0, rpl_data_stub_route_loops);
+}
+
+TEST_F(Test_RplData, route_saturated_transit_costs)
+{
+    chain(4);
+
+    // Errors add 4 to a transit cost, it saturates at 0xFFFF. Path costs
+    // then go past 16 bits from the second hop on.
+    for (uint32_t node = 1; node <= 4; node++) {
+        test_rpl_data_transit_error(node, node - 1, 0x4000);
+    }
+
+    EXPECT_TRUE(next_hop_is(4, 1));
+    EXPECT_TRUE(next_hop_is(3, 1));
+    EXPECT_TRUE(next_hop_is(2, 1));
+    EXPECT_EQ(0, rpl_data_stub_route_loops);
+}
+
+TEST_F(Test_RplData, route_saturated_transit_costs_best_path)
+{
+    // Node 4 is behind 1 -> 2 and 3, both next to the root
+    const uint32_t parents[] = {2, 3};
+    chain(2);
+    test_rpl_data_dao(3, TEST_RPL_DATA_ROOT);
+    test_rpl_data_dao_parents(4, parents, 2);
+
+    // Path costs to 2 and 3 are 0x1FFFE and 0xFFFF, so 4 is cheaper through 3
+    test_rpl_data_transit_error(1, TEST_RPL_DATA_ROOT, 0x4000);
+    test_rpl_data_transit_error(2, 1, 0x4000);
+    test_rpl_data_transit_error(3, TEST_RPL_DATA_ROOT, 0x4000);
+
+    EXPECT_TRUE(next_hop_is(4, 3));
+    EXPECT_TRUE(next_hop_is(2, 1));
+    EXPECT_EQ(0, rpl_data_stub_route_loops);
+}
+
+TEST_F(Test_RplData, route_loop)
+{
+    chain(3);
+    ASSERT_TRUE(next_hop_is(3, 1));
+
+    // Loop 1 -> 3 -> 2 -> 1, which the topology sort would not leave
+    struct rpl_dao_target *parent = test_rpl_data_set_best_parent(1, test_rpl_data_target(3));
+
+    uint8_t next_hop[16];
+    EXPECT_FALSE(test_rpl_data_route(3, next_hop));
+    EXPECT_EQ(1, rpl_data_stub_route_loops);
+
+    test_rpl_data_set_best_parent(1, parent);
+    EXPECT_TRUE(next_hop_is(3, 1));
+}
+
+TEST_F(Test_RplData, route_loop_to_final_destination)
+{
+    chain(3);
+    ASSERT_TRUE(next_hop_is(3, 1));
+
+    // Path to 3 goes back through 3 itself
+    test_rpl_data_set_best_transit(2, 3);
+
+    uint8_t next_hop[16];
+    EXPECT_FALSE(test_rpl_data_route(3, next_hop));
+    EXPECT_EQ(1, rpl_data_stub_route_loops);
+}
+
+TEST_F(Test_RplData, route_walk_number_wraps)
+{
+    chain(3);
+    test_rpl_data_set_sr_walk(0);
+    ASSERT_TRUE(next_hop_is(3, 1));
+
+    // Next computation wraps to the number the targets are marked with
+    test_rpl_data_set_sr_walk(UINT16_MAX);
+    EXPECT_TRUE(next_hop_is(3, 1));
+    EXPECT_EQ(0, rpl_data_stub_route_loops);
+}
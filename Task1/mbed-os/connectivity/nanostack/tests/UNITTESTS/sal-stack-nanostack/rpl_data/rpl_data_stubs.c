@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stubs of the stack around rpl_data.c and rpl_downward.c, for a
+ * non-storing root whose DODAG is fed with DAOs. Everything the source
+ * routing computation doesn't reach aborts.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* External definitions of the libservice inline functions */
+#define NS_LIST_FN extern
+#include "ns_list.h"
+#define COMMON_FUNCTIONS_FN extern
+#include "common_functions.h"
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ip6string.h"
+#include "randLIB.h"
+#include "nsdynmemLIB.h"
+#include "Core/include/ns_address_internal.h"
+#include "Core/include/ns_buffer.h"
+#include "NWK_INTERFACE/Include/protocol.h"
+#include "NWK_INTERFACE/Include/protocol_stats.h"
+#include "Common_Protocols/ipv6.h"
+#include "Common_Protocols/ipv6_resolution.h"
+#include "Common_Protocols/icmpv6.h"
+#include "ipv6_stack/ipv6_routing_table.h"
+#include "RPL/rpl_protocol.h"
+#include "RPL/rpl_policy.h"
+#include "RPL/rpl_upward.h"
+#include "RPL/rpl_downward.h"
+#include "RPL/rpl_control.h"
+#include "RPL/rpl_structures.h"
+
+#include "test_rpl_data.h"
+
+#define UNREACHED() abort()
+
+/* As in rpl_upward.c */
+#define RPL_SEQUENCE_WINDOW 16
+
+const uint8_t ADDR_UNSPECIFIED[16];
+uint32_t protocol_core_monotonic_time;
+
+ipv6_route_next_hop_fn_t *rpl_data_stub_next_hop_fn;
+uint32_t rpl_data_stub_route_loops;
+
+void memswap(uint8_t *restrict a, uint8_t *restrict b, uint_fast8_t len)
+{
+    while (len--) {
+        uint8_t t = *a;
+        *a++ = *b;
+        *b++ = t;
+    }
+}
+
+uint_fast8_t ip6tos(const void *ip6addr, char *p)
+{
+    *p = '\0';
+    return 0;
+}
+
+uint_fast8_t ip6_prefix_tos(const void *prefix, uint_fast8_t prefix_len, char *p)
+{
+    *p = '\0';
+    return 0;
+}
+
+uint16_t randLIB_get_random_in_range(uint16_t min, uint16_t max)
+{
+    return min;
+}
+
+uint32_t randLIB_randomise_base(uint32_t base, uint16_t min_factor, uint16_t max_factor)
+{
+    return base;
+}
+
+void ns_dyn_mem_free(void *block)
+{
+    free(block);
+}
+
+void *ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size)
+{
+    return malloc(alloc_size);
+}
+
+bool addr_ipv6_equal(const uint8_t a[static 16], const uint8_t b[static 16])
+{
+    return memcmp(a, b, 16) == 0;
+}
+
+bool addr_is_ipv6_link_local(const uint8_t addr[static 16])
+{
+    return addr[0] == 0xfe && (addr[1] & 0xc0) == 0x80;
+}
+
+uint8_t *bitcopy0(uint8_t *restrict dst, const uint8_t *restrict src, uint_fast8_t bits)
+{
+    memset(dst, 0, 16);
+    memcpy(dst, src, (bits + 7) / 8);
+    return dst;
+}
+
+bool bitsequal(const uint8_t *a, const uint8_t *b, uint_fast8_t bits)
+{
+    return memcmp(a, b, bits / 8) == 0;
+}
+
+uint8_t addr_len_from_type(addrtype_t addr_type)
+{
+    UNREACHED();
+    return 0;
+}
+
+int8_t addr_interface_address_compare(protocol_interface_info_entry_t *cur, const uint8_t *addr)
+{
+    UNREACHED();
+    return -1;
+}
+
+int8_t protocol_interface_address_compare(const uint8_t *addr)
+{
+    return addr_ipv6_equal(addr, test_rpl_data_root_address) ? 0 : -1;
+}
+
+protocol_interface_info_entry_t *protocol_stack_interface_info_get_by_id(int8_t nwk_id)
+{
+    return NULL;
+}
+
+protocol_interface_info_entry_t *protocol_stack_interface_info_get_by_rpl_domain(const struct rpl_domain *domain, int8_t last_id)
+{
+    return NULL;
+}
+
+void protocol_push(buffer_t *buf)
+{
+    UNREACHED();
+}
+
+void protocol_stats_update(nwk_stats_type_t type, uint16_t update_val)
+{
+    if (type == STATS_RPL_ROUTELOOP) {
+        rpl_data_stub_route_loops += update_val;
+    }
+}
+
+buffer_t *buffer_free(buffer_t *buf)
+{
+    UNREACHED();
+    return NULL;
+}
+
+buffer_t *buffer_free_route(buffer_t *buf)
+{
+    UNREACHED();
+    return NULL;
+}
+
+buffer_t *buffer_headroom(buffer_t *buf, uint16_t size)
+{
+    UNREACHED();
+    return NULL;
+}
+
+buffer_t *icmpv6_build_ns(protocol_interface_info_entry_t *cur, const uint8_t target_addr[static 16], const uint8_t *prompting_src_addr, bool unicast, bool unspecified_source, const aro_t *aro)
+{
+    UNREACHED();
+    return NULL;
+}
+
+buffer_t *icmpv6_error(buffer_t *buf, protocol_interface_info_entry_t *cur, uint8_t type, uint8_t code, uint32_t aux)
+{
+    UNREACHED();
+    return NULL;
+}
+
+buffer_routing_info_t *ipv6_buffer_route_to(buffer_t *buf, const uint8_t *next_hop, protocol_interface_info_entry_t *next_if)
+{
+    UNREACHED();
+    return NULL;
+}
+
+bool ipv6_map_ip_to_ll(protocol_interface_info_entry_t *cur, ipv6_neighbour_t *n, const uint8_t ip_addr[16], addrtype_t *ll_type, const uint8_t **ll_addr_out)
+{
+    UNREACHED();
+    return false;
+}
+
+bool ipv6_map_ll_to_ip_link_local(protocol_interface_info_entry_t *cur, addrtype_t ll_type, const uint8_t *ll_addr, uint8_t ip_addr_out[16])
+{
+    UNREACHED();
+    return false;
+}
+
+void ipv6_neighbour_reachability_confirmation(const uint8_t ip_address[static 16], int8_t interface_id)
+{
+    UNREACHED();
+}
+
+void ipv6_neighbour_reachability_problem(const uint8_t ip_address[static 16], int8_t interface_id)
+{
+    UNREACHED();
+}
+
+ipv6_route_t *ipv6_route_add_with_info(const uint8_t *prefix, uint8_t prefix_len, int8_t interface_id, const uint8_t *next_hop, ipv6_route_src_t source, void *info, uint8_t source_id, uint32_t lifetime, int_fast8_t pref)
+{
+    return NULL;
+}
+
+int_fast8_t ipv6_route_delete_with_info(const uint8_t *prefix, uint8_t prefix_len, int8_t interface_id, const uint8_t *next_hop, ipv6_route_src_t source, void *info, int_fast16_t source_id)
+{
+    return 0;
+}
+
+ipv6_route_t *ipv6_route_lookup_with_info(const uint8_t *prefix, uint8_t prefix_len, int8_t interface_id, const uint8_t *next_hop, ipv6_route_src_t source, void *info, int_fast16_t source_id)
+{
+    return NULL;
+}
+
+void ipv6_route_table_remove_info(int8_t interface_id, ipv6_route_src_t source, void *info)
+{
+}
+
+void ipv6_route_table_set_predicate_fn(ipv6_route_src_t src, ipv6_route_predicate_fn_t *fn)
+{
+}
+
+void ipv6_route_table_set_next_hop_fn(ipv6_route_src_t src, ipv6_route_next_hop_fn_t *fn)
+{
+    if (src == ROUTE_RPL_DAO_SR) {
+        rpl_data_stub_next_hop_fn = fn;
+    }
+}
+
+void ipv6_set_exthdr_provider(ipv6_route_src_t src, ipv6_exthdr_provider_fn_t *fn)
+{
+}
+
+void *rpl_alloc(uint16_t size)
+{
+    return malloc(size);
+}
+
+void *rpl_realloc(void *p, uint16_t old_size, uint16_t new_size)
+{
+    return realloc(p, new_size);
+}
+
+void rpl_free(void *p, uint16_t size)
+{
+    free(p);
+}
+
+uint8_t rpl_seq_init(void)
+{
+    return 256 - RPL_SEQUENCE_WINDOW;
+}
+
+uint8_t rpl_seq_inc(uint8_t seq)
+{
+    return seq == 127 ? 0 : (uint8_t)(seq + 1);
+}
+
+rpl_cmp_t rpl_seq_compare(uint8_t a, uint8_t b)
+{
+    /* Test sequences stay in the circular region */
+    if (a == b) {
+        return RPL_CMP_EQUAL;
+    }
+    return ((a - b) & 127) <= RPL_SEQUENCE_WINDOW ? RPL_CMP_GREATER : RPL_CMP_LESS;
+}
+
+rpl_dodag_t *rpl_instance_current_dodag(const rpl_instance_t *instance)
+{
+    return test_rpl_data_dodag;
+}
+
+bool rpl_instance_am_root(const rpl_instance_t *instance)
+{
+    return true;
+}
+
+uint8_t rpl_instance_mop(const rpl_instance_t *instance)
+{
+    return RPL_MODE_NON_STORING;
+}
+
+bool rpl_dodag_am_root(const rpl_dodag_t *dodag)
+{
+    return true;
+}
+
+uint8_t rpl_dodag_mop(const rpl_dodag_t *dodag)
+{
+    return RPL_MODE_NON_STORING;
+}
+
+const rpl_dodag_conf_int_t *rpl_dodag_get_config(const rpl_dodag_t *dodag)
+{
+    return &dodag->config;
+}
+
+uint16_t nrpl_dag_rank(const rpl_dodag_t *dodag, uint16_t rank)
+{
+    UNREACHED();
+    return 0;
+}
+
+rpl_cmp_t rpl_rank_compare_dagrank_rank(const rpl_dodag_t *dodag, uint16_t dag_rank_a, uint16_t b)
+{
+    UNREACHED();
+    return RPL_CMP_EQUAL;
+}
+
+rpl_instance_t *rpl_lookup_instance(const rpl_domain_t *domain, uint8_t instance_id, const uint8_t *addr)
+{
+    UNREACHED();
+    return NULL;
+}
+
+rpl_instance_t *rpl_neighbour_instance(const rpl_neighbour_t *neighbour)
+{
+    UNREACHED();
+    return NULL;
+}
+
+rpl_neighbour_t *rpl_instance_preferred_parent(const rpl_instance_t *instance)
+{
+    UNREACHED();
+    return NULL;
+}
+
+void rpl_instance_inconsistency(rpl_instance_t *instance)
+{
+    UNREACHED();
+}
+
+void rpl_instance_increment_dtsn(rpl_instance_t *instance)
+{
+}
+
+void rpl_delete_neighbour(rpl_instance_t *instance, rpl_neighbour_t *neighbour)
+{
+    UNREACHED();
+}
+
+void rpl_control_event(struct rpl_domain *domain, rpl_event_t event)
+{
+    UNREACHED();
+}
+
+bool rpl_control_transmit_dao(struct rpl_domain *domain, struct protocol_interface_info_entry *cur, struct rpl_instance *instance, uint8_t instance_id, uint8_t dao_sequence, const uint8_t dodagid[16], const uint8_t *opts, uint16_t opts_size, const uint8_t *dst)
+{
+    UNREACHED();
+    return false;
+}
+
+uint16_t rpl_policy_modify_downward_cost_to_root_neighbour(rpl_domain_t *domain, int8_t if_id, const uint8_t *next_hop, uint16_t cost)
+{
+    return cost;
+}
+
+bool rpl_policy_dao_trigger_after_srh_error(rpl_domain_t *domain, uint32_t seconds_since_last_dao_trigger, uint16_t errors_since_last_dao_trigger, uint_fast16_t targets)
+{
+    return false;
+}
+
+bool rpl_policy_force_tunnel(void)
+{
+    return false;
+}
+
+int8_t rpl_policy_srh_next_hop_interface(rpl_domain_t *domain, int8_t if_id, const uint8_t *next_hop)
+{
+    return if_id;
+}
+
+uint16_t rpl_policy_address_registration_timeout()
+{
+    UNREACHED();
+    return 0;
+}
+
+int8_t rpl_policy_dao_retry_count()
+{
+    UNREACHED();
+    return 0;
+}
+
+uint16_t rpl_policy_initial_dao_ack_wait(const rpl_domain_t *domain, uint8_t mop)
+{
+    UNREACHED();
+    return 0;
+}
+
+uint16_t rpl_policy_minimum_dao_target_refresh(void)
+{
+    UNREACHED();
+    return 0;
+}
+
+bool rpl_policy_parent_confirmation_requested(void)
+{
+    UNREACHED();
+    return false;
+}
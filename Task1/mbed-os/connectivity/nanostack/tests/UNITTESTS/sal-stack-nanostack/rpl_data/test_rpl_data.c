@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "nsconfig.h"
+#include "ns_types.h"
+#include "ns_list.h"
+#include "NWK_INTERFACE/Include/protocol.h"
+#include "ipv6_stack/ipv6_routing_table.h"
+#include "RPL/rpl_protocol.h"
+#include "RPL/rpl_upward.h"
+#include "RPL/rpl_downward.h"
+#include "RPL/rpl_data.h"
+#include "RPL/rpl_structures.h"
+
+#include "test_rpl_data.h"
+
+#define TEST_RPL_DATA_NODES 16
+
+extern ipv6_route_next_hop_fn_t *rpl_data_stub_next_hop_fn;
+
+const uint8_t test_rpl_data_root_address[16] = {0xfd, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+rpl_dodag_t *test_rpl_data_dodag;
+
+static rpl_instance_t instance;
+static rpl_dodag_t dodag;
+static uint8_t path_sequence[TEST_RPL_DATA_NODES];
+
+void test_rpl_data_init(void)
+{
+    memset(&instance, 0, sizeof instance);
+    memset(&dodag, 0, sizeof dodag);
+    memset(path_sequence, 0, sizeof path_sequence);
+    ns_list_init(&instance.dao_targets);
+    ns_list_init(&instance.root_children);
+    dodag.instance = &instance;
+    dodag.config.lifetime_unit = 60;
+    test_rpl_data_dodag = &dodag;
+    rpl_data_stub_route_loops = 0;
+    rpl_data_init_root();
+}
+
+void test_rpl_data_deinit(void)
+{
+    ns_list_foreach_safe(rpl_dao_target_t, target, &instance.dao_targets) {
+        rpl_delete_dao_target(&instance, target);
+    }
+    rpl_data_sr_invalidate();
+}
+
+void test_rpl_data_node_address(uint8_t address[16], uint32_t node)
+{
+    memcpy(address, test_rpl_data_root_address, 16);
+    if (node == TEST_RPL_DATA_ROOT) {
+        return;
+    }
+    address[11] = 0xff;
+    address[12] = 0xfe;
+    address[13] = node >> 16;
+    address[14] = node >> 8;
+    address[15] = node;
+}
+
+void test_rpl_data_dao_parents(uint32_t node, const uint32_t *parents, uint_fast8_t count)
+{
+    uint8_t opts[20 + 22 * 2], status;
+    uint8_t *ptr = opts;
+
+    *ptr++ = RPL_TARGET_OPTION;
+    *ptr++ = 18;
+    *ptr++ = 0;
+    *ptr++ = 128;
+    test_rpl_data_node_address(ptr, node);
+    ptr += 16;
+    for (uint_fast8_t i = 0; i < count && i < 2; i++) {
+        *ptr++ = RPL_TRANSIT_OPTION;
+        *ptr++ = 20;
+        *ptr++ = 0;
+        *ptr++ = 0x80 >> i; // Path Control, both most preferred
+        *ptr++ = path_sequence[node];
+        *ptr++ = 30; // Path Lifetime
+        test_rpl_data_node_address(ptr, parents[i]);
+        ptr += 16;
+    }
+    path_sequence[node] = (path_sequence[node] + 1) & 127;
+    rpl_instance_dao_received(&instance, opts + 4, 0, false, opts, ptr - opts, &status);
+}
+
+void test_rpl_data_dao(uint32_t node, uint32_t parent)
+{
+    test_rpl_data_dao_parents(node, &parent, 1);
+}
+
+void test_rpl_data_transit_error(uint32_t node, uint32_t parent, uint32_t count)
+{
+    uint8_t target_address[16], transit_address[16];
+
+    test_rpl_data_node_address(target_address, node);
+    test_rpl_data_node_address(transit_address, parent);
+    while (count--) {
+        rpl_downward_transit_error(&instance, target_address, transit_address);
+    }
+}
+
+bool test_rpl_data_route(uint32_t node, uint8_t next_hop[16])
+{
+    uint8_t address[16];
+    ipv6_route_info_t route_info;
+
+    test_rpl_data_node_address(address, node);
+    memset(&route_info, 0, sizeof route_info);
+    route_info.source = ROUTE_RPL_DAO_SR;
+    route_info.info = rpl_instance_match_dao_target(&instance, address, 128);
+    if (!route_info.info || !rpl_data_stub_next_hop_fn(address, &route_info)) {
+        return false;
+    }
+    memcpy(next_hop, route_info.next_hop_addr, 16);
+    return true;
+}
+
+rpl_dao_target_t *test_rpl_data_target(uint32_t node)
+{
+    uint8_t address[16];
+
+    test_rpl_data_node_address(address, node);
+    return rpl_instance_match_dao_target(&instance, address, 128);
+}
+
+rpl_dao_target_t *test_rpl_data_set_best_parent(uint32_t node, rpl_dao_target_t *parent)
+{
+    rpl_dao_root_transit_t *transit = ns_list_get_first(&test_rpl_data_target(node)->info.root.transits);
+    rpl_dao_target_t *old_parent = transit->parent;
+
+    transit->parent = parent;
+    /* Next route is computed again, with the paths left as they are */
+    rpl_data_sr_invalidate();
+    return old_parent;
+}
+
+void test_rpl_data_set_best_transit(uint32_t node, uint32_t transit_node)
+{
+    rpl_dao_root_transit_t *transit = ns_list_get_first(&test_rpl_data_target(node)->info.root.transits);
+
+    test_rpl_data_node_address(transit->transit, transit_node);
+    rpl_data_sr_invalidate();
+}
+
+void test_rpl_data_set_sr_walk(uint16_t walk)
+{
+    instance.root_sr_walk = walk;
+    rpl_data_sr_invalidate();
+}
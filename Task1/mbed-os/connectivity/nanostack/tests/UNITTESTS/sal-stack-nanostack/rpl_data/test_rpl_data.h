@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021, Pelion and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_RPL_DATA_H_
+#define TEST_RPL_DATA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct rpl_dodag;
+struct rpl_dao_target;
+
+/* Non-storing DODAG with us as the root, nodes are numbered from 1 */
+#define TEST_RPL_DATA_ROOT 0
+
+extern const uint8_t test_rpl_data_root_address[16];
+extern struct rpl_dodag *test_rpl_data_dodag;
+
+/* Set by the stubs */
+extern uint32_t rpl_data_stub_route_loops;
+
+void test_rpl_data_init(void);
+
+void test_rpl_data_deinit(void);
+
+void test_rpl_data_node_address(uint8_t address[16], uint32_t node);
+
+/* Node's DAO, with a single transit through the parent */
+void test_rpl_data_dao(uint32_t node, uint32_t parent);
+
+/* Node's DAO, with a transit through each parent, up to two */
+void test_rpl_data_dao_parents(uint32_t node, const uint32_t *parents, uint_fast8_t count);
+
+/* Reports source routing errors on the node's transit through the parent */
+void test_rpl_data_transit_error(uint32_t node, uint32_t parent, uint32_t count);
+
+/* Next hop of a packet to the node, as the routing table asks for it */
+bool test_rpl_data_route(uint32_t node, uint8_t next_hop[16]);
+
+/* Replaces the parent of the node's best transit, returns the old one */
+struct rpl_dao_target *test_rpl_data_set_best_parent(uint32_t node, struct rpl_dao_target *parent);
+
+struct rpl_dao_target *test_rpl_data_target(uint32_t node);
+
+/* Replaces the address of the node's best transit, the parent stays */
+void test_rpl_data_set_best_transit(uint32_t node, uint32_t transit_node);
+
+/* Sets the number of the last source route computation */
+void test_rpl_data_set_sr_walk(uint16_t walk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_RPL_DATA_H_ */
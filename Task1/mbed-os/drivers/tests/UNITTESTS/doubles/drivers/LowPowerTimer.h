@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021 Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_LOWPOWERTIMER_H
+#define MBED_LOWPOWERTIMER_H
+
+#include <chrono>
+
+namespace mbed {
+
+/** mock Low Power Timer
+ *
+ */
+class LowPowerTimer {
+
+public:
+    LowPowerTimer()
+    {
+    }
+
+    ~LowPowerTimer()
+    {
+    }
+
+    void start()
+    {
+
+    }
+
+    void stop()
+    {
+
+    }
+
+    void reset()
+    {
+
+    }
+
+    std::chrono::microseconds elapsed_time() const
+    {
+        return std::chrono::microseconds(0);
+    }
+};
+
+} // namespace mbed
+
+#endif
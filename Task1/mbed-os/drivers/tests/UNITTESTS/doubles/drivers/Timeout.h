@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2021 Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_TIMEOUT_H
+#define MBED_TIMEOUT_H
+
+#include <chrono>
+
+#include "drivers/Ticker.h"
+#include "platform/Callback.h"
+
+namespace mbed {
+
+/** mock Timeout
+ *
+ */
+class Timeout {
+
+public:
+    Timeout()
+    {
+    }
+
+    ~Timeout()
+    {
+    }
+
+    template <typename F>
+    void attach(F &&func, std::chrono::microseconds t)
+    {
+
+    }
+
+    void attach_us(Callback<void()> func, us_timestamp_t t)
+    {
+
+    }
+
+    void detach()
+    {
+
+    }
+
+    std::chrono::microseconds remaining_time() const
+    {
+        return std::chrono::microseconds(0);
+    }
+};
+
+} // namespace mbed
+
+#endif
@@ -66,14 +66,27 @@ bool EventQueue::cancel_handler(handle_t handle)
 
 void EventQueue::process_events(tick_t duration_ms)
 {
-    // execute all events during the duration
-    for (uint64_t i = 0; i < duration_ms; ++i) {
+    const tick_t end = _now + duration_ms;
+
+    // execute all events during the duration, jumping from one event to the next
+    while (!_handlers.empty()) {
+        auto smallest = std::min_element(
+            _handlers.begin(),
+            _handlers.end(),
+            [](internal_event& element, internal_event& smallest){
+                return (element.tick < smallest.tick);
+            }
+        );
+        if (smallest->tick > end) {
+            break;
+        }
+        if (smallest->tick > _now) {
+            _now = smallest->tick;
+        }
         process_events();
-        _now++;
     }
 
-    // last round to execute immediate events
-    process_events();
+    _now = end;
 }
 
 void EventQueue::process_events() {
@@ -82,7 +95,7 @@ void EventQueue::process_events() {
             return;
         }
 
-        /* to guarantee order we only dispatch one tick at a time*/
+        /* to guarantee order we dispatch the earliest handler, in the order they were posted */
         auto smallest = std::min_element(
             _handlers.begin(),
             _handlers.end(),
@@ -90,30 +103,16 @@ void EventQueue::process_events() {
                 return (element.tick < smallest.tick);
             }
         );
-        tick_t earliest_tick = smallest->tick;
 
         /* stop if all elements happen later */
-        if (earliest_tick > _now) {
+        if (smallest->tick > _now) {
             return;
         }
 
-        /* dispatch all handlers that happen at this time */
-        auto found = std::remove_if(
-            _handlers.begin(),
-            _handlers.end(),
-            [earliest_tick](internal_event& element) -> bool {
-                if (earliest_tick >= element.tick) {
-                    (*(element.handler))();
-                    return true;
-                } else {
-                    return false;
-                }
-            }
-        );
-
-        if (found != _handlers.end()) {
-            _handlers.erase(found, _handlers.end());
-        }
+        /* take the handler out before calling it, it may add and cancel events */
+        std::unique_ptr<function_t> handler = std::move(smallest->handler);
+        _handlers.erase(smallest);
+        (*handler)();
     }
 }
 